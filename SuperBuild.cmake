@@ -133,6 +133,7 @@ if( NOT USE_SYSTEM_VTK )
       -DPython${PYTHON_VERSION_MAJOR}_LIBRARY_DEBUG:FILEPATH=${PYTHON_DEBUG_LIBRARY}
       -DPython${PYTHON_VERSION_MAJOR}_LIBRARY_RELEASE:FILEPATH=${PYTHON_LIBRARY}
       -DVTK_USE_TK:BOOL=OFF
+      -DVTK_MODULE_ENABLE_VTK_hdf5:STRING=YES
       )
   else ()
     set(VTK_GIT_TAG "v8.2.0")
@@ -237,6 +238,7 @@ ExternalProject_Add( ${proj}
     -DVMTK_BUILD_TETGEN:BOOL=${VMTK_BUILD_TETGEN}
     -DVTK_VMTK_USE_COCOA:BOOL=${VTK_VMTK_USE_COCOA}
     -DVMTK_BUILD_STREAMTRACER:BOOL=${VMTK_BUILD_STREAMTRACER}
+    -DVTK_VMTK_BUILD_XDMF_WRITER:BOOL=${VTK_VMTK_BUILD_XDMF_WRITER}
     -DVTK_REQUIRED_OBJCXX_FLAGS:STRING=${VTK_REQUIRED_OBJCXX_FLAGS}
     -DVMTK_USE_RENDERING:STRING=${VMTK_USE_RENDERING}
     -DVMTK_USE_VTK9:BOOL=${VMTK_USE_VTK9}
@@ -48,8 +48,10 @@ def vmtk_vtkvmtk_attributes():
         'vtkvmtkCenterlineSphereDistance',
         'vtkvmtkCenterlineSplitExtractor',
         'vtkvmtkCenterlineSplittingAndGroupingFilter',
+        'vtkvmtkCenterlineTopologyIndex',
         'vtkvmtkCenterlineUtilities',
         'vtkvmtkCollidingFrontsImageFilter',
+        'vtkvmtkCompactStencils',
         # 'vtkvmtkConcaveAnnularCapPolyData',
         'vtkvmtkCurvedMPRImageFilter',
         'vtkvmtkCurvesLevelSetImageFilter',
@@ -145,9 +147,11 @@ def vmtk_vtkvmtk_attributes():
         # 'vtkvmtkPolyDataGeodesicRBFInterpolation',
         'vtkvmtkPolyDataGradientFilter',
         'vtkvmtkPolyDataGradientStencil',
+        'vtkvmtkPolyDataGroupPartition',
         'vtkvmtkPolyDataHarmonicMappingFilter',
         'vtkvmtkPolyDataKiteRemovalFilter',
         'vtkvmtkPolyDataLaplaceBeltramiStencil',
+        'vtkvmtkPolyDataLaplaceOperator',
         'vtkvmtkPolyDataLineEmbedder',
         'vtkvmtkPolyDataLocalGeometry',
         'vtkvmtkPolyDataManifoldExtendedNeighborhood',
@@ -16,9 +16,9 @@
 
 import pytest
 import vmtk.vmtkimagevesselenhancement as vesselenhancement
+import vmtk.vmtkimagecompare as imagecompare
 
 
-#TODO: VEDM Method is currently diabled in vtkVmtk (vtkvmtkVesselEnhancingDiffusion3DImageFilter). Find a fix or remove.
 @pytest.mark.parametrize("enhance_method,paramid", [
     ('frangi', '0'),
     ('sato', '1'),
@@ -115,3 +115,33 @@ def test_ved_enhancement_with_varied_params(aorta_image, compare_images,
     enhancer.Execute()
 
     assert compare_images(enhancer.Image, name, tolerance=1.0) == True
+
+
+@pytest.mark.parametrize("numiterations,numdiffusioniterations,threads", [
+    (0, 1, 4),
+    (1, 1, 4),
+    (3, 1, 4),
+    (3, 2, 3),
+])
+def test_vedm_threaded_enhancement_matches_single_thread(aorta_image,
+                                                         numiterations,
+                                                         numdiffusioniterations,
+                                                         threads):
+    def enhance(numberofthreads):
+        enhancer = vesselenhancement.vmtkImageVesselEnhancement()
+        enhancer.Image = aorta_image
+        enhancer.Method = 'vedm'
+        enhancer.NumberOfIterations = numiterations
+        enhancer.NumberOfDiffusionSubIterations = numdiffusioniterations
+        enhancer.NumberOfThreads = numberofthreads
+        enhancer.Execute()
+        return enhancer.Image
+
+    comp = imagecompare.vmtkImageCompare()
+    comp.Image = enhance(threads)
+    comp.ReferenceImage = enhance(1)
+    comp.Method = 'subtraction'
+    comp.Tolerance = 1E-6
+    comp.Execute()
+
+    assert comp.Result == True
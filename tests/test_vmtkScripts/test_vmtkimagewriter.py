@@ -0,0 +1,104 @@
+## Program: VMTK
+## Language:  Python
+## Date:      October 18, 2026
+## Version:   1.4
+
+##   Copyright (c) Richard Izzo, Luca Antiga, All rights reserved.
+##   See LICENSE file for details.
+
+##      This software is distributed WITHOUT ANY WARRANTY; without even
+##      the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+##      PURPOSE.  See the above copyright notices for more information.
+
+import pytest
+import os
+import vmtk.vmtkimagewriter as imagewriter
+import vmtk.vmtkimagereader as imagereader
+import vmtk.vmtkimagecompare as imagecompare
+
+
+def write_and_read_image(image, filename, parallelcompression, streamdivisions=1):
+    writer = imagewriter.vmtkImageWriter()
+    writer.Image = image
+    writer.OutputFileName = filename
+    writer.Compressed = 1
+    writer.ParallelCompression = parallelcompression
+    writer.NumberOfStreamDivisions = streamdivisions
+    writer.Execute()
+
+    reader = imagereader.vmtkImageReader()
+    reader.InputFileName = filename
+    reader.Execute()
+    return reader.Image
+
+
+def read_header_fields(filename, separator):
+    fields = []
+    with open(filename, 'rb') as f:
+        for line in f:
+            line = line.decode('latin-1').rstrip('\n')
+            if line == '' or line.startswith('ElementDataFile'):
+                fields.append(line.split(separator)[0].strip())
+                break
+            if line.startswith('#') or separator not in line:
+                continue
+            fields.append(line.split(separator)[0].strip())
+    return fields
+
+
+@pytest.mark.parametrize("extension,separator,streamdivisions", [
+    ('mha', ' = ', 1),
+    ('mha', ' = ', 4),
+    ('nrrd', ': ', 1),
+    ('nrrd', ': ', 4),
+])
+def test_parallel_compression_round_trip(aorta_image, tmpdir, extension,
+                                         separator, streamdivisions):
+    itkFileName = os.path.join(str(tmpdir), 'itk.' + extension)
+    parallelFileName = os.path.join(str(tmpdir), 'parallel.' + extension)
+    itkImage = write_and_read_image(aorta_image, itkFileName, 0)
+    parallelImage = write_and_read_image(aorta_image, parallelFileName, 1, streamdivisions)
+
+    assert parallelImage.GetDimensions() == aorta_image.GetDimensions()
+    assert parallelImage.GetDimensions() == itkImage.GetDimensions()
+    assert parallelImage.GetOrigin() == pytest.approx(itkImage.GetOrigin())
+    assert parallelImage.GetSpacing() == pytest.approx(itkImage.GetSpacing())
+    assert parallelImage.GetScalarType() == itkImage.GetScalarType()
+
+    comp = imagecompare.vmtkImageCompare()
+    comp.Image = parallelImage
+    comp.ReferenceImage = itkImage
+    comp.Method = 'subtraction'
+    comp.Tolerance = 1E-8
+    comp.Execute()
+    assert comp.Result == True
+
+    itkFields = read_header_fields(itkFileName, separator)
+    parallelFields = read_header_fields(parallelFileName, separator)
+    assert set(itkFields) <= set(parallelFields)
+
+
+def test_streamed_write_round_trip(aorta_image, tmpdir):
+    filename = os.path.join(str(tmpdir), 'streamed.mha')
+    writer = imagewriter.vmtkImageWriter()
+    writer.Image = aorta_image
+    writer.OutputFileName = filename
+    writer.Compressed = 0
+    writer.NumberOfStreamDivisions = 4
+    writer.Execute()
+
+    reader = imagereader.vmtkImageReader()
+    reader.InputFileName = filename
+    reader.Execute()
+
+    assert reader.Image.GetDimensions() == aorta_image.GetDimensions()
+    assert reader.Image.GetOrigin() == pytest.approx(aorta_image.GetOrigin())
+    assert reader.Image.GetSpacing() == pytest.approx(aorta_image.GetSpacing())
+
+    comp = imagecompare.vmtkImageCompare()
+    comp.Image = reader.Image
+    comp.ReferenceImage = aorta_image
+    comp.Method = 'subtraction'
+    comp.Tolerance = 1E-8
+    comp.Execute()
+    assert comp.Result == True
@@ -0,0 +1,77 @@
+## Program: VMTK
+## Language:  Python
+## Date:      October 18, 2026
+## Version:   1.4
+
+##   Copyright (c) Richard Izzo, Luca Antiga, All rights reserved.
+##   See LICENSE file for details.
+
+##      This software is distributed WITHOUT ANY WARRANTY; without even
+##      the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+##      PURPOSE.  See the above copyright notices for more information.
+
+import pytest
+import os
+import xml.etree.ElementTree as ET
+import vtk
+from vmtk import vtkvmtk
+import vmtk.vmtkmeshwriter as meshwriter
+
+pytestmark = pytest.mark.skipif(not hasattr(vtkvmtk, 'vtkvmtkXdmfWriter'),
+                                reason='vmtk built without VTK_VMTK_BUILD_XDMF_WRITER')
+
+
+@pytest.fixture(scope='module')
+def two_tetra_mesh():
+    # two tetrahedra sharing the face 1 2 3, region ids 1 and 2, and one
+    # boundary triangle with id 5
+    points = vtk.vtkPoints()
+    for point in [(0.0, 0.0, 0.0), (1.0, 0.0, 0.0), (0.0, 1.0, 0.0),
+                  (0.0, 0.0, 1.0), (1.0, 1.0, 1.0)]:
+        points.InsertNextPoint(point)
+    mesh = vtk.vtkUnstructuredGrid()
+    mesh.SetPoints(points)
+    entityIds = vtk.vtkIntArray()
+    entityIds.SetName('CellEntityIds')
+    for cellType, pointIds, entityId in [(vtk.VTK_TETRA, (0, 1, 2, 3), 1),
+                                          (vtk.VTK_TETRA, (4, 3, 2, 1), 2),
+                                          (vtk.VTK_TRIANGLE, (2, 1, 0), 5)]:
+        ids = vtk.vtkIdList()
+        for pointId in pointIds:
+            ids.InsertNextId(pointId)
+        mesh.InsertNextCell(cellType, ids)
+        entityIds.InsertNextValue(entityId)
+    mesh.GetCellData().AddArray(entityIds)
+    return mesh
+
+
+@pytest.mark.parametrize("compressed", [0, 1])
+def test_write_xdmf_read_back(two_tetra_mesh, tmpdir, compressed):
+    h5py = pytest.importorskip('h5py')
+    filename = os.path.join(str(tmpdir), 'mesh.xdmf')
+    writer = meshwriter.vmtkMeshWriter()
+    writer.Mesh = two_tetra_mesh
+    writer.OutputFileName = filename
+    writer.Format = 'xdmf'
+    writer.CellEntityIdsArrayName = 'CellEntityIds'
+    writer.CellEntityIdsOffset = 0
+    writer.WriteRegionMarkers = 1
+    writer.Compressed = compressed
+    writer.Execute()
+
+    grids = {grid.get('Name'): grid for grid in ET.parse(filename).getroot().iter('Grid')}
+    assert sorted(grids.keys()) == ['cells', 'facets', 'mesh']
+    assert grids['mesh'].find('Topology').get('NumberOfElements') == '2'
+    assert grids['facets'].find('Topology').get('NumberOfElements') == '1'
+    dataItem = grids['mesh'].find('Geometry/DataItem')
+    assert dataItem.get('Dimensions') == '5 3'
+    assert dataItem.text.strip() == 'mesh.h5:/Mesh/mesh/geometry'
+
+    with h5py.File(os.path.join(str(tmpdir), 'mesh.h5'), 'r') as f:
+        geometry = f['/Mesh/mesh/geometry'][()]
+        for i in range(two_tetra_mesh.GetNumberOfPoints()):
+            assert list(geometry[i]) == pytest.approx(two_tetra_mesh.GetPoint(i))
+        assert f['/Mesh/mesh/topology'][()].tolist() == [[0, 1, 2, 3], [1, 2, 3, 4]]
+        assert f['/MeshTags/facets/topology'][()].tolist() == [[0, 1, 2]]
+        assert f['/MeshTags/facets/values'][()].ravel().tolist() == [5]
+        assert f['/MeshTags/cells/values'][()].ravel().tolist() == [1, 2]
@@ -43,6 +43,8 @@ class vmtkImageObjectEnhancement(pypes.pypeScript):
 
         self.ObjectDimension = 0
 
+        self.FusedMultiScale = 0
+
         self.SetScriptName('vmtkimageobjectenhancement')
         self.SetScriptDoc('compute a feature image for use in segmentation')
         self.SetInputMembers([
@@ -54,7 +56,8 @@ class vmtkImageObjectEnhancement(pypes.pypeScript):
             ['Alpha','alpha','float',1,'(0.0,)',''],
             ['Beta','beta','float',1,'(0.0,)',''],
             ['Gamma','gamma','float',1,'(0.0,)',''],
-            ['ObjectDimension','dimension','int',1,'(0,2)','']
+            ['ObjectDimension','dimension','int',1,'(0,2)',''],
+            ['FusedMultiScale','fused','bool',1,'','compute all scales slab by slab without per-scale Hessian images']
             ])
         self.SetOutputMembers([
             ['Image','o','vtkImageData',1,'','the output image','vmtkimagewriter'],
@@ -72,6 +75,7 @@ class vmtkImageObjectEnhancement(pypes.pypeScript):
         objectness.SetBeta(self.Beta)
         objectness.SetGamma(self.Gamma)
         objectness.SetObjectDimension(self.ObjectDimension)
+        objectness.SetUseFusedMultiScale(self.FusedMultiScale)
         objectness.Update()
 
         self.EnhancedImage = vtk.vtkImageData()
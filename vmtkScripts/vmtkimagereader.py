@@ -46,6 +46,7 @@ class vmtkImageReader(pypes.pypeScript):
         self.FileDimensionality = 3
         self.Flip = [0, 0, 0]
         self.AutoOrientDICOMImage = 1
+        self.UseHeaderCache = 0
         self.RasToIjkMatrixCoefficients = [1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1]
         self.XyzToRasMatrixCoefficients = [1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1]
 
@@ -68,7 +69,8 @@ class vmtkImageReader(pypes.pypeScript):
             ['DataScalarType','scalartype','str',1,'["float","double","int","short","ushort","uchar"]','scalar type - raw only'],
             ['FileDimensionality','filedimensionality','int',1,'(2,3)','dimensionality of the file to read - raw only'],
             ['Flip','flip','bool',3,'','toggle flipping of the corresponding axis'],
-            ['AutoOrientDICOMImage','autoorientdicom','bool',1,'','flip a dicom stack in order to have a left-to-right, posterio-to-anterior, inferior-to-superior image; this is based on the \"image orientation (patient)\" field in the dicom header']
+            ['AutoOrientDICOMImage','autoorientdicom','bool',1,'','flip a dicom stack in order to have a left-to-right, posterio-to-anterior, inferior-to-superior image; this is based on the \"image orientation (patient)\" field in the dicom header'],
+            ['UseHeaderCache','headercache','bool',1,'','keep an index of the dicom tags of the input directory in the user cache directory, reused until the directory is modified - itk only']
             ])
         self.SetOutputMembers([
             ['Image','o','vtkImageData',1,'','the output image','vmtkimagewriter'],
@@ -195,6 +197,7 @@ class vmtkImageReader(pypes.pypeScript):
         elif self.DesiredOrientation == 'sagittal':
             reader.SetDesiredCoordinateOrientationToSagittal()
         reader.SetSingleFile(0)
+        reader.SetUseHeaderCache(self.UseHeaderCache)
         reader.Update()
         self.Image = vtk.vtkImageData()
         self.Image.DeepCopy(reader.GetOutput())
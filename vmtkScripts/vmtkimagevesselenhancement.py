@@ -51,7 +51,9 @@ class vmtkImageVesselEnhancement(pypes.pypeScript):
         self.Sensitivity = 5.0
         self.NumberOfIterations = 0
         self.NumberOfDiffusionSubIterations = 0
+        self.NumberOfThreads = 0
         self.BrightObject = True
+        self.FusedMultiScale = 0
 
         self.SetScriptName('vmtkimagevesselenhancement')
         self.SetScriptDoc('compute a feature image for use in segmentation')
@@ -64,6 +66,7 @@ class vmtkImageVesselEnhancement(pypes.pypeScript):
             ['SigmaStepMethod','stepmethod','str',1,'["equispaced","logarithmic"]'],
             ['ScaledVesselness','scaled','bool',1,'','(frangi)'],
             ['BrightObject','brightobject','bool',1,'','(frangi)'],
+            ['FusedMultiScale','fused','bool',1,'','compute all scales slab by slab without per-scale Hessian images (frangi, sato)'],
             ['Alpha1','alpha1','float',1,'(0.0,)','(sato)'],
             ['Alpha2','alpha2','float',1,'(0.0,)','(sato)'],
             ['Alpha','alpha','float',1,'(0.0,)','(frangi, ved, vedm)'],
@@ -75,7 +78,8 @@ class vmtkImageVesselEnhancement(pypes.pypeScript):
             ['WStrength','wstrength','float',1,'(0.0,)','(ved, vedm)'],
             ['Sensitivity','sensitivity','float',1,'(0.0,)','(ved, vedm)'],
             ['NumberOfIterations','iterations','int',1,'(0,)','(ved, vedm)'],
-            ['NumberOfDiffusionSubIterations','subiterations','int',1,'(1,)','(ved, vedm)']
+            ['NumberOfDiffusionSubIterations','subiterations','int',1,'(1,)','(ved, vedm)'],
+            ['NumberOfThreads','threads','int',1,'(0,)','number of threads, 0 for the default (vedm)']
             ])
         self.SetOutputMembers([
             ['Image','o','vtkImageData',1,'','the output image','vmtkimagewriter']
@@ -93,6 +97,7 @@ class vmtkImageVesselEnhancement(pypes.pypeScript):
         vesselness.SetBeta(self.Beta)
         vesselness.SetGamma(self.Gamma)
         vesselness.SetBrightObject(self.BrightObject)
+        vesselness.SetUseFusedMultiScale(self.FusedMultiScale)
         if self.SigmaStepMethod == 'equispaced':
             vesselness.SetSigmaStepMethodToEquispaced()
         elif self.SigmaStepMethod == 'logarithmic':
@@ -111,6 +116,7 @@ class vmtkImageVesselEnhancement(pypes.pypeScript):
         vesselness.SetNumberOfSigmaSteps(self.NumberOfSigmaSteps)
         vesselness.SetAlpha1(self.Alpha1)
         vesselness.SetAlpha2(self.Alpha2)
+        vesselness.SetUseFusedMultiScale(self.FusedMultiScale)
         if self.SigmaStepMethod == 'equispaced':
             vesselness.SetSigmaStepMethodToEquispaced()
         elif self.SigmaStepMethod == 'logarithmic':
@@ -162,6 +168,7 @@ class vmtkImageVesselEnhancement(pypes.pypeScript):
         vesselness.SetSensitivity(self.Sensitivity)
         vesselness.SetNumberOfIterations(self.NumberOfIterations)
         vesselness.SetRecalculateVesselness(self.NumberOfDiffusionSubIterations)
+        vesselness.SetNumberOfThreads(self.NumberOfThreads)
         if self.SigmaStepMethod == 'equispaced':
             vesselness.SetSigmaStepMethodToEquispaced()
         elif self.SigmaStepMethod == 'logarithmic':
@@ -31,6 +31,10 @@ class vmtkImageWriter(pypes.pypeScript):
         self.GuessFormat = 1
         self.UseITKIO = 1
         self.ApplyTransform = 0
+        self.Compressed = 1
+        self.ParallelCompression = 0
+        self.CompressionLevel = -1
+        self.NumberOfStreamDivisions = 1
         self.OutputFileName = ''
         self.OutputRawFileName = ''
         self.OutputDirectoryName = ''
@@ -48,6 +52,10 @@ class vmtkImageWriter(pypes.pypeScript):
             ['GuessFormat','guessformat','bool',1,'','guess file format from extension'],
             ['UseITKIO','useitk','bool',1,'','use ITKIO mechanism'],
             ['ApplyTransform','transform','bool',1,'','apply transform on writing - ITKIO only'],
+            ['Compressed','compressed','bool',1,'','compress image data - ITKIO only'],
+            ['ParallelCompression','parallelcompression','bool',1,'','compress scalar volumes in parallel instead of through the ITK writer - ITKIO nrrd and mha only'],
+            ['CompressionLevel','compressionlevel','int',1,'(-1,9)','zlib compression level, -1 for the default - parallelcompression only'],
+            ['NumberOfStreamDivisions','streamdivisions','int',1,'(1,)','number of slabs images are written in - ITKIO only'],
             ['OutputFileName','ofile','str',1,'','output file name'],
             ['OutputFileName','o','str',1,'','output file name (deprecated: use -ofile)'],
             ['OutputRawFileName','rawfile','str',1,'','name of the output raw file - meta image only'],
@@ -211,7 +219,10 @@ class vmtkImageWriter(pypes.pypeScript):
         writer = vtkvmtk.vtkvmtkITKImageWriter()
         writer.SetInputData(self.Image)
         writer.SetFileName(self.OutputFileName)
-        writer.SetUseCompression(1)
+        writer.SetUseCompression(self.Compressed)
+        writer.SetParallelCompression(self.ParallelCompression)
+        writer.SetCompressionLevel(self.CompressionLevel)
+        writer.SetNumberOfStreamDivisions(self.NumberOfStreamDivisions)
         if self.ApplyTransform == 0:
             origin = self.Image.GetOrigin()
             spacing = self.Image.GetSpacing()
@@ -33,6 +33,7 @@ class vmtkMeshWriter(pypes.pypeScript):
         self.Mesh = None
         self.Input = None
         self.Mode = "binary"
+        self.FluentBinary = 0
 
         self.Compressed = 1
         self.CellEntityIdsOffset = -1
@@ -45,16 +46,17 @@ class vmtkMeshWriter(pypes.pypeScript):
         self.SetInputMembers([
             ['Mesh','i','vtkUnstructuredGrid',1,'','the input mesh','vmtkmeshreader'],
             ['Format','f','str',1,
-             '["vtkxml","vtk","xda","fdneut","tecplot","lifev","dolfin","fluent","tetgen","pointdata"]',
+             '["vtkxml","vtk","xda","fdneut","tecplot","lifev","dolfin","xdmf","fluent","tetgen","pointdata"]',
              'file format (xda - libmesh ASCII format, fdneut - FIDAP neutral format)'],
             ['GuessFormat','guessformat','bool',1,'','guess file format from extension'],
-            ['Compressed','compressed','bool',1,'','output gz compressed file (dolfin only)'],
+            ['Compressed','compressed','bool',1,'','output gz compressed file (dolfin), deflate compressed datasets (xdmf)'],
             ['OutputFileName','ofile','str',1,'','output file name'],
             ['Mesh','o','vtkUnstructuredGrid',1,'','the output mesh'],
-            ['Mode','mode','str',1,'["ascii","binary"]','write files in ASCII or binary mode (vtk and vtu only)'],
+            ['Mode','mode','str',1,'["ascii","binary"]','write files in ASCII or binary mode (vtk and vtu only; fluent is always ASCII unless fluentbinary is set)'],
+            ['FluentBinary','fluentbinary','bool',1,'','write Fluent files in binary mode (fluent only, default ASCII)'],
             ['CellEntityIdsArrayName','entityidsarray','str',1,'','name of the array where entity ids are stored'],
-            ['CellEntityIdsOffset','entityidsoffset','int',1,'','add this number to entity ids in output (dolfin only)'],
-            ['WriteRegionMarkers','writeregionmarkers','bool',1,'','write entity ids for volume regions to file (dolfin only)'],
+            ['CellEntityIdsOffset','entityidsoffset','int',1,'','add this number to entity ids in output (dolfin and xdmf only)'],
+            ['WriteRegionMarkers','writeregionmarkers','bool',1,'','write entity ids for volume regions to file (dolfin and xdmf only)'],
             ])
         self.SetOutputMembers([])
 
@@ -268,6 +270,23 @@ class vmtkMeshWriter(pypes.pypeScript):
             gzfile.write(xml)
             gzfile.close()
 
+    def WriteXdmfMeshFile(self):
+        if (self.OutputFileName == ''):
+            self.PrintError('Error: no OutputFileName.')
+        if not hasattr(vtkvmtk, 'vtkvmtkXdmfWriter'):
+            self.PrintError('Error: XDMF writer not available, build vmtk with VTK_VMTK_BUILD_XDMF_WRITER enabled.')
+        self.PrintLog('Writing XDMF file.')
+        writer = vtkvmtk.vtkvmtkXdmfWriter()
+        writer.SetInputData(self.Mesh)
+        writer.SetFileName(self.OutputFileName)
+        if self.CellEntityIdsArrayName != '':
+            writer.SetBoundaryDataArrayName(self.CellEntityIdsArrayName)
+            writer.SetBoundaryDataIdOffset(self.CellEntityIdsOffset)
+            writer.SetStoreCellMarkers(self.WriteRegionMarkers)
+        if self.Compressed:
+            writer.SetCompressionLevel(4)
+        writer.Write()
+
     def WriteFluentMeshFile(self):
         if (self.OutputFileName == ''):
             self.PrintError('Error: no OutputFileName.')
@@ -277,6 +296,10 @@ class vmtkMeshWriter(pypes.pypeScript):
         writer = vtkvmtk.vtkvmtkFluentWriter()
         writer.SetInputData(self.Mesh)
         writer.SetFileName(self.OutputFileName)
+        if self.FluentBinary:
+            writer.SetFileTypeToBinary()
+        else:
+            writer.SetFileTypeToASCII()
         if self.CellEntityIdsArrayName != '':
             writer.SetBoundaryDataArrayName(self.CellEntityIdsArrayName)
 #            writer.SetBoundaryDataIdOffset(self.CellEntityIdsOffset)
@@ -328,6 +351,7 @@ class vmtkMeshWriter(pypes.pypeScript):
                             'FDNEUT':'fdneut',
                             'lifev':'lifev',
                             'xml':'dolfin',
+                            'xdmf':'xdmf',
                             'msh':'fluent',
                             'tec':'tecplot',
                             'node':'tetgen',
@@ -363,6 +387,8 @@ class vmtkMeshWriter(pypes.pypeScript):
             self.WriteLifeVMeshFile()
         elif (self.Format == 'dolfin'):
             self.WriteDolfinMeshFile()
+        elif (self.Format == 'xdmf'):
+            self.WriteXdmfMeshFile()
         elif (self.Format == 'fluent'):
             self.WriteFluentMeshFile()
         elif (self.Format == 'tecplot'):
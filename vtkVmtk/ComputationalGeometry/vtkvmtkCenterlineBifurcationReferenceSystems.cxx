@@ -37,15 +37,19 @@ Version:   $Revision: 1.8 $
 #include "vtkObjectFactory.h"
 
 #include "vtkvmtkCenterlineUtilities.h"
+#include "vtkvmtkCenterlineTopologyIndex.h"
 
 
 vtkStandardNewMacro(vtkvmtkCenterlineBifurcationReferenceSystems);
 
+vtkCxxSetObjectMacro(vtkvmtkCenterlineBifurcationReferenceSystems,CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
 vtkvmtkCenterlineBifurcationReferenceSystems::vtkvmtkCenterlineBifurcationReferenceSystems()
 {
   this->RadiusArrayName = NULL;
   this->GroupIdsArrayName = NULL;
   this->BlankingArrayName = NULL;
+  this->CenterlineTopologyIndex = NULL;
 
   this->NormalArrayName = NULL;
   this->UpNormalArrayName = NULL;
@@ -82,6 +86,12 @@ vtkvmtkCenterlineBifurcationReferenceSystems::~vtkvmtkCenterlineBifurcationRefer
     delete[] this->UpNormalArrayName;
     this->UpNormalArrayName = NULL;
     }
+
+  if (this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex->Delete();
+    this->CenterlineTopologyIndex = NULL;
+    }
 }
 
 int vtkvmtkCenterlineBifurcationReferenceSystems::RequestData(
@@ -167,8 +177,19 @@ int vtkvmtkCenterlineBifurcationReferenceSystems::RequestData(
 
   vtkIntArray* referenceGroupIdsArray = vtkIntArray::New();
   referenceGroupIdsArray->SetName(this->GroupIdsArrayName);
+
+  if (!this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex = vtkvmtkCenterlineTopologyIndex::New();
+    }
+  this->CenterlineTopologyIndex->SetCenterlines(input);
+  this->CenterlineTopologyIndex->SetGroupIdsArrayName(this->GroupIdsArrayName);
+  this->CenterlineTopologyIndex->SetCenterlineIdsArrayName(NULL);
+  this->CenterlineTopologyIndex->SetTractIdsArrayName(NULL);
+  this->CenterlineTopologyIndex->SetBlankingArrayName(this->BlankingArrayName);
+
   vtkIdList* blankedGroupIds = vtkIdList::New();
-  vtkvmtkCenterlineUtilities::GetBlankedGroupsIdList(input,this->GroupIdsArrayName,this->BlankingArrayName,blankedGroupIds);
+  this->CenterlineTopologyIndex->GetBlankedGroupIds(blankedGroupIds);
   int i;
   for (i=0; i<blankedGroupIds->GetNumberOfIds(); i++)
     {
@@ -224,7 +245,7 @@ void vtkvmtkCenterlineBifurcationReferenceSystems::ComputeGroupReferenceSystem(v
 
   vtkIdList* groupCellIds = vtkIdList::New();
 //  vtkvmtkCenterlineUtilities::GetGroupCellIds(input,this->GroupIdsArrayName,referenceGroupId,groupCellIds);
-  vtkvmtkCenterlineUtilities::GetGroupUniqueCellIds(input,this->GroupIdsArrayName,referenceGroupId,groupCellIds);
+  this->CenterlineTopologyIndex->GetGroupUniqueCellIds(referenceGroupId,groupCellIds);
   int i;
   for (i=0; i<groupCellIds->GetNumberOfIds(); i++)
     {
@@ -32,6 +32,7 @@ Version:   $Revision: 1.5 $
 class vtkPoints;
 class vtkDoubleArray;
 class vtkIntArray;
+class vtkvmtkCenterlineTopologyIndex;
   
 class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkCenterlineBifurcationReferenceSystems : public vtkPolyDataAlgorithm
 {
@@ -56,6 +57,13 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkCenterlineBifurcationReferen
   vtkSetStringMacro(UpNormalArrayName);
   vtkGetStringMacro(UpNormalArrayName);
 
+  // Description:
+  // Topology index of the centerlines. If not set, one is created on the
+  // first update and kept; it can be shared among the filters working on the
+  // same split centerlines.
+  virtual void SetCenterlineTopologyIndex(vtkvmtkCenterlineTopologyIndex*);
+  vtkGetObjectMacro(CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
   protected:
   vtkvmtkCenterlineBifurcationReferenceSystems();
   ~vtkvmtkCenterlineBifurcationReferenceSystems();  
@@ -67,6 +75,7 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkCenterlineBifurcationReferen
   char* RadiusArrayName;
   char* GroupIdsArrayName;
   char* BlankingArrayName;
+  vtkvmtkCenterlineTopologyIndex* CenterlineTopologyIndex;
 
   char* NormalArrayName;
   char* UpNormalArrayName;
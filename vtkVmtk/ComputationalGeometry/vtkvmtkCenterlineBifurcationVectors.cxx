@@ -36,11 +36,14 @@ Version:   $Revision: 1.1 $
 #include "vtkObjectFactory.h"
 
 #include "vtkvmtkCenterlineUtilities.h"
+#include "vtkvmtkCenterlineTopologyIndex.h"
 #include "vtkvmtkReferenceSystemUtilities.h"
 
 
 vtkStandardNewMacro(vtkvmtkCenterlineBifurcationVectors);
 
+vtkCxxSetObjectMacro(vtkvmtkCenterlineBifurcationVectors,CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
 vtkvmtkCenterlineBifurcationVectors::vtkvmtkCenterlineBifurcationVectors()
 {
   this->RadiusArrayName = NULL;
@@ -48,6 +51,7 @@ vtkvmtkCenterlineBifurcationVectors::vtkvmtkCenterlineBifurcationVectors()
   this->CenterlineIdsArrayName = NULL;
   this->TractIdsArrayName = NULL;
   this->BlankingArrayName = NULL;
+  this->CenterlineTopologyIndex = NULL;
 
   this->ReferenceSystems = NULL;
 
@@ -163,6 +167,12 @@ vtkvmtkCenterlineBifurcationVectors::~vtkvmtkCenterlineBifurcationVectors()
     delete[] this->BifurcationGroupIdsArrayName;
     this->BifurcationGroupIdsArrayName = NULL;
   }
+
+  if (this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex->Delete();
+    this->CenterlineTopologyIndex = NULL;
+    }
 }
 
 int vtkvmtkCenterlineBifurcationVectors::RequestData(
@@ -379,8 +389,18 @@ int vtkvmtkCenterlineBifurcationVectors::RequestData(
   output->GetPointData()->AddArray(bifurcationVectorsGroupIdsArray);
   output->GetPointData()->AddArray(bifurcationVectorsBifurcationGroupIdsArray);
 
+  if (!this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex = vtkvmtkCenterlineTopologyIndex::New();
+    }
+  this->CenterlineTopologyIndex->SetCenterlines(input);
+  this->CenterlineTopologyIndex->SetGroupIdsArrayName(this->GroupIdsArrayName);
+  this->CenterlineTopologyIndex->SetCenterlineIdsArrayName(this->CenterlineIdsArrayName);
+  this->CenterlineTopologyIndex->SetTractIdsArrayName(this->TractIdsArrayName);
+  this->CenterlineTopologyIndex->SetBlankingArrayName(this->BlankingArrayName);
+
   vtkIdList* blankedGroupIds = vtkIdList::New();
-  vtkvmtkCenterlineUtilities::GetBlankedGroupsIdList(input,this->GroupIdsArrayName,this->BlankingArrayName,blankedGroupIds);
+  this->CenterlineTopologyIndex->GetBlankedGroupIds(blankedGroupIds);
   int i;
   for (i=0; i<blankedGroupIds->GetNumberOfIds(); i++)
   {
@@ -453,7 +473,7 @@ void vtkvmtkCenterlineBifurcationVectors::ComputeBifurcationVectors(vtkPolyData*
   vtkIdList* upStreamGroupIds = vtkIdList::New();
   vtkIdList* downStreamGroupIds = vtkIdList::New();
   
-  vtkvmtkCenterlineUtilities::FindAdjacentCenterlineGroupIds(input,this->GroupIdsArrayName,this->CenterlineIdsArrayName,this->TractIdsArrayName,bifurcationGroupId,upStreamGroupIds,downStreamGroupIds);
+  this->CenterlineTopologyIndex->FindAdjacentCenterlineGroupIds(bifurcationGroupId,upStreamGroupIds,downStreamGroupIds);
 
   int numberOfUpStreamGroupIds = upStreamGroupIds->GetNumberOfIds();
   int numberOfDownStreamGroupIds = downStreamGroupIds->GetNumberOfIds();
@@ -488,7 +508,7 @@ void vtkvmtkCenterlineBifurcationVectors::ComputeBifurcationVectors(vtkPolyData*
     double lastPointWeightSum = 0.0;
     double touchingPointWeightSum = 0.0;
     vtkIdList* groupCellIds = vtkIdList::New();
-    vtkvmtkCenterlineUtilities::GetGroupUniqueCellIds(input,this->GroupIdsArrayName,bifurcationVectorGroupId,groupCellIds);
+    this->CenterlineTopologyIndex->GetGroupUniqueCellIds(bifurcationVectorGroupId,groupCellIds);
     for (int j=0; j<groupCellIds->GetNumberOfIds(); j++)
       {
       vtkIdType cellId = groupCellIds->GetId(j);
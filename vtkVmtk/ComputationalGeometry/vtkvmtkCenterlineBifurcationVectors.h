@@ -43,6 +43,7 @@ Version:   $Revision: 1.1 $
 class vtkPoints;
 class vtkDoubleArray;
 class vtkIntArray;
+class vtkvmtkCenterlineTopologyIndex;
   
 class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkCenterlineBifurcationVectors : public vtkPolyDataAlgorithm
 {
@@ -110,6 +111,14 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkCenterlineBifurcationVectors
     VTK_VMTK_DOWNSTREAM_ORIENTATION
     };
 //ETX
+
+  // Description:
+  // Topology index of the centerlines. If not set, one is created on the
+  // first update and kept; it can be shared among the filters working on the
+  // same split centerlines.
+  virtual void SetCenterlineTopologyIndex(vtkvmtkCenterlineTopologyIndex*);
+  vtkGetObjectMacro(CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
   protected:
   vtkvmtkCenterlineBifurcationVectors();
   ~vtkvmtkCenterlineBifurcationVectors();  
@@ -127,6 +136,7 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkCenterlineBifurcationVectors
   char* CenterlineIdsArrayName;
   char* TractIdsArrayName;
   char* BlankingArrayName;
+  vtkvmtkCenterlineTopologyIndex* CenterlineTopologyIndex;
 
   vtkPolyData* ReferenceSystems;
 
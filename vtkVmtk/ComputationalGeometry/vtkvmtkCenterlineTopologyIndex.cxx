@@ -0,0 +1,429 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    $RCSfile: vtkvmtkCenterlineTopologyIndex.cxx,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:46:43 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "vtkvmtkCenterlineTopologyIndex.h"
+#include "vtkPolyData.h"
+#include "vtkCellData.h"
+#include "vtkCellType.h"
+#include "vtkIdList.h"
+#include "vtkMath.h"
+#include "vtkvmtkConstants.h"
+#include "vtkObjectFactory.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+
+vtkStandardNewMacro(vtkvmtkCenterlineTopologyIndex);
+
+vtkCxxSetObjectMacro(vtkvmtkCenterlineTopologyIndex,Centerlines,vtkPolyData);
+
+vtkvmtkCenterlineTopologyIndex::vtkvmtkCenterlineTopologyIndex()
+{
+  this->Centerlines = NULL;
+  this->GroupIdsArrayName = NULL;
+  this->CenterlineIdsArrayName = NULL;
+  this->TractIdsArrayName = NULL;
+  this->BlankingArrayName = NULL;
+  this->Built = false;
+}
+
+vtkvmtkCenterlineTopologyIndex::~vtkvmtkCenterlineTopologyIndex()
+{
+  if (this->Centerlines)
+    {
+    this->Centerlines->Delete();
+    this->Centerlines = NULL;
+    }
+
+  if (this->GroupIdsArrayName)
+    {
+    delete[] this->GroupIdsArrayName;
+    this->GroupIdsArrayName = NULL;
+    }
+
+  if (this->CenterlineIdsArrayName)
+    {
+    delete[] this->CenterlineIdsArrayName;
+    this->CenterlineIdsArrayName = NULL;
+    }
+
+  if (this->TractIdsArrayName)
+    {
+    delete[] this->TractIdsArrayName;
+    this->TractIdsArrayName = NULL;
+    }
+
+  if (this->BlankingArrayName)
+    {
+    delete[] this->BlankingArrayName;
+    this->BlankingArrayName = NULL;
+    }
+}
+
+void vtkvmtkCenterlineTopologyIndex::InsertUniqueId(std::vector<vtkIdType>& ids, vtkIdType id)
+{
+  if (std::find(ids.begin(),ids.end(),id) == ids.end())
+    {
+    ids.push_back(id);
+    }
+}
+
+void vtkvmtkCenterlineTopologyIndex::CopyIds(const std::vector<vtkIdType>& ids, vtkIdList* idList)
+{
+  idList->Initialize();
+  idList->SetNumberOfIds(static_cast<vtkIdType>(ids.size()));
+  for (size_t i=0; i<ids.size(); i++)
+    {
+    idList->SetId(static_cast<vtkIdType>(i),ids[i]);
+    }
+}
+
+void vtkvmtkCenterlineTopologyIndex::Build()
+{
+  this->GroupIds.clear();
+  this->Groups.clear();
+  this->CenterlineCellIds.clear();
+  this->CenterlineTractCellIds.clear();
+  this->TractCellIds.clear();
+  this->Built = true;
+  this->BuildTime.Modified();
+
+  if (!this->Centerlines)
+    {
+    vtkErrorMacro(<<"No centerlines specified.");
+    return;
+    }
+
+  vtkCellData* cellData = this->Centerlines->GetCellData();
+
+  vtkDataArray* groupIdsArray = this->GroupIdsArrayName ? cellData->GetArray(this->GroupIdsArrayName) : NULL;
+  if (!groupIdsArray)
+    {
+    vtkErrorMacro(<<"GroupIdsArray with name specified does not exist.");
+    return;
+    }
+
+  vtkDataArray* centerlineIdsArray = NULL;
+  if (this->CenterlineIdsArrayName)
+    {
+    centerlineIdsArray = cellData->GetArray(this->CenterlineIdsArrayName);
+    if (!centerlineIdsArray)
+      {
+      vtkErrorMacro(<<"CenterlineIdsArray with name specified does not exist.");
+      return;
+      }
+    }
+
+  vtkDataArray* tractIdsArray = NULL;
+  if (this->TractIdsArrayName)
+    {
+    tractIdsArray = cellData->GetArray(this->TractIdsArrayName);
+    if (!tractIdsArray)
+      {
+      vtkErrorMacro(<<"TractIdsArray with name specified does not exist.");
+      return;
+      }
+    }
+
+  vtkDataArray* blankingArray = NULL;
+  if (this->BlankingArrayName)
+    {
+    blankingArray = cellData->GetArray(this->BlankingArrayName);
+    if (!blankingArray)
+      {
+      vtkErrorMacro(<<"BlankingArray with name specified does not exist.");
+      return;
+      }
+    }
+
+  vtkIdType numberOfCells = this->Centerlines->GetNumberOfCells();
+  std::vector<vtkIdType> cellGroupIds(numberOfCells);
+  std::vector<vtkIdType> cellCenterlineIds(numberOfCells,-1);
+  std::vector<vtkIdType> cellTractIds(numberOfCells,-1);
+
+  vtkIdType i;
+  for (i=0; i<numberOfCells; i++)
+    {
+    vtkIdType groupId = static_cast<int>(groupIdsArray->GetComponent(i,0));
+    cellGroupIds[i] = groupId;
+
+    std::unordered_map<vtkIdType,GroupEntry>::iterator it = this->Groups.find(groupId);
+    if (it == this->Groups.end())
+      {
+      it = this->Groups.insert(std::make_pair(groupId,GroupEntry())).first;
+      it->second.Blanked = blankingArray ? (static_cast<int>(blankingArray->GetComponent(i,0)) == 1 ? 1 : 0) : 0;
+      this->GroupIds.push_back(groupId);
+      }
+    it->second.CellIds.push_back(i);
+
+    if (centerlineIdsArray)
+      {
+      vtkIdType centerlineId = static_cast<int>(centerlineIdsArray->GetComponent(i,0));
+      cellCenterlineIds[i] = centerlineId;
+      this->CenterlineCellIds[centerlineId].push_back(i);
+      if (tractIdsArray)
+        {
+        vtkIdType tractId = static_cast<int>(tractIdsArray->GetComponent(i,0));
+        cellTractIds[i] = tractId;
+        this->TractCellIds[std::make_pair(centerlineId,tractId)].push_back(i);
+        }
+      }
+    }
+
+  // stable, as the bubble sort of vtkvmtkCenterlineUtilities::GetCenterlineCellIds
+  std::unordered_map<vtkIdType,std::vector<vtkIdType> >::const_iterator centerlineIt;
+  for (centerlineIt = this->CenterlineCellIds.begin(); centerlineIt != this->CenterlineCellIds.end(); ++centerlineIt)
+    {
+    std::vector<vtkIdType>& sortedCellIds = this->CenterlineTractCellIds[centerlineIt->first];
+    sortedCellIds = centerlineIt->second;
+    if (tractIdsArray)
+      {
+      std::stable_sort(sortedCellIds.begin(),sortedCellIds.end(),
+        [&cellTractIds](vtkIdType a, vtkIdType b) { return cellTractIds[a] < cellTractIds[b]; });
+      }
+    }
+
+  std::unordered_map<vtkIdType,GroupEntry>::iterator groupIt;
+  for (groupIt = this->Groups.begin(); groupIt != this->Groups.end(); ++groupIt)
+    {
+    GroupEntry& group = groupIt->second;
+    this->BuildUniqueCellIds(group.CellIds,group.UniqueCellIds);
+
+    if (!centerlineIdsArray || !tractIdsArray)
+      {
+      continue;
+      }
+
+    // cells of the same centerline on the previous and next tract
+    for (size_t j=0; j<group.CellIds.size(); j++)
+      {
+      vtkIdType cellId = group.CellIds[j];
+      int cellType = this->Centerlines->GetCellType(cellId);
+      if (cellType != VTK_LINE && cellType != VTK_POLY_LINE)
+        {
+        continue;
+        }
+      vtkIdType centerlineId = cellCenterlineIds[cellId];
+      vtkIdType tractId = cellTractIds[cellId];
+      std::map<std::pair<vtkIdType,vtkIdType>,std::vector<vtkIdType> >::const_iterator tractIt;
+      tractIt = this->TractCellIds.find(std::make_pair(centerlineId,tractId-1));
+      if (tractIt != this->TractCellIds.end())
+        {
+        for (size_t k=0; k<tractIt->second.size(); k++)
+          {
+          vtkIdType adjacentGroupId = cellGroupIds[tractIt->second[k]];
+          if (adjacentGroupId != groupIt->first)
+            {
+            InsertUniqueId(group.UpStreamGroupIds,adjacentGroupId);
+            }
+          }
+        }
+      tractIt = this->TractCellIds.find(std::make_pair(centerlineId,tractId+1));
+      if (tractIt != this->TractCellIds.end())
+        {
+        for (size_t k=0; k<tractIt->second.size(); k++)
+          {
+          vtkIdType adjacentGroupId = cellGroupIds[tractIt->second[k]];
+          if (adjacentGroupId != groupIt->first)
+            {
+            InsertUniqueId(group.DownStreamGroupIds,adjacentGroupId);
+            }
+          }
+        }
+      }
+    }
+}
+
+void vtkvmtkCenterlineTopologyIndex::BuildUniqueCellIds(const std::vector<vtkIdType>& cellIds, std::vector<vtkIdType>& uniqueCellIds)
+{
+  uniqueCellIds.clear();
+
+  std::vector<double> uniqueEndpoints;
+  vtkIdType npts;
+  const vtkIdType *pts;
+  for (size_t i=0; i<cellIds.size(); i++)
+    {
+    this->Centerlines->GetCellPoints(cellIds[i],npts,pts);
+    if (npts == 0)
+      {
+      continue;
+      }
+    double endpoints[6];
+    this->Centerlines->GetPoint(pts[0],endpoints);
+    this->Centerlines->GetPoint(pts[npts-1],endpoints+3);
+
+    bool duplicate = false;
+    for (size_t j=0; j<uniqueCellIds.size(); j++)
+      {
+      const double* uniqueEndpoint = &uniqueEndpoints[6*j];
+      if ((vtkMath::Distance2BetweenPoints(uniqueEndpoint,endpoints) < VTK_VMTK_DOUBLE_TOL) &&
+          (vtkMath::Distance2BetweenPoints(uniqueEndpoint+3,endpoints+3) < VTK_VMTK_DOUBLE_TOL))
+        {
+        duplicate = true;
+        break;
+        }
+      }
+    if (duplicate)
+      {
+      continue;
+      }
+
+    uniqueCellIds.push_back(cellIds[i]);
+    uniqueEndpoints.insert(uniqueEndpoints.end(),endpoints,endpoints+6);
+    }
+}
+
+void vtkvmtkCenterlineTopologyIndex::BuildIfNeeded()
+{
+  if (!this->Built || this->GetMTime() > this->BuildTime || (this->Centerlines && this->Centerlines->GetMTime() > this->BuildTime))
+    {
+    this->Build();
+    }
+}
+
+void vtkvmtkCenterlineTopologyIndex::GetGroupIds(vtkIdList* groupIds)
+{
+  this->BuildIfNeeded();
+  CopyIds(this->GroupIds,groupIds);
+}
+
+void vtkvmtkCenterlineTopologyIndex::GetBlankedGroupIds(vtkIdList* groupIds)
+{
+  this->BuildIfNeeded();
+  groupIds->Initialize();
+  for (size_t i=0; i<this->GroupIds.size(); i++)
+    {
+    if (!this->BlankingArrayName || this->Groups[this->GroupIds[i]].Blanked)
+      {
+      groupIds->InsertNextId(this->GroupIds[i]);
+      }
+    }
+}
+
+void vtkvmtkCenterlineTopologyIndex::GetNonBlankedGroupIds(vtkIdList* groupIds)
+{
+  this->BuildIfNeeded();
+  groupIds->Initialize();
+  for (size_t i=0; i<this->GroupIds.size(); i++)
+    {
+    if (!this->BlankingArrayName || !this->Groups[this->GroupIds[i]].Blanked)
+      {
+      groupIds->InsertNextId(this->GroupIds[i]);
+      }
+    }
+}
+
+void vtkvmtkCenterlineTopologyIndex::GetGroupCellIds(vtkIdType groupId, vtkIdList* groupCellIds)
+{
+  this->BuildIfNeeded();
+  std::unordered_map<vtkIdType,GroupEntry>::const_iterator it = this->Groups.find(groupId);
+  if (it == this->Groups.end())
+    {
+    groupCellIds->Initialize();
+    return;
+    }
+  CopyIds(it->second.CellIds,groupCellIds);
+}
+
+void vtkvmtkCenterlineTopologyIndex::GetGroupUniqueCellIds(vtkIdType groupId, vtkIdList* groupCellIds)
+{
+  this->BuildIfNeeded();
+  std::unordered_map<vtkIdType,GroupEntry>::const_iterator it = this->Groups.find(groupId);
+  if (it == this->Groups.end())
+    {
+    groupCellIds->Initialize();
+    return;
+    }
+  CopyIds(it->second.UniqueCellIds,groupCellIds);
+}
+
+void vtkvmtkCenterlineTopologyIndex::GetCenterlineCellIds(vtkIdType centerlineId, vtkIdList* centerlineCellIds)
+{
+  this->BuildIfNeeded();
+  std::unordered_map<vtkIdType,std::vector<vtkIdType> >::const_iterator it = this->CenterlineCellIds.find(centerlineId);
+  if (it == this->CenterlineCellIds.end())
+    {
+    centerlineCellIds->Initialize();
+    return;
+    }
+  CopyIds(it->second,centerlineCellIds);
+}
+
+void vtkvmtkCenterlineTopologyIndex::GetCenterlineTractCellIds(vtkIdType centerlineId, vtkIdList* centerlineCellIds)
+{
+  this->BuildIfNeeded();
+  std::unordered_map<vtkIdType,std::vector<vtkIdType> >::const_iterator it = this->CenterlineTractCellIds.find(centerlineId);
+  if (it == this->CenterlineTractCellIds.end())
+    {
+    centerlineCellIds->Initialize();
+    return;
+    }
+  CopyIds(it->second,centerlineCellIds);
+}
+
+void vtkvmtkCenterlineTopologyIndex::GetTractCellIds(vtkIdType centerlineId, vtkIdType tractId, vtkIdList* tractCellIds)
+{
+  this->BuildIfNeeded();
+  std::map<std::pair<vtkIdType,vtkIdType>,std::vector<vtkIdType> >::const_iterator it = this->TractCellIds.find(std::make_pair(centerlineId,tractId));
+  if (it == this->TractCellIds.end())
+    {
+    tractCellIds->Initialize();
+    return;
+    }
+  CopyIds(it->second,tractCellIds);
+}
+
+int vtkvmtkCenterlineTopologyIndex::IsGroupBlanked(vtkIdType groupId)
+{
+  this->BuildIfNeeded();
+  std::unordered_map<vtkIdType,GroupEntry>::const_iterator it = this->Groups.find(groupId);
+  if (it == this->Groups.end())
+    {
+    return -1;
+    }
+  return it->second.Blanked;
+}
+
+void vtkvmtkCenterlineTopologyIndex::FindAdjacentCenterlineGroupIds(vtkIdType groupId, vtkIdList* upStreamGroupIds, vtkIdList* downStreamGroupIds)
+{
+  this->BuildIfNeeded();
+  std::unordered_map<vtkIdType,GroupEntry>::const_iterator it = this->Groups.find(groupId);
+  if (it == this->Groups.end())
+    {
+    upStreamGroupIds->Initialize();
+    downStreamGroupIds->Initialize();
+    return;
+    }
+  CopyIds(it->second.UpStreamGroupIds,upStreamGroupIds);
+  CopyIds(it->second.DownStreamGroupIds,downStreamGroupIds);
+}
+
+void vtkvmtkCenterlineTopologyIndex::PrintSelf(std::ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "Centerlines: " << this->Centerlines << endl;
+  os << indent << "GroupIdsArrayName: " << (this->GroupIdsArrayName ? this->GroupIdsArrayName : "(none)") << endl;
+  os << indent << "CenterlineIdsArrayName: " << (this->CenterlineIdsArrayName ? this->CenterlineIdsArrayName : "(none)") << endl;
+  os << indent << "TractIdsArrayName: " << (this->TractIdsArrayName ? this->TractIdsArrayName : "(none)") << endl;
+  os << indent << "BlankingArrayName: " << (this->BlankingArrayName ? this->BlankingArrayName : "(none)") << endl;
+  os << indent << "Number of groups: " << this->GroupIds.size() << endl;
+}
@@ -0,0 +1,158 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    $RCSfile: vtkvmtkCenterlineTopologyIndex.h,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:46:43 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// .NAME vtkvmtkCenterlineTopologyIndex - Index of the cells of split centerlines by group, centerline and tract id.
+// .SECTION Description
+// vtkvmtkCenterlineTopologyIndex reads the group, centerline, tract and
+// blanking cell arrays of split centerlines once and answers the topology
+// queries of vtkvmtkCenterlineUtilities (group cells, unique group cells,
+// centerline cells, group blanking and upstream/downstream adjacent groups)
+// with table lookups instead of a scan of all the cells. Results, including
+// the order of the returned ids, are the same as those of the corresponding
+// vtkvmtkCenterlineUtilities methods.
+//
+// The centerline id, tract id and blanking arrays are optional; the queries
+// that need them return empty lists if they are not set. The index is
+// rebuilt on demand when the centerlines or the array names are modified, so
+// a single instance can be handed to several filters working on the same
+// centerlines.
+//
+// .SECTION See Also
+// vtkvmtkCenterlineUtilities vtkvmtkCenterlineSplittingAndGroupingFilter
+
+#ifndef __vtkvmtkCenterlineTopologyIndex_h
+#define __vtkvmtkCenterlineTopologyIndex_h
+
+#include "vtkObject.h"
+#include "vtkvmtkWin32Header.h"
+
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class vtkPolyData;
+class vtkIdList;
+
+class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkCenterlineTopologyIndex : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkvmtkCenterlineTopologyIndex,vtkObject);
+  void PrintSelf(std::ostream& os, vtkIndent indent) override;
+
+  static vtkvmtkCenterlineTopologyIndex* New();
+
+  virtual void SetCenterlines(vtkPolyData*);
+  vtkGetObjectMacro(Centerlines,vtkPolyData);
+
+  vtkSetStringMacro(GroupIdsArrayName);
+  vtkGetStringMacro(GroupIdsArrayName);
+
+  vtkSetStringMacro(CenterlineIdsArrayName);
+  vtkGetStringMacro(CenterlineIdsArrayName);
+
+  vtkSetStringMacro(TractIdsArrayName);
+  vtkGetStringMacro(TractIdsArrayName);
+
+  vtkSetStringMacro(BlankingArrayName);
+  vtkGetStringMacro(BlankingArrayName);
+
+  // Description:
+  // Build the index. Called by the other methods if the centerlines or the
+  // array names changed since the last build.
+  void Build();
+
+  // Description:
+  // Group ids in order of first appearance (as
+  // vtkvmtkCenterlineUtilities::GetGroupsIdList and its blanked and non
+  // blanked variants). The blanking of a group is that of its first cell.
+  void GetGroupIds(vtkIdList* groupIds);
+  void GetBlankedGroupIds(vtkIdList* groupIds);
+  void GetNonBlankedGroupIds(vtkIdList* groupIds);
+
+  // Description:
+  // Ids of the cells of a group, and of the cells of a group with distinct
+  // endpoints (as vtkvmtkCenterlineUtilities::GetGroupUniqueCellIds).
+  void GetGroupCellIds(vtkIdType groupId, vtkIdList* groupCellIds);
+  void GetGroupUniqueCellIds(vtkIdType groupId, vtkIdList* groupCellIds);
+
+  // Description:
+  // Ids of the cells of a centerline, in cell order or sorted by tract id.
+  void GetCenterlineCellIds(vtkIdType centerlineId, vtkIdList* centerlineCellIds);
+  void GetCenterlineTractCellIds(vtkIdType centerlineId, vtkIdList* centerlineCellIds);
+
+  // Description:
+  // Ids of the cells of a tract of a centerline.
+  void GetTractCellIds(vtkIdType centerlineId, vtkIdType tractId, vtkIdList* tractCellIds);
+
+  // Description:
+  // Blanking of the first cell of a group, -1 if the group does not exist
+  // (as vtkvmtkCenterlineUtilities::IsGroupBlanked).
+  int IsGroupBlanked(vtkIdType groupId);
+
+  // Description:
+  // Groups preceding and following a group along the centerlines (as
+  // vtkvmtkCenterlineUtilities::FindAdjacentCenterlineGroupIds).
+  void FindAdjacentCenterlineGroupIds(vtkIdType groupId, vtkIdList* upStreamGroupIds, vtkIdList* downStreamGroupIds);
+
+protected:
+  vtkvmtkCenterlineTopologyIndex();
+  ~vtkvmtkCenterlineTopologyIndex();
+
+  void BuildIfNeeded();
+  void BuildUniqueCellIds(const std::vector<vtkIdType>& cellIds, std::vector<vtkIdType>& uniqueCellIds);
+
+  static void InsertUniqueId(std::vector<vtkIdType>& ids, vtkIdType id);
+  static void CopyIds(const std::vector<vtkIdType>& ids, vtkIdList* idList);
+
+  vtkPolyData* Centerlines;
+  char* GroupIdsArrayName;
+  char* CenterlineIdsArrayName;
+  char* TractIdsArrayName;
+  char* BlankingArrayName;
+
+  vtkTimeStamp BuildTime;
+  bool Built;
+
+  struct GroupEntry
+    {
+    std::vector<vtkIdType> CellIds;
+    std::vector<vtkIdType> UniqueCellIds;
+    std::vector<vtkIdType> UpStreamGroupIds;
+    std::vector<vtkIdType> DownStreamGroupIds;
+    int Blanked;
+    };
+
+  // groups in order of first appearance
+  std::vector<vtkIdType> GroupIds;
+  std::unordered_map<vtkIdType,GroupEntry> Groups;
+
+  // cells of each centerline in cell order and in tract order, and cells of
+  // each (centerline id, tract id) pair in cell order
+  std::unordered_map<vtkIdType,std::vector<vtkIdType> > CenterlineCellIds;
+  std::unordered_map<vtkIdType,std::vector<vtkIdType> > CenterlineTractCellIds;
+  std::map<std::pair<vtkIdType,vtkIdType>,std::vector<vtkIdType> > TractCellIds;
+
+private:
+  vtkvmtkCenterlineTopologyIndex(const vtkvmtkCenterlineTopologyIndex&);  // Not implemented.
+  void operator=(const vtkvmtkCenterlineTopologyIndex&);  // Not implemented.
+};
+
+#endif
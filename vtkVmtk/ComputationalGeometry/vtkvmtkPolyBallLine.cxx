@@ -68,6 +68,56 @@ double vtkvmtkPolyBallLine::ComplexDot(double x[4], double y[4])
   return x[0]*y[0] + x[1]*y[1] + x[2]*y[2] - x[3]*y[3];
 }
 
+double vtkvmtkPolyBallLine::EvaluateSegmentFunction(const double x[3], const double point0[3], double radius0, const double point1[3], double radius1, double closestPoint[4], double& t)
+{
+  double vector0[4], vector1[4];
+  vector0[0] = point1[0] - point0[0];
+  vector0[1] = point1[1] - point0[1];
+  vector0[2] = point1[2] - point0[2];
+  vector0[3] = radius1 - radius0;
+  vector1[0] = x[0] - point0[0];
+  vector1[1] = x[1] - point0[1];
+  vector1[2] = x[2] - point0[2];
+  vector1[3] = 0.0 - radius0;
+
+  double num = ComplexDot(vector0,vector1);
+  double den = ComplexDot(vector0,vector0);
+
+  if (fabs(den)<VTK_VMTK_DOUBLE_TOL)
+    {
+    t = 0.0;
+    return VTK_VMTK_LARGE_DOUBLE;
+    }
+
+  t = num / den;
+
+  if (t<VTK_VMTK_DOUBLE_TOL)
+    {
+    t = 0.0;
+    closestPoint[0] = point0[0];
+    closestPoint[1] = point0[1];
+    closestPoint[2] = point0[2];
+    closestPoint[3] = radius0;
+    }
+  else if (1.0-t<VTK_VMTK_DOUBLE_TOL)
+    {
+    t = 1.0;
+    closestPoint[0] = point1[0];
+    closestPoint[1] = point1[1];
+    closestPoint[2] = point1[2];
+    closestPoint[3] = radius1;
+    }
+  else
+    {
+    closestPoint[0] = point0[0] + t * vector0[0];
+    closestPoint[1] = point0[1] + t * vector0[1];
+    closestPoint[2] = point0[2] + t * vector0[2];
+    closestPoint[3] = radius0 + t * vector0[3];
+    }
+
+  return (x[0]-closestPoint[0])*(x[0]-closestPoint[0]) + (x[1]-closestPoint[1])*(x[1]-closestPoint[1]) + (x[2]-closestPoint[2])*(x[2]-closestPoint[2]) - closestPoint[3]*closestPoint[3];
+}
+
 double vtkvmtkPolyBallLine::EvaluateFunction(double x[3])
 {
   vtkIdType i, k;
@@ -76,9 +126,8 @@ double vtkvmtkPolyBallLine::EvaluateFunction(double x[3])
   double polyballFunctionValue, minPolyBallFunctionValue;
   double point0[3], point1[3];
   double radius0, radius1;
-  double vector0[4], vector1[4], closestPoint[4];
+  double closestPoint[4];
   double t;
-  double num, den;
   vtkDataArray *polyballRadiusArray = NULL;
 
   if (!this->Input)
@@ -172,52 +221,7 @@ double vtkvmtkPolyBallLine::EvaluateFunction(double x[3])
         radius0 = 0.0;
         radius1 = 0.0;
         }
-      vector0[0] = point1[0] - point0[0];
-      vector0[1] = point1[1] - point0[1];
-      vector0[2] = point1[2] - point0[2];
-      vector0[3] = radius1 - radius0;
-      vector1[0] = x[0] - point0[0];
-      vector1[1] = x[1] - point0[1];
-      vector1[2] = x[2] - point0[2];
-      vector1[3] = 0.0 - radius0;
-
-//       cout<<x[0]<<" "<<x[1]<<" "<<x[2]<<" "<<point0[0]<<" "<<point0[1]<<" "<<point0[2]<<" "<<point1[0]<<" "<<point1[1]<<" "<<point1[2]<<" "<<endl;
-
-      num = this->ComplexDot(vector0,vector1);
-      den = this->ComplexDot(vector0,vector0);
-      
-      if (fabs(den)<VTK_VMTK_DOUBLE_TOL)
-        {
-        continue;
-        }
-
-      t = num / den;
-
-      if (t<VTK_VMTK_DOUBLE_TOL)
-        {
-        t = 0.0;
-        closestPoint[0] = point0[0];
-        closestPoint[1] = point0[1];
-        closestPoint[2] = point0[2];
-        closestPoint[3] = radius0;
-        }
-      else if (1.0-t<VTK_VMTK_DOUBLE_TOL)
-        {
-        t = 1.0;
-        closestPoint[0] = point1[0];
-        closestPoint[1] = point1[1];
-        closestPoint[2] = point1[2];
-        closestPoint[3] = radius1;
-        }
-      else
-        {
-        closestPoint[0] = point0[0] + t * vector0[0];
-        closestPoint[1] = point0[1] + t * vector0[1];
-        closestPoint[2] = point0[2] + t * vector0[2];
-        closestPoint[3] = radius0 + t * vector0[3];
-        }
-
-      polyballFunctionValue = (x[0]-closestPoint[0])*(x[0]-closestPoint[0]) + (x[1]-closestPoint[1])*(x[1]-closestPoint[1]) + (x[2]-closestPoint[2])*(x[2]-closestPoint[2]) - closestPoint[3]*closestPoint[3];
+      polyballFunctionValue = EvaluateSegmentFunction(x,point0,radius0,point1,radius1,closestPoint,t);
 
       if (polyballFunctionValue<minPolyBallFunctionValue)
         {
@@ -85,6 +85,13 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyBallLine : public vtkImp
 
   static double ComplexDot(double x[4], double y[4]);
 
+  // Description:
+  // Evaluate the poly ball function of the single segment between two balls
+  // at x. The closest ball center and radius are returned in closestPoint
+  // and its parametric coordinate on the segment in t. Returns
+  // VTK_VMTK_LARGE_DOUBLE for degenerate segments.
+  static double EvaluateSegmentFunction(const double x[3], const double point0[3], double radius0, const double point1[3], double radius1, double closestPoint[4], double& t);
+
   protected:
   vtkvmtkPolyBallLine();
   ~vtkvmtkPolyBallLine();
@@ -34,8 +34,10 @@ Version:   $Revision: 1.1 $
 
 #include "vtkvmtkConstants.h"
 #include "vtkvmtkCenterlineUtilities.h"
+#include "vtkvmtkCenterlineTopologyIndex.h"
 #include "vtkvmtkCenterlineBifurcationVectors.h"
 #include "vtkvmtkPolyDataBranchUtilities.h"
+#include "vtkvmtkPolyDataGroupPartition.h"
 
 #include "vtkvmtkPolyDataBoundaryExtractor.h"
 #include "vtkvmtkBoundaryReferenceSystems.h"
@@ -43,11 +45,15 @@ Version:   $Revision: 1.1 $
 
 vtkStandardNewMacro(vtkvmtkPolyDataBifurcationProfiles);
 
+vtkCxxSetObjectMacro(vtkvmtkPolyDataBifurcationProfiles,CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
 vtkvmtkPolyDataBifurcationProfiles::vtkvmtkPolyDataBifurcationProfiles()
 {
   this->GroupIdsArrayName = NULL;
 
   this->Centerlines = NULL;
+  this->GroupPartition = NULL;
+  this->CenterlineTopologyIndex = NULL;
 
   this->CenterlineRadiusArrayName = NULL;
   this->CenterlineGroupIdsArrayName = NULL;
@@ -121,6 +127,12 @@ vtkvmtkPolyDataBifurcationProfiles::~vtkvmtkPolyDataBifurcationProfiles()
     delete[] this->BifurcationProfileOrientationArrayName;
     this->BifurcationProfileOrientationArrayName = NULL;
     }
+
+  if (this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex->Delete();
+    this->CenterlineTopologyIndex = NULL;
+    }
 }
 
 int vtkvmtkPolyDataBifurcationProfiles::RequestData(
@@ -263,9 +275,24 @@ int vtkvmtkPolyDataBifurcationProfiles::RequestData(
   output->SetPoints(outputPoints);
   output->SetLines(outputLines);
 
+  if (!this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex = vtkvmtkCenterlineTopologyIndex::New();
+    }
+  this->CenterlineTopologyIndex->SetCenterlines(this->Centerlines);
+  this->CenterlineTopologyIndex->SetGroupIdsArrayName(this->CenterlineGroupIdsArrayName);
+  this->CenterlineTopologyIndex->SetCenterlineIdsArrayName(this->CenterlineIdsArrayName);
+  this->CenterlineTopologyIndex->SetTractIdsArrayName(this->CenterlineTractIdsArrayName);
+  this->CenterlineTopologyIndex->SetBlankingArrayName(this->BlankingArrayName);
+
   vtkIdList* blankedGroupIds = vtkIdList::New();
-  vtkvmtkCenterlineUtilities::GetBlankedGroupsIdList(this->Centerlines,this->CenterlineGroupIdsArrayName,this->BlankingArrayName,blankedGroupIds);
+  this->CenterlineTopologyIndex->GetBlankedGroupIds(blankedGroupIds);
   int i;
+  this->GroupPartition = vtkvmtkPolyDataGroupPartition::New();
+  this->GroupPartition->SetSurface(input);
+  this->GroupPartition->SetGroupIdsArrayName(this->GroupIdsArrayName);
+  this->GroupPartition->Build();
+
   for (i=0; i<blankedGroupIds->GetNumberOfIds(); i++)
   {
     vtkIdType bifurcationGroupId = blankedGroupIds->GetId(i);
@@ -274,7 +301,7 @@ int vtkvmtkPolyDataBifurcationProfiles::RequestData(
     vtkIdList* upStreamGroupIds = vtkIdList::New();
     vtkIdList* downStreamGroupIds = vtkIdList::New();
     
-    vtkvmtkCenterlineUtilities::FindAdjacentCenterlineGroupIds(this->Centerlines,this->CenterlineGroupIdsArrayName,this->CenterlineIdsArrayName,this->CenterlineTractIdsArrayName,bifurcationGroupId,upStreamGroupIds,downStreamGroupIds);
+    this->CenterlineTopologyIndex->FindAdjacentCenterlineGroupIds(bifurcationGroupId,upStreamGroupIds,downStreamGroupIds);
     
     this->ComputeBifurcationProfiles(input,bifurcationGroupId,upStreamGroupIds,downStreamGroupIds,output);
     
@@ -284,6 +311,9 @@ int vtkvmtkPolyDataBifurcationProfiles::RequestData(
 
   blankedGroupIds->Delete();
 
+  this->GroupPartition->Delete();
+  this->GroupPartition = NULL;
+
   outputPoints->Delete();
   outputLines->Delete();
   
@@ -334,7 +364,7 @@ void vtkvmtkPolyDataBifurcationProfiles::ComputeBifurcationProfiles(vtkPolyData*
 
     int j;
     vtkIdList* groupCellIds = vtkIdList::New();
-    vtkvmtkCenterlineUtilities::GetGroupUniqueCellIds(this->Centerlines,this->CenterlineGroupIdsArrayName,bifurcationProfileGroupId,groupCellIds);
+    this->CenterlineTopologyIndex->GetGroupUniqueCellIds(bifurcationProfileGroupId,groupCellIds);
     for (j=0; j<groupCellIds->GetNumberOfIds(); j++)
       {
       vtkIdType cellId = groupCellIds->GetId(j);
@@ -372,7 +402,7 @@ void vtkvmtkPolyDataBifurcationProfiles::ComputeBifurcationProfiles(vtkPolyData*
     averagePoint[2] /= weightSum;
 
     vtkPolyData* cylinder = vtkPolyData::New();
-    vtkvmtkPolyDataBranchUtilities::ExtractGroup(input,this->GroupIdsArrayName,bifurcationProfileGroupId,false,cylinder);
+    this->GroupPartition->ExtractGroup(bifurcationProfileGroupId,false,cylinder);
 
     vtkvmtkPolyDataBoundaryExtractor* boundaryExtractor = vtkvmtkPolyDataBoundaryExtractor::New();
     boundaryExtractor->SetInputData(cylinder);
@@ -30,6 +30,9 @@ Version:   $Revision: 1.1 $
 #include "vtkvmtkWin32Header.h"
 #include "vtkPolyData.h"
 
+class vtkvmtkPolyDataGroupPartition;
+class vtkvmtkCenterlineTopologyIndex;
+
 class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataBifurcationProfiles : public vtkPolyDataAlgorithm
 {
   public: 
@@ -68,6 +71,13 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataBifurcationProfiles
   vtkSetStringMacro(BifurcationProfileOrientationArrayName);
   vtkGetStringMacro(BifurcationProfileOrientationArrayName);
 
+  // Description:
+  // Topology index of the centerlines. If not set, one is created on the
+  // first update and kept; it can be shared among the filters working on the
+  // same split centerlines.
+  virtual void SetCenterlineTopologyIndex(vtkvmtkCenterlineTopologyIndex*);
+  vtkGetObjectMacro(CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
   protected:
   vtkvmtkPolyDataBifurcationProfiles();
   ~vtkvmtkPolyDataBifurcationProfiles();  
@@ -78,6 +88,9 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataBifurcationProfiles
   
   vtkPolyData* Centerlines;
 
+  vtkvmtkPolyDataGroupPartition* GroupPartition;
+  vtkvmtkCenterlineTopologyIndex* CenterlineTopologyIndex;
+
   char* GroupIdsArrayName;
   char* CenterlineRadiusArrayName;
   char* CenterlineGroupIdsArrayName;
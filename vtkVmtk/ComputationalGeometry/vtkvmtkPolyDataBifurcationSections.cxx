@@ -33,18 +33,24 @@ Version:   $Revision: 1.1 $
 #include "vtkObjectFactory.h"
 
 #include "vtkvmtkCenterlineUtilities.h"
+#include "vtkvmtkCenterlineTopologyIndex.h"
 #include "vtkvmtkCenterlineBifurcationVectors.h"
 #include "vtkvmtkPolyDataBranchUtilities.h"
+#include "vtkvmtkPolyDataGroupPartition.h"
 #include "vtkvmtkPolyDataBranchSections.h"
 
 
 vtkStandardNewMacro(vtkvmtkPolyDataBifurcationSections);
 
+vtkCxxSetObjectMacro(vtkvmtkPolyDataBifurcationSections,CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
 vtkvmtkPolyDataBifurcationSections::vtkvmtkPolyDataBifurcationSections()
 {
   this->GroupIdsArrayName = NULL;
 
   this->Centerlines = NULL;
+  this->GroupPartition = NULL;
+  this->CenterlineTopologyIndex = NULL;
 
   this->CenterlineRadiusArrayName = NULL;
   this->CenterlineGroupIdsArrayName = NULL;
@@ -176,6 +182,12 @@ vtkvmtkPolyDataBifurcationSections::~vtkvmtkPolyDataBifurcationSections()
     delete[] this->BifurcationSectionDistanceSpheresArrayName;
     this->BifurcationSectionDistanceSpheresArrayName = NULL;
     }
+
+  if (this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex->Delete();
+    this->CenterlineTopologyIndex = NULL;
+    }
 }
 
 int vtkvmtkPolyDataBifurcationSections::RequestData(
@@ -400,9 +412,24 @@ int vtkvmtkPolyDataBifurcationSections::RequestData(
   output->SetPoints(outputPoints);
   output->SetPolys(outputPolys);
 
+  if (!this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex = vtkvmtkCenterlineTopologyIndex::New();
+    }
+  this->CenterlineTopologyIndex->SetCenterlines(this->Centerlines);
+  this->CenterlineTopologyIndex->SetGroupIdsArrayName(this->CenterlineGroupIdsArrayName);
+  this->CenterlineTopologyIndex->SetCenterlineIdsArrayName(this->CenterlineIdsArrayName);
+  this->CenterlineTopologyIndex->SetTractIdsArrayName(this->CenterlineTractIdsArrayName);
+  this->CenterlineTopologyIndex->SetBlankingArrayName(this->BlankingArrayName);
+
   vtkIdList* blankedGroupIds = vtkIdList::New();
-  vtkvmtkCenterlineUtilities::GetBlankedGroupsIdList(this->Centerlines,this->CenterlineGroupIdsArrayName,this->BlankingArrayName,blankedGroupIds);
+  this->CenterlineTopologyIndex->GetBlankedGroupIds(blankedGroupIds);
   int i;
+  this->GroupPartition = vtkvmtkPolyDataGroupPartition::New();
+  this->GroupPartition->SetSurface(input);
+  this->GroupPartition->SetGroupIdsArrayName(this->GroupIdsArrayName);
+  this->GroupPartition->Build();
+
   for (i=0; i<blankedGroupIds->GetNumberOfIds(); i++)
   {
     vtkIdType bifurcationGroupId = blankedGroupIds->GetId(i);
@@ -411,7 +438,7 @@ int vtkvmtkPolyDataBifurcationSections::RequestData(
     vtkIdList* upStreamGroupIds = vtkIdList::New();
     vtkIdList* downStreamGroupIds = vtkIdList::New();
     
-    vtkvmtkCenterlineUtilities::FindAdjacentCenterlineGroupIds(this->Centerlines,this->CenterlineGroupIdsArrayName,this->CenterlineIdsArrayName,this->CenterlineTractIdsArrayName,bifurcationGroupId,upStreamGroupIds,downStreamGroupIds);
+    this->CenterlineTopologyIndex->FindAdjacentCenterlineGroupIds(bifurcationGroupId,upStreamGroupIds,downStreamGroupIds);
     
     this->ComputeBifurcationSections(input,bifurcationGroupId,upStreamGroupIds,downStreamGroupIds,output);
     
@@ -421,6 +448,9 @@ int vtkvmtkPolyDataBifurcationSections::RequestData(
 
   blankedGroupIds->Delete();
 
+  this->GroupPartition->Delete();
+  this->GroupPartition = NULL;
+
   outputPoints->Delete();
   outputPolys->Delete();
   
@@ -491,7 +521,7 @@ void vtkvmtkPolyDataBifurcationSections::ComputeBifurcationSections(vtkPolyData*
     int j;
     bool anyPoint = false;
     vtkIdList* groupCellIds = vtkIdList::New();
-    vtkvmtkCenterlineUtilities::GetGroupUniqueCellIds(this->Centerlines,this->CenterlineGroupIdsArrayName,bifurcationSectionGroupId,groupCellIds);
+    this->CenterlineTopologyIndex->GetGroupUniqueCellIds(bifurcationSectionGroupId,groupCellIds);
     for (j=0; j<groupCellIds->GetNumberOfIds(); j++)
       {
       vtkIdType cellId = groupCellIds->GetId(j);
@@ -583,7 +613,7 @@ void vtkvmtkPolyDataBifurcationSections::ComputeBifurcationSections(vtkPolyData*
     //now cut branch with plane and get section. Compute section properties and store them.
     
     vtkPolyData* cylinder = vtkPolyData::New();
-    vtkvmtkPolyDataBranchUtilities::ExtractGroup(input,this->GroupIdsArrayName,bifurcationSectionGroupId,false,cylinder);
+    this->GroupPartition->ExtractGroup(bifurcationSectionGroupId,false,cylinder);
 
     vtkPolyData* section = vtkPolyData::New();
     bool closed = false;
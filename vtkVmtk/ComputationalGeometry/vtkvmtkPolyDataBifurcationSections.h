@@ -41,6 +41,9 @@ Version:   $Revision: 1.1 $
 #include "vtkvmtkWin32Header.h"
 #include "vtkPolyData.h"
 
+class vtkvmtkPolyDataGroupPartition;
+class vtkvmtkCenterlineTopologyIndex;
+
 class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataBifurcationSections : public vtkPolyDataAlgorithm
 {
   public: 
@@ -106,6 +109,13 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataBifurcationSections
   vtkSetMacro(NumberOfDistanceSpheres,int);
   vtkGetMacro(NumberOfDistanceSpheres,int);
 
+  // Description:
+  // Topology index of the centerlines. If not set, one is created on the
+  // first update and kept; it can be shared among the filters working on the
+  // same split centerlines.
+  virtual void SetCenterlineTopologyIndex(vtkvmtkCenterlineTopologyIndex*);
+  vtkGetObjectMacro(CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
   protected:
   vtkvmtkPolyDataBifurcationSections();
   ~vtkvmtkPolyDataBifurcationSections();  
@@ -116,6 +126,9 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataBifurcationSections
   
   vtkPolyData* Centerlines;
 
+  vtkvmtkPolyDataGroupPartition* GroupPartition;
+  vtkvmtkCenterlineTopologyIndex* CenterlineTopologyIndex;
+
   char* GroupIdsArrayName;
   char* CenterlineRadiusArrayName;
   char* CenterlineGroupIdsArrayName;
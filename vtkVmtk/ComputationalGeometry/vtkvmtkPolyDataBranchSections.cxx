@@ -45,16 +45,22 @@ Version:   $Revision: 1.1 $
 #include "vtkVersion.h"
 
 #include "vtkvmtkCenterlineUtilities.h"
+#include "vtkvmtkCenterlineTopologyIndex.h"
 #include "vtkvmtkPolyDataBranchUtilities.h"
+#include "vtkvmtkPolyDataGroupPartition.h"
 
 
 vtkStandardNewMacro(vtkvmtkPolyDataBranchSections);
 
+vtkCxxSetObjectMacro(vtkvmtkPolyDataBranchSections,CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
 vtkvmtkPolyDataBranchSections::vtkvmtkPolyDataBranchSections()
 {
   this->GroupIdsArrayName = NULL;
 
   this->Centerlines = NULL;
+  this->GroupPartition = NULL;
+  this->CenterlineTopologyIndex = NULL;
 
   this->CenterlineRadiusArrayName = NULL;
   this->CenterlineGroupIdsArrayName = NULL;
@@ -159,6 +165,12 @@ vtkvmtkPolyDataBranchSections::~vtkvmtkPolyDataBranchSections()
     delete[] this->BranchSectionDistanceSpheresArrayName;
     this->BranchSectionDistanceSpheresArrayName = NULL;
     }
+
+  if (this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex->Delete();
+    this->CenterlineTopologyIndex = NULL;
+    }
 }
 
 int vtkvmtkPolyDataBranchSections::RequestData(
@@ -341,9 +353,24 @@ int vtkvmtkPolyDataBranchSections::RequestData(
   output->GetCellData()->AddArray(branchSectionClosedArray);
   output->GetCellData()->AddArray(branchSectionDistanceSpheresArray);
   
+  if (!this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex = vtkvmtkCenterlineTopologyIndex::New();
+    }
+  this->CenterlineTopologyIndex->SetCenterlines(this->Centerlines);
+  this->CenterlineTopologyIndex->SetGroupIdsArrayName(this->CenterlineGroupIdsArrayName);
+  this->CenterlineTopologyIndex->SetCenterlineIdsArrayName(this->CenterlineIdsArrayName);
+  this->CenterlineTopologyIndex->SetTractIdsArrayName(this->CenterlineTractIdsArrayName);
+  this->CenterlineTopologyIndex->SetBlankingArrayName(this->BlankingArrayName);
+
   vtkIdList* nonBlankedGroupIds = vtkIdList::New();
-  vtkvmtkCenterlineUtilities::GetNonBlankedGroupsIdList(this->Centerlines,this->CenterlineGroupIdsArrayName,this->BlankingArrayName,nonBlankedGroupIds);
+  this->CenterlineTopologyIndex->GetNonBlankedGroupIds(nonBlankedGroupIds);
   int i;
+  this->GroupPartition = vtkvmtkPolyDataGroupPartition::New();
+  this->GroupPartition->SetSurface(input);
+  this->GroupPartition->SetGroupIdsArrayName(this->GroupIdsArrayName);
+  this->GroupPartition->Build();
+
   for (i=0; i<nonBlankedGroupIds->GetNumberOfIds(); i++)
   {
     vtkIdType groupId = nonBlankedGroupIds->GetId(i);
@@ -353,6 +380,9 @@ int vtkvmtkPolyDataBranchSections::RequestData(
 
   nonBlankedGroupIds->Delete();
 
+  this->GroupPartition->Delete();
+  this->GroupPartition = NULL;
+
   outputPoints->Delete();
   outputPolys->Delete();
 
@@ -396,7 +426,7 @@ void vtkvmtkPolyDataBranchSections::ComputeBranchSections(vtkPolyData* input, in
     bool anyPoint = false;
     
     vtkIdList* groupCellIds = vtkIdList::New();
-    vtkvmtkCenterlineUtilities::GetGroupUniqueCellIds(this->Centerlines,this->CenterlineGroupIdsArrayName,groupId,groupCellIds);
+    this->CenterlineTopologyIndex->GetGroupUniqueCellIds(groupId,groupCellIds);
     for (j=0; j<groupCellIds->GetNumberOfIds(); j++)
       {
       vtkIdType centerlineCellId = groupCellIds->GetId(j);
@@ -467,7 +497,7 @@ void vtkvmtkPolyDataBranchSections::ComputeBranchSections(vtkPolyData* input, in
     //now cut branch with plane and get section. Compute section properties and store them.
 
     vtkPolyData* cylinder = vtkPolyData::New();
-    vtkvmtkPolyDataBranchUtilities::ExtractGroup(input,this->GroupIdsArrayName,groupId,false,cylinder);
+    this->GroupPartition->ExtractGroup(groupId,false,cylinder);
 
     vtkPolyData* section = vtkPolyData::New();
     bool closed = false;
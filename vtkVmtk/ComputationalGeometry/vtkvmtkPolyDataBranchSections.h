@@ -41,6 +41,9 @@ Version:   $Revision: 1.1 $
 #include "vtkvmtkWin32Header.h"
 #include "vtkPolyData.h"
 
+class vtkvmtkPolyDataGroupPartition;
+class vtkvmtkCenterlineTopologyIndex;
+
 class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataBranchSections : public vtkPolyDataAlgorithm
 {
   public: 
@@ -103,6 +106,13 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataBranchSections : pub
 
   static void ExtractCylinderSection(vtkPolyData* cylinder, double origin[3], double normal[3], vtkPolyData* section, bool & closed);
 
+  // Description:
+  // Topology index of the centerlines. If not set, one is created on the
+  // first update and kept; it can be shared among the filters working on the
+  // same split centerlines.
+  virtual void SetCenterlineTopologyIndex(vtkvmtkCenterlineTopologyIndex*);
+  vtkGetObjectMacro(CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
   protected:
   vtkvmtkPolyDataBranchSections();
   ~vtkvmtkPolyDataBranchSections();  
@@ -113,6 +123,9 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataBranchSections : pub
 
   vtkPolyData* Centerlines;
 
+  vtkvmtkPolyDataGroupPartition* GroupPartition;
+  vtkvmtkCenterlineTopologyIndex* CenterlineTopologyIndex;
+
   char* GroupIdsArrayName;
   char* CenterlineRadiusArrayName;
   char* CenterlineGroupIdsArrayName;
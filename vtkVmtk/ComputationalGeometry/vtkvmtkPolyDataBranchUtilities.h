@@ -22,6 +22,8 @@ Version:   $Revision: 1.3 $
 // .SECTION Description
 // - ExtractGroup: Extract a single surface branch group from a surface which has already been grouped. 
 // - GetGroupIdsList: get the group ids which are contained within a grouped surface as a vtkIdList.
+// To extract many groups from the same surface use vtkvmtkPolyDataGroupPartition,
+// which indexes the surface once.
 
 #ifndef __vtkvmtkPolyDataBranchUtilities_h
 #define __vtkvmtkPolyDataBranchUtilities_h
@@ -0,0 +1,302 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    $RCSfile: vtkvmtkPolyDataGroupPartition.cxx,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:46:43 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "vtkvmtkPolyDataGroupPartition.h"
+#include "vtkCleanPolyData.h"
+#include "vtkPolyData.h"
+#include "vtkPointData.h"
+#include "vtkCellData.h"
+#include "vtkCellArray.h"
+#include "vtkIdList.h"
+#include "vtkObjectFactory.h"
+
+#include <algorithm>
+
+
+vtkStandardNewMacro(vtkvmtkPolyDataGroupPartition);
+
+vtkCxxSetObjectMacro(vtkvmtkPolyDataGroupPartition,Surface,vtkPolyData);
+
+vtkvmtkPolyDataGroupPartition::vtkvmtkPolyDataGroupPartition()
+{
+  this->Surface = NULL;
+  this->GroupIdsArrayName = NULL;
+}
+
+vtkvmtkPolyDataGroupPartition::~vtkvmtkPolyDataGroupPartition()
+{
+  if (this->Surface)
+    {
+    this->Surface->Delete();
+    this->Surface = NULL;
+    }
+
+  if (this->GroupIdsArrayName)
+    {
+    delete[] this->GroupIdsArrayName;
+    this->GroupIdsArrayName = NULL;
+    }
+}
+
+void vtkvmtkPolyDataGroupPartition::Build()
+{
+  this->GroupIds.clear();
+  this->CellOffsets.assign(1,0);
+  this->CellIds.clear();
+  this->LocalPointIds.clear();
+  this->BuildTime.Modified();
+
+  if (!this->Surface)
+    {
+    vtkErrorMacro(<<"No surface specified.");
+    return;
+    }
+
+  vtkDataArray* groupIdsArray = this->GroupIdsArrayName ? this->Surface->GetPointData()->GetArray(this->GroupIdsArrayName) : NULL;
+  if (!groupIdsArray)
+    {
+    vtkErrorMacro(<<"GroupIdsArray with name specified does not exist.");
+    return;
+    }
+
+  vtkIdType numberOfPoints = this->Surface->GetNumberOfPoints();
+  std::vector<vtkIdType> pointGroupIds(numberOfPoints);
+  vtkIdType i;
+  for (i=0; i<numberOfPoints; i++)
+    {
+    pointGroupIds[i] = static_cast<int>(groupIdsArray->GetComponent(i,0));
+    }
+
+  this->GroupIds = pointGroupIds;
+  std::sort(this->GroupIds.begin(),this->GroupIds.end());
+  this->GroupIds.erase(std::unique(this->GroupIds.begin(),this->GroupIds.end()),this->GroupIds.end());
+
+  vtkIdType numberOfGroups = static_cast<vtkIdType>(this->GroupIds.size());
+  this->CellOffsets.assign(numberOfGroups+1,0);
+
+  // polygon ids follow vertices and lines
+  vtkIdType firstPolyId = this->Surface->GetNumberOfVerts() + this->Surface->GetNumberOfLines();
+  vtkCellArray* polys = this->Surface->GetPolys();
+  vtkIdType numberOfPolys = polys->GetNumberOfCells();
+  std::vector<vtkIdType> polyGroups(numberOfPolys,-1);
+
+  vtkIdType npts;
+  const vtkIdType *pts;
+  vtkIdType polyId = 0;
+  for (polys->InitTraversal(); polys->GetNextCell(npts,pts); polyId++)
+    {
+    if (npts == 0)
+      {
+      continue;
+      }
+    vtkIdType groupId = pointGroupIds[pts[0]];
+    bool insertCell = true;
+    for (vtkIdType k=1; k<npts; k++)
+      {
+      if (pointGroupIds[pts[k]] != groupId)
+        {
+        insertCell = false;
+        break;
+        }
+      }
+    if (!insertCell)
+      {
+      continue;
+      }
+    vtkIdType groupIndex = this->FindGroup(groupId);
+    polyGroups[polyId] = groupIndex;
+    this->CellOffsets[groupIndex+1]++;
+    }
+
+  for (i=0; i<numberOfGroups; i++)
+    {
+    this->CellOffsets[i+1] += this->CellOffsets[i];
+    }
+
+  this->CellIds.resize(this->CellOffsets[numberOfGroups]);
+  std::vector<vtkIdType> fill(this->CellOffsets.begin(),this->CellOffsets.end()-1);
+  for (polyId=0; polyId<numberOfPolys; polyId++)
+    {
+    if (polyGroups[polyId] >= 0)
+      {
+      this->CellIds[fill[polyGroups[polyId]]++] = firstPolyId + polyId;
+      }
+    }
+
+  this->LocalPointIds.assign(numberOfPoints,-1);
+}
+
+void vtkvmtkPolyDataGroupPartition::BuildIfNeeded()
+{
+  if (this->CellOffsets.empty() || this->GetMTime() > this->BuildTime || (this->Surface && this->Surface->GetMTime() > this->BuildTime))
+    {
+    this->Build();
+    }
+}
+
+vtkIdType vtkvmtkPolyDataGroupPartition::FindGroup(vtkIdType groupId)
+{
+  std::vector<vtkIdType>::const_iterator it = std::lower_bound(this->GroupIds.begin(),this->GroupIds.end(),groupId);
+  if (it == this->GroupIds.end() || *it != groupId)
+    {
+    return -1;
+    }
+  return static_cast<vtkIdType>(it - this->GroupIds.begin());
+}
+
+void vtkvmtkPolyDataGroupPartition::GetGroupIds(vtkIdList* groupIds)
+{
+  this->BuildIfNeeded();
+  groupIds->Initialize();
+  for (size_t i=0; i<this->GroupIds.size(); i++)
+    {
+    groupIds->InsertNextId(this->GroupIds[i]);
+    }
+}
+
+vtkIdType vtkvmtkPolyDataGroupPartition::GetNumberOfGroupCells(vtkIdType groupId)
+{
+  this->BuildIfNeeded();
+  vtkIdType groupIndex = this->FindGroup(groupId);
+  if (groupIndex < 0)
+    {
+    return 0;
+    }
+  return this->CellOffsets[groupIndex+1] - this->CellOffsets[groupIndex];
+}
+
+void vtkvmtkPolyDataGroupPartition::GetGroupCellIds(vtkIdType groupId, vtkIdList* cellIds)
+{
+  this->BuildIfNeeded();
+  cellIds->Initialize();
+  vtkIdType groupIndex = this->FindGroup(groupId);
+  if (groupIndex < 0)
+    {
+    return;
+    }
+  vtkIdType begin = this->CellOffsets[groupIndex];
+  vtkIdType end = this->CellOffsets[groupIndex+1];
+  cellIds->SetNumberOfIds(end-begin);
+  for (vtkIdType i=begin; i<end; i++)
+    {
+    cellIds->SetId(i-begin,this->CellIds[i]);
+    }
+}
+
+void vtkvmtkPolyDataGroupPartition::ExtractGroup(vtkIdType groupId, bool compactGroupSurface, vtkPolyData* groupSurface)
+{
+  this->BuildIfNeeded();
+
+  groupSurface->Initialize();
+
+  if (!this->Surface)
+    {
+    return;
+    }
+
+  vtkIdType begin = 0;
+  vtkIdType end = 0;
+  vtkIdType groupIndex = this->FindGroup(groupId);
+  if (groupIndex >= 0)
+    {
+    begin = this->CellOffsets[groupIndex];
+    end = this->CellOffsets[groupIndex+1];
+    }
+
+  vtkPointData* pointData = this->Surface->GetPointData();
+  vtkCellData* cellData = this->Surface->GetCellData();
+
+  vtkCellArray* polys = vtkCellArray::New();
+  polys->AllocateEstimate(end-begin,3);
+  vtkCellData* groupCellData = groupSurface->GetCellData();
+  groupCellData->CopyAllocate(cellData,end-begin);
+
+  vtkIdType npts;
+  const vtkIdType *pts;
+  vtkIdType i, k;
+
+  if (!compactGroupSurface)
+    {
+    groupSurface->SetPoints(this->Surface->GetPoints());
+    groupSurface->GetPointData()->ShallowCopy(pointData);
+    for (i=begin; i<end; i++)
+      {
+      this->Surface->GetCellPoints(this->CellIds[i],npts,pts);
+      vtkIdType newCellId = polys->InsertNextCell(npts,pts);
+      groupCellData->CopyData(cellData,this->CellIds[i],newCellId);
+      }
+    groupSurface->SetPolys(polys);
+    polys->Delete();
+    return;
+    }
+
+  // points are numbered by first use, as vtkCleanPolyData does
+  vtkPoints* points = vtkPoints::New();
+  points->SetDataType(this->Surface->GetPoints()->GetDataType());
+  vtkPointData* groupPointData = groupSurface->GetPointData();
+  groupPointData->CopyAllocate(pointData);
+  std::vector<vtkIdType> usedPointIds;
+  std::vector<vtkIdType> localPts;
+  for (i=begin; i<end; i++)
+    {
+    this->Surface->GetCellPoints(this->CellIds[i],npts,pts);
+    localPts.resize(npts);
+    for (k=0; k<npts; k++)
+      {
+      vtkIdType& localPointId = this->LocalPointIds[pts[k]];
+      if (localPointId < 0)
+        {
+        localPointId = points->InsertNextPoint(this->Surface->GetPoint(pts[k]));
+        groupPointData->CopyData(pointData,pts[k],localPointId);
+        usedPointIds.push_back(pts[k]);
+        }
+      localPts[k] = localPointId;
+      }
+    vtkIdType newCellId = polys->InsertNextCell(npts,&localPts[0]);
+    groupCellData->CopyData(cellData,this->CellIds[i],newCellId);
+    }
+
+  for (size_t j=0; j<usedPointIds.size(); j++)
+    {
+    this->LocalPointIds[usedPointIds[j]] = -1;
+    }
+
+  groupSurface->SetPoints(points);
+  groupSurface->SetPolys(polys);
+  points->Delete();
+  polys->Delete();
+
+  vtkCleanPolyData* cleaner = vtkCleanPolyData::New();
+  cleaner->SetInputData(groupSurface);
+  cleaner->Update();
+
+  groupSurface->DeepCopy(cleaner->GetOutput());
+
+  cleaner->Delete();
+}
+
+void vtkvmtkPolyDataGroupPartition::PrintSelf(std::ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "Surface: " << this->Surface << endl;
+  os << indent << "GroupIdsArrayName: " << (this->GroupIdsArrayName ? this->GroupIdsArrayName : "(none)") << endl;
+  os << indent << "Number of groups: " << this->GroupIds.size() << endl;
+}
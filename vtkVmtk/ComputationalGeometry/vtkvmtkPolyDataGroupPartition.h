@@ -0,0 +1,111 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    $RCSfile: vtkvmtkPolyDataGroupPartition.h,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:46:43 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// .NAME vtkvmtkPolyDataGroupPartition - Index of the polygons of a grouped surface by group id.
+// .SECTION Description
+// vtkvmtkPolyDataGroupPartition sorts the polygons of a surface whose points
+// carry a group id array into one bucket per group in a single pass. As in
+// vtkvmtkPolyDataBranchUtilities::ExtractGroup, a polygon belongs to a group
+// if all its points have that group id.
+//
+// ExtractGroup then builds a group surface in time proportional to the size
+// of the group. Without compaction the group surface is a view on the input:
+// it shares its points and point data arrays (point ids are unchanged) and
+// only owns the polygons of the group. With compaction only the points used
+// by the group are copied, with their point data, and the result is cleaned
+// as with vtkCleanPolyData.
+//
+// The index is rebuilt on demand when the surface is modified.
+//
+// .SECTION See Also
+// vtkvmtkPolyDataBranchUtilities
+
+#ifndef __vtkvmtkPolyDataGroupPartition_h
+#define __vtkvmtkPolyDataGroupPartition_h
+
+#include "vtkObject.h"
+#include "vtkvmtkWin32Header.h"
+
+#include <vector>
+
+class vtkPolyData;
+class vtkIdList;
+
+class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataGroupPartition : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkvmtkPolyDataGroupPartition,vtkObject);
+  void PrintSelf(std::ostream& os, vtkIndent indent) override;
+
+  static vtkvmtkPolyDataGroupPartition* New();
+
+  virtual void SetSurface(vtkPolyData*);
+  vtkGetObjectMacro(Surface,vtkPolyData);
+
+  vtkSetStringMacro(GroupIdsArrayName);
+  vtkGetStringMacro(GroupIdsArrayName);
+
+  // Description:
+  // Build the index. Called by the other methods if the surface or the
+  // array name changed since the last build.
+  void Build();
+
+  // Description:
+  // Group ids found on the points of the surface, in increasing order (as
+  // vtkvmtkPolyDataBranchUtilities::GetGroupsIdList).
+  void GetGroupIds(vtkIdList* groupIds);
+
+  // Description:
+  // Ids of the polygons of a group.
+  void GetGroupCellIds(vtkIdType groupId, vtkIdList* cellIds);
+  vtkIdType GetNumberOfGroupCells(vtkIdType groupId);
+
+  // Description:
+  // Extract the polygons of a group into groupSurface, either as a view on
+  // the surface points or as a compact cleaned surface.
+  void ExtractGroup(vtkIdType groupId, bool compactGroupSurface, vtkPolyData* groupSurface);
+
+protected:
+  vtkvmtkPolyDataGroupPartition();
+  ~vtkvmtkPolyDataGroupPartition();
+
+  void BuildIfNeeded();
+  vtkIdType FindGroup(vtkIdType groupId);
+
+  vtkPolyData* Surface;
+  char* GroupIdsArrayName;
+
+  vtkTimeStamp BuildTime;
+
+  // sorted group ids and, for group i, its polygon ids in
+  // CellIds[CellOffsets[i]..CellOffsets[i+1])
+  std::vector<vtkIdType> GroupIds;
+  std::vector<vtkIdType> CellOffsets;
+  std::vector<vtkIdType> CellIds;
+
+  // global to local point ids, -1 outside of the group being extracted
+  std::vector<vtkIdType> LocalPointIds;
+
+private:
+  vtkvmtkPolyDataGroupPartition(const vtkvmtkPolyDataGroupPartition&);  // Not implemented.
+  void operator=(const vtkvmtkPolyDataGroupPartition&);  // Not implemented.
+};
+
+#endif
@@ -27,13 +27,176 @@ Version:   $Revision: 1.5 $
 #include "vtkCell.h"
 #include "vtkMath.h"
 #include "vtkDoubleArray.h"
+#include "vtkIntArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
 #include "vtkVersion.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
 
 #include "vtkvmtkConstants.h"
 
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+// Local geometry of a range of surface points from the Voronoi diagram
+// point which is their pole. Voronoi arrays which are not needed and output
+// arrays which are not requested are NULL. Points with an invalid pole id
+// are left to 0 and counted in InvalidPoleIds.
+class LocalGeometryFunctor
+{
+public:
+  LocalGeometryFunctor(vtkPolyData* input, vtkPolyData* voronoiDiagram, vtkIdList* poleIds,
+    vtkDataArray* voronoiGeodesicDistanceArray, vtkDataArray* voronoiPoleVectorsArray, vtkDataArray* voronoiCellIdsArray, vtkDataArray* voronoiPCoordsArray,
+    vtkDoubleArray* poleVectorsArray, vtkDoubleArray* geodesicDistanceArray, vtkDoubleArray* normalizedTangencyDeviationArray,
+    vtkDoubleArray* euclideanDistanceArray, vtkDoubleArray* centerlineVectorsArray, vtkIntArray* cellIdsArray, vtkDoubleArray* pcoordsArray)
+    : Input(input), VoronoiDiagram(voronoiDiagram), PoleIds(poleIds),
+      VoronoiGeodesicDistanceArray(voronoiGeodesicDistanceArray), VoronoiPoleVectorsArray(voronoiPoleVectorsArray), VoronoiCellIdsArray(voronoiCellIdsArray), VoronoiPCoordsArray(voronoiPCoordsArray),
+      PoleVectorsArray(poleVectorsArray), GeodesicDistanceArray(geodesicDistanceArray), NormalizedTangencyDeviationArray(normalizedTangencyDeviationArray),
+      EuclideanDistanceArray(euclideanDistanceArray), CenterlineVectorsArray(centerlineVectorsArray), CellIdsArray(cellIdsArray), PCoordsArray(pcoordsArray),
+      InvalidPoleIds(0)
+  {
+    this->NumberOfInvalidPoleIds = 0;
+    int numberOfComponents = 0;
+    if (this->VoronoiCellIdsArray)
+      {
+      numberOfComponents = std::max(numberOfComponents,this->VoronoiCellIdsArray->GetNumberOfComponents());
+      }
+    if (this->VoronoiPCoordsArray)
+      {
+      numberOfComponents = std::max(numberOfComponents,this->VoronoiPCoordsArray->GetNumberOfComponents());
+      }
+    this->TupleSize = numberOfComponents;
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    std::vector<double>& tuple = this->Tuples.Local();
+    tuple.resize(this->TupleSize);
+    vtkIdType& invalidPoleIds = this->InvalidPoleIds.Local();
+    double surfacePoint[3], polePoint[3], poleVector[3], voronoiPoleVector[3], centerlinePoint[3], centerlineVector[3];
+    double voronoiRadius, voronoiGeodesicDistance;
+    double geodesicDistance, normalizedTangencyDeviation;
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      vtkIdType poleId = this->PoleIds->GetId(i);
+
+      if (poleId == -1)
+        {
+        invalidPoleIds++;
+        continue;
+        }
+
+      this->Input->GetPoint(i,surfacePoint);
+      this->VoronoiDiagram->GetPoint(poleId,polePoint);
+
+      if (this->PoleVectorsArray)
+        {
+        poleVector[0] = polePoint[0] - surfacePoint[0];
+        poleVector[1] = polePoint[1] - surfacePoint[1];
+        poleVector[2] = polePoint[2] - surfacePoint[2];
+        this->PoleVectorsArray->SetTuple(i,poleVector);
+        }
+
+      if (this->GeodesicDistanceArray || this->NormalizedTangencyDeviationArray)
+        {
+        voronoiRadius = sqrt(vtkMath::Distance2BetweenPoints(surfacePoint,polePoint));
+        voronoiGeodesicDistance = this->VoronoiGeodesicDistanceArray->GetComponent(poleId,0);
+
+        geodesicDistance = voronoiGeodesicDistance + voronoiRadius;
+        if (geodesicDistance > VTK_VMTK_DOUBLE_TOL)
+          {
+          normalizedTangencyDeviation = voronoiGeodesicDistance / geodesicDistance;
+          }
+        else
+          {
+          normalizedTangencyDeviation = 1.0;
+          }
+
+        if (this->GeodesicDistanceArray)
+          {
+          this->GeodesicDistanceArray->SetComponent(i,0,geodesicDistance);
+          }
+
+        if (this->NormalizedTangencyDeviationArray)
+          {
+          this->NormalizedTangencyDeviationArray->SetComponent(i,0,normalizedTangencyDeviation);
+          }
+        }
+
+      if (this->EuclideanDistanceArray || this->CenterlineVectorsArray)
+        {
+        this->VoronoiPoleVectorsArray->GetTuple(poleId,voronoiPoleVector);
+        centerlinePoint[0] = polePoint[0] + voronoiPoleVector[0];
+        centerlinePoint[1] = polePoint[1] + voronoiPoleVector[1];
+        centerlinePoint[2] = polePoint[2] + voronoiPoleVector[2];
+        centerlineVector[0] = centerlinePoint[0] - surfacePoint[0];
+        centerlineVector[1] = centerlinePoint[1] - surfacePoint[1];
+        centerlineVector[2] = centerlinePoint[2] - surfacePoint[2];
+        if (this->EuclideanDistanceArray)
+          {
+          this->EuclideanDistanceArray->SetComponent(i,0,sqrt(vtkMath::Distance2BetweenPoints(surfacePoint,centerlinePoint)));
+          }
+        if (this->CenterlineVectorsArray)
+          {
+          this->CenterlineVectorsArray->SetTuple(i,centerlineVector);
+          }
+        }
+
+      // GetTuple(id) returns a buffer shared by the threads, so the tuple
+      // is read into a thread local one
+      if (this->CellIdsArray)
+        {
+        this->VoronoiCellIdsArray->GetTuple(poleId,&tuple[0]);
+        this->CellIdsArray->SetTuple(i,&tuple[0]);
+        }
+
+      if (this->PCoordsArray)
+        {
+        this->VoronoiPCoordsArray->GetTuple(poleId,&tuple[0]);
+        this->PCoordsArray->SetTuple(i,&tuple[0]);
+        }
+      }
+  }
+
+  // Sums the thread local counts of invalid pole ids.
+  void Reduce()
+  {
+    this->NumberOfInvalidPoleIds = 0;
+    for (vtkSMPThreadLocal<vtkIdType>::iterator it=this->InvalidPoleIds.begin(); it!=this->InvalidPoleIds.end(); ++it)
+      {
+      this->NumberOfInvalidPoleIds += *it;
+      }
+  }
+
+  vtkIdType NumberOfInvalidPoleIds;
+
+private:
+  vtkPolyData* Input;
+  vtkPolyData* VoronoiDiagram;
+  vtkIdList* PoleIds;
+  vtkDataArray* VoronoiGeodesicDistanceArray;
+  vtkDataArray* VoronoiPoleVectorsArray;
+  vtkDataArray* VoronoiCellIdsArray;
+  vtkDataArray* VoronoiPCoordsArray;
+  vtkDoubleArray* PoleVectorsArray;
+  vtkDoubleArray* GeodesicDistanceArray;
+  vtkDoubleArray* NormalizedTangencyDeviationArray;
+  vtkDoubleArray* EuclideanDistanceArray;
+  vtkDoubleArray* CenterlineVectorsArray;
+  vtkIntArray* CellIdsArray;
+  vtkDoubleArray* PCoordsArray;
+  int TupleSize;
+  mutable vtkSMPThreadLocal<std::vector<double> > Tuples;
+  mutable vtkSMPThreadLocal<vtkIdType> InvalidPoleIds;
+};
+
+}
+
 
 vtkStandardNewMacro(vtkvmtkPolyDataLocalGeometry);
 
@@ -63,6 +226,8 @@ vtkvmtkPolyDataLocalGeometry::vtkvmtkPolyDataLocalGeometry()
   this->VoronoiPCoordsArrayName = NULL;
   this->VoronoiDiagram = NULL;
   this->PoleIds = NULL;
+
+  this->ParallelComputation = 1;
 }
 
 vtkvmtkPolyDataLocalGeometry::~vtkvmtkPolyDataLocalGeometry()
@@ -128,11 +293,7 @@ int vtkvmtkPolyDataLocalGeometry::RequestData(
   vtkPolyData *output = vtkPolyData::SafeDownCast(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
-  vtkIdType i, poleId;
-  double surfacePoint[3], polePoint[3], poleVector[3], voronoiPoleVector[3], centerlinePoint[3], centerlineVector[3];
-  double voronoiRadius, voronoiGeodesicDistance;
-  double geodesicDistance, normalizedTangencyDeviation;
-  double euclideanDistance;
+  vtkIdType numberOfPoints;
   vtkDataArray* voronoiGeodesicDistanceArray = NULL;
   vtkDataArray* voronoiPoleVectorsArray = NULL;
   vtkDataArray* voronoiCellIdsArray = NULL;
@@ -277,6 +438,12 @@ int vtkvmtkPolyDataLocalGeometry::RequestData(
       }
     }
 
+  if (this->PoleIds->GetNumberOfIds() < input->GetNumberOfPoints())
+    {
+    vtkErrorMacro(<< "Fewer poleIds than input points!");
+    return 1;
+    }
+
   if (this->ComputePoleVectors)
     {
     poleVectorsArray = vtkDoubleArray::New();
@@ -342,85 +509,26 @@ int vtkvmtkPolyDataLocalGeometry::RequestData(
     pcoordsArray->FillComponent(0,0.0);
     }
 
-  for (i=0; i<input->GetNumberOfPoints(); i++)
-    {
-    poleId = this->PoleIds->GetId(i);
+  numberOfPoints = input->GetNumberOfPoints();
 
-    if (poleId == -1)
-      {
-      vtkWarningMacro(<<"Invalid PoleId found");
-      }
-
-    if (this->ComputePoleVectors)
-      {
-      input->GetPoint(i,surfacePoint);
-      this->VoronoiDiagram->GetPoint(poleId,polePoint);
-      poleVector[0] = polePoint[0] - surfacePoint[0];
-      poleVector[1] = polePoint[1] - surfacePoint[1];
-      poleVector[2] = polePoint[2] - surfacePoint[2];
-      poleVectorsArray->SetTuple(i,poleVector);
-      }
+  LocalGeometryFunctor functor(input,this->VoronoiDiagram,this->PoleIds,
+    voronoiGeodesicDistanceArray,voronoiPoleVectorsArray,voronoiCellIdsArray,voronoiPCoordsArray,
+    poleVectorsArray,geodesicDistanceArray,normalizedTangencyDeviationArray,
+    euclideanDistanceArray,centerlineVectorsArray,cellIdsArray,pcoordsArray);
 
-    if (this->ComputeGeodesicDistance || this->ComputeNormalizedTangencyDeviation)
-      {
-      input->GetPoint(i,surfacePoint);
-      this->VoronoiDiagram->GetPoint(poleId,polePoint);
-
-      voronoiRadius = sqrt(vtkMath::Distance2BetweenPoints(surfacePoint,polePoint));
-      voronoiGeodesicDistance = voronoiGeodesicDistanceArray->GetTuple1(poleId);
-
-      geodesicDistance = voronoiGeodesicDistance + voronoiRadius;
-      if (geodesicDistance > VTK_VMTK_DOUBLE_TOL)
-        {
-        normalizedTangencyDeviation = voronoiGeodesicDistance / geodesicDistance;
-        }
-      else
-        {
-        normalizedTangencyDeviation = 1.0;
-        }
-
-      if (this->ComputeGeodesicDistance)
-        {
-        geodesicDistanceArray->SetComponent(i,0,geodesicDistance);
-        }
-
-      if (this->ComputeNormalizedTangencyDeviation)
-        {
-        normalizedTangencyDeviationArray->SetComponent(i,0,normalizedTangencyDeviation);
-        }
-      }
-    
-    if (this->ComputeEuclideanDistance || this->ComputeCenterlineVectors)
-      {
-      input->GetPoint(i,surfacePoint);
-      this->VoronoiDiagram->GetPoint(poleId,polePoint);
-      voronoiPoleVectorsArray->GetTuple(poleId,voronoiPoleVector);
-      centerlinePoint[0] = polePoint[0] + voronoiPoleVector[0];
-      centerlinePoint[1] = polePoint[1] + voronoiPoleVector[1];
-      centerlinePoint[2] = polePoint[2] + voronoiPoleVector[2];
-      centerlineVector[0] = centerlinePoint[0] - surfacePoint[0];
-      centerlineVector[1] = centerlinePoint[1] - surfacePoint[1];
-      centerlineVector[2] = centerlinePoint[2] - surfacePoint[2];
-      if (this->ComputeEuclideanDistance)
-        {
-        euclideanDistance = sqrt(vtkMath::Distance2BetweenPoints(surfacePoint,centerlinePoint));
-        euclideanDistanceArray->SetComponent(i,0,euclideanDistance);
-        }
-      if (this->ComputeCenterlineVectors)
-        {
-        centerlineVectorsArray->SetTuple(i,centerlineVector);
-        }
-      }
-
-    if (this->ComputeCellIds)
-      {
-      cellIdsArray->SetTuple(i,voronoiCellIdsArray->GetTuple(poleId));
-      }
+  if (this->ParallelComputation)
+    {
+    vtkSMPTools::For(0,numberOfPoints,functor);
+    }
+  else
+    {
+    functor(0,numberOfPoints);
+    }
+  functor.Reduce();
 
-    if (this->ComputePCoords)
-      {
-      pcoordsArray->SetTuple(i,voronoiPCoordsArray->GetTuple(poleId));
-      }
+  if (functor.NumberOfInvalidPoleIds > 0)
+    {
+    vtkWarningMacro(<<"Invalid PoleId found for "<<functor.NumberOfInvalidPoleIds<<" points");
     }
 
    output->CopyStructure(input);
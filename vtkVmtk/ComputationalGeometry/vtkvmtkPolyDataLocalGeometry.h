@@ -163,6 +163,12 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataLocalGeometry : publ
   vtkSetStringMacro(PoleVectorsArrayName);
   vtkGetStringMacro(PoleVectorsArrayName);
 
+  // Description:
+  // Turn on/off the concurrent processing of the surface points.
+  vtkSetMacro(ParallelComputation,int);
+  vtkGetMacro(ParallelComputation,int);
+  vtkBooleanMacro(ParallelComputation,int);
+
   protected:
   vtkvmtkPolyDataLocalGeometry();
   ~vtkvmtkPolyDataLocalGeometry();  
@@ -196,6 +202,8 @@ class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataLocalGeometry : publ
   vtkPolyData* VoronoiDiagram;
   vtkIdList* PoleIds;
 
+  int ParallelComputation;
+
   private:
   vtkvmtkPolyDataLocalGeometry(const vtkvmtkPolyDataLocalGeometry&);  // Not implemented.
   void operator=(const vtkvmtkPolyDataLocalGeometry&);  // Not implemented.
@@ -37,261 +37,67 @@
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
 #include "vtkVersion.h"
+#include "vtkSmartPointer.h"
+#include "vtkSMPTools.h"
+
+#include <vector>
 
 #include "vtkvmtkPolyDataBranchUtilities.h"
+#include "vtkvmtkPolyDataGroupPartition.h"
 
 
 vtkStandardNewMacro(vtkvmtkPolyDataPatchingFilter);
 
-vtkvmtkPolyDataPatchingFilter::vtkvmtkPolyDataPatchingFilter() 
-{
-  this->LongitudinalMappingArrayName = NULL;
-  this->CircularMappingArrayName = NULL;
-  this->GroupIdsArrayName = NULL;
-  this->LongitudinalPatchNumberArrayName = NULL;
-  this->CircularPatchNumberArrayName = NULL;
-  this->PatchAreaArrayName = NULL;
-  this->PatchSize[0] = this->PatchSize[1] = 0.0;
-  this->PatchOffsets[0] = this->PatchOffsets[1] = 0.0;
-  this->LongitudinalPatchBounds[0] = this->LongitudinalPatchBounds[1] = 0.0;
-  this->CircularPatchBounds[0] = this->CircularPatchBounds[1] = 0.0; 
-  this->PatchedData = NULL;
-  this->CircularPatching = 1;
-  this->UseConnectivity = 1;
-}
-
-vtkvmtkPolyDataPatchingFilter::~vtkvmtkPolyDataPatchingFilter()
-{
-  if (this->LongitudinalMappingArrayName)
-    {
-    delete[] this->LongitudinalMappingArrayName;
-    this->LongitudinalMappingArrayName = NULL;
-    }
-
-  if (this->CircularMappingArrayName)
-    {
-    delete[] this->CircularMappingArrayName;
-    this->CircularMappingArrayName = NULL;
-    }
-
-  if (this->LongitudinalPatchNumberArrayName)
-    {
-    delete[] this->LongitudinalPatchNumberArrayName;
-    this->LongitudinalPatchNumberArrayName = NULL;
-    }
-
-  if (this->CircularPatchNumberArrayName)
-    {
-    delete[] this->CircularPatchNumberArrayName;
-    this->CircularPatchNumberArrayName = NULL;
-    }
-
-  if (this->PatchAreaArrayName)
-    {
-    delete[] this->PatchAreaArrayName;
-    this->PatchAreaArrayName = NULL;
-    }
-
-  if (this->PatchedData)
-    {
-    this->PatchedData->Delete();
-    this->PatchedData = NULL;
-    }
-}
-
-int vtkvmtkPolyDataPatchingFilter::RequestData(
-  vtkInformation *vtkNotUsed(request),
-  vtkInformationVector **inputVector,
-  vtkInformationVector *outputVector)
+namespace
 {
-  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
-  vtkInformation *outInfo = outputVector->GetInformationObject(0);
-
-  vtkPolyData *input = vtkPolyData::SafeDownCast(
-    inInfo->Get(vtkDataObject::DATA_OBJECT()));
-  vtkPolyData *output = vtkPolyData::SafeDownCast(
-    outInfo->Get(vtkDataObject::DATA_OBJECT()));
-
-  if (!this->LongitudinalPatchNumberArrayName)
-    {
-    vtkErrorMacro(<<"LongitudinalPatchNumberArrayName not set.");
-    return 1;
-    }
-
-  if (!this->CircularPatchNumberArrayName)
-    {
-    vtkErrorMacro(<<"CircularPatchNumberArrayName not set.");
-    return 1;
-    }
-
-  if (!this->PatchAreaArrayName)
-    {
-    vtkErrorMacro(<<"PatchAreaArrayName not set.");
-    return 1;
-    }
-
-  if (!this->LongitudinalMappingArrayName)
-    {
-    vtkErrorMacro(<<"LongitudinalMappingArrayName not set.");
-    return 1;
-    }
-
-  vtkDataArray* longitudinalMappingArray = input->GetPointData()->GetArray(this->LongitudinalMappingArrayName);
-
-  if (!longitudinalMappingArray)
-    {
-    vtkErrorMacro(<<"LongitudinalMappingArray with name specified does not exist.");
-    return 1;
-    }
-
-  vtkDataArray* circularMappingArray = NULL;
-  if (this->CircularPatching)
-    {
-  
-    if (!this->CircularMappingArrayName)
-      {
-      vtkErrorMacro(<<"CircularMappingArrayName not set.");
-      return 1;
-      }
-
-    circularMappingArray = input->GetPointData()->GetArray(this->CircularMappingArrayName);
-
-    if (!circularMappingArray)
-      {
-      vtkErrorMacro(<<"CircularMappingArray with name specified does not exist.");
-      return 1;
-      }
-    }
-
-  if (!this->GroupIdsArrayName)
-    {
-    vtkErrorMacro(<<"GroupIdsArrayName not set.");
-    return 1;
-    }
-
-  vtkDataArray* groupIdsArray = input->GetPointData()->GetArray(this->GroupIdsArrayName);
-
-  if (!groupIdsArray)
-    {
-    vtkErrorMacro(<<"GroupIdsArray with name specified does not exist.");
-    return 1;
-    }
-
-  int numberOfInputPoints = input->GetNumberOfPoints();
-
-  double circumferentialActualPatchSize = this->PatchSize[1] * 2.0 * vtkMath::Pi();
- 
-  char shiftedCircularMapping90ArrayName[] = "ShiftedCircularMapping90";
-  char shiftedCircularMapping180ArrayName[] = "ShiftedCircularMapping180";
-  char shiftedCircularMapping270ArrayName[] = "ShiftedCircularMapping270";
-
-  vtkDoubleArray* shiftedCircularMapping90Array = vtkDoubleArray::New();
-  shiftedCircularMapping90Array->SetName(shiftedCircularMapping90ArrayName);
-  shiftedCircularMapping90Array->SetNumberOfComponents(1);
-  shiftedCircularMapping90Array->SetNumberOfTuples(numberOfInputPoints);
-  vtkDoubleArray* shiftedCircularMapping180Array = vtkDoubleArray::New();
-  shiftedCircularMapping180Array->SetName(shiftedCircularMapping180ArrayName);
-  shiftedCircularMapping180Array->SetNumberOfComponents(1);
-  shiftedCircularMapping180Array->SetNumberOfTuples(numberOfInputPoints);
-  vtkDoubleArray* shiftedCircularMapping270Array = vtkDoubleArray::New();
-  shiftedCircularMapping270Array->SetName(shiftedCircularMapping270ArrayName);
-  shiftedCircularMapping270Array->SetNumberOfComponents(1);
-  shiftedCircularMapping270Array->SetNumberOfTuples(numberOfInputPoints);
-
-  int i;
-  if (this->CircularPatching)
-    {
-    for (i=0; i<numberOfInputPoints; i++)
-      {
-      double value = circularMappingArray->GetComponent(i,0);
-      double shiftedValue = value + 0.5 * vtkMath::Pi();
-      if (shiftedValue > vtkMath::Pi())
-        {
-        shiftedValue -= 2.0 * vtkMath::Pi();
-        }
-      shiftedCircularMapping90Array->SetValue(i,shiftedValue);
-      shiftedValue = value + vtkMath::Pi();
-      if (shiftedValue > vtkMath::Pi())
-        {
-        shiftedValue -= 2.0 * vtkMath::Pi();
-        }
-      shiftedCircularMapping180Array->SetValue(i,shiftedValue);
-      shiftedValue = value + 1.5 * vtkMath::Pi();
-      if (shiftedValue > vtkMath::Pi())
-        {
-        shiftedValue -= 2.0 * vtkMath::Pi();
-        }
-      shiftedCircularMapping270Array->SetValue(i,shiftedValue);
-      }
-    }
-  else
-    {
-    shiftedCircularMapping90Array->FillComponent(0,0.0);
-    shiftedCircularMapping180Array->FillComponent(0,0.0);
-    shiftedCircularMapping270Array->FillComponent(0,0.0);
-    }
-  
-  input->GetPointData()->AddArray(shiftedCircularMapping90Array);
-  input->GetPointData()->AddArray(shiftedCircularMapping180Array);
-  input->GetPointData()->AddArray(shiftedCircularMapping270Array);
-  
-  if (this->PatchedData)
-    {
-    this->PatchedData->Delete();
-    this->PatchedData = NULL;
-    }
-
-  this->PatchedData = vtkImageData::New();
-
-  vtkPointData* patchedDataPointData = this->PatchedData->GetPointData();
-  patchedDataPointData->CopyAllocate(input->GetPointData(),0);
-
-  vtkIntArray* patchedDataLongitudinalPatchNumberArray = vtkIntArray::New();
-  patchedDataLongitudinalPatchNumberArray->SetName(this->LongitudinalPatchNumberArrayName);
-  patchedDataLongitudinalPatchNumberArray->SetNumberOfComponents(1);
-
-  vtkIntArray* patchedDataCircularPatchNumberArray = vtkIntArray::New();
-  patchedDataCircularPatchNumberArray->SetName(this->CircularPatchNumberArrayName);
-  patchedDataCircularPatchNumberArray->SetNumberOfComponents(1);
-
-  vtkDoubleArray* patchedDataPatchAreaArray = vtkDoubleArray::New();
-  patchedDataPatchAreaArray->SetName(this->PatchAreaArrayName);
-  patchedDataPatchAreaArray->SetNumberOfComponents(1);
-
-  vtkAppendPolyData* patchAppendFilter = vtkAppendPolyData::New();
-
-  if (this->CircularPatchBounds[0] == 0.0 && this->CircularPatchBounds[1] == 0.0)
-    {
-    this->CircularPatchBounds[0] = - vtkMath::Pi();
-    this->CircularPatchBounds[1] = vtkMath::Pi();
-    }
- 
-  int circularPatchStartIndex = 0; 
-  int circularPatchEndIndex = 0;
- 
-  if (this->CircularPatching)
-    {
-    circularPatchStartIndex = vtkMath::Floor((this->CircularPatchBounds[0] - this->PatchOffsets[1]) / circumferentialActualPatchSize);
-    if (circularPatchStartIndex*circumferentialActualPatchSize - this->PatchOffsets[1] < - vtkMath::Pi())
-      {
-      circularPatchStartIndex += 1;
-      }
-    circularPatchEndIndex = vtkMath::Floor((this->CircularPatchBounds[1] - this->PatchOffsets[1] - 1E-3 * circumferentialActualPatchSize) / circumferentialActualPatchSize);
-    }
-
-  int numberOfPreviousPatchDataLines = 0;
-  vtkIdList* groupIds = vtkIdList::New();
-  vtkvmtkPolyDataBranchUtilities::GetGroupsIdList(input,this->GroupIdsArrayName,groupIds);
-  for (i=0; i<groupIds->GetNumberOfIds(); i++)
-    {
-    vtkIdType groupId = groupIds->GetId(i);
-    vtkPolyData* cylinder = vtkPolyData::New();
-    vtkvmtkPolyDataBranchUtilities::ExtractGroup(input,this->GroupIdsArrayName,groupId,true,cylinder);
-  
-    longitudinalMappingArray = cylinder->GetPointData()->GetArray(this->LongitudinalMappingArrayName);
-    circularMappingArray = cylinder->GetPointData()->GetArray(this->CircularMappingArrayName);
-
-    cylinder->GetPointData()->SetActiveScalars(this->LongitudinalMappingArrayName);
+  struct PatchingParameters
+  {
+    const char* LongitudinalMappingArrayName;
+    const char* CircularMappingArrayName;
+    const char* ShiftedCircularMapping90ArrayName;
+    const char* ShiftedCircularMapping180ArrayName;
+    const char* ShiftedCircularMapping270ArrayName;
+    const char* LongitudinalPatchNumberArrayName;
+    const char* CircularPatchNumberArrayName;
+    const char* PatchAreaArrayName;
+    double PatchSize[2];
+    double PatchOffsets[2];
+    double LongitudinalPatchBounds[2];
+    double CircumferentialActualPatchSize;
+    int CircularPatchStartIndex;
+    int CircularPatchEndIndex;
+    int CircularPatching;
+    int UseConnectivity;
+  };
+
+  // A patch of a group, with its patch number within the group and the
+  // tuples of the patched data, one per cell data array (empty if the array
+  // has no value for the patch).
+  struct GroupPatch
+  {
+    int LocalPatchId;
+    int LongitudinalPatchNumber;
+    int CircularPatchNumber;
+    double Area;
+    vtkSmartPointer<vtkPolyData> Patch;
+    std::vector<std::vector<double> > PatchedDataTuples;
+  };
+
+  struct GroupPatches
+  {
+    int NumberOfPatchDataLines;
+    std::vector<GroupPatch> Patches;
+  };
+
+  // Cut the patches of a single group. Only touches the group surface and
+  // the result, so groups can be processed concurrently.
+  void ComputeGroupPatches(const PatchingParameters& parameters, vtkPolyData* cylinder, GroupPatches& result)
+  {
+    result.Patches.clear();
+
+    vtkDataArray* longitudinalMappingArray = cylinder->GetPointData()->GetArray(parameters.LongitudinalMappingArrayName);
+
+    cylinder->GetPointData()->SetActiveScalars(parameters.LongitudinalMappingArrayName);
 
     vtkClipPolyData* longitudinalClipper0 = vtkClipPolyData::New();
     longitudinalClipper0->SetInputData(cylinder);
@@ -323,25 +129,31 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
 
     double longitudinalCylinderPatchBounds[2];
    
-    if (this->LongitudinalPatchBounds[0] == 0.0 && this->LongitudinalPatchBounds[1] == 0.0)
+    if (parameters.LongitudinalPatchBounds[0] == 0.0 && parameters.LongitudinalPatchBounds[1] == 0.0)
       {
       longitudinalCylinderPatchBounds[0] = longitudinalMappingRange[0];
       longitudinalCylinderPatchBounds[1] = longitudinalMappingRange[1];
       }
     else
       {
-      longitudinalCylinderPatchBounds[0] = this->LongitudinalPatchBounds[0];
-      longitudinalCylinderPatchBounds[1] = this->LongitudinalPatchBounds[1];
+      longitudinalCylinderPatchBounds[0] = parameters.LongitudinalPatchBounds[0];
+      longitudinalCylinderPatchBounds[1] = parameters.LongitudinalPatchBounds[1];
       }
 
-    int longitudinalPatchStartIndex = vtkMath::Floor((longitudinalCylinderPatchBounds[0] - this->PatchOffsets[0]) / this->PatchSize[0]);
-    int longitudinalPatchEndIndex = vtkMath::Floor((longitudinalCylinderPatchBounds[1] - this->PatchOffsets[0] - 1E-3 * this->PatchSize[0]) / this->PatchSize[0]);
+    int circularPatchStartIndex = parameters.CircularPatchStartIndex;
+    int circularPatchEndIndex = parameters.CircularPatchEndIndex;
+    double circumferentialActualPatchSize = parameters.CircumferentialActualPatchSize;
+
+    int longitudinalPatchStartIndex = vtkMath::Floor((longitudinalCylinderPatchBounds[0] - parameters.PatchOffsets[0]) / parameters.PatchSize[0]);
+    int longitudinalPatchEndIndex = vtkMath::Floor((longitudinalCylinderPatchBounds[1] - parameters.PatchOffsets[0] - 1E-3 * parameters.PatchSize[0]) / parameters.PatchSize[0]);
+
+    result.NumberOfPatchDataLines = longitudinalPatchEndIndex - longitudinalPatchStartIndex + 1;
   
     int j, k;
     for (j=longitudinalPatchStartIndex; j<=longitudinalPatchEndIndex; j++)
       {
-      double longitudinalPatchStart = this->PatchOffsets[0] + j * this->PatchSize[0];
-      double longitudinalPatchEnd = this->PatchOffsets[0] + (j+1) * this->PatchSize[0];
+      double longitudinalPatchStart = parameters.PatchOffsets[0] + j * parameters.PatchSize[0];
+      double longitudinalPatchEnd = parameters.PatchOffsets[0] + (j+1) * parameters.PatchSize[0];
 
       longitudinalClipper0->SetValue(longitudinalPatchStart);
       longitudinalClipper1->SetValue(longitudinalPatchEnd);
@@ -354,15 +166,15 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
 
       for (k=circularPatchStartIndex; k<=circularPatchEndIndex; k++)
         {
-        int patchId = k - circularPatchStartIndex + (j - longitudinalPatchStartIndex) * (circularPatchEndIndex-circularPatchStartIndex+1) + numberOfPreviousPatchDataLines * (circularPatchEndIndex-circularPatchStartIndex+1);
+        int localPatchId = k - circularPatchStartIndex + (j - longitudinalPatchStartIndex) * (circularPatchEndIndex-circularPatchStartIndex+1);
         double circularPatchCenter = 0.0;
         double shiftedCircularPatchCenter = 0.0;
-        char* patchShiftedCircularMappingArrayName = NULL;
+        const char* patchShiftedCircularMappingArrayName = NULL;
 
-        if (this->CircularPatching)
+        if (parameters.CircularPatching)
           {
-          double circularPatchStart = this->PatchOffsets[1] + k * circumferentialActualPatchSize;
-          double circularPatchEnd = this->PatchOffsets[1] + (k+1) * circumferentialActualPatchSize;
+          double circularPatchStart = parameters.PatchOffsets[1] + k * circumferentialActualPatchSize;
+          double circularPatchEnd = parameters.PatchOffsets[1] + (k+1) * circumferentialActualPatchSize;
 
           double pi = vtkMath::Pi();
 
@@ -377,7 +189,7 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
 //          if (circularPatchStart < pi && circularPatchEnd > pi)
           if (circularPatchCenter <= - 0.75 * pi || circularPatchCenter >= 0.75 * pi)
             {
-            patchShiftedCircularMappingArrayName = shiftedCircularMapping180ArrayName;
+            patchShiftedCircularMappingArrayName = parameters.ShiftedCircularMapping180ArrayName;
             if (circularPatchCenter <= - 0.75 * pi)
               {
               circularPatchStart += pi;
@@ -392,20 +204,20 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
 //          else if (circularPatchStart < 0.5 * pi && circularPatchEnd > 0.5 * pi)
           else if (circularPatchCenter >= 0.25 * pi && circularPatchCenter < 0.75 * pi)
             {
-            patchShiftedCircularMappingArrayName = shiftedCircularMapping270ArrayName;
+            patchShiftedCircularMappingArrayName = parameters.ShiftedCircularMapping270ArrayName;
             circularPatchStart -= 0.5 * pi;
             circularPatchEnd -= 0.5 * pi;
             }
 //          else if (circularPatchStart < -0.5 * pi && circularPatchEnd > -0.5 * pi)
           else if (circularPatchCenter > -0.75 * pi && circularPatchCenter <= -0.25 * pi)
             {
-            patchShiftedCircularMappingArrayName = shiftedCircularMapping90ArrayName;
+            patchShiftedCircularMappingArrayName = parameters.ShiftedCircularMapping90ArrayName;
             circularPatchStart += 0.5 * pi;
             circularPatchEnd += 0.5 * pi;
             }
           else
             {
-            patchShiftedCircularMappingArrayName = this->CircularMappingArrayName;
+            patchShiftedCircularMappingArrayName = parameters.CircularMappingArrayName;
             }
 
           longitudinalClipper1->GetOutput()->GetPointData()->SetActiveScalars(patchShiftedCircularMappingArrayName);
@@ -425,9 +237,9 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
 
         vtkTriangleFilter* patchTriangleFilter = vtkTriangleFilter::New();
 
-        if (this->UseConnectivity)
+        if (parameters.UseConnectivity)
           {
-          if (this->CircularPatching)
+          if (parameters.CircularPatching)
             {
             patchConnectivityFilter->SetInputConnection(circularClipper1->GetOutputPort());
             }
@@ -440,7 +252,7 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
           }
         else
           {
-          if (this->CircularPatching)
+          if (parameters.CircularPatching)
             {
             patchTriangleFilter->SetInputConnection(circularClipper1->GetOutputPort());
             }
@@ -458,9 +270,9 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
         patch->BuildCells();
         int patchNumberOfCells = patch->GetNumberOfCells();
 
-        if (this->CircularPatching)
+        if (parameters.CircularPatching)
           {
-          vtkDataArray* patchCircularMappingArray = patch->GetPointData()->GetArray(this->CircularMappingArrayName);
+          vtkDataArray* patchCircularMappingArray = patch->GetPointData()->GetArray(parameters.CircularMappingArrayName);
           vtkDataArray* patchShiftedCircularMappingArray = patch->GetPointData()->GetArray(patchShiftedCircularMappingArrayName);
 
           double angularOffset = circularPatchCenter - shiftedCircularPatchCenter;
@@ -476,17 +288,17 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
           }
 
         vtkIntArray* longitudinalPatchNumberArray = vtkIntArray::New();
-        longitudinalPatchNumberArray->SetName(this->LongitudinalPatchNumberArrayName);
+        longitudinalPatchNumberArray->SetName(parameters.LongitudinalPatchNumberArrayName);
         longitudinalPatchNumberArray->SetNumberOfComponents(1);
         longitudinalPatchNumberArray->SetNumberOfTuples(patchNumberOfCells);
 
         vtkIntArray* circularPatchNumberArray = vtkIntArray::New();
-        circularPatchNumberArray->SetName(this->CircularPatchNumberArrayName);
+        circularPatchNumberArray->SetName(parameters.CircularPatchNumberArrayName);
         circularPatchNumberArray->SetNumberOfComponents(1);
         circularPatchNumberArray->SetNumberOfTuples(patchNumberOfCells);
 
         vtkDoubleArray* patchAreaArray = vtkDoubleArray::New();
-        patchAreaArray->SetName(this->PatchAreaArrayName);
+        patchAreaArray->SetName(parameters.PatchAreaArrayName);
         patchAreaArray->SetNumberOfComponents(1);
         patchAreaArray->SetNumberOfTuples(patchNumberOfCells);
 
@@ -530,22 +342,27 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
           patchAreaArray->SetValue(cellId,patchArea);
           }
 
-        patchedDataLongitudinalPatchNumberArray->InsertValue(patchId,j);
-        patchedDataCircularPatchNumberArray->InsertValue(patchId,k);
-        patchedDataPatchAreaArray->InsertValue(patchId,patchArea);
+        result.Patches.push_back(GroupPatch());
+        GroupPatch& groupPatch = result.Patches.back();
+        groupPatch.LocalPatchId = localPatchId;
+        groupPatch.LongitudinalPatchNumber = j;
+        groupPatch.CircularPatchNumber = k;
+        groupPatch.Area = patchArea;
 
         int numberOfArrays = patchCellData->GetNumberOfArrays();
+        groupPatch.PatchedDataTuples.resize(numberOfArrays);
         int arrayId;
         for (arrayId = 0; arrayId<numberOfArrays; arrayId++)
           {
           vtkDataArray* patchArray = patchCellData->GetArray(arrayId);
           vtkDataArray* patchedArray = patchedPatchCellData->GetArray(patchArray->GetName());
-          vtkDataArray* patchedDataArray = patchedDataPointData->GetArray(arrayId);
+          std::vector<double>& patchedDataTuple = groupPatch.PatchedDataTuples[arrayId];
           if (!patchedArray)
             {
             continue;
             }
 
+          int numberOfComponents = patchArray->GetNumberOfComponents();
           int dataType = patchArray->GetDataType();
           if (dataType != VTK_FLOAT && dataType != VTK_DOUBLE)
             {
@@ -555,17 +372,14 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
               }
             if (patchNumberOfCells > 0)
               {
-              patchedDataArray->InsertTuple(patchId,patchArray->GetTuple(0));
+              double* firstTuple = patchArray->GetTuple(0);
+              patchedDataTuple.assign(firstTuple,firstTuple+numberOfComponents);
               }
             continue;
             }
 
-          double* integralTuple = new double[patchArray->GetNumberOfComponents()];
+          patchedDataTuple.assign(numberOfComponents,0.0);
           int componentId;
-          for (componentId = 0; componentId < patchArray->GetNumberOfComponents(); componentId++)
-            {
-            integralTuple[componentId] = 0.0;
-            }
           for (cellId = 0; cellId < patchNumberOfCells; cellId++)
             {
             vtkTriangle* triangle = vtkTriangle::SafeDownCast(patch->GetCell(cellId));
@@ -579,30 +393,26 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
             triangle->GetPoints()->GetPoint(2,point2);
             double area = vtkTriangle::TriangleArea(point0,point1,point2);
 
-            for (componentId = 0; componentId < patchArray->GetNumberOfComponents(); componentId++)
+            for (componentId = 0; componentId < numberOfComponents; componentId++)
               {
-              integralTuple[componentId] += area * patchArray->GetComponent(cellId,componentId);
+              patchedDataTuple[componentId] += area * patchArray->GetComponent(cellId,componentId);
               }
             }
-          for (componentId = 0; componentId < patchArray->GetNumberOfComponents(); componentId++)
+          for (componentId = 0; componentId < numberOfComponents; componentId++)
             {
-            integralTuple[componentId] /= patchArea;
+            patchedDataTuple[componentId] /= patchArea;
             }
           for (cellId = 0; cellId < patchNumberOfCells; cellId++)
             {
-            patchedArray->InsertTuple(cellId,integralTuple);
+            patchedArray->InsertTuple(cellId,&patchedDataTuple[0]);
             }
-
-          patchedDataArray->InsertTuple(patchId,integralTuple);
-
-          delete[] integralTuple;
           }
 
         patch->GetCellData()->AddArray(longitudinalPatchNumberArray);
         patch->GetCellData()->AddArray(circularPatchNumberArray);
         patch->GetCellData()->AddArray(patchAreaArray);
 
-        patchAppendFilter->AddInputData(patch);
+        groupPatch.Patch = patch;
 
         patch->Delete();
         patchTriangleFilter->Delete();
@@ -613,17 +423,352 @@ int vtkvmtkPolyDataPatchingFilter::RequestData(
         }
       }
 
-    cylinder->Delete();
-
     longitudinalClipper0->Delete();
     longitudinalClipper1->Delete();
     circularClipper0->Delete();
     circularClipper1->Delete();
     patchConnectivityFilter->Delete();
+  }
+
+  class GroupPatchesFunctor
+  {
+  public:
+    GroupPatchesFunctor(const PatchingParameters& parameters, const std::vector<vtkSmartPointer<vtkPolyData> >& cylinders, std::vector<GroupPatches>& groupPatches)
+      : Parameters(parameters), Cylinders(cylinders), GroupPatchesList(groupPatches) {}
 
-    numberOfPreviousPatchDataLines += longitudinalPatchEndIndex - longitudinalPatchStartIndex + 1;
+    void operator()(vtkIdType begin, vtkIdType end) const
+    {
+      for (vtkIdType i=begin; i<end; i++)
+        {
+        ComputeGroupPatches(this->Parameters,this->Cylinders[i],this->GroupPatchesList[i]);
+        }
+    }
+
+  private:
+    const PatchingParameters& Parameters;
+    const std::vector<vtkSmartPointer<vtkPolyData> >& Cylinders;
+    std::vector<GroupPatches>& GroupPatchesList;
+  };
+}
+
+vtkvmtkPolyDataPatchingFilter::vtkvmtkPolyDataPatchingFilter() 
+{
+  this->LongitudinalMappingArrayName = NULL;
+  this->CircularMappingArrayName = NULL;
+  this->GroupIdsArrayName = NULL;
+  this->LongitudinalPatchNumberArrayName = NULL;
+  this->CircularPatchNumberArrayName = NULL;
+  this->PatchAreaArrayName = NULL;
+  this->PatchSize[0] = this->PatchSize[1] = 0.0;
+  this->PatchOffsets[0] = this->PatchOffsets[1] = 0.0;
+  this->LongitudinalPatchBounds[0] = this->LongitudinalPatchBounds[1] = 0.0;
+  this->CircularPatchBounds[0] = this->CircularPatchBounds[1] = 0.0; 
+  this->PatchedData = NULL;
+  this->CircularPatching = 1;
+  this->UseConnectivity = 1;
+  this->ParallelGroupProcessing = 1;
+}
+
+vtkvmtkPolyDataPatchingFilter::~vtkvmtkPolyDataPatchingFilter()
+{
+  if (this->LongitudinalMappingArrayName)
+    {
+    delete[] this->LongitudinalMappingArrayName;
+    this->LongitudinalMappingArrayName = NULL;
+    }
+
+  if (this->CircularMappingArrayName)
+    {
+    delete[] this->CircularMappingArrayName;
+    this->CircularMappingArrayName = NULL;
+    }
+
+  if (this->LongitudinalPatchNumberArrayName)
+    {
+    delete[] this->LongitudinalPatchNumberArrayName;
+    this->LongitudinalPatchNumberArrayName = NULL;
+    }
+
+  if (this->CircularPatchNumberArrayName)
+    {
+    delete[] this->CircularPatchNumberArrayName;
+    this->CircularPatchNumberArrayName = NULL;
+    }
+
+  if (this->PatchAreaArrayName)
+    {
+    delete[] this->PatchAreaArrayName;
+    this->PatchAreaArrayName = NULL;
+    }
+
+  if (this->PatchedData)
+    {
+    this->PatchedData->Delete();
+    this->PatchedData = NULL;
+    }
+}
+
+int vtkvmtkPolyDataPatchingFilter::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  vtkPolyData *input = vtkPolyData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkPolyData *output = vtkPolyData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  if (!this->LongitudinalPatchNumberArrayName)
+    {
+    vtkErrorMacro(<<"LongitudinalPatchNumberArrayName not set.");
+    return 1;
+    }
+
+  if (!this->CircularPatchNumberArrayName)
+    {
+    vtkErrorMacro(<<"CircularPatchNumberArrayName not set.");
+    return 1;
+    }
+
+  if (!this->PatchAreaArrayName)
+    {
+    vtkErrorMacro(<<"PatchAreaArrayName not set.");
+    return 1;
+    }
+
+  if (!this->LongitudinalMappingArrayName)
+    {
+    vtkErrorMacro(<<"LongitudinalMappingArrayName not set.");
+    return 1;
+    }
+
+  vtkDataArray* longitudinalMappingArray = input->GetPointData()->GetArray(this->LongitudinalMappingArrayName);
+
+  if (!longitudinalMappingArray)
+    {
+    vtkErrorMacro(<<"LongitudinalMappingArray with name specified does not exist.");
+    return 1;
+    }
+
+  vtkDataArray* circularMappingArray = NULL;
+  if (this->CircularPatching)
+    {
+  
+    if (!this->CircularMappingArrayName)
+      {
+      vtkErrorMacro(<<"CircularMappingArrayName not set.");
+      return 1;
+      }
+
+    circularMappingArray = input->GetPointData()->GetArray(this->CircularMappingArrayName);
+
+    if (!circularMappingArray)
+      {
+      vtkErrorMacro(<<"CircularMappingArray with name specified does not exist.");
+      return 1;
+      }
+    }
+
+  if (!this->GroupIdsArrayName)
+    {
+    vtkErrorMacro(<<"GroupIdsArrayName not set.");
+    return 1;
+    }
+
+  vtkDataArray* groupIdsArray = input->GetPointData()->GetArray(this->GroupIdsArrayName);
+
+  if (!groupIdsArray)
+    {
+    vtkErrorMacro(<<"GroupIdsArray with name specified does not exist.");
+    return 1;
+    }
+
+  int numberOfInputPoints = input->GetNumberOfPoints();
+
+  double circumferentialActualPatchSize = this->PatchSize[1] * 2.0 * vtkMath::Pi();
+ 
+  char shiftedCircularMapping90ArrayName[] = "ShiftedCircularMapping90";
+  char shiftedCircularMapping180ArrayName[] = "ShiftedCircularMapping180";
+  char shiftedCircularMapping270ArrayName[] = "ShiftedCircularMapping270";
+
+  vtkDoubleArray* shiftedCircularMapping90Array = vtkDoubleArray::New();
+  shiftedCircularMapping90Array->SetName(shiftedCircularMapping90ArrayName);
+  shiftedCircularMapping90Array->SetNumberOfComponents(1);
+  shiftedCircularMapping90Array->SetNumberOfTuples(numberOfInputPoints);
+  vtkDoubleArray* shiftedCircularMapping180Array = vtkDoubleArray::New();
+  shiftedCircularMapping180Array->SetName(shiftedCircularMapping180ArrayName);
+  shiftedCircularMapping180Array->SetNumberOfComponents(1);
+  shiftedCircularMapping180Array->SetNumberOfTuples(numberOfInputPoints);
+  vtkDoubleArray* shiftedCircularMapping270Array = vtkDoubleArray::New();
+  shiftedCircularMapping270Array->SetName(shiftedCircularMapping270ArrayName);
+  shiftedCircularMapping270Array->SetNumberOfComponents(1);
+  shiftedCircularMapping270Array->SetNumberOfTuples(numberOfInputPoints);
+
+  int i;
+  if (this->CircularPatching)
+    {
+    for (i=0; i<numberOfInputPoints; i++)
+      {
+      double value = circularMappingArray->GetComponent(i,0);
+      double shiftedValue = value + 0.5 * vtkMath::Pi();
+      if (shiftedValue > vtkMath::Pi())
+        {
+        shiftedValue -= 2.0 * vtkMath::Pi();
+        }
+      shiftedCircularMapping90Array->SetValue(i,shiftedValue);
+      shiftedValue = value + vtkMath::Pi();
+      if (shiftedValue > vtkMath::Pi())
+        {
+        shiftedValue -= 2.0 * vtkMath::Pi();
+        }
+      shiftedCircularMapping180Array->SetValue(i,shiftedValue);
+      shiftedValue = value + 1.5 * vtkMath::Pi();
+      if (shiftedValue > vtkMath::Pi())
+        {
+        shiftedValue -= 2.0 * vtkMath::Pi();
+        }
+      shiftedCircularMapping270Array->SetValue(i,shiftedValue);
+      }
+    }
+  else
+    {
+    shiftedCircularMapping90Array->FillComponent(0,0.0);
+    shiftedCircularMapping180Array->FillComponent(0,0.0);
+    shiftedCircularMapping270Array->FillComponent(0,0.0);
+    }
+  
+  input->GetPointData()->AddArray(shiftedCircularMapping90Array);
+  input->GetPointData()->AddArray(shiftedCircularMapping180Array);
+  input->GetPointData()->AddArray(shiftedCircularMapping270Array);
+  
+  if (this->PatchedData)
+    {
+    this->PatchedData->Delete();
+    this->PatchedData = NULL;
+    }
+
+  this->PatchedData = vtkImageData::New();
+
+  vtkPointData* patchedDataPointData = this->PatchedData->GetPointData();
+  patchedDataPointData->CopyAllocate(input->GetPointData(),0);
+
+  vtkIntArray* patchedDataLongitudinalPatchNumberArray = vtkIntArray::New();
+  patchedDataLongitudinalPatchNumberArray->SetName(this->LongitudinalPatchNumberArrayName);
+  patchedDataLongitudinalPatchNumberArray->SetNumberOfComponents(1);
+
+  vtkIntArray* patchedDataCircularPatchNumberArray = vtkIntArray::New();
+  patchedDataCircularPatchNumberArray->SetName(this->CircularPatchNumberArrayName);
+  patchedDataCircularPatchNumberArray->SetNumberOfComponents(1);
+
+  vtkDoubleArray* patchedDataPatchAreaArray = vtkDoubleArray::New();
+  patchedDataPatchAreaArray->SetName(this->PatchAreaArrayName);
+  patchedDataPatchAreaArray->SetNumberOfComponents(1);
+
+  vtkAppendPolyData* patchAppendFilter = vtkAppendPolyData::New();
+
+  if (this->CircularPatchBounds[0] == 0.0 && this->CircularPatchBounds[1] == 0.0)
+    {
+    this->CircularPatchBounds[0] = - vtkMath::Pi();
+    this->CircularPatchBounds[1] = vtkMath::Pi();
+    }
+ 
+  int circularPatchStartIndex = 0; 
+  int circularPatchEndIndex = 0;
+ 
+  if (this->CircularPatching)
+    {
+    circularPatchStartIndex = vtkMath::Floor((this->CircularPatchBounds[0] - this->PatchOffsets[1]) / circumferentialActualPatchSize);
+    if (circularPatchStartIndex*circumferentialActualPatchSize - this->PatchOffsets[1] < - vtkMath::Pi())
+      {
+      circularPatchStartIndex += 1;
+      }
+    circularPatchEndIndex = vtkMath::Floor((this->CircularPatchBounds[1] - this->PatchOffsets[1] - 1E-3 * circumferentialActualPatchSize) / circumferentialActualPatchSize);
+    }
+
+  vtkIdList* groupIds = vtkIdList::New();
+  vtkvmtkPolyDataBranchUtilities::GetGroupsIdList(input,this->GroupIdsArrayName,groupIds);
+  vtkvmtkPolyDataGroupPartition* groupPartition = vtkvmtkPolyDataGroupPartition::New();
+  groupPartition->SetSurface(input);
+  groupPartition->SetGroupIdsArrayName(this->GroupIdsArrayName);
+  groupPartition->Build();
+
+  // group surfaces are extracted up front, patches are then cut group by
+  // group (concurrently if requested) and assembled in group order
+  vtkIdType numberOfGroups = groupIds->GetNumberOfIds();
+  std::vector<vtkSmartPointer<vtkPolyData> > cylinders(numberOfGroups);
+  for (i=0; i<numberOfGroups; i++)
+    {
+    cylinders[i] = vtkSmartPointer<vtkPolyData>::New();
+    groupPartition->ExtractGroup(groupIds->GetId(i),true,cylinders[i]);
+    }
+
+  groupIds->Delete();
+  groupPartition->Delete();
+
+  PatchingParameters parameters;
+  parameters.LongitudinalMappingArrayName = this->LongitudinalMappingArrayName;
+  parameters.CircularMappingArrayName = this->CircularMappingArrayName;
+  parameters.ShiftedCircularMapping90ArrayName = shiftedCircularMapping90ArrayName;
+  parameters.ShiftedCircularMapping180ArrayName = shiftedCircularMapping180ArrayName;
+  parameters.ShiftedCircularMapping270ArrayName = shiftedCircularMapping270ArrayName;
+  parameters.LongitudinalPatchNumberArrayName = this->LongitudinalPatchNumberArrayName;
+  parameters.CircularPatchNumberArrayName = this->CircularPatchNumberArrayName;
+  parameters.PatchAreaArrayName = this->PatchAreaArrayName;
+  parameters.PatchSize[0] = this->PatchSize[0];
+  parameters.PatchSize[1] = this->PatchSize[1];
+  parameters.PatchOffsets[0] = this->PatchOffsets[0];
+  parameters.PatchOffsets[1] = this->PatchOffsets[1];
+  parameters.LongitudinalPatchBounds[0] = this->LongitudinalPatchBounds[0];
+  parameters.LongitudinalPatchBounds[1] = this->LongitudinalPatchBounds[1];
+  parameters.CircumferentialActualPatchSize = circumferentialActualPatchSize;
+  parameters.CircularPatchStartIndex = circularPatchStartIndex;
+  parameters.CircularPatchEndIndex = circularPatchEndIndex;
+  parameters.CircularPatching = this->CircularPatching;
+  parameters.UseConnectivity = this->UseConnectivity;
+
+  std::vector<GroupPatches> groupPatches(numberOfGroups);
+  GroupPatchesFunctor functor(parameters,cylinders,groupPatches);
+  if (this->ParallelGroupProcessing)
+    {
+    vtkSMPTools::For(0,numberOfGroups,1,functor);
+    }
+  else
+    {
+    functor(0,numberOfGroups);
+    }
+
+  int numberOfPreviousPatchDataLines = 0;
+  int numberOfCircularPatches = circularPatchEndIndex - circularPatchStartIndex + 1;
+  for (i=0; i<numberOfGroups; i++)
+    {
+    for (size_t p=0; p<groupPatches[i].Patches.size(); p++)
+      {
+      const GroupPatch& groupPatch = groupPatches[i].Patches[p];
+      int patchId = groupPatch.LocalPatchId + numberOfPreviousPatchDataLines * numberOfCircularPatches;
+
+      patchedDataLongitudinalPatchNumberArray->InsertValue(patchId,groupPatch.LongitudinalPatchNumber);
+      patchedDataCircularPatchNumberArray->InsertValue(patchId,groupPatch.CircularPatchNumber);
+      patchedDataPatchAreaArray->InsertValue(patchId,groupPatch.Area);
+
+      int numberOfArrays = static_cast<int>(groupPatch.PatchedDataTuples.size());
+      int arrayId;
+      for (arrayId = 0; arrayId<numberOfArrays; arrayId++)
+        {
+        if (groupPatch.PatchedDataTuples[arrayId].empty())
+          {
+          continue;
+          }
+        patchedDataPointData->GetArray(arrayId)->InsertTuple(patchId,&groupPatch.PatchedDataTuples[arrayId][0]);
+        }
+
+      patchAppendFilter->AddInputData(groupPatch.Patch);
+      }
+
+    numberOfPreviousPatchDataLines += groupPatches[i].NumberOfPatchDataLines;
     }
-  groupIds->Delete();
   
   this->PatchedData->SetOrigin(0.0,0.0,0.0);
   this->PatchedData->SetSpacing(circumferentialActualPatchSize,this->PatchSize[0],1.0);
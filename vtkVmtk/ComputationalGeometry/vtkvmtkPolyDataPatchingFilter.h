@@ -79,6 +79,13 @@ public:
   vtkGetMacro(UseConnectivity,int);
   vtkBooleanMacro(UseConnectivity,int);
 
+  // Description:
+  // Cut the patches of different groups concurrently. Patches are assembled
+  // in group order, so the output does not depend on this setting.
+  vtkSetMacro(ParallelGroupProcessing,int);
+  vtkGetMacro(ParallelGroupProcessing,int);
+  vtkBooleanMacro(ParallelGroupProcessing,int);
+
 protected:
   vtkvmtkPolyDataPatchingFilter();
   ~vtkvmtkPolyDataPatchingFilter();
@@ -103,6 +110,7 @@ protected:
 
   int CircularPatching;
   int UseConnectivity;
+  int ParallelGroupProcessing;
 
 private:
   vtkvmtkPolyDataPatchingFilter(const vtkvmtkPolyDataPatchingFilter&);  // Not implemented.
@@ -35,12 +35,16 @@
 #include "vtkvmtkPolyBallLine.h"
 
 #include "vtkvmtkPolyDataBranchUtilities.h"
+#include "vtkvmtkPolyDataGroupPartition.h"
 #include "vtkvmtkCenterlineUtilities.h"
+#include "vtkvmtkCenterlineTopologyIndex.h"
 #include "vtkvmtkReferenceSystemUtilities.h"
 
 
 vtkStandardNewMacro(vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter);
 
+vtkCxxSetObjectMacro(vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter,CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
 vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter() 
 {
   this->BoundaryMetricArrayName = NULL;
@@ -53,6 +57,7 @@ vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::vtkvmtkPolyDataReferenceSyst
   this->CenterlineGroupIdsArrayName = NULL;
   this->CenterlineIdsArrayName = NULL;
   this->CenterlineTractIdsArrayName = NULL;
+  this->CenterlineTopologyIndex = NULL;
 
   this->ReferenceSystems = NULL;
   this->ReferenceSystemGroupIdsArrayName = NULL;
@@ -119,6 +124,12 @@ vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::~vtkvmtkPolyDataReferenceSys
     delete[] this->ReferenceSystemGroupIdsArrayName;
     this->ReferenceSystemGroupIdsArrayName = NULL;
     }
+
+  if (this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex->Delete();
+    this->CenterlineTopologyIndex = NULL;
+    }
 }
 
 int vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::RequestData(
@@ -264,14 +275,29 @@ int vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::RequestData(
 
   // for each group, find boundaries, find centerline group, see if it's adjacent to a bifurcation, get correspondent reference system origin, evaluate mean abscissa and put value on right boundary; if not adjacent to bifucation, just put extremal centerline abscissa.
 
+  if (!this->CenterlineTopologyIndex)
+    {
+    this->CenterlineTopologyIndex = vtkvmtkCenterlineTopologyIndex::New();
+    }
+  this->CenterlineTopologyIndex->SetCenterlines(this->Centerlines);
+  this->CenterlineTopologyIndex->SetGroupIdsArrayName(this->CenterlineGroupIdsArrayName);
+  this->CenterlineTopologyIndex->SetCenterlineIdsArrayName(this->CenterlineIdsArrayName);
+  this->CenterlineTopologyIndex->SetTractIdsArrayName(this->CenterlineTractIdsArrayName);
+  this->CenterlineTopologyIndex->SetBlankingArrayName(NULL);
+
   vtkIdList* groupIds = vtkIdList::New();
   vtkvmtkPolyDataBranchUtilities::GetGroupsIdList(input,this->GroupIdsArrayName,groupIds);
   int i;
+  vtkvmtkPolyDataGroupPartition* groupPartition = vtkvmtkPolyDataGroupPartition::New();
+  groupPartition->SetSurface(input);
+  groupPartition->SetGroupIdsArrayName(this->GroupIdsArrayName);
+  groupPartition->Build();
+
   for (i=0; i<groupIds->GetNumberOfIds(); i++)
     {
     vtkIdType groupId = groupIds->GetId(i);
     vtkPolyData* cylinder = vtkPolyData::New();
-    vtkvmtkPolyDataBranchUtilities::ExtractGroup(input,this->GroupIdsArrayName,groupId,false,cylinder);
+    groupPartition->ExtractGroup(groupId,false,cylinder);
             
     vtkvmtkPolyDataBoundaryExtractor* boundaryExtractor = vtkvmtkPolyDataBoundaryExtractor::New();   
     boundaryExtractor->SetInputData(cylinder);
@@ -286,7 +312,7 @@ int vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::RequestData(
       }
 
     vtkIdList* centerlineGroupCellIds = vtkIdList::New();
-    vtkvmtkCenterlineUtilities::GetGroupCellIds(this->Centerlines,this->CenterlineGroupIdsArrayName,groupId,centerlineGroupCellIds);
+    this->CenterlineTopologyIndex->GetGroupCellIds(groupId,centerlineGroupCellIds);
 
     vtkvmtkPolyBallLine* tube = vtkvmtkPolyBallLine::New();
     tube->SetInput(this->Centerlines);
@@ -332,7 +358,7 @@ int vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::RequestData(
     vtkIdList* upStreamGroupIds = vtkIdList::New();
     vtkIdList* downStreamGroupIds = vtkIdList::New();
     
-    vtkvmtkCenterlineUtilities::FindAdjacentCenterlineGroupIds(this->Centerlines,this->CenterlineGroupIdsArrayName,this->CenterlineIdsArrayName,this->CenterlineTractIdsArrayName,groupId,upStreamGroupIds,downStreamGroupIds);
+    this->CenterlineTopologyIndex->FindAdjacentCenterlineGroupIds(groupId,upStreamGroupIds,downStreamGroupIds);
     
     if ((upStreamGroupIds->GetNumberOfIds() > 1) || (downStreamGroupIds->GetNumberOfIds() > 1))
       {
@@ -390,7 +416,7 @@ int vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::RequestData(
         double weightSum = 0.0;
 
         vtkIdList* centerlineGroupAllCellIds = vtkIdList::New();
-        vtkvmtkCenterlineUtilities::GetGroupUniqueCellIds(this->Centerlines,this->CenterlineGroupIdsArrayName,referenceSystemGroupIds[n],centerlineGroupAllCellIds);
+        this->CenterlineTopologyIndex->GetGroupUniqueCellIds(referenceSystemGroupIds[n],centerlineGroupAllCellIds);
         for (j=0; j<centerlineGroupAllCellIds->GetNumberOfIds(); j++)
           {
           centerlineGroupCellIds->Initialize();
@@ -422,7 +448,7 @@ int vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::RequestData(
           referenceSystemAbscissas[n] = VTK_DOUBLE_MAX;
 
           vtkIdList* centerlineGroupCellIds = vtkIdList::New();
-          vtkvmtkCenterlineUtilities::GetGroupCellIds(this->Centerlines,this->CenterlineGroupIdsArrayName,groupId,centerlineGroupCellIds);
+          this->CenterlineTopologyIndex->GetGroupCellIds(groupId,centerlineGroupCellIds);
           for (j=0; j<centerlineGroupCellIds->GetNumberOfIds(); j++)
             {
             vtkIdType centerlineCellId = centerlineGroupCellIds->GetId(j);
@@ -439,7 +465,7 @@ int vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::RequestData(
           referenceSystemAbscissas[n] = VTK_DOUBLE_MIN;
  
           vtkIdList* centerlineGroupCellIds = vtkIdList::New();
-          vtkvmtkCenterlineUtilities::GetGroupCellIds(this->Centerlines,this->CenterlineGroupIdsArrayName,groupId,centerlineGroupCellIds);
+          this->CenterlineTopologyIndex->GetGroupCellIds(groupId,centerlineGroupCellIds);
           for (j=0; j<centerlineGroupCellIds->GetNumberOfIds(); j++)
             {
             vtkIdType centerlineCellId = centerlineGroupCellIds->GetId(j);
@@ -478,6 +504,7 @@ int vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter::RequestData(
     }
 
   groupIds->Delete();
+  groupPartition->Delete();
   boundaryMetricArray->Delete();
 
   return 1;
@@ -33,6 +33,7 @@
 
 class vtkDataArray;
 class vtkIdList;
+class vtkvmtkCenterlineTopologyIndex;
 
 class VTK_VMTK_COMPUTATIONAL_GEOMETRY_EXPORT vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter : public vtkPolyDataAlgorithm
 {
@@ -70,6 +71,13 @@ public:
   vtkSetStringMacro(ReferenceSystemGroupIdsArrayName);
   vtkGetStringMacro(ReferenceSystemGroupIdsArrayName);
 
+  // Description:
+  // Topology index of the centerlines. If not set, one is created on the
+  // first update and kept; it can be shared among the filters working on the
+  // same split centerlines.
+  virtual void SetCenterlineTopologyIndex(vtkvmtkCenterlineTopologyIndex*);
+  vtkGetObjectMacro(CenterlineTopologyIndex,vtkvmtkCenterlineTopologyIndex);
+
 protected:
   vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter();
   ~vtkvmtkPolyDataReferenceSystemBoundaryMetricFilter();
@@ -86,6 +94,7 @@ protected:
   char* CenterlineGroupIdsArrayName;
   char* CenterlineIdsArrayName;
   char* CenterlineTractIdsArrayName;
+  vtkvmtkCenterlineTopologyIndex* CenterlineTopologyIndex;
 
   vtkPolyData* ReferenceSystems;
   char* ReferenceSystemGroupIdsArrayName;
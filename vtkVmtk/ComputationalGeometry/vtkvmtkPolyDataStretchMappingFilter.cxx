@@ -38,171 +38,58 @@
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
 #include "vtkVersion.h"
+#include "vtkSmartPointer.h"
+#include "vtkSMPTools.h"
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
 
 #include "vtkvmtkPolyDataBranchUtilities.h"
+#include "vtkvmtkPolyDataGroupPartition.h"
 
 
 vtkStandardNewMacro(vtkvmtkPolyDataStretchMappingFilter);
 
-vtkvmtkPolyDataStretchMappingFilter::vtkvmtkPolyDataStretchMappingFilter() 
-{
-  this->StretchedMappingArrayName = NULL;
-
-  this->HarmonicMappingArrayName = NULL;
-  this->GroupIdsArrayName = NULL;
-
-  this->MetricArrayName = NULL;
-  this->BoundaryMetricArrayName = NULL;
-
-  this->UseBoundaryMetric = 0;
-
-  this->MetricBoundsGapFactor = 2.0;
-}
-
-vtkvmtkPolyDataStretchMappingFilter::~vtkvmtkPolyDataStretchMappingFilter()
-{
-  if (this->StretchedMappingArrayName)
-    {
-    delete[] this->StretchedMappingArrayName;
-    this->StretchedMappingArrayName = NULL;
-    }
-
-  if (this->HarmonicMappingArrayName)
-    {
-    delete[] this->HarmonicMappingArrayName;
-    this->HarmonicMappingArrayName = NULL;
-    }
-
-  if (this->GroupIdsArrayName)
-    {
-    delete[] this->GroupIdsArrayName;
-    this->GroupIdsArrayName = NULL;
-    }
-
-  if (this->MetricArrayName)
-    {
-    delete[] this->MetricArrayName;
-    this->MetricArrayName = NULL;
-    }
-
-  if (this->BoundaryMetricArrayName)
-    {
-    delete[] this->BoundaryMetricArrayName;
-    this->BoundaryMetricArrayName = NULL;
-    }
-}
-
-int vtkvmtkPolyDataStretchMappingFilter::RequestData(
-  vtkInformation *vtkNotUsed(request),
-  vtkInformationVector **inputVector,
-  vtkInformationVector *outputVector)
+namespace
 {
-  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
-  vtkInformation *outInfo = outputVector->GetInformationObject(0);
-
-  vtkPolyData *input = vtkPolyData::SafeDownCast(
-    inInfo->Get(vtkDataObject::DATA_OBJECT()));
-  vtkPolyData *output = vtkPolyData::SafeDownCast(
-    outInfo->Get(vtkDataObject::DATA_OBJECT()));
-
-  if (!this->StretchedMappingArrayName)
-    {
-    vtkErrorMacro(<<"StretchedMappingArrayName not set.");
-    return 1;
-    }
-
-  if (!this->HarmonicMappingArrayName)
-    {
-    vtkErrorMacro(<<"HarmonicMappingArrayName not set.");
-    return 1;
-    }
-
-  vtkDataArray* harmonicMappingArray = input->GetPointData()->GetArray(this->HarmonicMappingArrayName);
-
-  if (!harmonicMappingArray)
-    {
-    vtkErrorMacro(<<"HarmonicMappingArrayName with name specified does not exist.");
-    return 1;
-    }
-
-  if (!this->GroupIdsArrayName)
-    {
-    vtkErrorMacro(<<"GroupIdsArrayName not set.");
-    return 1;
-    }
-
-  vtkDataArray* groupIdsArray = input->GetPointData()->GetArray(this->GroupIdsArrayName);
-
-  if (!groupIdsArray)
-    {
-    vtkErrorMacro(<<"GroupIdsArray with name specified does not exist.");
-    return 1;
-    }
-
-  if (!this->MetricArrayName)
-    {
-    vtkErrorMacro(<<"MetricArrayName not set.");
-    return 1;
-    }
-
-  vtkDataArray* metricArray = input->GetPointData()->GetArray(this->MetricArrayName);
-
-  if (!metricArray)
-    {
-    vtkErrorMacro(<<"MetricArrayName with name specified does not exist.");
-    return 1;
-    }
-
-  vtkDataArray* boundaryMetricArray = NULL;
-  if (this->UseBoundaryMetric)
-    {
-    if (!this->BoundaryMetricArrayName)
-      {
-      vtkErrorMacro(<<"BoundaryMetricArrayName not set.");
-      return 1;
-      }
-
-    boundaryMetricArray = input->GetPointData()->GetArray(this->BoundaryMetricArrayName);
-    
-    if (!boundaryMetricArray)
-      {
-      vtkErrorMacro(<<"BoundaryMetricArrayName with name specified does not exist.");
-      return 1;
-      }
-    }
-
-  int numberOfInputPoints = input->GetNumberOfPoints();
-
-  output->DeepCopy(input);
-
-  vtkDoubleArray* stretchedMapping = vtkDoubleArray::New();
-  stretchedMapping->SetName(this->StretchedMappingArrayName);
-  stretchedMapping->SetNumberOfComponents(1);
-  stretchedMapping->SetNumberOfTuples(numberOfInputPoints);
-  
-  output->GetPointData()->AddArray(stretchedMapping);
-
-  vtkIdList* groupIds = vtkIdList::New();
-  vtkvmtkPolyDataBranchUtilities::GetGroupsIdList(input,this->GroupIdsArrayName,groupIds);
- 
-  int i, j, k;
-  for (i=0; i<groupIds->GetNumberOfIds(); i++)
-    {
-    vtkIdType groupId = groupIds->GetId(i);
-    vtkPolyData* cylinder = vtkPolyData::New();
-    vtkvmtkPolyDataBranchUtilities::ExtractGroup(input,this->GroupIdsArrayName,groupId,true,cylinder);
-    cylinder->GetPointData()->SetActiveScalars(this->HarmonicMappingArrayName);
+  struct StretchMappingParameters
+  {
+    const char* HarmonicMappingArrayName;
+    const char* MetricArrayName;
+    const char* BoundaryMetricArrayName;
+    int UseBoundaryMetric;
+    double MetricBoundsGapFactor;
+  };
+
+  enum
+  {
+    GROUP_OK,
+    GROUP_NOT_CYLINDER,
+    GROUP_DEGENERATE
+  };
+
+  // Build the stretch function of a single group from its surface. Only
+  // touches the group surface and the function, so groups can be processed
+  // concurrently.
+  int ComputeGroupStretchFunction(const StretchMappingParameters& parameters, vtkPolyData* cylinder, vtkPiecewiseFunction* stretchFunction)
+  {
+    int j, k;
+
+    cylinder->GetPointData()->SetActiveScalars(parameters.HarmonicMappingArrayName);
 
     // before contouring, extract boundaries and look for boundary values there if UseBoundaryValues is 1
 
-    vtkDataArray* cylinderHarmonicMappingArray = cylinder->GetPointData()->GetArray(this->HarmonicMappingArrayName);
-    vtkDataArray* cylinderMetricArray = cylinder->GetPointData()->GetArray(this->MetricArrayName);
-    vtkDataArray* cylinderBoundaryMetricArray = cylinder->GetPointData()->GetArray(this->BoundaryMetricArrayName);
+    vtkDataArray* cylinderHarmonicMappingArray = cylinder->GetPointData()->GetArray(parameters.HarmonicMappingArrayName);
+    vtkDataArray* cylinderMetricArray = cylinder->GetPointData()->GetArray(parameters.MetricArrayName);
+    vtkDataArray* cylinderBoundaryMetricArray = parameters.BoundaryMetricArrayName ? cylinder->GetPointData()->GetArray(parameters.BoundaryMetricArrayName) : NULL;
 
     double boundaryMappings[2];
     double boundaryMetrics[2];
     double boundaryMetricUsefulBounds[2];
 
+    boundaryMetrics[0] = boundaryMetrics[1] = 0.0;
+
     // extract boundaries and look at values there.
     vtkvmtkPolyDataBoundaryExtractor* boundaryExtractor = vtkvmtkPolyDataBoundaryExtractor::New();    
     boundaryExtractor->SetInputData(cylinder);
@@ -211,8 +98,8 @@ int vtkvmtkPolyDataStretchMappingFilter::RequestData(
     int numberOfBoundaries = boundaryExtractor->GetOutput()->GetNumberOfCells();
     if (numberOfBoundaries != 2)
       {
-      vtkErrorMacro(<<"Branch not topologically a cylinder.");
-      return 1;
+      boundaryExtractor->Delete();
+      return GROUP_NOT_CYLINDER;
       }
 
     double contourMetricBounds[2][2];
@@ -225,13 +112,13 @@ int vtkvmtkPolyDataStretchMappingFilter::RequestData(
       vtkCell* boundary = boundaryExtractor->GetOutput()->GetCell(j);
       if (boundary->GetNumberOfPoints() == 0)
         {
-        vtkErrorMacro(<<"Degenerate branch found.");
-        return 1;
+        boundaryExtractor->Delete();
+        return GROUP_DEGENERATE;
         }
       vtkDataArray* boundaryPointIds = boundaryExtractor->GetOutput()->GetPointData()->GetScalars();
       vtkIdType boundaryPointId = static_cast<int>(boundaryPointIds->GetComponent(boundary->GetPointId(0),0));
       boundaryMappings[j] = cylinderHarmonicMappingArray->GetComponent(boundaryPointId,0);
-      if (UseBoundaryMetric)
+      if (parameters.UseBoundaryMetric)
         {
         boundaryMetrics[j] = cylinderBoundaryMetricArray->GetComponent(boundaryPointId,0);
         }
@@ -272,10 +159,10 @@ int vtkvmtkPolyDataStretchMappingFilter::RequestData(
 //     boundaryMetricUsefulBounds[0] = contourMetricBounds[0][1];
 //     boundaryMetricUsefulBounds[1] = contourMetricBounds[1][0];
 
-    boundaryMetricUsefulBounds[0] = contourMetricBounds[0][0] + this->MetricBoundsGapFactor * (contourMetricBounds[0][1] - contourMetricBounds[0][0]);
-    boundaryMetricUsefulBounds[1] = contourMetricBounds[1][1] - this->MetricBoundsGapFactor * (contourMetricBounds[1][1] - contourMetricBounds[1][0]);
+    boundaryMetricUsefulBounds[0] = contourMetricBounds[0][0] + parameters.MetricBoundsGapFactor * (contourMetricBounds[0][1] - contourMetricBounds[0][0]);
+    boundaryMetricUsefulBounds[1] = contourMetricBounds[1][1] - parameters.MetricBoundsGapFactor * (contourMetricBounds[1][1] - contourMetricBounds[1][0]);
 
-    if (!this->UseBoundaryMetric)
+    if (!parameters.UseBoundaryMetric)
       {
       boundaryMetrics[0] = contourMetricBounds[0][0];
       boundaryMetrics[1] = contourMetricBounds[1][1];
@@ -303,12 +190,9 @@ int vtkvmtkPolyDataStretchMappingFilter::RequestData(
 
     vtkPolyData* contours = contourStripper->GetOutput();
 
-//     vtkCardinalSpline* stretchFunction = vtkCardinalSpline::New();
-    vtkPiecewiseFunction* stretchFunction = vtkPiecewiseFunction::New();
-
     int numberOfComputedContours = contours->GetNumberOfCells();
 
-    vtkDataArray* contourMetricArray = contours->GetPointData()->GetArray(this->MetricArrayName);
+    vtkDataArray* contourMetricArray = contours->GetPointData()->GetArray(parameters.MetricArrayName);
 
     for (j=0; j<numberOfComputedContours; j++)
       {
@@ -381,30 +265,272 @@ int vtkvmtkPolyDataStretchMappingFilter::RequestData(
 //     derivative = (stretchFunction->Evaluate(1.0) - stretchFunction->Evaluate(1.0-interval)) / interval;
 //     stretchFunction->AddPoint(1.0+blendingSkip, stretchFunction->Evaluate(1.0) + derivative * blendingSkip);
 
-    for (j=0; j<numberOfInputPoints; j++)
-      {
-      vtkIdType currentGroupId = static_cast<int>(groupIdsArray->GetComponent(j,0));
+    contourFilter->Delete();
+    contourStripper->Delete();
+
+    return GROUP_OK;
+  }
+
+  class GroupStretchMappingFunctor
+  {
+  public:
+    GroupStretchMappingFunctor(const StretchMappingParameters& parameters, const std::vector<vtkSmartPointer<vtkPolyData> >& cylinders, const std::vector<std::vector<vtkIdType> >& groupPointIds, vtkDataArray* harmonicMappingArray, vtkDoubleArray* stretchedMapping, std::vector<int>& groupErrors, std::atomic<bool>& failed)
+      : Parameters(parameters), Cylinders(cylinders), GroupPointIds(groupPointIds), HarmonicMappingArray(harmonicMappingArray), StretchedMapping(stretchedMapping), GroupErrors(groupErrors), Failed(failed) {}
 
-      if (currentGroupId != groupId)
+    void operator()(vtkIdType begin, vtkIdType end) const
+    {
+      for (vtkIdType i=begin; i<end; i++)
         {
-        continue;
+        // stop mapping groups as soon as one of them has failed
+        if (this->Failed)
+          {
+          return;
+          }
+        vtkPiecewiseFunction* stretchFunction = vtkPiecewiseFunction::New();
+        this->GroupErrors[i] = ComputeGroupStretchFunction(this->Parameters,this->Cylinders[i],stretchFunction);
+        if (this->GroupErrors[i] != GROUP_OK)
+          {
+          this->Failed = true;
+          }
+        else
+          {
+          const std::vector<vtkIdType>& pointIds = this->GroupPointIds[i];
+          for (size_t j=0; j<pointIds.size(); j++)
+            {
+            double harmonicMappingValue = this->HarmonicMappingArray->GetComponent(pointIds[j],0);
+//             double stretchedMappingValue = stretchFunction->Evaluate(harmonicMappingValue);
+            double stretchedMappingValue = stretchFunction->GetValue(harmonicMappingValue);
+            this->StretchedMapping->SetValue(pointIds[j],stretchedMappingValue);
+            }
+          }
+        stretchFunction->Delete();
         }
+    }
 
-      double harmonicMappingValue = harmonicMappingArray->GetComponent(j,0);
+  private:
+    const StretchMappingParameters& Parameters;
+    const std::vector<vtkSmartPointer<vtkPolyData> >& Cylinders;
+    const std::vector<std::vector<vtkIdType> >& GroupPointIds;
+    vtkDataArray* HarmonicMappingArray;
+    vtkDoubleArray* StretchedMapping;
+    std::vector<int>& GroupErrors;
+    std::atomic<bool>& Failed;
+  };
+}
 
-//       double stretchedMappingValue = stretchFunction->Evaluate(harmonicMappingValue);
-      double stretchedMappingValue = stretchFunction->GetValue(harmonicMappingValue);
+vtkvmtkPolyDataStretchMappingFilter::vtkvmtkPolyDataStretchMappingFilter() 
+{
+  this->StretchedMappingArrayName = NULL;
+
+  this->HarmonicMappingArrayName = NULL;
+  this->GroupIdsArrayName = NULL;
+
+  this->MetricArrayName = NULL;
+  this->BoundaryMetricArrayName = NULL;
+
+  this->UseBoundaryMetric = 0;
+
+  this->MetricBoundsGapFactor = 2.0;
+
+  this->ParallelGroupProcessing = 1;
+}
+
+vtkvmtkPolyDataStretchMappingFilter::~vtkvmtkPolyDataStretchMappingFilter()
+{
+  if (this->StretchedMappingArrayName)
+    {
+    delete[] this->StretchedMappingArrayName;
+    this->StretchedMappingArrayName = NULL;
+    }
+
+  if (this->HarmonicMappingArrayName)
+    {
+    delete[] this->HarmonicMappingArrayName;
+    this->HarmonicMappingArrayName = NULL;
+    }
+
+  if (this->GroupIdsArrayName)
+    {
+    delete[] this->GroupIdsArrayName;
+    this->GroupIdsArrayName = NULL;
+    }
+
+  if (this->MetricArrayName)
+    {
+    delete[] this->MetricArrayName;
+    this->MetricArrayName = NULL;
+    }
+
+  if (this->BoundaryMetricArrayName)
+    {
+    delete[] this->BoundaryMetricArrayName;
+    this->BoundaryMetricArrayName = NULL;
+    }
+}
+
+int vtkvmtkPolyDataStretchMappingFilter::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  vtkPolyData *input = vtkPolyData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkPolyData *output = vtkPolyData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  if (!this->StretchedMappingArrayName)
+    {
+    vtkErrorMacro(<<"StretchedMappingArrayName not set.");
+    return 1;
+    }
+
+  if (!this->HarmonicMappingArrayName)
+    {
+    vtkErrorMacro(<<"HarmonicMappingArrayName not set.");
+    return 1;
+    }
+
+  vtkDataArray* harmonicMappingArray = input->GetPointData()->GetArray(this->HarmonicMappingArrayName);
+
+  if (!harmonicMappingArray)
+    {
+    vtkErrorMacro(<<"HarmonicMappingArrayName with name specified does not exist.");
+    return 1;
+    }
+
+  if (!this->GroupIdsArrayName)
+    {
+    vtkErrorMacro(<<"GroupIdsArrayName not set.");
+    return 1;
+    }
+
+  vtkDataArray* groupIdsArray = input->GetPointData()->GetArray(this->GroupIdsArrayName);
 
-      stretchedMapping->SetComponent(j,0,stretchedMappingValue);
+  if (!groupIdsArray)
+    {
+    vtkErrorMacro(<<"GroupIdsArray with name specified does not exist.");
+    return 1;
+    }
+
+  if (!this->MetricArrayName)
+    {
+    vtkErrorMacro(<<"MetricArrayName not set.");
+    return 1;
+    }
+
+  vtkDataArray* metricArray = input->GetPointData()->GetArray(this->MetricArrayName);
+
+  if (!metricArray)
+    {
+    vtkErrorMacro(<<"MetricArrayName with name specified does not exist.");
+    return 1;
+    }
+
+  vtkDataArray* boundaryMetricArray = NULL;
+  if (this->UseBoundaryMetric)
+    {
+    if (!this->BoundaryMetricArrayName)
+      {
+      vtkErrorMacro(<<"BoundaryMetricArrayName not set.");
+      return 1;
       }
 
-    stretchFunction->Delete();
-    contourFilter->Delete();
-    contourStripper->Delete();
-    cylinder->Delete();
+    boundaryMetricArray = input->GetPointData()->GetArray(this->BoundaryMetricArrayName);
+    
+    if (!boundaryMetricArray)
+      {
+      vtkErrorMacro(<<"BoundaryMetricArrayName with name specified does not exist.");
+      return 1;
+      }
+    }
+
+  int numberOfInputPoints = input->GetNumberOfPoints();
+
+  output->DeepCopy(input);
+
+  vtkDoubleArray* stretchedMapping = vtkDoubleArray::New();
+  stretchedMapping->SetName(this->StretchedMappingArrayName);
+  stretchedMapping->SetNumberOfComponents(1);
+  stretchedMapping->SetNumberOfTuples(numberOfInputPoints);
+  
+  output->GetPointData()->AddArray(stretchedMapping);
+
+  vtkIdList* groupIds = vtkIdList::New();
+  vtkvmtkPolyDataBranchUtilities::GetGroupsIdList(input,this->GroupIdsArrayName,groupIds);
+ 
+  int i, j;
+  vtkvmtkPolyDataGroupPartition* groupPartition = vtkvmtkPolyDataGroupPartition::New();
+  groupPartition->SetSurface(input);
+  groupPartition->SetGroupIdsArrayName(this->GroupIdsArrayName);
+  groupPartition->Build();
+
+  // group surfaces and point ids are collected up front, stretch functions
+  // are then computed group by group (concurrently if requested)
+  vtkIdType numberOfGroups = groupIds->GetNumberOfIds();
+  std::vector<vtkSmartPointer<vtkPolyData> > cylinders(numberOfGroups);
+  std::unordered_map<vtkIdType,vtkIdType> groupIndices;
+  for (i=0; i<numberOfGroups; i++)
+    {
+    cylinders[i] = vtkSmartPointer<vtkPolyData>::New();
+    groupPartition->ExtractGroup(groupIds->GetId(i),true,cylinders[i]);
+    groupIndices[groupIds->GetId(i)] = i;
+    }
+
+  std::vector<std::vector<vtkIdType> > groupPointIds(numberOfGroups);
+  for (j=0; j<numberOfInputPoints; j++)
+    {
+    vtkIdType currentGroupId = static_cast<int>(groupIdsArray->GetComponent(j,0));
+    std::unordered_map<vtkIdType,vtkIdType>::const_iterator it = groupIndices.find(currentGroupId);
+    if (it != groupIndices.end())
+      {
+      groupPointIds[it->second].push_back(j);
+      }
+    }
+
+  StretchMappingParameters parameters;
+  parameters.HarmonicMappingArrayName = this->HarmonicMappingArrayName;
+  parameters.MetricArrayName = this->MetricArrayName;
+  parameters.BoundaryMetricArrayName = this->BoundaryMetricArrayName;
+  parameters.UseBoundaryMetric = this->UseBoundaryMetric;
+  parameters.MetricBoundsGapFactor = this->MetricBoundsGapFactor;
+
+  std::vector<int> groupErrors(numberOfGroups,GROUP_OK);
+  std::atomic<bool> failed(false);
+  GroupStretchMappingFunctor functor(parameters,cylinders,groupPointIds,harmonicMappingArray,stretchedMapping,groupErrors,failed);
+  if (this->ParallelGroupProcessing)
+    {
+    vtkSMPTools::For(0,numberOfGroups,1,functor);
+    }
+  else
+    {
+    functor(0,numberOfGroups);
     }
 
   groupIds->Delete();
+  groupPartition->Delete();
+
+  if (failed)
+    {
+    for (i=0; i<numberOfGroups; i++)
+      {
+      if (groupErrors[i] == GROUP_NOT_CYLINDER)
+        {
+        vtkErrorMacro(<<"Branch not topologically a cylinder.");
+        break;
+        }
+      if (groupErrors[i] == GROUP_DEGENERATE)
+        {
+        vtkErrorMacro(<<"Degenerate branch found.");
+        break;
+        }
+      }
+    stretchedMapping->Delete();
+    return 1;
+    }
+
   stretchedMapping->Delete();
 
   return 1;
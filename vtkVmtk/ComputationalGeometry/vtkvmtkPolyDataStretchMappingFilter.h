@@ -57,6 +57,13 @@ public:
   vtkSetMacro(MetricBoundsGapFactor,double);
   vtkGetMacro(MetricBoundsGapFactor,double);
 
+  // Description:
+  // Process different groups concurrently. The output does not depend on
+  // this setting.
+  vtkSetMacro(ParallelGroupProcessing,int);
+  vtkGetMacro(ParallelGroupProcessing,int);
+  vtkBooleanMacro(ParallelGroupProcessing,int);
+
 protected:
   vtkvmtkPolyDataStretchMappingFilter();
   ~vtkvmtkPolyDataStretchMappingFilter();
@@ -75,6 +82,8 @@ protected:
 
   double MetricBoundsGapFactor;
 
+  int ParallelGroupProcessing;
+
 private:
   vtkvmtkPolyDataStretchMappingFilter(const vtkvmtkPolyDataStretchMappingFilter&);  // Not implemented.
   void operator=(const vtkvmtkPolyDataStretchMappingFilter&);  // Not implemented.
@@ -0,0 +1,479 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    $RCSfile: vtkvmtkCompactStencils.cxx,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:46:43 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "vtkvmtkCompactStencils.h"
+#include "vtkvmtkPolyDataUmbrellaStencil.h"
+#include "vtkvmtkPolyDataAreaWeightedUmbrellaStencil.h"
+#include "vtkvmtkPolyDataFELaplaceBeltramiStencil.h"
+#include "vtkvmtkPolyDataFVFELaplaceBeltramiStencil.h"
+#include "vtkvmtkPolyDataGradientStencil.h"
+#include "vtkPolyData.h"
+#include "vtkMath.h"
+#include "vtkObjectFactory.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
+
+#include <algorithm>
+
+
+// Walks the manifold neighborhood of a range of points on a copy of the cell
+// connectivity and of the point to cell links of the surface, in the same
+// order as vtkvmtkPolyDataManifoldNeighborhood and
+// vtkvmtkPolyDataManifoldExtendedNeighborhood. The first pass stores the
+// neighborhood sizes in Offsets, the second one the neighbor ids.
+class vtkvmtkCompactStencils::NeighborhoodsFunctor
+{
+public:
+  NeighborhoodsFunctor(vtkvmtkCompactStencils* stencils, const std::vector<vtkIdType>& cellOffsets, const std::vector<vtkIdType>& cellPointIds, const std::vector<vtkIdType>& linkOffsets, const std::vector<vtkIdType>& linkCellIds, bool extended)
+    : Stencils(stencils), CellOffsets(cellOffsets), CellPointIds(cellPointIds), LinkOffsets(linkOffsets), LinkCellIds(linkCellIds), Extended(extended), Fill(false) {}
+
+  void SetFill(bool fill) { this->Fill = fill; }
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    std::vector<vtkIdType>& neighborIds = this->NeighborIds.Local();
+    std::vector<vtkIdType>& extendedNeighborIds = this->ExtendedNeighborIds.Local();
+    for (vtkIdType pointId=begin; pointId<end; pointId++)
+      {
+      bool isBoundary = this->BuildNeighborhood(pointId,neighborIds);
+      if (this->Extended && !isBoundary)
+        {
+        this->ExtendNeighborhood(pointId,neighborIds,extendedNeighborIds);
+        neighborIds.swap(extendedNeighborIds);
+        }
+      vtkIdType numberOfNeighbors = static_cast<vtkIdType>(neighborIds.size());
+      if (!this->Fill)
+        {
+        this->Stencils->Offsets[pointId+1] = numberOfNeighbors;
+        this->Stencils->IsBoundary[pointId] = isBoundary ? 1 : 0;
+        }
+      else if (numberOfNeighbors > 0)
+        {
+        std::copy(neighborIds.begin(),neighborIds.end(),this->Stencils->PointIds.begin()+this->Stencils->Offsets[pointId]);
+        }
+      }
+  }
+
+private:
+  // cells other than cellId sharing the edge (p1,p2), in the order of the
+  // links of p1; returns their number and stores the first two
+  vtkIdType GetCellEdgeNeighbors(vtkIdType cellId, vtkIdType p1, vtkIdType p2, vtkIdType neighborCellIds[2]) const
+  {
+    vtkIdType numberOfNeighbors = 0;
+    for (vtkIdType l=this->LinkOffsets[p1]; l<this->LinkOffsets[p1+1]; l++)
+      {
+      vtkIdType neighborCellId = this->LinkCellIds[l];
+      if (neighborCellId == cellId)
+        {
+        continue;
+        }
+      for (vtkIdType k=this->CellOffsets[neighborCellId]; k<this->CellOffsets[neighborCellId+1]; k++)
+        {
+        if (this->CellPointIds[k] == p2)
+          {
+          if (numberOfNeighbors < 2)
+            {
+            neighborCellIds[numberOfNeighbors] = neighborCellId;
+            }
+          numberOfNeighbors++;
+          break;
+          }
+        }
+      }
+    return numberOfNeighbors;
+  }
+
+  // point of a triangle other than p and p2
+  vtkIdType GetOppositePointId(vtkIdType cellId, vtkIdType p, vtkIdType p2) const
+  {
+    vtkIdType p1 = -1;
+    vtkIdType numberOfCellPoints = std::min<vtkIdType>(3,this->CellOffsets[cellId+1]-this->CellOffsets[cellId]);
+    for (vtkIdType i=0; i<numberOfCellPoints; i++)
+      {
+      if ((p1 = this->CellPointIds[this->CellOffsets[cellId]+i]) != p && p1 != p2)
+        {
+        break;
+        }
+      }
+    return p1;
+  }
+
+  bool BuildNeighborhood(vtkIdType pointId, std::vector<vtkIdType>& neighborIds) const
+  {
+    neighborIds.clear();
+
+    vtkIdType numberOfPointCells = this->LinkOffsets[pointId+1] - this->LinkOffsets[pointId];
+    if (numberOfPointCells < 1)
+      {
+      return false;
+      }
+
+    vtkIdType firstCellId = this->LinkCellIds[this->LinkOffsets[pointId]];
+    vtkIdType k = this->CellOffsets[firstCellId];
+    vtkIdType p2 = this->CellPointIds[k++];
+    while (pointId == p2 && k < this->CellOffsets[firstCellId+1])
+      {
+      p2 = this->CellPointIds[k++];
+      }
+
+    vtkIdType neighborCellIds[2];
+    vtkIdType numberOfNeighbors = this->GetCellEdgeNeighbors(-1,pointId,p2,neighborCellIds);
+
+    vtkIdType nextCell = neighborCellIds[0];
+    vtkIdType bp1 = p2;
+    vtkIdType bp2 = -1;
+    vtkIdType startCell = numberOfNeighbors == 1 ? -1 : neighborCellIds[1];
+
+    neighborIds.push_back(p2);
+
+    // walk around the point counter-clockwise
+    vtkIdType j;
+    for (j=0; j<numberOfPointCells; j++)
+      {
+      p2 = this->GetOppositePointId(nextCell,pointId,p2);
+      neighborIds.push_back(p2);
+      if (this->GetCellEdgeNeighbors(nextCell,pointId,p2,neighborCellIds) != 1)
+        {
+        bp2 = p2;
+        j++;
+        break;
+        }
+      nextCell = neighborCellIds[0];
+      }
+
+    // walk the other way if a boundary cell was not visited
+    nextCell = startCell;
+    p2 = bp1;
+    for (; j<numberOfPointCells && startCell!=-1; j++)
+      {
+      p2 = this->GetOppositePointId(nextCell,pointId,p2);
+      neighborIds.push_back(p2);
+      if (this->GetCellEdgeNeighbors(nextCell,pointId,p2,neighborCellIds) != 1)
+        {
+        break;
+        }
+      nextCell = neighborCellIds[0];
+      }
+
+    if (bp2 != -1)
+      {
+      std::vector<vtkIdType>::iterator boundaryId = std::find(neighborIds.begin(),neighborIds.end(),bp2);
+      std::reverse(neighborIds.begin(),boundaryId+1);
+      return true;
+      }
+
+    // the last id is a duplicate of the first
+    neighborIds.pop_back();
+    return false;
+  }
+
+  void ExtendNeighborhood(vtkIdType pointId, const std::vector<vtkIdType>& neighborIds, std::vector<vtkIdType>& extendedNeighborIds) const
+  {
+    extendedNeighborIds = neighborIds;
+
+    vtkIdType numberOfNeighbors = static_cast<vtkIdType>(neighborIds.size());
+    if (numberOfNeighbors != 3 && numberOfNeighbors != 4)
+      {
+      return;
+      }
+
+    extendedNeighborIds.clear();
+
+    vtkPolyData* pdata = this->Stencils->DataSet;
+    double outerPoint[3], point1[3], point2[3];
+    double edgeVector[3], outerVector1[3], outerVector2[3];
+    vtkIdType neighborCellIds[2];
+    for (vtkIdType i=0; i<numberOfNeighbors; i++)
+      {
+      vtkIdType p1 = neighborIds[i];
+      vtkIdType p2 = neighborIds[(i+1)%numberOfNeighbors];
+      extendedNeighborIds.push_back(p1);
+      if (this->GetCellEdgeNeighbors(-1,p1,p2,neighborCellIds) < 2)
+        {
+        continue;
+        }
+      vtkIdType outerP = -1;
+      for (int j=0; j<2 && outerP==-1; j++)
+        {
+        vtkIdType cellId = neighborCellIds[j];
+        vtkIdType numberOfCellPoints = std::min<vtkIdType>(3,this->CellOffsets[cellId+1]-this->CellOffsets[cellId]);
+        for (vtkIdType k=0; k<numberOfCellPoints; k++)
+          {
+          vtkIdType p = this->CellPointIds[this->CellOffsets[cellId]+k];
+          if (p!=pointId && p!=p1 && p!=p2)
+            {
+            outerP = p;
+            break;
+            }
+          }
+        }
+      if (outerP == -1)
+        {
+        continue;
+        }
+
+      pdata->GetPoint(p1,point1);
+      pdata->GetPoint(p2,point2);
+      pdata->GetPoint(outerP,outerPoint);
+      edgeVector[0] = point1[0] - point2[0];
+      edgeVector[1] = point1[1] - point2[1];
+      edgeVector[2] = point1[2] - point2[2];
+      outerVector1[0] = outerPoint[0] - point1[0];
+      outerVector1[1] = outerPoint[1] - point1[1];
+      outerVector1[2] = outerPoint[2] - point1[2];
+      outerVector2[0] = outerPoint[0] - point2[0];
+      outerVector2[1] = outerPoint[1] - point2[1];
+      outerVector2[2] = outerPoint[2] - point2[2];
+
+      if (vtkMath::Dot(edgeVector,outerVector1)*vtkMath::Dot(edgeVector,outerVector2) < 0.0)
+        {
+        extendedNeighborIds.push_back(outerP);
+        }
+      }
+  }
+
+  vtkvmtkCompactStencils* Stencils;
+  const std::vector<vtkIdType>& CellOffsets;
+  const std::vector<vtkIdType>& CellPointIds;
+  const std::vector<vtkIdType>& LinkOffsets;
+  const std::vector<vtkIdType>& LinkCellIds;
+  bool Extended;
+  bool Fill;
+  mutable vtkSMPThreadLocal<std::vector<vtkIdType> > NeighborIds;
+  mutable vtkSMPThreadLocal<std::vector<vtkIdType> > ExtendedNeighborIds;
+};
+
+// Computes the weights of a range of stencils with the BuildWeights method of
+// the stencil class.
+class vtkvmtkCompactStencils::WeightsFunctor
+{
+public:
+  typedef double (*BuildWeightsFunction)(vtkPolyData*, vtkIdType, vtkIdType, const vtkIdType*, bool, int, int, double*, double*);
+
+  WeightsFunctor(vtkvmtkCompactStencils* stencils, BuildWeightsFunction buildWeights)
+    : Stencils(stencils), BuildWeights(buildWeights) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkvmtkCompactStencils* stencils = this->Stencils;
+    vtkIdType numberOfComponents = stencils->NumberOfComponents;
+    for (vtkIdType pointId=begin; pointId<end; pointId++)
+      {
+      vtkIdType offset = stencils->Offsets[pointId];
+      this->BuildWeights(stencils->DataSet,pointId,stencils->Offsets[pointId+1]-offset,stencils->PointIds.data()+offset,stencils->IsBoundary[pointId]!=0,stencils->WeightScaling,stencils->NegateWeights,stencils->Weights.data()+numberOfComponents*offset,stencils->CenterWeights.data()+numberOfComponents*pointId);
+      }
+  }
+
+private:
+  vtkvmtkCompactStencils* Stencils;
+  BuildWeightsFunction BuildWeights;
+};
+
+
+vtkStandardNewMacro(vtkvmtkCompactStencils);
+
+vtkCxxSetObjectMacro(vtkvmtkCompactStencils,DataSet,vtkPolyData);
+
+vtkvmtkCompactStencils::vtkvmtkCompactStencils()
+{
+  this->DataSet = NULL;
+  this->StencilType = VTK_VMTK_UMBRELLA_STENCIL;
+  this->WeightScaling = 1;
+  this->NegateWeights = 1;
+  this->ParallelBuild = 1;
+  this->NumberOfComponents = 1;
+}
+
+vtkvmtkCompactStencils::~vtkvmtkCompactStencils()
+{
+  if (this->DataSet)
+    {
+    this->DataSet->Delete();
+    this->DataSet = NULL;
+    }
+}
+
+void vtkvmtkCompactStencils::Build()
+{
+  this->BuildNeighborhoods();
+  this->BuildWeights();
+}
+
+void vtkvmtkCompactStencils::BuildNeighborhoods()
+{
+  this->Offsets.assign(1,0);
+  this->PointIds.clear();
+  this->IsBoundary.clear();
+  this->Weights.clear();
+  this->CenterWeights.clear();
+
+  if (!this->DataSet)
+    {
+    vtkErrorMacro(<<"No DataSet specified.");
+    return;
+    }
+
+  vtkIdType numberOfPoints = this->DataSet->GetNumberOfPoints();
+  this->Offsets.assign(numberOfPoints+1,0);
+  this->IsBoundary.assign(numberOfPoints,0);
+
+  if (this->StencilType == VTK_VMTK_EMPTY_STENCIL)
+    {
+    return;
+    }
+
+  bool extended = this->GetUsesExtendedNeighborhoods();
+
+  // copy the connectivity and build the point to cell links, in cell order
+  // as vtkPolyData::BuildLinks does
+  vtkIdType numberOfCells = this->DataSet->GetNumberOfCells();
+  std::vector<vtkIdType> cellOffsets(numberOfCells+1,0);
+  std::vector<vtkIdType> cellPointIds;
+  std::vector<vtkIdType> linkOffsets(numberOfPoints+1,0);
+  cellPointIds.reserve(3*numberOfCells);
+
+  vtkIdType npts;
+  const vtkIdType *pts;
+  vtkIdType cellId, k;
+  for (cellId=0; cellId<numberOfCells; cellId++)
+    {
+    this->DataSet->GetCellPoints(cellId,npts,pts);
+    cellPointIds.insert(cellPointIds.end(),pts,pts+npts);
+    cellOffsets[cellId+1] = cellOffsets[cellId] + npts;
+    for (k=0; k<npts; k++)
+      {
+      linkOffsets[pts[k]+1]++;
+      }
+    }
+
+  vtkIdType pointId;
+  for (pointId=0; pointId<numberOfPoints; pointId++)
+    {
+    linkOffsets[pointId+1] += linkOffsets[pointId];
+    }
+
+  std::vector<vtkIdType> linkCellIds(linkOffsets[numberOfPoints]);
+  std::vector<vtkIdType> fill(linkOffsets.begin(),linkOffsets.end()-1);
+  for (cellId=0; cellId<numberOfCells; cellId++)
+    {
+    for (k=cellOffsets[cellId]; k<cellOffsets[cellId+1]; k++)
+      {
+      linkCellIds[fill[cellPointIds[k]]++] = cellId;
+      }
+    }
+
+  NeighborhoodsFunctor functor(this,cellOffsets,cellPointIds,linkOffsets,linkCellIds,extended);
+  if (this->ParallelBuild)
+    {
+    vtkSMPTools::For(0,numberOfPoints,functor);
+    }
+  else
+    {
+    functor(0,numberOfPoints);
+    }
+
+  for (pointId=0; pointId<numberOfPoints; pointId++)
+    {
+    this->Offsets[pointId+1] += this->Offsets[pointId];
+    }
+  this->PointIds.resize(this->Offsets[numberOfPoints]);
+
+  functor.SetFill(true);
+  if (this->ParallelBuild)
+    {
+    vtkSMPTools::For(0,numberOfPoints,functor);
+    }
+  else
+    {
+    functor(0,numberOfPoints);
+    }
+}
+
+void vtkvmtkCompactStencils::BuildWeights()
+{
+  if (!this->DataSet)
+    {
+    vtkErrorMacro(<<"No DataSet specified.");
+    return;
+    }
+
+  vtkIdType numberOfStencils = this->GetNumberOfStencils();
+  if (numberOfStencils != this->DataSet->GetNumberOfPoints())
+    {
+    vtkErrorMacro(<<"Neighborhoods not built or DataSet changed, call BuildNeighborhoods first.");
+    return;
+    }
+
+  WeightsFunctor::BuildWeightsFunction buildWeights = NULL;
+  switch (this->StencilType)
+    {
+    case VTK_VMTK_EMPTY_STENCIL:
+      break;
+    case VTK_VMTK_UMBRELLA_STENCIL:
+      buildWeights = vtkvmtkPolyDataUmbrellaStencil::BuildWeights;
+      break;
+    case VTK_VMTK_AREA_WEIGHTED_UMBRELLA_STENCIL:
+      buildWeights = vtkvmtkPolyDataAreaWeightedUmbrellaStencil::BuildWeights;
+      break;
+    case VTK_VMTK_FE_LAPLACE_BELTRAMI_STENCIL:
+      buildWeights = vtkvmtkPolyDataFELaplaceBeltramiStencil::BuildWeights;
+      break;
+    case VTK_VMTK_FVFE_LAPLACE_BELTRAMI_STENCIL:
+      buildWeights = vtkvmtkPolyDataFVFELaplaceBeltramiStencil::BuildWeights;
+      break;
+    case VTK_VMTK_GRADIENT_STENCIL:
+      buildWeights = vtkvmtkPolyDataGradientStencil::BuildWeights;
+      break;
+    default:
+      vtkErrorMacro(<<"Invalid stencil type");
+      return;
+    }
+
+  this->NumberOfComponents = this->StencilType == VTK_VMTK_GRADIENT_STENCIL ? 3 : 1;
+  this->Weights.assign(this->NumberOfComponents*this->PointIds.size(),0.0);
+  this->CenterWeights.assign(this->NumberOfComponents*numberOfStencils,0.0);
+
+  if (!buildWeights)
+    {
+    return;
+    }
+
+  WeightsFunctor functor(this,buildWeights);
+  if (this->ParallelBuild)
+    {
+    vtkSMPTools::For(0,numberOfStencils,functor);
+    }
+  else
+    {
+    functor(0,numberOfStencils);
+    }
+}
+
+void vtkvmtkCompactStencils::PrintSelf(std::ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "DataSet: " << this->DataSet << endl;
+  os << indent << "StencilType: " << this->StencilType << endl;
+  os << indent << "WeightScaling: " << this->WeightScaling << endl;
+  os << indent << "NegateWeights: " << this->NegateWeights << endl;
+  os << indent << "ParallelBuild: " << this->ParallelBuild << endl;
+  os << indent << "Number of stencils: " << this->GetNumberOfStencils() << endl;
+}
@@ -0,0 +1,161 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    $RCSfile: vtkvmtkCompactStencils.h,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:46:43 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// .NAME vtkvmtkCompactStencils - Stencils of all the points of a surface stored in flat arrays.
+// .SECTION Description
+// vtkvmtkCompactStencils holds the same stencils as vtkvmtkStencils, with the
+// same neighbor ordering and weights, but in compressed row form: the
+// neighbor ids and weights of all the stencils are stored contiguously and
+// indexed by per point offsets, and no stencil instance is allocated. The
+// weights are computed by the BuildWeights methods of the stencil classes.
+//
+// BuildNeighborhoods builds the manifold (or extended manifold) neighborhood
+// of every point and BuildWeights computes the weights on the current point
+// coordinates, so when the points of a surface move and its connectivity
+// does not, as in vtkvmtkPolyDataStencilFlowFilter, only the weights need to
+// be recomputed for 1-ring stencils; extended neighborhoods depend on the
+// point coordinates and must be rebuilt too. With ParallelBuild on both
+// steps run concurrently over the points.
+//
+// .SECTION See Also
+// vtkvmtkStencils vtkvmtkPolyDataManifoldNeighborhood
+
+#ifndef __vtkvmtkCompactStencils_h
+#define __vtkvmtkCompactStencils_h
+
+#include "vtkObject.h"
+#include "vtkvmtkConstants.h"
+#include "vtkvmtkWin32Header.h"
+
+#include <vector>
+
+class vtkPolyData;
+
+class VTK_VMTK_DIFFERENTIAL_GEOMETRY_EXPORT vtkvmtkCompactStencils : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkvmtkCompactStencils,vtkObject);
+  void PrintSelf(std::ostream& os, vtkIndent indent) override;
+
+  static vtkvmtkCompactStencils* New();
+
+  virtual void SetDataSet(vtkPolyData*);
+  vtkGetObjectMacro(DataSet,vtkPolyData);
+
+  vtkSetMacro(StencilType,int);
+  vtkGetMacro(StencilType,int);
+  void SetStencilTypeToEmptyStencil()
+    {this->SetStencilType(VTK_VMTK_EMPTY_STENCIL);};
+  void SetStencilTypeToUmbrellaStencil()
+    {this->SetStencilType(VTK_VMTK_UMBRELLA_STENCIL);};
+  void SetStencilTypeToAreaWeightedUmbrellaStencil()
+    {this->SetStencilType(VTK_VMTK_AREA_WEIGHTED_UMBRELLA_STENCIL);};
+  void SetStencilTypeToFELaplaceBeltramiStencil()
+    {this->SetStencilType(VTK_VMTK_FE_LAPLACE_BELTRAMI_STENCIL);};
+  void SetStencilTypeToFVFELaplaceBeltramiStencil()
+    {this->SetStencilType(VTK_VMTK_FVFE_LAPLACE_BELTRAMI_STENCIL);};
+  void SetStencilTypeToGradientStencil()
+    {this->SetStencilType(VTK_VMTK_GRADIENT_STENCIL);};
+
+  vtkSetMacro(WeightScaling,int);
+  vtkGetMacro(WeightScaling,int);
+  vtkBooleanMacro(WeightScaling,int);
+
+  vtkSetMacro(NegateWeights,int);
+  vtkGetMacro(NegateWeights,int);
+  vtkBooleanMacro(NegateWeights,int);
+
+  vtkSetMacro(ParallelBuild,int);
+  vtkGetMacro(ParallelBuild,int);
+  vtkBooleanMacro(ParallelBuild,int);
+
+  // Description:
+  // Build the neighborhoods and the weights of the stencils.
+  void Build();
+
+  // Description:
+  // Build the neighborhoods of the stencils. The extended manifold
+  // neighborhood used by the Laplace-Beltrami and gradient stencils depends
+  // on the point coordinates, as it does for vtkvmtkStencils.
+  void BuildNeighborhoods();
+
+  // Description:
+  // Compute the weights of the stencils on the current point coordinates,
+  // keeping the neighborhoods of the last BuildNeighborhoods.
+  void BuildWeights();
+
+  // Description:
+  // Whether the stencil type uses the extended manifold neighborhood, which
+  // has to be rebuilt when the point coordinates change.
+  bool GetUsesExtendedNeighborhoods() const
+    { return this->StencilType == VTK_VMTK_FE_LAPLACE_BELTRAMI_STENCIL || this->StencilType == VTK_VMTK_FVFE_LAPLACE_BELTRAMI_STENCIL || this->StencilType == VTK_VMTK_GRADIENT_STENCIL; }
+
+  vtkIdType GetNumberOfStencils() { return static_cast<vtkIdType>(this->IsBoundary.size()); }
+
+  // Description:
+  // Number of weight components, 3 for the gradient stencil and 1 otherwise.
+  vtkGetMacro(NumberOfComponents,vtkIdType);
+
+  vtkIdType GetNumberOfPoints(vtkIdType stencilId) { return this->Offsets[stencilId+1] - this->Offsets[stencilId]; }
+  vtkIdType GetPointId(vtkIdType stencilId, vtkIdType i) { return this->PointIds[this->Offsets[stencilId]+i]; }
+  bool GetIsBoundary(vtkIdType stencilId) { return this->IsBoundary[stencilId] != 0; }
+
+  double GetWeight(vtkIdType stencilId, vtkIdType i) { return this->Weights[this->NumberOfComponents*(this->Offsets[stencilId]+i)]; }
+  double GetWeight(vtkIdType stencilId, vtkIdType i, vtkIdType component) { return this->Weights[this->NumberOfComponents*(this->Offsets[stencilId]+i)+component]; }
+
+  double GetCenterWeight(vtkIdType stencilId) { return this->CenterWeights[this->NumberOfComponents*stencilId]; }
+  double GetCenterWeight(vtkIdType stencilId, vtkIdType component) { return this->CenterWeights[this->NumberOfComponents*stencilId+component]; }
+
+  // Description:
+  // Direct access to the neighbor ids and weights of a stencil, stored as
+  // GetNumberOfPoints(stencilId) ids and as many weight tuples.
+  const vtkIdType* GetPointIds(vtkIdType stencilId) { return this->PointIds.data() + this->Offsets[stencilId]; }
+  const double* GetWeights(vtkIdType stencilId) { return this->Weights.data() + this->NumberOfComponents*this->Offsets[stencilId]; }
+  const double* GetCenterWeights(vtkIdType stencilId) { return this->CenterWeights.data() + this->NumberOfComponents*stencilId; }
+
+protected:
+  vtkvmtkCompactStencils();
+  ~vtkvmtkCompactStencils();
+
+//BTX
+  class NeighborhoodsFunctor;
+  class WeightsFunctor;
+//ETX
+
+  vtkPolyData* DataSet;
+  int StencilType;
+  int WeightScaling;
+  int NegateWeights;
+  int ParallelBuild;
+  vtkIdType NumberOfComponents;
+
+  // point i has neighbors PointIds[Offsets[i]] to PointIds[Offsets[i+1]-1]
+  std::vector<vtkIdType> Offsets;
+  std::vector<vtkIdType> PointIds;
+  std::vector<char> IsBoundary;
+  std::vector<double> Weights;
+  std::vector<double> CenterWeights;
+
+private:
+  vtkvmtkCompactStencils(const vtkvmtkCompactStencils&);  // Not implemented.
+  void operator=(const vtkvmtkCompactStencils&);  // Not implemented.
+};
+
+#endif
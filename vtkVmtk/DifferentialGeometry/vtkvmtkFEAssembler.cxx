@@ -22,8 +22,44 @@
 #include "vtkvmtkFEAssembler.h"
 #include "vtkvmtkGaussQuadrature.h"
 #include "vtkvmtkFEShapeFunctions.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
 #include "vtkObjectFactory.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocalObject.h"
+#include "vtkType.h"
 
+#include <vector>
+
+
+// Assembles a range of cells with thread local cell, quadrature and shape
+// function objects.
+class vtkvmtkFEAssembler::AssembleCellsFunctor
+{
+public:
+  AssembleCellsFunctor(vtkvmtkFEAssembler* assembler, const vtkIdType* cellIds)
+    : Assembler(assembler), CellIds(cellIds) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkGenericCell* cell = this->Cells.Local();
+    vtkvmtkGaussQuadrature* gaussQuadrature = this->GaussQuadratures.Local();
+    vtkvmtkFEShapeFunctions* feShapeFunctions = this->ShapeFunctions.Local();
+    gaussQuadrature->SetOrder(this->Assembler->QuadratureOrder);
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Assembler->DataSet->GetCell(this->CellIds[i],cell);
+      this->Assembler->AssembleCell(cell,gaussQuadrature,feShapeFunctions);
+      }
+  }
+
+private:
+  vtkvmtkFEAssembler* Assembler;
+  const vtkIdType* CellIds;
+  mutable vtkSMPThreadLocalObject<vtkGenericCell> Cells;
+  mutable vtkSMPThreadLocalObject<vtkvmtkGaussQuadrature> GaussQuadratures;
+  mutable vtkSMPThreadLocalObject<vtkvmtkFEShapeFunctions> ShapeFunctions;
+};
 
 
 vtkvmtkFEAssembler::vtkvmtkFEAssembler()
@@ -34,6 +70,7 @@ vtkvmtkFEAssembler::vtkvmtkFEAssembler()
   this->SolutionVector = NULL;
   this->NumberOfVariables = 1;
   this->QuadratureOrder = 1;
+  this->ParallelAssembly = 1;
 }
 
 vtkvmtkFEAssembler::~vtkvmtkFEAssembler()
@@ -73,6 +110,111 @@ void vtkvmtkFEAssembler::Initialize(int numberOfVariables)
   this->SolutionVector->Fill(0.0);
 }
 
+void vtkvmtkFEAssembler::AssembleCells(int dimension)
+{
+  vtkIdType numberOfCells = this->DataSet->GetNumberOfCells();
+  vtkIdType numberOfPoints = this->DataSet->GetNumberOfPoints();
+
+  vtkGenericCell* cell = vtkGenericCell::New();
+  std::vector<vtkIdType> cellIds;
+  vtkIdType k;
+
+  if (!this->ParallelAssembly)
+    {
+    for (k=0; k<numberOfCells; k++)
+      {
+      cell->SetCellType(this->DataSet->GetCellType(k));
+      if (cell->GetCellDimension() == dimension)
+        {
+        cellIds.push_back(k);
+        }
+      }
+    if (!cellIds.empty())
+      {
+      AssembleCellsFunctor functor(this,&cellIds[0]);
+      functor(0,static_cast<vtkIdType>(cellIds.size()));
+      }
+    cell->Delete();
+    return;
+    }
+
+  // greedy coloring of the cells, the color of a cell being the lowest one
+  // not taken by a cell sharing one of its points; cells for which the 64
+  // colors are all taken are assembled serially at the end
+  const int numberOfColors = 64;
+  std::vector<vtkTypeUInt64> pointColors(numberOfPoints,0);
+  std::vector<int> cellColors(numberOfCells,-1);
+  std::vector<vtkIdType> colorOffsets(numberOfColors+2,0);
+  vtkIdList* cellPointIds = vtkIdList::New();
+  vtkIdType j;
+  for (k=0; k<numberOfCells; k++)
+    {
+    cell->SetCellType(this->DataSet->GetCellType(k));
+    if (cell->GetCellDimension() != dimension)
+      {
+      continue;
+      }
+    this->DataSet->GetCellPoints(k,cellPointIds);
+    vtkIdType numberOfCellPoints = cellPointIds->GetNumberOfIds();
+    vtkTypeUInt64 takenColors = 0;
+    for (j=0; j<numberOfCellPoints; j++)
+      {
+      takenColors |= pointColors[cellPointIds->GetId(j)];
+      }
+    int color = 0;
+    while (color < numberOfColors && (takenColors & (static_cast<vtkTypeUInt64>(1) << color)))
+      {
+      color++;
+      }
+    if (color < numberOfColors)
+      {
+      for (j=0; j<numberOfCellPoints; j++)
+        {
+        pointColors[cellPointIds->GetId(j)] |= static_cast<vtkTypeUInt64>(1) << color;
+        }
+      }
+    cellColors[k] = color;
+    colorOffsets[color+1]++;
+    }
+  cellPointIds->Delete();
+
+  int c;
+  for (c=0; c<numberOfColors+1; c++)
+    {
+    colorOffsets[c+1] += colorOffsets[c];
+    }
+
+  cellIds.resize(colorOffsets[numberOfColors+1]);
+  std::vector<vtkIdType> fill(colorOffsets.begin(),colorOffsets.end()-1);
+  for (k=0; k<numberOfCells; k++)
+    {
+    if (cellColors[k] >= 0)
+      {
+      cellIds[fill[cellColors[k]]++] = k;
+      }
+    }
+
+  if (cellIds.empty())
+    {
+    cell->Delete();
+    return;
+    }
+
+  // cells must be built before querying them from several threads
+  this->DataSet->GetCell(cellIds[0],cell);
+  cell->Delete();
+
+  AssembleCellsFunctor functor(this,&cellIds[0]);
+  for (c=0; c<numberOfColors; c++)
+    {
+    if (colorOffsets[c+1] > colorOffsets[c])
+      {
+      vtkSMPTools::For(colorOffsets[c],colorOffsets[c+1],functor);
+      }
+    }
+  functor(colorOffsets[numberOfColors],colorOffsets[numberOfColors+1]);
+}
+
 void vtkvmtkFEAssembler::DeepCopy(vtkvmtkFEAssembler *src)
 {
   this->DataSet->DeepCopy(src->DataSet);
@@ -81,6 +223,7 @@ void vtkvmtkFEAssembler::DeepCopy(vtkvmtkFEAssembler *src)
   this->SolutionVector->DeepCopy(src->SolutionVector);
   this->NumberOfVariables = src->NumberOfVariables;
   this->QuadratureOrder = src->QuadratureOrder;
+  this->ParallelAssembly = src->ParallelAssembly;
 }
  
 void vtkvmtkFEAssembler::ShallowCopy(vtkvmtkFEAssembler *src)
@@ -95,5 +238,6 @@ void vtkvmtkFEAssembler::ShallowCopy(vtkvmtkFEAssembler *src)
   this->SolutionVector->Register(this);
   this->NumberOfVariables = src->NumberOfVariables;
   this->QuadratureOrder = src->QuadratureOrder;
+  this->ParallelAssembly = src->ParallelAssembly;
 }
 
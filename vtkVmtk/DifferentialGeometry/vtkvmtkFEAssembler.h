@@ -31,6 +31,10 @@
 #include "vtkvmtkDoubleVector.h"
 #include "vtkvmtkWin32Header.h"
 
+class vtkCell;
+class vtkvmtkGaussQuadrature;
+class vtkvmtkFEShapeFunctions;
+
 class VTK_VMTK_DIFFERENTIAL_GEOMETRY_EXPORT vtkvmtkFEAssembler : public vtkObject
 {
 public:
@@ -54,6 +58,14 @@ public:
   vtkSetMacro(QuadratureOrder,int);
   vtkGetMacro(QuadratureOrder,int);
 
+  // Description:
+  // Assemble cells concurrently, in batches of cells sharing no point. The
+  // order in which cell contributions are summed differs from the serial
+  // one, so results can differ by round-off. On by default.
+  vtkSetMacro(ParallelAssembly,int);
+  vtkGetMacro(ParallelAssembly,int);
+  vtkBooleanMacro(ParallelAssembly,int);
+
   virtual void Build() = 0;
 
   void DeepCopy(vtkvmtkFEAssembler *src);
@@ -65,6 +77,18 @@ protected:
 
   void Initialize(int numberOfVariables);
 
+  // Description:
+  // Call AssembleCell on the cells of the given dimension. With
+  // ParallelAssembly on, AssembleCell runs concurrently on cells sharing no
+  // point, so it must only add to the matrix rows and vector entries of the
+  // points of its cell.
+  void AssembleCells(int dimension);
+  virtual void AssembleCell(vtkCell* vtkNotUsed(cell), vtkvmtkGaussQuadrature* vtkNotUsed(gaussQuadrature), vtkvmtkFEShapeFunctions* vtkNotUsed(feShapeFunctions)) {}
+
+//BTX
+  class AssembleCellsFunctor;
+//ETX
+
   vtkDataSet* DataSet;
   vtkvmtkSparseMatrix* Matrix;
   vtkvmtkDoubleVector* RHSVector;
@@ -72,6 +96,7 @@ protected:
 
   int NumberOfVariables;
   int QuadratureOrder;
+  int ParallelAssembly;
 
 private:
   vtkvmtkFEAssembler(const vtkvmtkFEAssembler&);  // Not implemented.
@@ -40,6 +40,7 @@
 #include "vtkQuadraticTetra.h"
 #include "vtkPoints.h"
 #include "vtkMath.h"
+#include "vtkGenericCell.h"
 
 //#define VTKVMTKFESHAPEFUNCTIONS_NEGATIVE_JACOBIAN_WARNING
 
@@ -52,6 +53,9 @@ vtkvmtkFEShapeFunctions::vtkvmtkFEShapeFunctions()
   this->DPhi = vtkDoubleArray::New();
   this->Jacobians = vtkDoubleArray::New();
   this->NumberOfCellPoints = -1;
+
+  this->ReferenceCellType = VTK_EMPTY_CELL;
+  this->ReferenceNumberOfCellPoints = -1;
 }
 
 vtkvmtkFEShapeFunctions::~vtkvmtkFEShapeFunctions()
@@ -68,40 +72,42 @@ void vtkvmtkFEShapeFunctions::Initialize(vtkCell* cell, vtkDoubleArray* pcoords)
   vtkIdType numberOfCellPoints = cell->GetNumberOfPoints();
   this->NumberOfCellPoints = numberOfCellPoints;
 
-  this->Phi->Initialize();
+  this->BuildReferenceTables(cell,pcoords);
+
+  // arrays keep their capacity from cell to cell
+  this->Phi->SetNumberOfComponents(1);
   this->Phi->SetNumberOfTuples(numberOfCellPoints*numberOfPCoords);
 
-  this->DPhi->Initialize();
   this->DPhi->SetNumberOfComponents(3);
   this->DPhi->SetNumberOfTuples(numberOfCellPoints*numberOfPCoords);
 
-  this->Jacobians->Initialize();
+  this->Jacobians->SetNumberOfComponents(1);
   this->Jacobians->SetNumberOfTuples(numberOfPCoords);
 
-  int i;
+  this->CellCoordinates.resize(3*numberOfCellPoints);
+  int i, j, k;
+  for (j=0; j<numberOfCellPoints; j++)
+  {
+    cell->GetPoints()->GetPoint(j,&this->CellCoordinates[3*j]);
+  }
 
-  //Phi
   for (i=0; i<numberOfPCoords; i++)
   {
-    double* sf = new double[numberOfCellPoints];
-    this->GetInterpolationFunctions(cell,pcoords->GetTuple(i),sf);
-    int j;
+    //Phi
     for (j=0; j<numberOfCellPoints; j++)
     {
-      this->Phi->SetValue(i*numberOfCellPoints+j,sf[j]);
+      this->Phi->SetValue(i*numberOfCellPoints+j,this->ReferencePhi[i*numberOfCellPoints+j]);
     }
-    delete[] sf;
 
-    //DPhi
-    double* derivs = new double[cellDimension*numberOfCellPoints];
-    this->GetInterpolationDerivs(cell,pcoords->GetTuple(i),derivs);
+    //DPhi and Jacobians, from a single evaluation of the Jacobian matrix
+    const double* derivs = &this->ReferenceDerivs[i*cellDimension*numberOfCellPoints];
+    double jacobian = 0.0;
     if (cellDimension == 2)
     {
       double inverseJacobianMatrix[2][3];
-      this->ComputeInverseJacobianMatrix2D(cell,pcoords->GetTuple(i),inverseJacobianMatrix);
+      jacobian = ComputeInverseJacobianMatrix2D(&this->CellCoordinates[0],numberOfCellPoints,derivs,inverseJacobianMatrix);
       for (j=0; j<numberOfCellPoints; j++)
       {
-        int k;
         for (k=0; k<3; k++)
         {
           double dphik = derivs[j] * inverseJacobianMatrix[0][k] + derivs[j+numberOfCellPoints] * inverseJacobianMatrix[1][k];
@@ -112,10 +118,9 @@ void vtkvmtkFEShapeFunctions::Initialize(vtkCell* cell, vtkDoubleArray* pcoords)
     else if (cellDimension == 3)
     {
       double inverseJacobianMatrix[3][3];
-      this->ComputeInverseJacobianMatrix3D(cell,pcoords->GetTuple(i),inverseJacobianMatrix);
+      jacobian = ComputeInverseJacobianMatrix3D(&this->CellCoordinates[0],numberOfCellPoints,derivs,inverseJacobianMatrix);
       for (j=0; j<numberOfCellPoints; j++)
       {
-        int k;
         for (k=0; k<3; k++)
         {
           double dphik = derivs[j] * inverseJacobianMatrix[0][k] + derivs[j+numberOfCellPoints] * inverseJacobianMatrix[1][k] + derivs[j+2*numberOfCellPoints] * inverseJacobianMatrix[2][k];
@@ -123,29 +128,65 @@ void vtkvmtkFEShapeFunctions::Initialize(vtkCell* cell, vtkDoubleArray* pcoords)
         }
       }
     }
-    delete[] derivs;
 
-    //Jacobians
-    double jacobian = this->ComputeJacobian(cell,pcoords->GetTuple(i));
     this->Jacobians->SetValue(i,jacobian);
   }
 }
 
-void vtkvmtkFEShapeFunctions::ComputeInverseJacobianMatrix2D(vtkCell* cell, double* pcoords, double inverseJacobianMatrix[2][3])
+void vtkvmtkFEShapeFunctions::BuildReferenceTables(vtkCell* cell, vtkDoubleArray* pcoords)
 {
-  int cellDimension = cell->GetCellDimension();
+  int cellType = cell->GetCellType();
+  vtkIdType cellDimension = cell->GetCellDimension();
+  vtkIdType numberOfPCoords = pcoords->GetNumberOfTuples();
+  int numberOfPCoordsComponents = pcoords->GetNumberOfComponents();
+  vtkIdType numberOfCellPoints = cell->GetNumberOfPoints();
 
-  if (cellDimension != 2)
+  int i, j;
+  bool sameReference = (cellType == this->ReferenceCellType && numberOfCellPoints == this->ReferenceNumberOfCellPoints && static_cast<vtkIdType>(this->ReferencePCoords.size()) == 3*numberOfPCoords);
+  for (i=0; i<numberOfPCoords && sameReference; i++)
+  {
+    for (j=0; j<3; j++)
+    {
+      double pcoord = j < numberOfPCoordsComponents ? pcoords->GetComponent(i,j) : 0.0;
+      if (pcoord != this->ReferencePCoords[3*i+j])
+      {
+        sameReference = false;
+        break;
+      }
+    }
+  }
+
+  if (sameReference)
   {
-    vtkGenericWarningMacro("Error: ComputeInverseJacobian2D only works for 2D cells.");
     return;
   }
 
-  int numberOfCellPoints = cell->GetNumberOfPoints();
-  double* derivs = new double[2*numberOfCellPoints];
+  this->ReferenceCellType = cellType;
+  this->ReferenceNumberOfCellPoints = numberOfCellPoints;
+  this->ReferencePCoords.assign(3*numberOfPCoords,0.0);
+  for (i=0; i<numberOfPCoords; i++)
+  {
+    for (j=0; j<numberOfPCoordsComponents && j<3; j++)
+    {
+      this->ReferencePCoords[3*i+j] = pcoords->GetComponent(i,j);
+    }
+  }
+
+  this->ReferencePhi.assign(numberOfPCoords*numberOfCellPoints,0.0);
+  this->ReferenceDerivs.assign(numberOfPCoords*cellDimension*numberOfCellPoints,0.0);
 
-  vtkvmtkFEShapeFunctions::GetInterpolationDerivs(cell,pcoords,derivs);
+  for (i=0; i<numberOfPCoords; i++)
+  {
+    this->GetInterpolationFunctions(cell,&this->ReferencePCoords[3*i],&this->ReferencePhi[i*numberOfCellPoints]);
+    if (cellDimension > 0)
+    {
+      this->GetInterpolationDerivs(cell,&this->ReferencePCoords[3*i],&this->ReferenceDerivs[i*cellDimension*numberOfCellPoints]);
+    }
+  }
+}
 
+double vtkvmtkFEShapeFunctions::ComputeInverseJacobianMatrix2D(const double* coordinates, vtkIdType numberOfCellPoints, const double* derivs, double inverseJacobianMatrix[2][3])
+{
   int i, j;
 
   double jacobianMatrixTr[2][3];
@@ -154,17 +195,15 @@ void vtkvmtkFEShapeFunctions::ComputeInverseJacobianMatrix2D(vtkCell* cell, doub
     jacobianMatrixTr[0][i] = jacobianMatrixTr[1][i] = 0.0;
   }
 
-  double x[3];
   for (j=0; j<numberOfCellPoints; j++)
   {
-    cell->GetPoints()->GetPoint(j,x);
+    const double* x = coordinates + 3*j;
     for (i=0; i<3; i++)
     {
       jacobianMatrixTr[0][i] += x[i] * derivs[j];
       jacobianMatrixTr[1][i] += x[i] * derivs[numberOfCellPoints+j];
     }
   }
-  delete[] derivs;
 
   double jacobianMatrixSquared[2][2];
   jacobianMatrixSquared[0][0] = vtkMath::Dot(jacobianMatrixTr[0],jacobianMatrixTr[0]);
@@ -196,23 +235,12 @@ void vtkvmtkFEShapeFunctions::ComputeInverseJacobianMatrix2D(vtkCell* cell, doub
   inverseJacobianMatrix[1][0] = inverseJacobianMatrixSquared[1][0] * jacobianMatrixTr[0][0] + inverseJacobianMatrixSquared[1][1] * jacobianMatrixTr[1][0];
   inverseJacobianMatrix[1][1] = inverseJacobianMatrixSquared[1][0] * jacobianMatrixTr[0][1] + inverseJacobianMatrixSquared[1][1] * jacobianMatrixTr[1][1];
   inverseJacobianMatrix[1][2] = inverseJacobianMatrixSquared[1][0] * jacobianMatrixTr[0][2] + inverseJacobianMatrixSquared[1][1] * jacobianMatrixTr[1][2];
+
+  return sqrt(jacobianSquared);
 }
 
-void vtkvmtkFEShapeFunctions::ComputeInverseJacobianMatrix3D(vtkCell* cell, double* pcoords, double inverseJacobianMatrix[3][3])
+double vtkvmtkFEShapeFunctions::ComputeInverseJacobianMatrix3D(const double* coordinates, vtkIdType numberOfCellPoints, const double* derivs, double inverseJacobianMatrix[3][3])
 {
-  int cellDimension = cell->GetCellDimension();
-
-  if (cellDimension != 3)
-  {
-    vtkGenericWarningMacro("Error: ComputeInverseJacobian3D only works for 3D cells.");
-    return;
-  }
-
-  int numberOfCellPoints = cell->GetNumberOfPoints();
-  double* derivs = new double[3*numberOfCellPoints];
-
-  vtkvmtkFEShapeFunctions::GetInterpolationDerivs(cell,pcoords,derivs);
-
   int i, j;
 
   double jacobianMatrix[3][3];
@@ -221,10 +249,9 @@ void vtkvmtkFEShapeFunctions::ComputeInverseJacobianMatrix3D(vtkCell* cell, doub
     jacobianMatrix[0][i] = jacobianMatrix[1][i] = jacobianMatrix[2][i] = 0.0;
   }
 
-  double x[3];
   for (j=0; j<numberOfCellPoints; j++)
   {
-    cell->GetPoints()->GetPoint(j,x);
+    const double* x = coordinates + 3*j;
     for (i=0; i<3; i++)
     {
       jacobianMatrix[0][i] += x[i] * derivs[j];
@@ -232,15 +259,78 @@ void vtkvmtkFEShapeFunctions::ComputeInverseJacobianMatrix3D(vtkCell* cell, doub
       jacobianMatrix[2][i] += x[i] * derivs[2*numberOfCellPoints+j];
     }
   }
-  delete[] derivs;
 
   vtkMath::Invert3x3(jacobianMatrix,inverseJacobianMatrix);
 
   vtkMath::Transpose3x3(inverseJacobianMatrix,inverseJacobianMatrix);
+
+  double jacobian = vtkMath::Determinant3x3(jacobianMatrix);
+
+  if (jacobian < 0.0)
+  {
+#ifdef VTKVMTKFESHAPEFUNCTIONS_NEGATIVE_JACOBIAN_WARNING 
+    vtkGenericWarningMacro("Warning: negative Jacobian, taking absolute value.");
+#endif
+    jacobian = fabs(jacobian);
+  }
+
+  return jacobian;
+}
+
+void vtkvmtkFEShapeFunctions::ComputeInverseJacobianMatrix2D(vtkCell* cell, double* pcoords, double inverseJacobianMatrix[2][3])
+{
+  int cellDimension = cell->GetCellDimension();
+
+  if (cellDimension != 2)
+  {
+    vtkGenericWarningMacro("Error: ComputeInverseJacobian2D only works for 2D cells.");
+    return;
+  }
+
+  int numberOfCellPoints = cell->GetNumberOfPoints();
+  std::vector<double> derivs(2*numberOfCellPoints);
+  std::vector<double> coordinates(3*numberOfCellPoints);
+
+  vtkvmtkFEShapeFunctions::GetInterpolationDerivs(cell,pcoords,&derivs[0]);
+  for (int j=0; j<numberOfCellPoints; j++)
+  {
+    cell->GetPoints()->GetPoint(j,&coordinates[3*j]);
+  }
+
+  ComputeInverseJacobianMatrix2D(&coordinates[0],numberOfCellPoints,&derivs[0],inverseJacobianMatrix);
+}
+
+void vtkvmtkFEShapeFunctions::ComputeInverseJacobianMatrix3D(vtkCell* cell, double* pcoords, double inverseJacobianMatrix[3][3])
+{
+  int cellDimension = cell->GetCellDimension();
+
+  if (cellDimension != 3)
+  {
+    vtkGenericWarningMacro("Error: ComputeInverseJacobian3D only works for 3D cells.");
+    return;
+  }
+
+  int numberOfCellPoints = cell->GetNumberOfPoints();
+  std::vector<double> derivs(3*numberOfCellPoints);
+  std::vector<double> coordinates(3*numberOfCellPoints);
+
+  vtkvmtkFEShapeFunctions::GetInterpolationDerivs(cell,pcoords,&derivs[0]);
+  for (int j=0; j<numberOfCellPoints; j++)
+  {
+    cell->GetPoints()->GetPoint(j,&coordinates[3*j]);
+  }
+
+  ComputeInverseJacobianMatrix3D(&coordinates[0],numberOfCellPoints,&derivs[0],inverseJacobianMatrix);
 }
 
 void vtkvmtkFEShapeFunctions::GetInterpolationFunctions(vtkCell* cell, double* pcoords, double* sf)
 {
+  vtkGenericCell* genericCell = vtkGenericCell::SafeDownCast(cell);
+  if (genericCell)
+  {
+    cell = genericCell->GetRepresentativeCell();
+  }
+
   switch (cell->GetCellType())
   {
     case VTK_QUAD:
@@ -287,6 +377,12 @@ void vtkvmtkFEShapeFunctions::GetInterpolationFunctions(vtkCell* cell, double* p
 
 void vtkvmtkFEShapeFunctions::GetInterpolationDerivs(vtkCell* cell, double* pcoords, double* derivs)
 {
+  vtkGenericCell* genericCell = vtkGenericCell::SafeDownCast(cell);
+  if (genericCell)
+  {
+    cell = genericCell->GetRepresentativeCell();
+  }
+
   switch (cell->GetCellType())
   {
     case VTK_QUAD:
@@ -333,94 +429,30 @@ void vtkvmtkFEShapeFunctions::GetInterpolationDerivs(vtkCell* cell, double* pcoo
 
 double vtkvmtkFEShapeFunctions::ComputeJacobian(vtkCell* cell, double* pcoords)
 {
-  double jacobian = 0.0;
-
   int cellDimension = cell->GetCellDimension();
 
-  if (cellDimension == 2)
+  if (cellDimension != 2 && cellDimension != 3)
   {
-    int numberOfCellPoints = cell->GetNumberOfPoints();
-    double* derivs = new double[2*numberOfCellPoints];
-  
-    vtkvmtkFEShapeFunctions::GetInterpolationDerivs(cell,pcoords,derivs);
-  
-    int i, j;
-  
-    double jacobianMatrixTr[2][3];
-    for (i=0; i<3; i++)
-    {
-      jacobianMatrixTr[0][i] = jacobianMatrixTr[1][i] = 0.0;
-    }
-  
-    double x[3];
-    for (j=0; j<numberOfCellPoints; j++)
-    {
-      cell->GetPoints()->GetPoint(j,x);
-      for (i=0; i<3; i++)
-      {
-        jacobianMatrixTr[0][i] += x[i] * derivs[j];
-        jacobianMatrixTr[1][i] += x[i] * derivs[numberOfCellPoints+j];
-      }
-    }
-    delete[] derivs;
-
-    double jacobianMatrixSquared[2][2];
-    jacobianMatrixSquared[0][0] = vtkMath::Dot(jacobianMatrixTr[0],jacobianMatrixTr[0]);
-    jacobianMatrixSquared[0][1] = vtkMath::Dot(jacobianMatrixTr[0],jacobianMatrixTr[1]);
-    jacobianMatrixSquared[1][0] = vtkMath::Dot(jacobianMatrixTr[1],jacobianMatrixTr[0]);
-    jacobianMatrixSquared[1][1] = vtkMath::Dot(jacobianMatrixTr[1],jacobianMatrixTr[1]);
-
-    double jacobianSquared = vtkMath::Determinant2x2(jacobianMatrixSquared[0],jacobianMatrixSquared[1]);
+    return 0.0;
+  }
 
-    if (jacobianSquared < 0.0)
-    {
-#ifdef VTKVMTKFESHAPEFUNCTIONS_NEGATIVE_JACOBIAN_WARNING 
-      vtkGenericWarningMacro("Warning: negative determinant of squared Jacobian, taking absolute value.");
-#endif
-      jacobianSquared = fabs(jacobianSquared);
-    }
+  int numberOfCellPoints = cell->GetNumberOfPoints();
+  std::vector<double> derivs(cellDimension*numberOfCellPoints);
+  std::vector<double> coordinates(3*numberOfCellPoints);
 
-    jacobian = sqrt(jacobianSquared);
-  }
-  else if (cellDimension == 3)
+  vtkvmtkFEShapeFunctions::GetInterpolationDerivs(cell,pcoords,&derivs[0]);
+  for (int j=0; j<numberOfCellPoints; j++)
   {
-    int numberOfCellPoints = cell->GetNumberOfPoints();
-    double* derivs = new double[3*numberOfCellPoints];
-  
-    vtkvmtkFEShapeFunctions::GetInterpolationDerivs(cell,pcoords,derivs);
-  
-    int i, j;
-  
-    double jacobianMatrix[3][3];
-    for (i=0; i<3; i++)
-    {
-      jacobianMatrix[0][i] = jacobianMatrix[1][i] = jacobianMatrix[2][i] = 0.0;
-    }
-  
-    double x[3];
-    for (j=0; j<numberOfCellPoints; j++)
-    {
-      cell->GetPoints()->GetPoint(j,x);
-      for (i=0; i<3; i++)
-      {
-        jacobianMatrix[0][i] += x[i] * derivs[j];
-        jacobianMatrix[1][i] += x[i] * derivs[numberOfCellPoints+j];
-        jacobianMatrix[2][i] += x[i] * derivs[2*numberOfCellPoints+j];
-      }
-    }
-    delete[] derivs;
-
-    jacobian = vtkMath::Determinant3x3(jacobianMatrix);
+    cell->GetPoints()->GetPoint(j,&coordinates[3*j]);
+  }
 
-    if (jacobian < 0.0)
-    {
-#ifdef VTKVMTKFESHAPEFUNCTIONS_NEGATIVE_JACOBIAN_WARNING 
-      vtkGenericWarningMacro("Warning: negative Jacobian, taking absolute value.");
-#endif
-      jacobian = fabs(jacobian);
-    }
+  if (cellDimension == 2)
+  {
+    double inverseJacobianMatrix[2][3];
+    return ComputeInverseJacobianMatrix2D(&coordinates[0],numberOfCellPoints,&derivs[0],inverseJacobianMatrix);
   }
 
-  return jacobian;
+  double inverseJacobianMatrix[3][3];
+  return ComputeInverseJacobianMatrix3D(&coordinates[0],numberOfCellPoints,&derivs[0],inverseJacobianMatrix);
 }
 
@@ -31,6 +31,8 @@
 #include "vtkCell.h"
 #include "vtkDoubleArray.h"
 
+#include <vector>
+
 class VTK_VMTK_DIFFERENTIAL_GEOMETRY_EXPORT vtkvmtkFEShapeFunctions : public vtkObject
 {
 public:
@@ -66,11 +68,29 @@ protected:
   static void ComputeInverseJacobianMatrix2D(vtkCell* cell, double* pcoords, double inverseJacobianMatrix[2][3]);
   static void ComputeInverseJacobianMatrix3D(vtkCell* cell, double* pcoords, double inverseJacobianMatrix[3][3]);
 
+  // Description:
+  // Inverse Jacobian matrix from point coordinates and parametric
+  // derivatives; the Jacobian is returned.
+  static double ComputeInverseJacobianMatrix2D(const double* coordinates, vtkIdType numberOfCellPoints, const double* derivs, double inverseJacobianMatrix[2][3]);
+  static double ComputeInverseJacobianMatrix3D(const double* coordinates, vtkIdType numberOfCellPoints, const double* derivs, double inverseJacobianMatrix[3][3]);
+
+  void BuildReferenceTables(vtkCell* cell, vtkDoubleArray* pcoords);
+
   vtkDoubleArray* Phi;
   vtkDoubleArray* DPhi;
   vtkDoubleArray* Jacobians;
   vtkIdType NumberOfCellPoints;
 
+  // shape functions and parametric derivatives at the quadrature points,
+  // which only depend on the cell type: they are computed once for a run of
+  // cells of the same type
+  int ReferenceCellType;
+  vtkIdType ReferenceNumberOfCellPoints;
+  std::vector<double> ReferencePCoords;
+  std::vector<double> ReferencePhi;
+  std::vector<double> ReferenceDerivs;
+  std::vector<double> CellCoordinates;
+
 private:  
   vtkvmtkFEShapeFunctions(const vtkvmtkFEShapeFunctions&);  // Not implemented.
   void operator=(const vtkvmtkFEShapeFunctions&);  // Not implemented.
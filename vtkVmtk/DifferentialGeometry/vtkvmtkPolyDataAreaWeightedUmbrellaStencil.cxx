@@ -36,29 +36,27 @@ void vtkvmtkPolyDataAreaWeightedUmbrellaStencil::Build()
 {
   this->Superclass::Build();
 
-  for (vtkIdType i=0; i<this->NPoints; i++)
-    {
-    this->Weights[i] = 1.0/double(this->NPoints);
-    }
-
-  vtkPolyData* pdata = vtkPolyData::SafeDownCast(this->DataSet);
+  this->Area = vtkvmtkPolyDataAreaWeightedUmbrellaStencil::BuildWeights(vtkPolyData::SafeDownCast(this->DataSet),this->DataSetPointId,this->NPoints,this->PointIds,this->IsBoundary,this->WeightScaling,this->NegateWeights,this->Weights,this->CenterWeight);
+}
 
-  int j;
-  for (j=0; j<this->NPoints; j++)
+double vtkvmtkPolyDataAreaWeightedUmbrellaStencil::BuildWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, int weightScaling, int negateWeights, double* weights, double* centerWeight)
+{
+  vtkIdType j;
+  for (j=0; j<numberOfPoints; j++)
     {
-    this->Weights[j] = 0.0;
+    weights[j] = 0.0;
     }
   
   double point[3], point1[3], point2[3];
 //  double vector[3], vector1[3], vector2[3];
 //  double dot = 0.0;
   
-  pdata->GetPoint(this->DataSetPointId,point);
+  pdata->GetPoint(pointId,point);
 
-//  for (j=0; j<this->NPoints; j++)
+//  for (j=0; j<numberOfPoints; j++)
 //    {
-//    pdata->GetPoint(this->PointIds[j],point1);
-//    pdata->GetPoint(this->PointIds[(j+1)%this->NPoints],point2);
+//    pdata->GetPoint(pointIds[j],point1);
+//    pdata->GetPoint(pointIds[(j+1)%numberOfPoints],point2);
 //    vector[0] = point2[0] - point1[0];
 //    vector[1] = point2[1] - point1[1];
 //    vector[2] = point2[2] - point1[2];
@@ -72,35 +70,43 @@ void vtkvmtkPolyDataAreaWeightedUmbrellaStencil::Build()
 //    vtkMath::Normalize(vector1);
 //    vtkMath::Normalize(vector2);
 //    dot = vtkMath::Dot(vector,vector1);
-//    this->Weights[j] += vtkMath::Distance2BetweenPoints(point,point1) * dot * sqrt(1.0 - dot*dot) / 2.0;
-//    if (!(this->IsBoundary || j==this->NPoints-1))
+//    weights[j] += vtkMath::Distance2BetweenPoints(point,point1) * dot * sqrt(1.0 - dot*dot) / 2.0;
+//    if (!(isBoundary || j==numberOfPoints-1))
 //      {
 //      dot = vtkMath::Dot(vector,vector2);
-//      this->Weights[(j+1)%this->NPoints] += vtkMath::Distance2BetweenPoints(point,point2) * dot * sqrt(1.0 - dot*dot) / 2.0;
+//      weights[(j+1)%numberOfPoints] += vtkMath::Distance2BetweenPoints(point,point2) * dot * sqrt(1.0 - dot*dot) / 2.0;
 //      }
-  for (j=0; j<this->NPoints; j++)
+  for (j=0; j<numberOfPoints; j++)
     {
-    pdata->GetPoint(this->PointIds[j],point1);
-    pdata->GetPoint(this->PointIds[(j+1)%this->NPoints],point2);
+    pdata->GetPoint(pointIds[j],point1);
+    pdata->GetPoint(pointIds[(j+1)%numberOfPoints],point2);
     double area = vtkvmtkMath::TriangleArea(point,point1,point2);
-    if (!(this->IsBoundary || j==this->NPoints-1))
+    if (!(isBoundary || j==numberOfPoints-1))
       {
-      this->Weights[j] += area;
-      this->Weights[(j+1)%this->NPoints] += area;
+      weights[j] += area;
+      weights[(j+1)%numberOfPoints] += area;
       }
     }
  
-  this->CenterWeight[0] = 0.0;
-  for (j=0; j<this->NPoints; j++)
+  centerWeight[0] = 0.0;
+  for (j=0; j<numberOfPoints; j++)
     {
-    this->CenterWeight[0] += this->Weights[j];
+    centerWeight[0] += weights[j];
     }
 
-  this->Area = this->CenterWeight[0];
+  double stencilArea = centerWeight[0];
 
-  this->ScaleWithArea();
+  if (weightScaling)
+    {
+    vtkvmtkPolyDataManifoldStencil::ScaleWithAreaFactor(stencilArea,1.0,numberOfPoints,1,weights,centerWeight);
+    }
+
+  if (negateWeights)
+    {
+    vtkvmtkStencil::ChangeWeightSign(numberOfPoints,weights);
+    }
 
-  this->ChangeWeightSign();
+  return stencilArea;
 }
 
 void vtkvmtkPolyDataAreaWeightedUmbrellaStencil::ScaleWithArea()
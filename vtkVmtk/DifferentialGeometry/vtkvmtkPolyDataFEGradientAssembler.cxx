@@ -34,6 +34,7 @@ vtkStandardNewMacro(vtkvmtkPolyDataFEGradientAssembler);
 vtkvmtkPolyDataFEGradientAssembler::vtkvmtkPolyDataFEGradientAssembler()
 {
   this->ScalarsArrayName = NULL;
+  this->ScalarsArray = NULL;
   this->ScalarsComponent = 0;
 }
 
@@ -65,72 +66,64 @@ void vtkvmtkPolyDataFEGradientAssembler::Build()
   int numberOfVariables = 3;
   this->Initialize(numberOfVariables);
 
-  vtkvmtkGaussQuadrature* gaussQuadrature = vtkvmtkGaussQuadrature::New();
-  gaussQuadrature->SetOrder(this->QuadratureOrder);
-
-  vtkvmtkFEShapeFunctions* feShapeFunctions = vtkvmtkFEShapeFunctions::New();
+  this->ScalarsArray = scalarsArray;
 
   int dimension = 2;
+  this->AssembleCells(dimension);
+
+  this->ScalarsArray = NULL;
+}
 
-  int numberOfCells = this->DataSet->GetNumberOfCells();
+void vtkvmtkPolyDataFEGradientAssembler::AssembleCell(vtkCell* cell, vtkvmtkGaussQuadrature* gaussQuadrature, vtkvmtkFEShapeFunctions* feShapeFunctions)
+{
+  vtkDataArray* scalarsArray = this->ScalarsArray;
   int numberOfPoints = this->DataSet->GetNumberOfPoints();
-  int k;
-  for (k=0; k<numberOfCells; k++)
+
+  gaussQuadrature->Initialize(cell->GetCellType());
+  feShapeFunctions->Initialize(cell,gaussQuadrature->GetQuadraturePoints());
+  int numberOfQuadraturePoints = gaussQuadrature->GetNumberOfQuadraturePoints();
+  double quadraturePCoords[3];
+  int numberOfCellPoints = cell->GetNumberOfPoints();
+  int i, j;
+  int q;
+  for (q=0; q<numberOfQuadraturePoints; q++)
     {
-    vtkCell* cell = this->DataSet->GetCell(k);
-    if (cell->GetCellDimension() != dimension)
+    gaussQuadrature->GetQuadraturePoint(q,quadraturePCoords);
+    double quadratureWeight = gaussQuadrature->GetQuadratureWeight(q);
+    double jacobian = feShapeFunctions->GetJacobian(q);
+    double phii, phij;
+    double dphii[3];
+    double gradientValue[3];
+    gradientValue[0] = gradientValue[1] = gradientValue[2] = 0.0;
+    for (i=0; i<numberOfCellPoints; i++)
       {
-      continue;
-      } 
-    gaussQuadrature->Initialize(cell->GetCellType());
-    feShapeFunctions->Initialize(cell,gaussQuadrature->GetQuadraturePoints());
-    int numberOfQuadraturePoints = gaussQuadrature->GetNumberOfQuadraturePoints();
-    double quadraturePCoords[3];
-    int numberOfCellPoints = cell->GetNumberOfPoints();
-    int i, j;
-    int q;
-    for (q=0; q<numberOfQuadraturePoints; q++)
+      vtkIdType iId = cell->GetPointId(i);
+      feShapeFunctions->GetDPhi(q,i,dphii);
+      double nodalValue = scalarsArray->GetComponent(iId,this->ScalarsComponent);
+      gradientValue[0] += nodalValue * dphii[0];
+      gradientValue[1] += nodalValue * dphii[1];
+      gradientValue[2] += nodalValue * dphii[2];
+      }
+    for (i=0; i<numberOfCellPoints; i++)
       {
-      gaussQuadrature->GetQuadraturePoint(q,quadraturePCoords);
-      double quadratureWeight = gaussQuadrature->GetQuadratureWeight(q);
-      double jacobian = feShapeFunctions->GetJacobian(q);
-      double phii, phij;
-      double dphii[3];
-      double gradientValue[3];
-      gradientValue[0] = gradientValue[1] = gradientValue[2] = 0.0;
-      for (i=0; i<numberOfCellPoints; i++)
-        {
-        vtkIdType iId = cell->GetPointId(i);
-        feShapeFunctions->GetDPhi(q,i,dphii);
-        double nodalValue = scalarsArray->GetComponent(iId,this->ScalarsComponent);
-        gradientValue[0] += nodalValue * dphii[0];
-        gradientValue[1] += nodalValue * dphii[1];
-        gradientValue[2] += nodalValue * dphii[2];
-        }
-      for (i=0; i<numberOfCellPoints; i++)
+      vtkIdType iId = cell->GetPointId(i);
+      phii = feShapeFunctions->GetPhi(q,i);
+      double value0 = jacobian * quadratureWeight * gradientValue[0] * phii;
+      double value1 = jacobian * quadratureWeight * gradientValue[1] * phii;
+      double value2 = jacobian * quadratureWeight * gradientValue[2] * phii;
+      this->RHSVector->AddElement(iId,value0);
+      this->RHSVector->AddElement(iId+numberOfPoints,value1);
+      this->RHSVector->AddElement(iId+2*numberOfPoints,value2);
+      for (j=0; j<numberOfCellPoints; j++)
         {
-        vtkIdType iId = cell->GetPointId(i);
-        phii = feShapeFunctions->GetPhi(q,i);
-        double value0 = jacobian * quadratureWeight * gradientValue[0] * phii;
-        double value1 = jacobian * quadratureWeight * gradientValue[1] * phii;
-        double value2 = jacobian * quadratureWeight * gradientValue[2] * phii;
-        this->RHSVector->AddElement(iId,value0);
-        this->RHSVector->AddElement(iId+numberOfPoints,value1);
-        this->RHSVector->AddElement(iId+2*numberOfPoints,value2);
-        for (j=0; j<numberOfCellPoints; j++)
-          {
-          vtkIdType jId = cell->GetPointId(j);
-          phij = feShapeFunctions->GetPhi(q,j);
-          double value = jacobian * quadratureWeight * phii * phij;
-          this->Matrix->AddElement(iId,jId,value);
-          this->Matrix->AddElement(iId+numberOfPoints,jId+numberOfPoints,value);
-          this->Matrix->AddElement(iId+2*numberOfPoints,jId+2*numberOfPoints,value);
-          }
+        vtkIdType jId = cell->GetPointId(j);
+        phij = feShapeFunctions->GetPhi(q,j);
+        double value = jacobian * quadratureWeight * phii * phij;
+        this->Matrix->AddElement(iId,jId,value);
+        this->Matrix->AddElement(iId+numberOfPoints,jId+numberOfPoints,value);
+        this->Matrix->AddElement(iId+2*numberOfPoints,jId+2*numberOfPoints,value);
         }
       }
     }
-
-  gaussQuadrature->Delete();
-  feShapeFunctions->Delete();
 }
 
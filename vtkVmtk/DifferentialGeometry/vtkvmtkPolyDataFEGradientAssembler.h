@@ -28,6 +28,8 @@
 #include "vtkvmtkFEAssembler.h"
 #include "vtkvmtkWin32Header.h"
 
+class vtkDataArray;
+
 class VTK_VMTK_DIFFERENTIAL_GEOMETRY_EXPORT vtkvmtkPolyDataFEGradientAssembler : public vtkvmtkFEAssembler
 {
 public:
@@ -47,9 +49,14 @@ protected:
   vtkvmtkPolyDataFEGradientAssembler();
   ~vtkvmtkPolyDataFEGradientAssembler();
 
+  virtual void AssembleCell(vtkCell* cell, vtkvmtkGaussQuadrature* gaussQuadrature, vtkvmtkFEShapeFunctions* feShapeFunctions) override;
+
   char* ScalarsArrayName;
   int ScalarsComponent;
 
+  // scalars array of the Build in progress
+  vtkDataArray* ScalarsArray;
+
 private:
   vtkvmtkPolyDataFEGradientAssembler(const vtkvmtkPolyDataFEGradientAssembler&);  // Not implemented.
   void operator=(const vtkvmtkPolyDataFEGradientAssembler&);  // Not implemented.
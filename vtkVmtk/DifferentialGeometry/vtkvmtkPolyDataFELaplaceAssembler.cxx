@@ -42,52 +42,38 @@ void vtkvmtkPolyDataFELaplaceAssembler::Build()
   int numberOfVariables = 1;
   this->Initialize(numberOfVariables);
 
-  vtkvmtkGaussQuadrature* gaussQuadrature = vtkvmtkGaussQuadrature::New();
-  gaussQuadrature->SetOrder(this->QuadratureOrder);
-
-  vtkvmtkFEShapeFunctions* feShapeFunctions = vtkvmtkFEShapeFunctions::New();
-
   int dimension = 2;
+  this->AssembleCells(dimension);
+}
 
-  int numberOfCells = this->DataSet->GetNumberOfCells();
-  int k;
-  for (k=0; k<numberOfCells; k++)
+void vtkvmtkPolyDataFELaplaceAssembler::AssembleCell(vtkCell* cell, vtkvmtkGaussQuadrature* gaussQuadrature, vtkvmtkFEShapeFunctions* feShapeFunctions)
+{
+  gaussQuadrature->Initialize(cell->GetCellType());
+  feShapeFunctions->Initialize(cell,gaussQuadrature->GetQuadraturePoints());
+  int numberOfQuadraturePoints = gaussQuadrature->GetNumberOfQuadraturePoints();
+  double quadraturePCoords[3];
+  int numberOfCellPoints = cell->GetNumberOfPoints();
+  int i, j;
+  int q;
+  for (q=0; q<numberOfQuadraturePoints; q++)
     {
-    vtkCell* cell = this->DataSet->GetCell(k);
-    if (cell->GetCellDimension() != dimension)
-      {
-      continue;
-      } 
-    gaussQuadrature->Initialize(cell->GetCellType());
-    feShapeFunctions->Initialize(cell,gaussQuadrature->GetQuadraturePoints());
-    int numberOfQuadraturePoints = gaussQuadrature->GetNumberOfQuadraturePoints();
-    double quadraturePCoords[3];
-    int numberOfCellPoints = cell->GetNumberOfPoints();
-    int i, j;
-    int q;
-    for (q=0; q<numberOfQuadraturePoints; q++)
+    gaussQuadrature->GetQuadraturePoint(q,quadraturePCoords);
+    double quadratureWeight = gaussQuadrature->GetQuadratureWeight(q);
+    double jacobian = feShapeFunctions->GetJacobian(q);
+    double dphii[3], dphij[3];
+    for (i=0; i<numberOfCellPoints; i++)
       {
-      gaussQuadrature->GetQuadraturePoint(q,quadraturePCoords);
-      double quadratureWeight = gaussQuadrature->GetQuadratureWeight(q);
-      double jacobian = feShapeFunctions->GetJacobian(q);
-      double dphii[3], dphij[3];
-      for (i=0; i<numberOfCellPoints; i++)
+      vtkIdType iId = cell->GetPointId(i);
+      feShapeFunctions->GetDPhi(q,i,dphii);
+      for (j=0; j<numberOfCellPoints; j++)
         {
-        vtkIdType iId = cell->GetPointId(i);
-        feShapeFunctions->GetDPhi(q,i,dphii);
-        for (j=0; j<numberOfCellPoints; j++)
-          {
-          vtkIdType jId = cell->GetPointId(j);
-          feShapeFunctions->GetDPhi(q,j,dphij);
-          double gradphii_gradphij = vtkMath::Dot(dphii,dphij);
-          double value = jacobian * quadratureWeight * gradphii_gradphij;
-          this->Matrix->AddElement(iId,jId,value);
-          }
+        vtkIdType jId = cell->GetPointId(j);
+        feShapeFunctions->GetDPhi(q,j,dphij);
+        double gradphii_gradphij = vtkMath::Dot(dphii,dphij);
+        double value = jacobian * quadratureWeight * gradphii_gradphij;
+        this->Matrix->AddElement(iId,jId,value);
         }
       }
     }
-
-  gaussQuadrature->Delete();
-  feShapeFunctions->Delete();
 }
 
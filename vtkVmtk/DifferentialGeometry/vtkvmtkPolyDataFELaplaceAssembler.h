@@ -41,6 +41,8 @@ protected:
   vtkvmtkPolyDataFELaplaceAssembler();
   ~vtkvmtkPolyDataFELaplaceAssembler();
 
+  virtual void AssembleCell(vtkCell* cell, vtkvmtkGaussQuadrature* gaussQuadrature, vtkvmtkFEShapeFunctions* feShapeFunctions) override;
+
 private:
   vtkvmtkPolyDataFELaplaceAssembler(const vtkvmtkPolyDataFELaplaceAssembler&);  // Not implemented.
   void operator=(const vtkvmtkPolyDataFELaplaceAssembler&);  // Not implemented.
@@ -38,3 +38,8 @@ void vtkvmtkPolyDataFELaplaceBeltramiStencil::ScaleWithArea()
   {
   this->ScaleWithAreaFactor(1.0/3.0);
   }
+
+double vtkvmtkPolyDataFELaplaceBeltramiStencil::BuildWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, int weightScaling, int negateWeights, double* weights, double* centerWeight)
+  {
+  return vtkvmtkPolyDataLaplaceBeltramiStencil::BuildLaplaceBeltramiWeights(pdata,pointId,numberOfPoints,pointIds,isBoundary,1.0/3.0,weightScaling,negateWeights,weights,centerWeight);
+  }
@@ -71,4 +71,9 @@ void vtkvmtkPolyDataFVFELaplaceBeltramiStencil::ScaleWithArea()
   this->ScaleWithAreaFactor(1.0/3.0);
   }
 
+double vtkvmtkPolyDataFVFELaplaceBeltramiStencil::BuildWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, int weightScaling, int negateWeights, double* weights, double* centerWeight)
+  {
+  return vtkvmtkPolyDataLaplaceBeltramiStencil::BuildLaplaceBeltramiWeights(pdata,pointId,numberOfPoints,pointIds,isBoundary,1.0/3.0,weightScaling,negateWeights,weights,centerWeight);
+  }
+
 
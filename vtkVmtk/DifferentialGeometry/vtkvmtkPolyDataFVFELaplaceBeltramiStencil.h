@@ -40,6 +40,12 @@ public:
 
   virtual vtkIdType GetItemType() override {return VTK_VMTK_FVFE_LAPLACE_BELTRAMI_STENCIL;};
 
+  // Description:
+  // Build the weights of the stencil of point pointId of pdata, whose
+  // neighborhood is the numberOfPoints ids in pointIds, into weights and
+  // centerWeight without instantiating a stencil. Returns the stencil area.
+  static double BuildWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, int weightScaling, int negateWeights, double* weights, double* centerWeight);
+
 protected:
   vtkvmtkPolyDataFVFELaplaceBeltramiStencil();
   ~vtkvmtkPolyDataFVFELaplaceBeltramiStencil() {};
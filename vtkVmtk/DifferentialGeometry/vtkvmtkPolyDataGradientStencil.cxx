@@ -62,75 +62,83 @@ void vtkvmtkPolyDataGradientStencil::Gamma(double p0[3], double p1[3], double p2
 
 void vtkvmtkPolyDataGradientStencil::Build()
 {
-  double point[3], point1[3], point2[3];
-  vtkIdType j, firstId, lastId;
-
   this->Superclass::Build();
 
-  vtkPolyData* pdata = vtkPolyData::SafeDownCast(this->DataSet);
+  this->Area = vtkvmtkPolyDataGradientStencil::BuildWeights(vtkPolyData::SafeDownCast(this->DataSet),this->DataSetPointId,this->NPoints,this->PointIds,this->IsBoundary,this->WeightScaling,this->NegateWeights,this->Weights,this->CenterWeight);
+}
 
-  if (!this->IsBoundary)
+double vtkvmtkPolyDataGradientStencil::BuildWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, int weightScaling, int vtkNotUsed(negateWeights), double* weights, double* centerWeight)
+{
+  double point[3], point1[3], point2[3];
+  vtkIdType j, firstId, lastId;
+
+  if (!isBoundary)
     {
     firstId = 0;
-    lastId = this->NPoints-1;
+    lastId = numberOfPoints-1;
     }
   else
     {
     firstId = 0;
-    lastId = this->NPoints-2;
+    lastId = numberOfPoints-2;
     }
 
-  pdata->GetPoint(this->DataSetPointId,point);
+  pdata->GetPoint(pointId,point);
 
-  for (j=0; j<3*this->NPoints; j++)
-    this->Weights[j] = 0.0;
+  for (j=0; j<3*numberOfPoints; j++)
+    weights[j] = 0.0;
 
-  this->CenterWeight[0] = 0.0;
-  this->CenterWeight[1] = 0.0;
-  this->CenterWeight[2] = 0.0;
+  centerWeight[0] = 0.0;
+  centerWeight[1] = 0.0;
+  centerWeight[2] = 0.0;
   
   double gamma[3];
   for (j=firstId; j<=lastId; j++)
     {
-    pdata->GetPoint(this->PointIds[j],point1);
+    pdata->GetPoint(pointIds[j],point1);
  
-    int jplus = (j+1) % this->NPoints;
-    pdata->GetPoint(this->PointIds[jplus],point2);
+    vtkIdType jplus = (j+1) % numberOfPoints;
+    pdata->GetPoint(pointIds[jplus],point2);
 
     double areaWeight = 1.0 / (4.0 * vtkvmtkMath::TriangleArea(point,point1,point2));
     
-    this->Gamma(point,point1,point2,gamma); 
-    this->CenterWeight[0] += gamma[0] * areaWeight;
-    this->CenterWeight[1] += gamma[1] * areaWeight;
-    this->CenterWeight[2] += gamma[2] * areaWeight;
-
-    this->Gamma(point,point2,point1,gamma); 
-    this->CenterWeight[0] += gamma[0] * areaWeight;
-    this->CenterWeight[1] += gamma[1] * areaWeight;
-    this->CenterWeight[2] += gamma[2] * areaWeight;
-
-    this->Gamma(point1,point,point2,gamma); 
-    this->Weights[3*j+0] += gamma[0] * areaWeight;
-    this->Weights[3*j+1] += gamma[1] * areaWeight;
-    this->Weights[3*j+2] += gamma[2] * areaWeight;
-
-    this->Gamma(point1,point2,point,gamma); 
-    this->Weights[3*j+0] += gamma[0] * areaWeight;
-    this->Weights[3*j+1] += gamma[1] * areaWeight;
-    this->Weights[3*j+2] += gamma[2] * areaWeight;
-
-    this->Gamma(point2,point1,point,gamma); 
-    this->Weights[3*jplus+0] += gamma[0] * areaWeight;
-    this->Weights[3*jplus+1] += gamma[1] * areaWeight;
-    this->Weights[3*jplus+2] += gamma[2] * areaWeight;
-
-    this->Gamma(point2,point,point1,gamma); 
-    this->Weights[3*jplus+0] += gamma[0] * areaWeight;
-    this->Weights[3*jplus+1] += gamma[1] * areaWeight;
-    this->Weights[3*jplus+2] += gamma[2] * areaWeight;
+    vtkvmtkPolyDataGradientStencil::Gamma(point,point1,point2,gamma); 
+    centerWeight[0] += gamma[0] * areaWeight;
+    centerWeight[1] += gamma[1] * areaWeight;
+    centerWeight[2] += gamma[2] * areaWeight;
+
+    vtkvmtkPolyDataGradientStencil::Gamma(point,point2,point1,gamma); 
+    centerWeight[0] += gamma[0] * areaWeight;
+    centerWeight[1] += gamma[1] * areaWeight;
+    centerWeight[2] += gamma[2] * areaWeight;
+
+    vtkvmtkPolyDataGradientStencil::Gamma(point1,point,point2,gamma); 
+    weights[3*j+0] += gamma[0] * areaWeight;
+    weights[3*j+1] += gamma[1] * areaWeight;
+    weights[3*j+2] += gamma[2] * areaWeight;
+
+    vtkvmtkPolyDataGradientStencil::Gamma(point1,point2,point,gamma); 
+    weights[3*j+0] += gamma[0] * areaWeight;
+    weights[3*j+1] += gamma[1] * areaWeight;
+    weights[3*j+2] += gamma[2] * areaWeight;
+
+    vtkvmtkPolyDataGradientStencil::Gamma(point2,point1,point,gamma); 
+    weights[3*jplus+0] += gamma[0] * areaWeight;
+    weights[3*jplus+1] += gamma[1] * areaWeight;
+    weights[3*jplus+2] += gamma[2] * areaWeight;
+
+    vtkvmtkPolyDataGradientStencil::Gamma(point2,point,point1,gamma); 
+    weights[3*jplus+0] += gamma[0] * areaWeight;
+    weights[3*jplus+1] += gamma[1] * areaWeight;
+    weights[3*jplus+2] += gamma[2] * areaWeight;
     }
 
-  this->ComputeArea();
-  this->ScaleWithArea();
-}
+  double area = vtkvmtkPolyDataManifoldStencil::ComputeArea(pdata,pointId,numberOfPoints,pointIds,isBoundary);
+
+  if (weightScaling)
+    {
+    vtkvmtkPolyDataManifoldStencil::ScaleWithAreaFactor(area,1.0,numberOfPoints,3,weights,centerWeight);
+    }
 
+  return area;
+}
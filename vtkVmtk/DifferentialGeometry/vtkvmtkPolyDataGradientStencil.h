@@ -41,13 +41,20 @@ public:
   
   void Build() override;
 
+  // Description:
+  // Build the weights of the stencil of point pointId of pdata, whose
+  // neighborhood is the numberOfPoints ids in pointIds, into weights and
+  // centerWeight (three components each) without instantiating a stencil.
+  // Returns the stencil area. negateWeights is ignored, as in Build.
+  static double BuildWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, int weightScaling, int negateWeights, double* weights, double* centerWeight);
+
 protected:
   vtkvmtkPolyDataGradientStencil();
   ~vtkvmtkPolyDataGradientStencil() {};
 
   void ScaleWithArea() override;
 
-  void Gamma(double p0[3], double p1[3], double p2[3], double gamma[3]);
+  static void Gamma(double p0[3], double p1[3], double p2[3], double gamma[3]);
   
 private:
   vtkvmtkPolyDataGradientStencil(const vtkvmtkPolyDataGradientStencil&);  // Not implemented.
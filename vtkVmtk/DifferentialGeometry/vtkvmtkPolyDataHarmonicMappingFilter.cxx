@@ -23,22 +23,18 @@
 #include "vtkPolyData.h"
 #include "vtkPointData.h"
 #include "vtkDoubleArray.h"
-#include "vtkvmtkDoubleVector.h"
-#include "vtkvmtkStencils.h"
-#include "vtkvmtkPolyDataFELaplaceAssembler.h"
-#include "vtkvmtkSparseMatrix.h"
-#include "vtkvmtkSparseMatrixRow.h"
-#include "vtkvmtkLinearSystem.h"
-#include "vtkvmtkOpenNLLinearSystemSolver.h"
-
-#include "vtkvmtkDirichletBoundaryConditions.h"
+#include "vtkvmtkPolyDataLaplaceOperator.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
 
+#include <vector>
+
 
 vtkStandardNewMacro(vtkvmtkPolyDataHarmonicMappingFilter);
 
+vtkCxxSetObjectMacro(vtkvmtkPolyDataHarmonicMappingFilter,LaplaceOperator,vtkvmtkPolyDataLaplaceOperator);
+
 vtkvmtkPolyDataHarmonicMappingFilter::vtkvmtkPolyDataHarmonicMappingFilter() 
 {
   this->BoundaryPointIds = NULL;
@@ -48,6 +44,8 @@ vtkvmtkPolyDataHarmonicMappingFilter::vtkvmtkPolyDataHarmonicMappingFilter()
   this->ConvergenceTolerance = 1E-6;
   this->SetAssemblyModeToFiniteElements();
   this->QuadratureOrder = 1;
+
+  this->LaplaceOperator = NULL;
 }
 
 vtkvmtkPolyDataHarmonicMappingFilter::~vtkvmtkPolyDataHarmonicMappingFilter()
@@ -69,6 +67,12 @@ vtkvmtkPolyDataHarmonicMappingFilter::~vtkvmtkPolyDataHarmonicMappingFilter()
     delete[] this->HarmonicMappingArrayName;
     this->HarmonicMappingArrayName = NULL;
     }
+
+  if (this->LaplaceOperator)
+    {
+    this->LaplaceOperator->Delete();
+    this->LaplaceOperator = NULL;
+    }
 }
 
 int vtkvmtkPolyDataHarmonicMappingFilter::RequestData(
@@ -104,81 +108,78 @@ int vtkvmtkPolyDataHarmonicMappingFilter::RequestData(
 
   int numberOfInputPoints = input->GetNumberOfPoints();
 
-  vtkvmtkSparseMatrix* sparseMatrix = vtkvmtkSparseMatrix::New();
+  vtkvmtkPolyDataLaplaceOperator* laplaceOperator = this->LaplaceOperator;
+  if (laplaceOperator)
+    {
+    laplaceOperator->Register(this);
+    }
+  else
+    {
+    laplaceOperator = vtkvmtkPolyDataLaplaceOperator::New();
+    }
 
-  vtkvmtkDoubleVector* rhsVector = vtkvmtkDoubleVector::New();
-  rhsVector->SetNormTypeToLInf();
-    
-  vtkvmtkDoubleVector* solutionVector = vtkvmtkDoubleVector::New();
-  solutionVector->SetNormTypeToLInf();
-   
-  if (this->AssemblyMode == VTK_VMTK_ASSEMBLY_STENCILS)
+  if (!laplaceOperator->GetDataSet())
     {
-    vtkvmtkStencils* stencils = vtkvmtkStencils::New();
-    stencils->SetStencilTypeToFELaplaceBeltramiStencil();
-    stencils->WeightScalingOff();
-    stencils->NegateWeightsOn();
-    stencils->SetDataSet(input);
-    stencils->Build();
-
-    sparseMatrix->CopyRowsFromStencils(stencils);
-    rhsVector->Allocate(numberOfInputPoints);
-    rhsVector->Fill(0.0);
-    solutionVector->Allocate(numberOfInputPoints);
-    solutionVector->Fill(0.0);
-
-    stencils->Delete();
+    laplaceOperator->SetDataSet(input);
     }
-  else if (this->AssemblyMode == VTK_VMTK_ASSEMBLY_FINITEELEMENTS)
+
+  laplaceOperator->SetAssemblyMode(this->AssemblyMode);
+  laplaceOperator->SetQuadratureOrder(this->QuadratureOrder);
+  laplaceOperator->SetConvergenceTolerance(this->ConvergenceTolerance);
+
+  // with an operator on a larger surface sharing the input points, solve
+  // for the points used by the input cells only
+  vtkIdList* pointIds = NULL;
+  if (laplaceOperator->GetDataSet() != input)
     {
-    vtkvmtkPolyDataFELaplaceAssembler* assembler = vtkvmtkPolyDataFELaplaceAssembler::New();
-    assembler->SetDataSet(input);
-    assembler->SetMatrix(sparseMatrix);
-    assembler->SetRHSVector(rhsVector);
-    assembler->SetSolutionVector(solutionVector);
-    assembler->SetQuadratureOrder(this->QuadratureOrder);
-    assembler->Build();
-    assembler->Delete();
+    if (laplaceOperator->GetDataSet()->GetNumberOfPoints() != numberOfInputPoints)
+      {
+      vtkErrorMacro(<<"LaplaceOperator dataset and input have a different number of points.");
+      laplaceOperator->UnRegister(this);
+      return 1;
+      }
+
+    std::vector<char> usedPoints(numberOfInputPoints,0);
+    vtkIdType numberOfCells = input->GetNumberOfCells();
+    vtkIdType npts;
+    const vtkIdType *pts;
+    vtkIdType i, j;
+    for (i=0; i<numberOfCells; i++)
+      {
+      input->GetCellPoints(i,npts,pts);
+      for (j=0; j<npts; j++)
+        {
+        usedPoints[pts[j]] = 1;
+        }
+      }
+
+    pointIds = vtkIdList::New();
+    for (i=0; i<numberOfInputPoints; i++)
+      {
+      if (usedPoints[i])
+        {
+        pointIds->InsertNextId(i);
+        }
+      }
     }
-    
-  vtkvmtkLinearSystem* linearSystem = vtkvmtkLinearSystem::New();
-  linearSystem->SetA(sparseMatrix);
-  linearSystem->SetB(rhsVector);
-  linearSystem->SetX(solutionVector);
-
-  //TODO: deal with NumberOfVariables > 1
-  vtkvmtkDirichletBoundaryConditions* dirichetBoundaryConditions = vtkvmtkDirichletBoundaryConditions::New();
-  dirichetBoundaryConditions->SetLinearSystem(linearSystem);
-  dirichetBoundaryConditions->SetBoundaryNodes(this->BoundaryPointIds);
-  dirichetBoundaryConditions->SetBoundaryValues(this->BoundaryValues);
-  dirichetBoundaryConditions->Apply();
-
-  vtkvmtkOpenNLLinearSystemSolver* solver = vtkvmtkOpenNLLinearSystemSolver::New();
-  solver->SetLinearSystem(linearSystem);
-  solver->SetConvergenceTolerance(this->ConvergenceTolerance);
-  solver->SetMaximumNumberOfIterations(numberOfInputPoints);
-  solver->SetSolverTypeToCG();
-  solver->SetPreconditionerTypeToNone();
-  solver->Solve();
 
   vtkDoubleArray* harmonicMappingArray = vtkDoubleArray::New();
   harmonicMappingArray->SetName(this->HarmonicMappingArrayName);
   harmonicMappingArray->SetNumberOfComponents(1);
   harmonicMappingArray->SetNumberOfTuples(numberOfInputPoints);
 
-  solutionVector->CopyIntoArrayComponent(harmonicMappingArray,0);
- 
-  output->DeepCopy(input);
+  laplaceOperator->Solve(pointIds,this->BoundaryPointIds,this->BoundaryValues,harmonicMappingArray);
+
+  output->ShallowCopy(input);
 
   output->GetPointData()->AddArray(harmonicMappingArray);
 
-  solver->Delete();
+  if (pointIds)
+    {
+    pointIds->Delete();
+    }
   harmonicMappingArray->Delete();
-  sparseMatrix->Delete();
-  rhsVector->Delete();
-  solutionVector->Delete();
-  linearSystem->Delete();
-  dirichetBoundaryConditions->Delete();
+  laplaceOperator->UnRegister(this);
 
   return 1;
 }
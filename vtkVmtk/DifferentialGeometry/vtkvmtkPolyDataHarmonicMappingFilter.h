@@ -31,6 +31,8 @@
 #include "vtkIdList.h"
 #include "vtkDoubleArray.h"
 
+class vtkvmtkPolyDataLaplaceOperator;
+
 class VTK_VMTK_DIFFERENTIAL_GEOMETRY_EXPORT vtkvmtkPolyDataHarmonicMappingFilter : public vtkPolyDataAlgorithm
 {
 public:
@@ -59,6 +61,15 @@ public:
   vtkSetMacro(QuadratureOrder,int);
   vtkGetMacro(QuadratureOrder,int);
 
+  // Description:
+  // Optional Laplace operator to assemble the system with. An operator
+  // shared by several executions keeps its assembled matrix as long as its
+  // surface does not change. Its surface must be the input or share the
+  // input points; in the latter case only the points used by the input
+  // cells are solved for. If not set, a temporary operator on the input is
+  // used.
+  virtual void SetLaplaceOperator(vtkvmtkPolyDataLaplaceOperator*);
+  vtkGetObjectMacro(LaplaceOperator,vtkvmtkPolyDataLaplaceOperator);
 
 //BTX
   enum 
@@ -82,6 +93,8 @@ protected:
   int AssemblyMode;
   int QuadratureOrder;
 
+  vtkvmtkPolyDataLaplaceOperator* LaplaceOperator;
+
 private:
   vtkvmtkPolyDataHarmonicMappingFilter(const vtkvmtkPolyDataHarmonicMappingFilter&);  // Not implemented.
   void operator=(const vtkvmtkPolyDataHarmonicMappingFilter&);  // Not implemented.
@@ -34,17 +34,22 @@ vtkvmtkPolyDataLaplaceBeltramiStencil::vtkvmtkPolyDataLaplaceBeltramiStencil()
   }
 
 void vtkvmtkPolyDataLaplaceBeltramiStencil::BuildBoundaryWeights(vtkIdType boundaryPointId, vtkIdType boundaryNeighborPointId, double &boundaryWeight, double &boundaryNeighborWeight)
+  {
+  if (!this->IsBoundary)
+    return;
+
+  vtkvmtkPolyDataLaplaceBeltramiStencil::ComputeBoundaryWeights(this->DataSet,this->DataSetPointId,boundaryPointId,boundaryNeighborPointId,boundaryWeight,boundaryNeighborWeight);
+  }
+
+void vtkvmtkPolyDataLaplaceBeltramiStencil::ComputeBoundaryWeights(vtkDataSet* dataSet, vtkIdType pointId, vtkIdType boundaryPointId, vtkIdType boundaryNeighborPointId, double &boundaryWeight, double &boundaryNeighborWeight)
   {
   double point[3], point1[3], point2[3];
   double vector1[3], vector2[3];
   double triangleArea;
 
-  if (!this->IsBoundary)
-    return;
-
-  this->DataSet->GetPoint(this->DataSetPointId,point);
-  this->DataSet->GetPoint(boundaryPointId,point1);
-  this->DataSet->GetPoint(boundaryNeighborPointId,point2);
+  dataSet->GetPoint(pointId,point);
+  dataSet->GetPoint(boundaryPointId,point1);
+  dataSet->GetPoint(boundaryNeighborPointId,point2);
 
   vector1[0] = point1[0] - point[0];
   vector1[1] = point1[1] - point[1];
@@ -79,64 +84,85 @@ void vtkvmtkPolyDataLaplaceBeltramiStencil::BuildBoundaryWeights(vtkIdType bound
   }
 
 void vtkvmtkPolyDataLaplaceBeltramiStencil::Build()
+  {
+  this->Superclass::Build();
+
+  vtkvmtkPolyDataLaplaceBeltramiStencil::ComputeWeights(vtkPolyData::SafeDownCast(this->DataSet),this->DataSetPointId,this->NPoints,this->PointIds,this->IsBoundary,this->Weights,this->CenterWeight);
+
+  this->ComputeArea();
+  this->ScaleWithArea();
+  this->ChangeWeightSign();
+  }
+
+void vtkvmtkPolyDataLaplaceBeltramiStencil::ComputeWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, double* weights, double* centerWeight)
   {
   double point[3], point1[3], point2[3];
   double boundaryWeight, boundaryNeighborWeight;
   double cotangent;
   vtkIdType j, firstId, lastId;
 
-  this->Superclass::Build();
-
-  vtkPolyData* pdata = vtkPolyData::SafeDownCast(this->DataSet);
-
-  if (!this->IsBoundary)
+  if (!isBoundary)
     {
     firstId = 0;
-    lastId = this->NPoints-1;
+    lastId = numberOfPoints-1;
     }
   else
     {
     firstId = 1;
-    lastId = this->NPoints-3;
+    lastId = numberOfPoints-3;
     }
 
-  pdata->GetPoint(this->DataSetPointId,point);
+  pdata->GetPoint(pointId,point);
 
-  for (j=0; j<this->NPoints; j++)
-    this->Weights[j] = 0.0;
+  for (j=0; j<numberOfPoints; j++)
+    weights[j] = 0.0;
 
   for (j=firstId; j<=lastId; j++)
     {
-    pdata->GetPoint(this->PointIds[j],point1);
+    pdata->GetPoint(pointIds[j],point1);
     
-    pdata->GetPoint(this->PointIds[(j+1)%this->NPoints],point2);
+    pdata->GetPoint(pointIds[(j+1)%numberOfPoints],point2);
 
     cotangent = vtkvmtkMath::Cotangent(point,point2,point1);
-    this->Weights[j] += cotangent / 2.0;
+    weights[j] += cotangent / 2.0;
 
     cotangent = vtkvmtkMath::Cotangent(point,point1,point2);
-    this->Weights[(j+1)%this->NPoints] += cotangent / 2.0;
+    weights[(j+1)%numberOfPoints] += cotangent / 2.0;
     }
 
-  if (this->IsBoundary)
+  if (isBoundary)
     {
-    this->BuildBoundaryWeights(this->PointIds[0],this->PointIds[1],boundaryWeight,boundaryNeighborWeight);
-    this->Weights[0] += boundaryWeight;
-    this->Weights[1] += boundaryNeighborWeight;
+    vtkvmtkPolyDataLaplaceBeltramiStencil::ComputeBoundaryWeights(pdata,pointId,pointIds[0],pointIds[1],boundaryWeight,boundaryNeighborWeight);
+    weights[0] += boundaryWeight;
+    weights[1] += boundaryNeighborWeight;
 
-    this->BuildBoundaryWeights(this->PointIds[this->NPoints-1],this->PointIds[this->NPoints-2],boundaryWeight,boundaryNeighborWeight);
-    this->Weights[this->NPoints-1] += boundaryWeight;
-    this->Weights[this->NPoints-2] += boundaryNeighborWeight;
+    vtkvmtkPolyDataLaplaceBeltramiStencil::ComputeBoundaryWeights(pdata,pointId,pointIds[numberOfPoints-1],pointIds[numberOfPoints-2],boundaryWeight,boundaryNeighborWeight);
+    weights[numberOfPoints-1] += boundaryWeight;
+    weights[numberOfPoints-2] += boundaryNeighborWeight;
     }
 
-  this->CenterWeight[0] = 0.0;
-  for (j=0; j<this->NPoints; j++)
+  centerWeight[0] = 0.0;
+  for (j=0; j<numberOfPoints; j++)
     {
-    this->CenterWeight[0] += this->Weights[j];
+    centerWeight[0] += weights[j];
     }
-
-  this->ComputeArea();
-  this->ScaleWithArea();
-  this->ChangeWeightSign();
   }
 
+double vtkvmtkPolyDataLaplaceBeltramiStencil::BuildLaplaceBeltramiWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, double areaFactor, int weightScaling, int negateWeights, double* weights, double* centerWeight)
+  {
+  vtkvmtkPolyDataLaplaceBeltramiStencil::ComputeWeights(pdata,pointId,numberOfPoints,pointIds,isBoundary,weights,centerWeight);
+
+  double area = vtkvmtkPolyDataManifoldStencil::ComputeArea(pdata,pointId,numberOfPoints,pointIds,isBoundary);
+
+  if (weightScaling)
+    {
+    vtkvmtkPolyDataManifoldStencil::ScaleWithAreaFactor(area,areaFactor,numberOfPoints,1,weights,centerWeight);
+    }
+
+  if (negateWeights)
+    {
+    vtkvmtkStencil::ChangeWeightSign(numberOfPoints,weights);
+    }
+
+  return area;
+  }
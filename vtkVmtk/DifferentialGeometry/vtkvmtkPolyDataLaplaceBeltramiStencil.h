@@ -43,6 +43,16 @@ protected:
   vtkvmtkPolyDataLaplaceBeltramiStencil();
   ~vtkvmtkPolyDataLaplaceBeltramiStencil() {};
 
+  // Description:
+  // Array versions of Build and BuildBoundaryWeights, for stencils that are
+  // not stored in a stencil instance (see vtkvmtkCompactStencils).
+  // ComputeWeights computes the unscaled weights, BuildLaplaceBeltramiWeights
+  // also scales them with the stencil area times areaFactor and returns the
+  // area.
+  static void ComputeWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, double* weights, double* centerWeight);
+  static void ComputeBoundaryWeights(vtkDataSet* dataSet, vtkIdType pointId, vtkIdType boundaryPointId, vtkIdType boundaryNeighborPointId, double &boundaryWeight, double &boundaryNeighborWeight);
+  static double BuildLaplaceBeltramiWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, double areaFactor, int weightScaling, int negateWeights, double* weights, double* centerWeight);
+
 private:
   vtkvmtkPolyDataLaplaceBeltramiStencil(const vtkvmtkPolyDataLaplaceBeltramiStencil&);  // Not implemented.
   void operator=(const vtkvmtkPolyDataLaplaceBeltramiStencil&);  // Not implemented.
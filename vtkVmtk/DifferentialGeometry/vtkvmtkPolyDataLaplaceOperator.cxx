@@ -0,0 +1,421 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    $RCSfile: vtkvmtkPolyDataLaplaceOperator.cxx,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:46:43 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+#include "vtkvmtkPolyDataLaplaceOperator.h"
+#include "vtkPolyData.h"
+#include "vtkIdList.h"
+#include "vtkDoubleArray.h"
+#include "vtkvmtkDoubleVector.h"
+#include "vtkvmtkCompactStencils.h"
+#include "vtkvmtkPolyDataFELaplaceAssembler.h"
+#include "vtkvmtkSparseMatrix.h"
+#include "vtkvmtkSparseMatrixRow.h"
+#include "vtkvmtkLinearSystem.h"
+#include "vtkvmtkOpenNLLinearSystemSolver.h"
+#include "vtkObjectFactory.h"
+
+
+vtkStandardNewMacro(vtkvmtkPolyDataLaplaceOperator);
+
+vtkCxxSetObjectMacro(vtkvmtkPolyDataLaplaceOperator,DataSet,vtkPolyData);
+
+vtkvmtkPolyDataLaplaceOperator::vtkvmtkPolyDataLaplaceOperator()
+{
+  this->DataSet = NULL;
+  this->SetAssemblyModeToFiniteElements();
+  this->QuadratureOrder = 1;
+  this->ConvergenceTolerance = 1E-6;
+
+  this->StiffnessMatrix = vtkvmtkSparseMatrix::New();
+  this->RHSVector = vtkvmtkDoubleVector::New();
+  this->Built = false;
+
+  this->ConstrainedMatrix = vtkvmtkSparseMatrix::New();
+  this->ConstrainedAllPoints = false;
+}
+
+vtkvmtkPolyDataLaplaceOperator::~vtkvmtkPolyDataLaplaceOperator()
+{
+  if (this->DataSet)
+    {
+    this->DataSet->Delete();
+    this->DataSet = NULL;
+    }
+
+  if (this->StiffnessMatrix)
+    {
+    this->StiffnessMatrix->Delete();
+    this->StiffnessMatrix = NULL;
+    }
+
+  if (this->RHSVector)
+    {
+    this->RHSVector->Delete();
+    this->RHSVector = NULL;
+    }
+
+  if (this->ConstrainedMatrix)
+    {
+    this->ConstrainedMatrix->Delete();
+    this->ConstrainedMatrix = NULL;
+    }
+}
+
+void vtkvmtkPolyDataLaplaceOperator::Build()
+{
+  this->Built = false;
+  this->ConstrainedPointIds.clear();
+  this->ConstrainedBoundaryPointIds.clear();
+
+  if (!this->DataSet)
+    {
+    vtkErrorMacro(<<"No dataset specified.");
+    return;
+    }
+
+  vtkIdType numberOfPoints = this->DataSet->GetNumberOfPoints();
+
+  this->StiffnessMatrix->Initialize();
+
+  if (this->AssemblyMode == VTK_VMTK_ASSEMBLY_STENCILS)
+    {
+    vtkvmtkCompactStencils* stencils = vtkvmtkCompactStencils::New();
+    stencils->SetStencilTypeToFELaplaceBeltramiStencil();
+    stencils->WeightScalingOff();
+    stencils->NegateWeightsOn();
+    stencils->SetDataSet(this->DataSet);
+    stencils->Build();
+
+    this->StiffnessMatrix->CopyRowsFromStencils(stencils);
+    this->RHSVector->Allocate(numberOfPoints);
+    this->RHSVector->Fill(0.0);
+
+    stencils->Delete();
+    }
+  else if (this->AssemblyMode == VTK_VMTK_ASSEMBLY_FINITEELEMENTS)
+    {
+    vtkvmtkDoubleVector* solutionVector = vtkvmtkDoubleVector::New();
+
+    vtkvmtkPolyDataFELaplaceAssembler* assembler = vtkvmtkPolyDataFELaplaceAssembler::New();
+    assembler->SetDataSet(this->DataSet);
+    assembler->SetMatrix(this->StiffnessMatrix);
+    assembler->SetRHSVector(this->RHSVector);
+    assembler->SetSolutionVector(solutionVector);
+    assembler->SetQuadratureOrder(this->QuadratureOrder);
+    assembler->Build();
+    assembler->Delete();
+
+    solutionVector->Delete();
+    }
+  else
+    {
+    vtkErrorMacro(<<"Unknown assembly mode.");
+    return;
+    }
+
+  this->Built = true;
+  this->BuildTime.Modified();
+}
+
+void vtkvmtkPolyDataLaplaceOperator::BuildIfNeeded()
+{
+  if (!this->Built || this->GetMTime() > this->BuildTime || (this->DataSet && this->DataSet->GetMTime() > this->BuildTime))
+    {
+    this->Build();
+    }
+}
+
+bool vtkvmtkPolyDataLaplaceOperator::IsConstrainedMatrixValid(vtkIdList* pointIds, vtkIdList* boundaryPointIds)
+{
+  if (this->ConstrainedTime < this->BuildTime)
+    {
+    return false;
+    }
+
+  if (this->ConstrainedAllPoints != (pointIds == NULL))
+    {
+    return false;
+    }
+
+  vtkIdType i;
+  if (pointIds)
+    {
+    if (static_cast<vtkIdType>(this->ConstrainedPointIds.size()) != pointIds->GetNumberOfIds())
+      {
+      return false;
+      }
+    for (i=0; i<pointIds->GetNumberOfIds(); i++)
+      {
+      if (this->ConstrainedPointIds[i] != pointIds->GetId(i))
+        {
+        return false;
+        }
+      }
+    }
+
+  if (static_cast<vtkIdType>(this->ConstrainedBoundaryPointIds.size()) != boundaryPointIds->GetNumberOfIds())
+    {
+    return false;
+    }
+  for (i=0; i<boundaryPointIds->GetNumberOfIds(); i++)
+    {
+    if (this->ConstrainedBoundaryPointIds[i] != boundaryPointIds->GetId(i))
+      {
+      return false;
+      }
+    }
+
+  return true;
+}
+
+void vtkvmtkPolyDataLaplaceOperator::BuildConstrainedMatrix(vtkIdList* pointIds, vtkIdList* boundaryPointIds)
+{
+  vtkIdType numberOfPoints = this->DataSet->GetNumberOfPoints();
+  vtkIdType i, j;
+
+  this->ConstrainedAllPoints = (pointIds == NULL);
+  if (pointIds)
+    {
+    this->ConstrainedPointIds.resize(pointIds->GetNumberOfIds());
+    for (i=0; i<pointIds->GetNumberOfIds(); i++)
+      {
+      this->ConstrainedPointIds[i] = pointIds->GetId(i);
+      }
+    }
+  else
+    {
+    this->ConstrainedPointIds.resize(numberOfPoints);
+    for (i=0; i<numberOfPoints; i++)
+      {
+      this->ConstrainedPointIds[i] = i;
+      }
+    }
+
+  this->ConstrainedBoundaryPointIds.resize(boundaryPointIds->GetNumberOfIds());
+  for (i=0; i<boundaryPointIds->GetNumberOfIds(); i++)
+    {
+    this->ConstrainedBoundaryPointIds[i] = boundaryPointIds->GetId(i);
+    }
+
+  vtkIdType numberOfUnknowns = static_cast<vtkIdType>(this->ConstrainedPointIds.size());
+
+  this->LocalPointIds.assign(numberOfPoints,-1);
+  for (i=0; i<numberOfUnknowns; i++)
+    {
+    this->LocalPointIds[this->ConstrainedPointIds[i]] = i;
+    }
+
+  this->BoundaryNodes.assign(numberOfUnknowns,0);
+  for (i=0; i<boundaryPointIds->GetNumberOfIds(); i++)
+    {
+    vtkIdType boundaryPointId = boundaryPointIds->GetId(i);
+    if (boundaryPointId < 0 || boundaryPointId >= numberOfPoints || this->LocalPointIds[boundaryPointId] < 0)
+      {
+      continue;
+      }
+    this->BoundaryNodes[this->LocalPointIds[boundaryPointId]] = 1;
+    }
+
+  // as vtkvmtkDirichletBoundaryConditions, one pass over the rows: boundary
+  // rows become identity rows and boundary columns are dropped
+  this->ConstrainedMatrix->Initialize();
+  this->ConstrainedMatrix->SetNumberOfRows(numberOfUnknowns);
+  for (i=0; i<numberOfUnknowns; i++)
+    {
+    vtkvmtkSparseMatrixRow* row = this->ConstrainedMatrix->GetRow(i);
+    if (this->BoundaryNodes[i])
+      {
+      row->SetDiagonalElement(1.0);
+      continue;
+      }
+    vtkvmtkSparseMatrixRow* stiffnessRow = this->StiffnessMatrix->GetRow(this->ConstrainedPointIds[i]);
+    vtkIdType numberOfRowElements = stiffnessRow->GetNumberOfElements();
+    vtkIdType numberOfConstrainedElements = 0;
+    for (j=0; j<numberOfRowElements; j++)
+      {
+      vtkIdType localId = this->LocalPointIds[stiffnessRow->GetElementId(j)];
+      if (localId >= 0 && !this->BoundaryNodes[localId])
+        {
+        numberOfConstrainedElements++;
+        }
+      }
+    row->SetNumberOfElements(numberOfConstrainedElements);
+    vtkIdType index = 0;
+    for (j=0; j<numberOfRowElements; j++)
+      {
+      vtkIdType localId = this->LocalPointIds[stiffnessRow->GetElementId(j)];
+      if (localId >= 0 && !this->BoundaryNodes[localId])
+        {
+        row->SetElementId(index,localId);
+        row->SetElement(index,stiffnessRow->GetElement(j));
+        index++;
+        }
+      }
+    row->SetDiagonalElement(stiffnessRow->GetDiagonalElement());
+    }
+
+  this->ConstrainedTime.Modified();
+}
+
+int vtkvmtkPolyDataLaplaceOperator::Solve(vtkIdList* pointIds, vtkIdList* boundaryPointIds, vtkDataArray* boundaryValues, vtkDoubleArray* solution)
+{
+  if (!this->DataSet)
+    {
+    vtkErrorMacro(<<"No dataset specified.");
+    return -1;
+    }
+
+  if (!boundaryPointIds || !boundaryValues || !solution)
+    {
+    vtkErrorMacro(<<"BoundaryPointIds, BoundaryValues or solution not set.");
+    return -1;
+    }
+
+  if (boundaryValues->GetNumberOfTuples() < boundaryPointIds->GetNumberOfIds())
+    {
+    vtkErrorMacro(<<"Fewer BoundaryValues than BoundaryPointIds.");
+    return -1;
+    }
+
+  vtkIdType numberOfPoints = this->DataSet->GetNumberOfPoints();
+  vtkIdType i, j;
+
+  if (pointIds)
+    {
+    for (i=0; i<pointIds->GetNumberOfIds(); i++)
+      {
+      if (pointIds->GetId(i) < 0 || pointIds->GetId(i) >= numberOfPoints)
+        {
+        vtkErrorMacro(<<"Point id out of range.");
+        return -1;
+        }
+      }
+    }
+
+  this->BuildIfNeeded();
+  if (!this->Built)
+    {
+    return -1;
+    }
+
+  if (!this->IsConstrainedMatrixValid(pointIds,boundaryPointIds))
+    {
+    this->BuildConstrainedMatrix(pointIds,boundaryPointIds);
+    }
+
+  vtkIdType numberOfUnknowns = static_cast<vtkIdType>(this->ConstrainedPointIds.size());
+
+  solution->SetNumberOfComponents(1);
+  solution->SetNumberOfTuples(numberOfPoints);
+  solution->FillComponent(0,0.0);
+
+  if (numberOfUnknowns == 0)
+    {
+    return 0;
+    }
+
+  // as vtkvmtkDirichletBoundaryConditions, a boundary row takes the last
+  // value given for its node and the first one is moved to the right hand
+  // side of the other rows
+  std::vector<double> rowBoundaryValues(numberOfUnknowns,0.0);
+  std::vector<double> columnBoundaryValues(numberOfUnknowns,0.0);
+  std::vector<char> columnBoundaryValueSet(numberOfUnknowns,0);
+  for (i=0; i<boundaryPointIds->GetNumberOfIds(); i++)
+    {
+    vtkIdType boundaryPointId = boundaryPointIds->GetId(i);
+    if (boundaryPointId < 0 || boundaryPointId >= numberOfPoints || this->LocalPointIds[boundaryPointId] < 0)
+      {
+      continue;
+      }
+    vtkIdType localId = this->LocalPointIds[boundaryPointId];
+    double boundaryValue = boundaryValues->GetComponent(i,0);
+    rowBoundaryValues[localId] = boundaryValue;
+    if (!columnBoundaryValueSet[localId])
+      {
+      columnBoundaryValues[localId] = boundaryValue;
+      columnBoundaryValueSet[localId] = 1;
+      }
+    }
+
+  vtkvmtkDoubleVector* rhsVector = vtkvmtkDoubleVector::New();
+  rhsVector->SetNormTypeToLInf();
+  rhsVector->Allocate(numberOfUnknowns);
+
+  vtkvmtkDoubleVector* solutionVector = vtkvmtkDoubleVector::New();
+  solutionVector->SetNormTypeToLInf();
+  solutionVector->Allocate(numberOfUnknowns);
+  solutionVector->Fill(0.0);
+
+  for (i=0; i<numberOfUnknowns; i++)
+    {
+    if (this->BoundaryNodes[i])
+      {
+      rhsVector->SetElement(i,rowBoundaryValues[i]);
+      continue;
+      }
+    double rhsValue = this->RHSVector->GetElement(this->ConstrainedPointIds[i]);
+    vtkvmtkSparseMatrixRow* stiffnessRow = this->StiffnessMatrix->GetRow(this->ConstrainedPointIds[i]);
+    vtkIdType numberOfRowElements = stiffnessRow->GetNumberOfElements();
+    for (j=0; j<numberOfRowElements; j++)
+      {
+      vtkIdType localId = this->LocalPointIds[stiffnessRow->GetElementId(j)];
+      if (localId >= 0 && this->BoundaryNodes[localId])
+        {
+        rhsValue -= stiffnessRow->GetElement(j) * columnBoundaryValues[localId];
+        }
+      }
+    rhsVector->SetElement(i,rhsValue);
+    }
+
+  vtkvmtkLinearSystem* linearSystem = vtkvmtkLinearSystem::New();
+  linearSystem->SetA(this->ConstrainedMatrix);
+  linearSystem->SetB(rhsVector);
+  linearSystem->SetX(solutionVector);
+
+  vtkvmtkOpenNLLinearSystemSolver* solver = vtkvmtkOpenNLLinearSystemSolver::New();
+  solver->SetLinearSystem(linearSystem);
+  solver->SetConvergenceTolerance(this->ConvergenceTolerance);
+  solver->SetMaximumNumberOfIterations(numberOfPoints);
+  solver->SetSolverTypeToCG();
+  solver->SetPreconditionerTypeToNone();
+  int result = solver->Solve();
+
+  for (i=0; i<numberOfUnknowns; i++)
+    {
+    solution->SetComponent(this->ConstrainedPointIds[i],0,solutionVector->GetElement(i));
+    }
+
+  solver->Delete();
+  linearSystem->Delete();
+  rhsVector->Delete();
+  solutionVector->Delete();
+
+  return result;
+}
+
+void vtkvmtkPolyDataLaplaceOperator::PrintSelf(std::ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "DataSet: " << this->DataSet << endl;
+  os << indent << "AssemblyMode: " << this->AssemblyMode << endl;
+  os << indent << "QuadratureOrder: " << this->QuadratureOrder << endl;
+  os << indent << "ConvergenceTolerance: " << this->ConvergenceTolerance << endl;
+}
@@ -0,0 +1,134 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    $RCSfile: vtkvmtkPolyDataLaplaceOperator.h,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:46:43 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// .NAME vtkvmtkPolyDataLaplaceOperator - Assembled Laplace-Beltrami operator of a surface, reused across harmonic mapping solves.
+// .SECTION Description
+// vtkvmtkPolyDataLaplaceOperator assembles the Laplace-Beltrami stiffness
+// matrix of a surface once, with stencils or finite elements as
+// vtkvmtkPolyDataHarmonicMappingFilter does, and solves Laplace problems with
+// Dirichlet boundary conditions on it. The matrix is reassembled only when
+// the surface, the assembly mode or the quadrature order change.
+//
+// The matrix constrained by the boundary nodes of the last solve is kept as
+// well, so solves with the same boundary nodes and different boundary
+// values only rebuild the right hand side. A solve can be restricted to a
+// subset of the surface points, e.g. the points of one group of a surface
+// whose groups are not connected by any cell: one operator then serves all
+// the groups.
+//
+// .SECTION See Also
+// vtkvmtkPolyDataHarmonicMappingFilter vtkvmtkDirichletBoundaryConditions
+
+#ifndef __vtkvmtkPolyDataLaplaceOperator_h
+#define __vtkvmtkPolyDataLaplaceOperator_h
+
+#include "vtkObject.h"
+#include "vtkvmtkWin32Header.h"
+
+#include <vector>
+
+class vtkPolyData;
+class vtkIdList;
+class vtkDataArray;
+class vtkDoubleArray;
+class vtkvmtkSparseMatrix;
+class vtkvmtkDoubleVector;
+
+class VTK_VMTK_DIFFERENTIAL_GEOMETRY_EXPORT vtkvmtkPolyDataLaplaceOperator : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkvmtkPolyDataLaplaceOperator,vtkObject);
+  void PrintSelf(std::ostream& os, vtkIndent indent) override;
+
+  static vtkvmtkPolyDataLaplaceOperator* New();
+
+  virtual void SetDataSet(vtkPolyData*);
+  vtkGetObjectMacro(DataSet,vtkPolyData);
+
+  vtkSetMacro(AssemblyMode,int);
+  vtkGetMacro(AssemblyMode,int);
+  void SetAssemblyModeToStencils()
+  { this->SetAssemblyMode(VTK_VMTK_ASSEMBLY_STENCILS); }
+  void SetAssemblyModeToFiniteElements()
+  { this->SetAssemblyMode(VTK_VMTK_ASSEMBLY_FINITEELEMENTS); }
+
+  vtkSetMacro(QuadratureOrder,int);
+  vtkGetMacro(QuadratureOrder,int);
+
+  vtkSetMacro(ConvergenceTolerance,double);
+  vtkGetMacro(ConvergenceTolerance,double);
+
+  // Description:
+  // Assemble the stiffness matrix. Called by Solve if the surface or the
+  // assembly parameters changed since the last build.
+  void Build();
+
+  // Description:
+  // Solve the Laplace problem with values boundaryValues on the points
+  // boundaryPointIds and write the solution into the first component of
+  // solution, which is resized to the number of points of the surface.
+  // If pointIds is not NULL only those points are unknowns and the other
+  // points get 0. Returns 0 on success, -1 on error.
+  int Solve(vtkIdList* pointIds, vtkIdList* boundaryPointIds, vtkDataArray* boundaryValues, vtkDoubleArray* solution);
+
+//BTX
+  enum
+    {
+    VTK_VMTK_ASSEMBLY_STENCILS,
+    VTK_VMTK_ASSEMBLY_FINITEELEMENTS
+    };
+//ETX
+
+protected:
+  vtkvmtkPolyDataLaplaceOperator();
+  ~vtkvmtkPolyDataLaplaceOperator();
+
+  void BuildIfNeeded();
+  void BuildConstrainedMatrix(vtkIdList* pointIds, vtkIdList* boundaryPointIds);
+  bool IsConstrainedMatrixValid(vtkIdList* pointIds, vtkIdList* boundaryPointIds);
+
+  vtkPolyData* DataSet;
+  int AssemblyMode;
+  int QuadratureOrder;
+  double ConvergenceTolerance;
+
+  vtkvmtkSparseMatrix* StiffnessMatrix;
+  vtkvmtkDoubleVector* RHSVector;
+  vtkTimeStamp BuildTime;
+  bool Built;
+
+  // stiffness matrix restricted to ConstrainedPointIds, with identity rows
+  // and no columns for the boundary nodes
+  vtkvmtkSparseMatrix* ConstrainedMatrix;
+  vtkTimeStamp ConstrainedTime;
+  bool ConstrainedAllPoints;
+  std::vector<vtkIdType> ConstrainedPointIds;
+  std::vector<vtkIdType> ConstrainedBoundaryPointIds;
+
+  // global to local point ids, -1 for points which are not unknowns
+  std::vector<vtkIdType> LocalPointIds;
+  std::vector<char> BoundaryNodes;
+
+private:
+  vtkvmtkPolyDataLaplaceOperator(const vtkvmtkPolyDataLaplaceOperator&);  // Not implemented.
+  void operator=(const vtkvmtkPolyDataLaplaceOperator&);  // Not implemented.
+};
+
+#endif
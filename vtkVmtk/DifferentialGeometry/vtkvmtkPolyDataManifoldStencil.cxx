@@ -40,50 +40,67 @@ vtkvmtkPolyDataManifoldStencil::vtkvmtkPolyDataManifoldStencil()
 
 void vtkvmtkPolyDataManifoldStencil::ComputeArea()
   {
-  double point[3], point1[3], point2[3];
-  vtkIdType j, numberOfTriangles;
-
   if (this->DataSet==NULL)
     {
     vtkErrorMacro(<<"No DataSet specified.");
     return;
     }
 
-  this->DataSet->GetPoint(this->DataSetPointId,point);
-  this->Area = 0.0;
+  this->Area = vtkvmtkPolyDataManifoldStencil::ComputeArea(this->DataSet,this->DataSetPointId,this->NPoints,this->PointIds,this->IsBoundary);
+  }
+
+double vtkvmtkPolyDataManifoldStencil::ComputeArea(vtkDataSet* dataSet, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary)
+  {
+  double point[3], point1[3], point2[3];
+  vtkIdType j, numberOfTriangles;
 
-  if (!this->IsBoundary)
+  dataSet->GetPoint(pointId,point);
+  double area = 0.0;
+
+  if (!isBoundary)
     {
-    numberOfTriangles = this->NPoints;
+    numberOfTriangles = numberOfPoints;
     }
   else
     {
-    numberOfTriangles = this->NPoints-1;
+    numberOfTriangles = numberOfPoints-1;
     }
 
   for (j=0; j<numberOfTriangles; j++)
     {
-    this->DataSet->GetPoint(this->PointIds[j],point1);
-    this->DataSet->GetPoint(this->PointIds[(j+1)%this->NPoints],point2);
+    dataSet->GetPoint(pointIds[j],point1);
+    dataSet->GetPoint(pointIds[(j+1)%numberOfPoints],point2);
 		
-    this->Area += vtkvmtkMath::TriangleArea(point2,point,point1);
+    area += vtkvmtkMath::TriangleArea(point2,point,point1);
     }
+
+  return area;
   }
 
 void vtkvmtkPolyDataManifoldStencil::ScaleWithAreaFactor(double factor)
+  {
+  if (!this->WeightScaling)
+    {
+    return;
+    }
+
+  vtkvmtkPolyDataManifoldStencil::ScaleWithAreaFactor(this->Area,factor,this->NPoints,this->NumberOfComponents,this->Weights,this->CenterWeight);
+  }
+
+void vtkvmtkPolyDataManifoldStencil::ScaleWithAreaFactor(double area, double factor, vtkIdType numberOfPoints, vtkIdType numberOfComponents, double* weights, double* centerWeight)
   {
   double scale;
 
-  if (this->Area<VTK_VMTK_DOUBLE_TOL)
+  if (area<VTK_VMTK_DOUBLE_TOL)
     {
     scale = 2.0*VTK_VMTK_LARGE_DOUBLE;
     }
   else
     {
-    scale = 1.0 / (this->Area * factor);
+    scale = 1.0 / (area * factor);
     }
 
-  this->ScaleWeights(scale);
+  vtkvmtkStencil::ScaleWeights(scale,numberOfPoints,numberOfComponents,weights,centerWeight);
   }
 
 
@@ -57,6 +57,12 @@ protected:
 
   void ScaleWithAreaFactor(double factor);
 
+  // Description:
+  // Array versions of ComputeArea and ScaleWithAreaFactor, for stencils
+  // that are not stored in a stencil instance (see vtkvmtkCompactStencils).
+  static double ComputeArea(vtkDataSet* dataSet, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary);
+  static void ScaleWithAreaFactor(double area, double factor, vtkIdType numberOfPoints, vtkIdType numberOfComponents, double* weights, double* centerWeight);
+
   double Area;
 
   int UseExtendedNeighborhood;
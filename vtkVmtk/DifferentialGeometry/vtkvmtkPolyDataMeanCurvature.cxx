@@ -20,8 +20,7 @@
 =========================================================================*/
 
 #include "vtkvmtkPolyDataMeanCurvature.h"
-#include "vtkvmtkStencils.h"
-#include "vtkvmtkStencil.h"
+#include "vtkvmtkCompactStencils.h"
 #include "vtkDoubleArray.h"
 #include "vtkPointData.h"
 #include "vtkCellData.h"
@@ -31,6 +30,45 @@
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
+#include "vtkSMPTools.h"
+
+
+// Mean curvature of a range of points. Arrays that are not requested are
+// NULL.
+class vtkvmtkPolyDataMeanCurvature::MeanCurvatureFunctor
+{
+public:
+  MeanCurvatureFunctor(vtkPolyData* input, vtkvmtkCompactStencils* stencils, double* meanCurvatureScalars, double* meanCurvatureNormals)
+    : Input(input), Stencils(stencils), MeanCurvatureScalars(meanCurvatureScalars), MeanCurvatureNormals(meanCurvatureNormals) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    double meanCurvatureVector[3];
+    for (vtkIdType pointId=begin; pointId<end; pointId++)
+      {
+      vtkvmtkPolyDataMeanCurvature::ComputePointMeanCurvatureVector(this->Input,this->Stencils,pointId,meanCurvatureVector);
+
+      if (this->MeanCurvatureScalars)
+        {
+        this->MeanCurvatureScalars[pointId] = vtkMath::Norm(meanCurvatureVector);
+        }
+
+      if (this->MeanCurvatureNormals)
+        {
+        vtkMath::Normalize(meanCurvatureVector);
+        this->MeanCurvatureNormals[3*pointId+0] = meanCurvatureVector[0];
+        this->MeanCurvatureNormals[3*pointId+1] = meanCurvatureVector[1];
+        this->MeanCurvatureNormals[3*pointId+2] = meanCurvatureVector[2];
+        }
+      }
+  }
+
+private:
+  vtkPolyData* Input;
+  vtkvmtkCompactStencils* Stencils;
+  double* MeanCurvatureScalars;
+  double* MeanCurvatureNormals;
+};
 
 
 vtkStandardNewMacro(vtkvmtkPolyDataMeanCurvature);
@@ -41,29 +79,43 @@ vtkvmtkPolyDataMeanCurvature::vtkvmtkPolyDataMeanCurvature()
   this->MeanCurvatureScalarsArrayName = NULL;
   this->MeanCurvatureNormalsArrayName = NULL;
 
+  this->Stencils = NULL;
+
   this->ComputeMeanCurvatureScalars = 0;
   this->ComputeMeanCurvatureNormals = 0;
+  this->ParallelComputation = 1;
 }
 
 vtkvmtkPolyDataMeanCurvature::~vtkvmtkPolyDataMeanCurvature()
 {
   this->ReleaseStencils();
+
+  if (this->MeanCurvatureScalarsArrayName)
+    {
+    delete[] this->MeanCurvatureScalarsArrayName;
+    this->MeanCurvatureScalarsArrayName = NULL;
+    }
+
+  if (this->MeanCurvatureNormalsArrayName)
+    {
+    delete[] this->MeanCurvatureNormalsArrayName;
+    this->MeanCurvatureNormalsArrayName = NULL;
+    }
 }
 
 void vtkvmtkPolyDataMeanCurvature::ReleaseStencils()
 {
   if (this->Stencils)
     {
-    this->Stencils->UnRegister(this);
+    this->Stencils->Delete();
     this->Stencils = NULL;
     }
 }
 
-void vtkvmtkPolyDataMeanCurvature::ComputePointMeanCurvatureVector(vtkPolyData* input, vtkIdType pointId, double* meanCurvatureVector)
+void vtkvmtkPolyDataMeanCurvature::ComputePointMeanCurvatureVector(vtkPolyData* input, vtkvmtkCompactStencils* stencils, vtkIdType pointId, double* meanCurvatureVector)
 {
   double point[3], stencilPoint[3];
   vtkIdType j;
-  vtkvmtkStencil* stencil;
 
   meanCurvatureVector[0] = 0.0;
   meanCurvatureVector[1] = 0.0;
@@ -71,20 +123,23 @@ void vtkvmtkPolyDataMeanCurvature::ComputePointMeanCurvatureVector(vtkPolyData*
 
   input->GetPoint(pointId,point);
 
-  stencil = this->Stencils->GetStencil(pointId);
+  vtkIdType numberOfStencilPoints = stencils->GetNumberOfPoints(pointId);
+  const vtkIdType* stencilPointIds = stencils->GetPointIds(pointId);
+  const double* stencilWeights = stencils->GetWeights(pointId);
 
-  for (j=0; j<stencil->GetNumberOfPoints(); j++)
+  for (j=0; j<numberOfStencilPoints; j++)
     {
-    input->GetPoint(stencil->GetPointId(j),stencilPoint);
+    input->GetPoint(stencilPointIds[j],stencilPoint);
 
-    meanCurvatureVector[0] += stencil->GetWeight(j) * stencilPoint[0];
-    meanCurvatureVector[1] += stencil->GetWeight(j) * stencilPoint[1];
-    meanCurvatureVector[2] += stencil->GetWeight(j) * stencilPoint[2];
+    meanCurvatureVector[0] += stencilWeights[j] * stencilPoint[0];
+    meanCurvatureVector[1] += stencilWeights[j] * stencilPoint[1];
+    meanCurvatureVector[2] += stencilWeights[j] * stencilPoint[2];
     }
 
-  meanCurvatureVector[0] += stencil->GetCenterWeight() * point[0];
-  meanCurvatureVector[1] += stencil->GetCenterWeight() * point[1];
-  meanCurvatureVector[2] += stencil->GetCenterWeight() * point[2];
+  double centerWeight = stencils->GetCenterWeight(pointId);
+  meanCurvatureVector[0] += centerWeight * point[0];
+  meanCurvatureVector[1] += centerWeight * point[1];
+  meanCurvatureVector[2] += centerWeight * point[2];
 
   meanCurvatureVector[0] *= 0.5;
   meanCurvatureVector[1] *= 0.5;
@@ -105,8 +160,7 @@ int vtkvmtkPolyDataMeanCurvature::RequestData(
   vtkPolyData *output = vtkPolyData::SafeDownCast(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
-  vtkIdType pointId, numberOfPoints;
-  double meanCurvatureVector[3], meanCurvature;
+  vtkIdType numberOfPoints;
   vtkDoubleArray* meanCurvatureScalarsArray = NULL;
   vtkDoubleArray* meanCurvatureNormalsArray = NULL;
 
@@ -122,9 +176,12 @@ int vtkvmtkPolyDataMeanCurvature::RequestData(
     return 1;
     }
 
-  this->Stencils = vtkvmtkStencils::New();
-  this->Stencils->SetItemType(this->StencilType);
+  this->ReleaseStencils();
+
+  this->Stencils = vtkvmtkCompactStencils::New();
+  this->Stencils->SetStencilType(this->StencilType);
   this->Stencils->SetDataSet(input);
+  this->Stencils->SetParallelBuild(this->ParallelComputation);
   this->Stencils->Build();
 
   if (this->ComputeMeanCurvatureScalars)
@@ -133,8 +190,6 @@ int vtkvmtkPolyDataMeanCurvature::RequestData(
     meanCurvatureScalarsArray->SetName(this->MeanCurvatureScalarsArrayName);
     meanCurvatureScalarsArray->SetNumberOfTuples(input->GetNumberOfPoints());
     meanCurvatureScalarsArray->FillComponent(0,0.0);
-    meanCurvatureScalarsArray->Register(this);
-    meanCurvatureScalarsArray->Delete();
     }
 
   if (this->ComputeMeanCurvatureNormals)
@@ -146,27 +201,21 @@ int vtkvmtkPolyDataMeanCurvature::RequestData(
     meanCurvatureNormalsArray->FillComponent(0,0.0);
     meanCurvatureNormalsArray->FillComponent(1,0.0);
     meanCurvatureNormalsArray->FillComponent(2,0.0);
-    meanCurvatureNormalsArray->Register(this);
-    meanCurvatureNormalsArray->Delete();
     }
 
   numberOfPoints = input->GetNumberOfPoints();
 
-  for (pointId=0; pointId<numberOfPoints; pointId++)
-    {
-    this->ComputePointMeanCurvatureVector(input,pointId,meanCurvatureVector);
-
-    if (this->ComputeMeanCurvatureScalars)
-      {
-      meanCurvature = vtkMath::Norm(meanCurvatureVector);
-      meanCurvatureScalarsArray->SetComponent(pointId,0,meanCurvature);
-      }
+  MeanCurvatureFunctor functor(input,this->Stencils,
+    meanCurvatureScalarsArray ? meanCurvatureScalarsArray->GetPointer(0) : NULL,
+    meanCurvatureNormalsArray ? meanCurvatureNormalsArray->GetPointer(0) : NULL);
 
-    if (this->ComputeMeanCurvatureNormals)
-      {
-      vtkMath::Normalize(meanCurvatureVector);
-      meanCurvatureNormalsArray->SetTuple(pointId,meanCurvatureVector);
-      }
+  if (this->ParallelComputation)
+    {
+    vtkSMPTools::For(0,numberOfPoints,functor);
+    }
+  else
+    {
+    functor(0,numberOfPoints);
     }
 
   output->CopyStructure(input);
@@ -177,12 +226,14 @@ int vtkvmtkPolyDataMeanCurvature::RequestData(
     {
     output->GetPointData()->AddArray(meanCurvatureScalarsArray);
     output->GetPointData()->SetActiveScalars(this->MeanCurvatureScalarsArrayName);
+    meanCurvatureScalarsArray->Delete();
     }
 
   if (this->ComputeMeanCurvatureNormals)
     {
     output->GetPointData()->AddArray(meanCurvatureNormalsArray);
     output->GetPointData()->SetActiveNormals(this->MeanCurvatureNormalsArrayName);
+    meanCurvatureNormalsArray->Delete();
     }
  
   return 1;
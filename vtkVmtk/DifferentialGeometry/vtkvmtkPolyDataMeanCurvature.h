@@ -20,17 +20,22 @@
 =========================================================================*/
 // .NAME vtkvmtkPolyDataMeanCurvature - Compute the mean curvature and mean curvature normals of surface point neighborhoods with a particular stencil applied.
 // .SECTION Description
-// ..
+// The mean curvature vector of a point is half the stencil weighted
+// combination of the point and its neighbors. The stencils are stored in a
+// vtkvmtkCompactStencils; with ParallelComputation on, the stencils are built
+// and the points processed concurrently.
 
 #ifndef __vtkvmtkPolyDataMeanCurvature_h
 #define __vtkvmtkPolyDataMeanCurvature_h
 
 #include "vtkObject.h"
 #include "vtkPolyDataAlgorithm.h"
-#include "vtkvmtkStencils.h"
+#include "vtkvmtkConstants.h"
 //#include "vtkvmtkDifferentialGeometryWin32Header.h"
 #include "vtkvmtkWin32Header.h"
 
+class vtkvmtkCompactStencils;
+
 class VTK_VMTK_DIFFERENTIAL_GEOMETRY_EXPORT vtkvmtkPolyDataMeanCurvature : public vtkPolyDataAlgorithm
 {
 public:
@@ -63,22 +68,31 @@ public:
   vtkGetMacro(ComputeMeanCurvatureNormals,int);
   vtkBooleanMacro(ComputeMeanCurvatureNormals,int);
 
+  vtkSetMacro(ParallelComputation,int);
+  vtkGetMacro(ParallelComputation,int);
+  vtkBooleanMacro(ParallelComputation,int);
+
 protected:
   vtkvmtkPolyDataMeanCurvature();
   ~vtkvmtkPolyDataMeanCurvature();
 
   virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
 
-  void ComputePointMeanCurvatureVector(vtkPolyData* input, vtkIdType pointId, double* meanCurvatureVector);
+//BTX
+  class MeanCurvatureFunctor;
+//ETX
+
+  static void ComputePointMeanCurvatureVector(vtkPolyData* input, vtkvmtkCompactStencils* stencils, vtkIdType pointId, double* meanCurvatureVector);
   void ReleaseStencils();
 
   char* MeanCurvatureScalarsArrayName;
   char* MeanCurvatureNormalsArrayName;
   int StencilType;
-  vtkvmtkStencils* Stencils;
+  vtkvmtkCompactStencils* Stencils;
 
   int ComputeMeanCurvatureScalars;
   int ComputeMeanCurvatureNormals;
+  int ParallelComputation;
 
 private:
   vtkvmtkPolyDataMeanCurvature(const vtkvmtkPolyDataMeanCurvature&);  // Not implemented.
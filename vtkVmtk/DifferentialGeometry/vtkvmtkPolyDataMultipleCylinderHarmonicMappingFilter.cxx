@@ -31,6 +31,11 @@
 #include "vtkVersion.h"
 
 #include "vtkvmtkPolyDataBranchUtilities.h"
+#include "vtkvmtkPolyDataGroupPartition.h"
+#include "vtkvmtkPolyDataLaplaceOperator.h"
+
+#include <map>
+#include <vector>
 
 
 vtkStandardNewMacro(vtkvmtkPolyDataMultipleCylinderHarmonicMappingFilter);
@@ -102,15 +107,52 @@ int vtkvmtkPolyDataMultipleCylinderHarmonicMappingFilter::RequestData(
   vtkvmtkPolyDataBranchUtilities::GetGroupsIdList(input,this->GroupIdsArrayName,groupIds);
 
   int i, j;
+  vtkvmtkPolyDataGroupPartition* groupPartition = vtkvmtkPolyDataGroupPartition::New();
+  groupPartition->SetSurface(input);
+  groupPartition->SetGroupIdsArrayName(this->GroupIdsArrayName);
+  groupPartition->Build();
+
+  // the polygons of all the groups share no point across groups, so the
+  // operator assembled on them once restricts to the operator of each group
+  vtkCellArray* groupedPolys = vtkCellArray::New();
+  vtkIdList* groupCellIds = vtkIdList::New();
+  vtkIdType npts;
+  const vtkIdType *pts;
+  for (i=0; i<groupIds->GetNumberOfIds(); i++)
+    {
+    groupPartition->GetGroupCellIds(groupIds->GetId(i),groupCellIds);
+    for (j=0; j<groupCellIds->GetNumberOfIds(); j++)
+      {
+      input->GetCellPoints(groupCellIds->GetId(j),npts,pts);
+      groupedPolys->InsertNextCell(npts,pts);
+      }
+    }
+  groupCellIds->Delete();
+
+  vtkPolyData* groupedSurface = vtkPolyData::New();
+  groupedSurface->SetPoints(input->GetPoints());
+  groupedSurface->SetPolys(groupedPolys);
+  groupedPolys->Delete();
+
+  vtkvmtkPolyDataLaplaceOperator* laplaceOperator = vtkvmtkPolyDataLaplaceOperator::New();
+  laplaceOperator->SetDataSet(groupedSurface);
+
+  std::map<vtkIdType,std::vector<vtkIdType> > groupPointIds;
+  for (j=0; j<numberOfInputPoints; j++)
+    {
+    groupPointIds[static_cast<int>(groupIdsArray->GetComponent(j,0))].push_back(j);
+    }
+
   for (i=0; i<groupIds->GetNumberOfIds(); i++)
     {
     vtkIdType groupId = groupIds->GetId(i);
     vtkPolyData* cylinder = vtkPolyData::New();
-    vtkvmtkPolyDataBranchUtilities::ExtractGroup(input,this->GroupIdsArrayName,groupId,false,cylinder);
+    groupPartition->ExtractGroup(groupId,false,cylinder);
   
     vtkvmtkPolyDataCylinderHarmonicMappingFilter* mappingFilter = vtkvmtkPolyDataCylinderHarmonicMappingFilter::New();
     mappingFilter->SetInputData(cylinder);
     mappingFilter->SetHarmonicMappingArrayName(this->HarmonicMappingArrayName);
+    mappingFilter->SetLaplaceOperator(laplaceOperator);
     mappingFilter->Update();
 
     vtkDataArray* cylinderMappingArray = mappingFilter->GetOutput()->GetPointData()->GetArray(this->HarmonicMappingArrayName);
@@ -118,18 +160,16 @@ int vtkvmtkPolyDataMultipleCylinderHarmonicMappingFilter::RequestData(
     if (!cylinderMappingArray)
       {
       mappingFilter->Delete();
+      cylinder->Delete();
       continue;
       }
 
+    const std::vector<vtkIdType>& currentGroupPointIds = groupPointIds[groupId];
     double mappingValue;
-    for (j=0; j<numberOfInputPoints; j++)
+    for (j=0; j<static_cast<int>(currentGroupPointIds.size()); j++)
       {
-      vtkIdType currentGroupId = static_cast<int>(groupIdsArray->GetComponent(j,0));
-      if (currentGroupId == groupId)
-        {
-        mappingValue = cylinderMappingArray->GetComponent(j,0);
-        harmonicMappingArray->SetComponent(j,0,mappingValue);
-        }
+      mappingValue = cylinderMappingArray->GetComponent(currentGroupPointIds[j],0);
+      harmonicMappingArray->SetComponent(currentGroupPointIds[j],0,mappingValue);
       }
 
     mappingFilter->Delete();
@@ -139,6 +179,9 @@ int vtkvmtkPolyDataMultipleCylinderHarmonicMappingFilter::RequestData(
   output->GetPointData()->AddArray(harmonicMappingArray);
   
   groupIds->Delete();
+  groupPartition->Delete();
+  groupedSurface->Delete();
+  laplaceOperator->Delete();
   harmonicMappingArray->Delete();
 
   return 1;
@@ -20,11 +20,10 @@
 =========================================================================*/
 
 #include "vtkvmtkPolyDataStencilFlowFilter.h"
-#include "vtkvmtkStencils.h"
-#include "vtkvmtkStencil.h"
-#include "vtkIdList.h"
-#include "vtkCell.h"
-#include "vtkCellLocator.h"
+#include "vtkvmtkCompactStencils.h"
+#include "vtkGenericCell.h"
+#include "vtkStaticCellLocator.h"
+#include "vtkPoints.h"
 #include "vtkPolyData.h"
 #include "vtkPointData.h"
 #include "vtkCellData.h"
@@ -33,6 +32,164 @@
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPThreadLocalObject.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+// Spreads the lower 21 bits of x so that they take every third bit.
+unsigned long long SpreadBits(unsigned long long x)
+{
+  x &= 0x1fffffULL;
+  x = (x | (x << 32)) & 0x1f00000000ffffULL;
+  x = (x | (x << 16)) & 0x1f0000ff0000ffULL;
+  x = (x | (x << 8)) & 0x100f00f00f00f00fULL;
+  x = (x | (x << 4)) & 0x10c30c30c30c30c3ULL;
+  x = (x | (x << 2)) & 0x1249249249249249ULL;
+  return x;
+}
+
+// Point ids sorted by the Morton code of their coordinates in the bounding
+// box, so that consecutive points in the order are close in space.
+void ComputeSpatialOrder(vtkPoints* points, std::vector<vtkIdType>& order)
+{
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  double bounds[6];
+  points->GetBounds(bounds);
+  double scale[3];
+  for (int k=0; k<3; k++)
+    {
+    double length = bounds[2*k+1] - bounds[2*k];
+    scale[k] = length > 0.0 ? 2097151.0 / length : 0.0;
+    }
+
+  std::vector<std::pair<unsigned long long,vtkIdType> > codes(numberOfPoints);
+  double point[3];
+  for (vtkIdType i=0; i<numberOfPoints; i++)
+    {
+    points->GetPoint(i,point);
+    unsigned long long code = 0;
+    for (int k=0; k<3; k++)
+      {
+      code |= SpreadBits(static_cast<unsigned long long>((point[k] - bounds[2*k]) * scale[k])) << k;
+      }
+    codes[i] = std::make_pair(code,i);
+    }
+  std::sort(codes.begin(),codes.end());
+
+  order.resize(numberOfPoints);
+  for (vtkIdType i=0; i<numberOfPoints; i++)
+    {
+    order[i] = codes[i].second;
+    }
+}
+
+// Jacobi update of a range of points taken in spatial order: displacements
+// are computed from the positions of the previous iteration, read from
+// Points, and the new positions are written to NewPoints. If Locator is not
+// NULL the new positions are projected on Surface, starting from the cell
+// the point was last projected on.
+class StencilFlowFunctor
+{
+public:
+  StencilFlowFunctor(vtkvmtkCompactStencils* stencils, vtkPoints* points, const vtkIdType* order, double* newPoints, double relaxationFactor, double maximumDisplacement, bool processBoundary, vtkPolyData* surface, vtkStaticCellLocator* locator, vtkIdType* constrainCellIds)
+    : Stencils(stencils), Points(points), Order(order), NewPoints(newPoints), RelaxationFactor(relaxationFactor), MaximumDisplacement(maximumDisplacement), ProcessBoundary(processBoundary), Surface(surface), Locator(locator), ConstrainCellIds(constrainCellIds) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkGenericCell* cell = this->Cells.Local();
+    std::vector<double>& weights = this->Weights.Local();
+    double displacement[3], stencilPoint[3], weight;
+    double point[3], newPoint[3];
+    for (vtkIdType k=begin; k<end; k++)
+      {
+      vtkIdType pointId = this->Order[k];
+      this->Points->GetPoint(pointId,point);
+      double* newPointPtr = this->NewPoints + 3*pointId;
+
+      if (this->Stencils->GetIsBoundary(pointId) && (!this->ProcessBoundary))
+        {
+        newPointPtr[0] = point[0];
+        newPointPtr[1] = point[1];
+        newPointPtr[2] = point[2];
+        continue;
+        }
+
+      displacement[0] = displacement[1] = displacement[2] = 0.0;
+      vtkIdType numberOfStencilPoints = this->Stencils->GetNumberOfPoints(pointId);
+      const vtkIdType* stencilPointIds = this->Stencils->GetPointIds(pointId);
+      const double* stencilWeights = this->Stencils->GetWeights(pointId);
+      for (vtkIdType j=0; j<numberOfStencilPoints; j++)
+        {
+        this->Points->GetPoint(stencilPointIds[j],stencilPoint);
+        weight = stencilWeights[j];
+        displacement[0] += weight * stencilPoint[0];
+        displacement[1] += weight * stencilPoint[1];
+        displacement[2] += weight * stencilPoint[2];
+        }
+      weight = this->Stencils->GetCenterWeight(pointId);
+      displacement[0] -= weight * point[0];
+      displacement[1] -= weight * point[1];
+      displacement[2] -= weight * point[2];
+
+      if (vtkMath::Norm(displacement) > this->MaximumDisplacement)
+        {
+        vtkMath::Normalize(displacement);
+        displacement[0] *= this->MaximumDisplacement;
+        displacement[1] *= this->MaximumDisplacement;
+        displacement[2] *= this->MaximumDisplacement;
+        }
+
+      newPoint[0] = point[0] + this->RelaxationFactor * displacement[0];
+      newPoint[1] = point[1] + this->RelaxationFactor * displacement[1];
+      newPoint[2] = point[2] + this->RelaxationFactor * displacement[2];
+
+      if (this->Locator)
+        {
+        double closestPoint[3];
+        vtkIdType cellId;
+        int subId;
+        double dist2, pcoords[3];
+        this->Surface->GetCell(this->ConstrainCellIds[pointId],cell);
+        weights.resize(cell->GetNumberOfPoints());
+        if (cell->EvaluatePosition(newPoint,closestPoint,subId,pcoords,dist2,&weights[0])==0)
+          {
+          this->Locator->FindClosestPoint(newPoint,closestPoint,cell,cellId,subId,dist2);
+          this->ConstrainCellIds[pointId] = cellId;
+          }
+        newPoint[0] = closestPoint[0];
+        newPoint[1] = closestPoint[1];
+        newPoint[2] = closestPoint[2];
+        }
+
+      newPointPtr[0] = newPoint[0];
+      newPointPtr[1] = newPoint[1];
+      newPointPtr[2] = newPoint[2];
+      }
+  }
+
+private:
+  vtkvmtkCompactStencils* Stencils;
+  vtkPoints* Points;
+  const vtkIdType* Order;
+  double* NewPoints;
+  double RelaxationFactor;
+  double MaximumDisplacement;
+  bool ProcessBoundary;
+  vtkPolyData* Surface;
+  vtkStaticCellLocator* Locator;
+  vtkIdType* ConstrainCellIds;
+  mutable vtkSMPThreadLocalObject<vtkGenericCell> Cells;
+  mutable vtkSMPThreadLocal<std::vector<double> > Weights;
+};
+
+}
 
 
 vtkStandardNewMacro(vtkvmtkPolyDataStencilFlowFilter);
@@ -47,6 +204,8 @@ vtkvmtkPolyDataStencilFlowFilter::vtkvmtkPolyDataStencilFlowFilter()
   this->MaximumDisplacement = VTK_VMTK_LARGE_DOUBLE;
   this->ProcessBoundary = 0;
   this->ConstrainOnSurface = 0;
+  this->RecomputeWeights = 1;
+  this->ParallelIterations = 1;
 }
 
 vtkvmtkPolyDataStencilFlowFilter::~vtkvmtkPolyDataStencilFlowFilter()
@@ -58,7 +217,7 @@ void vtkvmtkPolyDataStencilFlowFilter::ReleaseStencils()
 {
   if (this->Stencils)
     {
-    this->Stencils->UnRegister(this);
+    this->Stencils->Delete();
     this->Stencils = NULL;
     }
 }
@@ -81,105 +240,90 @@ int vtkvmtkPolyDataStencilFlowFilter::RequestData(
   output->GetCellData()->PassData(input->GetCellData());
   output->GetFieldData()->PassData(input->GetFieldData());
 
+  if (!input->GetPoints())
+    {
+    return 1;
+    }
+
+  // the output gets its own points, so that the input is left untouched and
+  // can be used as the constraint surface
+  vtkPoints* outputPoints = vtkPoints::New();
+  outputPoints->DeepCopy(input->GetPoints());
+  output->SetPoints(outputPoints);
+  outputPoints->Delete();
+
   if (this->Stencils)
     {
     this->ReleaseStencils();
     }
   
-  this->Stencils = vtkvmtkStencils::New();
-  this->Stencils->SetItemType(this->StencilType);
-  this->Stencils->SetDataSet(input);
-  this->Stencils->ReallocateOnBuildOff();
+  this->Stencils = vtkvmtkCompactStencils::New();
+  this->Stencils->SetStencilType(this->StencilType);
+  this->Stencils->SetDataSet(output);
   this->Stencils->WeightScalingOn();
+  this->Stencils->SetParallelBuild(this->ParallelIterations);
+
+  vtkIdType numberOfPoints = input->GetNumberOfPoints();
 
-  vtkCellLocator *cellLocator = NULL;
-  double* weights = NULL;
+  vtkStaticCellLocator *cellLocator = NULL;
+  std::vector<vtkIdType> constrainCellIds;
   if (this->ConstrainOnSurface)
     {
-    weights = new double[input->GetMaxCellSize()];
-    cellLocator = vtkCellLocator::New();
+    input->BuildCells();
+    cellLocator = vtkStaticCellLocator::New();
     cellLocator->SetDataSet(input);
     cellLocator->BuildLocator();
+    constrainCellIds.assign(numberOfPoints,0);
     }
-  
-  vtkIdType numberOfPoints = input->GetNumberOfPoints();
 
-  double displacement[3], stencilPoint[3], weight;
-  double point[3], newPoint[3];
+  // points are visited in spatial order, so that the points updated by a
+  // thread and their neighbors are close in memory for meshes whose point
+  // ids do not follow the geometry
+  std::vector<vtkIdType> order;
+  ComputeSpatialOrder(outputPoints,order);
+
+  std::vector<double> newPoints(3*numberOfPoints);
+
+  StencilFlowFunctor functor(this->Stencils,outputPoints,order.data(),newPoints.data(),this->RelaxationFactor,this->MaximumDisplacement,this->ProcessBoundary!=0,input,cellLocator,constrainCellIds.data());
 
-  vtkIdList* constrainCellIds = vtkIdList::New();
-  constrainCellIds->SetNumberOfIds(input->GetNumberOfPoints());
-  for (vtkIdType pointId=0; pointId<numberOfPoints; pointId++)
+  // the weights are recomputed on the displaced points unless
+  // RecomputeWeights is off; 1-ring neighborhoods only depend on the
+  // connectivity and are built once, extended neighborhoods depend on the
+  // point coordinates and are rebuilt along with the weights
+  bool rebuildNeighborhoods = this->Stencils->GetUsesExtendedNeighborhoods();
+  if (!rebuildNeighborhoods)
     {
-    constrainCellIds->SetId(pointId,0);
+    this->Stencils->BuildNeighborhoods();
     }
- 
+
   for (int iteration=0; iteration<this->NumberOfIterations; iteration++)
     {
-    this->Stencils->Build();
-    for (vtkIdType pointId=0; pointId<numberOfPoints; pointId++)
+    if (iteration==0 || this->RecomputeWeights)
       {
-      vtkvmtkStencil* stencil = this->Stencils->GetStencil(pointId);
-      if (stencil->GetIsBoundary() && (!this->ProcessBoundary))
-        {
-        continue;
-        }      
-      displacement[0] = displacement[1] = displacement[2] = 0.0;
-      int numberOfStencilPoints = stencil->GetNumberOfPoints();
-      for (int j=0; j<numberOfStencilPoints; j++)
+      if (rebuildNeighborhoods)
         {
-        output->GetPoint(stencil->GetPointId(j),stencilPoint);
-        weight = stencil->GetWeight(j);
-        displacement[0] += weight * stencilPoint[0];
-        displacement[1] += weight * stencilPoint[1];
-        displacement[2] += weight * stencilPoint[2];
+        this->Stencils->BuildNeighborhoods();
         }
-      weight = stencil->GetCenterWeight();
-      output->GetPoint(pointId,point);
-      displacement[0] -= weight * point[0];
-      displacement[1] -= weight * point[1];
-      displacement[2] -= weight * point[2];
-      
-      if (vtkMath::Norm(displacement) > this->MaximumDisplacement)
-        {
-        vtkMath::Normalize(displacement);
-        displacement[0] *= this->MaximumDisplacement;
-        displacement[1] *= this->MaximumDisplacement;
-        displacement[2] *= this->MaximumDisplacement;
-        }
-      
-      newPoint[0] = point[0] + this->RelaxationFactor * displacement[0];
-      newPoint[1] = point[1] + this->RelaxationFactor * displacement[1];
-      newPoint[2] = point[2] + this->RelaxationFactor * displacement[2];
+      this->Stencils->BuildWeights();
+      }
 
-      if (this->ConstrainOnSurface)
-        {
-        double closestPoint[3];
-        vtkIdType cellId;
-        int subId;
-        double dist2, pcoords[3];
-        if (input->GetCell(constrainCellIds->GetId(pointId))->EvaluatePosition(newPoint,closestPoint,subId,pcoords,dist2,weights)==0)
-          {
-          cellLocator->FindClosestPoint(newPoint,closestPoint,cellId,subId,dist2);
-          constrainCellIds->SetId(pointId,cellId);
-          }
-        newPoint[0] = closestPoint[0];
-        newPoint[1] = closestPoint[1];
-        newPoint[2] = closestPoint[2];
-        }
-      
-      output->GetPoints()->SetPoint(pointId,newPoint);
+    if (this->ParallelIterations)
+      {
+      vtkSMPTools::For(0,numberOfPoints,functor);
+      }
+    else
+      {
+      functor(0,numberOfPoints);
+      }
+
+    for (vtkIdType pointId=0; pointId<numberOfPoints; pointId++)
+      {
+      outputPoints->SetPoint(pointId,&newPoints[3*pointId]);
       }
     }
 
-  constrainCellIds->Delete();
-  
-  if (weights)
-  {
-    delete[] weights;
-    weights = NULL;
-  }
-  
+  outputPoints->Modified();
+
   if (cellLocator)
     {
     cellLocator->Delete();
@@ -20,7 +20,17 @@
 =========================================================================*/
 // .NAME vtkvmtkPolyDataStencilFlowFilter - Displace points of a surface with an iterative algorithm based on stencil weighting. 
 // .SECTION Description
-// ..
+// Each iteration moves every point by RelaxationFactor times the stencil
+// weighted combination of its neighbors, optionally clamped to
+// MaximumDisplacement and projected back on the input surface. The update
+// is Jacobi-style: all the displacements of an iteration are computed from
+// the positions of the previous one, so with ParallelIterations on the points
+// are updated concurrently and the result does not depend on the number of
+// threads. The input points are not modified.
+//
+// The stencil neighborhoods are built once. The weights are recomputed on
+// the displaced points at every iteration, or only on the input points if
+// RecomputeWeights is off.
 
 #ifndef __vtkvmtkPolyDataStencilFlowFilter_h
 #define __vtkvmtkPolyDataStencilFlowFilter_h
@@ -30,7 +40,7 @@
 //#include "vtkvmtkDifferentialGeometryWin32Header.h"
 #include "vtkvmtkWin32Header.h"
 
-class vtkvmtkStencils;
+class vtkvmtkCompactStencils;
 
 class VTK_VMTK_DIFFERENTIAL_GEOMETRY_EXPORT vtkvmtkPolyDataStencilFlowFilter : public vtkPolyDataAlgorithm
 {
@@ -65,6 +75,14 @@ public:
 
   vtkSetMacro(MaximumDisplacement,double);
   vtkGetMacro(MaximumDisplacement,double);
+
+  vtkSetMacro(RecomputeWeights,int);
+  vtkGetMacro(RecomputeWeights,int);
+  vtkBooleanMacro(RecomputeWeights,int);
+
+  vtkSetMacro(ParallelIterations,int);
+  vtkGetMacro(ParallelIterations,int);
+  vtkBooleanMacro(ParallelIterations,int);
   
 protected:
   vtkvmtkPolyDataStencilFlowFilter();
@@ -75,7 +93,7 @@ protected:
   void ReleaseStencils();
   
   int StencilType;
-  vtkvmtkStencils* Stencils;
+  vtkvmtkCompactStencils* Stencils;
 
   int NumberOfIterations;
   double RelaxationFactor;
@@ -84,6 +102,8 @@ protected:
 
   int ProcessBoundary;
   int ConstrainOnSurface;
+  int RecomputeWeights;
+  int ParallelIterations;
   
 private:
   vtkvmtkPolyDataStencilFlowFilter(const vtkvmtkPolyDataStencilFlowFilter&);  // Not implemented.
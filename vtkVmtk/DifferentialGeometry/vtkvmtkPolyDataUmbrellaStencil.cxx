@@ -34,12 +34,19 @@ void vtkvmtkPolyDataUmbrellaStencil::Build()
   {
   this->Superclass::Build();
 
-  this->Area = 1.0;
-  for (vtkIdType i=0; i<this->NPoints; i++)
+  this->Area = vtkvmtkPolyDataUmbrellaStencil::BuildWeights(vtkPolyData::SafeDownCast(this->DataSet),this->DataSetPointId,this->NPoints,this->PointIds,this->IsBoundary,this->WeightScaling,this->NegateWeights,this->Weights,this->CenterWeight);
+  }
+
+double vtkvmtkPolyDataUmbrellaStencil::BuildWeights(vtkPolyData* vtkNotUsed(pdata), vtkIdType vtkNotUsed(pointId), vtkIdType numberOfPoints, const vtkIdType* vtkNotUsed(pointIds), bool vtkNotUsed(isBoundary), int vtkNotUsed(weightScaling), int negateWeights, double* weights, double* centerWeight)
+  {
+  for (vtkIdType i=0; i<numberOfPoints; i++)
     {
-    this->Weights[i] = 1.0/double(this->NPoints);
+    weights[i] = 1.0/double(numberOfPoints);
     }
-  this->CenterWeight[0] = 1.0;
-  this->ChangeWeightSign();
+  centerWeight[0] = 1.0;
+  if (negateWeights)
+    {
+    vtkvmtkStencil::ChangeWeightSign(numberOfPoints,weights);
+    }
+  return 1.0;
   }
-
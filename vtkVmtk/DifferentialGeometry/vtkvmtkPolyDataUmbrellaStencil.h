@@ -41,6 +41,12 @@ public:
 
   void Build() override;
 
+  // Description:
+  // Build the weights of the stencil of point pointId of pdata, whose
+  // neighborhood is the numberOfPoints ids in pointIds, into weights and
+  // centerWeight without instantiating a stencil. Returns the stencil area.
+  static double BuildWeights(vtkPolyData* pdata, vtkIdType pointId, vtkIdType numberOfPoints, const vtkIdType* pointIds, bool isBoundary, int weightScaling, int negateWeights, double* weights, double* centerWeight);
+
 protected:
   vtkvmtkPolyDataUmbrellaStencil();
   ~vtkvmtkPolyDataUmbrellaStencil() {};
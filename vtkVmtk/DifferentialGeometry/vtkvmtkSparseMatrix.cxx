@@ -105,6 +105,36 @@ void vtkvmtkSparseMatrix::CopyRowsFromStencils(vtkvmtkStencils *stencils)
     }
 }
 
+void vtkvmtkSparseMatrix::CopyRowsFromStencils(vtkvmtkCompactStencils *stencils)
+{
+  vtkIdType i, j;
+  vtkIdType numberOfStencils;
+  
+  if (stencils==NULL)
+    {
+    vtkErrorMacro(<<"No stencils provided.");
+    return;
+    }
+
+  numberOfStencils = stencils->GetNumberOfStencils();
+
+  this->Initialize();
+  this->SetNumberOfRows(numberOfStencils);
+
+  for (i=0; i<numberOfStencils; i++)
+    {
+    vtkvmtkSparseMatrixRow* row = this->GetRow(i);
+    vtkIdType numberOfStencilPoints = stencils->GetNumberOfPoints(i);
+    row->SetNumberOfElements(numberOfStencilPoints);
+    for (j=0; j<numberOfStencilPoints; j++)
+      {
+      row->SetElementId(j,stencils->GetPointId(i,j));
+      row->SetElement(j,stencils->GetWeight(i,j));
+      }
+    row->SetDiagonalElement(stencils->GetCenterWeight(i));
+    }
+}
+
 void vtkvmtkSparseMatrix::AllocateRowsFromNeighborhoods(vtkvmtkNeighborhoods *neighborhoods, int numberOfVariables)
 {
   if (neighborhoods==NULL)
@@ -240,8 +270,19 @@ void vtkvmtkSparseMatrix::SetElement(vtkIdType i, vtkIdType j, double value)
 
 void vtkvmtkSparseMatrix::AddElement(vtkIdType i, vtkIdType j, double value)
 {
-  double currentValue = this->GetElement(i,j);
-  this->SetElement(i,j,currentValue+value);
+  vtkvmtkSparseMatrixRow* row = this->GetRow(i);
+  if (i == j)
+  {
+    row->SetDiagonalElement(row->GetDiagonalElement()+value);
+    return;
+  }
+  // a single search of the column, shared by the read and the write
+  vtkIdType index = row->GetElementIndex(j);
+  if (index == -1)
+  {
+    return;
+  }
+  row->SetElement(index,row->GetElement(index)+value);
 }
 
 void vtkvmtkSparseMatrix::Multiply(vtkvmtkDoubleVector* x, vtkvmtkDoubleVector* y)
@@ -29,6 +29,7 @@
 #include "vtkvmtkSparseMatrixRow.h"
 #include "vtkvmtkNeighborhoods.h"
 #include "vtkvmtkStencils.h"
+#include "vtkvmtkCompactStencils.h"
 #include "vtkvmtkDoubleVector.h"
 #include "vtkDataSet.h"
 #include "vtkvmtkWin32Header.h"
@@ -49,6 +50,7 @@ public:
 
   vtkGetMacro(NumberOfRows,vtkIdType);
   void CopyRowsFromStencils(vtkvmtkStencils *stencils);
+  void CopyRowsFromStencils(vtkvmtkCompactStencils *stencils);
   void AllocateRowsFromNeighborhoods(vtkvmtkNeighborhoods *neighborhoods, int numberOfVariables=1);
   void AllocateRowsFromDataSet(vtkDataSet *dataSet, int numberOfVariables=1);
   
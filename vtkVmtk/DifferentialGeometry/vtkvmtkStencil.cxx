@@ -57,9 +57,14 @@ void vtkvmtkStencil::ChangeWeightSign()
     return;
     }
   
-  for (int j=0; j<this->NumberOfComponents*this->NPoints; j++)
+  vtkvmtkStencil::ChangeWeightSign(this->NumberOfComponents*this->NPoints,this->Weights);
+}
+
+void vtkvmtkStencil::ChangeWeightSign(vtkIdType numberOfWeights, double* weights)
+{
+  for (vtkIdType j=0; j<numberOfWeights; j++)
     {
-    this->Weights[j] *= -1.0;
+    weights[j] *= -1.0;
     }
 }
 
@@ -77,53 +82,58 @@ void vtkvmtkStencil::ResizePointList(vtkIdType ptId, int size)
 
 void vtkvmtkStencil::ScaleWeights(double factor)
   {
-  vtkIdType j;
-
   if (!this->WeightScaling)
     {
     return;
     }
 
+  vtkvmtkStencil::ScaleWeights(factor,this->NPoints,this->NumberOfComponents,this->Weights,this->CenterWeight);
+  }
+
+void vtkvmtkStencil::ScaleWeights(double factor, vtkIdType numberOfPoints, vtkIdType numberOfComponents, double* weights, double* centerWeight)
+  {
+  vtkIdType j;
+
   if (std::fabs(factor)<VTK_VMTK_DOUBLE_TOL)
     {
-    for (j=0; j<this->NumberOfComponents*this->NPoints; j++)
+    for (j=0; j<numberOfComponents*numberOfPoints; j++)
       {
-      this->Weights[j] = 0.0;
+      weights[j] = 0.0;
       }
-    for (j=0; j<this->NumberOfComponents; j++)
+    for (j=0; j<numberOfComponents; j++)
       {
-      this->CenterWeight[j] = 0.0;
+      centerWeight[j] = 0.0;
       }
     return;
     }
   else if (std::fabs(factor)>VTK_VMTK_LARGE_DOUBLE)
     {
-    for (j=0; j<this->NumberOfComponents*this->NPoints; j++)
+    for (j=0; j<numberOfComponents*numberOfPoints; j++)
       {
-      this->Weights[j] = VTK_VMTK_LARGE_DOUBLE;
+      weights[j] = VTK_VMTK_LARGE_DOUBLE;
       }
-    for (j=0; j<this->NumberOfComponents; j++)
+    for (j=0; j<numberOfComponents; j++)
       {
-      this->CenterWeight[j] = VTK_VMTK_LARGE_DOUBLE;
+      centerWeight[j] = VTK_VMTK_LARGE_DOUBLE;
       }
     return;
     }
 
-  for (j=0; j<this->NumberOfComponents*this->NPoints; j++)
+  for (j=0; j<numberOfComponents*numberOfPoints; j++)
     {
-    this->Weights[j] *= factor;
-    if (std::fabs(this->Weights[j])<VTK_VMTK_DOUBLE_TOL)
+    weights[j] *= factor;
+    if (std::fabs(weights[j])<VTK_VMTK_DOUBLE_TOL)
       {
-      this->Weights[j] = 0.0;
+      weights[j] = 0.0;
       }
     }
 
-  for (j=0; j<this->NumberOfComponents; j++)
+  for (j=0; j<numberOfComponents; j++)
     {
-    this->CenterWeight[j] *= factor;
-    if (std::fabs(this->CenterWeight[j])<VTK_VMTK_DOUBLE_TOL)
+    centerWeight[j] *= factor;
+    if (std::fabs(centerWeight[j])<VTK_VMTK_DOUBLE_TOL)
       {
-      this->CenterWeight[j] = 0.0;
+      centerWeight[j] = 0.0;
       }
     }
 
@@ -84,6 +84,12 @@ protected:
 
   void ChangeWeightSign();
 
+  // Description:
+  // Array versions of ScaleWeights and ChangeWeightSign, for weights that
+  // are not stored in a stencil instance (see vtkvmtkCompactStencils).
+  static void ScaleWeights(double factor, vtkIdType numberOfPoints, vtkIdType numberOfComponents, double* weights, double* centerWeight);
+  static void ChangeWeightSign(vtkIdType numberOfWeights, double* weights);
+
   vtkIdType NumberOfComponents;
   double* Weights;
   double* CenterWeight;
@@ -28,6 +28,8 @@
 #include "vtkvmtkFEAssembler.h"
 #include "vtkvmtkWin32Header.h"
 
+class vtkDataArray;
+
 class VTK_VMTK_DIFFERENTIAL_GEOMETRY_EXPORT vtkvmtkUnstructuredGridFEGradientAssembler : public vtkvmtkFEAssembler
 {
 public:
@@ -67,11 +69,18 @@ protected:
   void BuildGradient();
   void BuildPartialDerivative();
 
+  virtual void AssembleCell(vtkCell* cell, vtkvmtkGaussQuadrature* gaussQuadrature, vtkvmtkFEShapeFunctions* feShapeFunctions) override;
+  void AssembleGradientCell(vtkCell* cell, vtkvmtkGaussQuadrature* gaussQuadrature, vtkvmtkFEShapeFunctions* feShapeFunctions);
+  void AssemblePartialDerivativeCell(vtkCell* cell, vtkvmtkGaussQuadrature* gaussQuadrature, vtkvmtkFEShapeFunctions* feShapeFunctions);
+
   char* ScalarsArrayName;
   int ScalarsComponent;
   int AssemblyMode;
   int Direction;
 
+  // scalars array of the Build in progress
+  vtkDataArray* ScalarsArray;
+
 private:
   vtkvmtkUnstructuredGridFEGradientAssembler(const vtkvmtkUnstructuredGridFEGradientAssembler&);  // Not implemented.
   void operator=(const vtkvmtkUnstructuredGridFEGradientAssembler&);  // Not implemented.
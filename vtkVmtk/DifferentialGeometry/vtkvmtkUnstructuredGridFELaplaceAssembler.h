@@ -41,6 +41,8 @@ protected:
   vtkvmtkUnstructuredGridFELaplaceAssembler();
   ~vtkvmtkUnstructuredGridFELaplaceAssembler();
 
+  virtual void AssembleCell(vtkCell* cell, vtkvmtkGaussQuadrature* gaussQuadrature, vtkvmtkFEShapeFunctions* feShapeFunctions) override;
+
 private:
   vtkvmtkUnstructuredGridFELaplaceAssembler(const vtkvmtkUnstructuredGridFELaplaceAssembler&);  // Not implemented.
   void operator=(const vtkvmtkUnstructuredGridFELaplaceAssembler&);  // Not implemented.
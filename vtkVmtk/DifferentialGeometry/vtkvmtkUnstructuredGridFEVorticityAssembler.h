@@ -28,6 +28,8 @@
 #include "vtkvmtkFEAssembler.h"
 #include "vtkvmtkWin32Header.h"
 
+class vtkDataArray;
+
 class VTK_VMTK_DIFFERENTIAL_GEOMETRY_EXPORT vtkvmtkUnstructuredGridFEVorticityAssembler : public vtkvmtkFEAssembler
 {
 public:
@@ -47,9 +49,14 @@ protected:
   vtkvmtkUnstructuredGridFEVorticityAssembler();
   ~vtkvmtkUnstructuredGridFEVorticityAssembler();
 
+  virtual void AssembleCell(vtkCell* cell, vtkvmtkGaussQuadrature* gaussQuadrature, vtkvmtkFEShapeFunctions* feShapeFunctions) override;
+
   char* VelocityArrayName;
   int Direction;
 
+  // velocity array of the Build in progress
+  vtkDataArray* VelocityArray;
+
 private:
   vtkvmtkUnstructuredGridFEVorticityAssembler(const vtkvmtkUnstructuredGridFEVorticityAssembler&);  // Not implemented.
   void operator=(const vtkvmtkUnstructuredGridFEVorticityAssembler&);  // Not implemented.
@@ -22,6 +22,7 @@ Version:   $Revision: 1.6 $
 // #include <fstream>
 #include <cassert>
 #include <algorithm>
+#include <vector>
 
 #include "vtkvmtkDolfinWriter.h"
 #include "vtkUnstructuredGrid.h"
@@ -29,10 +30,236 @@ Version:   $Revision: 1.6 $
 #include "vtkCell.h"
 #include "vtkCellData.h"
 #include "vtkIdTypeArray.h"
+#include "vtkIdList.h"
+#include "vtkSMPTools.h"
 #include "vtkObjectFactory.h"
 #include "vtkvmtkConstants.h"
+#include "vtkvmtkTextWriterUtilities.h"
 
 
+namespace
+{
+
+const int numberOfTetraPoints = 4; // Points in a tetrahedron(!)
+
+// Sorted point ids of a tetrahedron, the way dolfin likes it (this works only for simplices!)
+void GetDolfinCellPointIds(vtkUnstructuredGrid* input, vtkIdType cellId, vtkIdList* cellPointIds, vtkIdType dolfinCellPointIds[numberOfTetraPoints])
+{
+  input->GetCellPoints(cellId,cellPointIds);
+  for (int k=0; k<numberOfTetraPoints; k++)
+    {
+    dolfinCellPointIds[k] = cellPointIds->GetId(k);
+    }
+  std::sort(dolfinCellPointIds, dolfinCellPointIds+numberOfTetraPoints);
+}
+
+class VertexFormatter
+{
+public:
+  VertexFormatter(vtkUnstructuredGrid* input) : Input(input) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    static const char* coordinateNames[3] = {"x=\"", "y=\"", "z=\""};
+    double point[3];
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Input->GetPoint(i,point);
+      buffer += "      <vertex index=\"";
+      vtkvmtkTextWriterUtilities::AppendInteger(buffer,i);
+      buffer += "\" ";
+      for (int k=0; k<3; k++)
+        {
+        buffer += coordinateNames[k];
+        vtkvmtkTextWriterUtilities::AppendDouble(buffer,point[k]);
+        buffer += "\" ";
+        }
+      buffer += "/>\n";
+      }
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+};
+
+class TetrahedronFormatter
+{
+public:
+  TetrahedronFormatter(vtkUnstructuredGrid* input, vtkIdTypeArray* tetraCellIds) : Input(input), TetraCellIds(tetraCellIds) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    vtkIdList* cellPointIds = vtkIdList::New();
+    vtkIdType dolfinCellPointIds[numberOfTetraPoints];
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      GetDolfinCellPointIds(this->Input,this->TetraCellIds->GetValue(i),cellPointIds,dolfinCellPointIds);
+
+      // Write out vertex ids for a single tetrahedron
+      buffer += "      <tetrahedron index=\"";
+      vtkvmtkTextWriterUtilities::AppendInteger(buffer,i);
+      buffer += "\" ";
+      for (int k=0; k<numberOfTetraPoints; k++)
+        {
+        buffer += 'v';
+        vtkvmtkTextWriterUtilities::AppendInteger(buffer,k);
+        buffer += "=\"";
+        vtkvmtkTextWriterUtilities::AppendInteger(buffer,dolfinCellPointIds[k]);
+        buffer += "\" ";
+        }
+      buffer += "/>\n";
+      }
+    cellPointIds->Delete();
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  vtkIdTypeArray* TetraCellIds;
+};
+
+// Finds the tetrahedron adjacent to each triangle and the local dolfin
+// number of the shared facet. Requires links to be built.
+class FacetFunctor
+{
+public:
+  FacetFunctor(vtkUnstructuredGrid* input, vtkIdTypeArray* triangleCellIds, vtkIdList* volumeCellIdMap,
+               std::vector<vtkIdType>& triangleToTetrahedron, std::vector<vtkIdType>& triangleToLocalFacetId,
+               std::vector<vtkIdType>& triangleNumberOfNeighbors, std::vector<vtkIdType>& triangleUnsupportedCellId)
+    : Input(input), TriangleCellIds(triangleCellIds), VolumeCellIdMap(volumeCellIdMap),
+      TriangleToTetrahedron(triangleToTetrahedron), TriangleToLocalFacetId(triangleToLocalFacetId),
+      TriangleNumberOfNeighbors(triangleNumberOfNeighbors), TriangleUnsupportedCellId(triangleUnsupportedCellId) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkIdList* faceCellPoints = vtkIdList::New();
+    vtkIdList* cellIds = vtkIdList::New();
+    vtkIdList* cellPointIds = vtkIdList::New();
+    vtkIdType dolfinCellPointIds[numberOfTetraPoints];
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      const vtkIdType triangleCellId = this->TriangleCellIds->GetValue(i);
+
+      this->Input->GetCellPoints(triangleCellId,faceCellPoints);
+      this->Input->GetCellNeighbors(triangleCellId,faceCellPoints,cellIds);
+
+      this->TriangleNumberOfNeighbors[i] = cellIds->GetNumberOfIds();
+      this->TriangleUnsupportedCellId[i] = -1;
+      this->TriangleToTetrahedron[i] = -1;
+      this->TriangleToLocalFacetId[i] = -1;
+
+      // Get neighbor cell to facet, pick the one with smallest index if two (interior facet)
+      vtkIdType cellId = cellIds->GetId(0);
+      if (cellIds->GetNumberOfIds() == 2  &&  cellIds->GetId(1) < cellId)
+        {
+        cellId = cellIds->GetId(1);
+        }
+
+      // Check that all neighbor cells are tets
+      if (this->Input->GetCellType(cellId) != VTK_TETRA)
+        {
+        this->TriangleUnsupportedCellId[i] = cellId;
+        continue;
+        }
+
+      GetDolfinCellPointIds(this->Input,cellId,cellPointIds,dolfinCellPointIds);
+
+      // Find local facet id in dolfin numbering, opposite of point in cell that is not part of facet
+      vtkIdType dolfinFaceId = -1;
+      for (int k=0; k<numberOfTetraPoints; k++)
+        {
+        bool found = false;
+        const int numberOfTrianglePoints = 3;
+        for (int j=0; j<numberOfTrianglePoints; j++)
+          {
+            if (dolfinCellPointIds[k] == faceCellPoints->GetId(j))
+              {
+              found = true;
+              break;
+              }
+          }
+        if (!found)
+          {
+          dolfinFaceId = k;
+          break;
+          }
+        }
+
+      // Store tetrahedron number and local dolfin facet number for vtk triangle i
+      this->TriangleToTetrahedron[i] = this->VolumeCellIdMap->GetId(cellId);
+      this->TriangleToLocalFacetId[i] = dolfinFaceId;
+      }
+    faceCellPoints->Delete();
+    cellIds->Delete();
+    cellPointIds->Delete();
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  vtkIdTypeArray* TriangleCellIds;
+  vtkIdList* VolumeCellIdMap;
+  std::vector<vtkIdType>& TriangleToTetrahedron;
+  std::vector<vtkIdType>& TriangleToLocalFacetId;
+  std::vector<vtkIdType>& TriangleNumberOfNeighbors;
+  std::vector<vtkIdType>& TriangleUnsupportedCellId;
+};
+
+void AppendValue(std::string& buffer, vtkIdType cellIndex, vtkIdType localEntity, vtkIdType value)
+{
+  buffer += "        <value cell_index=\"";
+  vtkvmtkTextWriterUtilities::AppendInteger(buffer,cellIndex);
+  buffer += "\" local_entity=\"";
+  vtkvmtkTextWriterUtilities::AppendInteger(buffer,localEntity);
+  buffer += "\" value=\"";
+  vtkvmtkTextWriterUtilities::AppendInteger(buffer,value);
+  buffer += "\" />\n";
+}
+
+class FacetValueFormatter
+{
+public:
+  FacetValueFormatter(vtkIdTypeArray* triangleCellIds, vtkIdTypeArray* cellEntityIds, int boundaryDataIdOffset,
+                      const std::vector<vtkIdType>& triangleToTetrahedron, const std::vector<vtkIdType>& triangleToLocalFacetId)
+    : TriangleCellIds(triangleCellIds), CellEntityIds(cellEntityIds), BoundaryDataIdOffset(boundaryDataIdOffset),
+      TriangleToTetrahedron(triangleToTetrahedron), TriangleToLocalFacetId(triangleToLocalFacetId) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      const vtkIdType triangleCellId = this->TriangleCellIds->GetValue(i);
+      const vtkIdType value = this->CellEntityIds->GetValue(triangleCellId) + this->BoundaryDataIdOffset;
+      AppendValue(buffer,this->TriangleToTetrahedron[i],this->TriangleToLocalFacetId[i],value);
+      }
+  }
+
+private:
+  vtkIdTypeArray* TriangleCellIds;
+  vtkIdTypeArray* CellEntityIds;
+  int BoundaryDataIdOffset;
+  const std::vector<vtkIdType>& TriangleToTetrahedron;
+  const std::vector<vtkIdType>& TriangleToLocalFacetId;
+};
+
+class CellValueFormatter
+{
+public:
+  CellValueFormatter(vtkIdTypeArray* tetraCellIds, vtkIdTypeArray* cellEntityIds) : TetraCellIds(tetraCellIds), CellEntityIds(cellEntityIds) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      AppendValue(buffer,i,0,this->CellEntityIds->GetValue(this->TetraCellIds->GetValue(i)));
+      }
+  }
+
+private:
+  vtkIdTypeArray* TetraCellIds;
+  vtkIdTypeArray* CellEntityIds;
+};
+
+}
+
 vtkStandardNewMacro(vtkvmtkDolfinWriter);
 
 vtkvmtkDolfinWriter::vtkvmtkDolfinWriter()
@@ -92,7 +319,6 @@ void vtkvmtkDolfinWriter::WriteData()
   vtkIdTypeArray* tetraCellIdArray = vtkIdTypeArray::New();
   input->GetIdsOfCellsOfType(VTK_TETRA, tetraCellIdArray);
   const int numberOfTetras = tetraCellIdArray->GetNumberOfTuples();
-  const int numberOfTetraPoints = 4; // Points in a tetrahedron(!)
 
   // Build the inverted array with mapping from contiguous tetrahedron numbering to vtk cell numbering
   vtkIdList* volumeCellIdMap = vtkIdList::New();
@@ -104,48 +330,21 @@ void vtkvmtkDolfinWriter::WriteData()
     }
 
   // Write out dolfin mesh header
-  out << "<?xml version=\"1.0\"?>" << endl;
-  out << "<dolfin xmlns:dolfin=\"http://www.fenicsproject.org\">" << endl;
-  out << "  <mesh celltype=\"tetrahedron\" dim=\"3\">" << endl;
+  out << "<?xml version=\"1.0\"?>\n";
+  out << "<dolfin xmlns:dolfin=\"http://www.fenicsproject.org\">\n";
+  out << "  <mesh celltype=\"tetrahedron\" dim=\"3\">\n";
 
   // Write out all vertices
-  out << "    <vertices size=\""<< numberOfPoints << "\">" << endl;
-  for (int i=0; i<numberOfPoints; i++)
-    {
-    double point[3];
-    input->GetPoint(i,point);
-    out << "      <vertex index=\"" << i << "\" ";
-    out << "x=\"" << point[0] << "\" ";
-    out << "y=\"" << point[1] << "\" ";
-    out << "z=\"" << point[2] << "\" ";
-    out << "/>" <<endl;
-    }
-  out << "    </vertices>" << endl;
+  out << "    <vertices size=\""<< numberOfPoints << "\">\n";
+  VertexFormatter vertexFormatter(input);
+  vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfPoints,vertexFormatter);
+  out << "    </vertices>\n";
 
   // Write out all cells
-  out << "    <cells size=\"" << numberOfTetras << "\">" << endl;
-  for (int i=0; i<numberOfTetras; i++)
-    {
-    vtkIdType tetraCellId = tetraCellIdArray->GetValue(i);
-    vtkIdList* cellPointIds = input->GetCell(tetraCellId)->GetPointIds();
-
-    // Sort point ids in cell, the way dolfin likes it (this works only for simplices!)
-    vtkIdType dolfinCellPointIds[numberOfTetraPoints];
-    for (int k=0; k<numberOfTetraPoints; k++)
-      {
-      dolfinCellPointIds[k] = cellPointIds->GetId(k);
-      }
-    std::sort(dolfinCellPointIds, dolfinCellPointIds+numberOfTetraPoints);
-
-    // Write out vertex ids for a single tetrahedron
-    out << "      <tetrahedron index=\"" << i << "\" "; 
-    for (int k=0; k<numberOfTetraPoints; k++)
-      {
-      out << "v" << k << "=\"" << dolfinCellPointIds[k] << "\" ";
-      }
-    out << "/>" << endl;
-    }
-  out << "    </cells>" << endl;
+  out << "    <cells size=\"" << numberOfTetras << "\">\n";
+  TetrahedronFormatter tetrahedronFormatter(input,tetraCellIdArray);
+  vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfTetras,tetrahedronFormatter);
+  out << "    </cells>\n";
 
   // Build and write subdomains if available
   if (cellEntityIds)
@@ -154,136 +353,58 @@ void vtkvmtkDolfinWriter::WriteData()
     input->GetIdsOfCellsOfType(VTK_TRIANGLE,triangleCellIdArray);
     const int numberOfTriangles = triangleCellIdArray->GetNumberOfTuples();
 
-    vtkIdList* triangleToTetrahedron = vtkIdList::New();
-    triangleToTetrahedron->SetNumberOfIds(numberOfTriangles);
+    // Tetrahedron number, local dolfin facet number and number of adjacent
+    // cells for each vtk triangle; the volume cell id is kept for triangles
+    // whose neighbor is not a tetrahedron, to report them afterwards.
+    std::vector<vtkIdType> triangleToTetrahedron(numberOfTriangles);
+    std::vector<vtkIdType> triangleToLocalFacetId(numberOfTriangles);
+    std::vector<vtkIdType> triangleNumberOfNeighbors(numberOfTriangles);
+    std::vector<vtkIdType> triangleUnsupportedCellId(numberOfTriangles);
 
-    vtkIdList* triangleToLocalFacetId = vtkIdList::New();
-    triangleToLocalFacetId->SetNumberOfIds(numberOfTriangles);
+    FacetFunctor facetFunctor(input,triangleCellIdArray,volumeCellIdMap,triangleToTetrahedron,triangleToLocalFacetId,triangleNumberOfNeighbors,triangleUnsupportedCellId);
+    vtkSMPTools::For(0,numberOfTriangles,facetFunctor);
 
     int interiorFacetsFound = 0;
-    int exteriorFacetsFound = 0;
     for (int i=0; i<numberOfTriangles; i++)
       {
-      const vtkIdType triangleCellId = triangleCellIdArray->GetValue(i);
-
-      vtkIdList* faceCellPoints = vtkIdList::New();
-      input->GetCellPoints(triangleCellId,faceCellPoints);
-
-      vtkIdList* cellIds = vtkIdList::New();
-      input->GetCellNeighbors(triangleCellId,faceCellPoints,cellIds);
-
-      if (cellIds->GetNumberOfIds() != 1)
+      if (triangleNumberOfNeighbors[i] != 1)
         {
         interiorFacetsFound++;
         }
-      else
+      if (triangleUnsupportedCellId[i] != -1)
         {
-        exteriorFacetsFound++;
+        vtkErrorMacro(<<"Volume cell adjacent to triangle is not tetrahedron (volume cell id: "<<triangleUnsupportedCellId[i] <<") and it is unsupported by Dolfin. Skipping face.");
         }
-
-      // Get neighbor cell to facet, pick the one with smallest index if two (interior facet)
-      vtkIdType cellId = cellIds->GetId(0);
-      if (cellIds->GetNumberOfIds() == 2  &&  cellIds->GetId(1) < cellId)
-        {
-        cellId = cellIds->GetId(1);
-        }
-      vtkCell* cell = input->GetCell(cellId);
-      int cellType = cell->GetCellType();
-      vtkIdList* cellPointIds = cell->GetPointIds();
-
-      // Check that all neighbor cells are tets
-      if (cellType != VTK_TETRA)
-        {
-        vtkErrorMacro(<<"Volume cell adjacent to triangle is not tetrahedron (volume cell id: "<<cellId <<") and it is unsupported by Dolfin. Skipping face.");
-        faceCellPoints->Delete();
-        cellIds->Delete();
-        continue;
-        }
-
-      // Sort point ids in cell, the way dolfin likes it (this works only for simplices!)
-      vtkIdType dolfinCellPointIds[numberOfTetraPoints];
-      for (int k=0; k<numberOfTetraPoints; k++)
-        {
-        dolfinCellPointIds[k] = cellPointIds->GetId(k);
-        }
-      std::sort(dolfinCellPointIds, dolfinCellPointIds+numberOfTetraPoints);
-
-      // Find local facet id in dolfin numbering, opposite of point in cell that is not part of facet
-      vtkIdType dolfinFaceId = -1;
-      for (int k=0; k<numberOfTetraPoints; k++)
-        {
-        bool found = false;
-        const int numberOfTrianglePoints = 3;
-        for (int j=0; j<numberOfTrianglePoints; j++)
-          {
-            if (dolfinCellPointIds[k] == faceCellPoints->GetId(j))
-              {
-              found = true;
-              break;
-              }
-          }
-        if (!found)
-          {
-          dolfinFaceId = k;
-          break;
-          }
-        }
-
-      // Store tetrahedron number for vtk triangle i
-      triangleToTetrahedron->SetId(i, volumeCellIdMap->GetId(cellId));
-      // Store local dolfin facet number for vtk triangle i
-      triangleToLocalFacetId->SetId(i, dolfinFaceId);
-
-      // Cleanup
-      faceCellPoints->Delete();
-      cellIds->Delete();
       }
 
     // Start subdomains section in file
     if (numberOfTriangles || this->StoreCellMarkers)
       {
-      out << "    <domains>" << endl;
+      out << "    <domains>\n";
       }
 
     // Write facet subdomains
     if (numberOfTriangles)
       {
-      out << "      <mesh_value_collection type=\"uint\" dim=\"2\" size=\""<< numberOfTriangles<< "\">" << endl;
-      for (int i=0; i<numberOfTriangles; i++)
-        {
-        const vtkIdType triangleCellId = triangleCellIdArray->GetValue(i);
-        const vtkIdType tetrahedronCellId = triangleToTetrahedron->GetId(i);
-        const vtkIdType value = cellEntityIds->GetValue(triangleCellId) + this->BoundaryDataIdOffset;
-        const vtkIdType localEntity = triangleToLocalFacetId->GetId(i);
-
-        out << "        <value cell_index=\"" << tetrahedronCellId <<"\"" 
-            << " local_entity=\"" << localEntity << "\""
-            << " value=\""  << value << "\""
-            << " />" << endl;
-        }
-      out << "      </mesh_value_collection>" << endl;
+      out << "      <mesh_value_collection type=\"uint\" dim=\"2\" size=\""<< numberOfTriangles<< "\">\n";
+      FacetValueFormatter facetValueFormatter(triangleCellIdArray,cellEntityIds,this->BoundaryDataIdOffset,triangleToTetrahedron,triangleToLocalFacetId);
+      vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfTriangles,facetValueFormatter);
+      out << "      </mesh_value_collection>\n";
       }
 
     // Write cell subdomains
     if (this->StoreCellMarkers)
       {
-      out << "      <mesh_value_collection type=\"uint\" dim=\"3\" size=\""<< numberOfTetras << "\">" << endl;
-      for (int i=0; i<numberOfTetras; i++)
-        {
-        const vtkIdType cellId = tetraCellIdArray->GetValue(i);
-        const vtkIdType value = cellEntityIds->GetValue(cellId);
-        out << "        <value cell_index=\"" << i << "\"" 
-            << " local_entity=\"" << 0 << "\"" 
-            << " value=\""  <<  value << "\"" 
-            << " />" << endl;
-        }
-      out << "      </mesh_value_collection>" << endl;
+      out << "      <mesh_value_collection type=\"uint\" dim=\"3\" size=\""<< numberOfTetras << "\">\n";
+      CellValueFormatter cellValueFormatter(tetraCellIdArray,cellEntityIds);
+      vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfTetras,cellValueFormatter);
+      out << "      </mesh_value_collection>\n";
       }
 
     // End subdomains section in file
     if (numberOfTriangles || this->StoreCellMarkers)
       {
-      out << "    </domains>" << endl;
+      out << "    </domains>\n";
       }
 
     if (interiorFacetsFound)
@@ -292,12 +413,15 @@ void vtkvmtkDolfinWriter::WriteData()
       }
 
     triangleCellIdArray->Delete();
-    triangleToTetrahedron->Delete();
-    triangleToLocalFacetId->Delete();
   }
 
-  out << "  </mesh>" << endl;
-  out << "</dolfin>" << endl;
+  out << "  </mesh>\n";
+  out << "</dolfin>\n";
+
+  if (!out.good())
+    {
+    vtkErrorMacro(<<"Error writing file.");
+    }
 
   tetraCellIdArray->Delete();
   volumeCellIdMap->Delete();
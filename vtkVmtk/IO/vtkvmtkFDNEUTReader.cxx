@@ -21,6 +21,8 @@ Version:   $Revision: 1.8 $
 
 #include "vtkvmtkFDNEUTReader.h"
 #include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
 #include "vtkIntArray.h"
 #include "vtkObjectFactory.h"
 #include "vtkPoints.h"
@@ -31,8 +33,166 @@ Version:   $Revision: 1.8 $
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkSMPTools.h"
 #include "vtkvmtkConstants.h"
+#include "vtkvmtkTextReaderUtilities.h"
 
+#include <cstring>
+#include <vector>
+
+
+namespace
+{
+
+// First line at or after p whose first non blank character cannot start a
+// number, i.e. the end of a block of numeric records.
+const char* FindSectionEnd(const char* p, const char* end)
+{
+  while (p < end)
+    {
+    const char* q = vtkvmtkTextReaderUtilities::SkipBlanks(p,end);
+    if (q < end && *q != '\n' && !((*q >= '0' && *q <= '9') || *q == '-' || *q == '+' || *q == '.'))
+      {
+      return p;
+      }
+    p = vtkvmtkTextReaderUtilities::NextLine(q,end);
+    }
+  return end;
+}
+
+bool TokenEquals(const char* begin, const char* end, const char* str, size_t length)
+{
+  return static_cast<size_t>(end - begin) >= length && strncmp(begin,str,length) == 0;
+}
+
+// Skips tokens up to and including keyword and parses the following one.
+bool ReadKeywordValue(const char*& p, const char* end, const char* keyword, int& value)
+{
+  const char* tokenBegin;
+  const char* tokenEnd;
+  const size_t length = strlen(keyword);
+  do
+    {
+    if (!vtkvmtkTextReaderUtilities::NextToken(p,end,tokenBegin,tokenEnd))
+      {
+      return false;
+      }
+    }
+  while (!TokenEquals(tokenBegin,tokenEnd,keyword,length));
+  if (!vtkvmtkTextReaderUtilities::NextToken(p,end,tokenBegin,tokenEnd))
+    {
+    return false;
+    }
+  value = static_cast<int>(vtkvmtkTextReaderUtilities::ParseInteger(tokenBegin,tokenEnd));
+  return true;
+}
+
+// Node records: id x y z
+class NodeTokenFunctor
+{
+public:
+  NodeTokenFunctor(vtkIdType numberOfNodes, vtkIdType* ids, float* coordinates)
+    : NumberOfNodes(numberOfNodes), Ids(ids), Coordinates(coordinates) {}
+
+  void operator()(vtkIdType tokenId, const char* begin, const char* end) const
+  {
+    vtkIdType i = tokenId / 4;
+    int field = static_cast<int>(tokenId % 4);
+    if (i >= this->NumberOfNodes)
+      {
+      return;
+      }
+    if (field == 0)
+      {
+      this->Ids[i] = vtkvmtkTextReaderUtilities::ParseInteger(begin,end);
+      }
+    else
+      {
+      this->Coordinates[3*i+field-1] = static_cast<float>(vtkvmtkTextReaderUtilities::ParseDouble(begin,end));
+      }
+  }
+
+private:
+  vtkIdType NumberOfNodes;
+  vtkIdType* Ids;
+  float* Coordinates;
+};
+
+class NodeScatterFunctor
+{
+public:
+  NodeScatterFunctor(const vtkIdType* ids, const float* coordinates, float* points, vtkIdType numberOfPoints)
+    : Ids(ids), Coordinates(coordinates), Points(points), NumberOfPoints(numberOfPoints) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      vtkIdType pointId = this->Ids[i] - 1;
+      if (pointId < 0 || pointId >= this->NumberOfPoints)
+        {
+        continue;
+        }
+      this->Points[3*pointId+0] = this->Coordinates[3*i+0];
+      this->Points[3*pointId+1] = this->Coordinates[3*i+1];
+      this->Points[3*pointId+2] = this->Coordinates[3*i+2];
+      }
+  }
+
+private:
+  const vtkIdType* Ids;
+  const float* Coordinates;
+  float* Points;
+  vtkIdType NumberOfPoints;
+};
+
+// Element records: id followed by the FDNEUT nodes of the element. Order
+// maps each node to its position in the VTK cell, or -1 if it is dropped.
+class ElementTokenFunctor
+{
+public:
+  ElementTokenFunctor(vtkIdType numberOfElements, const std::vector<int>& order, int numberOfCellPoints, vtkIdType* connectivity)
+    : NumberOfElements(numberOfElements), Order(order), Stride(static_cast<int>(order.size())+1), NumberOfCellPoints(numberOfCellPoints), Connectivity(connectivity) {}
+
+  void operator()(vtkIdType tokenId, const char* begin, const char* end) const
+  {
+    vtkIdType i = tokenId / this->Stride;
+    int field = static_cast<int>(tokenId % this->Stride);
+    if (i >= this->NumberOfElements || field == 0)
+      {
+      return;
+      }
+    int position = this->Order[field-1];
+    if (position < 0)
+      {
+      return;
+      }
+    this->Connectivity[i*this->NumberOfCellPoints+position] = vtkvmtkTextReaderUtilities::ParseInteger(begin,end) - 1;
+  }
+
+private:
+  vtkIdType NumberOfElements;
+  const std::vector<int>& Order;
+  int Stride;
+  int NumberOfCellPoints;
+  vtkIdType* Connectivity;
+};
+
+void AssignOrder(std::vector<int>& order, const int* positions, int numberOfNodes)
+{
+  order.assign(positions,positions+numberOfNodes);
+}
+
+void AssignIdentityOrder(std::vector<int>& order, int numberOfNodes)
+{
+  order.resize(numberOfNodes);
+  for (int k=0; k<numberOfNodes; k++)
+    {
+    order[k] = k;
+    }
+}
+
+}
 
 vtkStandardNewMacro(vtkvmtkFDNEUTReader);
 
@@ -66,416 +226,261 @@ int vtkvmtkFDNEUTReader::ReadMeshSimple(const std::string& fname,
     return 1;
   }
 
-  FILE* FDNEUTFile;
-  FDNEUTFile = fopen(fname.c_str(),"r");
-  // std::ifstream ifs( fname, std::ifstream::in );
-  if(!FDNEUTFile)
+  vtkvmtkTextReaderUtilities::MappedFile FDNEUTFile;
+  if(!FDNEUTFile.Open(fname.c_str()))
   {
     vtkErrorMacro(<<"Unable to open " << fname << " for reading");
     return 1;
   }
 
-  char buffer[1024];
-  int ret;
+  const char* p = FDNEUTFile.GetBegin();
+  const char* end = FDNEUTFile.GetEnd();
+  const char* tokenBegin;
+  const char* tokenEnd;
+
+  // Skip to the line after the one starting with NODAL
   do
     {
-    ret = fscanf(FDNEUTFile, "%s", buffer);
-    while (fgetc(FDNEUTFile) != '\n');
+    if (!vtkvmtkTextReaderUtilities::NextToken(p,end,tokenBegin,tokenEnd))
+      {
+      vtkErrorMacro(<<"NODAL COORDINATES section not found in " << fname);
+      return 1;
+      }
+    p = vtkvmtkTextReaderUtilities::NextLine(tokenEnd,end);
     }
-  while (strncmp(buffer,"NODAL",5)!=0);
-  //  while (fgetc(FDNEUTFile) != '\n');
-
-  int pointId;
-  float point[3], doublePoint[3];
+  while (!TokenEquals(tokenBegin,tokenEnd,"NODAL",5));
 
-  vtkPoints* points = vtkPoints::New();
+  const char* nodesEnd = FindSectionEnd(p,end);
 
-  while(fscanf(FDNEUTFile, "%d", &pointId))
-    {
-    ret = fscanf(FDNEUTFile, "%f", &point[0]);
-    ret = fscanf(FDNEUTFile, "%f", &point[1]);
-    ret = fscanf(FDNEUTFile, "%f", &point[2]);
-    while (fgetc(FDNEUTFile) != '\n');
+  vtkvmtkTextReaderUtilities::TokenChunks nodeTokens;
+  vtkIdType numberOfNodes = nodeTokens.Initialize(p,nodesEnd) / 4;
 
-    doublePoint[0] = point[0];
-    doublePoint[1] = point[1];
-    doublePoint[2] = point[2];
+  std::vector<vtkIdType> nodeIds(numberOfNodes);
+  std::vector<float> nodeCoordinates(3*numberOfNodes);
+  NodeTokenFunctor nodeFunctor(numberOfNodes,numberOfNodes ? &nodeIds[0] : NULL,numberOfNodes ? &nodeCoordinates[0] : NULL);
+  nodeTokens.Parse(nodeFunctor);
 
-    points->InsertPoint(pointId-1,doublePoint);
+  // Points are stored at their id minus one
+  vtkIdType numberOfPoints = 0;
+  vtkIdType i;
+  for (i=0; i<numberOfNodes; i++)
+    {
+    if (nodeIds[i] > numberOfPoints)
+      {
+      numberOfPoints = nodeIds[i];
+      }
     }
 
-  int cellId, i;
-  int nodesPerElement, geometry, fdneutType;
-
-  vtkCellArray* gridCellArray = vtkCellArray::New();
+  vtkPoints* points = vtkPoints::New();
+  points->SetNumberOfPoints(numberOfPoints);
+  float* pointValues = vtkFloatArray::SafeDownCast(points->GetData())->GetPointer(0);
+  if (numberOfPoints != numberOfNodes)
+    {
+    memset(pointValues,0,3*numberOfPoints*sizeof(float));
+    }
+  NodeScatterFunctor scatterFunctor(numberOfNodes ? &nodeIds[0] : NULL,numberOfNodes ? &nodeCoordinates[0] : NULL,pointValues,numberOfPoints);
+  vtkSMPTools::For(0,numberOfNodes,scatterFunctor);
+
+  std::vector<vtkIdType>().swap(nodeIds);
+  std::vector<float>().swap(nodeCoordinates);
+
+  // FDNEUT node order of the supported elements: position of each node in
+  // the VTK cell, -1 for ghost nodes that are dropped
+  const int quadraticQuadOrder[] = {0,4,1,5,2,6,3,7,8};
+  const int quadraticTriangleOrder[] = {0,3,1,4,2,5,6};
+  const int hexahedronOrder[] = {0,1,3,2,4,5,7,6};
+  const int quadraticHexahedronOrder[] = {0,8,1,11,24,9,3,10,2,16,20,17,23,26,21,19,22,18,4,12,5,15,25,13,7,14,6};
+  const int quadraticHexahedronGhostNodes[] = {4,10,12,13,14,16,22};
+  const int quadraticTetraOrder[] = {0,4,1,6,5,2,7,8,9,3};
+  const int quadraticWedge18Order[] = {0,6,1,8,7,2,12,15,13,16,17,14,3,9,4,11,10,5};
+  const int quadraticWedge18GhostNodes[] = {7,9,10};
+  const int quadraticWedge15Order[] = {0,6,1,8,7,2,12,13,14,3,9,4,11,10,5};
+
+  vtkIdTypeArray* offsets = vtkIdTypeArray::New();
+  offsets->SetNumberOfValues(1);
+  offsets->SetValue(0,0);
+  vtkIdTypeArray* connectivity = vtkIdTypeArray::New();
+  vtkUnsignedCharArray* typesArray = vtkUnsignedCharArray::New();
 
   int entityCounter = 0;
   vtkUnsignedCharArray* singleEntityArray;
   singleEntityArray = vtkUnsignedCharArray::New();
   singleEntityArray->SetName(this->SingleCellDataEntityArrayName);
-  output->GetCellData()->AddArray(singleEntityArray);
- 
-  vtkIntArray* typesArray = vtkIntArray::New();
-  while (fscanf(FDNEUTFile, "%s", buffer)!=EOF)
+
+  std::vector<int> order;
+  p = nodesEnd;
+  int nodesPerElement, geometry, fdneutType;
+  while (ReadKeywordValue(p,end,"NODES:",nodesPerElement) &&
+         ReadKeywordValue(p,end,"GEOMETRY:",geometry) &&
+         ReadKeywordValue(p,end,"TYPE:",fdneutType))
     {
-    while (strncmp(buffer,"NODES:",6)!=0)
-      ret = fscanf(FDNEUTFile, "%s", buffer);
-    ret = fscanf(FDNEUTFile, "%d", &nodesPerElement);
-    while (strncmp(buffer,"GEOMETRY:",9)!=0)
-      ret = fscanf(FDNEUTFile, "%s", buffer);
-    ret = fscanf(FDNEUTFile, "%d", &geometry);
-    while (strncmp(buffer,"TYPE:",5)!=0)
-      ret = fscanf(FDNEUTFile, "%s", buffer);
-    ret = fscanf(FDNEUTFile, "%d", &fdneutType);
-                
-    while (fgetc(FDNEUTFile) != '\n');
-    ret = fscanf(FDNEUTFile, "%s", buffer);
-    ret = fscanf(FDNEUTFile, "%s", buffer);
-
-    char currentEntityName[256];
-    ret = fscanf(FDNEUTFile, "%s", currentEntityName);
-    while (fgetc(FDNEUTFile) != '\n');
+    // Skip the rest of the group line and the ENTITY NAME line
+    p = vtkvmtkTextReaderUtilities::NextLine(p,end);
+    p = vtkvmtkTextReaderUtilities::NextLine(p,end);
+
+    const char* groupBegin = p;
+    p = FindSectionEnd(p,end);
 
     int type = -1;
-    int pointBuffer;
-    vtkIdType numberOfCellPoints = 0;
-#if 0
-    vtkUnsignedCharArray* entityArray = NULL;
-    entityArray = vtkUnsignedCharArray::New();
-    entityArray->SetName(currentEntityName);
-    output->GetCellData()->AddArray(entityArray);
-#endif
-    while(fscanf(FDNEUTFile, "%d", &cellId)>0)
+    int numberOfCellPoints = 0;
+    order.clear();
+    switch (geometry)
       {
-      int* cellPoints = NULL;
-      bool invalid = false;
-      switch (geometry)
-        {
-        case QUADRILATERAL:
-          if (this->VolumeElementsOnly)
-            {
-            continue;
-            }
-          if (nodesPerElement==4)
-            {
-            type = VTK_QUAD;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 4;
-            cellPoints = new int[numberOfCellPoints];
-            for (i=0; i<nodesPerElement; i++)
-              {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[i]);
-              }
-            }
-          else if ((nodesPerElement==8) || (nodesPerElement==9))
-            {
-            type = VTK_QUADRATIC_QUAD;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 8;
-            cellPoints = new int[numberOfCellPoints];
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[0]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[4]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[1]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[5]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[2]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[6]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[3]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[7]);
-            if (nodesPerElement==9)
-              {
-              if (this->GhostNodes)
-                {
-                ret = fscanf(FDNEUTFile, "%d",&cellPoints[8]);
-                }
-              else
-                {
-                ret = fscanf(FDNEUTFile, "%d",&pointBuffer);
-                }
-              }
-            }
-          break;
-        case TRIANGLE:
-          if (this->VolumeElementsOnly)
-            {
-            continue;
-            }
-          if (nodesPerElement==3)
-            {
-            type = VTK_TRIANGLE;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 3;
-            cellPoints = new int[numberOfCellPoints];
-            for (i=0; i<nodesPerElement; i++)
-              {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[i]);
-              }
-            }
-          else if ((nodesPerElement==6) || (nodesPerElement==7))
-            {
-            type = VTK_QUADRATIC_TRIANGLE;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 6;
-            cellPoints = new int[numberOfCellPoints];
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[0]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[3]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[1]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[4]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[2]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[5]);
- 
-            if (nodesPerElement==7)
-              {
-              if (this->GhostNodes)
-                {
-                ret = fscanf(FDNEUTFile, "%d",&cellPoints[6]);
-                }
-              else
-                {
-                ret = fscanf(FDNEUTFile, "%d",&pointBuffer);
-                }
-              }
-            }
+      case QUADRILATERAL:
+        if (this->VolumeElementsOnly)
+          {
           break;
-        case BRICK:
-          if (nodesPerElement==8)
-            {
-            type = VTK_HEXAHEDRON;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 8;
-            cellPoints = new int[numberOfCellPoints];
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[0]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[1]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[3]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[2]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[4]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[5]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[7]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[6]);
-            }
-          else if (nodesPerElement==27)
+          }
+        if (nodesPerElement==4)
+          {
+          type = VTK_QUAD;
+          numberOfCellPoints = 4;
+          AssignIdentityOrder(order,4);
+          }
+        else if ((nodesPerElement==8) || (nodesPerElement==9))
+          {
+          type = VTK_QUADRATIC_QUAD;
+          numberOfCellPoints = this->GhostNodes ? nodesPerElement : 8;
+          AssignOrder(order,quadraticQuadOrder,nodesPerElement);
+          if (nodesPerElement==9 && !this->GhostNodes)
             {
-            type = VTK_QUADRATIC_HEXAHEDRON;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 20;
-            cellPoints = new int[numberOfCellPoints];
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[0]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[8]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[1]);
-
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[11]);
-            if (this->GhostNodes)
-              {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[24]);
-              }
-            else
-              {
-              ret = fscanf(FDNEUTFile, "%d", &pointBuffer);
-              }
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[9]);
-
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[3]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[10]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[2]);
-
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[16]);
-            if (this->GhostNodes)
-              {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[20]);
-              }
-            else
-              {
-              ret = fscanf(FDNEUTFile, "%d", &pointBuffer);
-              }
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[17]);
-
-            if (this->GhostNodes)
-              {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[23]);
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[26]);
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[21]);
-              }
-            else
-              {
-              ret = fscanf(FDNEUTFile, "%d", &pointBuffer);
-              ret = fscanf(FDNEUTFile, "%d", &pointBuffer);
-              ret = fscanf(FDNEUTFile, "%d", &pointBuffer);
-              }
-
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[19]);
-            if (this->GhostNodes)
-              {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[22]);
-              }
-            else
-              {
-              ret = fscanf(FDNEUTFile, "%d", &pointBuffer);
-              }
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[18]);
-
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[4]);
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[12]);
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[5]);
-
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[15]);
-            if (this->GhostNodes)
-              {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[25]);
-              }
-            else
-              {
-              ret = fscanf(FDNEUTFile, "%d", &pointBuffer);
-              }
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[13]);
-
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[7]);
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[14]);
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[6]);
+            order[8] = -1;
             }
+          }
+        break;
+      case TRIANGLE:
+        if (this->VolumeElementsOnly)
+          {
           break;
-        case TETRAHEDRON:
-          if (nodesPerElement==4)
-            {
-            type = VTK_TETRA;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 4;
-            cellPoints = new int[numberOfCellPoints];
-            for (i=0; i<nodesPerElement; i++)
-              {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[i]);
-              }
-            }
-          else if (nodesPerElement==10)
+          }
+        if (nodesPerElement==3)
+          {
+          type = VTK_TRIANGLE;
+          numberOfCellPoints = 3;
+          AssignIdentityOrder(order,3);
+          }
+        else if ((nodesPerElement==6) || (nodesPerElement==7))
+          {
+          type = VTK_QUADRATIC_TRIANGLE;
+          numberOfCellPoints = this->GhostNodes ? nodesPerElement : 6;
+          AssignOrder(order,quadraticTriangleOrder,nodesPerElement);
+          if (nodesPerElement==7 && !this->GhostNodes)
             {
-            type = VTK_QUADRATIC_TETRA;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 10;
-            cellPoints = new int[numberOfCellPoints];
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[0]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[4]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[1]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[6]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[5]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[2]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[7]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[8]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[9]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[3]);
+            order[6] = -1;
             }
-          break;
-        case WEDGE:
-          if (nodesPerElement==6)
+          }
+        break;
+      case BRICK:
+        if (nodesPerElement==8)
+          {
+          type = VTK_HEXAHEDRON;
+          numberOfCellPoints = 8;
+          AssignOrder(order,hexahedronOrder,8);
+          }
+        else if (nodesPerElement==27)
+          {
+          type = VTK_QUADRATIC_HEXAHEDRON;
+          numberOfCellPoints = this->GhostNodes ? nodesPerElement : 20;
+          AssignOrder(order,quadraticHexahedronOrder,27);
+          if (!this->GhostNodes)
             {
-            type = VTK_WEDGE;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 6;
-            cellPoints = new int[numberOfCellPoints];
-            for (i=0; i<nodesPerElement; i++)
+            for (int k=0; k<7; k++)
               {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[i]);
+              order[quadraticHexahedronGhostNodes[k]] = -1;
               }
             }
-          else if (nodesPerElement==18)
+          }
+        break;
+      case TETRAHEDRON:
+        if (nodesPerElement==4)
+          {
+          type = VTK_TETRA;
+          numberOfCellPoints = 4;
+          AssignIdentityOrder(order,4);
+          }
+        else if (nodesPerElement==10)
+          {
+          type = VTK_QUADRATIC_TETRA;
+          numberOfCellPoints = 10;
+          AssignOrder(order,quadraticTetraOrder,10);
+          }
+        break;
+      case WEDGE:
+        if (nodesPerElement==6)
+          {
+          type = VTK_WEDGE;
+          numberOfCellPoints = 6;
+          AssignIdentityOrder(order,6);
+          }
+        else if (nodesPerElement==18)
+          {
+          type = VTK_QUADRATIC_WEDGE;
+          numberOfCellPoints = this->GhostNodes ? nodesPerElement : 15;
+          AssignOrder(order,quadraticWedge18Order,18);
+          if (!this->GhostNodes)
             {
-            type = VTK_QUADRATIC_WEDGE;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 15;
-            cellPoints = new int[numberOfCellPoints];
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[0]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[6]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[1]);
-
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[8]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[7]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[2]);
-
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[12]);
-            if (this->GhostNodes)
-              {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[15]);
-              }
-            else
-              {
-              ret = fscanf(FDNEUTFile, "%d", &pointBuffer);
-              }
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[13]);
-
-            if (this->GhostNodes)
+            for (int k=0; k<3; k++)
               {
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[16]);
-              ret = fscanf(FDNEUTFile, "%d", &cellPoints[17]);
+              order[quadraticWedge18GhostNodes[k]] = -1;
               }
-            else
-              {
-              ret = fscanf(FDNEUTFile, "%d", &pointBuffer);
-              ret = fscanf(FDNEUTFile, "%d", &pointBuffer);
-              }
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[14]);
-
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[3]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[9]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[4]);
-
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[11]);
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[10]);
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[5]);
-            }
-          else if (nodesPerElement==15)
-            {
-            type = VTK_QUADRATIC_WEDGE;
-            numberOfCellPoints = this->GhostNodes ? nodesPerElement : 15;
-            cellPoints = new int[numberOfCellPoints];
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[0]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[6]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[1]);
-
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[8]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[7]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[2]);
-
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[12]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[13]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[14]);
-
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[3]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[9]);
-            ret = fscanf(FDNEUTFile, "%d", &cellPoints[4]);
-
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[11]);
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[10]);
-            ret = fscanf(FDNEUTFile, "%d",&cellPoints[5]);
             }
-          break;
-        default:
-          invalid = true;
-        }
-#if 0
-      entityArray->InsertValue(gridCellArray->GetNumberOfCells()-1,1);
-#endif
-      if (!invalid)
-        {
-        typesArray->InsertNextValue(type);
-        this->OneToZeroOffset(numberOfCellPoints,cellPoints);
-        vtkIdType* cellPointsIdType = new vtkIdType[numberOfCellPoints];
-        for (int i=0; i<numberOfCellPoints; i++)
+          }
+        else if (nodesPerElement==15)
           {
-          cellPointsIdType[i] = cellPoints[i];
+          type = VTK_QUADRATIC_WEDGE;
+          numberOfCellPoints = 15;
+          AssignOrder(order,quadraticWedge15Order,15);
           }
-        gridCellArray->InsertNextCell(numberOfCellPoints,cellPointsIdType);
-        delete[] cellPointsIdType;
-        singleEntityArray->InsertNextValue(entityCounter);
-        delete[] cellPoints;
-        }
-      else
+        break;
+      }
+
+    if (type == -1)
+      {
+      if (!((geometry == QUADRILATERAL || geometry == TRIANGLE) && this->VolumeElementsOnly))
         {
-        cout<<"foo"<<endl;
+        vtkWarningMacro(<<"Unsupported element group (geometry " << geometry << ", " << nodesPerElement << " nodes), skipping.");
         }
+      ++entityCounter;
+      continue;
       }
-#if 0
-    entityArray->Delete();
-#endif
+
+    vtkvmtkTextReaderUtilities::TokenChunks elementTokens;
+    vtkIdType numberOfGroupElements = elementTokens.Initialize(groupBegin,p) / (nodesPerElement+1);
+
+    vtkIdType numberOfCells = typesArray->GetNumberOfTuples();
+    vtkIdType connectivityOffset = connectivity->GetNumberOfTuples();
+
+    connectivity->SetNumberOfValues(connectivityOffset + numberOfGroupElements*numberOfCellPoints);
+    ElementTokenFunctor elementFunctor(numberOfGroupElements,order,numberOfCellPoints,connectivity->GetPointer(connectivityOffset));
+    elementTokens.Parse(elementFunctor);
+
+    offsets->SetNumberOfValues(numberOfCells + numberOfGroupElements + 1);
+    typesArray->SetNumberOfValues(numberOfCells + numberOfGroupElements);
+    singleEntityArray->SetNumberOfValues(numberOfCells + numberOfGroupElements);
+    for (i=0; i<numberOfGroupElements; i++)
+      {
+      offsets->SetValue(numberOfCells+i+1,connectivityOffset+(i+1)*numberOfCellPoints);
+      typesArray->SetValue(numberOfCells+i,type);
+      singleEntityArray->SetValue(numberOfCells+i,entityCounter);
+      }
+
     ++entityCounter;
     }
 
+  output->GetCellData()->AddArray(singleEntityArray);
   singleEntityArray->Delete();
 
-  fclose(FDNEUTFile);
+  vtkCellArray* gridCellArray = vtkCellArray::New();
+  gridCellArray->SetData(offsets,connectivity);
 
   output->SetPoints(points);
-  output->SetCells(typesArray->GetPointer(0),gridCellArray);
+  output->SetCells(typesArray,gridCellArray);
 
   points->Delete();
   typesArray->Delete();
   gridCellArray->Delete();
+  offsets->Delete();
+  connectivity->Delete();
 
   return 1;
 }
@@ -22,9 +22,87 @@ Version:   $Revision: 1.6 $
 #include "vtkvmtkFDNEUTWriter.h"
 #include "vtkUnstructuredGrid.h"
 #include "vtkCellType.h"
+#include "vtkIdList.h"
+#include "vtkIdTypeArray.h"
 #include "vtkObjectFactory.h"
 #include "vtkvmtkConstants.h"
+#include "vtkvmtkTextWriterUtilities.h"
 
+#include <vector>
+
+
+namespace
+{
+
+// Marks a line break in the node ordering of an element
+const int nodeOrderNewLine = -1;
+
+// "%8d" element lines; NodeOrder lists the indices of the cell points in
+// FDNEUT order.
+class ElementFormatter
+{
+public:
+  ElementFormatter(vtkUnstructuredGrid* input, vtkIdTypeArray* cellIds, const std::vector<int>& nodeOrder, int firstElementId)
+    : Input(input), CellIds(cellIds), NodeOrder(nodeOrder), FirstElementId(firstElementId) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    vtkIdList* cellPoints = vtkIdList::New();
+    const size_t numberOfEntries = this->NodeOrder.size();
+    for (vtkIdType k=begin; k<end; k++)
+      {
+      this->Input->GetCellPoints(this->CellIds->GetValue(k),cellPoints);
+      vtkvmtkTextWriterUtilities::AppendInteger(buffer,this->FirstElementId+k,8);
+      for (size_t i=0; i<numberOfEntries; i++)
+        {
+        if (this->NodeOrder[i] == nodeOrderNewLine)
+          {
+          buffer += '\n';
+          continue;
+          }
+        vtkvmtkTextWriterUtilities::AppendInteger(buffer,cellPoints->GetId(this->NodeOrder[i])+1,8);
+        }
+      buffer += '\n';
+      }
+    cellPoints->Delete();
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  vtkIdTypeArray* CellIds;
+  const std::vector<int>& NodeOrder;
+  int FirstElementId;
+};
+
+class NodeFormatter
+{
+public:
+  NodeFormatter(vtkUnstructuredGrid* input) : Input(input) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    double point[3];
+    for (vtkIdType k=begin; k<end; k++)
+      {
+      this->Input->GetPoint(k,point);
+      vtkvmtkTextWriterUtilities::AppendInteger(buffer,k+1,10);
+      vtkvmtkTextWriterUtilities::AppendDouble(buffer,point[0],"%20.10e");
+      vtkvmtkTextWriterUtilities::AppendDouble(buffer,point[1],"%20.10e");
+      vtkvmtkTextWriterUtilities::AppendDouble(buffer,point[2],"%20.10e");
+      buffer += '\n';
+      }
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+};
+
+void AssignNodeOrder(std::vector<int>& nodeOrder, const int* order, int numberOfEntries)
+{
+  nodeOrder.assign(order,order+numberOfEntries);
+}
+
+}
 
 vtkStandardNewMacro(vtkvmtkFDNEUTWriter);
 
@@ -46,9 +124,9 @@ void vtkvmtkFDNEUTWriter::WriteData()
     return;
     }
         
-  FILE* FDNEUTFile = fopen(this->GetFileName(),"w");
+  std::ofstream out (this->GetFileName());
 
-  if (!FDNEUTFile)
+  if (!out.good())
     {
     vtkErrorMacro(<<"Could not open file for writing.");
     return;
@@ -103,35 +181,37 @@ void vtkvmtkFDNEUTWriter::WriteData()
       }
     }
 
-  fprintf(FDNEUTFile,"** FIDAP NEUTRAL FILE\n");
-  fprintf(FDNEUTFile,"foo\n");   // TODO: set user-defined title
-  fprintf(FDNEUTFile,"VERSION    8.6\n");
-  fprintf(FDNEUTFile," Jan 2004     \n");
-  fprintf(FDNEUTFile,"   NO. OF NODES   NO. ELEMENTS NO. ELT GROUPS          NDFCD          NDFVL\n");
-  fprintf(FDNEUTFile,"%15d%15d%15d%15d%15d\n",numberOfNodes,numberOfElements,numberOfGroups,3,3);
-  fprintf(FDNEUTFile,"   STEADY/TRANS     TURB. FLAG FREE SURF FLAG    COMPR. FLAG   RESULTS ONLY\n");
-  fprintf(FDNEUTFile,"              0              0              0              0              0\n");
-  fprintf(FDNEUTFile,"TEMPERATURE/SPECIES FLAGS\n");
-  fprintf(FDNEUTFile," 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n");
-  fprintf(FDNEUTFile,"PRESSURE FLAGS - IDCTS, IPENY MPDF\n");
-  fprintf(FDNEUTFile,"         1         1         0\n");
-
-  fprintf(FDNEUTFile,"NODAL COORDINATES\n");
-  double point[3];
-  for (k=0; k<numberOfNodes; k++)
-    {
-    input->GetPoint(k,point);
-    fprintf(FDNEUTFile,"%10d%20.10e%20.10e%20.10e\n",k+1,point[0],point[1],point[2]);
-    }
+  char str[256];
+
+  out << "** FIDAP NEUTRAL FILE\n";
+  out << "foo\n";   // TODO: set user-defined title
+  out << "VERSION    8.6\n";
+  out << " Jan 2004     \n";
+  out << "   NO. OF NODES   NO. ELEMENTS NO. ELT GROUPS          NDFCD          NDFVL\n";
+  snprintf(str,sizeof(str),"%15d%15d%15d%15d%15d\n",numberOfNodes,numberOfElements,numberOfGroups,3,3);
+  out << str;
+  out << "   STEADY/TRANS     TURB. FLAG FREE SURF FLAG    COMPR. FLAG   RESULTS ONLY\n";
+  out << "              0              0              0              0              0\n";
+  out << "TEMPERATURE/SPECIES FLAGS\n";
+  out << " 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n";
+  out << "PRESSURE FLAGS - IDCTS, IPENY MPDF\n";
+  out << "         1         1         0\n";
+
+  out << "NODAL COORDINATES\n";
+  NodeFormatter nodeFormatter(input);
+  vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfNodes,nodeFormatter);
 
-  fprintf(FDNEUTFile,"BOUNDARY CONDITIONS\n");
-  fprintf(FDNEUTFile,"         0         0         0     0.0\n");
+  out << "BOUNDARY CONDITIONS\n";
+  out << "         0         0         0     0.0\n";
 
-  fprintf(FDNEUTFile,"ELEMENT GROUPS\n");
+  out << "ELEMENT GROUPS\n";
 
   int cellCount = 1;
   int groupCount = 1;
 
+  vtkIdTypeArray* typeCellIds = vtkIdTypeArray::New();
+  std::vector<int> nodeOrder;
+
   //  for (cellType=0; cellType<numberOfCellTypes; cellType++)
   for (cellType=numberOfCellTypes-1; cellType>=0; cellType--)
     {
@@ -141,13 +221,10 @@ void vtkvmtkFDNEUTWriter::WriteData()
       }
 
     int fdneutElementType, fdneutElementGeometry, numberOfNodesInElement;
-    vtkIdType npts, *cellPoints;
-    const vtkIdType *pts;
     fdneutElementType = -1;
     fdneutElementGeometry = -1;
 
-    input->GetCellPoints(firstCellIdOfType[cellType],npts,pts);
-    numberOfNodesInElement = npts;
+    numberOfNodesInElement = input->GetCellSize(firstCellIdOfType[cellType]);
     switch (cellType)
       {
       case VTK_QUAD:
@@ -185,224 +262,95 @@ void vtkvmtkFDNEUTWriter::WriteData()
         break;
       }
 
-    int groupNumber, numberOfElementsInGroup;
-    groupNumber = groupCount;
-    numberOfElementsInGroup = numberOfTypeCells[cellType];
-
-    fprintf(FDNEUTFile,"GROUP:    %5d ELEMENTS:%10d NODES:   %10d GEOMETRY:%5d TYPE:%4d\n",groupNumber,numberOfElementsInGroup,numberOfNodesInElement,fdneutElementGeometry,fdneutElementType);
-    fprintf(FDNEUTFile,"ENTITY NAME:   Entity%d\n",groupNumber);
-
-    for (k=0; k<numberOfElements; k++)
+    // FDNEUT node ordering of the cell points, nodeOrderNewLine breaking lines
+    const int quadraticQuadOrder[] = {0,4,1,5,2,6,3,7,8};
+    const int quadraticTriangleOrder[] = {0,3,1,4,2,5};
+    const int hexahedronOrder[] = {0,1,3,2,4,5,7,6};
+    const int triquadraticHexahedronOrder[] = {0,8,1,11,24,9,3,10,2,nodeOrderNewLine,
+                                               16,20,17,23,26,21,19,22,18,nodeOrderNewLine,
+                                               4,12,5,15,25,13,7,14,6};
+    const int quadraticTetraOrder[] = {0,4,1,6,5,2,7,nodeOrderNewLine,8,9,3};
+    const int quadraticWedge18Order[] = {0,6,1,8,7,2,12,15,13,nodeOrderNewLine,17,16,14,3,9,4,11,10,5};
+    const int quadraticWedge15Order[] = {0,6,1,8,7,2,12,13,14,nodeOrderNewLine,3,9,4,11,10,5};
+
+    nodeOrder.clear();
+    switch (cellType)
       {
-      if (input->GetCellType(k) != cellType)
-        {
-        continue;
-        }
-      input->GetCellPoints(k,npts,pts);
-      cellPoints = new vtkIdType[npts];
-      memcpy(cellPoints,pts,npts*sizeof(vtkIdType));
-      this->ZeroToOneOffset(npts,cellPoints);
+      case VTK_QUAD:
+      case VTK_TRIANGLE:
+      case VTK_TETRA:
+      case VTK_WEDGE:
+        for (k=0; k<numberOfNodesInElement; k++)
+          {
+          nodeOrder.push_back(k);
+          }
+        break;
+      case VTK_QUADRATIC_QUAD:
+        AssignNodeOrder(nodeOrder,quadraticQuadOrder,numberOfNodesInElement==9 ? 9 : 8);
+        break;
+      case VTK_BIQUADRATIC_QUAD:
+        AssignNodeOrder(nodeOrder,quadraticQuadOrder,9);
+        break;
+      case VTK_QUADRATIC_TRIANGLE:
+        AssignNodeOrder(nodeOrder,quadraticTriangleOrder,6);
+        break;
+      case VTK_HEXAHEDRON:
+        AssignNodeOrder(nodeOrder,hexahedronOrder,8);
+        break;
+      case VTK_TRIQUADRATIC_HEXAHEDRON:
+        if (numberOfNodesInElement != 27)
+          {
+          vtkErrorMacro(<< "Only 27-noded hexahedra are supported in FDNEUT.");
+          }
+        AssignNodeOrder(nodeOrder,triquadraticHexahedronOrder,29);
+        break;
+      case VTK_QUADRATIC_TETRA:
+        AssignNodeOrder(nodeOrder,quadraticTetraOrder,11);
+        break;
+      case VTK_QUADRATIC_WEDGE:
+        if (numberOfNodesInElement==18)
+          {
+          AssignNodeOrder(nodeOrder,quadraticWedge18Order,19);
+          }
+        else if (numberOfNodesInElement==15)
+          {
+          AssignNodeOrder(nodeOrder,quadraticWedge15Order,16);
+          }
+        break;
+      }
 
-      if (npts != numberOfNodesInElement)
+    input->GetIdsOfCellsOfType(cellType,typeCellIds);
+    vtkIdType numberOfCellsInGroup = typeCellIds->GetNumberOfTuples();
+    for (k=0; k<numberOfCellsInGroup; k++)
+      {
+      if (input->GetCellSize(typeCellIds->GetValue(k)) != numberOfNodesInElement)
         {
         vtkErrorMacro(<<"Can't handle same cell types with different number of points");
+        typeCellIds->Delete();
         return;
         }
-
-      fprintf(FDNEUTFile,"%8d",(int)cellCount);
-   
-      int i;
-      switch (cellType)
-        {
-        case VTK_QUAD:
-          for (i=0; i<numberOfNodesInElement; i++)
-            {
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[i]);
-            }
-          break;
-        case VTK_QUADRATIC_QUAD:
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[0]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[4]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[1]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[5]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[2]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[6]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[3]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[7]);
-          if (numberOfNodesInElement==9)
-            {
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[8]);
-            }
-          break;
-        case VTK_BIQUADRATIC_QUAD:
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[0]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[4]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[1]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[5]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[2]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[6]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[3]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[7]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[8]);
-          break;
-        case VTK_TRIANGLE:
-          for (i=0; i<numberOfNodesInElement; i++)
-            {
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[i]);
-            }
-          break;
-        case VTK_QUADRATIC_TRIANGLE:
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[0]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[3]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[1]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[4]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[2]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[5]);
-          break;
-        case VTK_HEXAHEDRON:
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[0]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[1]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[3]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[2]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[4]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[5]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[7]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[6]);
-          break;
-        case VTK_TRIQUADRATIC_HEXAHEDRON:
-          if (numberOfNodesInElement != 27)
-            {
-            vtkErrorMacro(<< "Only 27-noded hexahedra are supported in FDNEUT.");
-            }
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[0]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[8]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[1]);
-
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[11]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[24]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[9]);
-
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[3]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[10]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[2]);
-
-          fprintf(FDNEUTFile,"\n");
-
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[16]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[20]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[17]);
-
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[23]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[26]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[21]);
-
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[19]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[22]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[18]);
-
-          fprintf(FDNEUTFile,"\n");
-
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[4]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[12]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[5]);
-
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[15]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[25]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[13]);
-
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[7]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[14]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[6]);
-
-          break;
-        case VTK_TETRA:
-          for (i=0; i<numberOfNodesInElement; i++)
-            {
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[i]);
-            }
-          break;
-        case VTK_QUADRATIC_TETRA:
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[0]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[4]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[1]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[6]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[5]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[2]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[7]);
-          fprintf(FDNEUTFile,"\n");
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[8]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[9]);
-          fprintf(FDNEUTFile,"%8d",(int)cellPoints[3]);
-          break;
-        case WEDGE:
-          for (i=0; i<numberOfNodesInElement; i++)
-            {
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[i]);
-            }
-          break;
-        case VTK_QUADRATIC_WEDGE:
-          if (numberOfNodesInElement==18)
-            {
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[0]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[6]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[1]);
-
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[8]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[7]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[2]);
-
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[12]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[15]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[13]);
-
-            fprintf(FDNEUTFile,"\n");
-
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[17]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[16]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[14]);
-
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[3]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[9]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[4]);
-
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[11]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[10]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[5]);
-            }
-          else if (numberOfNodesInElement==15)
-            {
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[0]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[6]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[1]);
-
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[8]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[7]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[2]);
-
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[12]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[13]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[14]);
-
-            fprintf(FDNEUTFile,"\n");
-
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[3]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[9]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[4]);
-
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[11]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[10]);
-            fprintf(FDNEUTFile,"%8d",(int)cellPoints[5]);
-            }
-          break;
-        }
-      fprintf(FDNEUTFile,"\n");
-      cellCount++;
-      delete[] cellPoints;
       }
+
+    int groupNumber, numberOfElementsInGroup;
+    groupNumber = groupCount;
+    numberOfElementsInGroup = numberOfTypeCells[cellType];
+
+    snprintf(str,sizeof(str),"GROUP:    %5d ELEMENTS:%10d NODES:   %10d GEOMETRY:%5d TYPE:%4d\n",groupNumber,numberOfElementsInGroup,numberOfNodesInElement,fdneutElementGeometry,fdneutElementType);
+    out << str;
+    out << "ENTITY NAME:   Entity" << groupNumber << "\n";
+
+    ElementFormatter elementFormatter(input,typeCellIds,nodeOrder,cellCount);
+    vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfCellsInGroup,elementFormatter);
+    cellCount += numberOfCellsInGroup;
     ++groupCount;
     }
 
-  fclose(FDNEUTFile);
+  typeCellIds->Delete();
+
+  if (!out.good())
+    {
+    vtkErrorMacro(<<"Error writing file.");
+    }
 }
 
 void vtkvmtkFDNEUTWriter::PrintSelf(std::ostream& os, vtkIndent indent)
@@ -29,37 +29,31 @@ Version:   $Revision: 1.6 $
 #include "vtkCellData.h"
 #include "vtkIntArray.h"
 #include "vtkIdTypeArray.h"
+#include "vtkIdList.h"
+#include "vtkByteSwap.h"
 #include "vtkMath.h"
+#include "vtkSMPTools.h"
 #include "vtkObjectFactory.h"
 #include "vtkvmtkConstants.h"
+#include "vtkvmtkTextWriterUtilities.h"
 
+#include <algorithm>
+#include <vector>
 
-vtkStandardNewMacro(vtkvmtkFluentWriter);
 
-vtkvmtkFluentWriter::vtkvmtkFluentWriter()
+namespace
 {
-  this->BoundaryDataArrayName = NULL;
-}
-
-vtkvmtkFluentWriter::~vtkvmtkFluentWriter()
-{
-  if (this->BoundaryDataArrayName)
-    {
-    delete[] this->BoundaryDataArrayName;
-    this->BoundaryDataArrayName = NULL;
-    }
-}
 
-void vtkvmtkFluentWriter::ConvertFaceToLeftHanded(vtkUnstructuredGrid* input, vtkIdType tetraCellId, vtkIdType& id0, vtkIdType& id1, vtkIdType& id2)
+// Swaps id1 and id2 if needed so that (p1-p0)x(p2-p0) points towards the
+// fourth point of the tetrahedron with point ids tetraPointIds.
+void ConvertFaceToLeftHanded(vtkUnstructuredGrid* input, const vtkIdType* tetraPointIds, vtkIdType& id0, vtkIdType& id1, vtkIdType& id2)
 {
-  vtkTetra* tetra = vtkTetra::SafeDownCast(input->GetCell(tetraCellId));
-  vtkIdList* cellPointIds = tetra->GetPointIds();
   vtkIdType id3 = -1;
   vtkIdType tmpId = -1;
   int k;
   for (k=0; k<4; k++)
     {
-    tmpId = cellPointIds->GetId(k);
+    tmpId = tetraPointIds[k];
     if (tmpId != id0 && tmpId != id1 && tmpId != id2)
       {
       id3 = tmpId;
@@ -97,6 +91,340 @@ void vtkvmtkFluentWriter::ConvertFaceToLeftHanded(vtkUnstructuredGrid* input, vt
     }
 }
 
+// Ids are written as "%x" of an int, as in the rest of the file, or as
+// little endian 32 bit integers in binary sections.
+inline void AppendFluentId(std::string& buffer, vtkIdType value, bool binary)
+{
+  if (binary)
+    {
+    int binaryValue = static_cast<int>(value);
+    vtkByteSwap::Swap4LE(&binaryValue);
+    buffer.append(reinterpret_cast<const char*>(&binaryValue),sizeof(binaryValue));
+    return;
+    }
+  buffer += ' ';
+  vtkvmtkTextWriterUtilities::AppendHex(buffer,static_cast<unsigned int>(static_cast<int>(value)));
+}
+
+inline void AppendFace(std::string& buffer, vtkIdType id0, vtkIdType id1, vtkIdType id2, vtkIdType cell0, vtkIdType cell1, bool binary)
+{
+  if (binary)
+    {
+    AppendFluentId(buffer,3,true);
+    }
+  else
+    {
+    buffer += " 3";
+    }
+  AppendFluentId(buffer,id0+1,binary);
+  AppendFluentId(buffer,id1+1,binary);
+  AppendFluentId(buffer,id2+1,binary);
+  AppendFluentId(buffer,cell0,binary);
+  AppendFluentId(buffer,cell1,binary);
+  if (!binary)
+    {
+    buffer += '\n';
+    }
+}
+
+// Triangular faces of the tetrahedra, hashed on their sorted point ids.
+// Each face records how many tetrahedra share it and the first two of them,
+// in the order they were inserted. Faces are stored densely in insertion
+// order; the open-addressing probe array only holds face indices, so it is
+// sized by the expected number of unique faces and grown if that is exceeded.
+class FaceTable
+{
+public:
+  FaceTable(vtkIdType expectedNumberOfFaces)
+  {
+    this->Keys.reserve(3*expectedNumberOfFaces);
+    this->Counts.reserve(expectedNumberOfFaces);
+    this->Cells.reserve(2*expectedNumberOfFaces);
+    this->Allocate(expectedNumberOfFaces);
+  }
+
+  vtkIdType Insert(vtkIdType id0, vtkIdType id1, vtkIdType id2, vtkIdType cellId)
+  {
+    SortIds(id0,id1,id2);
+    vtkIdType slot = this->Probe(id0,id1,id2);
+    vtkIdType face = this->Slots[slot];
+    if (face == -1)
+      {
+      face = static_cast<vtkIdType>(this->Counts.size());
+      this->Keys.push_back(id0);
+      this->Keys.push_back(id1);
+      this->Keys.push_back(id2);
+      this->Counts.push_back(0);
+      this->Cells.push_back(-1);
+      this->Cells.push_back(-1);
+      this->Slots[slot] = face;
+      if (4*(face+1) > 3*static_cast<vtkIdType>(this->Slots.size()))
+        {
+        this->Allocate(2*(face+1));
+        }
+      }
+    if (this->Counts[face] < 2)
+      {
+      this->Cells[2*face+this->Counts[face]] = cellId;
+      }
+    this->Counts[face]++;
+    return face;
+  }
+
+  vtkIdType Find(vtkIdType id0, vtkIdType id1, vtkIdType id2) const
+  {
+    SortIds(id0,id1,id2);
+    return this->Slots[this->Probe(id0,id1,id2)];
+  }
+
+  int GetCount(vtkIdType face) const { return this->Counts[face]; }
+  vtkIdType GetCell(vtkIdType face, int k) const { return this->Cells[2*face+k]; }
+
+  vtkIdType GetNumberOfSharedFaces() const
+  {
+    vtkIdType numberOfSharedFaces = 0;
+    for (size_t face=0; face<this->Counts.size(); face++)
+      {
+      if (this->Counts[face] == 2)
+        {
+        numberOfSharedFaces++;
+        }
+      }
+    return numberOfSharedFaces;
+  }
+
+private:
+  static void SortIds(vtkIdType& id0, vtkIdType& id1, vtkIdType& id2)
+  {
+    if (id0 > id1) std::swap(id0,id1);
+    if (id1 > id2) std::swap(id1,id2);
+    if (id0 > id1) std::swap(id0,id1);
+  }
+
+  // Probe array with a load factor between 3/8 and 3/4, rehashing the
+  // faces stored so far.
+  void Allocate(vtkIdType numberOfFaces)
+  {
+    vtkIdType capacity = 16;
+    while (3*capacity < 4*numberOfFaces)
+      {
+      capacity *= 2;
+      }
+    this->Mask = capacity - 1;
+    this->Slots.assign(capacity,-1);
+    vtkIdType numberOfStoredFaces = static_cast<vtkIdType>(this->Counts.size());
+    for (vtkIdType face=0; face<numberOfStoredFaces; face++)
+      {
+      this->Slots[this->Probe(this->Keys[3*face],this->Keys[3*face+1],this->Keys[3*face+2])] = face;
+      }
+  }
+
+  // Slot holding the face with the given sorted ids, or the empty slot where
+  // it would be inserted.
+  vtkIdType Probe(vtkIdType id0, vtkIdType id1, vtkIdType id2) const
+  {
+    vtkIdType slot = this->Hash(id0,id1,id2);
+    while (this->Slots[slot] != -1 && !this->Matches(this->Slots[slot],id0,id1,id2))
+      {
+      slot = (slot + 1) & this->Mask;
+      }
+    return slot;
+  }
+
+  vtkIdType Hash(vtkIdType id0, vtkIdType id1, vtkIdType id2) const
+  {
+    unsigned long long hash = static_cast<unsigned long long>(id0);
+    hash = hash * 0x9E3779B97F4A7C15ULL ^ static_cast<unsigned long long>(id1);
+    hash = hash * 0x9E3779B97F4A7C15ULL ^ static_cast<unsigned long long>(id2);
+    hash *= 0x9E3779B97F4A7C15ULL;
+    return static_cast<vtkIdType>(hash >> 32) & this->Mask;
+  }
+
+  bool Matches(vtkIdType face, vtkIdType id0, vtkIdType id1, vtkIdType id2) const
+  {
+    return this->Keys[3*face] == id0 && this->Keys[3*face+1] == id1 && this->Keys[3*face+2] == id2;
+  }
+
+  vtkIdType Mask;
+  std::vector<vtkIdType> Slots;
+  std::vector<vtkIdType> Keys;
+  std::vector<int> Counts;
+  std::vector<vtkIdType> Cells;
+};
+
+class TetraPointsFunctor
+{
+public:
+  TetraPointsFunctor(vtkUnstructuredGrid* input, vtkIdTypeArray* tetraCellIds, std::vector<vtkIdType>& tetraPoints) : Input(input), TetraCellIds(tetraCellIds), TetraPoints(tetraPoints) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkIdList* cellPointIds = vtkIdList::New();
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Input->GetCellPoints(this->TetraCellIds->GetValue(i),cellPointIds);
+      for (int k=0; k<4; k++)
+        {
+        this->TetraPoints[4*i+k] = cellPointIds->GetId(k);
+        }
+      }
+    cellPointIds->Delete();
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  vtkIdTypeArray* TetraCellIds;
+  std::vector<vtkIdType>& TetraPoints;
+};
+
+class NodeFormatter
+{
+public:
+  NodeFormatter(vtkUnstructuredGrid* input, bool binary) : Input(input), Binary(binary) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    double point[3];
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Input->GetPoint(i,point);
+      if (this->Binary)
+        {
+        vtkByteSwap::Swap8LERange(point,3);
+        buffer.append(reinterpret_cast<const char*>(point),sizeof(point));
+        continue;
+        }
+      for (int k=0; k<3; k++)
+        {
+        buffer += "  ";
+        vtkvmtkTextWriterUtilities::AppendDouble(buffer,point[k],"%17.10e");
+        }
+      buffer += '\n';
+      }
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  bool Binary;
+};
+
+// Boundary triangles, oriented with respect to the adjacent tetrahedron.
+class BoundaryFaceFormatter
+{
+public:
+  BoundaryFaceFormatter(vtkUnstructuredGrid* input, const std::vector<vtkIdType>& triangleCellIds, const FaceTable& faces, const std::vector<vtkIdType>& tetraPoints, bool binary)
+    : Input(input), TriangleCellIds(triangleCellIds), Faces(faces), TetraPoints(tetraPoints), Binary(binary) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    vtkIdList* cellPointIds = vtkIdList::New();
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      vtkIdType triangleCellId = this->TriangleCellIds[i];
+      this->Input->GetCellPoints(triangleCellId,cellPointIds);
+      vtkIdType id0 = cellPointIds->GetId(0);
+      vtkIdType id1 = cellPointIds->GetId(1);
+      vtkIdType id2 = cellPointIds->GetId(2);
+      vtkIdType face = this->Faces.Find(id0,id1,id2);
+      vtkIdType tetraId = face != -1 ? this->Faces.GetCell(face,0) : -1;
+      if (tetraId != -1)
+        {
+        ConvertFaceToLeftHanded(this->Input,&this->TetraPoints[4*tetraId],id0,id1,id2);
+        }
+      AppendFace(buffer,id0,id1,id2,tetraId+1,0,this->Binary);
+      }
+    cellPointIds->Delete();
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  const std::vector<vtkIdType>& TriangleCellIds;
+  const FaceTable& Faces;
+  const std::vector<vtkIdType>& TetraPoints;
+  bool Binary;
+};
+
+// Faces shared by two tetrahedra, written once from the tetrahedron that
+// comes first.
+class InteriorFaceFormatter
+{
+public:
+  InteriorFaceFormatter(vtkUnstructuredGrid* input, const FaceTable& faces, const std::vector<vtkIdType>& tetraFaces, const std::vector<vtkIdType>& tetraPoints, bool binary)
+    : Input(input), Faces(faces), TetraFaces(tetraFaces), TetraPoints(tetraPoints), Binary(binary) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      const vtkIdType* tetraPointIds = &this->TetraPoints[4*i];
+      int j;
+      for (j=0; j<4; j++)
+        {
+        vtkIdType face = this->TetraFaces[4*i+j];
+        if (this->Faces.GetCount(face) != 2 || this->Faces.GetCell(face,0) != i)
+          {
+          continue;
+          }
+        auto faceIds = vtkTetra::GetFaceArray(j);
+        vtkIdType id0 = tetraPointIds[faceIds[0]];
+        vtkIdType id1 = tetraPointIds[faceIds[1]];
+        vtkIdType id2 = tetraPointIds[faceIds[2]];
+        ConvertFaceToLeftHanded(this->Input,tetraPointIds,id0,id1,id2);
+        AppendFace(buffer,id0,id1,id2,i+1,this->Faces.GetCell(face,1)+1,this->Binary);
+        }
+      }
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  const FaceTable& Faces;
+  const std::vector<vtkIdType>& TetraFaces;
+  const std::vector<vtkIdType>& TetraPoints;
+  bool Binary;
+};
+
+// Opening of a data section, binary variants (20xx, 30xx) if requested.
+void WriteSectionHeader(std::ostream& out, int section, const char* header, bool binary)
+{
+  out << "(" << section << " " << header << "(";
+  if (!binary)
+    {
+    out << "\n";
+    }
+}
+
+void WriteSectionFooter(std::ostream& out, int section, bool binary)
+{
+  if (binary)
+    {
+    char str[64];
+    sprintf(str,")\nEnd of Binary Section %6d)\n\n",section);
+    out << str;
+    }
+  else
+    {
+    out << "))\n\n";
+    }
+}
+
+}
+
+vtkStandardNewMacro(vtkvmtkFluentWriter);
+
+vtkvmtkFluentWriter::vtkvmtkFluentWriter()
+{
+  this->BoundaryDataArrayName = NULL;
+}
+
+vtkvmtkFluentWriter::~vtkvmtkFluentWriter()
+{
+  if (this->BoundaryDataArrayName)
+    {
+    delete[] this->BoundaryDataArrayName;
+    this->BoundaryDataArrayName = NULL;
+    }
+}
+
 void vtkvmtkFluentWriter::WriteData()
 {
   vtkUnstructuredGrid *input= vtkUnstructuredGrid::SafeDownCast(this->GetInput());
@@ -116,8 +444,10 @@ void vtkvmtkFluentWriter::WriteData()
     vtkErrorMacro(<<"FileName not set.");
     return;
     }
-        
-  std::ofstream out (this->GetFileName());
+
+  const bool binary = this->GetFileType() == VTK_BINARY;
+
+  std::ofstream out (this->GetFileName(), binary ? std::ios::out | std::ios::binary : std::ios::out);
 
   if (!out.good())
     {
@@ -125,8 +455,6 @@ void vtkvmtkFluentWriter::WriteData()
     return;
     }
   
-  input->BuildLinks();
-
   int numberOfPoints = input->GetNumberOfPoints();
 
   vtkIntArray* boundaryDataArray = vtkIntArray::New();
@@ -153,56 +481,75 @@ void vtkvmtkFluentWriter::WriteData()
   input->GetIdsOfCellsOfType(VTK_TETRA,tetraCellIdArray);
   int numberOfTetras = tetraCellIdArray->GetNumberOfTuples();
 
-  vtkIdList* tetraCellIdMap = vtkIdList::New();
-  tetraCellIdMap->SetNumberOfIds(numberOfCells);
-  
   int i;
 
-  for (i=0; i<numberOfCells; i++)
-    {
-    tetraCellIdMap->SetId(i,-1);
-    }
+  // Face table built once over all tetrahedra, in tetrahedron numbering
+  std::vector<vtkIdType> tetraPoints(4*numberOfTetras);
+  TetraPointsFunctor tetraPointsFunctor(input,tetraCellIdArray,tetraPoints);
+  vtkSMPTools::For(0,numberOfTetras,tetraPointsFunctor);
 
+  vtkIdTypeArray* triangleCellIdArray = vtkIdTypeArray::New();
+  input->GetIdsOfCellsOfType(VTK_TRIANGLE,triangleCellIdArray);
+  int numberOfTriangles = triangleCellIdArray->GetNumberOfTuples();
+
+  // Each interior face is shared by two tetrahedra, so there are about
+  // 2 faces per tetrahedron plus half of the boundary triangles; the
+  // boundary is counted in full to leave some headroom
+  FaceTable faces(2*static_cast<vtkIdType>(numberOfTetras)+numberOfTriangles);
+  std::vector<vtkIdType> tetraFaces(4*numberOfTetras);
   for (i=0; i<numberOfTetras; i++)
     {
-    tetraCellIdMap->SetId(tetraCellIdArray->GetValue(i),i);
+    for (int j=0; j<4; j++)
+      {
+      auto faceIds = vtkTetra::GetFaceArray(j);
+      tetraFaces[4*i+j] = faces.Insert(tetraPoints[4*i+faceIds[0]],tetraPoints[4*i+faceIds[1]],tetraPoints[4*i+faceIds[2]],i);
+      }
     }
 
-  vtkIdTypeArray* triangleCellIdArray = vtkIdTypeArray::New();
-  input->GetIdsOfCellsOfType(VTK_TRIANGLE,triangleCellIdArray);
-  int numberOfTriangles = triangleCellIdArray->GetNumberOfTuples();
+  vtkIdList* triangleCellPointIds = vtkIdList::New();
+  for (i=0; i<numberOfTriangles; i++)
+    {
+    input->GetCellPoints(triangleCellIdArray->GetValue(i),triangleCellPointIds);
+    if (faces.Find(triangleCellPointIds->GetId(0),triangleCellPointIds->GetId(1),triangleCellPointIds->GetId(2)) == -1)
+      {
+      vtkWarningMacro(<<"Boundary triangle not on a tetrahedron.");
+      break;
+      }
+    }
+  triangleCellPointIds->Delete();
 
 //  out << "(0 \"Fluent file generated by the Vascular Modeling Toolkit - www.vmtk.org\" )" << endl;
-  out << "(0 \"GAMBIT to Fluent File\")" << endl;
-  out << "(0 \"Dimension:\")" << endl;
-  out << "(2 3)" << endl;
-  out << endl;
+  out << "(0 \"GAMBIT to Fluent File\")\n";
+  out << "(0 \"Dimension:\")\n";
+  out << "(2 3)\n";
+  out << "\n";
 
   char str[200];
 
   sprintf(str,"(10 (0 1 %x 1 3))",numberOfPoints);
-  out << str << endl;
-  sprintf(str,"(10 (1 1 %x 1 3)(",numberOfPoints);
-  out << str << endl;
-
-  out.precision(6);
+  out << str << "\n";
+  sprintf(str,"(1 1 %x 1 3)",numberOfPoints);
+  WriteSectionHeader(out,binary ? 3010 : 10,str,binary);
 
-  double point[3];
-  for (i=0; i<numberOfPoints; i++)
+  NodeFormatter nodeFormatter(input,binary);
+  vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfPoints,nodeFormatter);
+  if (binary)
+    {
+    WriteSectionFooter(out,3010,binary);
+    }
+  else
     {
-    input->GetPoint(i,point);
-    sprintf(str,"  %17.10e  %17.10e  %17.10e",point[0],point[1],point[2]);
-    out << str << endl;
+    out << " ))\n\n";
     }
-  out << " ))" << endl << endl;
 
-  out << "(0 \"Faces:\")" << endl;
+  out << "(0 \"Faces:\")\n";
 
-  int numberOfInteriorFaces = 2*numberOfTetras - numberOfTriangles/2;
+  int numberOfInteriorFaces = static_cast<int>(faces.GetNumberOfSharedFaces());
 
   sprintf(str,"(13 (0 1 %x 0))",numberOfInteriorFaces+numberOfTriangles);
-  out << str << endl; 
+  out << str << "\n"; 
 
+  const int faceSection = binary ? 2013 : 13;
   int faceOffset = 1;
 
   vtkIdList* boundaryDataNumberOfTriangles = vtkIdList::New();
@@ -213,6 +560,7 @@ void vtkvmtkFluentWriter::WriteData()
     boundaryDataNumberOfTriangles->SetId(i,0);
     }
   int boundaryDataValue, value;
+  int n;
   for (i=0; i<numberOfTriangles; i++)
     {
     vtkIdType triangleCellId = triangleCellIdArray->GetValue(i);
@@ -221,10 +569,20 @@ void vtkvmtkFluentWriter::WriteData()
     boundaryDataNumberOfTriangles->SetId(boundaryDataValue,value+1);
     }
 
-  vtkIdList* neighborCellIds = vtkIdList::New();
+  // Triangle cell ids grouped by boundary value
+  std::vector<std::vector<vtkIdType> > boundaryDataTriangleCellIds(boundaryDataRange+1);
+  for (n=0; n<boundaryDataRange+1; n++)
+    {
+    boundaryDataTriangleCellIds[n].reserve(boundaryDataNumberOfTriangles->GetId(n));
+    }
+  for (i=0; i<numberOfTriangles; i++)
+    {
+    vtkIdType triangleCellId = triangleCellIdArray->GetValue(i);
+    boundaryDataTriangleCellIds[boundaryDataArray->GetValue(triangleCellId)].push_back(triangleCellId);
+    }
+
   const int entityOffset = 3;
   int entityId = entityOffset;
-  int n;
   for (n=0; n<boundaryDataRange+1; n++)
     {
     int numberOfBoundaryTriangles = boundaryDataNumberOfTriangles->GetId(n);
@@ -233,78 +591,32 @@ void vtkvmtkFluentWriter::WriteData()
       continue;
       }
     //sprintf(str,"(13 (%x %x %x %x 0)(",entityId,faceOffset,faceOffset+numberOfBoundaryTriangles-1,entityId);
-    sprintf(str,"(13 (%x %x %x 3 0)(",entityId,faceOffset,faceOffset+numberOfBoundaryTriangles-1);
+    sprintf(str,"(%x %x %x 3 0)",entityId,faceOffset,faceOffset+numberOfBoundaryTriangles-1);
     entityId++;
-    out << str << endl;
-    for (i=0; i<numberOfTriangles; i++)
-      {
-      vtkIdType triangleCellId = triangleCellIdArray->GetValue(i);
-      if (boundaryDataArray->GetValue(triangleCellId) != n)
-        {
-        continue;
-        }
-      vtkIdList* cellPointIds = input->GetCell(triangleCellId)->GetPointIds();
-      vtkIdType id0 = cellPointIds->GetId(0);
-      vtkIdType id1 = cellPointIds->GetId(1);
-      vtkIdType id2 = cellPointIds->GetId(2);
-      input->GetCellNeighbors(triangleCellId,cellPointIds,neighborCellIds);
-      vtkIdType tetraCellId = neighborCellIds->GetId(0);
-      this->ConvertFaceToLeftHanded(input,tetraCellId,id0,id1,id2);
-      sprintf(str," 3 %x %x %x %x 0",(int)id0+1,(int)id1+1,(int)id2+1,(int)tetraCellId+1);
-      out << str << endl;
-      }
-    out << "))" << endl << endl;
+    WriteSectionHeader(out,faceSection,str,binary);
+    BoundaryFaceFormatter boundaryFaceFormatter(input,boundaryDataTriangleCellIds[n],faces,tetraPoints,binary);
+    vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfBoundaryTriangles,boundaryFaceFormatter);
+    WriteSectionFooter(out,faceSection,binary);
     faceOffset += numberOfBoundaryTriangles;
     }
 
-  sprintf(str,"(13 (%x %x %x 2 0)(",(int)entityId,faceOffset,faceOffset+numberOfInteriorFaces-1);
-  out << str << endl;
+  sprintf(str,"(%x %x %x 2 0)",(int)entityId,faceOffset,faceOffset+numberOfInteriorFaces-1);
+  WriteSectionHeader(out,faceSection,str,binary);
 
-//TODO: loop over tets and write interior faces.
 //one space, #points on the face, pid1, pid2, pid3, tetraid1, tetraid2
-  for (i=0; i<numberOfTetras; i++)
-    {
-    vtkIdType tetraCellId = tetraCellIdArray->GetValue(i);
-    vtkTetra* tetra = vtkTetra::SafeDownCast(input->GetCell(tetraCellId));
-    int j;
-    for (j=0; j<4; j++)
-      {
-      vtkCell* face = tetra->GetFace(j);
-      vtkIdList* facePointIds = face->GetPointIds();
-      vtkIdType id0 = facePointIds->GetId(0);
-      vtkIdType id1 = facePointIds->GetId(1);
-      vtkIdType id2 = facePointIds->GetId(2);
-      input->GetCellNeighbors(tetraCellId,facePointIds,neighborCellIds);
-      if (neighborCellIds->GetNumberOfIds() != 1)
-        {
-        continue;
-        }
-      if (input->GetCellType(neighborCellIds->GetId(0)) != VTK_TETRA)
-        {
-        continue;
-        }
-      if (neighborCellIds->GetId(0) < tetraCellId)
-        {
-        continue;
-        }
-      this->ConvertFaceToLeftHanded(input,tetraCellId,id0,id1,id2);
-      sprintf(str," 3 %x %x %x %x %x",(int)id0+1,(int)id1+1,(int)id2+1,(int)tetraCellIdMap->GetId(tetraCellId)+1,(int)tetraCellIdMap->GetId(neighborCellIds->GetId(0))+1);
-      out << str << endl;
-      }
-    }
-  out << "))" << endl << endl;
+  InteriorFaceFormatter interiorFaceFormatter(input,faces,tetraFaces,tetraPoints,binary);
+  vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfTetras,interiorFaceFormatter);
+  WriteSectionFooter(out,faceSection,binary);
   faceOffset += numberOfInteriorFaces;
 
-  neighborCellIds->Delete();
-
-  out << "(0 \"Cells:\")" << endl;
+  out << "(0 \"Cells:\")\n";
   sprintf(str,"(12 (0 1 %x 0))",numberOfTetras);
-  out << str << endl;
+  out << str << "\n";
   sprintf(str,"(12 (2 1 %x 1 2))",numberOfTetras);
-  out << str << endl << endl;
+  out << str << "\n\n";
 
-  out << "(0 \"Zones:\")" << endl;
-  out << "(45 (2 fluid blood)())" << endl;
+  out << "(0 \"Zones:\")\n";
+  out << "(45 (2 fluid blood)())\n";
   int numberOfBoundaryTriangles = 0;
   entityId = entityOffset;
   for (n=0; n<boundaryDataRange+1; n++)
@@ -316,15 +628,20 @@ void vtkvmtkFluentWriter::WriteData()
       }
     sprintf(str,"(45 (%x wall surface%d)())",entityId,entityId);
     entityId++;
-    out << str << endl;
+    out << str << "\n";
     }
   sprintf(str,"(45 (%x interior default-interior)())",entityId);
-  out << str << endl;
+  out << str << "\n";
+
+  if (!out.good())
+    {
+    vtkErrorMacro(<<"Error writing file.");
+    }
 
   boundaryDataNumberOfTriangles->Delete();
+  boundaryDataArray->Delete();
   triangleCellIdArray->Delete();
   tetraCellIdArray->Delete();
-  tetraCellIdMap->Delete();
 }
 
 void vtkvmtkFluentWriter::PrintSelf(std::ostream& os, vtkIndent indent)
@@ -48,8 +48,6 @@ protected:
   vtkvmtkFluentWriter();
   ~vtkvmtkFluentWriter();
 
-  void ConvertFaceToLeftHanded(vtkUnstructuredGrid* input, vtkIdType tetraCellId, vtkIdType& id0, vtkIdType& id1, vtkIdType& id2);
-
   void WriteData() override;
 
   char* BoundaryDataArrayName;
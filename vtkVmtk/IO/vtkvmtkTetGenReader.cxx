@@ -21,6 +21,7 @@ Version:   Revision: 1.0
 
 #include "vtkvmtkTetGenReader.h"
 #include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
 #include "vtkIntArray.h"
 #include "vtkObjectFactory.h"
 #include "vtkPoints.h"
@@ -33,11 +34,157 @@ Version:   Revision: 1.0
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkSMPTools.h"
 #include "vtkvmtkConstants.h"
+#include "vtkvmtkTextReaderUtilities.h"
 
 #include <sstream>
+#include <vector>
 
 
+namespace
+{
+
+// Reads the first numberOfValues tokens of the file as integers and returns
+// the beginning of the line following them, where records start.
+const char* ReadHeader(const char* begin, const char* end, int numberOfValues, int* values)
+{
+  const char* p = begin;
+  const char* tokenBegin;
+  const char* tokenEnd;
+  for (int i=0; i<numberOfValues; i++)
+    {
+    if (!vtkvmtkTextReaderUtilities::NextToken(p,end,tokenBegin,tokenEnd,'#'))
+      {
+      return NULL;
+      }
+    values[i] = static_cast<int>(vtkvmtkTextReaderUtilities::ParseInteger(tokenBegin,tokenEnd));
+    }
+  return vtkvmtkTextReaderUtilities::NextLine(p,end);
+}
+
+// Node records: index, coordinates, attributes and an optional boundary marker.
+class NodeTokenFunctor
+{
+public:
+  NodeTokenFunctor(vtkIdType numberOfNodes, int dimension, int numberOfAttributes, int boundaryMarkers,
+                   vtkIdType* indices, float* points, double** attributes, vtkIdType* boundaryIds)
+    : NumberOfNodes(numberOfNodes), Dimension(dimension), NumberOfAttributes(numberOfAttributes), Stride(1+dimension+numberOfAttributes+boundaryMarkers),
+      Indices(indices), Points(points), Attributes(attributes), BoundaryIds(boundaryIds) {}
+
+  void operator()(vtkIdType tokenId, const char* begin, const char* end) const
+  {
+    vtkIdType i = tokenId / this->Stride;
+    int field = static_cast<int>(tokenId % this->Stride);
+    if (i >= this->NumberOfNodes)
+      {
+      return;
+      }
+    if (field == 0)
+      {
+      this->Indices[i] = vtkvmtkTextReaderUtilities::ParseInteger(begin,end);
+      for (int d=this->Dimension; d<3; d++)
+        {
+        this->Points[3*i+d] = 0.0f;
+        }
+      }
+    else if (field <= this->Dimension)
+      {
+      if (field <= 3)
+        {
+        this->Points[3*i+field-1] = static_cast<float>(vtkvmtkTextReaderUtilities::ParseDouble(begin,end));
+        }
+      }
+    else if (field <= this->Dimension + this->NumberOfAttributes)
+      {
+      this->Attributes[field-this->Dimension-1][i] = vtkvmtkTextReaderUtilities::ParseDouble(begin,end);
+      }
+    else
+      {
+      this->BoundaryIds[i] = vtkvmtkTextReaderUtilities::ParseInteger(begin,end);
+      }
+  }
+
+private:
+  vtkIdType NumberOfNodes;
+  int Dimension;
+  int NumberOfAttributes;
+  int Stride;
+  vtkIdType* Indices;
+  float* Points;
+  double** Attributes;
+  vtkIdType* BoundaryIds;
+};
+
+// Element records: index, point ids and attributes.
+class ElementTokenFunctor
+{
+public:
+  ElementTokenFunctor(vtkIdType numberOfElements, int nodesPerElement, int numberOfAttributes, vtkIdType firstIndex,
+                      vtkIdType* connectivity, double** attributes)
+    : NumberOfElements(numberOfElements), NodesPerElement(nodesPerElement), Stride(1+nodesPerElement+numberOfAttributes), FirstIndex(firstIndex),
+      Connectivity(connectivity), Attributes(attributes) {}
+
+  void operator()(vtkIdType tokenId, const char* begin, const char* end) const
+  {
+    vtkIdType i = tokenId / this->Stride;
+    int field = static_cast<int>(tokenId % this->Stride);
+    if (i >= this->NumberOfElements || field == 0)
+      {
+      return;
+      }
+    if (field <= this->NodesPerElement)
+      {
+      this->Connectivity[i*this->NodesPerElement+field-1] = vtkvmtkTextReaderUtilities::ParseInteger(begin,end) - this->FirstIndex;
+      }
+    else
+      {
+      this->Attributes[field-this->NodesPerElement-1][i] = vtkvmtkTextReaderUtilities::ParseDouble(begin,end);
+      }
+  }
+
+private:
+  vtkIdType NumberOfElements;
+  int NodesPerElement;
+  int Stride;
+  vtkIdType FirstIndex;
+  vtkIdType* Connectivity;
+  double** Attributes;
+};
+
+// Cell boundary markers, the largest marker of the element points but the first.
+class CellBoundaryFunctor
+{
+public:
+  CellBoundaryFunctor(int nodesPerElement, const vtkIdType* connectivity, const vtkIdType* pointBoundaryIds, vtkIdType* cellBoundaryIds)
+    : NodesPerElement(nodesPerElement), Connectivity(connectivity), PointBoundaryIds(pointBoundaryIds), CellBoundaryIds(cellBoundaryIds) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      vtkIdType maxBoundaryId = 0;
+      for (int j=1; j<this->NodesPerElement; j++)
+        {
+        vtkIdType boundaryId = this->PointBoundaryIds[this->Connectivity[i*this->NodesPerElement+j]];
+        if (boundaryId > maxBoundaryId)
+          {
+          maxBoundaryId = boundaryId;
+          }
+        }
+      this->CellBoundaryIds[i] = maxBoundaryId;
+      }
+  }
+
+private:
+  int NodesPerElement;
+  const vtkIdType* Connectivity;
+  const vtkIdType* PointBoundaryIds;
+  vtkIdType* CellBoundaryIds;
+};
+
+}
+
 vtkStandardNewMacro(vtkvmtkTetGenReader);
 
 vtkvmtkTetGenReader::vtkvmtkTetGenReader()
@@ -54,24 +201,6 @@ vtkvmtkTetGenReader::~vtkvmtkTetGenReader()
     }
 }
 
-void vtkvmtkTetGenReader::Tokenize(const std::string& str, std::vector<std::string>& tokens, const std::string& delimiters)
-{
-  if (tokens.size() > 0)
-    {
-    tokens.clear();
-    }
-
-  std::string::size_type lastPos = str.find_first_not_of(delimiters,0);
-  std::string::size_type pos = str.find_first_of(delimiters,lastPos);
-
-  while (std::string::npos != pos || std::string::npos != lastPos)
-    {
-    tokens.push_back(str.substr(lastPos,pos-lastPos));
-    lastPos = str.find_first_not_of(delimiters, pos);
-    pos = str.find_first_of(delimiters, lastPos);
-    }
-}
-
 int vtkvmtkTetGenReader::ReadMeshSimple(const std::string& fname,
                                        vtkDataObject* doOutput)
 {
@@ -92,41 +221,57 @@ int vtkvmtkTetGenReader::ReadMeshSimple(const std::string& fname,
   std::string eleFileName = fname;
   eleFileName += ".ele";
 
-  std::ifstream nodeStream(nodeFileName.c_str());
-  std::ifstream eleStream(eleFileName.c_str());
+  vtkvmtkTextReaderUtilities::MappedFile nodeFile;
+  vtkvmtkTextReaderUtilities::MappedFile eleFile;
 
-  if (!nodeStream.good())
+  if (!nodeFile.Open(nodeFileName.c_str()))
     {
     vtkErrorMacro(<<"Unable to open " << nodeFileName << " for reading");
     return 0;
     }
 
-  if (!eleStream.good())
+  if (!eleFile.Open(eleFileName.c_str()))
     {
     vtkErrorMacro(<<"Unable to open " << eleFileName << " for reading");
     return 0;
     }
 
-  std::string line;
-  std::string delimiter(" ");
-  std::vector<std::string> tokens;
-
-  std::getline(nodeStream,line);
-  this->Tokenize(line,tokens,delimiter);
+  int nodeHeader[4];
+  const char* nodeRecords = ReadHeader(nodeFile.GetBegin(),nodeFile.GetEnd(),4,nodeHeader);
+  if (!nodeRecords)
+    {
+    vtkErrorMacro(<<"Invalid header in " << nodeFileName);
+    return 0;
+    }
 
   int nodeCount, dim, numberOfAttributes, boundaryMarkers;
 
-  //TODO: check number of entries of each line.
-  nodeCount = atoi(tokens[0].c_str());
-  dim = atoi(tokens[1].c_str());
-  numberOfAttributes = atoi(tokens[2].c_str());
-  boundaryMarkers = atoi(tokens[3].c_str());
+  nodeCount = nodeHeader[0];
+  dim = nodeHeader[1];
+  numberOfAttributes = nodeHeader[2];
+  boundaryMarkers = nodeHeader[3] ? 1 : 0;
+
+  vtkvmtkTextReaderUtilities::TokenChunks nodeTokens;
+  nodeTokens.SetCommentCharacter('#');
+  nodeTokens.SetTokensPerLine(1+dim+numberOfAttributes+boundaryMarkers);
+  if (nodeTokens.Initialize(nodeRecords,nodeFile.GetEnd()) < static_cast<vtkIdType>(nodeCount) * (1+dim+numberOfAttributes+boundaryMarkers))
+    {
+    vtkErrorMacro(<<"Unexpected end of file in " << nodeFileName);
+    return 0;
+    }
+  if (nodeTokens.GetNumberOfInvalidLines())
+    {
+    vtkErrorMacro(<<nodeTokens.GetNumberOfInvalidLines() << " node records of " << nodeFileName << " do not have " << 1+dim+numberOfAttributes+boundaryMarkers << " fields");
+    return 0;
+    }
 
   vtkPoints* outputPoints = vtkPoints::New();
   outputPoints->SetNumberOfPoints(nodeCount);
+  vtkFloatArray* pointArray = vtkFloatArray::SafeDownCast(outputPoints->GetData());
 
   int i, j;
 
+  std::vector<double*> attributeValues(numberOfAttributes+1);
   vtkDoubleArray** attributeArrays = new vtkDoubleArray*[numberOfAttributes];
   for (j=0; j<numberOfAttributes; j++)
     {
@@ -137,6 +282,7 @@ int vtkvmtkTetGenReader::ReadMeshSimple(const std::string& fname,
     attributeArray->SetNumberOfComponents(1);
     attributeArray->SetNumberOfTuples(nodeCount);
     attributeArrays[j] = attributeArray;
+    attributeValues[j] = attributeArray->GetPointer(0);
     }
 
   vtkIdTypeArray* boundaryDataArray = vtkIdTypeArray::New();
@@ -147,36 +293,43 @@ int vtkvmtkTetGenReader::ReadMeshSimple(const std::string& fname,
     boundaryDataArray->SetNumberOfTuples(nodeCount);
     }
 
-  double point[3], value;
-  vtkIdType boundaryId;
+  std::vector<vtkIdType> nodeIndices(nodeCount);
 
-  int firstIndex = 0;
+  NodeTokenFunctor nodeFunctor(nodeCount,dim,numberOfAttributes,boundaryMarkers,
+                               nodeCount ? &nodeIndices[0] : NULL,pointArray->GetPointer(0),&attributeValues[0],
+                               boundaryMarkers ? boundaryDataArray->GetPointer(0) : NULL);
+  nodeTokens.Parse(nodeFunctor);
 
-  int index;
+  // Here we make the assumption that node 0 or 1 appear in the first line
+  vtkIdType firstIndex = nodeCount ? nodeIndices[0] : 0;
+
+  // Points are stored at index-firstIndex; they were parsed in file order,
+  // which is the same unless the file lists nodes out of order.
+  bool sorted = true;
   for (i=0; i<nodeCount; i++)
     {
-    std::getline(nodeStream,line);
-    this->Tokenize(line,tokens,delimiter);
-    index = atoi(tokens[0].c_str());
-    if (i==0)
+    if (nodeIndices[i] - firstIndex != i)
       {
-      // Here we make the assumption that node 0 or 1 appear in the first line
-      firstIndex = index;
+      sorted = false;
+      break;
       }
-    point[0] = atof(tokens[1].c_str());
-    point[1] = atof(tokens[2].c_str());
-    point[2] = atof(tokens[3].c_str());
-    outputPoints->SetPoint(index-firstIndex,point);
-    for (j=0; j<numberOfAttributes; j++)
-      {
-      value = atof(tokens[4+j].c_str());
-      attributeArrays[j]->SetValue(i,value);
-      }
-    if (boundaryMarkers)
+    }
+  if (!sorted)
+    {
+    vtkFloatArray* sortedPointArray = vtkFloatArray::New();
+    sortedPointArray->DeepCopy(pointArray);
+    for (i=0; i<nodeCount; i++)
       {
-      boundaryId = atoi(tokens[4+numberOfAttributes].c_str());
-      boundaryDataArray->SetValue(i,boundaryId);
+      vtkIdType index = nodeIndices[i] - firstIndex;
+      if (index < 0 || index >= nodeCount)
+        {
+        vtkErrorMacro(<<"Node index " << nodeIndices[i] << " out of range in " << nodeFileName);
+        continue;
+        }
+      sortedPointArray->SetTuple(index,i,pointArray);
       }
+    outputPoints->SetData(sortedPointArray);
+    sortedPointArray->Delete();
     }
 
   output->SetPoints(outputPoints);
@@ -194,14 +347,32 @@ int vtkvmtkTetGenReader::ReadMeshSimple(const std::string& fname,
     output->GetPointData()->AddArray(boundaryDataArray);
     }
 
-  std::getline(eleStream,line);
-  this->Tokenize(line,tokens,delimiter);
+  nodeFile.Close();
+
+  int eleHeader[3];
+  const char* eleRecords = ReadHeader(eleFile.GetBegin(),eleFile.GetEnd(),3,eleHeader);
+  if (!eleRecords)
+    {
+    vtkErrorMacro(<<"Invalid header in " << eleFileName);
+    boundaryDataArray->Delete();
+    return 0;
+    }
 
   int tetCount, nodesPerTet, numberOfCellAttributes;
-  tetCount = atoi(tokens[0].c_str());
-  nodesPerTet = atoi(tokens[1].c_str());
-  numberOfCellAttributes = atoi(tokens[2].c_str());
+  tetCount = eleHeader[0];
+  nodesPerTet = eleHeader[1];
+  numberOfCellAttributes = eleHeader[2];
+
+  vtkvmtkTextReaderUtilities::TokenChunks eleTokens;
+  eleTokens.SetCommentCharacter('#');
+  if (eleTokens.Initialize(eleRecords,eleFile.GetEnd()) < static_cast<vtkIdType>(tetCount) * (1+nodesPerTet+numberOfCellAttributes))
+    {
+    vtkErrorMacro(<<"Unexpected end of file in " << eleFileName);
+    boundaryDataArray->Delete();
+    return 0;
+    }
  
+  std::vector<double*> cellAttributeValues(numberOfCellAttributes+1);
   vtkDoubleArray** cellAttributeArrays = new vtkDoubleArray*[numberOfCellAttributes];
   for (j=0; j<numberOfCellAttributes; j++)
     {
@@ -210,58 +381,46 @@ int vtkvmtkTetGenReader::ReadMeshSimple(const std::string& fname,
     vtkDoubleArray* attributeArray = vtkDoubleArray::New();
     attributeArray->SetName(nameStream.str().c_str());
     attributeArray->SetNumberOfComponents(1);
-    attributeArray->SetNumberOfTuples(nodeCount);
+    attributeArray->SetNumberOfTuples(tetCount);
     cellAttributeArrays[j] = attributeArray;
+    cellAttributeValues[j] = attributeArray->GetPointer(0);
     }
 
-  int* outputCellTypes = new int[tetCount];
-  vtkCellArray* outputCellArray = vtkCellArray::New();
-
   int outputCellType = VTK_TETRA;
   if (nodesPerTet == 10)
     {
     outputCellType = VTK_QUADRATIC_TETRA;
     }
 
+  vtkUnsignedCharArray* outputCellTypes = vtkUnsignedCharArray::New();
+  outputCellTypes->SetNumberOfTuples(tetCount);
+  outputCellTypes->FillComponent(0,outputCellType);
+
+  vtkIdTypeArray* offsets = vtkIdTypeArray::New();
+  offsets->SetNumberOfTuples(tetCount+1);
+  vtkIdType* offsetValues = offsets->GetPointer(0);
+  for (i=0; i<=tetCount; i++)
+    {
+    offsetValues[i] = static_cast<vtkIdType>(i) * nodesPerTet;
+    }
+
+  vtkIdTypeArray* connectivity = vtkIdTypeArray::New();
+  connectivity->SetNumberOfTuples(static_cast<vtkIdType>(tetCount) * nodesPerTet);
+
+  ElementTokenFunctor elementFunctor(tetCount,nodesPerTet,numberOfCellAttributes,firstIndex,
+                                     connectivity->GetPointer(0),&cellAttributeValues[0]);
+  eleTokens.Parse(elementFunctor);
+
+  eleFile.Close();
+
   vtkIdTypeArray* cellBoundaryDataArray = vtkIdTypeArray::New();
   if (boundaryMarkers)
     {
     cellBoundaryDataArray->SetName(this->BoundaryDataArrayName);
     cellBoundaryDataArray->SetNumberOfComponents(1);
     cellBoundaryDataArray->SetNumberOfTuples(tetCount);
-    }
-
-  vtkIdType pointId, maxBoundaryId;
-  for (i=0; i<tetCount; i++)
-    {
-    std::getline(eleStream,line);
-    this->Tokenize(line,tokens,delimiter);
-    index = atoi(tokens[0].c_str());
-    outputCellArray->InsertNextCell(nodesPerTet);
-    maxBoundaryId = 0;
-    for (j=0; j<nodesPerTet; j++)
-      {
-      pointId = atoi(tokens[j+1].c_str());
-      outputCellArray->InsertCellPoint(pointId-firstIndex);
-      if (boundaryMarkers)
-        {
-        boundaryId = boundaryDataArray->GetValue(pointId-firstIndex);
-        if (j>0 && boundaryId > maxBoundaryId)
-          {
-          maxBoundaryId = boundaryId;
-          }
-        }
-      }
-    if (boundaryMarkers)
-      {
-      cellBoundaryDataArray->SetValue(i,maxBoundaryId);
-      }
-    outputCellTypes[i] = outputCellType;
-    for (j=0; j<numberOfCellAttributes; j++)
-      {
-      value = atof(tokens[1+nodesPerTet].c_str());
-      cellAttributeArrays[j]->SetValue(i,value);
-      }
+    CellBoundaryFunctor cellBoundaryFunctor(nodesPerTet,connectivity->GetPointer(0),boundaryDataArray->GetPointer(0),cellBoundaryDataArray->GetPointer(0));
+    vtkSMPTools::For(0,tetCount,cellBoundaryFunctor);
     }
 
   for (j=0; j<numberOfCellAttributes; j++)
@@ -271,6 +430,8 @@ int vtkvmtkTetGenReader::ReadMeshSimple(const std::string& fname,
     }
   delete[] cellAttributeArrays;
 
+  vtkCellArray* outputCellArray = vtkCellArray::New();
+  outputCellArray->SetData(offsets,connectivity);
   output->SetCells(outputCellTypes,outputCellArray);
 
   if (boundaryMarkers)
@@ -282,7 +443,9 @@ int vtkvmtkTetGenReader::ReadMeshSimple(const std::string& fname,
   boundaryDataArray->Delete();
 
   outputCellArray->Delete();
-  delete[] outputCellTypes;
+  outputCellTypes->Delete();
+  offsets->Delete();
+  connectivity->Delete();
 
   return 1;
 }
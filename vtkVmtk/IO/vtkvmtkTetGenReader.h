@@ -29,8 +29,6 @@ Version:   Revision: 1.0
 #include "vtkvmtkWin32Header.h"
 #include "vtkUnstructuredGridReader.h"
 
-#include <vector>
-
 // VTK_FILEPATH hint was introduced in VTK_VERSION_CHECK(9,1,0)
 // (https://github.com/Kitware/VTK/commit/c30ddf9a6caedd65ae316080b0efd1833983844e)
 #ifndef VTK_FILEPATH
@@ -54,10 +52,6 @@ protected:
   vtkvmtkTetGenReader();
   ~vtkvmtkTetGenReader();
 
-//BTX
-  void Tokenize(const std::string& str, std::vector<std::string>& tokens, const std::string& delimiters);
-//ETX
-
   char* BoundaryDataArrayName;
 
 private:
@@ -27,11 +27,116 @@ Version:   Revision: 1.0
 #include "vtkCellData.h"
 #include "vtkIntArray.h"
 #include "vtkIdTypeArray.h"
+#include "vtkIdList.h"
 #include "vtkMath.h"
 #include "vtkObjectFactory.h"
 #include "vtkvmtkConstants.h"
+#include "vtkvmtkTextWriterUtilities.h"
 
 
+namespace
+{
+
+// "id x y z" lines of the .node file
+class NodeFormatter
+{
+public:
+  NodeFormatter(vtkUnstructuredGrid* input) : Input(input) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    double point[3];
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Input->GetPoint(i,point);
+      vtkvmtkTextWriterUtilities::AppendInteger(buffer,i+1);
+      for (int j=0; j<3; j++)
+        {
+        buffer += ' ';
+        vtkvmtkTextWriterUtilities::AppendDouble(buffer,point[j]);
+        }
+      buffer += '\n';
+      }
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+};
+
+// "id p0 p1 ..." lines of the .ele file, with positively oriented tetrahedra
+class EleFormatter
+{
+public:
+  EleFormatter(vtkUnstructuredGrid* input, vtkIdTypeArray* tetIds, int pointsInTet) : Input(input), TetIds(tetIds), PointsInTet(pointsInTet) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    double point0[3], point1[3], point2[3], point3[3];
+    double cross[3], vector01[3], vector21[3], vector31[3];
+    double dot;
+    vtkIdType tmp;
+    vtkIdType cellPointIds[10];
+    vtkIdList* cellPoints = vtkIdList::New();
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      vtkIdType cellId = this->TetIds->GetValue(i);
+      this->Input->GetCellPoints(cellId,cellPoints);
+      int j;
+      for (j=0; j<this->PointsInTet; j++)
+        {
+        cellPointIds[j] = cellPoints->GetId(j);
+        }
+      this->Input->GetPoint(cellPointIds[0],point0);
+      this->Input->GetPoint(cellPointIds[1],point1);
+      this->Input->GetPoint(cellPointIds[2],point2);
+      this->Input->GetPoint(cellPointIds[3],point3);
+      vector01[0] = point0[0] - point1[0];
+      vector01[1] = point0[1] - point1[1];
+      vector01[2] = point0[2] - point1[2];
+      vector21[0] = point2[0] - point1[0];
+      vector21[1] = point2[1] - point1[1];
+      vector21[2] = point2[2] - point1[2];
+      vector31[0] = point3[0] - point1[0];
+      vector31[1] = point3[1] - point1[1];
+      vector31[2] = point3[2] - point1[2];
+      vtkMath::Cross(vector21,vector31,cross);
+      dot = vtkMath::Dot(cross,vector01);
+      if (dot < 0.0)
+        {
+        tmp = cellPointIds[2];
+        cellPointIds[2] = cellPointIds[3];
+        cellPointIds[3] = tmp;
+        if (this->PointsInTet == 10)
+          {
+          tmp = cellPointIds[6];
+          cellPointIds[6] = cellPointIds[7];
+          cellPointIds[7] = tmp;
+          tmp = cellPointIds[5];
+          cellPointIds[5] = cellPointIds[8];
+          cellPointIds[8] = tmp;
+          }
+        }
+
+      vtkvmtkTextWriterUtilities::AppendInteger(buffer,i+1);
+      buffer += ' ';
+      for (j=0; j<this->PointsInTet; j++)
+        {
+        vtkvmtkTextWriterUtilities::AppendInteger(buffer,cellPointIds[j]+1);
+        buffer += ' ';
+        }
+      buffer += '\n';
+      }
+    cellPoints->Delete();
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  vtkIdTypeArray* TetIds;
+  int PointsInTet;
+};
+
+}
+
 vtkStandardNewMacro(vtkvmtkTetGenWriter);
 
 vtkvmtkTetGenWriter::vtkvmtkTetGenWriter()
@@ -83,17 +188,14 @@ void vtkvmtkTetGenWriter::WriteData()
 
   int numberOfPoints = input->GetNumberOfPoints();
 
-  int i, j;
-
   //TODO: add attributes and boundary markers
 
-  nodeStream << numberOfPoints << " 3 0 0" << std::endl;
+  nodeStream << numberOfPoints << " 3 0 0\n";
 
-  double point[3];
-  for (i=0; i<numberOfPoints; i++)
+  NodeFormatter nodeFormatter(input);
+  if (!vtkvmtkTextWriterUtilities::WriteRecords(nodeStream,numberOfPoints,nodeFormatter))
     {
-    input->GetPoint(i,point);
-    nodeStream << i+1 << " " << point[0] << " " << point[1] << " " << point[2] << std::endl;
+    vtkErrorMacro(<<"Error writing node file.");
     }
 
 #if 0
@@ -139,59 +241,12 @@ void vtkvmtkTetGenWriter::WriteData()
 
   //TODO: add attributes
 
-  eleStream << numberOfOutputTetras << " " << pointsInTet << " 0" << std::endl;
-
-  double point0[3], point1[3], point2[3], point3[3];
-  double cross[3], vector01[3], vector21[3], vector31[3];
-  double dot;
-  int tmp;
+  eleStream << numberOfOutputTetras << " " << pointsInTet << " 0\n";
 
-  int cellPointIds[10];
-  for (i=0; i<numberOfOutputTetras; i++)
+  EleFormatter eleFormatter(input,tetIdsArray,pointsInTet);
+  if (!vtkvmtkTextWriterUtilities::WriteRecords(eleStream,numberOfOutputTetras,eleFormatter))
     {
-    vtkIdType cellId = tetraCellIdArray->GetValue(i);
-    vtkCell* cell = input->GetCell(cellId);
-    for (j=0; j<pointsInTet; j++)
-      {
-      cellPointIds[j] = cell->GetPointId(j);
-      }
-    input->GetPoint(cellPointIds[0],point0);
-    input->GetPoint(cellPointIds[1],point1);
-    input->GetPoint(cellPointIds[2],point2);
-    input->GetPoint(cellPointIds[3],point3);
-    vector01[0] = point0[0] - point1[0];
-    vector01[1] = point0[1] - point1[1];
-    vector01[2] = point0[2] - point1[2];
-    vector21[0] = point2[0] - point1[0];
-    vector21[1] = point2[1] - point1[1];
-    vector21[2] = point2[2] - point1[2];
-    vector31[0] = point3[0] - point1[0];
-    vector31[1] = point3[1] - point1[1];
-    vector31[2] = point3[2] - point1[2];
-    vtkMath::Cross(vector21,vector31,cross);
-    dot = vtkMath::Dot(cross,vector01);
-    if (dot < 0.0)
-      {
-      tmp = cellPointIds[2];
-      cellPointIds[2] = cellPointIds[3];
-      cellPointIds[3] = tmp;
-      if (pointsInTet == 10)
-        {
-        tmp = cellPointIds[6];
-        cellPointIds[6] = cellPointIds[7];
-        cellPointIds[7] = tmp;
-        tmp = cellPointIds[5];
-        cellPointIds[5] = cellPointIds[8];
-        cellPointIds[8] = tmp;
-        }
-      }
- 
-    eleStream << i+1 << " ";
-    for (j=0; j<pointsInTet; j++)
-      {
-      eleStream << cellPointIds[j]+1 << " ";
-      }
-    eleStream << std::endl;
+    vtkErrorMacro(<<"Error writing ele file.");
     }
 
   tetraCellIdArray->Delete();
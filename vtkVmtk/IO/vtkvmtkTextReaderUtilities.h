@@ -0,0 +1,458 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    vtkvmtkTextReaderUtilities.h
+Language:  C++
+Date:      $Date: 2006/04/06 16:47:47 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// .NAME vtkvmtkTextReaderUtilities - helpers for parallel ASCII mesh readers
+// .SECTION Description
+// vtkvmtkTextReaderUtilities collects the parsing routines shared by the
+// ASCII mesh readers. MappedFile maps a whole file in memory (it is read in
+// a buffer where mmap is not available). TokenChunks splits a section of the
+// file at line boundaries, counts the whitespace separated tokens of every
+// chunk in parallel and then hands each token, together with its index in
+// the section, to a functor, again processing chunks in parallel. Readers
+// know how many tokens make up a record, so the token index tells which
+// record and field a token belongs to and values can be stored straight
+// into preallocated arrays.
+//
+// A token functor is any object providing
+//   void operator()(vtkIdType tokenId, const char* begin, const char* end) const
+// It is called concurrently for different tokens.
+
+#ifndef __vtkvmtkTextReaderUtilities_h
+#define __vtkvmtkTextReaderUtilities_h
+
+#include "vtkType.h"
+#include "vtkSMPTools.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class vtkvmtkTextReaderUtilities
+{
+public:
+
+  static bool IsSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+  }
+
+  // Description:
+  // Pointer to the character following the next newline, or end.
+  static const char* NextLine(const char* p, const char* end)
+  {
+    const char* newLine = static_cast<const char*>(memchr(p,'\n',end-p));
+    return newLine ? newLine + 1 : end;
+  }
+
+  // Description:
+  // Pointer to the first non blank character of the line starting at p
+  // (the end of the line if there is none).
+  static const char* SkipBlanks(const char* p, const char* end)
+  {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+      {
+      ++p;
+      }
+    return p;
+  }
+
+  // Description:
+  // Extract the next token from [p,end), skipping whitespace and, if
+  // commentCharacter is not 0, comments up to the end of the line. Returns
+  // false when there are no more tokens.
+  static bool NextToken(const char*& p, const char* end, const char*& tokenBegin, const char*& tokenEnd, char commentCharacter = 0)
+  {
+    while (p < end)
+      {
+      if (IsSpace(*p))
+        {
+        ++p;
+        }
+      else if (commentCharacter && *p == commentCharacter)
+        {
+        p = NextLine(p,end);
+        }
+      else
+        {
+        break;
+        }
+      }
+    if (p == end)
+      {
+      return false;
+      }
+    tokenBegin = p;
+    while (p < end && !IsSpace(*p) && !(commentCharacter && *p == commentCharacter))
+      {
+      ++p;
+      }
+    tokenEnd = p;
+    return true;
+  }
+
+  // Description:
+  // Parse the leading integer of a token, like atoi.
+  static long long ParseInteger(const char* p, const char* end)
+  {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+      {
+      negative = *p == '-';
+      ++p;
+      }
+    long long value = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+      {
+      value = value * 10 + (*p - '0');
+      ++p;
+      }
+    return negative ? -value : value;
+  }
+
+  // Description:
+  // Parse a floating point token. Plain decimal numbers with up to 19
+  // significant digits and small exponents are converted exactly without
+  // going through the C library; everything else is handed to strtod.
+  static double ParseDouble(const char* begin, const char* end)
+  {
+    static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+      1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char* p = begin;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+      {
+      negative = *p == '-';
+      ++p;
+      }
+    unsigned long long mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool digits = false;
+    bool exact = true;
+    while (p < end && *p >= '0' && *p <= '9')
+      {
+      AccumulateDigit(*p,mantissa,significantDigits,exact,exponent,false);
+      digits = true;
+      ++p;
+      }
+    if (p < end && *p == '.')
+      {
+      ++p;
+      while (p < end && *p >= '0' && *p <= '9')
+        {
+        AccumulateDigit(*p,mantissa,significantDigits,exact,exponent,true);
+        digits = true;
+        ++p;
+        }
+      }
+    if (digits && p < end && (*p == 'e' || *p == 'E'))
+      {
+      ++p;
+      bool negativeExponent = false;
+      if (p < end && (*p == '-' || *p == '+'))
+        {
+        negativeExponent = *p == '-';
+        ++p;
+        }
+      int explicitExponent = 0;
+      bool exponentDigits = false;
+      while (p < end && *p >= '0' && *p <= '9')
+        {
+        if (explicitExponent < 10000)
+          {
+          explicitExponent = explicitExponent * 10 + (*p - '0');
+          }
+        exponentDigits = true;
+        ++p;
+        }
+      exact = exact && exponentDigits;
+      exponent += negativeExponent ? -explicitExponent : explicitExponent;
+      }
+    if (digits && exact && p == end && mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22)
+      {
+      double value = static_cast<double>(mantissa);
+      value = exponent < 0 ? value / powersOfTen[-exponent] : value * powersOfTen[exponent];
+      return negative ? -value : value;
+      }
+    char buffer[128];
+    size_t length = static_cast<size_t>(end - begin);
+    if (length >= sizeof(buffer))
+      {
+      length = sizeof(buffer) - 1;
+      }
+    memcpy(buffer,begin,length);
+    buffer[length] = '\0';
+    return strtod(buffer,NULL);
+  }
+
+  // Description:
+  // A file mapped (or read) in memory.
+  class MappedFile
+  {
+  public:
+    MappedFile() : Data(NULL), Size(0), Mapped(false) {}
+    ~MappedFile() { this->Close(); }
+
+    bool Open(const char* fileName)
+    {
+      this->Close();
+#if !defined(_WIN32)
+      int fileDescriptor = open(fileName,O_RDONLY);
+      if (fileDescriptor < 0)
+        {
+        return false;
+        }
+      struct stat fileStat;
+      if (fstat(fileDescriptor,&fileStat) == 0 && fileStat.st_size > 0)
+        {
+        void* data = mmap(NULL,static_cast<size_t>(fileStat.st_size),PROT_READ,MAP_PRIVATE,fileDescriptor,0);
+        if (data != MAP_FAILED)
+          {
+#ifdef MADV_SEQUENTIAL
+          madvise(data,static_cast<size_t>(fileStat.st_size),MADV_SEQUENTIAL);
+#endif
+          this->Data = static_cast<const char*>(data);
+          this->Size = static_cast<size_t>(fileStat.st_size);
+          this->Mapped = true;
+          }
+        }
+      close(fileDescriptor);
+      if (this->Mapped)
+        {
+        return true;
+        }
+#endif
+      std::ifstream file(fileName,std::ios::in | std::ios::binary);
+      if (!file.good())
+        {
+        return false;
+        }
+      file.seekg(0,std::ios::end);
+      std::streamoff size = file.tellg();
+      file.seekg(0,std::ios::beg);
+      this->Buffer.resize(size > 0 ? static_cast<size_t>(size) : 0);
+      if (size > 0)
+        {
+        file.read(&this->Buffer[0],size);
+        }
+      this->Data = this->Buffer.empty() ? NULL : &this->Buffer[0];
+      this->Size = this->Buffer.size();
+      return true;
+    }
+
+    void Close()
+    {
+#if !defined(_WIN32)
+      if (this->Mapped)
+        {
+        munmap(const_cast<char*>(this->Data),this->Size);
+        }
+#endif
+      this->Data = NULL;
+      this->Size = 0;
+      this->Mapped = false;
+      std::vector<char>().swap(this->Buffer);
+    }
+
+    const char* GetBegin() const { return this->Data; }
+    const char* GetEnd() const { return this->Data + this->Size; }
+
+  private:
+    MappedFile(const MappedFile&);  // Not implemented.
+    void operator=(const MappedFile&);  // Not implemented.
+
+    const char* Data;
+    size_t Size;
+    bool Mapped;
+    std::vector<char> Buffer;
+  };
+
+  // Description:
+  // Token indexing of a section of a file, see the class description.
+  class TokenChunks
+  {
+  public:
+    TokenChunks() : CommentCharacter(0), TokensPerLine(0) {}
+
+    // Description:
+    // Characters from CommentCharacter to the end of the line are skipped.
+    void SetCommentCharacter(char commentCharacter) { this->CommentCharacter = commentCharacter; }
+
+    // Description:
+    // If not 0, Initialize counts the lines holding a number of tokens other
+    // than 0 or TokensPerLine, see GetNumberOfInvalidLines.
+    void SetTokensPerLine(int tokensPerLine) { this->TokensPerLine = tokensPerLine; }
+
+    vtkIdType GetNumberOfInvalidLines() const
+    {
+      vtkIdType numberOfInvalidLines = 0;
+      for (size_t k=0; k<this->ChunkInvalidLines.size(); k++)
+        {
+        numberOfInvalidLines += this->ChunkInvalidLines[k];
+        }
+      return numberOfInvalidLines;
+    }
+
+    // Description:
+    // Split [begin,end) at line boundaries in chunks of about chunkSize
+    // bytes and count their tokens in parallel. Returns the number of tokens.
+    vtkIdType Initialize(const char* begin, const char* end, vtkIdType chunkSize = 1048576)
+    {
+      this->ChunkStarts.clear();
+      const char* p = begin;
+      while (p < end)
+        {
+        this->ChunkStarts.push_back(p);
+        p = end - p > chunkSize ? NextLine(p + chunkSize,end) : end;
+        }
+      this->ChunkStarts.push_back(end);
+      vtkIdType numberOfChunks = static_cast<vtkIdType>(this->ChunkStarts.size()) - 1;
+      this->ChunkFirstToken.assign(numberOfChunks+1,0);
+      this->ChunkInvalidLines.assign(numberOfChunks,0);
+      CountFunctor countFunctor(this);
+      vtkSMPTools::For(0,numberOfChunks,countFunctor);
+      vtkIdType numberOfTokens = 0;
+      for (vtkIdType k=0; k<numberOfChunks; k++)
+        {
+        vtkIdType chunkTokens = this->ChunkFirstToken[k+1];
+        this->ChunkFirstToken[k] = numberOfTokens;
+        numberOfTokens += chunkTokens;
+        }
+      this->ChunkFirstToken[numberOfChunks] = numberOfTokens;
+      return numberOfTokens;
+    }
+
+    vtkIdType GetNumberOfTokens() const
+    {
+      return this->ChunkFirstToken.empty() ? 0 : this->ChunkFirstToken.back();
+    }
+
+    // Description:
+    // Call functor on every token, chunks in parallel.
+    template<class TFunctor>
+    void Parse(const TFunctor& functor) const
+    {
+      ParseFunctor<TFunctor> parseFunctor(this,functor);
+      vtkSMPTools::For(0,static_cast<vtkIdType>(this->ChunkStarts.size())-1,parseFunctor);
+    }
+
+  private:
+    class CountFunctor
+    {
+    public:
+      CountFunctor(TokenChunks* self) : Self(self) {}
+      void operator()(vtkIdType begin, vtkIdType end) const
+      {
+        for (vtkIdType k=begin; k<end; k++)
+          {
+          const char* p = this->Self->ChunkStarts[k];
+          const char* chunkEnd = this->Self->ChunkStarts[k+1];
+          const char* tokenBegin;
+          const char* tokenEnd;
+          vtkIdType numberOfTokens = 0;
+          vtkIdType numberOfInvalidLines = 0;
+          while (p < chunkEnd)
+            {
+            const char* lineEnd = NextLine(p,chunkEnd);
+            int lineTokens = 0;
+            while (NextToken(p,lineEnd,tokenBegin,tokenEnd,this->Self->CommentCharacter))
+              {
+              ++lineTokens;
+              }
+            if (this->Self->TokensPerLine && lineTokens && lineTokens != this->Self->TokensPerLine)
+              {
+              ++numberOfInvalidLines;
+              }
+            numberOfTokens += lineTokens;
+            p = lineEnd;
+            }
+          this->Self->ChunkInvalidLines[k] = numberOfInvalidLines;
+          // counts are stored one slot ahead and turned into offsets afterwards
+          this->Self->ChunkFirstToken[k+1] = numberOfTokens;
+          }
+      }
+    private:
+      TokenChunks* Self;
+    };
+
+    template<class TFunctor>
+    class ParseFunctor
+    {
+    public:
+      ParseFunctor(const TokenChunks* self, const TFunctor& functor) : Self(self), Functor(functor) {}
+      void operator()(vtkIdType begin, vtkIdType end) const
+      {
+        for (vtkIdType k=begin; k<end; k++)
+          {
+          const char* p = this->Self->ChunkStarts[k];
+          const char* chunkEnd = this->Self->ChunkStarts[k+1];
+          const char* tokenBegin;
+          const char* tokenEnd;
+          vtkIdType tokenId = this->Self->ChunkFirstToken[k];
+          while (NextToken(p,chunkEnd,tokenBegin,tokenEnd,this->Self->CommentCharacter))
+            {
+            this->Functor(tokenId++,tokenBegin,tokenEnd);
+            }
+          }
+      }
+    private:
+      const TokenChunks* Self;
+      const TFunctor& Functor;
+    };
+
+    char CommentCharacter;
+    int TokensPerLine;
+    std::vector<const char*> ChunkStarts;
+    std::vector<vtkIdType> ChunkFirstToken;
+    std::vector<vtkIdType> ChunkInvalidLines;
+  };
+
+protected:
+
+  static void AccumulateDigit(char c, unsigned long long& mantissa, int& significantDigits, bool& exact, int& exponent, bool fraction)
+  {
+    int digit = c - '0';
+    if (significantDigits == 0 && digit == 0)
+      {
+      exponent -= fraction ? 1 : 0;
+      return;
+      }
+    if (significantDigits < 19)
+      {
+      mantissa = mantissa * 10 + digit;
+      ++significantDigits;
+      exponent -= fraction ? 1 : 0;
+      }
+    else
+      {
+      exact = false;
+      }
+  }
+};
+
+#endif
@@ -0,0 +1,192 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    vtkvmtkTextWriterUtilities.h
+Language:  C++
+Date:      $Date: 2006/04/06 16:47:47 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// .NAME vtkvmtkTextWriterUtilities - helpers for buffered ASCII mesh writers
+// .SECTION Description
+// vtkvmtkTextWriterUtilities collects the formatting routines shared by the
+// ASCII mesh writers. Integers are converted by hand, floating point values
+// through snprintf with the same format the stream operators would use, so
+// the output is unchanged. WriteRecords splits a list of records (points,
+// cells, faces) into chunks, formats batches of chunks in parallel with
+// vtkSMPTools into separate buffers and writes the buffers out in order.
+//
+// A record formatter is any object providing
+//   void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+// which appends the text of records [begin,end) to buffer. It is called
+// concurrently on disjoint ranges, so it may only use thread safe accessors
+// of the input (e.g. GetPoint(id,x), GetCellType, GetCellPoints(id,vtkIdList*)
+// with a list local to the call) and must not report errors.
+
+#ifndef __vtkvmtkTextWriterUtilities_h
+#define __vtkvmtkTextWriterUtilities_h
+
+#include "vtkType.h"
+#include "vtkSMPTools.h"
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class vtkvmtkTextWriterUtilities
+{
+public:
+
+  // Description:
+  // Append value in decimal notation, right aligned to width characters.
+  static void AppendInteger(std::string& buffer, long long value, int width = 0)
+  {
+    char digits[32];
+    char* end = digits + sizeof(digits);
+    char* begin = end;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+    do
+      {
+      *--begin = static_cast<char>('0' + magnitude % 10);
+      magnitude /= 10;
+      }
+    while (magnitude);
+    if (value < 0)
+      {
+      *--begin = '-';
+      }
+    AppendPadded(buffer,begin,end,width);
+  }
+
+  // Description:
+  // Append value in lowercase hexadecimal notation (as printf "%x").
+  static void AppendHex(std::string& buffer, unsigned long long value, int width = 0)
+  {
+    static const char hexDigits[] = "0123456789abcdef";
+    char digits[32];
+    char* end = digits + sizeof(digits);
+    char* begin = end;
+    do
+      {
+      *--begin = hexDigits[value & 0xf];
+      value >>= 4;
+      }
+    while (value);
+    AppendPadded(buffer,begin,end,width);
+  }
+
+  // Description:
+  // Append value using a printf floating point format. The default "%g"
+  // matches the default formatting of std::ostream.
+  static void AppendDouble(std::string& buffer, double value, const char* format = "%g")
+  {
+    char str[64];
+    int length = snprintf(str,sizeof(str),format,value);
+    if (length > 0)
+      {
+      buffer.append(str,length < static_cast<int>(sizeof(str)) ? length : static_cast<int>(sizeof(str))-1);
+      }
+  }
+
+  // Description:
+  // Format numberOfRecords records with formatter and write them to out in
+  // order. Returns false if the stream went bad.
+  template<class TFormatter>
+  static bool WriteRecords(std::ostream& out, vtkIdType numberOfRecords, const TFormatter& formatter, vtkIdType chunkSize = 8192)
+  {
+    if (numberOfRecords <= 0)
+      {
+      return out.good();
+      }
+    if (chunkSize < 1)
+      {
+      chunkSize = 1;
+      }
+    const vtkIdType numberOfChunks = (numberOfRecords + chunkSize - 1) / chunkSize;
+    // bounds the memory held by formatted text that has not been written yet
+    const vtkIdType chunksPerBatch = 64;
+    std::vector<std::string> buffers(static_cast<size_t>(numberOfChunks < chunksPerBatch ? numberOfChunks : chunksPerBatch));
+    for (vtkIdType firstChunk=0; firstChunk<numberOfChunks; firstChunk+=chunksPerBatch)
+      {
+      vtkIdType batchSize = numberOfChunks - firstChunk;
+      if (batchSize > chunksPerBatch)
+        {
+        batchSize = chunksPerBatch;
+        }
+      ChunkFunctor<TFormatter> functor(formatter,buffers,firstChunk,chunkSize,numberOfRecords);
+      if (batchSize > 1)
+        {
+        vtkSMPTools::For(0,batchSize,1,functor);
+        }
+      else
+        {
+        functor(0,1);
+        }
+      for (vtkIdType k=0; k<batchSize; k++)
+        {
+        out.write(buffers[k].data(),buffers[k].size());
+        }
+      if (!out.good())
+        {
+        return false;
+        }
+      }
+    return true;
+  }
+
+protected:
+
+  static void AppendPadded(std::string& buffer, const char* begin, const char* end, int width)
+  {
+    for (int k=static_cast<int>(end-begin); k<width; k++)
+      {
+      buffer += ' ';
+      }
+    buffer.append(begin,end);
+  }
+
+  template<class TFormatter>
+  class ChunkFunctor
+  {
+  public:
+    ChunkFunctor(const TFormatter& formatter, std::vector<std::string>& buffers, vtkIdType firstChunk, vtkIdType chunkSize, vtkIdType numberOfRecords)
+      : Formatter(formatter), Buffers(buffers), FirstChunk(firstChunk), ChunkSize(chunkSize), NumberOfRecords(numberOfRecords) {}
+
+    void operator()(vtkIdType begin, vtkIdType end) const
+    {
+      for (vtkIdType k=begin; k<end; k++)
+        {
+        vtkIdType firstRecord = (this->FirstChunk + k) * this->ChunkSize;
+        vtkIdType lastRecord = firstRecord + this->ChunkSize;
+        if (lastRecord > this->NumberOfRecords)
+          {
+          lastRecord = this->NumberOfRecords;
+          }
+        std::string& buffer = this->Buffers[k];
+        buffer.clear();
+        this->Formatter(firstRecord,lastRecord,buffer);
+        }
+    }
+
+  private:
+    const TFormatter& Formatter;
+    std::vector<std::string>& Buffers;
+    vtkIdType FirstChunk;
+    vtkIdType ChunkSize;
+    vtkIdType NumberOfRecords;
+  };
+};
+
+#endif
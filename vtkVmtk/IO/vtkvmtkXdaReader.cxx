@@ -26,12 +26,79 @@ Version:   $Revision: 1.3 $
 #include "vtkCellType.h"
 #include "vtkCell.h"
 #include "vtkIdTypeArray.h"
+#include "vtkIdList.h"
+#include "vtkCellArray.h"
+#include "vtkFloatArray.h"
+#include "vtkPoints.h"
+#include "vtkUnsignedCharArray.h"
 #include "vtkObjectFactory.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkvmtkConstants.h"
+#include "vtkvmtkTextReaderUtilities.h"
 
+#include <vector>
+
+
+namespace
+{
+
+// Element blocks and node records following the Xda header. Element tokens
+// are written at their position in the VTK cell, libmesh node k going to
+// point Connectivity[k] of the cell.
+struct XdaBlock
+{
+  int VTKCellType;
+  int NumberOfCellPoints;
+  vtkIdType NumberOfElements;
+  vtkIdType FirstToken;
+  vtkIdType FirstConnectivityId;
+  std::vector<vtkIdType> Connectivity;
+};
+
+class BodyTokenFunctor
+{
+public:
+  BodyTokenFunctor(const std::vector<XdaBlock>& blocks, vtkIdType firstPointToken, vtkIdType numberOfPoints, vtkIdType* connectivity, float* points)
+    : Blocks(blocks), FirstPointToken(firstPointToken), NumberOfPoints(numberOfPoints), Connectivity(connectivity), Points(points) {}
+
+  void operator()(vtkIdType tokenId, const char* begin, const char* end) const
+  {
+    if (tokenId >= this->FirstPointToken)
+      {
+      vtkIdType pointToken = tokenId - this->FirstPointToken;
+      if (pointToken < 3*this->NumberOfPoints)
+        {
+        this->Points[pointToken] = static_cast<float>(vtkvmtkTextReaderUtilities::ParseDouble(begin,end));
+        }
+      return;
+      }
+    size_t b = 0;
+    while (b+1 < this->Blocks.size() && tokenId >= this->Blocks[b+1].FirstToken)
+      {
+      ++b;
+      }
+    const XdaBlock& block = this->Blocks[b];
+    if (block.VTKCellType == -1)
+      {
+      return;
+      }
+    vtkIdType blockToken = tokenId - block.FirstToken;
+    vtkIdType i = blockToken / block.NumberOfCellPoints;
+    int k = static_cast<int>(blockToken % block.NumberOfCellPoints);
+    this->Connectivity[block.FirstConnectivityId + i*block.NumberOfCellPoints + block.Connectivity[k]] = vtkvmtkTextReaderUtilities::ParseInteger(begin,end);
+  }
+
+private:
+  const std::vector<XdaBlock>& Blocks;
+  vtkIdType FirstPointToken;
+  vtkIdType NumberOfPoints;
+  vtkIdType* Connectivity;
+  float* Points;
+};
+
+}
 
 vtkStandardNewMacro(vtkvmtkXdaReader);
 
@@ -62,10 +129,294 @@ int vtkvmtkXdaReader::ReadMeshSimple(const std::string& fname,
     vtkErrorMacro(<<"Input filename not set");
     return 1;
   }
-  
+
+  vtkvmtkTextReaderUtilities::MappedFile xdaFile;
+  if(!xdaFile.Open(fname.c_str()))
+  {
+    vtkErrorMacro(<<"Unable to open " << fname << " for reading");
+    return 1;
+  }
+
+  const char* end = xdaFile.GetEnd();
+  const char* p = vtkvmtkTextReaderUtilities::NextLine(xdaFile.GetBegin(),end);
+  const char* tokenBegin;
+  const char* tokenEnd;
+
+  // Num. Elements, Num. Nodes, Sum of Element Weights, Num. Boundary Conds.,
+  // String Size, Num. Element Types
+  long long header[6];
+  int i;
+  for (i=0; i<6; i++)
+    {
+    if (!vtkvmtkTextReaderUtilities::NextToken(p,end,tokenBegin,tokenEnd,'#'))
+      {
+      vtkErrorMacro(<<"Invalid header in " << fname);
+      return 1;
+      }
+    header[i] = vtkvmtkTextReaderUtilities::ParseInteger(tokenBegin,tokenEnd);
+    }
+
+  vtkIdType numberOfPoints = header[1];
+  vtkIdType numberOfBoundaryConditions = header[3];
+  int numberOfBlocks = static_cast<int>(header[5]);
+
+  std::vector<long long> blockValues(2*numberOfBlocks);
+  for (i=0; i<2*numberOfBlocks; i++)
+    {
+    if (!vtkvmtkTextReaderUtilities::NextToken(p,end,tokenBegin,tokenEnd,'#'))
+      {
+      vtkErrorMacro(<<"Invalid header in " << fname);
+      return 1;
+      }
+    blockValues[i] = vtkvmtkTextReaderUtilities::ParseInteger(tokenBegin,tokenEnd);
+    }
+
+  // Skip the rest of the block counts line, Id String and Title String
+  p = vtkvmtkTextReaderUtilities::NextLine(p,end);
+  p = vtkvmtkTextReaderUtilities::NextLine(p,end);
+  p = vtkvmtkTextReaderUtilities::NextLine(p,end);
+
+  std::vector<XdaBlock> blocks(numberOfBlocks);
+  vtkIdList* libmeshConnectivity = vtkIdList::New();
+  vtkIdType numberOfTokens = 0;
+  vtkIdType numberOfCells = 0;
+  vtkIdType connectivitySize = 0;
+  for (i=0; i<numberOfBlocks; i++)
+    {
+    XdaBlock& block = blocks[i];
+    int numberOfCellPoints = 0;
+    switch (blockValues[i])
+      {
+      case 8:
+        block.VTKCellType = VTK_TETRA;
+        break;
+      case 9:
+        block.VTKCellType = VTK_QUADRATIC_TETRA;
+        break;
+      case 10:
+        block.VTKCellType = VTK_HEXAHEDRON;
+        break;
+      case 11:
+        block.VTKCellType = VTK_QUADRATIC_HEXAHEDRON;
+        break;
+      case 12:
+        vtkWarningMacro(<<"Hex27 elements not currently supported. Skipping block.");
+        block.VTKCellType = -1;
+        numberOfCellPoints = 27;
+        break;
+      case 13:
+        block.VTKCellType = VTK_WEDGE;
+        break;
+      case 14:
+        block.VTKCellType = VTK_QUADRATIC_WEDGE;
+        break;
+      case 15:
+        block.VTKCellType = VTK_BIQUADRATIC_QUADRATIC_WEDGE;
+        break;
+      case 16:
+        block.VTKCellType = VTK_PYRAMID;
+        break;
+      default:
+        vtkErrorMacro(<<"Unsupported libmesh element type " << blockValues[i] << " in " << fname);
+        libmeshConnectivity->Delete();
+        return 1;
+      }
+    if (block.VTKCellType != -1)
+      {
+      this->GetLibmeshConnectivity(block.VTKCellType,libmeshConnectivity);
+      numberOfCellPoints = libmeshConnectivity->GetNumberOfIds();
+      block.Connectivity.assign(libmeshConnectivity->GetPointer(0),libmeshConnectivity->GetPointer(0)+numberOfCellPoints);
+      }
+    block.NumberOfCellPoints = numberOfCellPoints;
+    block.NumberOfElements = blockValues[numberOfBlocks+i];
+    block.FirstToken = numberOfTokens;
+    block.FirstConnectivityId = connectivitySize;
+    numberOfTokens += block.NumberOfElements * numberOfCellPoints;
+    if (block.VTKCellType != -1)
+      {
+      numberOfCells += block.NumberOfElements;
+      connectivitySize += block.NumberOfElements * numberOfCellPoints;
+      }
+    }
+  libmeshConnectivity->Delete();
+
+  vtkvmtkTextReaderUtilities::TokenChunks bodyTokens;
+  if (bodyTokens.Initialize(p,end) < numberOfTokens + 3*numberOfPoints)
+    {
+    vtkErrorMacro(<<"Unexpected end of file in " << fname);
+    return 1;
+    }
+
+  if (numberOfBoundaryConditions > 0)
+    {
+    vtkWarningMacro(<<"Reading of boundary conditions not currently supported. Skipping " << numberOfBoundaryConditions << " boundary conditions.");
+    }
+
+  vtkPoints* points = vtkPoints::New();
+  points->SetNumberOfPoints(numberOfPoints);
+
+  vtkIdTypeArray* connectivity = vtkIdTypeArray::New();
+  connectivity->SetNumberOfValues(connectivitySize);
+
+  BodyTokenFunctor bodyFunctor(blocks,numberOfTokens,numberOfPoints,connectivity->GetPointer(0),vtkFloatArray::SafeDownCast(points->GetData())->GetPointer(0));
+  bodyTokens.Parse(bodyFunctor);
+
+  vtkIdTypeArray* offsets = vtkIdTypeArray::New();
+  offsets->SetNumberOfValues(numberOfCells+1);
+  vtkUnsignedCharArray* typesArray = vtkUnsignedCharArray::New();
+  typesArray->SetNumberOfValues(numberOfCells);
+  vtkIdType cellId = 0;
+  offsets->SetValue(0,0);
+  for (i=0; i<numberOfBlocks; i++)
+    {
+    const XdaBlock& block = blocks[i];
+    if (block.VTKCellType == -1)
+      {
+      continue;
+      }
+    for (vtkIdType j=0; j<block.NumberOfElements; j++, cellId++)
+      {
+      offsets->SetValue(cellId+1,block.FirstConnectivityId+(j+1)*block.NumberOfCellPoints);
+      typesArray->SetValue(cellId,block.VTKCellType);
+      }
+    }
+
+  vtkCellArray* gridCellArray = vtkCellArray::New();
+  gridCellArray->SetData(offsets,connectivity);
+
+  output->SetPoints(points);
+  output->SetCells(typesArray,gridCellArray);
+
+  points->Delete();
+  typesArray->Delete();
+  gridCellArray->Delete();
+  offsets->Delete();
+  connectivity->Delete();
+
   return 1;
 }
 
+void vtkvmtkXdaReader::GetLibmeshConnectivity(int cellType, vtkIdList* libmeshConnectivity)
+{
+  libmeshConnectivity->Initialize();
+
+  switch(cellType)
+    {
+    case VTK_TETRA:
+      libmeshConnectivity->SetNumberOfIds(4);
+      libmeshConnectivity->SetId(0,0);
+      libmeshConnectivity->SetId(1,1);
+      libmeshConnectivity->SetId(2,2);
+      libmeshConnectivity->SetId(3,3);
+      break;
+    case VTK_HEXAHEDRON:
+      libmeshConnectivity->SetNumberOfIds(8);
+      libmeshConnectivity->SetId(0,0);
+      libmeshConnectivity->SetId(1,1);
+      libmeshConnectivity->SetId(2,2);
+      libmeshConnectivity->SetId(3,3);
+      libmeshConnectivity->SetId(4,4);
+      libmeshConnectivity->SetId(5,5);
+      libmeshConnectivity->SetId(6,6);
+      libmeshConnectivity->SetId(7,7);
+      break;
+    case VTK_WEDGE:
+      libmeshConnectivity->SetNumberOfIds(6);
+      libmeshConnectivity->SetId(0,0);
+      libmeshConnectivity->SetId(1,2);
+      libmeshConnectivity->SetId(2,1);
+      libmeshConnectivity->SetId(3,3);
+      libmeshConnectivity->SetId(4,5);
+      libmeshConnectivity->SetId(5,4);
+      break;
+    case VTK_PYRAMID:
+      libmeshConnectivity->SetNumberOfIds(5);
+      libmeshConnectivity->SetId(0,0);
+      libmeshConnectivity->SetId(1,1);
+      libmeshConnectivity->SetId(2,2);
+      libmeshConnectivity->SetId(3,3);
+      libmeshConnectivity->SetId(4,4);
+      break;
+    case VTK_QUADRATIC_TETRA:
+      libmeshConnectivity->SetNumberOfIds(10);
+      libmeshConnectivity->SetId(0,0);
+      libmeshConnectivity->SetId(1,1);
+      libmeshConnectivity->SetId(2,2);
+      libmeshConnectivity->SetId(3,3);
+      libmeshConnectivity->SetId(4,4);
+      libmeshConnectivity->SetId(5,5);
+      libmeshConnectivity->SetId(6,6);
+      libmeshConnectivity->SetId(7,7);
+      libmeshConnectivity->SetId(8,8);
+      libmeshConnectivity->SetId(9,9);
+      break;
+    case VTK_QUADRATIC_HEXAHEDRON:
+      libmeshConnectivity->SetNumberOfIds(20);
+      libmeshConnectivity->SetId(0,0);
+      libmeshConnectivity->SetId(1,1);
+      libmeshConnectivity->SetId(2,2);
+      libmeshConnectivity->SetId(3,3);
+      libmeshConnectivity->SetId(4,4);
+      libmeshConnectivity->SetId(5,5);
+      libmeshConnectivity->SetId(6,6);
+      libmeshConnectivity->SetId(7,7);
+      libmeshConnectivity->SetId(8,8);
+      libmeshConnectivity->SetId(9,9);
+      libmeshConnectivity->SetId(10,10);
+      libmeshConnectivity->SetId(11,11);
+      libmeshConnectivity->SetId(12,16);
+      libmeshConnectivity->SetId(13,17);
+      libmeshConnectivity->SetId(14,18);
+      libmeshConnectivity->SetId(15,19);
+      libmeshConnectivity->SetId(16,12);
+      libmeshConnectivity->SetId(17,13);
+      libmeshConnectivity->SetId(18,14);
+      libmeshConnectivity->SetId(19,15);
+      break;
+    case VTK_QUADRATIC_WEDGE:
+      libmeshConnectivity->SetNumberOfIds(15);
+      libmeshConnectivity->SetId(0,0);
+      libmeshConnectivity->SetId(1,2);
+      libmeshConnectivity->SetId(2,1);
+      libmeshConnectivity->SetId(3,3);
+      libmeshConnectivity->SetId(4,5);
+      libmeshConnectivity->SetId(5,4);
+      libmeshConnectivity->SetId(6,8);
+      libmeshConnectivity->SetId(7,7);
+      libmeshConnectivity->SetId(8,6);
+      libmeshConnectivity->SetId(9,12);
+      libmeshConnectivity->SetId(10,14);
+      libmeshConnectivity->SetId(11,13);
+      libmeshConnectivity->SetId(12,11);
+      libmeshConnectivity->SetId(13,10);
+      libmeshConnectivity->SetId(14,9);
+      break;
+    case VTK_BIQUADRATIC_QUADRATIC_WEDGE:
+      libmeshConnectivity->SetNumberOfIds(18);
+      libmeshConnectivity->SetId(0,0);
+      libmeshConnectivity->SetId(1,2);
+      libmeshConnectivity->SetId(2,1);
+      libmeshConnectivity->SetId(3,3);
+      libmeshConnectivity->SetId(4,5);
+      libmeshConnectivity->SetId(5,4);
+      libmeshConnectivity->SetId(6,8);
+      libmeshConnectivity->SetId(7,7);
+      libmeshConnectivity->SetId(8,6);
+      libmeshConnectivity->SetId(9,12);
+      libmeshConnectivity->SetId(10,14);
+      libmeshConnectivity->SetId(11,13);
+      libmeshConnectivity->SetId(12,11);
+      libmeshConnectivity->SetId(13,10);
+      libmeshConnectivity->SetId(14,9);
+      libmeshConnectivity->SetId(15,17);
+      libmeshConnectivity->SetId(16,16);
+      libmeshConnectivity->SetId(17,15);
+      break;
+    default:
+      break;
+    }
+}
+
 void vtkvmtkXdaReader::PrintSelf(std::ostream& os, vtkIndent indent)
 {
   vtkUnstructuredGridReader::PrintSelf(os,indent);
@@ -27,10 +27,71 @@ Version:   $Revision: 1.6 $
 #include "vtkCell.h"
 #include "vtkCellData.h"
 #include "vtkIdTypeArray.h"
+#include "vtkIdList.h"
 #include "vtkObjectFactory.h"
 #include "vtkvmtkConstants.h"
+#include "vtkvmtkTextWriterUtilities.h"
 
 
+namespace
+{
+
+// Connectivity lines of one element block, reordered for libmesh
+class ElementFormatter
+{
+public:
+  ElementFormatter(vtkUnstructuredGrid* input, vtkIdTypeArray* typeCellIds, vtkIdList* libmeshConnectivity) : Input(input), TypeCellIds(typeCellIds), LibmeshConnectivity(libmeshConnectivity) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    vtkIdList* cellPoints = vtkIdList::New();
+    int numberOfCellPoints = this->LibmeshConnectivity->GetNumberOfIds();
+    for (vtkIdType j=begin; j<end; j++)
+      {
+      this->Input->GetCellPoints(this->TypeCellIds->GetValue(j),cellPoints);
+      //TODO: get individual connectivity, reversed if needed by positive Jacobian in libMesh
+      for (int k=0; k<numberOfCellPoints; k++)
+        {
+        vtkvmtkTextWriterUtilities::AppendInteger(buffer,cellPoints->GetId(this->LibmeshConnectivity->GetId(k)));
+        buffer += ' ';
+        }
+      buffer += '\n';
+      }
+    cellPoints->Delete();
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  vtkIdTypeArray* TypeCellIds;
+  vtkIdList* LibmeshConnectivity;
+};
+
+class PointFormatter
+{
+public:
+  PointFormatter(vtkUnstructuredGrid* input) : Input(input) {}
+
+  void operator()(vtkIdType begin, vtkIdType end, std::string& buffer) const
+  {
+    double point[3];
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Input->GetPoint(i,point);
+      vtkvmtkTextWriterUtilities::AppendDouble(buffer,point[0]);
+      buffer += ' ';
+      vtkvmtkTextWriterUtilities::AppendDouble(buffer,point[1]);
+      buffer += ' ';
+      vtkvmtkTextWriterUtilities::AppendDouble(buffer,point[2]);
+      buffer += '\n';
+      }
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+};
+
+}
+
 vtkStandardNewMacro(vtkvmtkXdaWriter);
 
 vtkvmtkXdaWriter::vtkvmtkXdaWriter()
@@ -178,7 +239,7 @@ void vtkvmtkXdaWriter::WriteData()
       }
     
     ++numberOfVolumeCells;  
-    totalWeight += input->GetCell(i)->GetNumberOfPoints();
+    totalWeight += input->GetCellSize(i);
     }
 
   int numberOfElementBlocks = 0;
@@ -211,19 +272,19 @@ void vtkvmtkXdaWriter::WriteData()
       }
     }
 
-  out << "DEAL 003:003" << endl;
+  out << "DEAL 003:003\n";
 //  out << "LIBM 0" << endl;
-  out << numberOfVolumeCells << "\t# Num. Elements" << endl;
-  out << numberOfPoints << "\t# Num. Nodes" << endl;
-  out << totalWeight << "\t# Sum of Element Weights" << endl;
+  out << numberOfVolumeCells << "\t# Num. Elements\n";
+  out << numberOfPoints << "\t# Num. Nodes\n";
+  out << totalWeight << "\t# Sum of Element Weights\n";
   
-  out << numberOfBoundaryConditions << "\t# Num. Boundary Conds." << endl;
+  out << numberOfBoundaryConditions << "\t# Num. Boundary Conds.\n";
 
   int stringSize = 65536;
-  out << stringSize << "\t# String Size (ignore)" << endl;
+  out << stringSize << "\t# String Size (ignore)\n";
 
 //  out << numberOfElementBlocks << "\t# Num. Element Blocks." << endl;
-  out << numberOfElementBlocks << "\t# Num. Element Types." << endl;
+  out << numberOfElementBlocks << "\t# Num. Element Types.\n";
 
   for (i=0; i<numberOfVolumeCellTypes; i++)
     {
@@ -232,7 +293,7 @@ void vtkvmtkXdaWriter::WriteData()
       out << elementTypeLibmeshMap[i] << " ";
       }
     }
-  out << "\t# Element types in each block." << endl;
+  out << "\t# Element types in each block.\n";
 
   for (i=0; i<numberOfVolumeCellTypes; i++)
     {
@@ -241,10 +302,10 @@ void vtkvmtkXdaWriter::WriteData()
       out << numberOfElementsInBlock[i] << " ";
       }
     }
-  out << "\t# Num. of elements in each block at each refinement level." << endl;
+  out << "\t# Num. of elements in each block at each refinement level.\n";
 
-  out << "Id String" << endl;
-  out << "Title String" << endl;
+  out << "Id String\n";
+  out << "Title String\n";
 
   vtkIdList* volumeCellIdMap = vtkIdList::New();
   volumeCellIdMap->SetNumberOfIds(numberOfCells);
@@ -264,36 +325,22 @@ void vtkvmtkXdaWriter::WriteData()
 
     int numberOfTypeCells = typeCellIds->GetNumberOfTuples();
 
+    ElementFormatter elementFormatter(input,typeCellIds,libmeshConnectivity);
+    vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfTypeCells,elementFormatter);
+
     int j;
     for (j=0; j<numberOfTypeCells; j++)
       {
-      vtkIdType id = typeCellIds->GetValue(j);
-      vtkIdList* cellPoints = vtkIdList::New();
-      input->GetCellPoints(id,cellPoints);
-      //TODO: get individual connectivity, reversed if needed by positive Jacobian in libMesh
-      int numberOfCellPoints = libmeshConnectivity->GetNumberOfIds();
-      for (int k=0; k<numberOfCellPoints; k++)
-        {
-        out << cellPoints->GetId(libmeshConnectivity->GetId(k)) << " ";
-        }
-//      out << j << " " << "-1"; // TODO: change -1 into parent for AMR datasets
-      out << endl;
-
-      volumeCellIdMap->SetId(id,volumeCellCounter);
+      volumeCellIdMap->SetId(typeCellIds->GetValue(j),volumeCellCounter);
       volumeCellCounter++;
-      cellPoints->Delete();
       }
     
     typeCellIds->Delete();
     libmeshConnectivity->Delete();
     }
 
-  double point[3];
-  for (i=0; i<numberOfPoints; i++)
-    {
-    input->GetPoint(i,point);
-    out << point[0] << " " << point[1] << " " << point[2] << endl;
-    }
+  PointFormatter pointFormatter(input);
+  vtkvmtkTextWriterUtilities::WriteRecords(out,numberOfPoints,pointFormatter);
 
   if (boundaryDataArray)
     {
@@ -361,12 +408,18 @@ void vtkvmtkXdaWriter::WriteData()
       libmeshFaceOrder->Delete();
 
       short int boundaryValue = static_cast<short int>(boundaryDataArray->GetComponent(i,0));
-      out << volumeCellIdMap->GetId(cellId) << " " << libmeshFaceId << " " << boundaryValue << endl;
+      out << volumeCellIdMap->GetId(cellId) << " " << libmeshFaceId << " " << boundaryValue << "\n";
 
       faceCellPoints->Delete();
+      cellIds->Delete();
       }
     }
 
+  if (!out.good())
+    {
+    vtkErrorMacro(<<"Error writing file.");
+    }
+
   volumeCellIdMap->Delete();
 }
 
@@ -0,0 +1,368 @@
+/*=========================================================================
+                                                                                                                                    
+Program:   VMTK
+Module:    $RCSfile: vtkvmtkXdmfWriter.cxx,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:47:47 $
+Version:   $Revision: 1.6 $
+                                                                                                                                    
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm 
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even 
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+     PURPOSE.  See the above copyright notices for more information.
+                                                                                                                                    
+=========================================================================*/
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "vtkvmtkXdmfWriter.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkCellType.h"
+#include "vtkCellData.h"
+#include "vtkIdTypeArray.h"
+#include "vtkIdList.h"
+#include "vtkSMPTools.h"
+#include "vtkObjectFactory.h"
+#include "vtk_hdf5.h"
+
+
+namespace
+{
+
+// Point ids of each listed cell, sorted if requested (dolfin wants the
+// vertices of simplices in ascending order).
+class TopologyFunctor
+{
+public:
+  TopologyFunctor(vtkUnstructuredGrid* input, vtkIdTypeArray* cellIds, int numberOfCellPoints, bool sort, long long* topology)
+    : Input(input), CellIds(cellIds), NumberOfCellPoints(numberOfCellPoints), Sort(sort), Topology(topology) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkIdList* cellPointIds = vtkIdList::New();
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Input->GetCellPoints(this->CellIds->GetValue(i),cellPointIds);
+      long long* cellTopology = this->Topology + i*this->NumberOfCellPoints;
+      for (int k=0; k<this->NumberOfCellPoints; k++)
+        {
+        cellTopology[k] = cellPointIds->GetId(k);
+        }
+      if (this->Sort)
+        {
+        std::sort(cellTopology,cellTopology+this->NumberOfCellPoints);
+        }
+      }
+    cellPointIds->Delete();
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  vtkIdTypeArray* CellIds;
+  int NumberOfCellPoints;
+  bool Sort;
+  long long* Topology;
+};
+
+class GeometryFunctor
+{
+public:
+  GeometryFunctor(vtkUnstructuredGrid* input, double* geometry) : Input(input), Geometry(geometry) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Input->GetPoint(i,this->Geometry+3*i);
+      }
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  double* Geometry;
+};
+
+class MarkerFunctor
+{
+public:
+  MarkerFunctor(vtkIdTypeArray* cellIds, vtkIdTypeArray* cellEntityIds, int offset, int* markers)
+    : CellIds(cellIds), CellEntityIds(cellEntityIds), Offset(offset), Markers(markers) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Markers[i] = static_cast<int>(this->CellEntityIds->GetValue(this->CellIds->GetValue(i))) + this->Offset;
+      }
+  }
+
+private:
+  vtkIdTypeArray* CellIds;
+  vtkIdTypeArray* CellEntityIds;
+  int Offset;
+  int* Markers;
+};
+
+// Write a rows x columns dataset at path, creating the groups on the way.
+bool WriteDataset(hid_t file, const char* path, hid_t memoryType, hid_t fileType, hsize_t rows, hsize_t columns,
+                  const void* data, int compressionLevel, int chunkSize)
+{
+  hsize_t dimensions[2] = {rows, columns};
+  hid_t dataSpace = H5Screate_simple(columns > 1 ? 2 : 1,dimensions,NULL);
+
+  hid_t linkProperties = H5Pcreate(H5P_LINK_CREATE);
+  H5Pset_create_intermediate_group(linkProperties,1);
+
+  hid_t creationProperties = H5Pcreate(H5P_DATASET_CREATE);
+  if (compressionLevel > 0 && rows > 0)
+    {
+    hsize_t chunkDimensions[2] = {std::min(rows,static_cast<hsize_t>(chunkSize)), columns};
+    H5Pset_chunk(creationProperties,columns > 1 ? 2 : 1,chunkDimensions);
+    H5Pset_shuffle(creationProperties);
+    H5Pset_deflate(creationProperties,static_cast<unsigned int>(compressionLevel));
+    }
+
+  bool success = false;
+  hid_t dataSet = H5Dcreate2(file,path,fileType,dataSpace,linkProperties,creationProperties,H5P_DEFAULT);
+  if (dataSet >= 0)
+    {
+    success = rows == 0 || H5Dwrite(dataSet,memoryType,H5S_ALL,H5S_ALL,H5P_DEFAULT,data) >= 0;
+    H5Dclose(dataSet);
+    }
+
+  H5Pclose(creationProperties);
+  H5Pclose(linkProperties);
+  H5Sclose(dataSpace);
+
+  return success;
+}
+
+void WriteDataItem(std::ostream& out, const char* indent, vtkIdType rows, int columns, const char* numberType, int precision,
+                   const std::string& heavyDataFileName, const char* path)
+{
+  out << indent << "<DataItem Dimensions=\"" << rows;
+  if (columns > 1)
+    {
+    out << " " << columns;
+    }
+  out << "\" NumberType=\"" << numberType << "\" Precision=\"" << precision << "\" Format=\"HDF\">";
+  out << heavyDataFileName << ":" << path << "</DataItem>\n";
+}
+
+void WriteGeometry(std::ostream& out, vtkIdType numberOfPoints, const std::string& heavyDataFileName)
+{
+  out << "      <Geometry GeometryType=\"XYZ\">\n";
+  WriteDataItem(out,"        ",numberOfPoints,3,"Float",8,heavyDataFileName,"/Mesh/mesh/geometry");
+  out << "      </Geometry>\n";
+}
+
+void WriteTopology(std::ostream& out, const char* topologyType, vtkIdType numberOfCells, int numberOfCellPoints,
+                   const std::string& heavyDataFileName, const char* path)
+{
+  out << "      <Topology TopologyType=\"" << topologyType << "\" NumberOfElements=\"" << numberOfCells << "\" NodesPerElement=\"" << numberOfCellPoints << "\">\n";
+  WriteDataItem(out,"        ",numberOfCells,numberOfCellPoints,"Int",8,heavyDataFileName,path);
+  out << "      </Topology>\n";
+}
+
+void WriteMarkers(std::ostream& out, const char* name, vtkIdType numberOfCells, const std::string& heavyDataFileName, const char* path)
+{
+  out << "      <Attribute Name=\"" << name << "\" AttributeType=\"Scalar\" Center=\"Cell\">\n";
+  WriteDataItem(out,"        ",numberOfCells,1,"Int",4,heavyDataFileName,path);
+  out << "      </Attribute>\n";
+}
+
+}
+
+vtkStandardNewMacro(vtkvmtkXdmfWriter);
+
+vtkvmtkXdmfWriter::vtkvmtkXdmfWriter()
+{
+  this->BoundaryDataArrayName = NULL;
+  this->BoundaryDataIdOffset = 0;
+  this->StoreCellMarkers = 0;
+  this->CompressionLevel = 0;
+  this->ChunkSize = 65536;
+}
+
+vtkvmtkXdmfWriter::~vtkvmtkXdmfWriter()
+{
+  if (this->BoundaryDataArrayName)
+    {
+    delete[] this->BoundaryDataArrayName;
+    this->BoundaryDataArrayName = NULL;
+    }
+}
+
+void vtkvmtkXdmfWriter::WriteData()
+{
+  if (!this->FileName)
+    {
+    vtkErrorMacro(<<"FileName not set.");
+    return;
+    }
+
+  // Heavy data goes to FileName with extension .h5, referenced by its name
+  // relative to the XML file
+  std::string fileName = this->FileName;
+  std::string::size_type directoryEnd = fileName.find_last_of("/\\");
+  std::string::size_type nameBegin = directoryEnd == std::string::npos ? 0 : directoryEnd + 1;
+  std::string::size_type extensionBegin = fileName.find_last_of('.');
+  if (extensionBegin == std::string::npos || extensionBegin < nameBegin)
+    {
+    extensionBegin = fileName.size();
+    }
+  std::string heavyDataPath = fileName.substr(0,extensionBegin) + ".h5";
+  std::string heavyDataFileName = heavyDataPath.substr(nameBegin);
+
+  vtkUnstructuredGrid *input = vtkUnstructuredGrid::SafeDownCast(this->GetInput());
+  const vtkIdType numberOfPoints = input->GetNumberOfPoints();
+
+  vtkIdTypeArray* cellEntityIds = NULL;
+  if (this->BoundaryDataArrayName)
+    {
+    vtkDataArray * array = input->GetCellData()->GetArray(this->BoundaryDataArrayName);
+    if (array)
+      {
+      cellEntityIds = vtkIdTypeArray::New();
+      cellEntityIds->DeepCopy(array);
+      }
+    else
+      {
+      vtkErrorMacro(<<"Array with specified BoundaryDataArrayName does not exist");
+      }
+    }
+
+  vtkIdTypeArray* tetraCellIdArray = vtkIdTypeArray::New();
+  input->GetIdsOfCellsOfType(VTK_TETRA,tetraCellIdArray);
+  const vtkIdType numberOfTetras = tetraCellIdArray->GetNumberOfTuples();
+
+  vtkIdTypeArray* triangleCellIdArray = vtkIdTypeArray::New();
+  if (cellEntityIds)
+    {
+    input->GetIdsOfCellsOfType(VTK_TRIANGLE,triangleCellIdArray);
+    }
+  const vtkIdType numberOfTriangles = triangleCellIdArray->GetNumberOfTuples();
+  const bool storeCellMarkers = cellEntityIds && this->StoreCellMarkers;
+
+  hid_t file = H5Fcreate(heavyDataPath.c_str(),H5F_ACC_TRUNC,H5P_DEFAULT,H5P_DEFAULT);
+  if (file < 0)
+    {
+    vtkErrorMacro(<<"Could not open file " << heavyDataPath << " for writing.");
+    tetraCellIdArray->Delete();
+    triangleCellIdArray->Delete();
+    if (cellEntityIds)
+      {
+      cellEntityIds->Delete();
+      }
+    return;
+    }
+
+  bool success = true;
+
+  {
+  std::vector<double> geometry(3*numberOfPoints);
+  GeometryFunctor geometryFunctor(input,geometry.data());
+  vtkSMPTools::For(0,numberOfPoints,geometryFunctor);
+  success &= WriteDataset(file,"/Mesh/mesh/geometry",H5T_NATIVE_DOUBLE,H5T_IEEE_F64LE,numberOfPoints,3,geometry.data(),this->CompressionLevel,this->ChunkSize);
+  }
+
+  {
+  std::vector<long long> topology(4*numberOfTetras);
+  TopologyFunctor topologyFunctor(input,tetraCellIdArray,4,true,topology.data());
+  vtkSMPTools::For(0,numberOfTetras,topologyFunctor);
+  success &= WriteDataset(file,"/Mesh/mesh/topology",H5T_NATIVE_LLONG,H5T_STD_I64LE,numberOfTetras,4,topology.data(),this->CompressionLevel,this->ChunkSize);
+  }
+
+  if (numberOfTriangles)
+    {
+    std::vector<long long> topology(3*numberOfTriangles);
+    TopologyFunctor topologyFunctor(input,triangleCellIdArray,3,true,topology.data());
+    vtkSMPTools::For(0,numberOfTriangles,topologyFunctor);
+    success &= WriteDataset(file,"/MeshTags/facets/topology",H5T_NATIVE_LLONG,H5T_STD_I64LE,numberOfTriangles,3,topology.data(),this->CompressionLevel,this->ChunkSize);
+
+    std::vector<int> markers(numberOfTriangles);
+    MarkerFunctor markerFunctor(triangleCellIdArray,cellEntityIds,this->BoundaryDataIdOffset,markers.data());
+    vtkSMPTools::For(0,numberOfTriangles,markerFunctor);
+    success &= WriteDataset(file,"/MeshTags/facets/values",H5T_NATIVE_INT,H5T_STD_I32LE,numberOfTriangles,1,markers.data(),this->CompressionLevel,this->ChunkSize);
+    }
+
+  if (storeCellMarkers)
+    {
+    std::vector<int> markers(numberOfTetras);
+    MarkerFunctor markerFunctor(tetraCellIdArray,cellEntityIds,0,markers.data());
+    vtkSMPTools::For(0,numberOfTetras,markerFunctor);
+    success &= WriteDataset(file,"/MeshTags/cells/values",H5T_NATIVE_INT,H5T_STD_I32LE,numberOfTetras,1,markers.data(),this->CompressionLevel,this->ChunkSize);
+    }
+
+  H5Fclose(file);
+
+  if (!success)
+    {
+    vtkErrorMacro(<<"Error writing file " << heavyDataPath << ".");
+    }
+
+  std::ofstream out (this->FileName);
+  if (!out.good())
+    {
+    vtkErrorMacro(<<"Could not open file for writing.");
+    }
+  else
+    {
+    out << "<?xml version=\"1.0\"?>\n";
+    out << "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n";
+    out << "<Xdmf Version=\"3.0\" xmlns:xi=\"http://www.w3.org/2001/XInclude\">\n";
+    out << "  <Domain>\n";
+
+    out << "    <Grid Name=\"mesh\" GridType=\"Uniform\">\n";
+    WriteTopology(out,"Tetrahedron",numberOfTetras,4,heavyDataFileName,"/Mesh/mesh/topology");
+    WriteGeometry(out,numberOfPoints,heavyDataFileName);
+    out << "    </Grid>\n";
+
+    if (numberOfTriangles)
+      {
+      out << "    <Grid Name=\"facets\" GridType=\"Uniform\">\n";
+      WriteTopology(out,"Triangle",numberOfTriangles,3,heavyDataFileName,"/MeshTags/facets/topology");
+      WriteGeometry(out,numberOfPoints,heavyDataFileName);
+      WriteMarkers(out,"facets",numberOfTriangles,heavyDataFileName,"/MeshTags/facets/values");
+      out << "    </Grid>\n";
+      }
+
+    if (storeCellMarkers)
+      {
+      out << "    <Grid Name=\"cells\" GridType=\"Uniform\">\n";
+      WriteTopology(out,"Tetrahedron",numberOfTetras,4,heavyDataFileName,"/Mesh/mesh/topology");
+      WriteGeometry(out,numberOfPoints,heavyDataFileName);
+      WriteMarkers(out,"cells",numberOfTetras,heavyDataFileName,"/MeshTags/cells/values");
+      out << "    </Grid>\n";
+      }
+
+    out << "  </Domain>\n";
+    out << "</Xdmf>\n";
+
+    if (!out.good())
+      {
+      vtkErrorMacro(<<"Error writing file.");
+      }
+    }
+
+  tetraCellIdArray->Delete();
+  triangleCellIdArray->Delete();
+  if (cellEntityIds)
+    {
+    cellEntityIds->Delete();
+    }
+}
+
+void vtkvmtkXdmfWriter::PrintSelf(std::ostream& os, vtkIndent indent)
+{
+  vtkUnstructuredGridWriter::PrintSelf(os,indent);
+}
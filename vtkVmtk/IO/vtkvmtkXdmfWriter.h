@@ -0,0 +1,88 @@
+/*=========================================================================
+                                                                                                                                    
+Program:   VMTK
+Module:    $RCSfile: vtkvmtkXdmfWriter.h,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:47:47 $
+Version:   $Revision: 1.2 $
+                                                                                                                                    
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm 
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even 
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+     PURPOSE.  See the above copyright notices for more information.
+                                                                                                                                    
+=========================================================================*/
+// .NAME vtkvmtkXdmfWriter - write tetrahedral meshes as XDMF with HDF5 heavy data.
+// .SECTION Description
+// vtkvmtkXdmfWriter writes the tetrahedra of a mesh in the XDMF format read
+// by FEniCS (dolfin XDMFFile, dolfinx read_mesh/read_meshtags). The XML
+// file only describes the grids; points, connectivity and markers are
+// stored as contiguous binary datasets in an HDF5 file next to it, with the
+// same name and extension .h5. The XML file contains the grids:
+//     * mesh   - tetrahedra (vertex ids sorted, as for the Dolfin writer)
+//     * facets - triangles of the input with their BoundaryDataArrayName
+//                value plus BoundaryDataIdOffset
+//     * cells  - tetrahedra with their BoundaryDataArrayName value, only
+//                if StoreCellMarkers is on
+// Datasets are stored in chunks of ChunkSize rows and deflated if
+// CompressionLevel is greater than 0.
+// .SECTION See Also
+// vtkvmtkDolfinWriter
+
+#ifndef __vtkvmtkXdmfWriter_h
+#define __vtkvmtkXdmfWriter_h
+
+#include "vtkvmtkWin32Header.h"
+#include "vtkUnstructuredGridWriter.h"
+
+class VTK_VMTK_IO_EXPORT vtkvmtkXdmfWriter : public vtkUnstructuredGridWriter
+{
+public:
+  static vtkvmtkXdmfWriter *New();
+  vtkTypeMacro(vtkvmtkXdmfWriter,vtkUnstructuredGridWriter);
+  void PrintSelf(std::ostream& os, vtkIndent indent) override;
+
+  vtkSetStringMacro(BoundaryDataArrayName);
+  vtkGetStringMacro(BoundaryDataArrayName);
+
+  vtkSetMacro(BoundaryDataIdOffset,int);
+  vtkGetMacro(BoundaryDataIdOffset,int);
+
+  vtkSetMacro(StoreCellMarkers,int);
+  vtkGetMacro(StoreCellMarkers,int);
+  vtkBooleanMacro(StoreCellMarkers,int);
+
+  // Description:
+  // Deflate level of the HDF5 datasets, 0 (default) for no compression.
+  vtkSetClampMacro(CompressionLevel,int,0,9);
+  vtkGetMacro(CompressionLevel,int);
+
+  // Description:
+  // Number of rows of a dataset chunk.
+  vtkSetClampMacro(ChunkSize,int,1,VTK_INT_MAX);
+  vtkGetMacro(ChunkSize,int);
+
+protected:
+  vtkvmtkXdmfWriter();
+  ~vtkvmtkXdmfWriter();
+
+  void WriteData() override;
+
+  char* BoundaryDataArrayName;
+  int BoundaryDataIdOffset;
+  int StoreCellMarkers;
+  int CompressionLevel;
+  int ChunkSize;
+
+private:
+  vtkvmtkXdmfWriter(const vtkvmtkXdmfWriter&);  // Not implemented.
+  void operator=(const vtkvmtkXdmfWriter&);  // Not implemented.
+};
+
+#endif
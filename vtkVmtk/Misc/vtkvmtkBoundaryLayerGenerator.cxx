@@ -35,7 +35,424 @@ Version:   $Revision: 1.7 $
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
 
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+// Points of the sublayer subLayerId of a range of surface points, warped
+// along their warp vectors. With quadratic on, the mid points of the
+// sublayer go to the first half of warpedPoints and its top points to the
+// second half.
+class WarpPointsFunctor
+{
+public:
+  WarpPointsFunctor(vtkDataArray* warpVectorsArray, vtkPoints* inputPoints, vtkPoints* warpedPoints, double subLayerOffsetRatio, double subLayerThicknessRatio, bool quadratic)
+    : WarpVectorsArray(warpVectorsArray), InputPoints(inputPoints), WarpedPoints(warpedPoints),
+      SubLayerOffsetRatio(subLayerOffsetRatio), SubLayerThicknessRatio(subLayerThicknessRatio), Quadratic(quadratic) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkIdType numberOfInputPoints = this->InputPoints->GetNumberOfPoints();
+    double point[3], warpedPoint[3], warpVector[3];
+    double layerThickness, subLayerOffset, subLayerThickness;
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->InputPoints->GetPoint(i,point);
+      this->WarpVectorsArray->GetTuple(i,warpVector);
+
+      layerThickness = vtkMath::Norm(warpVector);
+
+      vtkMath::Normalize(warpVector);
+
+      subLayerOffset = this->SubLayerOffsetRatio * layerThickness;
+      subLayerThickness = this->SubLayerThicknessRatio * layerThickness;
+
+      if (this->Quadratic)
+        {
+        warpedPoint[0] = point[0] + 0.5 * warpVector[0] * (subLayerOffset + subLayerThickness);
+        warpedPoint[1] = point[1] + 0.5 * warpVector[1] * (subLayerOffset + subLayerThickness);
+        warpedPoint[2] = point[2] + 0.5 * warpVector[2] * (subLayerOffset + subLayerThickness);
+        this->WarpedPoints->SetPoint(i,warpedPoint);
+        warpedPoint[0] = point[0] + warpVector[0] * (subLayerOffset + subLayerThickness);
+        warpedPoint[1] = point[1] + warpVector[1] * (subLayerOffset + subLayerThickness);
+        warpedPoint[2] = point[2] + warpVector[2] * (subLayerOffset + subLayerThickness);
+        this->WarpedPoints->SetPoint(i+numberOfInputPoints,warpedPoint);
+        }
+      else
+        {
+        warpedPoint[0] = point[0] + warpVector[0] * (subLayerOffset + subLayerThickness);
+        warpedPoint[1] = point[1] + warpVector[1] * (subLayerOffset + subLayerThickness);
+        warpedPoint[2] = point[2] + warpVector[2] * (subLayerOffset + subLayerThickness);
+        this->WarpedPoints->SetPoint(i,warpedPoint);
+        }
+      }
+  }
+
+private:
+  vtkDataArray* WarpVectorsArray;
+  vtkPoints* InputPoints;
+  vtkPoints* WarpedPoints;
+  double SubLayerOffsetRatio;
+  double SubLayerThicknessRatio;
+  bool Quadratic;
+};
+
+}
+
+// Normal and area of the triangle spanned by the first three points of a
+// range of cells, on the base (unwarped) surface.
+class vtkvmtkBoundaryLayerGenerator::CellGeometryFunctor
+{
+public:
+  CellGeometryFunctor(vtkvmtkBoundaryLayerGenerator* filter) : Filter(filter) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    const double* basePoints = this->Filter->BasePoints.data();
+    for (vtkIdType j=begin; j<end; j++)
+      {
+      const vtkIdType* pts = &this->Filter->CellPointIds[this->Filter->CellOffsets[j]];
+      const double* point1 = basePoints + 3*pts[0];
+      const double* point2 = basePoints + 3*pts[1];
+      const double* point3 = basePoints + 3*pts[2];
+      vtkTriangle::ComputeNormal(point1,point2,point3,&this->Filter->CellNormals[3*j]);
+      this->Filter->CellAreas[j] = vtkTriangle::TriangleArea(point1,point2,point3);
+      }
+  }
+
+private:
+  vtkvmtkBoundaryLayerGenerator* Filter;
+};
+
+// Neighbors of a range of points: the first three points of the cells of a
+// point, in order of appearance. Without fill, counts the neighbors into
+// NeighborOffsets and flags the points which are not relaxed during the
+// warp, i.e. the points with an edge shared by less than two cells and the
+// points without neighbors; with fill, copies the neighbors into
+// NeighborIds.
+class vtkvmtkBoundaryLayerGenerator::NeighborsFunctor
+{
+public:
+  NeighborsFunctor(vtkvmtkBoundaryLayerGenerator* filter, bool fill) : Filter(filter), Fill(fill) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    const vtkvmtkBoundaryLayerGenerator* filter = this->Filter;
+    std::vector<vtkIdType>& neighborIds = this->LocalNeighborIds.Local();
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      const vtkIdType* cellIds = filter->PointCellIds.data() + filter->PointCellOffsets[i];
+      vtkIdType numberOfCells = filter->PointCellOffsets[i+1] - filter->PointCellOffsets[i];
+      neighborIds.clear();
+      for (vtkIdType k=0; k<numberOfCells; k++)
+        {
+        const vtkIdType* pts = &filter->CellPointIds[filter->CellOffsets[cellIds[k]]];
+        for (int q=0; q<3; q++)
+          {
+          if (pts[q] != i && std::find(neighborIds.begin(),neighborIds.end(),pts[q]) == neighborIds.end())
+            {
+            neighborIds.push_back(pts[q]);
+            }
+          }
+        }
+
+      if (this->Fill)
+        {
+        std::copy(neighborIds.begin(),neighborIds.end(),this->Filter->NeighborIds.begin()+filter->NeighborOffsets[i]);
+        continue;
+        }
+
+      this->Filter->NeighborOffsets[i+1] = static_cast<vtkIdType>(neighborIds.size());
+
+      bool onEdge = neighborIds.empty();
+      for (size_t n=0; n<neighborIds.size() && !onEdge; n++)
+        {
+        // all the cells sharing the edge (i,neighbor) are cells of i
+        int numberOfEdgeCells = 0;
+        for (vtkIdType k=0; k<numberOfCells; k++)
+          {
+          vtkIdType cellId = cellIds[k];
+          const vtkIdType* first = filter->CellPointIds.data() + filter->CellOffsets[cellId];
+          const vtkIdType* last = filter->CellPointIds.data() + filter->CellOffsets[cellId+1];
+          if (std::find(first,last,neighborIds[n]) != last)
+            {
+            numberOfEdgeCells++;
+            }
+          }
+        if (numberOfEdgeCells < 2)
+          {
+          onEdge = true;
+          }
+        }
+      this->Filter->FixedPoints[i] = onEdge ? 1 : 0;
+      }
+  }
+
+private:
+  vtkvmtkBoundaryLayerGenerator* Filter;
+  bool Fill;
+  mutable vtkSMPThreadLocal<std::vector<vtkIdType> > LocalNeighborIds;
+};
+
+// One warp substep of a range of points: each point is moved by its step
+// and relaxed towards the barycenter of its moved neighbors. Points are
+// relaxed from the moved positions of the previous substep only (Jacobi
+// sweep), so the result does not depend on the order of the points.
+class vtkvmtkBoundaryLayerGenerator::IncrementalWarpFunctor
+{
+public:
+  IncrementalWarpFunctor(vtkvmtkBoundaryLayerGenerator* filter, const std::vector<double>& steps, const std::vector<double>& basePoints, std::vector<double>& warpedPoints, double relaxation)
+    : Filter(filter), Steps(steps.data()), BasePoints(basePoints.data()), WarpedPoints(warpedPoints.data()), Relaxation(relaxation) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    const vtkIdType* neighborOffsets = this->Filter->NeighborOffsets.data();
+    const vtkIdType* neighborIds = this->Filter->NeighborIds.data();
+    double warpedPoint[3], barycenter[3];
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      warpedPoint[0] = this->BasePoints[3*i+0] + this->Steps[3*i+0];
+      warpedPoint[1] = this->BasePoints[3*i+1] + this->Steps[3*i+1];
+      warpedPoint[2] = this->BasePoints[3*i+2] + this->Steps[3*i+2];
+
+      if (!this->Filter->FixedPoints[i])
+        {
+        vtkIdType numberOfNeighbors = neighborOffsets[i+1] - neighborOffsets[i];
+        barycenter[0] = barycenter[1] = barycenter[2] = 0.0;
+        for (vtkIdType k=neighborOffsets[i]; k<neighborOffsets[i+1]; k++)
+          {
+          vtkIdType neighborId = neighborIds[k];
+          barycenter[0] += this->BasePoints[3*neighborId+0] + this->Steps[3*neighborId+0];
+          barycenter[1] += this->BasePoints[3*neighborId+1] + this->Steps[3*neighborId+1];
+          barycenter[2] += this->BasePoints[3*neighborId+2] + this->Steps[3*neighborId+2];
+          }
+        barycenter[0] /= numberOfNeighbors;
+        barycenter[1] /= numberOfNeighbors;
+        barycenter[2] /= numberOfNeighbors;
+
+        warpedPoint[0] += this->Relaxation * (barycenter[0] - warpedPoint[0]);
+        warpedPoint[1] += this->Relaxation * (barycenter[1] - warpedPoint[1]);
+        warpedPoint[2] += this->Relaxation * (barycenter[2] - warpedPoint[2]);
+        }
+
+      this->WarpedPoints[3*i+0] = warpedPoint[0];
+      this->WarpedPoints[3*i+1] = warpedPoint[1];
+      this->WarpedPoints[3*i+2] = warpedPoint[2];
+      }
+  }
+
+private:
+  vtkvmtkBoundaryLayerGenerator* Filter;
+  const double* Steps;
+  const double* BasePoints;
+  double* WarpedPoints;
+  double Relaxation;
+};
+
+// Points the warp vectors of a range of points from the base surface to
+// the warped one, keeping their magnitude.
+class vtkvmtkBoundaryLayerGenerator::WarpDirectionsFunctor
+{
+public:
+  WarpDirectionsFunctor(vtkvmtkBoundaryLayerGenerator* filter, const std::vector<double>& warpedPoints)
+    : Filter(filter), WarpedPoints(warpedPoints.data()) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    const double* basePoints = this->Filter->BasePoints.data();
+    double warpVector[3];
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Filter->WarpVectorsArray->GetTuple(i,warpVector);
+      double layerThickness = vtkMath::Norm(warpVector);
+      warpVector[0] = this->WarpedPoints[3*i+0] - basePoints[3*i+0];
+      warpVector[1] = this->WarpedPoints[3*i+1] - basePoints[3*i+1];
+      warpVector[2] = this->WarpedPoints[3*i+2] - basePoints[3*i+2];
+      vtkMath::Normalize(warpVector);
+      warpVector[0] = warpVector[0] * layerThickness;
+      warpVector[1] = warpVector[1] * layerThickness;
+      warpVector[2] = warpVector[2] * layerThickness;
+      this->Filter->WarpVectorsArray->SetTuple(i,warpVector);
+      }
+  }
+
+private:
+  vtkvmtkBoundaryLayerGenerator* Filter;
+  const double* WarpedPoints;
+};
+
+// Flags the cells of a range whose extruded triangle is flipped or shrunk
+// to a tenth of the base one, and counts them per thread.
+class vtkvmtkBoundaryLayerGenerator::TangleFunctor
+{
+public:
+  TangleFunctor(vtkvmtkBoundaryLayerGenerator* filter, vtkUnsignedCharArray* checkArray)
+    : Filter(filter), CheckArray(checkArray), TangledCells(0)
+  {
+    this->NumberOfTangledCells = 0;
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkIdType& tangledCells = this->TangledCells.Local();
+    const double* basePoints = this->Filter->BasePoints.data();
+    double warpedPoints[3][3], warpedNormal[3];
+    for (vtkIdType j=begin; j<end; j++)
+      {
+      const vtkIdType* pts = &this->Filter->CellPointIds[this->Filter->CellOffsets[j]];
+      for (int q=0; q<3; q++)
+        {
+        this->Filter->WarpVectorsArray->GetTuple(pts[q],warpedPoints[q]);
+        warpedPoints[q][0] += basePoints[3*pts[q]+0];
+        warpedPoints[q][1] += basePoints[3*pts[q]+1];
+        warpedPoints[q][2] += basePoints[3*pts[q]+2];
+        }
+
+      vtkTriangle::ComputeNormal(warpedPoints[0],warpedPoints[1],warpedPoints[2],warpedNormal);
+      double prod = vtkMath::Dot(&this->Filter->CellNormals[3*j],warpedNormal);
+      double warpedArea = vtkTriangle::TriangleArea(warpedPoints[0],warpedPoints[1],warpedPoints[2]);
+      double testArea = warpedArea / this->Filter->CellAreas[j];
+      if (prod < 0 || testArea <= 0.1 )
+        {
+        tangledCells++;
+        this->CheckArray->SetValue(j,1);
+        }
+      else
+        {
+        this->CheckArray->SetValue(j,0);
+        }
+      }
+  }
+
+  // Sums the thread local counts of tangled cells.
+  void Reduce()
+  {
+    this->NumberOfTangledCells = 0;
+    for (vtkSMPThreadLocal<vtkIdType>::iterator it=this->TangledCells.begin(); it!=this->TangledCells.end(); ++it)
+      {
+      this->NumberOfTangledCells += *it;
+      }
+  }
+
+  vtkIdType NumberOfTangledCells;
+
+private:
+  vtkvmtkBoundaryLayerGenerator* Filter;
+  vtkUnsignedCharArray* CheckArray;
+  mutable vtkSMPThreadLocal<vtkIdType> TangledCells;
+};
+
+// Untangling of a range of points in two passes over all the points. The
+// first pass computes, for the points of the flagged cells, the normalized
+// sum of the projections of their warp vector on the planes of their
+// cells. The second pass gathers for each point the tangent directions of
+// the other two points of each of its flagged cells, scaled by alpha,
+// bends its warp vector by their sum and restores its magnitude. Only the
+// first three points of a cell take part, as in CheckTangle.
+class vtkvmtkBoundaryLayerGenerator::UntangleFunctor
+{
+public:
+  UntangleFunctor(vtkvmtkBoundaryLayerGenerator* filter, vtkUnsignedCharArray* checkArray, std::vector<double>& tangentDirections, double alpha, bool correct)
+    : Filter(filter), CheckArray(checkArray), TangentDirections(tangentDirections.data()), Alpha(alpha), Correct(correct) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    const vtkvmtkBoundaryLayerGenerator* filter = this->Filter;
+    double warpVector[3], tangentDirection[3], correction[3];
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      const vtkIdType* cellIds = filter->PointCellIds.data() + filter->PointCellOffsets[i];
+      vtkIdType numberOfCells = filter->PointCellOffsets[i+1] - filter->PointCellOffsets[i];
+
+      if (!this->Correct)
+        {
+        if (!this->IsOnTangledCell(i,cellIds,numberOfCells))
+          {
+          continue;
+          }
+        this->Filter->WarpVectorsArray->GetTuple(i,warpVector);
+        tangentDirection[0] = tangentDirection[1] = tangentDirection[2] = 0.0;
+        for (vtkIdType k=0; k<numberOfCells; k++)
+          {
+          const double* n = &filter->CellNormals[3*cellIds[k]];
+          double dot = vtkMath::Dot(warpVector,n);
+          tangentDirection[0] += warpVector[0] - dot * n[0];
+          tangentDirection[1] += warpVector[1] - dot * n[1];
+          tangentDirection[2] += warpVector[2] - dot * n[2];
+          }
+        vtkMath::Normalize(tangentDirection);
+        this->TangentDirections[3*i+0] = tangentDirection[0];
+        this->TangentDirections[3*i+1] = tangentDirection[1];
+        this->TangentDirections[3*i+2] = tangentDirection[2];
+        continue;
+        }
+
+      correction[0] = correction[1] = correction[2] = 0.0;
+      for (vtkIdType k=0; k<numberOfCells; k++)
+        {
+        if (this->CheckArray->GetValue(cellIds[k]) != 1)
+          {
+          continue;
+          }
+        const vtkIdType* pts = &filter->CellPointIds[filter->CellOffsets[cellIds[k]]];
+        if (pts[0] != i && pts[1] != i && pts[2] != i)
+          {
+          continue;
+          }
+        for (int q=0; q<3; q++)
+          {
+          if (pts[q] == i)
+            {
+            continue;
+            }
+          correction[0] += this->Alpha * this->TangentDirections[3*pts[q]+0];
+          correction[1] += this->Alpha * this->TangentDirections[3*pts[q]+1];
+          correction[2] += this->Alpha * this->TangentDirections[3*pts[q]+2];
+          }
+        }
+
+      this->Filter->WarpVectorsArray->GetTuple(i,warpVector);
+      double layerThickness = vtkMath::Norm(warpVector);
+      warpVector[0] = warpVector[0] + correction[0];
+      warpVector[1] = warpVector[1] + correction[1];
+      warpVector[2] = warpVector[2] + correction[2];
+      vtkMath::Normalize(warpVector);
+      warpVector[0] = warpVector[0] * layerThickness;
+      warpVector[1] = warpVector[1] * layerThickness;
+      warpVector[2] = warpVector[2] * layerThickness;
+      this->Filter->WarpVectorsArray->SetTuple(i,warpVector);
+      }
+  }
+
+private:
+  bool IsOnTangledCell(vtkIdType pointId, const vtkIdType* cellIds, vtkIdType numberOfCells) const
+  {
+    for (vtkIdType k=0; k<numberOfCells; k++)
+      {
+      if (this->CheckArray->GetValue(cellIds[k]) != 1)
+        {
+        continue;
+        }
+      const vtkIdType* pts = &this->Filter->CellPointIds[this->Filter->CellOffsets[cellIds[k]]];
+      if (pts[0] == pointId || pts[1] == pointId || pts[2] == pointId)
+        {
+        return true;
+        }
+      }
+    return false;
+  }
+
+  vtkvmtkBoundaryLayerGenerator* Filter;
+  vtkUnsignedCharArray* CheckArray;
+  double* TangentDirections;
+  double Alpha;
+  bool Correct;
+};
 
 vtkStandardNewMacro(vtkvmtkBoundaryLayerGenerator);
 
@@ -70,6 +487,8 @@ vtkvmtkBoundaryLayerGenerator::vtkvmtkBoundaryLayerGenerator()
   this->VolumeCellEntityId = 0;
 
   this->InnerSurface = NULL;
+
+  this->ParallelComputation = 1;
 }
 
 vtkvmtkBoundaryLayerGenerator::~vtkvmtkBoundaryLayerGenerator()
@@ -149,6 +568,12 @@ int vtkvmtkBoundaryLayerGenerator::RequestData(
     this->LayerThicknessArray = input->GetPointData()->GetArray(this->LayerThicknessArrayName);
     }
 
+  if (!this->BuildSurfaceTopology(input))
+    {
+    this->ReleaseSurfaceTopology();
+    return 1;
+    }
+
   vtkIdType i;
 
   vtkPoints* outputPoints = vtkPoints::New();
@@ -517,10 +942,112 @@ int vtkvmtkBoundaryLayerGenerator::RequestData(
   cellEntityIdsArray->Delete();
   innerSurfaceCellEntityIdsArray->Delete();
   checkArray->Delete();
+
+  this->ReleaseSurfaceTopology();
  
   return 1;
 }
 
+int vtkvmtkBoundaryLayerGenerator::BuildSurfaceTopology(vtkUnstructuredGrid* input)
+{
+  vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  vtkIdType numberOfCells = input->GetNumberOfCells();
+
+  this->BasePoints.resize(3*numberOfPoints);
+  for (vtkIdType i=0; i<numberOfPoints; i++)
+    {
+    input->GetPoint(i,&this->BasePoints[3*i]);
+    }
+
+  vtkIdType npts;
+  const vtkIdType *pts;
+  this->CellOffsets.resize(numberOfCells+1);
+  this->CellOffsets[0] = 0;
+  for (vtkIdType j=0; j<numberOfCells; j++)
+    {
+    input->GetCellPoints(j,npts,pts);
+    if (npts < 3)
+      {
+      vtkErrorMacro(<<"Cell "<<j<<" has fewer than three points.");
+      return 0;
+      }
+    this->CellOffsets[j+1] = this->CellOffsets[j] + npts;
+    }
+  this->CellPointIds.resize(this->CellOffsets[numberOfCells]);
+  this->PointCellOffsets.assign(numberOfPoints+1,0);
+  for (vtkIdType j=0; j<numberOfCells; j++)
+    {
+    input->GetCellPoints(j,npts,pts);
+    for (vtkIdType k=0; k<npts; k++)
+      {
+      this->CellPointIds[this->CellOffsets[j]+k] = pts[k];
+      this->PointCellOffsets[pts[k]+1]++;
+      }
+    }
+
+  for (vtkIdType i=0; i<numberOfPoints; i++)
+    {
+    this->PointCellOffsets[i+1] += this->PointCellOffsets[i];
+    }
+  this->PointCellIds.resize(this->PointCellOffsets[numberOfPoints]);
+  std::vector<vtkIdType> insertLocations(this->PointCellOffsets.begin(),this->PointCellOffsets.end()-1);
+  for (vtkIdType j=0; j<numberOfCells; j++)
+    {
+    for (vtkIdType k=this->CellOffsets[j]; k<this->CellOffsets[j+1]; k++)
+      {
+      this->PointCellIds[insertLocations[this->CellPointIds[k]]++] = j;
+      }
+    }
+
+  this->CellNormals.resize(3*numberOfCells);
+  this->CellAreas.resize(numberOfCells);
+  CellGeometryFunctor cellGeometryFunctor(this);
+  this->NeighborOffsets.assign(numberOfPoints+1,0);
+  this->FixedPoints.resize(numberOfPoints);
+  NeighborsFunctor countNeighborsFunctor(this,false);
+  if (this->ParallelComputation)
+    {
+    vtkSMPTools::For(0,numberOfCells,cellGeometryFunctor);
+    vtkSMPTools::For(0,numberOfPoints,countNeighborsFunctor);
+    }
+  else
+    {
+    cellGeometryFunctor(0,numberOfCells);
+    countNeighborsFunctor(0,numberOfPoints);
+    }
+
+  for (vtkIdType i=0; i<numberOfPoints; i++)
+    {
+    this->NeighborOffsets[i+1] += this->NeighborOffsets[i];
+    }
+  this->NeighborIds.resize(this->NeighborOffsets[numberOfPoints]);
+  NeighborsFunctor fillNeighborsFunctor(this,true);
+  if (this->ParallelComputation)
+    {
+    vtkSMPTools::For(0,numberOfPoints,fillNeighborsFunctor);
+    }
+  else
+    {
+    fillNeighborsFunctor(0,numberOfPoints);
+    }
+
+  return 1;
+}
+
+void vtkvmtkBoundaryLayerGenerator::ReleaseSurfaceTopology()
+{
+  std::vector<vtkIdType>().swap(this->CellOffsets);
+  std::vector<vtkIdType>().swap(this->CellPointIds);
+  std::vector<vtkIdType>().swap(this->PointCellOffsets);
+  std::vector<vtkIdType>().swap(this->PointCellIds);
+  std::vector<vtkIdType>().swap(this->NeighborOffsets);
+  std::vector<vtkIdType>().swap(this->NeighborIds);
+  std::vector<char>().swap(this->FixedPoints);
+  std::vector<double>().swap(this->BasePoints);
+  std::vector<double>().swap(this->CellNormals);
+  std::vector<double>().swap(this->CellAreas);
+}
+
 void vtkvmtkBoundaryLayerGenerator::BuildWarpVectors(vtkUnstructuredGrid* input)
 {
   double warpVector[3];
@@ -566,219 +1093,88 @@ void vtkvmtkBoundaryLayerGenerator::BuildWarpVectors(vtkUnstructuredGrid* input)
 
 void vtkvmtkBoundaryLayerGenerator::IncrementalWarpVectors(vtkUnstructuredGrid* input, int numberOfSubsteps, double relaxation)
 {   
-  vtkPoints* inputPoints = input->GetPoints();
-  vtkPoints* warpedPoints = vtkPoints::New();    
-  vtkIdType numberOfInputPoints = inputPoints->GetNumberOfPoints();    
+  vtkIdType numberOfInputPoints = input->GetNumberOfPoints();
+
+  if (numberOfSubsteps <= 0 || numberOfInputPoints == 0)
+    {
+    return;
+    }
 
-  vtkPoints* basePoints = vtkPoints::New();
-  basePoints->DeepCopy(inputPoints);
+  std::vector<double> steps(3*numberOfInputPoints);
+  double warpVector[3], layerThickness;
+  for (vtkIdType i=0; i<numberOfInputPoints; i++)
+    {
+    this->WarpVectorsArray->GetTuple(i,warpVector);
+    layerThickness = vtkMath::Norm(warpVector);
+    vtkMath::Normalize(warpVector);
+    layerThickness /= numberOfSubsteps;
+    steps[3*i+0] = warpVector[0] * layerThickness;
+    steps[3*i+1] = warpVector[1] * layerThickness;
+    steps[3*i+2] = warpVector[2] * layerThickness;
+    }
 
+  std::vector<double> basePoints(this->BasePoints);
+  std::vector<double> warpedPoints(3*numberOfInputPoints);
   for (int l=0; l<numberOfSubsteps; l++)
     {
-    this->IncrementalWarpPoints(input, basePoints, warpedPoints, l, numberOfSubsteps, relaxation);
-    basePoints->DeepCopy(warpedPoints);
+    this->IncrementalWarpPoints(steps,basePoints,warpedPoints,relaxation);
+    basePoints.swap(warpedPoints);
     }
 
-  double warpVector[3], basePoint[3], warpedPoint[3];
-  for (vtkIdType j=0; j<numberOfInputPoints; j++)
+  WarpDirectionsFunctor functor(this,basePoints);
+  if (this->ParallelComputation)
     {
-    inputPoints->GetPoint(j,basePoint);
-    warpedPoints->GetPoint(j,warpedPoint);
-    this->WarpVectorsArray->GetTuple(j,warpVector);
-    double layerThickness=vtkMath::Norm(warpVector);
-    warpVector[0] = warpedPoint[0] - basePoint[0];
-    warpVector[1] = warpedPoint[1] - basePoint[1];
-    warpVector[2] = warpedPoint[2] - basePoint[2];
-    vtkMath::Normalize(warpVector); 
-    warpVector[0] = warpVector[0] * layerThickness; 
-    warpVector[1] = warpVector[1] * layerThickness; 
-    warpVector[2] = warpVector[2] * layerThickness;  
-    this->WarpVectorsArray->SetTuple(j,warpVector);
+    vtkSMPTools::For(0,numberOfInputPoints,functor);
+    }
+  else
+    {
+    functor(0,numberOfInputPoints);
     }
-    
-  warpedPoints->Delete();
-  basePoints->Delete();
 }
 
 int vtkvmtkBoundaryLayerGenerator::CheckTangle(vtkUnstructuredGrid* input, vtkUnsignedCharArray* checkArray)
 {
-  vtkIdList* pointList=vtkIdList::New();
-  
-  double warpVector1[3], warpVector2[3],  warpVector3[3];
-  double basePoint1[3], basePoint2[3], basePoint3[3];
-  double warpedPoint1[3], warpedPoint2[3], warpedPoint3[3];
-  double baseNormal[3], warpedNormal[3];
-  
-  int found = 0;
-  int check = 0;
-  for (vtkIdType j=0; j<input->GetNumberOfCells(); j++)
-    {
-    input->GetCellPoints(j,pointList);
-    //points on base triangle
-    input->GetPoint(pointList->GetId(0),basePoint1);
-    input->GetPoint(pointList->GetId(1),basePoint2);
-    input->GetPoint(pointList->GetId(2),basePoint3);
-    
-    this->WarpVectorsArray->GetTuple(pointList->GetId(0),warpVector1);
-    this->WarpVectorsArray->GetTuple(pointList->GetId(1),warpVector2);
-    this->WarpVectorsArray->GetTuple(pointList->GetId(2),warpVector3);
-                                  
-    //points on extruded triangle
-    warpedPoint1[0] = basePoint1[0] + warpVector1[0];
-    warpedPoint1[1] = basePoint1[1] + warpVector1[1];
-    warpedPoint1[2] = basePoint1[2] + warpVector1[2];
-    warpedPoint2[0] = basePoint2[0] + warpVector2[0];
-    warpedPoint2[1] = basePoint2[1] + warpVector2[1];
-    warpedPoint2[2] = basePoint2[2] + warpVector2[2];           
-    warpedPoint3[0] = basePoint3[0] + warpVector3[0];
-    warpedPoint3[1] = basePoint3[1] + warpVector3[1];
-    warpedPoint3[2] = basePoint3[2] + warpVector3[2];          
-    
-    //normals on base triangle (baseNormal) and normals on extruded triangle (warpedNormal)
-    vtkTriangle::ComputeNormal(basePoint1,basePoint2,basePoint3,baseNormal);
-    vtkTriangle::ComputeNormal(warpedPoint1,warpedPoint2,warpedPoint3,warpedNormal);
-    double prod = vtkMath::Dot(baseNormal,warpedNormal);
-    double baseArea = vtkTriangle::TriangleArea(basePoint1,basePoint2,basePoint3);
-    double warpedArea = vtkTriangle::TriangleArea(warpedPoint1,warpedPoint2,warpedPoint3);
-    double testArea = warpedArea / baseArea;    
-    if (prod < 0 || testArea <= 0.1 )
-      {
-      check = 1;
-      found = found + 1;
-      checkArray->SetValue(j,1); 
-      }
-    else
-      {
-      checkArray->SetValue(j,0);  
-      }
+  vtkIdType numberOfCells = input->GetNumberOfCells();
+
+  TangleFunctor functor(this,checkArray);
+  if (this->ParallelComputation)
+    {
+    vtkSMPTools::For(0,numberOfCells,functor);
     }
-  //std::cout << found <<" tangle triangles found"<<std::endl;
-  
-  pointList->Delete();
-  return check;
+  else
+    {
+    functor(0,numberOfCells);
+    }
+  functor.Reduce();
+  //std::cout << functor.NumberOfTangledCells <<" tangle triangles found"<<std::endl;
+
+  return functor.NumberOfTangledCells > 0 ? 1 : 0;
 }
 
 void vtkvmtkBoundaryLayerGenerator::LocalUntangle(vtkUnstructuredGrid* input, vtkUnsignedCharArray* checkArray, double alpha)
 {
-  vtkIdList* pointList=vtkIdList::New();
-  vtkIdList* pointList2=vtkIdList::New();
-  vtkIdList* cellList=vtkIdList::New();
-  
-  double warpVector1[3], warpVector2[3], warpVector3[3];
-  double w1s[3], w2s[3], w3s[3], n[3]; 
-  double point1[3], point2[3], point3[3];
-  double c1[3], c2[3],  c3[3];
-
-  vtkDoubleArray* correctionArray = vtkDoubleArray::New();
-  correctionArray->SetName("correctionVectors");
-  correctionArray->SetNumberOfComponents(3);
-  correctionArray->SetNumberOfTuples(input->GetNumberOfPoints());
-  correctionArray->FillComponent(0,0.0);
-  correctionArray->FillComponent(1,0.0);
-  correctionArray->FillComponent(2,0.0);
-  input->GetPointData()->AddArray(correctionArray);   
-  
-  for (vtkIdType j=0; j<input->GetNumberOfCells(); j++)
+  vtkIdType numberOfPoints = input->GetNumberOfPoints();
+
+  std::vector<double> tangentDirections(3*numberOfPoints,0.0);
+
+  UntangleFunctor tangentsFunctor(this,checkArray,tangentDirections,alpha,false);
+  UntangleFunctor correctionsFunctor(this,checkArray,tangentDirections,alpha,true);
+  if (this->ParallelComputation)
     {
-    if (checkArray->GetValue(j)==1)
-      {
-      input->GetCellPoints(j,pointList);
-      this->WarpVectorsArray->GetTuple(pointList->GetId(0),warpVector1);
-      this->WarpVectorsArray->GetTuple(pointList->GetId(1),warpVector2);
-      this->WarpVectorsArray->GetTuple(pointList->GetId(2),warpVector3);
-      //eventually we can do it iteratively (relaxation >1)
-      double relaxation = 1.0;
-      for (int r=0; r<relaxation; r++)
-        {
-        w1s[0] = w1s[1] = w1s[2] = 0.0;
-        w2s[0] = w2s[1] = w2s[2] = 0.0;
-        w3s[0] = w3s[1] = w3s[2] = 0.0;
-        n[0] = n[1] = n[2] = 0.0;
-        input->GetPointCells(pointList->GetId(0),cellList);
-        for (int i=0; i<cellList->GetNumberOfIds();i++)
-          {
-          input->GetCellPoints(i,pointList2);
-          input->GetPoint(pointList2->GetId(0),point1);
-          input->GetPoint(pointList2->GetId(1),point2);
-          input->GetPoint(pointList2->GetId(2),point3);
-          vtkTriangle::ComputeNormal(point1,point2,point3,n);         
-          w1s[0] += warpVector1[0] - vtkMath::Dot(warpVector1,n) * n[0];
-          w1s[1] += warpVector1[1] - vtkMath::Dot(warpVector1,n) * n[1];
-          w1s[2] += warpVector1[2] - vtkMath::Dot(warpVector1,n) * n[2];
-          }
-        vtkMath::Normalize(w1s);
-        input->GetPointCells(pointList->GetId(1),cellList);
-        for (int i=0; i<cellList->GetNumberOfIds();i++)
-          {                       
-          input->GetCellPoints(i,pointList2);
-          input->GetPoint(pointList2->GetId(0),point1);
-          input->GetPoint(pointList2->GetId(1),point2);
-          input->GetPoint(pointList2->GetId(2),point3);
-          vtkTriangle::ComputeNormal(point1,point2,point3,n); 
-          w2s[0] += warpVector2[0] - vtkMath::Dot(warpVector2,n) * n[0];
-          w2s[1] += warpVector2[1] - vtkMath::Dot(warpVector2,n) * n[1];
-          w2s[2] += warpVector2[2] - vtkMath::Dot(warpVector2,n) * n[2];
-          }
-        vtkMath::Normalize(w2s);
-        input->GetPointCells(pointList->GetId(2),cellList);
-        for (int i=0; i<cellList->GetNumberOfIds();i++)
-          {                       
-          input->GetCellPoints(i,pointList2);
-          input->GetPoint(pointList2->GetId(0),point1);
-          input->GetPoint(pointList2->GetId(1),point2);
-          input->GetPoint(pointList2->GetId(2),point3);
-          vtkTriangle::ComputeNormal(point1,point2,point3,n);
-          w3s[0] += warpVector3[0] - vtkMath::Dot(warpVector3,n) * n[0];
-          w3s[1] += warpVector3[1] - vtkMath::Dot(warpVector3,n) * n[1];
-          w3s[2] += warpVector3[2] - vtkMath::Dot(warpVector3,n) * n[2]; 
-          }
-        vtkMath::Normalize(w3s);
-        correctionArray->GetTuple(pointList->GetId(0),c1);
-        correctionArray->GetTuple(pointList->GetId(1),c2);
-        correctionArray->GetTuple(pointList->GetId(2),c3);
-        c1[0] = c1[0] + alpha * w2s[0] + alpha * w3s[0];
-        c1[1] = c1[1] + alpha * w2s[1] + alpha * w3s[1];
-        c1[2] = c1[2] + alpha * w2s[2] + alpha * w3s[2];
-        c2[0] = c2[0] + alpha * w1s[0] + alpha * w3s[0];
-        c2[1] = c2[1] + alpha * w1s[1] + alpha * w3s[1];
-        c2[2] = c2[2] + alpha * w1s[2] + alpha * w3s[2];
-        c3[0] = c3[0] + alpha * w2s[0] + alpha * w1s[0];
-        c3[1] = c3[1] + alpha * w2s[1] + alpha * w1s[1];
-        c3[2] = c3[2] + alpha * w2s[2] + alpha * w1s[2];
-        correctionArray->SetTuple3(pointList->GetId(0),c1[0],c1[1],c1[2]);
-        correctionArray->SetTuple3(pointList->GetId(1),c2[0],c2[1],c2[2]);
-        correctionArray->SetTuple3(pointList->GetId(2),c3[0],c3[1],c3[2]);                
-        }
-      }         
+    vtkSMPTools::For(0,numberOfPoints,tangentsFunctor);
+    vtkSMPTools::For(0,numberOfPoints,correctionsFunctor);
     }
-
-  double warp[3], correction[3];  
-  for (vtkIdType i=0; i<input->GetNumberOfPoints();i++)
+  else
     {
-    this->WarpVectorsArray->GetTuple(i,warp);
-    double layerThickness=vtkMath::Norm(warp);
-    correctionArray->GetTuple(i,correction);
-    warp[0] = warp[0] + correction[0];
-    warp[1] = warp[1] + correction[1];
-    warp[2] = warp[2] + correction[2];       
-    vtkMath::Normalize(warp);
-    warp[0] = warp[0] * layerThickness;
-    warp[1] = warp[1] * layerThickness;
-    warp[2] = warp[2] * layerThickness;
-    this->WarpVectorsArray->SetTuple(i,warp); 
+    tangentsFunctor(0,numberOfPoints);
+    correctionsFunctor(0,numberOfPoints);
     }
-  
-  correctionArray->Delete();
-  pointList->Delete();
-  pointList2->Delete();
-  cellList->Delete();  
 }
 
 void vtkvmtkBoundaryLayerGenerator::WarpPoints(vtkPoints* inputPoints, vtkPoints* warpedPoints, int subLayerId, bool quadratic)
 {
-  double point[3], warpedPoint[3], warpVector[3];
-  double layerThickness, subLayerThicknessRatio, subLayerThickness;
-  double totalLayerZeroSubLayerRatio, subLayerOffsetRatio, subLayerOffset;
+  double subLayerThicknessRatio;
+  double totalLayerZeroSubLayerRatio, subLayerOffsetRatio;
 
   vtkIdType numberOfInputPoints = inputPoints->GetNumberOfPoints();
 
@@ -807,142 +1203,34 @@ void vtkvmtkBoundaryLayerGenerator::WarpPoints(vtkPoints* inputPoints, vtkPoints
     warpedPoints->SetNumberOfPoints(2*numberOfInputPoints);
     }
 
-  for (i=0; i<numberOfInputPoints; i++)
+  WarpPointsFunctor functor(this->WarpVectorsArray,inputPoints,warpedPoints,subLayerOffsetRatio,subLayerThicknessRatio,quadratic);
+  if (this->ParallelComputation)
     {
-    inputPoints->GetPoint(i,point);
-    this->WarpVectorsArray->GetTuple(i,warpVector);
-
-    layerThickness = vtkMath::Norm(warpVector);
-
-    vtkMath::Normalize(warpVector);
-
-    subLayerOffset = subLayerOffsetRatio * layerThickness;
-    subLayerThickness = subLayerThicknessRatio * layerThickness;
-
-    if (quadratic)
-      {
-      warpedPoint[0] = point[0] + 0.5 * warpVector[0] * (subLayerOffset + subLayerThickness);
-      warpedPoint[1] = point[1] + 0.5 * warpVector[1] * (subLayerOffset + subLayerThickness);
-      warpedPoint[2] = point[2] + 0.5 * warpVector[2] * (subLayerOffset + subLayerThickness);
-      warpedPoints->SetPoint(i,warpedPoint);
-      warpedPoint[0] = point[0] + warpVector[0] * (subLayerOffset + subLayerThickness);
-      warpedPoint[1] = point[1] + warpVector[1] * (subLayerOffset + subLayerThickness);
-      warpedPoint[2] = point[2] + warpVector[2] * (subLayerOffset + subLayerThickness);
-      warpedPoints->SetPoint(i+numberOfInputPoints,warpedPoint);
-      }
-    else
-      {
-      warpedPoint[0] = point[0] + warpVector[0] * (subLayerOffset + subLayerThickness);
-      warpedPoint[1] = point[1] + warpVector[1] * (subLayerOffset + subLayerThickness);
-      warpedPoint[2] = point[2] + warpVector[2] * (subLayerOffset + subLayerThickness);
-      warpedPoints->SetPoint(i,warpedPoint);
-      }
+    vtkSMPTools::For(0,numberOfInputPoints,functor);
+    }
+  else
+    {
+    functor(0,numberOfInputPoints);
     }
 }
 
-void vtkvmtkBoundaryLayerGenerator::IncrementalWarpPoints(vtkUnstructuredGrid* input, vtkPoints* basePoints, vtkPoints* warpedPoints, int substep, int numberOfSubsteps, double relaxation)
+void vtkvmtkBoundaryLayerGenerator::IncrementalWarpPoints(const std::vector<double>& steps, const std::vector<double>& basePoints, std::vector<double>& warpedPoints, double relaxation)
 {
-  double point[3], warpedPoint[3], warpVector[3];
-  double layerThickness;
+  vtkIdType numberOfInputPoints = static_cast<vtkIdType>(basePoints.size() / 3);
 
-  vtkIdType numberOfInputPoints = basePoints->GetNumberOfPoints();
+  // TODO: find out if the current surface is intersecting the original 
+  // input surface (not the input surface at this iteration) and in that 
+  // case (before it gets too close) stop the warp
 
-  warpedPoints->SetNumberOfPoints(numberOfInputPoints);
-
-  for (vtkIdType i=0; i<numberOfInputPoints; i++)
+  IncrementalWarpFunctor functor(this,steps,basePoints,warpedPoints,relaxation);
+  if (this->ParallelComputation)
     {
-    basePoints->GetPoint(i,point);
-    this->WarpVectorsArray->GetTuple(i,warpVector);
-    
-    layerThickness = vtkMath::Norm(warpVector); 
-    vtkMath::Normalize(warpVector);
-    
-    layerThickness /= numberOfSubsteps;
-
-    warpedPoint[0] = point[0] + warpVector[0] * layerThickness;
-    warpedPoint[1] = point[1] + warpVector[1] * layerThickness;
-    warpedPoint[2] = point[2] + warpVector[2] * layerThickness;
-    warpedPoints->SetPoint(i,warpedPoint);
+    vtkSMPTools::For(0,numberOfInputPoints,functor);
     }
-
-  vtkIdType npts;
-  const vtkIdType *pts;
-  vtkIdList* cellIds = vtkIdList::New();
-  vtkIdType cellId;
-
-  vtkIdList* neighborIds = vtkIdList::New();
-  vtkIdList* edgePointIds = vtkIdList::New();
-  vtkIdList* edgeNeighborCellIds = vtkIdList::New();
-
-  for (vtkIdType j=0; j<numberOfInputPoints; j++)
+  else
     {
-    input->GetPointCells(j,cellIds);
-
-    neighborIds->Initialize();
-
-    vtkIdType numberOfNeighborCells = cellIds->GetNumberOfIds();
-    for (int k=0; k<numberOfNeighborCells; k++)
-      {
-      cellId = cellIds->GetId(k);
-      input->GetCellPoints(cellId,npts,pts);
-
-      neighborIds->InsertUniqueId(pts[0]);
-      neighborIds->InsertUniqueId(pts[1]);
-      neighborIds->InsertUniqueId(pts[2]);
-      }
-    neighborIds->DeleteId(j);
-
-    int numberOfNeighbors = neighborIds->GetNumberOfIds();
-
-    bool onEdge = false;
-    edgePointIds->Initialize();
-    edgeNeighborCellIds->Initialize();
-    edgePointIds->InsertId(0,j);
-    for (int k=0; k<numberOfNeighbors; k++)
-      {
-      edgePointIds->InsertId(1,neighborIds->GetId(k));
-      input->GetCellNeighbors(-1,edgePointIds,edgeNeighborCellIds);
-      if (edgeNeighborCellIds->GetNumberOfIds() < 2)
-        {
-        onEdge = true;
-        break;
-        }
-      }
-
-    if (onEdge)
-      {
-      continue;
-      }
-
-    double barycenter[3];
-    barycenter[0] = barycenter[1] = barycenter[2] = 0.0;
-    double neighborPoint[3];
-    for (int k=0; k<numberOfNeighbors; k++)
-      {
-      warpedPoints->GetPoint(neighborIds->GetId(k),neighborPoint);
-      barycenter[0] += neighborPoint[0];
-      barycenter[1] += neighborPoint[1];
-      barycenter[2] += neighborPoint[2];
-      }
-    barycenter[0] /= numberOfNeighbors;
-    barycenter[1] /= numberOfNeighbors;
-    barycenter[2] /= numberOfNeighbors;
-
-    warpedPoints->GetPoint(j,warpedPoint);
-
-    // TODO: find out if the current surface is intersecting the original 
-    // input surface (not the input surface at this iteration) and in that 
-    // case (before it gets too close) stop the warp
-
-    warpedPoint[0] += relaxation * (barycenter[0] - warpedPoint[0]);
-    warpedPoint[1] += relaxation * (barycenter[1] - warpedPoint[1]);
-    warpedPoint[2] += relaxation * (barycenter[2] - warpedPoint[2]);
-
-    warpedPoints->SetPoint(j,warpedPoint);
+    functor(0,numberOfInputPoints);
     }
-
-  cellIds->Delete();
-  neighborIds->Delete();
 }
 
 void vtkvmtkBoundaryLayerGenerator::PrintSelf(std::ostream& os, vtkIndent indent)
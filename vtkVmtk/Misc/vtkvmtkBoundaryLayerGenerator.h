@@ -20,7 +20,17 @@ Version:   $Revision: 1.4 $
 =========================================================================*/
 // .NAME vtkvmtkBoundaryLayerGenerator - Generates boundary layers of prismatic elements by warping a surface mesh.
 // .SECTION Description
-// ...
+// vtkvmtkBoundaryLayerGenerator extrudes a surface mesh along its warp
+// vectors into NumberOfSubLayers layers of wedges (from triangles) or
+// hexahedra (from quads).
+//
+// The warp vectors are smoothed by incremental warps of the surface, and
+// the cells whose extruded triangle is flipped or collapsed are untangled
+// by bending the warp vectors of their points. The cells of each point,
+// the neighbors of each point and the base normals and areas of the cells
+// are computed once per execution, and with ParallelComputation on the
+// warps, the tangle checks and the untangling run concurrently over the
+// points or the cells.
 
 #ifndef __vtkvmtkBoundaryLayerGenerator_h
 #define __vtkvmtkBoundaryLayerGenerator_h
@@ -28,6 +38,8 @@ Version:   $Revision: 1.4 $
 #include "vtkUnstructuredGridAlgorithm.h"
 #include "vtkvmtkWin32Header.h"
 
+#include <vector>
+
 class vtkPoints;
 class vtkUnsignedCharArray;
 class vtkDataArray;
@@ -107,14 +119,29 @@ class VTK_VMTK_MISC_EXPORT vtkvmtkBoundaryLayerGenerator : public vtkUnstructure
 
   vtkGetObjectMacro(InnerSurface,vtkUnstructuredGrid);
 
+  vtkSetMacro(ParallelComputation,int);
+  vtkGetMacro(ParallelComputation,int);
+  vtkBooleanMacro(ParallelComputation,int);
+
   protected:
   vtkvmtkBoundaryLayerGenerator();
   ~vtkvmtkBoundaryLayerGenerator();
 
   virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
 
+//BTX
+  class CellGeometryFunctor;
+  class NeighborsFunctor;
+  class IncrementalWarpFunctor;
+  class WarpDirectionsFunctor;
+  class TangleFunctor;
+  class UntangleFunctor;
+//ETX
+
+  int BuildSurfaceTopology(vtkUnstructuredGrid* input);
+  void ReleaseSurfaceTopology();
   void BuildWarpVectors(vtkUnstructuredGrid* input);
-  void IncrementalWarpPoints(vtkUnstructuredGrid* input, vtkPoints* basePoints, vtkPoints* warpedPoints, int substep, int numberOfSubsteps, double relaxation);
+  void IncrementalWarpPoints(const std::vector<double>& steps, const std::vector<double>& basePoints, std::vector<double>& warpedPoints, double relaxation);
   void IncrementalWarpVectors(vtkUnstructuredGrid* input, int numberOfSubsteps, double relaxation);
   int CheckTangle(vtkUnstructuredGrid* input, vtkUnsignedCharArray* checkArray);
   void LocalUntangle(vtkUnstructuredGrid* input, vtkUnsignedCharArray* checkArray, double alpha); 
@@ -153,6 +180,26 @@ class VTK_VMTK_MISC_EXPORT vtkvmtkBoundaryLayerGenerator : public vtkUnstructure
   double Relaxation;
   double LocalCorrectionFactor;
 
+  int ParallelComputation;
+
+  // cell j has points CellPointIds[CellOffsets[j]] to
+  // CellPointIds[CellOffsets[j+1]-1], point i belongs to cells
+  // PointCellIds[PointCellOffsets[i]] to PointCellIds[PointCellOffsets[i+1]-1]
+  // and has neighbors NeighborIds[NeighborOffsets[i]] to
+  // NeighborIds[NeighborOffsets[i+1]-1]
+  std::vector<vtkIdType> CellOffsets;
+  std::vector<vtkIdType> CellPointIds;
+  std::vector<vtkIdType> PointCellOffsets;
+  std::vector<vtkIdType> PointCellIds;
+  std::vector<vtkIdType> NeighborOffsets;
+  std::vector<vtkIdType> NeighborIds;
+  // points which are not relaxed by the incremental warp
+  std::vector<char> FixedPoints;
+  // coordinates of the input points, normals and areas of the input cells
+  std::vector<double> BasePoints;
+  std::vector<double> CellNormals;
+  std::vector<double> CellAreas;
+
   private:
   vtkvmtkBoundaryLayerGenerator(const vtkvmtkBoundaryLayerGenerator&);  // Not implemented.
   void operator=(const vtkvmtkBoundaryLayerGenerator&);  // Not implemented.
@@ -27,19 +27,261 @@ Version:   $Revision: 1.6 $
 #include "vtkLinearSubdivisionFilter.h"
 #include "vtkButterflySubdivisionFilter.h"
 #include "vtkPolyData.h"
-#include "vtkCellLocator.h"
+#include "vtkStaticCellLocator.h"
 #include "vtkUnstructuredGrid.h"
 #include "vtkPointData.h"
 #include "vtkCellData.h"
 #include "vtkCellArray.h"
 #include "vtkGenericCell.h"
-#include "vtkEdgeTable.h"
 #include "vtkIdTypeArray.h"
 #include "vtkIntArray.h"
 #include "vtkMath.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocalObject.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+// Open addressing hash table from unordered pairs of ids to ids, with the
+// IsEdge/InsertEdge interface of vtkEdgeTable. Lookups touch one or two
+// contiguous entries instead of per point id lists, and are thread safe.
+class EdgeHashTable
+{
+public:
+  EdgeHashTable()
+  {
+    this->NumberOfEdges = 0;
+    this->Rehash(1024);
+  }
+
+  void Reserve(vtkIdType numberOfEdges)
+  {
+    size_t size = this->Entries.size();
+    while (size < 2*static_cast<size_t>(numberOfEdges))
+      {
+      size *= 2;
+      }
+    if (size > this->Entries.size())
+      {
+      this->Rehash(size);
+      }
+  }
+
+  vtkIdType IsEdge(vtkIdType p1, vtkIdType p2) const
+  {
+    if (p1 > p2)
+      {
+      std::swap(p1,p2);
+      }
+    size_t i = Hash(p1,p2) & this->Mask;
+    while (this->Entries[i].Id0 != -1)
+      {
+      if (this->Entries[i].Id0 == p1 && this->Entries[i].Id1 == p2)
+        {
+        return this->Entries[i].Attribute;
+        }
+      i = (i+1) & this->Mask;
+      }
+    return -1;
+  }
+
+  void InsertEdge(vtkIdType p1, vtkIdType p2, vtkIdType attribute)
+  {
+    if (2*static_cast<size_t>(this->NumberOfEdges+1) > this->Entries.size())
+      {
+      this->Rehash(2*this->Entries.size());
+      }
+    if (p1 > p2)
+      {
+      std::swap(p1,p2);
+      }
+    size_t i = Hash(p1,p2) & this->Mask;
+    while (this->Entries[i].Id0 != -1)
+      {
+      if (this->Entries[i].Id0 == p1 && this->Entries[i].Id1 == p2)
+        {
+        return;
+        }
+      i = (i+1) & this->Mask;
+      }
+    this->Entries[i].Id0 = p1;
+    this->Entries[i].Id1 = p2;
+    this->Entries[i].Attribute = attribute;
+    this->NumberOfEdges++;
+  }
+
+private:
+  struct Entry
+    {
+    vtkIdType Id0;
+    vtkIdType Id1;
+    vtkIdType Attribute;
+    };
+
+  static size_t Hash(vtkIdType p1, vtkIdType p2)
+  {
+    unsigned long long h = static_cast<unsigned long long>(p1) * 0x9e3779b97f4a7c15ULL;
+    h ^= static_cast<unsigned long long>(p2) * 0xc2b2ae3d27d4eb4fULL;
+    return static_cast<size_t>(h ^ (h >> 29));
+  }
+
+  void Rehash(size_t size)
+  {
+    std::vector<Entry> entries(size);
+    for (size_t k=0; k<size; k++)
+      {
+      entries[k].Id0 = -1;
+      }
+    this->Mask = size - 1;
+    for (size_t k=0; k<this->Entries.size(); k++)
+      {
+      const Entry& entry = this->Entries[k];
+      if (entry.Id0 == -1)
+        {
+        continue;
+        }
+      size_t i = Hash(entry.Id0,entry.Id1) & this->Mask;
+      while (entries[i].Id0 != -1)
+        {
+        i = (i+1) & this->Mask;
+        }
+      entries[i] = entry;
+      }
+    this->Entries.swap(entries);
+  }
+
+  std::vector<Entry> Entries;
+  size_t Mask;
+  vtkIdType NumberOfEdges;
+};
+
+// Projection of a list of points on the reference surface.
+class ProjectionFunctor
+{
+public:
+  ProjectionFunctor(vtkPoints* points, const vtkIdType* pointIds, vtkStaticCellLocator* locator)
+    : Points(points), PointIds(pointIds), Locator(locator) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkGenericCell* cell = this->Cells.Local();
+    double point[3], projectedPoint[3], dist2;
+    vtkIdType referenceCellId;
+    int subId;
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Points->GetPoint(this->PointIds[i],point);
+      this->Locator->FindClosestPoint(point,projectedPoint,cell,referenceCellId,subId,dist2);
+      this->Points->SetPoint(this->PointIds[i],projectedPoint);
+      }
+  }
+
+private:
+  vtkPoints* Points;
+  const vtkIdType* PointIds;
+  vtkStaticCellLocator* Locator;
+  mutable vtkSMPThreadLocalObject<vtkGenericCell> Cells;
+};
+
+// Flags the volume cells that have a pair of points in the table of
+// projected surface edges, the only cells whose shape the projection
+// changes. The pairs include the edges of the cells.
+class SurfaceEdgeCellsFunctor
+{
+public:
+  SurfaceEdgeCellsFunctor(vtkUnstructuredGrid* input, vtkIdList* inputToOutputCellIds, const EdgeHashTable& surfaceEdgeTable, char* surfaceEdgeCells)
+    : Input(input), InputToOutputCellIds(inputToOutputCellIds), SurfaceEdgeTable(surfaceEdgeTable), SurfaceEdgeCells(surfaceEdgeCells) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkIdList* cellPointIds = this->CellPointIds.Local();
+    for (vtkIdType cellId=begin; cellId<end; cellId++)
+      {
+      this->SurfaceEdgeCells[cellId] = 0;
+      int cellType = this->Input->GetCellType(cellId);
+      if ((cellType != VTK_TETRA && cellType != VTK_WEDGE && cellType != VTK_HEXAHEDRON) || this->InputToOutputCellIds->GetId(cellId) == -1)
+        {
+        continue;
+        }
+      this->Input->GetCellPoints(cellId,cellPointIds);
+      vtkIdType numberOfCellPoints = cellPointIds->GetNumberOfIds();
+      for (vtkIdType i=0; i<numberOfCellPoints && !this->SurfaceEdgeCells[cellId]; i++)
+        {
+        for (vtkIdType j=i+1; j<numberOfCellPoints; j++)
+          {
+          if (this->SurfaceEdgeTable.IsEdge(cellPointIds->GetId(i),cellPointIds->GetId(j)) != -1)
+            {
+            this->SurfaceEdgeCells[cellId] = 1;
+            break;
+            }
+          }
+        }
+      }
+  }
+
+private:
+  vtkUnstructuredGrid* Input;
+  vtkIdList* InputToOutputCellIds;
+  const EdgeHashTable& SurfaceEdgeTable;
+  char* SurfaceEdgeCells;
+  mutable vtkSMPThreadLocalObject<vtkIdList> CellPointIds;
+};
+
+}
+
+// Flags the cells whose Jacobian changes sign between the linear input
+// cell and the quadratic output cell. CellIds lists the input cells to
+// check; if it is NULL all the cells are checked. Cells which are not
+// volume cells converted by the filter are not flagged.
+class vtkvmtkLinearToQuadraticMeshFilter::JacobianFunctor
+{
+public:
+  JacobianFunctor(vtkvmtkLinearToQuadraticMeshFilter* filter, vtkUnstructuredGrid* input, vtkUnstructuredGrid* output, vtkIdList* inputToOutputCellIds, const vtkIdType* cellIds, char* signChanged)
+    : Filter(filter), Input(input), Output(output), InputToOutputCellIds(inputToOutputCellIds), CellIds(cellIds), SignChanged(signChanged) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkGenericCell* linearVolumeCell = this->LinearCells.Local();
+    vtkGenericCell* quadraticVolumeCell = this->QuadraticCells.Local();
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->SignChanged[i] = 0;
+      vtkIdType cellId = this->CellIds ? this->CellIds[i] : i;
+      int cellType = this->Input->GetCellType(cellId);
+      if (cellType != VTK_TETRA && cellType != VTK_WEDGE && cellType != VTK_HEXAHEDRON)
+        {
+        continue;
+        }
+      vtkIdType outputCellId = this->InputToOutputCellIds->GetId(cellId);
+      if (outputCellId == -1)
+        {
+        continue;
+        }
+      this->Input->GetCell(cellId,linearVolumeCell);
+      this->Output->GetCell(outputCellId,quadraticVolumeCell);
+      if (this->Filter->HasJacobianChangedSign(linearVolumeCell,quadraticVolumeCell))
+        {
+        this->SignChanged[i] = 1;
+        }
+      }
+  }
+
+private:
+  vtkvmtkLinearToQuadraticMeshFilter* Filter;
+  vtkUnstructuredGrid* Input;
+  vtkUnstructuredGrid* Output;
+  vtkIdList* InputToOutputCellIds;
+  const vtkIdType* CellIds;
+  char* SignChanged;
+  mutable vtkSMPThreadLocalObject<vtkGenericCell> LinearCells;
+  mutable vtkSMPThreadLocalObject<vtkGenericCell> QuadraticCells;
+};
 
 
 vtkStandardNewMacro(vtkvmtkLinearToQuadraticMeshFilter);
@@ -55,6 +297,7 @@ vtkvmtkLinearToQuadraticMeshFilter::vtkvmtkLinearToQuadraticMeshFilter()
   this->NegativeJacobianTolerance = 0.0;
   this->JacobianRelaxation = 1;
   this->TestFinalJacobians = 0;
+  this->ParallelComputation = 1;
 }
 
 vtkvmtkLinearToQuadraticMeshFilter::~vtkvmtkLinearToQuadraticMeshFilter()
@@ -70,6 +313,8 @@ vtkvmtkLinearToQuadraticMeshFilter::~vtkvmtkLinearToQuadraticMeshFilter()
     delete[] this->CellEntityIdsArrayName;
     this->CellEntityIdsArrayName = NULL;
     }
+
+  this->ReleaseJacobianQuadratures();
 }
 
 int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
@@ -83,6 +328,8 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
   vtkUnstructuredGrid *input = vtkUnstructuredGrid::SafeDownCast(inInfo->Get(vtkDataObject::DATA_OBJECT()));
   vtkUnstructuredGrid *output = vtkUnstructuredGrid::SafeDownCast(outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
+  this->ReleaseJacobianQuadratures();
+
   vtkIntArray* cellEntityIdsArray = vtkIntArray::New();
   if (this->ReferenceSurface)
     {
@@ -101,11 +348,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
 
   int numberOfInputPoints = input->GetNumberOfPoints();
 
-  vtkEdgeTable* edgeTable = vtkEdgeTable::New();
-  edgeTable->InitEdgeInsertion(numberOfInputPoints,1);
+  EdgeHashTable edgeTable;
+  edgeTable.Reserve(numberOfInputPoints);
 
-  vtkEdgeTable* faceTable = vtkEdgeTable::New();
-  faceTable->InitEdgeInsertion(numberOfInputPoints,1);
+  EdgeHashTable faceTable;
 
   vtkPointData* inputPointData = input->GetPointData();
   vtkPointData* outputPointData = output->GetPointData();
@@ -156,7 +402,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
 
   int numberOfCells = input->GetNumberOfCells();
   vtkIdList* inputToOutputCellIds = vtkIdList::New();
-  inputToOutputCellIds->SetNumberOfIds(numberOfInputCells);
+  inputToOutputCellIds->SetNumberOfIds(numberOfCells);
 
   for (i=0; i<numberOfCells; i++)
     {
@@ -205,7 +451,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
     pointId4 = cell->PointIds->GetId(4);
     pointId5 = cell->PointIds->GetId(5);
 
-    edgePointId01 = edgeTable->IsEdge(pointId0,pointId1);
+    edgePointId01 = edgeTable.IsEdge(pointId0,pointId1);
     if (edgePointId01 == -1)
       {
       for (j=0; j<3; j++)
@@ -214,10 +460,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId01 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId01,pointId0,pointId1,0.5);
-      edgeTable->InsertEdge(pointId0,pointId1,edgePointId01);
+      edgeTable.InsertEdge(pointId0,pointId1,edgePointId01);
       }
 
-    edgePointId02 = edgeTable->IsEdge(pointId0,pointId2);
+    edgePointId02 = edgeTable.IsEdge(pointId0,pointId2);
     if (edgePointId02 == -1)
       {
       for (j=0; j<3; j++)
@@ -226,10 +472,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId02 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId02,pointId0,pointId2,0.5);
-      edgeTable->InsertEdge(pointId0,pointId2,edgePointId02);
+      edgeTable.InsertEdge(pointId0,pointId2,edgePointId02);
       }
 
-    edgePointId12 = edgeTable->IsEdge(pointId1,pointId2);
+    edgePointId12 = edgeTable.IsEdge(pointId1,pointId2);
     if (edgePointId12 == -1)
       {
       for (j=0; j<3; j++)
@@ -238,10 +484,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId12 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId12,pointId1,pointId2,0.5);
-      edgeTable->InsertEdge(pointId1,pointId2,edgePointId12);
+      edgeTable.InsertEdge(pointId1,pointId2,edgePointId12);
       }
 
-    edgePointId34 = edgeTable->IsEdge(pointId3,pointId4);
+    edgePointId34 = edgeTable.IsEdge(pointId3,pointId4);
     if (edgePointId34 == -1)
       {
       for (j=0; j<3; j++)
@@ -250,10 +496,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId34 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId34,pointId3,pointId4,0.5);
-      edgeTable->InsertEdge(pointId3,pointId4,edgePointId34);
+      edgeTable.InsertEdge(pointId3,pointId4,edgePointId34);
       }
 
-    edgePointId35 = edgeTable->IsEdge(pointId3,pointId5);
+    edgePointId35 = edgeTable.IsEdge(pointId3,pointId5);
     if (edgePointId35 == -1)
       {
       for (j=0; j<3; j++)
@@ -262,10 +508,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId35 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId35,pointId3,pointId5,0.5);
-      edgeTable->InsertEdge(pointId3,pointId5,edgePointId35);
+      edgeTable.InsertEdge(pointId3,pointId5,edgePointId35);
       }
 
-    edgePointId45 = edgeTable->IsEdge(pointId4,pointId5);
+    edgePointId45 = edgeTable.IsEdge(pointId4,pointId5);
     if (edgePointId45 == -1)
       {
       for (j=0; j<3; j++)
@@ -274,10 +520,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId45 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId45,pointId4,pointId5,0.5);
-      edgeTable->InsertEdge(pointId4,pointId5,edgePointId45);
+      edgeTable.InsertEdge(pointId4,pointId5,edgePointId45);
       }
 
-    edgePointId03 = edgeTable->IsEdge(pointId0,pointId3);
+    edgePointId03 = edgeTable.IsEdge(pointId0,pointId3);
     if (edgePointId03 == -1)
       {
       for (j=0; j<3; j++)
@@ -286,10 +532,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId03 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId03,pointId0,pointId3,0.5);
-      edgeTable->InsertEdge(pointId0,pointId3,edgePointId03);
+      edgeTable.InsertEdge(pointId0,pointId3,edgePointId03);
       }
 
-    edgePointId14 = edgeTable->IsEdge(pointId1,pointId4);
+    edgePointId14 = edgeTable.IsEdge(pointId1,pointId4);
     if (edgePointId14 == -1)
       {
       for (j=0; j<3; j++)
@@ -298,10 +544,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId14 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId14,pointId1,pointId4,0.5);
-      edgeTable->InsertEdge(pointId1,pointId4,edgePointId14);
+      edgeTable.InsertEdge(pointId1,pointId4,edgePointId14);
       }
 
-    edgePointId25 = edgeTable->IsEdge(pointId2,pointId5);
+    edgePointId25 = edgeTable.IsEdge(pointId2,pointId5);
     if (edgePointId25 == -1)
       {
       for (j=0; j<3; j++)
@@ -310,7 +556,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId25 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId25,pointId2,pointId5,0.5);
-      edgeTable->InsertEdge(pointId2,pointId5,edgePointId25);
+      edgeTable.InsertEdge(pointId2,pointId5,edgePointId25);
       }
 
     if (this->UseBiquadraticWedge)
@@ -332,7 +578,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       if (neighborCellId != -1)
         {
-        facePointId0143 = faceTable->IsEdge(cellId,neighborCellId);
+        facePointId0143 = faceTable.IsEdge(cellId,neighborCellId);
         if (facePointId0143 == -1)
           {
           for (j=0; j<3; j++)
@@ -341,7 +587,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
             }
           facePointId0143 = outputPoints->InsertNextPoint(point);
           outputPointData->InterpolatePoint(inputPointData,facePointId0143,facePointIds,weights);
-          faceTable->InsertEdge(cellId,neighborCellId,facePointId0143);
+          faceTable.InsertEdge(cellId,neighborCellId,facePointId0143);
           }
         }
   
@@ -362,7 +608,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       if (neighborCellId != -1)
         {
-        facePointId1254 = faceTable->IsEdge(cellId,neighborCellId);
+        facePointId1254 = faceTable.IsEdge(cellId,neighborCellId);
         if (facePointId1254 == -1)
           {
           for (j=0; j<3; j++)
@@ -371,7 +617,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
             }
           facePointId1254 = outputPoints->InsertNextPoint(point);
           outputPointData->InterpolatePoint(inputPointData,facePointId1254,facePointIds,weights);
-          faceTable->InsertEdge(cellId,neighborCellId,facePointId1254);
+          faceTable.InsertEdge(cellId,neighborCellId,facePointId1254);
           }
         }
   
@@ -392,7 +638,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       if (neighborCellId != -1)
         {
-        facePointId2035 = faceTable->IsEdge(cellId,neighborCellId);
+        facePointId2035 = faceTable.IsEdge(cellId,neighborCellId);
         if (facePointId2035 == -1)
           {
           for (j=0; j<3; j++)
@@ -401,7 +647,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
             }
           facePointId2035 = outputPoints->InsertNextPoint(point);
           outputPointData->InterpolatePoint(inputPointData,facePointId2035,facePointIds,weights);
-          faceTable->InsertEdge(cellId,neighborCellId,facePointId2035);
+          faceTable.InsertEdge(cellId,neighborCellId,facePointId2035);
           }
         }
       }
@@ -456,7 +702,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
     pointId2 = cell->PointIds->GetId(2);
     pointId3 = cell->PointIds->GetId(3);
 
-    edgePointId01 = edgeTable->IsEdge(pointId0,pointId1);
+    edgePointId01 = edgeTable.IsEdge(pointId0,pointId1);
     if (edgePointId01 == -1)
       {
       for (j=0; j<3; j++)
@@ -465,10 +711,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId01 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId01,pointId0,pointId1,0.5);
-      edgeTable->InsertEdge(pointId0,pointId1,edgePointId01);
+      edgeTable.InsertEdge(pointId0,pointId1,edgePointId01);
       }
 
-    edgePointId02 = edgeTable->IsEdge(pointId0,pointId2);
+    edgePointId02 = edgeTable.IsEdge(pointId0,pointId2);
     if (edgePointId02 == -1)
       {
       for (j=0; j<3; j++)
@@ -477,10 +723,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId02 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId02,pointId0,pointId2,0.5);
-      edgeTable->InsertEdge(pointId0,pointId2,edgePointId02);
+      edgeTable.InsertEdge(pointId0,pointId2,edgePointId02);
       }
 
-    edgePointId03 = edgeTable->IsEdge(pointId0,pointId3);
+    edgePointId03 = edgeTable.IsEdge(pointId0,pointId3);
     if (edgePointId03 == -1)
       {
       for (j=0; j<3; j++)
@@ -489,10 +735,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId03 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId03,pointId0,pointId3,0.5);
-      edgeTable->InsertEdge(pointId0,pointId3,edgePointId03);
+      edgeTable.InsertEdge(pointId0,pointId3,edgePointId03);
       }
 
-    edgePointId12 = edgeTable->IsEdge(pointId1,pointId2);
+    edgePointId12 = edgeTable.IsEdge(pointId1,pointId2);
     if (edgePointId12 == -1)
       {
       for (j=0; j<3; j++)
@@ -501,10 +747,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId12 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId12,pointId1,pointId2,0.5);
-      edgeTable->InsertEdge(pointId1,pointId2,edgePointId12);
+      edgeTable.InsertEdge(pointId1,pointId2,edgePointId12);
       }
 
-    edgePointId13 = edgeTable->IsEdge(pointId1,pointId3);
+    edgePointId13 = edgeTable.IsEdge(pointId1,pointId3);
     if (edgePointId13 == -1)
       {
       for (j=0; j<3; j++)
@@ -513,10 +759,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId13 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId13,pointId1,pointId3,0.5);
-      edgeTable->InsertEdge(pointId1,pointId3,edgePointId13);
+      edgeTable.InsertEdge(pointId1,pointId3,edgePointId13);
       }
 
-    edgePointId23 = edgeTable->IsEdge(pointId2,pointId3);
+    edgePointId23 = edgeTable.IsEdge(pointId2,pointId3);
     if (edgePointId23 == -1)
       {
       for (j=0; j<3; j++)
@@ -525,7 +771,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId23 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId23,pointId2,pointId3,0.5);
-      edgeTable->InsertEdge(pointId2,pointId3,edgePointId23);
+      edgeTable.InsertEdge(pointId2,pointId3,edgePointId23);
       }
 
     pts[0] = pointId0;
@@ -568,7 +814,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
     pointId6 = cell->PointIds->GetId(6);
     pointId7 = cell->PointIds->GetId(7);
 
-    edgePointId01 = edgeTable->IsEdge(pointId0,pointId1);
+    edgePointId01 = edgeTable.IsEdge(pointId0,pointId1);
     if (edgePointId01 == -1)
       {
       for (j=0; j<3; j++)
@@ -577,10 +823,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId01 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId01,pointId0,pointId1,0.5);
-      edgeTable->InsertEdge(pointId0,pointId1,edgePointId01);
+      edgeTable.InsertEdge(pointId0,pointId1,edgePointId01);
       }
 
-    edgePointId12 = edgeTable->IsEdge(pointId1,pointId2);
+    edgePointId12 = edgeTable.IsEdge(pointId1,pointId2);
     if (edgePointId12 == -1)
       {
       for (j=0; j<3; j++)
@@ -589,10 +835,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId12 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId12,pointId1,pointId2,0.5);
-      edgeTable->InsertEdge(pointId1,pointId2,edgePointId12);
+      edgeTable.InsertEdge(pointId1,pointId2,edgePointId12);
       }
 
-    edgePointId23 = edgeTable->IsEdge(pointId2,pointId3);
+    edgePointId23 = edgeTable.IsEdge(pointId2,pointId3);
     if (edgePointId23 == -1)
       {
       for (j=0; j<3; j++)
@@ -601,10 +847,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId23 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId23,pointId2,pointId3,0.5);
-      edgeTable->InsertEdge(pointId2,pointId3,edgePointId23);
+      edgeTable.InsertEdge(pointId2,pointId3,edgePointId23);
       }
 
-    edgePointId03 = edgeTable->IsEdge(pointId0,pointId3);
+    edgePointId03 = edgeTable.IsEdge(pointId0,pointId3);
     if (edgePointId03 == -1)
       {
       for (j=0; j<3; j++)
@@ -613,10 +859,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId03 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId03,pointId0,pointId3,0.5);
-      edgeTable->InsertEdge(pointId0,pointId3,edgePointId03);
+      edgeTable.InsertEdge(pointId0,pointId3,edgePointId03);
       }
 
-    edgePointId04 = edgeTable->IsEdge(pointId0,pointId4);
+    edgePointId04 = edgeTable.IsEdge(pointId0,pointId4);
     if (edgePointId04 == -1)
       {
       for (j=0; j<3; j++)
@@ -625,10 +871,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId04 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId04,pointId0,pointId4,0.5);
-      edgeTable->InsertEdge(pointId0,pointId4,edgePointId04);
+      edgeTable.InsertEdge(pointId0,pointId4,edgePointId04);
       }
 
-    edgePointId15 = edgeTable->IsEdge(pointId1,pointId5);
+    edgePointId15 = edgeTable.IsEdge(pointId1,pointId5);
     if (edgePointId15 == -1)
       {
       for (j=0; j<3; j++)
@@ -637,10 +883,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId15 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId15,pointId1,pointId5,0.5);
-      edgeTable->InsertEdge(pointId1,pointId5,edgePointId15);
+      edgeTable.InsertEdge(pointId1,pointId5,edgePointId15);
       }
 
-    edgePointId26 = edgeTable->IsEdge(pointId2,pointId6);
+    edgePointId26 = edgeTable.IsEdge(pointId2,pointId6);
     if (edgePointId26 == -1)
       {
       for (j=0; j<3; j++)
@@ -649,10 +895,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId26 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId26,pointId2,pointId6,0.5);
-      edgeTable->InsertEdge(pointId2,pointId6,edgePointId26);
+      edgeTable.InsertEdge(pointId2,pointId6,edgePointId26);
       }
 
-    edgePointId37 = edgeTable->IsEdge(pointId3,pointId7);
+    edgePointId37 = edgeTable.IsEdge(pointId3,pointId7);
     if (edgePointId37 == -1)
       {
       for (j=0; j<3; j++)
@@ -661,10 +907,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId37 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId37,pointId3,pointId7,0.5);
-      edgeTable->InsertEdge(pointId3,pointId7,edgePointId37);
+      edgeTable.InsertEdge(pointId3,pointId7,edgePointId37);
       }
 
-    edgePointId45 = edgeTable->IsEdge(pointId4,pointId5);
+    edgePointId45 = edgeTable.IsEdge(pointId4,pointId5);
     if (edgePointId45 == -1)
       {
       for (j=0; j<3; j++)
@@ -673,10 +919,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId45 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId45,pointId4,pointId5,0.5);
-      edgeTable->InsertEdge(pointId4,pointId5,edgePointId45);
+      edgeTable.InsertEdge(pointId4,pointId5,edgePointId45);
       }
 
-    edgePointId56 = edgeTable->IsEdge(pointId5,pointId6);
+    edgePointId56 = edgeTable.IsEdge(pointId5,pointId6);
     if (edgePointId56 == -1)
       {
       for (j=0; j<3; j++)
@@ -685,10 +931,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId56 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId56,pointId5,pointId6,0.5);
-      edgeTable->InsertEdge(pointId5,pointId6,edgePointId56);
+      edgeTable.InsertEdge(pointId5,pointId6,edgePointId56);
       }
 
-    edgePointId67 = edgeTable->IsEdge(pointId6,pointId7);
+    edgePointId67 = edgeTable.IsEdge(pointId6,pointId7);
     if (edgePointId67 == -1)
       {
       for (j=0; j<3; j++)
@@ -697,10 +943,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId67 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId67,pointId6,pointId7,0.5);
-      edgeTable->InsertEdge(pointId6,pointId7,edgePointId67);
+      edgeTable.InsertEdge(pointId6,pointId7,edgePointId67);
       }
 
-    edgePointId74 = edgeTable->IsEdge(pointId4,pointId7);
+    edgePointId74 = edgeTable.IsEdge(pointId4,pointId7);
     if (edgePointId74 == -1)
       {
       for (j=0; j<3; j++)
@@ -709,7 +955,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId74 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId74,pointId4,pointId7,0.5);
-      edgeTable->InsertEdge(pointId4,pointId7,edgePointId74);
+      edgeTable.InsertEdge(pointId4,pointId7,edgePointId74);
       }
 
     if (this->NumberOfNodesHexahedra > 20)
@@ -743,7 +989,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       if (neighborCellId != -1)
         {
-        facePointId0154 = faceTable->IsEdge(cellId,neighborCellId);
+        facePointId0154 = faceTable.IsEdge(cellId,neighborCellId);
         if (facePointId0154 == -1)
           {
           for (j=0; j<3; j++)
@@ -752,7 +998,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
             }
           facePointId0154 = outputPoints->InsertNextPoint(point);
           outputPointData->InterpolatePoint(inputPointData,facePointId0154,facePointIds,weights);
-          faceTable->InsertEdge(cellId,neighborCellId,facePointId0154);
+          faceTable.InsertEdge(cellId,neighborCellId,facePointId0154);
           }
         }
 
@@ -784,7 +1030,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       if (neighborCellId != -1)
         {
-        facePointId1265 = faceTable->IsEdge(cellId,neighborCellId);
+        facePointId1265 = faceTable.IsEdge(cellId,neighborCellId);
         if (facePointId1265 == -1)
           {
           for (j=0; j<3; j++)
@@ -793,7 +1039,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
             }
           facePointId1265 = outputPoints->InsertNextPoint(point);
           outputPointData->InterpolatePoint(inputPointData,facePointId1265,facePointIds,weights);
-          faceTable->InsertEdge(cellId,neighborCellId,facePointId1265);
+          faceTable.InsertEdge(cellId,neighborCellId,facePointId1265);
           }
         }
 
@@ -825,7 +1071,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       if (neighborCellId != -1)
         {
-        facePointId2376 = faceTable->IsEdge(cellId,neighborCellId);
+        facePointId2376 = faceTable.IsEdge(cellId,neighborCellId);
         if (facePointId2376 == -1)
           {
           for (j=0; j<3; j++)
@@ -834,7 +1080,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
             }
           facePointId2376 = outputPoints->InsertNextPoint(point);
           outputPointData->InterpolatePoint(inputPointData,facePointId2376,facePointIds,weights);
-          faceTable->InsertEdge(cellId,neighborCellId,facePointId2376);
+          faceTable.InsertEdge(cellId,neighborCellId,facePointId2376);
           }
         }
 
@@ -866,7 +1112,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       if (neighborCellId != -1)
         {
-        facePointId3047 = faceTable->IsEdge(cellId,neighborCellId);
+        facePointId3047 = faceTable.IsEdge(cellId,neighborCellId);
         if (facePointId3047 == -1)
           {
           for (j=0; j<3; j++)
@@ -875,7 +1121,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
             }
           facePointId3047 = outputPoints->InsertNextPoint(point);
           outputPointData->InterpolatePoint(inputPointData,facePointId3047,facePointIds,weights);
-          faceTable->InsertEdge(cellId,neighborCellId,facePointId3047);
+          faceTable.InsertEdge(cellId,neighborCellId,facePointId3047);
           }
         }
 
@@ -910,7 +1156,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
           }
         if (neighborCellId != -1)
           {
-          facePointId0123 = faceTable->IsEdge(cellId,neighborCellId);
+          facePointId0123 = faceTable.IsEdge(cellId,neighborCellId);
           if (facePointId0123 == -1)
             {
             for (j=0; j<3; j++)
@@ -919,7 +1165,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
               }
             facePointId0123 = outputPoints->InsertNextPoint(point);
             outputPointData->InterpolatePoint(inputPointData,facePointId0123,facePointIds,weights);
-            faceTable->InsertEdge(cellId,neighborCellId,facePointId0123);
+            faceTable.InsertEdge(cellId,neighborCellId,facePointId0123);
             }
           }
 
@@ -951,7 +1197,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
           }
         if (neighborCellId != -1)
           {
-          facePointId4567 = faceTable->IsEdge(cellId,neighborCellId);
+          facePointId4567 = faceTable.IsEdge(cellId,neighborCellId);
           if (facePointId4567 == -1)
             {
             for (j=0; j<3; j++)
@@ -960,7 +1206,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
               }
             facePointId4567 = outputPoints->InsertNextPoint(point);
             outputPointData->InterpolatePoint(inputPointData,facePointId4567,facePointIds,weights);
-            faceTable->InsertEdge(cellId,neighborCellId,facePointId4567);
+            faceTable.InsertEdge(cellId,neighborCellId,facePointId4567);
             }
           }
 
@@ -1048,23 +1294,22 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
     outputCellData->CopyData(inputCellData,cellId,newCellId);
     }
 
-  vtkCellLocator* locator = NULL;
+  vtkStaticCellLocator* locator = NULL;
   if (this->ReferenceSurface)
     {
-    locator = vtkCellLocator::New();
+    locator = vtkStaticCellLocator::New();
     locator->SetDataSet(this->ReferenceSurface);
     locator->BuildLocator();
+    // cells must be built before querying them from several threads
+    this->ReferenceSurface->BuildCells();
     }
 
-  double projectedPoint[3];
-  vtkIdType referenceCellId;
-  int subId;
-  double dist2;
+  // mid nodes of the surface cells to be projected on the reference
+  // surface, projected all at once after the surface cells are created
+  std::vector<vtkIdType> projectedPointIds;
 
-  vtkEdgeTable* surfaceEdgeTable = vtkEdgeTable::New();
-  vtkEdgeTable* surfaceFaceTable = vtkEdgeTable::New();
-  surfaceEdgeTable->InitEdgeInsertion(numberOfInputPoints,1);
-  surfaceFaceTable->InitEdgeInsertion(numberOfInputPoints,1);
+  EdgeHashTable surfaceEdgeTable;
+  EdgeHashTable surfaceFaceTable;
 
   for (i=0; i<numberOfInputTriangles; i++)
     {
@@ -1091,7 +1336,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
     pointId1 = cell->PointIds->GetId(1);
     pointId2 = cell->PointIds->GetId(2);
 
-    edgePointId01 = edgeTable->IsEdge(pointId0,pointId1);
+    edgePointId01 = edgeTable.IsEdge(pointId0,pointId1);
     if (edgePointId01 == -1)
       {
       for (j=0; j<3; j++)
@@ -1100,10 +1345,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId01 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId01,pointId0,pointId1,0.5);
-      edgeTable->InsertEdge(pointId0,pointId1,edgePointId01);
+      edgeTable.InsertEdge(pointId0,pointId1,edgePointId01);
       }
 
-    edgePointId02 = edgeTable->IsEdge(pointId0,pointId2);
+    edgePointId02 = edgeTable.IsEdge(pointId0,pointId2);
     if (edgePointId02 == -1)
       {
       for (j=0; j<3; j++)
@@ -1112,10 +1357,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId02 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId02,pointId0,pointId2,0.5);
-      edgeTable->InsertEdge(pointId0,pointId2,edgePointId02);
+      edgeTable.InsertEdge(pointId0,pointId2,edgePointId02);
       }
 
-    edgePointId12 = edgeTable->IsEdge(pointId1,pointId2);
+    edgePointId12 = edgeTable.IsEdge(pointId1,pointId2);
     if (edgePointId12 == -1)
       {
       for (j=0; j<3; j++)
@@ -1124,14 +1369,14 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId12 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId12,pointId1,pointId2,0.5);
-      edgeTable->InsertEdge(pointId1,pointId2,edgePointId12);
+      edgeTable.InsertEdge(pointId1,pointId2,edgePointId12);
       }
 
     if (project)
       {
-      surfaceEdgeTable->InsertEdge(pointId0,pointId1,edgePointId01);
-      surfaceEdgeTable->InsertEdge(pointId0,pointId2,edgePointId02);
-      surfaceEdgeTable->InsertEdge(pointId1,pointId2,edgePointId12);
+      surfaceEdgeTable.InsertEdge(pointId0,pointId1,edgePointId01);
+      surfaceEdgeTable.InsertEdge(pointId0,pointId2,edgePointId02);
+      surfaceEdgeTable.InsertEdge(pointId1,pointId2,edgePointId12);
       }
 
     pts[0] = pointId0;
@@ -1148,16 +1393,9 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
 
     if (locator && project)
       {
-      double point01[3], point12[3], point02[3];
-      outputPoints->GetPoint(edgePointId01,point01);
-      locator->FindClosestPoint(point01,projectedPoint,referenceCellId,subId,dist2);
-      outputPoints->SetPoint(edgePointId01,projectedPoint);
-      outputPoints->GetPoint(edgePointId12,point12);
-      locator->FindClosestPoint(point12,projectedPoint,referenceCellId,subId,dist2);
-      outputPoints->SetPoint(edgePointId12,projectedPoint);
-      outputPoints->GetPoint(edgePointId02,point02);
-      locator->FindClosestPoint(point02,projectedPoint,referenceCellId,subId,dist2);
-      outputPoints->SetPoint(edgePointId02,projectedPoint);
+      projectedPointIds.push_back(edgePointId01);
+      projectedPointIds.push_back(edgePointId12);
+      projectedPointIds.push_back(edgePointId02);
       }
     }
 
@@ -1188,7 +1426,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
     pointId2 = cell->PointIds->GetId(2);
     pointId3 = cell->PointIds->GetId(3);
 
-    edgePointId01 = edgeTable->IsEdge(pointId0,pointId1);
+    edgePointId01 = edgeTable.IsEdge(pointId0,pointId1);
     if (edgePointId01 == -1)
       {
       for (j=0; j<3; j++)
@@ -1197,10 +1435,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId01 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId01,pointId0,pointId1,0.5);
-      edgeTable->InsertEdge(pointId0,pointId1,edgePointId01);
+      edgeTable.InsertEdge(pointId0,pointId1,edgePointId01);
       }
 
-    edgePointId12 = edgeTable->IsEdge(pointId1,pointId2);
+    edgePointId12 = edgeTable.IsEdge(pointId1,pointId2);
     if (edgePointId12 == -1)
       {
       for (j=0; j<3; j++)
@@ -1209,10 +1447,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId12 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId12,pointId1,pointId2,0.5);
-      edgeTable->InsertEdge(pointId1,pointId2,edgePointId12);
+      edgeTable.InsertEdge(pointId1,pointId2,edgePointId12);
       }
 
-    edgePointId23 = edgeTable->IsEdge(pointId2,pointId3);
+    edgePointId23 = edgeTable.IsEdge(pointId2,pointId3);
     if (edgePointId23 == -1)
       {
       for (j=0; j<3; j++)
@@ -1221,10 +1459,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId23 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId23,pointId2,pointId3,0.5);
-      edgeTable->InsertEdge(pointId2,pointId3,edgePointId23);
+      edgeTable.InsertEdge(pointId2,pointId3,edgePointId23);
       }
 
-    edgePointId03 = edgeTable->IsEdge(pointId0,pointId3);
+    edgePointId03 = edgeTable.IsEdge(pointId0,pointId3);
     if (edgePointId03 == -1)
       {
       for (j=0; j<3; j++)
@@ -1233,15 +1471,15 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         }
       edgePointId03 = outputPoints->InsertNextPoint(point);
       outputPointData->InterpolateEdge(inputPointData,edgePointId03,pointId0,pointId3,0.5);
-      edgeTable->InsertEdge(pointId0,pointId3,edgePointId03);
+      edgeTable.InsertEdge(pointId0,pointId3,edgePointId03);
       }
 
     if (project)
       {
-      surfaceEdgeTable->InsertEdge(pointId0,pointId1,edgePointId01);
-      surfaceEdgeTable->InsertEdge(pointId1,pointId2,edgePointId12);
-      surfaceEdgeTable->InsertEdge(pointId2,pointId3,edgePointId23);
-      surfaceEdgeTable->InsertEdge(pointId0,pointId3,edgePointId03);
+      surfaceEdgeTable.InsertEdge(pointId0,pointId1,edgePointId01);
+      surfaceEdgeTable.InsertEdge(pointId1,pointId2,edgePointId12);
+      surfaceEdgeTable.InsertEdge(pointId2,pointId3,edgePointId23);
+      surfaceEdgeTable.InsertEdge(pointId0,pointId3,edgePointId03);
       }
 
     pts[0] = pointId0;
@@ -1268,7 +1506,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
             input->GetCellType(cellNeighbors->GetId(j)) == VTK_HEXAHEDRON)
           {
           neighborCellId = cellNeighbors->GetId(j);
-          facePointId0123 = faceTable->IsEdge(cellId,neighborCellId);
+          facePointId0123 = faceTable.IsEdge(cellId,neighborCellId);
           break;
           }
         }
@@ -1277,7 +1515,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
         pts[8] = facePointId0123;
         if (project)
           {
-          surfaceFaceTable->InsertEdge(cellId,neighborCellId,facePointId0123);
+          surfaceFaceTable.InsertEdge(cellId,neighborCellId,facePointId0123);
           }
         }
       }
@@ -1308,28 +1546,34 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
 
     if (locator && project)
       {
-      double point01[3], point12[3], point23[3], point03[3], facePoint[3];
-      outputPoints->GetPoint(edgePointId01,point01);
-      locator->FindClosestPoint(point01,projectedPoint,referenceCellId,subId,dist2);
-      outputPoints->SetPoint(edgePointId01,projectedPoint);
-      outputPoints->GetPoint(edgePointId12,point12);
-      locator->FindClosestPoint(point12,projectedPoint,referenceCellId,subId,dist2);
-      outputPoints->SetPoint(edgePointId12,projectedPoint);
-      outputPoints->GetPoint(edgePointId23,point23);
-      locator->FindClosestPoint(point23,projectedPoint,referenceCellId,subId,dist2);
-      outputPoints->SetPoint(edgePointId23,projectedPoint);
-      outputPoints->GetPoint(edgePointId03,point03);
-      locator->FindClosestPoint(point03,projectedPoint,referenceCellId,subId,dist2);
-      outputPoints->SetPoint(edgePointId03,projectedPoint);
-      if (this->NumberOfNodesHexahedra > 20)
-        {
-        outputPoints->GetPoint(facePointId0123,facePoint);
-        locator->FindClosestPoint(facePoint,projectedPoint,referenceCellId,subId,dist2);
-        outputPoints->SetPoint(facePointId0123,projectedPoint);
+      projectedPointIds.push_back(edgePointId01);
+      projectedPointIds.push_back(edgePointId12);
+      projectedPointIds.push_back(edgePointId23);
+      projectedPointIds.push_back(edgePointId03);
+      if (this->NumberOfNodesHexahedra > 20 && facePointId0123 != -1)
+        {
+        projectedPointIds.push_back(facePointId0123);
         }
       }
     }
 
+  if (locator)
+    {
+    // mid nodes shared by several surface cells are projected once
+    std::sort(projectedPointIds.begin(),projectedPointIds.end());
+    projectedPointIds.erase(std::unique(projectedPointIds.begin(),projectedPointIds.end()),projectedPointIds.end());
+    vtkIdType numberOfProjectedPoints = static_cast<vtkIdType>(projectedPointIds.size());
+    ProjectionFunctor projectionFunctor(outputPoints,projectedPointIds.data(),locator);
+    if (this->ParallelComputation)
+      {
+      vtkSMPTools::For(0,numberOfProjectedPoints,projectionFunctor);
+      }
+    else
+      {
+      projectionFunctor(0,numberOfProjectedPoints);
+      }
+    }
+
 //#define LEGACY_RELAXATION
 #ifdef LEGACY_RELAXATION
   int numberOfRelaxationSteps = 10;
@@ -1357,9 +1601,9 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
       pointId1 = cell->PointIds->GetId(1);
       pointId2 = cell->PointIds->GetId(2);
   
-      edgePointId01 = edgeTable->IsEdge(pointId0,pointId1);
-      edgePointId12 = edgeTable->IsEdge(pointId1,pointId2);
-      edgePointId02 = edgeTable->IsEdge(pointId0,pointId2);
+      edgePointId01 = edgeTable.IsEdge(pointId0,pointId1);
+      edgePointId12 = edgeTable.IsEdge(pointId1,pointId2);
+      edgePointId02 = edgeTable.IsEdge(pointId0,pointId2);
    
       if (locator)
         {
@@ -1438,10 +1682,10 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
       pointId2 = cell->PointIds->GetId(2);
       pointId3 = cell->PointIds->GetId(3);
 
-      edgePointId01 = edgeTable->IsEdge(pointId0,pointId1);
-      edgePointId12 = edgeTable->IsEdge(pointId1,pointId2);
-      edgePointId23 = edgeTable->IsEdge(pointId2,pointId3);
-      edgePointId03 = edgeTable->IsEdge(pointId0,pointId3);
+      edgePointId01 = edgeTable.IsEdge(pointId0,pointId1);
+      edgePointId12 = edgeTable.IsEdge(pointId1,pointId2);
+      edgePointId23 = edgeTable.IsEdge(pointId2,pointId3);
+      edgePointId03 = edgeTable.IsEdge(pointId0,pointId3);
 
       if (locator)
         {
@@ -1517,6 +1761,38 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
     {
     anySignChange = false;
     }
+
+  // the cells with an edge on the projected surface are found once; at each
+  // sweep their Jacobians are checked concurrently, then the cells whose
+  // Jacobian changed sign are relaxed one at a time, since relaxing a cell
+  // moves nodes it shares with its neighbors
+  std::vector<vtkIdType> surfaceEdgeCellIds;
+  if (anySignChange)
+    {
+    std::vector<char> surfaceEdgeCells(numberOfCells);
+    SurfaceEdgeCellsFunctor surfaceEdgeCellsFunctor(input,inputToOutputCellIds,surfaceEdgeTable,surfaceEdgeCells.data());
+    if (this->ParallelComputation)
+      {
+      vtkSMPTools::For(0,numberOfCells,surfaceEdgeCellsFunctor);
+      }
+    else
+      {
+      surfaceEdgeCellsFunctor(0,numberOfCells);
+      }
+    for (i=0; i<numberOfCells; i++)
+      {
+      if (surfaceEdgeCells[i])
+        {
+        surfaceEdgeCellIds.push_back(i);
+        }
+      }
+    this->PrepareJacobianQuadratures(output);
+    }
+
+  vtkIdType numberOfSurfaceEdgeCells = static_cast<vtkIdType>(surfaceEdgeCellIds.size());
+  std::vector<char> signChanged(numberOfSurfaceEdgeCells);
+  JacobianFunctor jacobianFunctor(this,input,output,inputToOutputCellIds,surfaceEdgeCellIds.data(),signChanged.data());
+
   while (anySignChange)
     {
     if (signChangeCounter >= maxSignChangeIterations)
@@ -1526,71 +1802,61 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
     signChangeCounter++;
     anySignChange = false;
 
-    surfaceEdgeTable->InitTraversal();
-    vtkIdType edgePointId = surfaceEdgeTable->GetNextEdge(pointId0,pointId1);
-    vtkIdList* edgePointIds = vtkIdList::New();
-    vtkIdList* cellEdgeNeighbors = vtkIdList::New();
-    while (edgePointId >= 0)
-      {
-      edgePointIds->Initialize();
-      edgePointIds->InsertNextId(pointId0);
-      edgePointIds->InsertNextId(pointId1);
-      input->GetCellNeighbors(-1,edgePointIds,cellEdgeNeighbors);
-      int numberOfCellEdgeNeighbors = cellEdgeNeighbors->GetNumberOfIds();
-      for (i=0; i<numberOfCellEdgeNeighbors; i++)
-        {
-        vtkIdType volumeCellId = cellEdgeNeighbors->GetId(i);
-        if (input->GetCell(volumeCellId)->GetCellDimension() != 3)
-          {
-          continue;
-          }
-        vtkCell* linearVolumeCell = input->GetCell(volumeCellId);
-        vtkIdType outputCellId = inputToOutputCellIds->GetId(volumeCellId);
-        if (outputCellId == -1)
+    if (this->ParallelComputation)
+      {
+      vtkSMPTools::For(0,numberOfSurfaceEdgeCells,jacobianFunctor);
+      }
+    else
+      {
+      jacobianFunctor(0,numberOfSurfaceEdgeCells);
+      }
+
+    for (vtkIdType k=0; k<numberOfSurfaceEdgeCells; k++)
+      {
+      if (!signChanged[k])
+        {
+        continue;
+        }
+      vtkIdType volumeCellId = surfaceEdgeCellIds[k];
+      vtkCell* linearVolumeCell = input->GetCell(volumeCellId);
+      vtkIdType outputCellId = inputToOutputCellIds->GetId(volumeCellId);
+      vtkCell* quadraticVolumeCell = output->GetCell(outputCellId);
+
+      int s;
+      for (s=0; s<numberOfRelaxationSteps; s++)
+        {
+        if (!this->HasJacobianChangedSign(linearVolumeCell,quadraticVolumeCell))
           {
-          continue;
+          break;
           }
-        vtkCell* quadraticVolumeCell = output->GetCell(outputCellId);
-
-        int s;
-        for (s=0; s<numberOfRelaxationSteps; s++)
+        anySignChange = true;
+        vtkWarningMacro(<<"Warning: projection causes element "<<volumeCellId<<" to have a negative Jacobian somewhere. Relaxing projection for this element.");
+        double relaxation = (double)(s+1)/(double)numberOfRelaxationSteps;
+        int numberOfEdges = linearVolumeCell->GetNumberOfEdges();
+        int e;
+        for (e=0; e<numberOfEdges; e++)
           {
-          if (!this->HasJacobianChangedSign(linearVolumeCell,quadraticVolumeCell))
+          vtkCell* edge = linearVolumeCell->GetEdge(e);
+          vtkIdType pointId0 = edge->GetPointId(0);
+          vtkIdType pointId1 = edge->GetPointId(1);
+          vtkIdType edgePointId = surfaceEdgeTable.IsEdge(pointId0,pointId1);
+          if (edgePointId == -1)
             {
-            break;
+            continue;
             }
-          anySignChange = true;
-          vtkWarningMacro(<<"Warning: projection causes element "<<volumeCellId<<" to have a negative Jacobian somewhere. Relaxing projection for this element.");
-          double relaxation = (double)(s+1)/(double)numberOfRelaxationSteps;
-          int numberOfEdges = linearVolumeCell->GetNumberOfEdges();
-          int e;
-          for (e=0; e<numberOfEdges; e++)
+          double edgePoint[3], relaxedEdgePoint[3];
+          input->GetPoint(pointId0,point0);
+          input->GetPoint(pointId1,point1);
+          output->GetPoint(edgePointId,edgePoint);
+          for (j=0; j<3; j++)
             {
-            vtkCell* edge = linearVolumeCell->GetEdge(e);
-            vtkIdType pointId0 = edge->GetPointId(0);
-            vtkIdType pointId1 = edge->GetPointId(1);
-            vtkIdType edgePointId = surfaceEdgeTable->IsEdge(pointId0,pointId1);
-            if (edgePointId == -1)
-              {
-              continue;
-              }
-            double edgePoint[3], relaxedEdgePoint[3];
-            input->GetPoint(pointId0,point0);
-            input->GetPoint(pointId1,point1);
-            output->GetPoint(edgePointId,edgePoint);
-            for (j=0; j<3; j++)
-              {
-              relaxedEdgePoint[j] = (1.0 - relaxation) * edgePoint[j] + relaxation * (0.5 * (point0[j] + point1[j]));
-              }
-            outputPoints->SetPoint(edgePointId,relaxedEdgePoint);
+            relaxedEdgePoint[j] = (1.0 - relaxation) * edgePoint[j] + relaxation * (0.5 * (point0[j] + point1[j]));
             }
-          quadraticVolumeCell = output->GetCell(outputCellId);
+          outputPoints->SetPoint(edgePointId,relaxedEdgePoint);
           }
+        quadraticVolumeCell = output->GetCell(outputCellId);
         }
-      edgePointId = surfaceEdgeTable->GetNextEdge(pointId0,pointId1);
       }
-    edgePointIds->Delete();
-    cellEdgeNeighbors->Delete();
     }
 #endif
 
@@ -1639,7 +1905,7 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
               input->GetCellType(cellNeighbors->GetId(j)) == VTK_HEXAHEDRON)
             {
             neighborCellId = cellNeighbors->GetId(j);
-            facePointId0123 = faceTable->IsEdge(cellId,neighborCellId);
+            facePointId0123 = faceTable.IsEdge(cellId,neighborCellId);
             break;
             }
           }
@@ -1703,33 +1969,27 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
 
   if (this->TestFinalJacobians)
     {
+    this->PrepareJacobianQuadratures(output);
+    std::vector<char> finalSignChanged(numberOfCells);
+    JacobianFunctor finalJacobianFunctor(this,input,output,inputToOutputCellIds,NULL,finalSignChanged.data());
+    if (this->ParallelComputation)
+      {
+      vtkSMPTools::For(0,numberOfCells,finalJacobianFunctor);
+      }
+    else
+      {
+      finalJacobianFunctor(0,numberOfCells);
+      }
     for (i=0; i<numberOfCells; i++)
       {
-      vtkCell* linearVolumeCell = input->GetCell(i);
-      if (linearVolumeCell->GetCellDimension() != 3)
-        {
-        continue;
-        }
-      vtkIdType outputCellId = inputToOutputCellIds->GetId(i);
-      if (outputCellId == -1)
-        {
-        continue;
-        }
-      vtkCell* quadraticVolumeCell = output->GetCell(outputCellId);
-  
-      if (this->HasJacobianChangedSign(linearVolumeCell,quadraticVolumeCell))
+      if (finalSignChanged[i])
         {
-        vtkErrorMacro("Error: negative Jacobian detected in cell "<<outputCellId<<" even after relaxation. Output quadratic mesh will have negative Jacobians.");
+        vtkErrorMacro("Error: negative Jacobian detected in cell "<<inputToOutputCellIds->GetId(i)<<" even after relaxation. Output quadratic mesh will have negative Jacobians.");
         }
       }
     }
 
-  surfaceEdgeTable->Delete();
-  surfaceFaceTable->Delete();
-
   outputPoints->Delete();
-  edgeTable->Delete();
-  faceTable->Delete();
 
   triangleIds->Delete();
   tetraIds->Delete();
@@ -1749,6 +2009,8 @@ int vtkvmtkLinearToQuadraticMeshFilter::RequestData(
 
   inputToOutputCellIds->Delete();
 
+  this->ReleaseJacobianQuadratures();
+
   output->Squeeze();
 
   return 1;
@@ -1759,7 +2021,16 @@ double vtkvmtkLinearToQuadraticMeshFilter::ComputeJacobian(vtkCell* cell, double
   double jacobian = 0.0;
 
   int numberOfCellPoints = cell->GetNumberOfPoints();
-  double* derivs = new double[3*numberOfCellPoints];
+
+  // the cells handled by this filter have at most 27 points
+  double derivsBuffer[3*27];
+  std::vector<double> derivsVector;
+  double* derivs = derivsBuffer;
+  if (numberOfCellPoints > 27)
+    {
+    derivsVector.resize(3*numberOfCellPoints);
+    derivs = &derivsVector[0];
+    }
   
   vtkvmtkFEShapeFunctions::GetInterpolationDerivs(cell,pcoords,derivs);
   
@@ -1782,18 +2053,56 @@ double vtkvmtkLinearToQuadraticMeshFilter::ComputeJacobian(vtkCell* cell, double
       jacobianMatrix[2][i] += x[i] * derivs[2*numberOfCellPoints+j];
       }
     }
-  delete[] derivs;
 
   jacobian = vtkMath::Determinant3x3(jacobianMatrix);
 
   return jacobian;
 }
 
-bool vtkvmtkLinearToQuadraticMeshFilter::HasJacobianChangedSign(vtkCell* linearVolumeCell, vtkCell* quadraticVolumeCell)
+vtkvmtkGaussQuadrature* vtkvmtkLinearToQuadraticMeshFilter::GetJacobianQuadrature(int cellType)
 {
+  std::map<int,vtkvmtkGaussQuadrature*>::iterator it = this->JacobianQuadratures.find(cellType);
+  if (it != this->JacobianQuadratures.end())
+    {
+    return it->second;
+    }
   vtkvmtkGaussQuadrature* gaussQuadrature = vtkvmtkGaussQuadrature::New();
   gaussQuadrature->SetOrder(this->QuadratureOrder);
-  gaussQuadrature->Initialize(quadraticVolumeCell->GetCellType());
+  gaussQuadrature->Initialize(cellType);
+  this->JacobianQuadratures[cellType] = gaussQuadrature;
+  return gaussQuadrature;
+}
+
+void vtkvmtkLinearToQuadraticMeshFilter::PrepareJacobianQuadratures(vtkUnstructuredGrid* output)
+{
+  std::vector<char> cellTypes(256,0);
+  vtkIdType numberOfCells = output->GetNumberOfCells();
+  for (vtkIdType i=0; i<numberOfCells; i++)
+    {
+    cellTypes[output->GetCellType(i) & 0xff] = 1;
+    }
+  for (int cellType=0; cellType<256; cellType++)
+    {
+    if (cellTypes[cellType])
+      {
+      this->GetJacobianQuadrature(cellType);
+      }
+    }
+}
+
+void vtkvmtkLinearToQuadraticMeshFilter::ReleaseJacobianQuadratures()
+{
+  std::map<int,vtkvmtkGaussQuadrature*>::iterator it;
+  for (it=this->JacobianQuadratures.begin(); it!=this->JacobianQuadratures.end(); ++it)
+    {
+    it->second->Delete();
+    }
+  this->JacobianQuadratures.clear();
+}
+
+bool vtkvmtkLinearToQuadraticMeshFilter::HasJacobianChangedSign(vtkCell* linearVolumeCell, vtkCell* quadraticVolumeCell)
+{
+  vtkvmtkGaussQuadrature* gaussQuadrature = this->GetJacobianQuadrature(quadraticVolumeCell->GetCellType());
   bool signChanged = false;
   int numberOfQuadraturePoints = gaussQuadrature->GetNumberOfQuadraturePoints();
   double quadraturePCoords[3];
@@ -1809,7 +2118,6 @@ bool vtkvmtkLinearToQuadraticMeshFilter::HasJacobianChangedSign(vtkCell* linearV
       break;
       }
     }
-  gaussQuadrature->Delete();
   if (signChanged)
     {
     return signChanged;
@@ -1819,9 +2127,9 @@ bool vtkvmtkLinearToQuadraticMeshFilter::HasJacobianChangedSign(vtkCell* linearV
   int numberOfCellPoints = quadraticVolumeCell->GetNumberOfPoints();
   for (q=0; q<numberOfCellPoints; q++)
     {
-    quadraturePCoords[0] = parametricCoords[q*numberOfCellPoints + 0];
-    quadraturePCoords[1] = parametricCoords[q*numberOfCellPoints + 1];
-    quadraturePCoords[2] = parametricCoords[q*numberOfCellPoints + 2];
+    quadraturePCoords[0] = parametricCoords[3*q + 0];
+    quadraturePCoords[1] = parametricCoords[3*q + 1];
+    quadraturePCoords[2] = parametricCoords[3*q + 2];
     double linearJacobian = this->ComputeJacobian(linearVolumeCell,quadraturePCoords);
     double quadraticJacobian = this->ComputeJacobian(quadraticVolumeCell,quadraturePCoords);
     if (linearJacobian*quadraticJacobian < this->NegativeJacobianTolerance)
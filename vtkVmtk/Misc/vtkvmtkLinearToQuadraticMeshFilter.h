@@ -20,7 +20,11 @@ Version:   $Revision: 1.4 $
 =========================================================================*/
 // .NAME vtkvmtkLinearToQuadraticMeshFilter - Converts linear mesh elements to quadratic mesh elements (optionally) by executing by projecting mid side nodes onto the surface and relaxing projection if Jacobian is negative, otherwise does not project nodes.
 // .SECTION Description
-// ...
+// Mid edge and mid face nodes are shared through hash tables keyed on point
+// and cell id pairs. Mid nodes of the surface cells are projected on
+// ReferenceSurface, and the volume cells along the projected edges are
+// checked for Jacobian sign changes and relaxed. With ParallelComputation on,
+// the projection and the Jacobian checks run concurrently.
 
 #ifndef __vtkvmtkLinearToQuadraticMeshFilter_h
 #define __vtkvmtkLinearToQuadraticMeshFilter_h
@@ -30,6 +34,10 @@ Version:   $Revision: 1.4 $
 #include "vtkCell.h"
 #include "vtkvmtkWin32Header.h"
 
+#include <map>
+
+class vtkvmtkGaussQuadrature;
+
 class VTK_VMTK_MISC_EXPORT vtkvmtkLinearToQuadraticMeshFilter : public vtkUnstructuredGridAlgorithm
 {
   public: 
@@ -68,15 +76,30 @@ class VTK_VMTK_MISC_EXPORT vtkvmtkLinearToQuadraticMeshFilter : public vtkUnstru
   vtkGetMacro(TestFinalJacobians,int);
   vtkBooleanMacro(TestFinalJacobians,int);
 
+  vtkSetMacro(ParallelComputation,int);
+  vtkGetMacro(ParallelComputation,int);
+  vtkBooleanMacro(ParallelComputation,int);
+
   protected:
   vtkvmtkLinearToQuadraticMeshFilter();
   ~vtkvmtkLinearToQuadraticMeshFilter();
 
   virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
 
+//BTX
+  class JacobianFunctor;
+//ETX
+
+  // Description:
+  // HasJacobianChangedSign can be called concurrently once the quadratures
+  // of all the cell types involved have been created.
   bool HasJacobianChangedSign(vtkCell* linearVolumeCell, vtkCell* quadraticVolumeCell);
   double ComputeJacobian(vtkCell* cell, double pcoords[3]);
 
+  vtkvmtkGaussQuadrature* GetJacobianQuadrature(int cellType);
+  void PrepareJacobianQuadratures(vtkUnstructuredGrid* output);
+  void ReleaseJacobianQuadratures();
+
   int UseBiquadraticWedge;
 
   int NumberOfNodesHexahedra;
@@ -90,6 +113,10 @@ class VTK_VMTK_MISC_EXPORT vtkvmtkLinearToQuadraticMeshFilter : public vtkUnstru
 
   int JacobianRelaxation;
   int TestFinalJacobians;
+  int ParallelComputation;
+
+  // quadrature rules of the Jacobian checks, by cell type
+  std::map<int,vtkvmtkGaussQuadrature*> JacobianQuadratures;
 
   private:
   vtkvmtkLinearToQuadraticMeshFilter(const vtkvmtkLinearToQuadraticMeshFilter&);  // Not implemented.
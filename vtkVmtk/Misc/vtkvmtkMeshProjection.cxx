@@ -21,7 +21,7 @@ Version:   $Revision: 1.1 $
 
 #include "vtkvmtkMeshProjection.h"
 
-#include "vtkCellLocator.h"
+#include "vtkStaticCellLocator.h"
 #include "vtkDoubleArray.h"
 #include "vtkGenericCell.h"
 #include "vtkUnstructuredGrid.h"
@@ -30,6 +30,45 @@ Version:   $Revision: 1.1 $
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPThreadLocalObject.h"
+
+#include <vector>
+
+namespace
+{
+
+// Closest cell of each input point on the reference mesh. Only the queries
+// run in parallel; data is interpolated afterwards.
+class ClosestCellFunctor
+{
+public:
+  ClosestCellFunctor(vtkDataSet* input, vtkStaticCellLocator* locator, vtkIdType* cellIds, int* subIds, double* closestPoints)
+    : Input(input), Locator(locator), CellIds(cellIds), SubIds(subIds), ClosestPoints(closestPoints) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkGenericCell* cell = this->Cells.Local();
+    double point[3];
+    double distance2;
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Input->GetPoint(i,point);
+      this->Locator->FindClosestPoint(point,this->ClosestPoints+3*i,cell,this->CellIds[i],this->SubIds[i],distance2);
+      }
+  }
+
+private:
+  vtkDataSet* Input;
+  vtkStaticCellLocator* Locator;
+  vtkIdType* CellIds;
+  int* SubIds;
+  double* ClosestPoints;
+  mutable vtkSMPThreadLocalObject<vtkGenericCell> Cells;
+};
+
+}
 
 
 vtkStandardNewMacro(vtkvmtkMeshProjection);
@@ -38,6 +77,8 @@ vtkvmtkMeshProjection::vtkvmtkMeshProjection()
 {
   this->ReferenceMesh = NULL;
   this->Tolerance = 1E-6;
+  this->Locator = NULL;
+  this->ReuseLocator = 0;
 }
 
 vtkvmtkMeshProjection::~vtkvmtkMeshProjection()
@@ -47,6 +88,12 @@ vtkvmtkMeshProjection::~vtkvmtkMeshProjection()
     this->ReferenceMesh->Delete();
     this->ReferenceMesh = NULL;
     }
+
+  if (this->Locator)
+    {
+    this->Locator->Delete();
+    this->Locator = NULL;
+    }
 }
 
 int vtkvmtkMeshProjection::RequestData(
@@ -63,12 +110,9 @@ int vtkvmtkMeshProjection::RequestData(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
   vtkIdType i;
-  vtkIdType cellId;
   int subId;
-  double point[3], closestPoint[3];
   double pcoords[3];
   double distance2;
-  vtkCellLocator *locator;
   vtkGenericCell *genericCell;
 
   if (!this->ReferenceMesh)
@@ -86,28 +130,50 @@ int vtkvmtkMeshProjection::RequestData(
 
   outputPointData->InterpolateAllocate(referencePointData,numberOfPoints);
   
-  locator = vtkCellLocator::New();
-  genericCell = vtkGenericCell::New();
+  if (!this->ReuseLocator || !this->Locator || this->Locator->GetDataSet() != this->ReferenceMesh || this->ReferenceMesh->GetMTime() > this->LocatorBuildTime.GetMTime())
+    {
+    if (this->Locator)
+      {
+      this->Locator->Delete();
+      }
+    this->Locator = vtkStaticCellLocator::New();
+    this->Locator->SetDataSet(this->ReferenceMesh);
+    this->Locator->BuildLocator();
+    this->LocatorBuildTime.Modified();
+    }
+  this->Locator->SetTolerance(this->Tolerance);
+
+  std::vector<vtkIdType> cellIds(numberOfPoints);
+  std::vector<int> subIds(numberOfPoints);
+  std::vector<double> closestPoints(3*numberOfPoints);
+  if (numberOfPoints > 0)
+    {
+    ClosestCellFunctor functor(input,this->Locator,&cellIds[0],&subIds[0],&closestPoints[0]);
+    vtkSMPTools::For(0,numberOfPoints,functor);
+    }
 
-  locator->SetDataSet(this->ReferenceMesh);
-  locator->BuildLocator();
-  locator->SetTolerance(this->Tolerance);
+  genericCell = vtkGenericCell::New();
 
   for (i=0; i<numberOfPoints; i++)
     {
-    input->GetPoint(i,point);
-    locator->FindClosestPoint(point,closestPoint,genericCell,cellId,subId,distance2);
+    this->ReferenceMesh->GetCell(cellIds[i],genericCell);
+    subId = subIds[i];
     double* weights = new double[genericCell->GetNumberOfPoints()];
-    genericCell->EvaluatePosition(closestPoint,NULL,subId,pcoords,distance2,weights);
+    genericCell->EvaluatePosition(&closestPoints[3*i],NULL,subId,pcoords,distance2,weights);
 
     outputPointData->InterpolatePoint(referencePointData,i,genericCell->GetPointIds(),weights);
 
     delete[] weights;
     }
 
-  locator->Delete();
   genericCell->Delete();
 
+  if (!this->ReuseLocator)
+    {
+    this->Locator->Delete();
+    this->Locator = NULL;
+    }
+
   return 1;
 }
 
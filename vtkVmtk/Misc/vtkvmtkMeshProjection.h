@@ -29,6 +29,8 @@ Version:   $Revision: 1.1 $
 #include "vtkUnstructuredGrid.h"
 #include "vtkvmtkWin32Header.h"
 
+class vtkStaticCellLocator;
+
 class VTK_VMTK_MISC_EXPORT vtkvmtkMeshProjection : public vtkUnstructuredGridAlgorithm
 {
   public: 
@@ -43,6 +45,14 @@ class VTK_VMTK_MISC_EXPORT vtkvmtkMeshProjection : public vtkUnstructuredGridAlg
   vtkSetMacro(Tolerance,double);
   vtkGetMacro(Tolerance,double);
 
+  // Description:
+  // Keep the cell locator of the reference between executions and only
+  // rebuild it when the reference is replaced or modified. Useful when
+  // many inputs are compared against the same reference.
+  vtkSetMacro(ReuseLocator,int);
+  vtkGetMacro(ReuseLocator,int);
+  vtkBooleanMacro(ReuseLocator,int);
+
   protected:
   vtkvmtkMeshProjection();
   ~vtkvmtkMeshProjection();  
@@ -52,6 +62,10 @@ class VTK_VMTK_MISC_EXPORT vtkvmtkMeshProjection : public vtkUnstructuredGridAlg
   vtkUnstructuredGrid *ReferenceMesh;
   double Tolerance;
 
+  vtkStaticCellLocator *Locator;
+  vtkTimeStamp LocatorBuildTime;
+  int ReuseLocator;
+
   private:
   vtkvmtkMeshProjection(const vtkvmtkMeshProjection&);  // Not implemented.
   void operator=(const vtkvmtkMeshProjection&);  // Not implemented.
@@ -21,7 +21,7 @@ Version:   $Revision: 1.3 $
 
 #include "vtkvmtkSurfaceDistance.h"
 
-#include "vtkCellLocator.h"
+#include "vtkStaticCellLocator.h"
 #include "vtkDoubleArray.h"
 #include "vtkGenericCell.h"
 #include "vtkPolyData.h"
@@ -30,6 +30,86 @@ Version:   $Revision: 1.3 $
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPThreadLocalObject.h"
+
+#include <vector>
+
+namespace
+{
+
+// Closest point queries for a range of input points. Output arrays that
+// are not requested are NULL.
+class SurfaceDistanceFunctor
+{
+public:
+  SurfaceDistanceFunctor(vtkPolyData* input, vtkStaticCellLocator* locator, vtkDataArray* normals, double* distances, double* distanceVectors, double* signedDistances)
+    : Input(input), Locator(locator), Normals(normals), Distances(distances), DistanceVectors(distanceVectors), SignedDistances(signedDistances) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkGenericCell* cell = this->Cells.Local();
+    std::vector<double>& weights = this->Weights.Local();
+    double point[3], closestPoint[3], distanceVector[3];
+    double pcoords[3], normal[3], pointNormal[3];
+    double distance2, distance;
+    vtkIdType cellId;
+    int subId;
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Input->GetPoint(i,point);
+      this->Locator->FindClosestPoint(point,closestPoint,cell,cellId,subId,distance2);
+      distanceVector[0] = point[0] - closestPoint[0];
+      distanceVector[1] = point[1] - closestPoint[1];
+      distanceVector[2] = point[2] - closestPoint[2];
+      distance = sqrt(distance2);
+
+      if (this->Distances)
+        {
+        this->Distances[i] = distance;
+        }
+
+      if (this->DistanceVectors)
+        {
+        this->DistanceVectors[3*i+0] = -distanceVector[0];
+        this->DistanceVectors[3*i+1] = -distanceVector[1];
+        this->DistanceVectors[3*i+2] = -distanceVector[2];
+        }
+
+      if (this->SignedDistances)
+        {
+        vtkIdType numberOfCellPoints = cell->GetNumberOfPoints();
+        weights.resize(numberOfCellPoints);
+        cell->EvaluatePosition(point,NULL,subId,pcoords,distance2,&weights[0]);
+        pointNormal[0] = 0.0;
+        pointNormal[1] = 0.0;
+        pointNormal[2] = 0.0;
+        for (vtkIdType j=0; j<numberOfCellPoints; j++)
+          {
+          this->Normals->GetTuple(cell->GetPointId(j),normal);
+          pointNormal[0] += weights[j] * normal[0];
+          pointNormal[1] += weights[j] * normal[1];
+          pointNormal[2] += weights[j] * normal[2];
+          }
+        // distance is positive if distanceVector and normal have negative dot
+        this->SignedDistances[i] = vtkMath::Dot(distanceVector,pointNormal) > 0.0 ? -distance : distance;
+        }
+      }
+  }
+
+private:
+  vtkPolyData* Input;
+  vtkStaticCellLocator* Locator;
+  vtkDataArray* Normals;
+  double* Distances;
+  double* DistanceVectors;
+  double* SignedDistances;
+  mutable vtkSMPThreadLocalObject<vtkGenericCell> Cells;
+  mutable vtkSMPThreadLocal<std::vector<double> > Weights;
+};
+
+}
 
 
 vtkStandardNewMacro(vtkvmtkSurfaceDistance);
@@ -40,6 +120,8 @@ vtkvmtkSurfaceDistance::vtkvmtkSurfaceDistance()
   this->DistanceVectorsArrayName = NULL;
   this->SignedDistanceArrayName = NULL;
   this->ReferenceSurface = NULL;
+  this->Locator = NULL;
+  this->ReuseLocator = 0;
 }
 
 vtkvmtkSurfaceDistance::~vtkvmtkSurfaceDistance()
@@ -50,6 +132,12 @@ vtkvmtkSurfaceDistance::~vtkvmtkSurfaceDistance()
     this->ReferenceSurface = NULL;
     }
 
+  if (this->Locator)
+    {
+    this->Locator->Delete();
+    this->Locator = NULL;
+    }
+
   if (this->DistanceArrayName)
     {
     delete[] this->DistanceArrayName;
@@ -82,23 +170,10 @@ int vtkvmtkSurfaceDistance::RequestData(
   vtkPolyData *output = vtkPolyData::SafeDownCast(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
-  vtkIdType i, j;
-  vtkIdType numberOfPoints, numberOfCellPoints;
-  vtkIdType cellId, pointId;
-  int subId;
-  double point[3], closestPoint[3];
-  double distance2, distance, signedDistance;
-  double pcoords[3];
-  double pointNormal[3], *normal;
-  double distanceVector[3];
-  double *weights;
-  double dot;
+  vtkIdType numberOfPoints;
   bool computeDistance, computeDistanceVectors, computeSignedDistance;
   vtkDoubleArray *distanceArray, *distanceVectorsArray, *signedDistanceArray;
   vtkDataArray *normals;
-  vtkCellLocator *locator;
-  vtkGenericCell *genericCell;
-  vtkCell *cell;
 
   if (!this->ReferenceSurface)
     {
@@ -117,9 +192,6 @@ int vtkvmtkSurfaceDistance::RequestData(
   signedDistanceArray = vtkDoubleArray::New();
   normals = NULL;
 
-  locator = vtkCellLocator::New();
-  genericCell = vtkGenericCell::New();
-
   numberOfPoints = input->GetNumberOfPoints();
 
   computeDistance = false;
@@ -152,61 +224,37 @@ int vtkvmtkSurfaceDistance::RequestData(
     if (!normals)
       {
       vtkErrorMacro(<<"Signed distance requires point normals to be defined over ReferenceSurface!");
+      distanceArray->Delete();
+      distanceVectorsArray->Delete();
+      signedDistanceArray->Delete();
       return 1;
       }
     }
 
-  locator->SetDataSet(this->ReferenceSurface);
-  locator->BuildLocator();
-
-  for (i=0; i<numberOfPoints; i++)
+  if (!this->ReuseLocator || !this->Locator || this->Locator->GetDataSet() != this->ReferenceSurface || this->ReferenceSurface->GetMTime() > this->LocatorBuildTime.GetMTime())
     {
-    input->GetPoint(i,point);
-    locator->FindClosestPoint(point,closestPoint,genericCell,cellId,subId,distance2);
-    distanceVector[0] = point[0] - closestPoint[0];
-    distanceVector[1] = point[1] - closestPoint[1];
-    distanceVector[2] = point[2] - closestPoint[2];
-    distance = sqrt(distance2);
-    
-    if (computeDistance)
+    if (this->Locator)
       {
-      distanceArray->SetTuple1(i,distance);
-      }
-
-    if (computeDistanceVectors)
-      {
-      distanceVectorsArray->SetTuple3(i,-distanceVector[0],-distanceVector[1],-distanceVector[2]);
+      this->Locator->Delete();
       }
+    this->Locator = vtkStaticCellLocator::New();
+    this->Locator->SetDataSet(this->ReferenceSurface);
+    this->Locator->BuildLocator();
+    this->LocatorBuildTime.Modified();
+    }
 
-    if (computeSignedDistance)
-      {
-      cell = this->ReferenceSurface->GetCell(cellId);
-      numberOfCellPoints = cell->GetNumberOfPoints();
-      weights = new double[numberOfCellPoints];
-      cell->EvaluatePosition(point,NULL,subId,pcoords,distance2,weights);
-      pointNormal[0] = 0.0;
-      pointNormal[1] = 0.0;
-      pointNormal[2] = 0.0;
-      for (j=0; j<numberOfCellPoints; j++)
-        {
-        pointId = cell->GetPointId(j);
-        normal = normals->GetTuple3(pointId);
-        pointNormal[0] += weights[j] * normal[0];
-        pointNormal[1] += weights[j] * normal[1];
-        pointNormal[2] += weights[j] * normal[2];
-        }
-      dot = vtkMath::Dot(distanceVector,pointNormal);
-      signedDistance = distance;
-      // distance is positive if distanceVector and normal have negative dot
-      if (dot>0.0)
-        {
-        signedDistance *= -1.0;
-        }
-      signedDistanceArray->SetTuple1(i,signedDistance);
-      delete[] weights;
-      }
+  // cells must be built before querying them from several threads
+  if (this->ReferenceSurface->NeedToBuildCells())
+    {
+    this->ReferenceSurface->BuildCells();
     }
 
+  SurfaceDistanceFunctor functor(input,this->Locator,normals,
+    computeDistance ? distanceArray->GetPointer(0) : NULL,
+    computeDistanceVectors ? distanceVectorsArray->GetPointer(0) : NULL,
+    computeSignedDistance ? signedDistanceArray->GetPointer(0) : NULL);
+  vtkSMPTools::For(0,numberOfPoints,functor);
+
   output->DeepCopy(input);
 
   if (computeDistance)
@@ -227,8 +275,12 @@ int vtkvmtkSurfaceDistance::RequestData(
   distanceArray->Delete();
   distanceVectorsArray->Delete();
   signedDistanceArray->Delete();
-  locator->Delete();
-  genericCell->Delete();
+
+  if (!this->ReuseLocator)
+    {
+    this->Locator->Delete();
+    this->Locator = NULL;
+    }
 
   return 1;
 }
@@ -29,6 +29,8 @@ Version:   $Revision: 1.4 $
 #include "vtkPolyData.h"
 #include "vtkvmtkWin32Header.h"
 
+class vtkStaticCellLocator;
+
 class vtkPolyData;
 
 class VTK_VMTK_MISC_EXPORT vtkvmtkSurfaceDistance : public vtkPolyDataAlgorithm
@@ -59,6 +61,14 @@ class VTK_VMTK_MISC_EXPORT vtkvmtkSurfaceDistance : public vtkPolyDataAlgorithm
   vtkSetObjectMacro(ReferenceSurface,vtkPolyData);
   vtkGetObjectMacro(ReferenceSurface,vtkPolyData);
 
+  // Description:
+  // Keep the cell locator of the reference between executions and only
+  // rebuild it when the reference is replaced or modified. Useful when
+  // many inputs are compared against the same reference.
+  vtkSetMacro(ReuseLocator,int);
+  vtkGetMacro(ReuseLocator,int);
+  vtkBooleanMacro(ReuseLocator,int);
+
   protected:
   vtkvmtkSurfaceDistance();
   ~vtkvmtkSurfaceDistance();  
@@ -70,6 +80,10 @@ class VTK_VMTK_MISC_EXPORT vtkvmtkSurfaceDistance : public vtkPolyDataAlgorithm
   char *SignedDistanceArrayName;
   vtkPolyData *ReferenceSurface;
 
+  vtkStaticCellLocator *Locator;
+  vtkTimeStamp LocatorBuildTime;
+  int ReuseLocator;
+
   private:
   vtkvmtkSurfaceDistance(const vtkvmtkSurfaceDistance&);  // Not implemented.
   void operator=(const vtkvmtkSurfaceDistance&);  // Not implemented.
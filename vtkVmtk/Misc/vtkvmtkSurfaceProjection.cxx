@@ -21,7 +21,7 @@ Version:   $Revision: 1.4 $
 
 #include "vtkvmtkSurfaceProjection.h"
 
-#include "vtkCellLocator.h"
+#include "vtkStaticCellLocator.h"
 #include "vtkDoubleArray.h"
 #include "vtkGenericCell.h"
 #include "vtkPolyData.h"
@@ -30,6 +30,45 @@ Version:   $Revision: 1.4 $
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPThreadLocalObject.h"
+
+#include <vector>
+
+namespace
+{
+
+// Closest cell of each input point on the reference surface. Only the
+// queries run in parallel; data is interpolated afterwards.
+class ClosestCellFunctor
+{
+public:
+  ClosestCellFunctor(vtkDataSet* input, vtkStaticCellLocator* locator, vtkIdType* cellIds, int* subIds, double* closestPoints)
+    : Input(input), Locator(locator), CellIds(cellIds), SubIds(subIds), ClosestPoints(closestPoints) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    vtkGenericCell* cell = this->Cells.Local();
+    double point[3];
+    double distance2;
+    for (vtkIdType i=begin; i<end; i++)
+      {
+      this->Input->GetPoint(i,point);
+      this->Locator->FindClosestPoint(point,this->ClosestPoints+3*i,cell,this->CellIds[i],this->SubIds[i],distance2);
+      }
+  }
+
+private:
+  vtkDataSet* Input;
+  vtkStaticCellLocator* Locator;
+  vtkIdType* CellIds;
+  int* SubIds;
+  double* ClosestPoints;
+  mutable vtkSMPThreadLocalObject<vtkGenericCell> Cells;
+};
+
+}
 
 
 vtkStandardNewMacro(vtkvmtkSurfaceProjection);
@@ -37,6 +76,8 @@ vtkStandardNewMacro(vtkvmtkSurfaceProjection);
 vtkvmtkSurfaceProjection::vtkvmtkSurfaceProjection()
 {
   this->ReferenceSurface = NULL;
+  this->Locator = NULL;
+  this->ReuseLocator = 0;
 }
 
 vtkvmtkSurfaceProjection::~vtkvmtkSurfaceProjection()
@@ -46,6 +87,12 @@ vtkvmtkSurfaceProjection::~vtkvmtkSurfaceProjection()
     this->ReferenceSurface->Delete();
     this->ReferenceSurface = NULL;
     }
+
+  if (this->Locator)
+    {
+    this->Locator->Delete();
+    this->Locator = NULL;
+    }
 }
 
 int vtkvmtkSurfaceProjection::RequestData(
@@ -64,10 +111,9 @@ int vtkvmtkSurfaceProjection::RequestData(
   vtkIdType i;
   vtkIdType cellId;
   int subId;
-  double point[3], closestPoint[3];
+  double closestPoint[3];
   double pcoords[3];
   double distance2;
-  vtkCellLocator *locator;
   vtkGenericCell *genericCell;
 
   if (!this->ReferenceSurface)
@@ -87,16 +133,37 @@ int vtkvmtkSurfaceProjection::RequestData(
   
   this->ReferenceSurface->BuildCells();
 
-  locator = vtkCellLocator::New();
-  genericCell = vtkGenericCell::New();
+  if (!this->ReuseLocator || !this->Locator || this->Locator->GetDataSet() != this->ReferenceSurface || this->ReferenceSurface->GetMTime() > this->LocatorBuildTime.GetMTime())
+    {
+    if (this->Locator)
+      {
+      this->Locator->Delete();
+      }
+    this->Locator = vtkStaticCellLocator::New();
+    this->Locator->SetDataSet(this->ReferenceSurface);
+    this->Locator->BuildLocator();
+    this->LocatorBuildTime.Modified();
+    }
+
+  std::vector<vtkIdType> cellIds(numberOfPoints);
+  std::vector<int> subIds(numberOfPoints);
+  std::vector<double> closestPoints(3*numberOfPoints);
+  if (numberOfPoints > 0)
+    {
+    ClosestCellFunctor functor(input,this->Locator,&cellIds[0],&subIds[0],&closestPoints[0]);
+    vtkSMPTools::For(0,numberOfPoints,functor);
+    }
 
-  locator->SetDataSet(this->ReferenceSurface);
-  locator->BuildLocator();
+  genericCell = vtkGenericCell::New();
 
   for (i=0; i<numberOfPoints; i++)
     {
-    input->GetPoint(i,point);
-    locator->FindClosestPoint(point,closestPoint,genericCell,cellId,subId,distance2);
+    cellId = cellIds[i];
+    subId = subIds[i];
+    closestPoint[0] = closestPoints[3*i+0];
+    closestPoint[1] = closestPoints[3*i+1];
+    closestPoint[2] = closestPoints[3*i+2];
+    this->ReferenceSurface->GetCell(cellId,genericCell);
     if (this->ReferenceSurface->GetCellType(cellId) != VTK_POLY_LINE)
       {
       double* weights = new double[genericCell->GetNumberOfPoints()];
@@ -118,9 +185,14 @@ int vtkvmtkSurfaceProjection::RequestData(
       }
     }
 
-  locator->Delete();
   genericCell->Delete();
 
+  if (!this->ReuseLocator)
+    {
+    this->Locator->Delete();
+    this->Locator = NULL;
+    }
+
   return 1;
 }
 
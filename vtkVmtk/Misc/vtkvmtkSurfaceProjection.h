@@ -29,6 +29,8 @@ Version:   $Revision: 1.4 $
 #include "vtkPolyData.h"
 #include "vtkvmtkWin32Header.h"
 
+class vtkStaticCellLocator;
+
 class vtkPolyData;
 
 class VTK_VMTK_MISC_EXPORT vtkvmtkSurfaceProjection : public vtkPolyDataAlgorithm
@@ -44,6 +46,14 @@ class VTK_VMTK_MISC_EXPORT vtkvmtkSurfaceProjection : public vtkPolyDataAlgorith
   vtkSetObjectMacro(ReferenceSurface,vtkPolyData);
   vtkGetObjectMacro(ReferenceSurface,vtkPolyData);
 
+  // Description:
+  // Keep the cell locator of the reference between executions and only
+  // rebuild it when the reference is replaced or modified. Useful when
+  // many inputs are compared against the same reference.
+  vtkSetMacro(ReuseLocator,int);
+  vtkGetMacro(ReuseLocator,int);
+  vtkBooleanMacro(ReuseLocator,int);
+
   protected:
   vtkvmtkSurfaceProjection();
   ~vtkvmtkSurfaceProjection();  
@@ -52,6 +62,10 @@ class VTK_VMTK_MISC_EXPORT vtkvmtkSurfaceProjection : public vtkPolyDataAlgorith
 
   vtkPolyData *ReferenceSurface;
 
+  vtkStaticCellLocator *Locator;
+  vtkTimeStamp LocatorBuildTime;
+  int ReuseLocator;
+
   private:
   vtkvmtkSurfaceProjection(const vtkvmtkSurfaceProjection&);  // Not implemented.
   void operator=(const vtkvmtkSurfaceProjection&);  // Not implemented.
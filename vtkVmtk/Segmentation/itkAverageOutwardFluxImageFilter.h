@@ -40,10 +40,11 @@ Modification Authors:
 #include <time.h>
 
 #include <itkImage.h>
-#include <itkNeighborhoodIterator.h>
-#include <itkImageRegionIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
 
 #include <itkImageToImageFilter.h>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 using namespace std;
@@ -55,6 +56,11 @@ namespace itk
 /// represented as a distance transform. This class implements the centerline extraction 
 ///	algorithm described in : "S. Bouix, K. Siddiqi, and A. Tannenbaum. Flux driven automatic centerline extraction. Technical Report
 ///	SOCS-04.2, School of Ccomputer Science, McGill University, 2004."
+///
+/// The flux is only computed inside the object (distance <= 0), which is the only region the
+/// medial curve filter reads; it is zero elsewhere. The output region is split among threads and
+/// the 3^N-1 neighbors are read from the gradient buffer through precomputed offsets, clamped at
+/// the image boundary.
 
 /// TODO:
 /// 1. manual instantation
@@ -89,9 +95,11 @@ class ITK_EXPORT AverageOutwardFluxImageFilter:
 		typedef typename TInputVectorImage::ConstPointer InputVectorConstPointerType;
 		typedef typename TOutputImage::Pointer OutputPointerType;
 
-		typedef itk::ImageRegionConstIterator< TInputImage > InputConstIteratorType;
-		typedef itk::ConstNeighborhoodIterator< TInputVectorImage > InputVectorConstNeighborhoodIteratorType;
-		typedef itk::ImageRegionIterator< TOutputImage > OutputIteratorType;
+		typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+
+		typedef itk::ImageRegionIteratorWithIndex< TOutputImage > OutputIteratorType;
+
+		itkStaticConstMacro(ImageDimension, unsigned int, TInputImage::ImageDimension);
 
 // #ifdef ITK_USE_CONCEPT_CHECKING
 // 		/** Begin concept checking */
@@ -121,9 +129,6 @@ class ITK_EXPORT AverageOutwardFluxImageFilter:
 		{
 			return ( static_cast< TInputVectorImage *>(this->ProcessObject::GetInput(1)) );
 		}
-		
-		/// \brief Compute the gradient.
-		void GenerateData() ITK_OVERRIDE;
 
 		void PrintSelf(std::ostream& os, Indent indent) const ITK_OVERRIDE;
 
@@ -135,6 +140,19 @@ class ITK_EXPORT AverageOutwardFluxImageFilter:
 		/// \brief Destructor
 		virtual ~AverageOutwardFluxImageFilter();
 
+		/// \brief The whole distance and gradient images are needed.
+		void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+		/// \brief Precomputes the neighbor offsets and normals.
+		void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+		/// \brief Compute the average outward flux of the object voxels in a region.
+#if ITK_VERSION_MAJOR >= 5
+		void DynamicThreadedGenerateData( const OutputImageRegionType& outputRegionForThread ) ITK_OVERRIDE;
+#else
+		void ThreadedGenerateData( const OutputImageRegionType& outputRegionForThread, ThreadIdType threadId ) ITK_OVERRIDE;
+#endif
+
 
 		//-----------------------------------------------------
 		// Variables
@@ -144,6 +162,10 @@ class ITK_EXPORT AverageOutwardFluxImageFilter:
 		InputVectorConstPointerType gradient;
 		OutputPointerType aof;
 
+		std::vector< typename TInputImage::OffsetType > neighbors; // Offsets of the 3^N-1 neighbors.
+		std::vector< OffsetValueType > bufferOffsets;             // Their buffer offsets.
+		std::vector< double > normals;                           // Their unit normals, N per neighbor.
+
 	private:
 
 		AverageOutwardFluxImageFilter( const AverageOutwardFluxImageFilter& );  //purposely not implemented
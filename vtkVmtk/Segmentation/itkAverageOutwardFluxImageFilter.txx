@@ -39,6 +39,10 @@ template< class TInputImage, class TOutputPixelType, class TInputVectorPixelType
 AverageOutwardFluxImageFilter<TInputImage, TOutputPixelType, TInputVectorPixelType>::AverageOutwardFluxImageFilter()
 //--------------------------------------------------
 {
+	this->SetNumberOfRequiredInputs( 2 );
+#if ITK_VERSION_MAJOR >= 5
+	this->DynamicMultiThreadingOn();
+#endif
 }
 
 //--------------------------------------------------
@@ -50,76 +54,136 @@ AverageOutwardFluxImageFilter<TInputImage, TOutputPixelType, TInputVectorPixelTy
 
 //--------------------------------------------------
 template< class TInputImage, class TOutputPixelType, class TInputVectorPixelType>
-void AverageOutwardFluxImageFilter<TInputImage, TOutputPixelType, TInputVectorPixelType>::GenerateData()
+void AverageOutwardFluxImageFilter<TInputImage, TOutputPixelType, TInputVectorPixelType>::GenerateInputRequestedRegion()
 //--------------------------------------------------
 {
-	try
+	Superclass::GenerateInputRequestedRegion();
+
+	for ( unsigned int i = 0; i < 2; i++ )
 	{
-		this->distance = dynamic_cast<const TInputImage  *>( ProcessObject::GetInput(0) );
-		this->gradient = dynamic_cast<const TInputVectorImage  *>( ProcessObject::GetInput(1) );
-
-		this->aof = dynamic_cast< TOutputImage * >(  this->ProcessObject::GetOutput(0) );
-
-		// Initialize output image
-		this->aof->SetSpacing( this->gradient->GetSpacing() );
-		this->aof->SetOrigin( this->gradient->GetOrigin() );
-		this->aof->SetRegions( this->gradient->GetRequestedRegion() );
-		this->aof->Allocate();
-
-		// aof and neighborhood iterators
-		InputConstIteratorType dit = InputConstIteratorType( this->distance, this->distance->GetRequestedRegion() );
-		OutputIteratorType aofit = OutputIteratorType( this->aof, this->aof->GetRequestedRegion() );
-
-		typename InputVectorConstNeighborhoodIteratorType::RadiusType radius;
-		radius.Fill(1);
-		InputVectorConstNeighborhoodIteratorType nit( radius, this->gradient, this->gradient->GetRequestedRegion() );
-
-		// Computation of the average outward flux inside the object
-		double f = 0, norm = 0;
-		vector<double> n(TInputImage::ImageDimension);
-		
-		for ( nit.GoToBegin(), dit.GoToBegin(), aofit.GoToBegin(); !nit.IsAtEnd(); ++nit, ++dit, ++aofit )
+		if ( this->ProcessObject::GetInput(i) )
 		{
-			f = 0.0;
-			for ( int i = 0; i < pow((float)3.0,(int)n.size()); i++ )
-			{
-				if ( nit.GetIndex() != nit.GetIndex(i) )
-				{
-					norm = 0.0;
-					for ( unsigned char d = 0; d < n.size(); d++ ) {
-						// Compute the normal of the sphere centered in p in the i-th 27 neighborhood
-						n[d] = nit.GetIndex(i)[d] - nit.GetIndex()[d];
-					}
-					for ( unsigned char d = 0; d < n.size(); d++ ) {
-						norm += n[d] * n[d];
-					}
-					norm = sqrt( norm );
-
-					for ( unsigned char d = 0; d < n.size(); d++ ) {
-						n[d] = n[d] / norm;
-					}
-
-					// Average formula
-					for ( unsigned char d = 0; d < n.size(); d++ ) {
-						f -= nit.GetPixel(i)[d]*n[d];
- 					}
+			this->ProcessObject::GetInput(i)->SetRequestedRegionToLargestPossibleRegion();
+		}
+	}
+}
 
-				}
-			}
+//--------------------------------------------------
+template< class TInputImage, class TOutputPixelType, class TInputVectorPixelType>
+void AverageOutwardFluxImageFilter<TInputImage, TOutputPixelType, TInputVectorPixelType>::BeforeThreadedGenerateData()
+//--------------------------------------------------
+{
+	this->distance = dynamic_cast<const TInputImage  *>( ProcessObject::GetInput(0) );
+	this->gradient = dynamic_cast<const TInputVectorImage  *>( ProcessObject::GetInput(1) );
+	this->aof = dynamic_cast< TOutputImage * >(  this->ProcessObject::GetOutput(0) );
 
-			if ( dit.Get() > 0.0 )
-				aofit.Set(0.0);
-			else
-				aofit.Set(f);
-		}
+	if ( this->distance->GetBufferedRegion() != this->gradient->GetBufferedRegion() )
+	{
+		itkExceptionMacro( << "AverageOutwardFluxImageFilter::BeforeThreadedGenerateData() - Distance and gradient images must have the same buffered region." );
 	}
-	catch ( itk::ExceptionObject &err )
+
+	// Neighbors of the 3^N neighborhood but the center, with the normal of the sphere
+	// centered in p at each of them
+	this->neighbors.clear();
+	this->bufferOffsets.clear();
+	this->normals.clear();
+
+	unsigned int numberOfPositions = 1;
+	for ( unsigned int d = 0; d < ImageDimension; d++ )
 	{
-		throw err;
+		numberOfPositions *= 3;
 	}
-	catch (...)
+
+	for ( unsigned int i = 0; i < numberOfPositions; i++ )
 	{
-		itkExceptionMacro( << "AverageOutwardFluxImageFilter::GenerateData() - Unexpected error!" << std::endl );
+		typename TInputImage::OffsetType offset;
+		unsigned int position = i;
+		double norm = 0.0;
+		for ( unsigned int d = 0; d < ImageDimension; d++ )
+		{
+			offset[d] = static_cast<OffsetValueType>( position % 3 ) - 1;
+			position /= 3;
+			norm += offset[d] * offset[d];
+		}
+		if ( norm == 0.0 )
+		{
+			continue;
+		}
+		norm = sqrt( norm );
+
+		this->neighbors.push_back( offset );
+		this->bufferOffsets.push_back( this->gradient->ComputeOffset( this->gradient->GetBufferedRegion().GetIndex() + offset ) 
+			- this->gradient->ComputeOffset( this->gradient->GetBufferedRegion().GetIndex() ) );
+		for ( unsigned int d = 0; d < ImageDimension; d++ )
+		{
+			this->normals.push_back( offset[d] / norm );
+		}
+	}
+}
+
+//--------------------------------------------------
+template< class TInputImage, class TOutputPixelType, class TInputVectorPixelType>
+void AverageOutwardFluxImageFilter<TInputImage, TOutputPixelType, TInputVectorPixelType>
+#if ITK_VERSION_MAJOR >= 5
+::DynamicThreadedGenerateData( const OutputImageRegionType& outputRegionForThread )
+#else
+::ThreadedGenerateData( const OutputImageRegionType& outputRegionForThread, ThreadIdType itkNotUsed(threadId) )
+#endif
+//--------------------------------------------------
+{
+	const typename TInputImage::RegionType bufferedRegion = this->gradient->GetBufferedRegion();
+	const typename TInputImage::IndexType start = bufferedRegion.GetIndex();
+	const typename TInputImage::SizeType size = bufferedRegion.GetSize();
+
+	const typename TInputImage::PixelType *d = this->distance->GetBufferPointer();
+	const TInputVectorPixelType *g = this->gradient->GetBufferPointer();
+
+	const size_t numberOfNeighbors = this->neighbors.size();
+
+	OutputIteratorType aofit( this->aof, outputRegionForThread );
+
+	for ( aofit.GoToBegin(); !aofit.IsAtEnd(); ++aofit )
+	{
+		const typename TInputImage::IndexType index = aofit.GetIndex();
+		const OffsetValueType o = this->gradient->ComputeOffset( index );
+
+		// Outside the object
+		if ( d[o] > 0.0 )
+		{
+			aofit.Set( 0.0 );
+			continue;
+		}
+
+		bool interior = true;
+		for ( unsigned int k = 0; k < ImageDimension && interior; k++ )
+		{
+			interior = index[k] > start[k] && index[k] < start[k] + static_cast<IndexValueType>( size[k] ) - 1;
+		}
+
+		// Average formula
+		double f = 0.0;
+		const double *n = &this->normals[0];
+		for ( size_t i = 0; i < numberOfNeighbors; i++, n += ImageDimension )
+		{
+			OffsetValueType q = o + this->bufferOffsets[i];
+			if ( !interior )
+			{
+				// Neighbors outside the image take the value of the closest voxel
+				typename TInputImage::IndexType neighbor = index + this->neighbors[i];
+				for ( unsigned int k = 0; k < ImageDimension; k++ )
+				{
+					neighbor[k] = std::max( start[k], std::min( neighbor[k], start[k] + static_cast<IndexValueType>( size[k] ) - 1 ) );
+				}
+				q = this->gradient->ComputeOffset( neighbor );
+			}
+
+			for ( unsigned int k = 0; k < ImageDimension; k++ )
+			{
+				f -= g[q][k] * n[k];
+			}
+		}
+
+		aofit.Set( f );
 	}
 }
 
@@ -0,0 +1,232 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    $RCSfile: itkFusedMultiScaleHessianMeasureImageFilter.h,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:48:25 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+  Portions of this code are covered under the ITK copyright.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkFusedMultiScaleHessianMeasureImageFilter_h
+#define __itkFusedMultiScaleHessianMeasureImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkImage.h"
+
+namespace itk
+{
+/** \class FusedMultiScaleHessianMeasureImageFilter
+ * \brief Multi-scale Hessian eigenvalue based measure (Frangi objectness or
+ * Sato vesselness) computed without per-scale Hessian images.
+ *
+ * Produces the same kind of output as MultiScaleHessianBasedMeasureImageFilter
+ * combined with HessianToObjectnessMeasureImageFilter or
+ * Hessian3DToVesselnessMeasureImageFilter, but never materializes a tensor
+ * image. The output region of each thread is processed in tiles of TileSize
+ * voxels along the first two axes and SlabThickness along the last. For
+ * every tile and scale, the input tile plus a halo of KernelWidth sigmas on
+ * each side is smoothed with a separable third-order recursive Gaussian
+ * (Young and van Vliet), the scale-normalized Hessian is obtained by central
+ * differences and its eigenvalues by the closed-form trigonometric solution
+ * for 3x3 symmetric matrices. Only the running maximum response and the sigma
+ * it was found at are kept (the latter in the scales output, output 1).
+ *
+ * Working memory is one tile plus halo per thread instead of a six-component
+ * tensor image plus derivative images per scale, and only the halo is
+ * smoothed more than once. Results agree with the ITK pipeline up to the
+ * differences between the recursive Gaussian approximations and the
+ * truncation of the smoothing at the halo.
+ *
+ * Only 3D images are supported.
+ *
+ * \ingroup IntensityImageFilters
+ */
+template <typename TInputImage, typename TOutputImage>
+class ITK_EXPORT FusedMultiScaleHessianMeasureImageFilter :
+    public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef FusedMultiScaleHessianMeasureImageFilter Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer<Self> Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods) */
+  itkTypeMacro(FusedMultiScaleHessianMeasureImageFilter, ImageToImageFilter);
+
+  typedef typename TOutputImage::PixelType OutputPixelType;
+  typedef typename TInputImage::PixelType InputPixelType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  /** Image typedef support */
+  typedef TInputImage  InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename InputImageType::Pointer InputImagePointer;
+  typedef typename OutputImageType::Pointer OutputImagePointer;
+
+  /** Superclass typedefs. */
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro(ThreeDimensionalInputCheck,
+    (Concept::SameDimension<ImageDimension, 3u>));
+#endif
+
+  enum
+  {
+    OBJECTNESS,
+    SATO
+  };
+
+  enum
+  {
+    EQUISPACED,
+    LOGARITHMIC
+  };
+
+  /** Measure computed from the eigenvalues: OBJECTNESS (Frangi, as in
+   * HessianToObjectnessMeasureImageFilter) or SATO (as in
+   * Hessian3DToVesselnessMeasureImageFilter). Default is OBJECTNESS. */
+  itkSetMacro(Measure, int);
+  itkGetConstMacro(Measure, int);
+
+  itkSetMacro(SigmaMinimum, double);
+  itkGetConstMacro(SigmaMinimum, double);
+
+  itkSetMacro(SigmaMaximum, double);
+  itkGetConstMacro(SigmaMaximum, double);
+
+  itkSetMacro(NumberOfSigmaSteps, unsigned int);
+  itkGetConstMacro(NumberOfSigmaSteps, unsigned int);
+
+  itkSetMacro(SigmaStepMethod, int);
+  itkGetConstMacro(SigmaStepMethod, int);
+
+  /** Objectness parameters. */
+  itkSetMacro(Alpha, double);
+  itkGetConstMacro(Alpha, double);
+
+  itkSetMacro(Beta, double);
+  itkGetConstMacro(Beta, double);
+
+  itkSetMacro(Gamma, double);
+  itkGetConstMacro(Gamma, double);
+
+  itkSetMacro(ObjectDimension, unsigned int);
+  itkGetConstMacro(ObjectDimension, unsigned int);
+
+  itkSetMacro(BrightObject, bool);
+  itkGetConstMacro(BrightObject, bool);
+  itkBooleanMacro(BrightObject);
+
+  itkSetMacro(ScaleObjectnessMeasure, bool);
+  itkGetConstMacro(ScaleObjectnessMeasure, bool);
+  itkBooleanMacro(ScaleObjectnessMeasure);
+
+  /** Sato vesselness parameters. */
+  itkSetMacro(Alpha1, double);
+  itkGetConstMacro(Alpha1, double);
+
+  itkSetMacro(Alpha2, double);
+  itkGetConstMacro(Alpha2, double);
+
+  /** Size of the tiles along the first two axes. Default is 64. */
+  itkSetMacro(TileSize, unsigned int);
+  itkGetConstMacro(TileSize, unsigned int);
+
+  /** Size of the tiles along the last axis. Default is 16. */
+  itkSetMacro(SlabThickness, unsigned int);
+  itkGetConstMacro(SlabThickness, unsigned int);
+
+  /** Half width of the smoothing support in units of sigma, used to size the
+   * halo of each tile. Default is 4. */
+  itkSetMacro(KernelWidth, double);
+  itkGetConstMacro(KernelWidth, double);
+
+  /** Sigma at which the maximum response was found. */
+  const OutputImageType* GetScalesOutput() const
+  { return static_cast<const OutputImageType*>(this->ProcessObject::GetOutput(1)); }
+
+  double ComputeSigma(unsigned int scaleLevel) const;
+
+protected:
+  FusedMultiScaleHessianMeasureImageFilter();
+  virtual ~FusedMultiScaleHessianMeasureImageFilter() {}
+
+  /** The whole input is requested, tiles read their halo from it. */
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+#if ITK_VERSION_MAJOR >= 5
+  void DynamicThreadedGenerateData(const OutputImageRegionType& outputRegionForThread) ITK_OVERRIDE;
+#else
+  void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                            ThreadIdType threadId ) ITK_OVERRIDE;
+#endif
+
+  void PrintSelf(std::ostream&, Indent) const ITK_OVERRIDE;
+
+  /** In-place recursive Gaussian along one axis of a block of lines. The
+   * block holds width contiguous lines of length n, consecutive samples along
+   * the axis being stride apart. */
+  static void SmoothBlock(float* data, SizeValueType n, SizeValueType stride, SizeValueType width, const double coefficients[4]);
+
+  static void ComputeRecursiveGaussianCoefficients(double sigma, double coefficients[4]);
+
+  /** Eigenvalues of the symmetric matrix (xx, xy, xz, yy, yz, zz) in
+   * ascending order. */
+  static void ComputeSymmetricEigenValues(const double hessian[6], double eigenValues[3]);
+
+  double ComputeMeasure(const double eigenValues[3]) const;
+
+private:
+  FusedMultiScaleHessianMeasureImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  int m_Measure;
+  double m_SigmaMinimum;
+  double m_SigmaMaximum;
+  unsigned int m_NumberOfSigmaSteps;
+  int m_SigmaStepMethod;
+  double m_Alpha;
+  double m_Beta;
+  double m_Gamma;
+  unsigned int m_ObjectDimension;
+  bool m_BrightObject;
+  bool m_ScaleObjectnessMeasure;
+  double m_Alpha1;
+  double m_Alpha2;
+  unsigned int m_TileSize;
+  unsigned int m_SlabThickness;
+  double m_KernelWidth;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFusedMultiScaleHessianMeasureImageFilter.txx"
+#endif
+
+#endif
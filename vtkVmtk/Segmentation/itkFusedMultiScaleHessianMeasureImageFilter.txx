@@ -0,0 +1,548 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    $RCSfile: itkFusedMultiScaleHessianMeasureImageFilter.txx,v $
+Language:  C++
+Date:      $Date: 2006/04/06 16:48:25 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+  Portions of this code are covered under the ITK copyright.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef _itkFusedMultiScaleHessianMeasureImageFilter_txx
+#define _itkFusedMultiScaleHessianMeasureImageFilter_txx
+#include "itkFusedMultiScaleHessianMeasureImageFilter.h"
+
+#include "itkImageRegionIterator.h"
+#include "itkMath.h"
+#if ITK_VERSION_MAJOR >= 5
+#include "itkTotalProgressReporter.h"
+#else
+#include "itkProgressReporter.h"
+#endif
+
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+namespace itk
+{
+
+template <typename TInputImage, typename TOutputImage>
+FusedMultiScaleHessianMeasureImageFilter<TInputImage, TOutputImage>
+::FusedMultiScaleHessianMeasureImageFilter()
+{
+  m_Measure = OBJECTNESS;
+  m_SigmaMinimum = 1.0;
+  m_SigmaMaximum = 1.0;
+  m_NumberOfSigmaSteps = 1;
+  m_SigmaStepMethod = EQUISPACED;
+  m_Alpha = 0.5;
+  m_Beta = 0.5;
+  m_Gamma = 5.0;
+  m_ObjectDimension = 1;
+  m_BrightObject = true;
+  m_ScaleObjectnessMeasure = false;
+  m_Alpha1 = 0.5;
+  m_Alpha2 = 2.0;
+  m_TileSize = 64;
+  m_SlabThickness = 16;
+  m_KernelWidth = 4.0;
+
+  this->SetNumberOfRequiredOutputs(2);
+  this->SetNthOutput(1,this->MakeOutput(1));
+
+#if ITK_VERSION_MAJOR >= 5
+  this->DynamicMultiThreadingOn();
+  this->ThreaderUpdateProgressOff();
+#endif
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+FusedMultiScaleHessianMeasureImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream& os, Indent indent) const
+{
+  Superclass::PrintSelf(os,indent);
+  os << indent << "Measure = " << m_Measure << std::endl;
+  os << indent << "SigmaMinimum = " << m_SigmaMinimum << std::endl;
+  os << indent << "SigmaMaximum = " << m_SigmaMaximum << std::endl;
+  os << indent << "NumberOfSigmaSteps = " << m_NumberOfSigmaSteps << std::endl;
+  os << indent << "SigmaStepMethod = " << m_SigmaStepMethod << std::endl;
+  os << indent << "Alpha = " << m_Alpha << std::endl;
+  os << indent << "Beta = " << m_Beta << std::endl;
+  os << indent << "Gamma = " << m_Gamma << std::endl;
+  os << indent << "ObjectDimension = " << m_ObjectDimension << std::endl;
+  os << indent << "BrightObject = " << m_BrightObject << std::endl;
+  os << indent << "ScaleObjectnessMeasure = " << m_ScaleObjectnessMeasure << std::endl;
+  os << indent << "Alpha1 = " << m_Alpha1 << std::endl;
+  os << indent << "Alpha2 = " << m_Alpha2 << std::endl;
+  os << indent << "TileSize = " << m_TileSize << std::endl;
+  os << indent << "SlabThickness = " << m_SlabThickness << std::endl;
+  os << indent << "KernelWidth = " << m_KernelWidth << std::endl;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+FusedMultiScaleHessianMeasureImageFilter<TInputImage,TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImagePointer inputPtr = const_cast< InputImageType * >( this->GetInput());
+  if ( inputPtr )
+    {
+    inputPtr->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+FusedMultiScaleHessianMeasureImageFilter<TInputImage,TOutputImage>
+::BeforeThreadedGenerateData()
+{
+  if (m_Measure == OBJECTNESS && m_ObjectDimension >= ImageDimension)
+    {
+    itkExceptionMacro(<< "ObjectDimension must be lower than ImageDimension.");
+    }
+  if (m_SigmaMinimum <= 0.0 || m_SigmaMaximum <= 0.0)
+    {
+    itkExceptionMacro(<< "Sigma must be positive.");
+    }
+}
+
+template <typename TInputImage, typename TOutputImage>
+double
+FusedMultiScaleHessianMeasureImageFilter<TInputImage,TOutputImage>
+::ComputeSigma(unsigned int scaleLevel) const
+{
+  if (m_NumberOfSigmaSteps < 2)
+    {
+    return m_SigmaMinimum;
+    }
+
+  double sigma = m_SigmaMinimum;
+  if (m_SigmaStepMethod == LOGARITHMIC)
+    {
+    const double stepSize = std::max(1E-10, (std::log(m_SigmaMaximum) - std::log(m_SigmaMinimum)) / (m_NumberOfSigmaSteps - 1));
+    sigma = std::exp(std::log(m_SigmaMinimum) + stepSize * scaleLevel);
+    }
+  else
+    {
+    const double stepSize = std::max(1E-10, (m_SigmaMaximum - m_SigmaMinimum) / (m_NumberOfSigmaSteps - 1));
+    sigma = m_SigmaMinimum + stepSize * scaleLevel;
+    }
+  return sigma;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+FusedMultiScaleHessianMeasureImageFilter<TInputImage,TOutputImage>
+::ComputeRecursiveGaussianCoefficients(double sigma, double coefficients[4])
+{
+  // Young and van Vliet, Signal Processing 44 (1995) 139-151.
+  if (sigma < 0.5)
+    {
+    sigma = 0.5;
+    }
+  double q;
+  if (sigma >= 2.5)
+    {
+    q = 0.98711 * sigma - 0.96330;
+    }
+  else
+    {
+    q = 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+    }
+  const double q2 = q * q;
+  const double q3 = q2 * q;
+  const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+  const double b1 = 2.44413 * q + 2.85619 * q2 + 1.26661 * q3;
+  const double b2 = -(1.4281 * q2 + 1.26661 * q3);
+  const double b3 = 0.422205 * q3;
+
+  coefficients[1] = b1 / b0;
+  coefficients[2] = b2 / b0;
+  coefficients[3] = b3 / b0;
+  coefficients[0] = 1.0 - (coefficients[1] + coefficients[2] + coefficients[3]);
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+FusedMultiScaleHessianMeasureImageFilter<TInputImage,TOutputImage>
+::SmoothBlock(float* data, SizeValueType n, SizeValueType stride, SizeValueType width, const double coefficients[4])
+{
+  const float b = static_cast<float>(coefficients[0]);
+  const float c1 = static_cast<float>(coefficients[1]);
+  const float c2 = static_cast<float>(coefficients[2]);
+  const float c3 = static_cast<float>(coefficients[3]);
+
+  // Samples before the first (after the last) one are taken equal to it, which
+  // leaves the first sample of the causal (the last of the anticausal) pass
+  // unchanged and lets us clamp the recursion indices.
+  for (SizeValueType k = 1; k < n; k++)
+    {
+    float* current = data + k * stride;
+    const float* previous1 = data + (k - 1) * stride;
+    const float* previous2 = data + (k >= 2 ? k - 2 : 0) * stride;
+    const float* previous3 = data + (k >= 3 ? k - 3 : 0) * stride;
+    for (SizeValueType i = 0; i < width; i++)
+      {
+      current[i] = b * current[i] + c1 * previous1[i] + c2 * previous2[i] + c3 * previous3[i];
+      }
+    }
+
+  for (SizeValueType k = n - 1; k-- > 0; )
+    {
+    float* current = data + k * stride;
+    const float* next1 = data + (k + 1) * stride;
+    const float* next2 = data + std::min(k + 2, n - 1) * stride;
+    const float* next3 = data + std::min(k + 3, n - 1) * stride;
+    for (SizeValueType i = 0; i < width; i++)
+      {
+      current[i] = b * current[i] + c1 * next1[i] + c2 * next2[i] + c3 * next3[i];
+      }
+    }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+FusedMultiScaleHessianMeasureImageFilter<TInputImage,TOutputImage>
+::ComputeSymmetricEigenValues(const double hessian[6], double eigenValues[3])
+{
+  const double a00 = hessian[0];
+  const double a01 = hessian[1];
+  const double a02 = hessian[2];
+  const double a11 = hessian[3];
+  const double a12 = hessian[4];
+  const double a22 = hessian[5];
+
+  const double q = (a00 + a11 + a22) / 3.0;
+  const double b00 = a00 - q;
+  const double b11 = a11 - q;
+  const double b22 = a22 - q;
+  const double p1 = a01 * a01 + a02 * a02 + a12 * a12;
+  const double p2 = b00 * b00 + b11 * b11 + b22 * b22 + 2.0 * p1;
+
+  if (p2 <= 0.0)
+    {
+    eigenValues[0] = eigenValues[1] = eigenValues[2] = q;
+    return;
+    }
+
+  const double p = std::sqrt(p2 / 6.0);
+  const double determinant = b00 * (b11 * b22 - a12 * a12) - a01 * (a01 * b22 - a12 * a02) + a02 * (a01 * a12 - b11 * a02);
+  double r = 0.5 * determinant / (p * p * p);
+  r = std::max(-1.0, std::min(1.0, r));
+
+  const double phi = std::acos(r) / 3.0;
+  const double twoThirdsPi = 2.0 * itk::Math::pi / 3.0;
+
+  eigenValues[2] = q + 2.0 * p * std::cos(phi);
+  eigenValues[0] = q + 2.0 * p * std::cos(phi + twoThirdsPi);
+  eigenValues[1] = 3.0 * q - eigenValues[0] - eigenValues[2];
+}
+
+template <typename TInputImage, typename TOutputImage>
+double
+FusedMultiScaleHessianMeasureImageFilter<TInputImage,TOutputImage>
+::ComputeMeasure(const double eigenValues[3]) const
+{
+  if (m_Measure == SATO)
+    {
+    // Hessian3DToVesselnessMeasureImageFilter, eigenvalues ordered by value
+    const double normalizeValue = std::min(-eigenValues[1], -eigenValues[0]);
+    if (normalizeValue <= 0.0)
+      {
+      return 0.0;
+      }
+    double lineMeasure;
+    if (eigenValues[2] <= 0.0)
+      {
+      lineMeasure = std::exp(-0.5 * itk::Math::sqr(eigenValues[2] / (m_Alpha1 * normalizeValue)));
+      }
+    else
+      {
+      lineMeasure = std::exp(-0.5 * itk::Math::sqr(eigenValues[2] / (m_Alpha2 * normalizeValue)));
+      }
+    return lineMeasure * normalizeValue;
+    }
+
+  // HessianToObjectnessMeasureImageFilter, eigenvalues ordered by magnitude
+  double sorted[3] = { eigenValues[0], eigenValues[1], eigenValues[2] };
+  if (std::fabs(sorted[0]) > std::fabs(sorted[1])) std::swap(sorted[0],sorted[1]);
+  if (std::fabs(sorted[1]) > std::fabs(sorted[2])) std::swap(sorted[1],sorted[2]);
+  if (std::fabs(sorted[0]) > std::fabs(sorted[1])) std::swap(sorted[0],sorted[1]);
+
+  const unsigned int m = m_ObjectDimension;
+  for (unsigned int i = m; i < 3; i++)
+    {
+    if ((m_BrightObject && sorted[i] > 0.0) || (!m_BrightObject && sorted[i] < 0.0))
+      {
+      return 0.0;
+      }
+    }
+
+  const double absSorted[3] = { std::fabs(sorted[0]), std::fabs(sorted[1]), std::fabs(sorted[2]) };
+
+  double objectnessMeasure = 1.0;
+
+  if (m < 2)
+    {
+    double rA = absSorted[m];
+    double rADenominatorBase = 1.0;
+    for (unsigned int j = m + 1; j < 3; j++)
+      {
+      rADenominatorBase *= absSorted[j];
+      }
+    if (rADenominatorBase > 0.0)
+      {
+      if (std::fabs(m_Alpha) > 0.0)
+        {
+        rA /= std::pow(rADenominatorBase, 1.0 / (3 - m - 1));
+        objectnessMeasure *= 1.0 - std::exp(-0.5 * itk::Math::sqr(rA) / itk::Math::sqr(m_Alpha));
+        }
+      }
+    else
+      {
+      objectnessMeasure = 0.0;
+      }
+    }
+
+  if (m > 0)
+    {
+    double rB = absSorted[m - 1];
+    double rBDenominatorBase = 1.0;
+    for (unsigned int j = m; j < 3; j++)
+      {
+      rBDenominatorBase *= absSorted[j];
+      }
+    if (rBDenominatorBase > 0.0 && std::fabs(m_Beta) > 0.0)
+      {
+      rB /= std::pow(rBDenominatorBase, 1.0 / (3 - m));
+      objectnessMeasure *= std::exp(-0.5 * itk::Math::sqr(rB) / itk::Math::sqr(m_Beta));
+      }
+    else
+      {
+      objectnessMeasure = 0.0;
+      }
+    }
+
+  if (std::fabs(m_Gamma) > 0.0)
+    {
+    const double frobeniusNormSquared = absSorted[0] * absSorted[0] + absSorted[1] * absSorted[1] + absSorted[2] * absSorted[2];
+    objectnessMeasure *= 1.0 - std::exp(-0.5 * frobeniusNormSquared / itk::Math::sqr(m_Gamma));
+    }
+
+  if (m_ScaleObjectnessMeasure)
+    {
+    objectnessMeasure *= absSorted[2];
+    }
+
+  return objectnessMeasure;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+FusedMultiScaleHessianMeasureImageFilter<TInputImage,TOutputImage>
+#if ITK_VERSION_MAJOR >= 5
+::DynamicThreadedGenerateData(const OutputImageRegionType& outputRegionForThread)
+#else
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                       ThreadIdType threadId)
+#endif
+{
+  typename InputImageType::ConstPointer input = this->GetInput();
+  OutputImageType* output = this->GetOutput();
+  OutputImageType* scalesOutput = static_cast<OutputImageType*>(this->ProcessObject::GetOutput(1));
+
+  const typename InputImageType::RegionType inputRegion = input->GetBufferedRegion();
+  const typename InputImageType::IndexType inputIndex = inputRegion.GetIndex();
+  const typename InputImageType::SizeType inputSize = inputRegion.GetSize();
+  const typename InputImageType::SpacingType spacing = input->GetSpacing();
+
+  const SizeValueType nx = inputSize[0];
+  const SizeValueType ny = inputSize[1];
+  const SizeValueType nz = inputSize[2];
+  const SizeValueType sliceSize = nx * ny;
+
+  const SizeValueType xBegin = outputRegionForThread.GetIndex()[0] - inputIndex[0];
+  const SizeValueType yBegin = outputRegionForThread.GetIndex()[1] - inputIndex[1];
+  const SizeValueType zBegin = outputRegionForThread.GetIndex()[2] - inputIndex[2];
+  const SizeValueType xEnd = xBegin + outputRegionForThread.GetSize()[0];
+  const SizeValueType yEnd = yBegin + outputRegionForThread.GetSize()[1];
+  const SizeValueType zEnd = zBegin + outputRegionForThread.GetSize()[2];
+
+  ImageRegionIterator<OutputImageType> oit(output,outputRegionForThread);
+  ImageRegionIterator<OutputImageType> sit(scalesOutput,outputRegionForThread);
+  for (oit.GoToBegin(), sit.GoToBegin(); !oit.IsAtEnd(); ++oit, ++sit)
+    {
+    oit.Set(NumericTraits<OutputPixelType>::ZeroValue());
+    sit.Set(NumericTraits<OutputPixelType>::ZeroValue());
+    }
+
+  const unsigned int numberOfScales = std::max(m_NumberOfSigmaSteps,1u);
+
+  double maximumSigma = 0.0;
+  for (unsigned int level = 0; level < numberOfScales; level++)
+    {
+    maximumSigma = std::max(maximumSigma,this->ComputeSigma(level));
+    }
+
+  const SizeValueType imageSize[3] = { nx, ny, nz };
+  const SizeValueType regionBegin[3] = { xBegin, yBegin, zBegin };
+  const SizeValueType regionEnd[3] = { xEnd, yEnd, zEnd };
+  const SizeValueType tileSize[3] = { std::max(m_TileSize,1u), std::max(m_TileSize,1u), std::max(m_SlabThickness,1u) };
+  SizeValueType halo[3];
+  SizeValueType maximumBufferSize = 1;
+  for (unsigned int d = 0; d < 3; d++)
+    {
+    halo[d] = static_cast<SizeValueType>(std::ceil(m_KernelWidth * maximumSigma / spacing[d])) + 1;
+    maximumBufferSize *= std::min(tileSize[d] + 2 * halo[d], imageSize[d]);
+    }
+
+  std::vector<float> buffer(maximumBufferSize);
+
+#if ITK_VERSION_MAJOR >= 5
+  TotalProgressReporter progress(this, output->GetRequestedRegion().GetNumberOfPixels() * numberOfScales);
+#else
+  ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels() * numberOfScales);
+#endif
+
+  const InputPixelType* inputBuffer = input->GetBufferPointer();
+
+  SizeValueType tileBegin[3];
+  for (tileBegin[2] = regionBegin[2]; tileBegin[2] < regionEnd[2]; tileBegin[2] += tileSize[2])
+  for (tileBegin[1] = regionBegin[1]; tileBegin[1] < regionEnd[1]; tileBegin[1] += tileSize[1])
+  for (tileBegin[0] = regionBegin[0]; tileBegin[0] < regionEnd[0]; tileBegin[0] += tileSize[0])
+    {
+    // the tile, and the tile plus its halo clipped to the image
+    SizeValueType tileEnd[3], bufferBegin[3], bufferSize[3];
+    for (unsigned int d = 0; d < 3; d++)
+      {
+      tileEnd[d] = std::min(tileBegin[d] + tileSize[d], regionEnd[d]);
+      bufferBegin[d] = tileBegin[d] > halo[d] ? tileBegin[d] - halo[d] : 0;
+      bufferSize[d] = std::min(tileEnd[d] + halo[d], imageSize[d]) - bufferBegin[d];
+      }
+    const SizeValueType bnx = bufferSize[0];
+    const SizeValueType bny = bufferSize[1];
+    const SizeValueType bnz = bufferSize[2];
+    const SizeValueType bufferSliceSize = bnx * bny;
+
+    for (unsigned int level = 0; level < numberOfScales; level++)
+      {
+      const double sigma = this->ComputeSigma(level);
+
+      for (SizeValueType k = 0; k < bnz; k++)
+        {
+        for (SizeValueType j = 0; j < bny; j++)
+          {
+          const InputPixelType* source = inputBuffer + (bufferBegin[2] + k) * sliceSize + (bufferBegin[1] + j) * nx + bufferBegin[0];
+          float* target = &buffer[k * bufferSliceSize + j * bnx];
+          for (SizeValueType i = 0; i < bnx; i++)
+            {
+            target[i] = static_cast<float>(source[i]);
+            }
+          }
+        }
+
+      double coefficients[4];
+      ComputeRecursiveGaussianCoefficients(sigma / spacing[0],coefficients);
+      for (SizeValueType line = 0; line < bny * bnz; line++)
+        {
+        SmoothBlock(&buffer[line * bnx],bnx,1,1,coefficients);
+        }
+      ComputeRecursiveGaussianCoefficients(sigma / spacing[1],coefficients);
+      for (SizeValueType k = 0; k < bnz; k++)
+        {
+        SmoothBlock(&buffer[k * bufferSliceSize],bny,bnx,bnx,coefficients);
+        }
+      ComputeRecursiveGaussianCoefficients(sigma / spacing[2],coefficients);
+      SmoothBlock(&buffer[0],bnz,bufferSliceSize,bufferSliceSize,coefficients);
+
+      // scale-normalized second derivatives, as with NormalizeAcrossScale
+      const double normalization = sigma * sigma;
+      const double sxx = normalization / (spacing[0] * spacing[0]);
+      const double syy = normalization / (spacing[1] * spacing[1]);
+      const double szz = normalization / (spacing[2] * spacing[2]);
+      const double sxy = normalization / (4.0 * spacing[0] * spacing[1]);
+      const double sxz = normalization / (4.0 * spacing[0] * spacing[2]);
+      const double syz = normalization / (4.0 * spacing[1] * spacing[2]);
+
+      // neighbors are clamped to the buffer, which only clips the halo at
+      // the image boundary
+      for (SizeValueType z = tileBegin[2]; z < tileEnd[2]; z++)
+        {
+        const SizeValueType k = z - bufferBegin[2];
+        const SizeValueType km = k > 0 ? k - 1 : k;
+        const SizeValueType kp = k + 1 < bnz ? k + 1 : k;
+        for (SizeValueType y = tileBegin[1]; y < tileEnd[1]; y++)
+          {
+          const SizeValueType j = y - bufferBegin[1];
+          const SizeValueType jm = j > 0 ? j - 1 : j;
+          const SizeValueType jp = j + 1 < bny ? j + 1 : j;
+
+          const float* c = &buffer[k * bufferSliceSize + j * bnx];
+          const float* cym = &buffer[k * bufferSliceSize + jm * bnx];
+          const float* cyp = &buffer[k * bufferSliceSize + jp * bnx];
+          const float* czm = &buffer[km * bufferSliceSize + j * bnx];
+          const float* czp = &buffer[kp * bufferSliceSize + j * bnx];
+          const float* czmym = &buffer[km * bufferSliceSize + jm * bnx];
+          const float* czmyp = &buffer[km * bufferSliceSize + jp * bnx];
+          const float* czpym = &buffer[kp * bufferSliceSize + jm * bnx];
+          const float* czpyp = &buffer[kp * bufferSliceSize + jp * bnx];
+
+          typename OutputImageType::IndexType rowIndex;
+          rowIndex[0] = tileBegin[0] + inputIndex[0];
+          rowIndex[1] = y + inputIndex[1];
+          rowIndex[2] = z + inputIndex[2];
+          OutputPixelType* outputRow = output->GetBufferPointer() + output->ComputeOffset(rowIndex);
+          OutputPixelType* scalesRow = scalesOutput->GetBufferPointer() + scalesOutput->ComputeOffset(rowIndex);
+
+          for (SizeValueType x = tileBegin[0]; x < tileEnd[0]; x++)
+            {
+            const SizeValueType i = x - bufferBegin[0];
+            const SizeValueType im = i > 0 ? i - 1 : i;
+            const SizeValueType ip = i + 1 < bnx ? i + 1 : i;
+
+            double hessian[6];
+            hessian[0] = (c[ip] - 2.0 * c[i] + c[im]) * sxx;
+            hessian[1] = (cyp[ip] - cyp[im] - cym[ip] + cym[im]) * sxy;
+            hessian[2] = (czp[ip] - czp[im] - czm[ip] + czm[im]) * sxz;
+            hessian[3] = (cyp[i] - 2.0 * c[i] + cym[i]) * syy;
+            hessian[4] = (czpyp[i] - czpym[i] - czmyp[i] + czmym[i]) * syz;
+            hessian[5] = (czp[i] - 2.0 * c[i] + czm[i]) * szz;
+
+            double eigenValues[3];
+            ComputeSymmetricEigenValues(hessian,eigenValues);
+            const OutputPixelType measure = static_cast<OutputPixelType>(this->ComputeMeasure(eigenValues));
+
+            if (measure > outputRow[x - tileBegin[0]])
+              {
+              outputRow[x - tileBegin[0]] = measure;
+              scalesRow[x - tileBegin[0]] = static_cast<OutputPixelType>(sigma);
+              }
+            progress.CompletedPixel();
+            }
+          }
+        }
+      }
+    }
+}
+
+} // end namespace itk
+
+#endif
@@ -34,16 +34,12 @@ Modification Authors:
 #ifndef _itkMedialCurveImageFilter_h
 #define _itkMedialCurveImageFilter_h
 
-#include <time.h>
-
 //STL
-#include <functional>
-#include <queue>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
 
 #include <itkImage.h>
-#include <itkNeighborhoodIterator.h>
-#include <itkImageRegionIterator.h>
-#include <itkConstantBoundaryCondition.h>
 
 #include <itkImageToImageFilter.h>
 
@@ -58,6 +54,16 @@ namespace itk
 ///	algorithm described in : "S. Bouix, K. Siddiqi, and A. Tannenbaum. Flux driven automatic centerline extraction. Technical Report
 ///	SOCS-04.2, School of Ccomputer Science, McGill University, 2004."
 
+///
+/// The thinning works directly on the image buffers. The 3x3x3 neighborhood of a voxel is packed into
+/// a 27 bit configuration (bit i is the neighbor at offset (i%3-1, (i/3)%3-1, i/9-1), voxels outside
+/// the image are background), the topological tests operate on the configuration with precomputed 
+/// adjacency masks and the simple point test is cached in a lookup table over the 2^26 neighbor 
+/// configurations, filled on demand. Candidates are kept in a bucketed queue keyed on the quantized
+/// distance, deeper buckets last, first in first out within a bucket.
+///
+/// Only 3D images are supported.
+
 /// TODO:
 /// 1. manual instantation
 template< class TInputImage,
@@ -87,8 +93,6 @@ class ITK_EXPORT MedialCurveImageFilter:
 		/** Run-time type information (and related methods). */
 		itkTypeMacro( MedialCurveImageFilter, ImageToImageFilter );
 
-		typedef itk::ConstantBoundaryCondition< TOutputImage > OutputBCType;
-
 		typedef typename TInputImage::ConstPointer InputConstPointerType;
 		typedef typename TAverageOutwardFluxFImage::ConstPointer AOFConstPointerType;
 		typedef typename TOutputImage::Pointer OutputPointerType;
@@ -101,37 +105,8 @@ class ITK_EXPORT MedialCurveImageFilter:
 		typedef typename TInputImage::IndexType InputIndexType;
 		typedef typename TInputImage::PixelType InputPixelType;
 
-		typedef itk::ImageRegionConstIterator< TInputImage > InputConstIteratorType;
-		typedef itk::ImageRegionIterator< TOutputImage > OutputIteratorType;
-		typedef itk::ConstNeighborhoodIterator< TInputImage > InputConstNeighborhoodIteratorType;
-		typedef itk::ConstNeighborhoodIterator< TAverageOutwardFluxFImage > AOFConstNeighborhoodIteratorType;
-		typedef itk::NeighborhoodIterator< TOutputImage > OutputNeighborhoodIteratorType;
-
-		struct Pixel 
-		{
-			private:
-				InputIndexType pixelIndex;
-				InputPixelType pixelValue;
-
-			public:
-				InputPixelType GetPriority() const {return pixelValue;};
-				void SetIndex(InputIndexType p) { pixelIndex=p;};
-				void SetValue(InputPixelType v) {pixelValue=v;};
-				InputIndexType GetIndex() {return pixelIndex;};
-				InputPixelType GetValue() {return pixelValue;};
-		};
-
-		struct Greater
-		{
-			public:
-				bool operator()(const Pixel &p1, const Pixel &p2)  const
-				{
-					return p1.GetPriority() > p2.GetPriority();
-				}
-		};
-
-		typedef std::vector<Pixel> HeapContainer;
-		typedef std::priority_queue<Pixel, HeapContainer, Greater > HeapType;
+		/** 3x3x3 neighborhood configuration, bit 13 is the center. */
+		typedef unsigned int ConfigurationType;
 
 		/** The dimension of the input and output images. */
 		itkStaticConstMacro(InputImageDimension, unsigned int,
@@ -160,10 +135,19 @@ class ITK_EXPORT MedialCurveImageFilter:
 		/** Get the AOF threshold . */
 		itkGetConstReferenceMacro( Threshold, double );
 
+		/** Set the width of the distance buckets of the thinning queue. If not positive,
+		 * 1/64 of the smallest spacing is used. */
+		itkSetMacro( BucketWidth, double );
+
+		/** Get the width of the distance buckets of the thinning queue. */
+		itkGetConstReferenceMacro( BucketWidth, double );
+
 #ifdef ITK_USE_CONCEPT_CHECKING
 		/** Begin concept checking */
 		itkConceptMacro(SameDimensionCheck,
 			(Concept::SameDimension<InputImageDimension, OutputImageDimension>));
+		itkConceptMacro(ThreeDimensionalInputCheck,
+			(Concept::SameDimension<InputImageDimension, 3u>));
 		itkConceptMacro(AOFIsFloatingPointCheck,
 			(Concept::IsFloatingPoint<TAverageOutwardFluxPixelType>));
 		/** End concept checking */
@@ -177,20 +161,26 @@ class ITK_EXPORT MedialCurveImageFilter:
 		/// \brief Destructor
 		virtual ~MedialCurveImageFilter();
 
-		///\brief Returns true if p belongs to the object and at least one of its 27 neighbors
+		///\brief Returns true if p belongs to the object and at least one of its 26 neighbors
 		/// belong to the background.
-		bool IsBoundary( OutputIndexType p );
+		bool IsBoundary( ConfigurationType c ) const;
     
-		///\brief Returns true if its deletion from the object changes the local object topology
-		/// in the 27 neighborhood.
-		bool IsIntSimple( OutputIndexType p );
+		///\brief Returns true if the object neighbors of p are 26 connected without p, ie if
+		/// its deletion does not change the local object topology in the 26 neighborhood.
+		bool IsIntSimple( ConfigurationType c ) const;
+
+		///\brief Returns true if the background 6 neighbors of p are 6 connected in the 18
+		/// neighborhood, ie if its deletion does not change the local background topology. 
+		bool IsExtSimple( ConfigurationType c ) const;
 
-		///\brief Returns true if its deletion from the object changes the local background topology
-		/// in the 18 neighborhood. 
-		bool IsExtSimple( OutputIndexType p );
+		///\brief IsIntSimple && IsExtSimple, cached in the lookup table.
+		bool IsSimple( ConfigurationType c );
 
 		///\brief Returns true if the point has less than two object neighbors.
-		bool IsEnd( OutputIndexType p );
+		bool IsEnd( ConfigurationType c ) const;
+
+		///\brief Packs the skeleton values in the 3x3x3 neighborhood of a voxel.
+		ConfigurationType GetConfiguration( OffsetValueType offset, const OffsetValueType index[3] ) const;
 
 		///\brief Computes the binary object from its implicit representation.
 		void DistanceToObject();
@@ -208,10 +198,18 @@ class ITK_EXPORT MedialCurveImageFilter:
 		InputConstPointerType distance; // Implicit representation of the object. Is at input 0.
 		AOFConstPointerType aof;        // Average outward flux. Is at input 1.
 		double m_Threshold;             // Threshold for the average outward flux.
-		OutputPointerType queued;       // Image that stores queued labels in Update().
-		OutputPointerType auxQueued;    // Image that stores queued labels in IsIntSimple() and IsExtSimple().
+		double m_BucketWidth;           // Distance quantization of the thinning queue.
 		OutputPointerType skeleton;     // Skeleton.
-		OutputRegionType region;
+
+		OffsetValueType size[3];        // Buffer size and strides.
+		OffsetValueType strides[3];
+		OffsetValueType offsets[27];    // Buffer offsets of the 3x3x3 neighborhood.
+
+		ConfigurationType adjacency26[27]; // Neighbors of each position inside the 3x3x3 neighborhood.
+		ConfigurationType adjacency6[27];
+		ConfigurationType n18;             // Positions of the 18 neighborhood.
+
+		std::vector<unsigned char> simpleTable; // 2 bits per configuration: unknown, not simple, simple.
 
 
 	private:
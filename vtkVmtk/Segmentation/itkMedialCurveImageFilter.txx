@@ -38,6 +38,37 @@ template< class TInputImage, class TAverageOutwardFluxPixelType, class TOutputPi
 MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::MedialCurveImageFilter()
 //--------------------------------------------------
 {
+	this->m_Threshold = 0.0;
+	this->m_BucketWidth = 0.0;
+
+	// Adjacency inside the 3x3x3 neighborhood, position i is at (i%3, (i/3)%3, i/9)
+	this->n18 = 0;
+	for ( int i = 0; i < 27; i++ )
+	{
+		const int pi[3] = { i % 3, ( i / 3 ) % 3, i / 9 };
+		this->adjacency26[i] = 0;
+		this->adjacency6[i] = 0;
+		for ( int j = 0; j < 27; j++ )
+		{
+			const int pj[3] = { j % 3, ( j / 3 ) % 3, j / 9 };
+			int maxDifference = 0;
+			int sumDifference = 0;
+			for ( int d = 0; d < 3; d++ )
+			{
+				const int difference = abs( pi[d] - pj[d] );
+				maxDifference = difference > maxDifference ? difference : maxDifference;
+				sumDifference += difference;
+			}
+			if ( maxDifference == 1 )
+				this->adjacency26[i] |= 1u << j;
+			if ( sumDifference == 1 )
+				this->adjacency6[i] |= 1u << j;
+		}
+		// at least one coordinate equal to the center's
+		if ( pi[0] == 1 || pi[1] == 1 || pi[2] == 1 )
+			this->n18 |= 1u << i;
+	}
+	this->n18 &= ~( 1u << 13 );
 }
 
 //--------------------------------------------------
@@ -47,45 +78,13 @@ MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelTy
 {
 }
 
-//An object pixel belongs to the boundary if its 27* neighborhood contains at least one foreground pixel.
+//An object pixel belongs to the boundary if its 27* neighborhood contains at least one background pixel.
 //--------------------------------------------------
 template< class TInputImage, class TAverageOutwardFluxPixelType, class TOutputPixelType>
-bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::IsBoundary(OutputIndexType p )
+bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::IsBoundary( ConfigurationType c ) const
   //--------------------------------------------------
 {
-	try
-	{
-		bool IsBoundary = false;
-		typename OutputNeighborhoodIteratorType::RadiusType radius;
-		radius.Fill(1);
-		OutputNeighborhoodIteratorType nit( radius, this->skeleton, this->skeleton->GetRequestedRegion() );
-
-		OutputBCType cbc;
-		nit.OverrideBoundaryCondition(&cbc);
-
-		nit.SetLocation(p);
-
-		if ( nit.GetCenterPixel() == 1 )
-		{
-			for( int i = 0; i < nit.Size() && !IsBoundary; i++ )
-			{
-				if ( nit.GetPixel( i ) == 0 )
-				{
-					IsBoundary = true;
-				}
-			}
-		}
-
-		return IsBoundary;
-	}
-	catch ( itk::ExceptionObject &err )
-	{
-		throw err;
-	}
-	catch (...)
-	{
-		itkExceptionMacro( << "MedialCurveImageFilter::IsBoundary() - Unexpected error!" << std::endl );
-	}
+	return ( c & ( 1u << 13 ) ) && ( c != ( 1u << 27 ) - 1 );
 }
 
 //An object pixel is simple for the object's topology if its deletion from the object does not change the
@@ -95,128 +94,43 @@ bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPi
 //object pixels-1 the local topology does not change and, therefore, the pixel is simple for the object.
 //--------------------------------------------------
 template< class TInputImage, class TAverageOutwardFluxPixelType, class TOutputPixelType>
-bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::IsIntSimple( OutputIndexType p )
+bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::IsIntSimple( ConfigurationType c ) const
 //--------------------------------------------------
 {
-	try
-	{
-		// Compute new index of the auxiliar queued image
-		OutputIndexType start;
-
-		for ( int i = 0; i < TOutputImage::ImageDimension; i++ )
-		{
-			start[i] = p[i]-1;
-		}
-		this->region.SetIndex( start );
-		this->auxQueued->SetRegions( region );
-
-		typename OutputNeighborhoodIteratorType::RadiusType radius;
-		radius.Fill(1);
-		OutputNeighborhoodIteratorType nit( radius, this->skeleton, this->skeleton->GetRequestedRegion());
-		radius.Fill(0);
-		OutputNeighborhoodIteratorType qnit( radius, this->auxQueued, this->auxQueued->GetRequestedRegion());
-
-		OutputBCType cbc;
-		nit.OverrideBoundaryCondition(&cbc);
-
-		nit.SetLocation(p);
-
-		int in = 0;
-		for ( int i = 0; i < nit.Size(); i++ )
-		{
-			if ( nit.GetPixel( i ) == 1 )
-				in++;
-		}
+	const ConfigurationType center = 1u << 13;
 
-		if( in == 1 || in == pow((float)3,(int)TInputImage::ImageDimension) )
-		{ // p is isolated or an interior point and therefore, not simple
-			return false;
-		}
-		else
-		{
-			//Flood-fill
-
-			typename TOutputImage::PixelType priority=0;
-			HeapType heap;
-			Pixel node;
-
-			OutputIteratorType aux( this->auxQueued , this->auxQueued->GetRequestedRegion() );
-
-			for ( aux.GoToBegin(); !aux.IsAtEnd(); ++aux )
-					aux.Set( 0 );
+	int in = 0;
+	for ( ConfigurationType m = c; m; m &= m - 1 )
+		in++;
 
-			qnit.SetLocation( nit.GetIndex() );
-			qnit.SetCenterPixel( 1 );
-
-			OutputIndexType q;
-
-			for( int i = 0; i < nit.Size(); i++ )
-			{
-				if ( nit.GetPixel( i ) == 1 )
-				{
-					//object pixel
-					qnit.SetLocation( nit.GetIndex( i ) );
-					if( qnit.GetCenterPixel() == 0 )
-
-					{
-						// not queued
-						node.SetIndex( nit.GetIndex( i ) );
-						node.SetValue( priority++ );
-						heap.push( node );
-
-						qnit.SetCenterPixel( 1 );
-						i = nit.Size();
-					}
-				}
-			}
-
-			//Just inserted the first found object pixel in N26*
-
-			while( !heap.empty() )
-			{
-				node = heap.top();
-				heap.pop();
+	if( in == 1 || in == 27 )
+	{ // p is isolated or an interior point and therefore, not simple
+		return false;
+	}
 
-				nit.SetLocation( node.GetIndex() );
+	//Flood-fill from the first object neighbor
+	const ConfigurationType object = c & ~center;
+	ConfigurationType front = object & ( ~object + 1 );
+	ConfigurationType queued = center | front;
+	int flooded = 1;
 
-				for( int i = 0; i < nit.Size(); i++ )
-				{
-					if( nit.GetPixel( i ) == 1 )
-					{
-						//object pixel
-						q = nit.GetIndex( i );
-						qnit.SetLocation( q );
-						bool cond = true;
-						for (unsigned int d = 0; d < TInputImage::ImageDimension && cond; d++) 
-						{
-							cond = cond && (abs( p[d] - q[d] ) <= 1);
-						}
-						if ( ( cond ) && qnit.GetCenterPixel() == 0 )
-						{
-							// 26* neighborhood - not queued
-							node.SetIndex( q );
-							node.SetValue( priority++ );
-							heap.push( node );
-							qnit.SetCenterPixel( 1 );
-						}
-					}
-				}
-			}
-
-			if ( priority == in-1 )
-				return true;
-			else
-				return false;
-		}
-	}
-	catch ( itk::ExceptionObject &err )
-	{
-		throw err;
-	}
-	catch (...)
+	while ( front )
 	{
-		itkExceptionMacro( << "MedialCurveImageFilter::IsIntSimple() - Unexpected error!" << std::endl );
+		const ConfigurationType bit = front & ( ~front + 1 );
+		front &= ~bit;
+
+		int i = 0;
+		while ( !( bit & ( 1u << i ) ) )
+			i++;
+
+		const ConfigurationType next = this->adjacency26[i] & object & ~queued;
+		queued |= next;
+		front |= next;
+		for ( ConfigurationType m = next; m; m &= m - 1 )
+			flooded++;
 	}
+
+	return flooded == in-1;
 }
 
 //An object pixel is simple for the background's topology if its deletion from the object does not
@@ -227,266 +141,126 @@ bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPi
 //does not change and, therefore, the pixel is simple for the background.
 //--------------------------------------------------
 template< class TInputImage, class TAverageOutwardFluxPixelType, class TOutputPixelType> 
-bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::IsExtSimple( OutputIndexType p )
+bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::IsExtSimple( ConfigurationType c ) const
 //--------------------------------------------------
 {
-	try
-	{
-		// Compute new index of the auxiliar queued image
-		OutputIndexType start;
-
-		for ( int i = 0; i < TOutputImage::ImageDimension; i++ )
-		{
-			start[i] = p[i]-1;
-		}
-		this->region.SetIndex( start );
-
-		this->auxQueued->SetRegions( region );
-
-
-		typename OutputNeighborhoodIteratorType::RadiusType radius;
-		radius.Fill(1);
-		OutputNeighborhoodIteratorType nit(radius, this->skeleton, this->skeleton->GetRequestedRegion());
-		radius.Fill(0);
-		OutputNeighborhoodIteratorType qnit(radius, this->auxQueued, this->auxQueued->GetRequestedRegion());
+	const ConfigurationType center = 1u << 13;
+	const ConfigurationType background = ~c & this->n18;
 
-		OutputBCType cbc;
-		nit.OverrideBoundaryCondition(&cbc);
+	// Background pixels of N18 6 connected to p
+	ConfigurationType front = center;
+	ConfigurationType queued = center;
+	int out = 1;
 
-		nit.SetLocation(p);
-
-		int out = 0;
-
-		OutputIndexType q,r;
-		OutputPixelType priority=0;
-		HeapType heap;
-
-		Pixel node;
-
-		OutputIteratorType aux( this->auxQueued , this->auxQueued->GetRequestedRegion() );
-
-		for ( aux.GoToBegin(); !aux.IsAtEnd(); ++aux )
-				aux.Set( 0 );
-
-		out = 0;
-		node.SetIndex( p );
-		node.SetValue( out++ );
-		heap.push( node );
-
-		qnit.SetLocation( p );
-		qnit.SetCenterPixel( 1 );
+	for ( int pass = 0; pass < 2; pass++ )
+	{
+		int flooded = pass == 0 ? 1 : 0;
 
-		while ( !heap.empty() )
+		if ( pass == 1 )
 		{
-			node = heap.top();
-			heap.pop();
-			r = node.GetIndex();
-			nit.SetLocation( r );
+			if ( out == 18 )
+				return false;
 
-			for( int i = 0; i < nit.Size(); i++ )
-			{
-				if ( nit.GetPixel( i ) == 0 )
-				{
-					q = nit.GetIndex( i );
-					qnit.SetLocation( q );
-					bool cond1 = true;
-					bool cond2 = false;
-					for (unsigned int d = 0; d < TInputImage::ImageDimension && cond1; d++) 
-					{
-						cond1 = cond1 && (abs( p[d] - q[d] ) <= 1);
-					}
-					for (unsigned int d = 0; d < TInputImage::ImageDimension && !cond2; d++) 
-					{
-						cond2 = cond2 || (p[d] - q[d] == 0);
-					}
-
-					if ( ( cond1 ) && ( cond2 ) )
-					{
-						bool cond3 = false;
-						for (unsigned int d = 0; d < TInputImage::ImageDimension && !cond3; d++) 
-						{
-							cond3 = cond3 || ( r[d] - q[d] == 0 && r[(d+1)%(TInputImage::ImageDimension)] - q[(d+1)%(TInputImage::ImageDimension)] == 0 );
-						}
-						//18 neighbor of p
-						if ( cond3 )
-						{
-							//6 connected to r
-							if ( qnit.GetCenterPixel() == 0 )
-							{
-								node.SetIndex( q );
-								node.SetValue( out++ );
-								heap.push( node );
-								qnit.SetCenterPixel( 1 );
-							}
-						}
-					}
-				}
-			}
+			// Flood-fill from the first background 6 neighbor, without going through p
+			const ConfigurationType first = this->adjacency6[13] & background;
+			front = first & ( ~first + 1 );
+			queued = center | front;
+			flooded = front ? 1 : 0;
 		}
 
-		if ( out == 0 || out == 18 )
-			return false;
-		else
+		while ( front )
 		{
+			const ConfigurationType bit = front & ( ~front + 1 );
+			front &= ~bit;
+
+			int i = 0;
+			while ( !( bit & ( 1u << i ) ) )
+				i++;
+
+			const ConfigurationType next = this->adjacency6[i] & background & ~queued;
+			queued |= next;
+			front |= next;
+			for ( ConfigurationType m = next; m; m &= m - 1 )
+				flooded++;
+		}
 
-			//Flood-fill
-
-			nit.SetLocation(p);
-
-			for ( aux.GoToBegin(); !aux.IsAtEnd(); ++aux )
-					aux.Set( 0 );
-
-			qnit.SetLocation( p );
-			qnit.SetCenterPixel( 1 );
-
-			for ( int i = 0; i < nit.Size(); i++ )
-			{
-				if ( nit.GetPixel( i ) == 0 )
-				{
-					//background pixel
-					q = nit.GetIndex( i );
-					qnit.SetLocation( q );
-					bool cond1 = true;
-					bool cond2 = false;
-					for (unsigned int d = 0; d < TInputImage::ImageDimension && cond1; d++) 
-					{
-						cond1 = cond1 && (abs( p[d] - q[d] ) <= 1);
-					}
-					for (unsigned int d = 0; d < TInputImage::ImageDimension && !cond2; d++) 
-					{
-						cond2 = cond2 || (p[d] - q[d] == 0);
-					}
-
-					if ( ( cond1 ) && ( cond2 ) )
-					{
-						bool cond3 = false;
-						for (unsigned int d = 0; d < TInputImage::ImageDimension && !cond3; d++) 
-						{
-							cond3 = cond3 || ( p[d] - q[d] == 0 && p[(d+1)%(TInputImage::ImageDimension)] - q[(d+1)%(TInputImage::ImageDimension)] == 0 );
-						}
-						//18 neighbor of p
-						if ( cond3 )
-						{
-							//6 connected to p
-							if ( qnit.GetCenterPixel() == 0 )
-							{
-								// not queued
-								node.SetIndex( q );
-								node.SetValue( priority++ );
-								heap.push( node );
-
-								qnit.SetCenterPixel( 1 );
-								i = nit.Size();
-							}
-						}
-					}
-				}
-			}
+		if ( pass == 0 )
+			out = flooded;
+		else
+			return flooded == out-1;
+	}
 
-			//Just inserted the first found background pixel in N18
-	    
-			while( !heap.empty() )
-			{
-				node = heap.top();
-				heap.pop();
-				r = node.GetIndex();
-				nit.SetLocation( r );
+	return false;
+}
 
-				for( int i = 0; i < nit.Size(); i++ )
-				{
-					if ( nit.GetPixel( i ) == 0 )
-					{
-						q = nit.GetIndex( i );
-						qnit.SetLocation( q );
-						bool cond1 = true;
-						bool cond2 = false;
-						for (unsigned int d = 0; d < TInputImage::ImageDimension && cond1; d++) 
-						{
-							cond1 = cond1 && (abs( p[d] - q[d] ) <= 1);
-						}
-						for (unsigned int d = 0; d < TInputImage::ImageDimension && !cond2; d++) 
-						{
-							cond2 = cond2 || (p[d] - q[d] == 0);
-						}
-
-						if ( ( cond1 ) && ( cond2 ) )
-						{
-						bool cond3 = false;
-						for (unsigned int d = 0; d < TInputImage::ImageDimension && !cond3; d++) 
-						{
-							cond3 = cond3 || ( r[d] - q[d] == 0 && r[(d+1)%(TInputImage::ImageDimension)] - q[(d+1)%(TInputImage::ImageDimension)] == 0 );
-						}
-						//18 neighbor of r
-						if ( cond3 )
-							{
-								//6 connected
-								if ( qnit.GetCenterPixel() == 0 )
-								{
-									node.SetIndex( q );
-									node.SetValue( priority++ );
-									heap.push( node );
-									qnit.SetCenterPixel( 1 );
-								}
-							}
-						}
-					}
-				}
-			}
+//Simple for both the object and the background. The result only depends on the 26 neighbors, and
+//it is cached in a table with two bits per configuration.
+//--------------------------------------------------
+template< class TInputImage, class TAverageOutwardFluxPixelType, class TOutputPixelType> 
+bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::IsSimple( ConfigurationType c )
+//--------------------------------------------------
+{
+	const ConfigurationType key = ( c & 0x1FFFu ) | ( ( c >> 14 ) << 13 );
+	unsigned char &entry = this->simpleTable[key >> 2];
+	const unsigned int shift = 2 * ( key & 3u );
+	unsigned int state = ( entry >> shift ) & 3u;
 
-			if( priority == out-1 )
-				return true;
-			else
-				return false;
-		}
-	}
-	catch ( itk::ExceptionObject &err )
+	if ( state == 0 )
 	{
-		throw err;
-	}
-	catch (...)
-	{
-		itkExceptionMacro( << "MedialCurveImageFilter::IsExtSimple() - Unexpected error!" << std::endl );
+		const ConfigurationType object = c | ( 1u << 13 );
+		state = ( this->IsIntSimple( object ) && this->IsExtSimple( object ) ) ? 2u : 1u;
+		entry |= static_cast<unsigned char>( state << shift );
 	}
+
+	return state == 2;
 }
 
 //p is a medial axis end point if in 26* there is only one foreground points
 //--------------------------------------------------
 template< class TInputImage, class TAverageOutwardFluxPixelType, class TOutputPixelType>
-bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::IsEnd( OutputIndexType p )
+bool MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::IsEnd( ConfigurationType c ) const
 //--------------------------------------------------
 {
-	try
-	{
-		typename OutputNeighborhoodIteratorType::RadiusType radius;
-		radius.Fill(1);
-		OutputNeighborhoodIteratorType nit(radius, this->skeleton, this->skeleton->GetRequestedRegion());
+	int n = 0;
+	for ( ConfigurationType m = c & ~( 1u << 13 ); m; m &= m - 1 )
+		n++;
 
-		OutputBCType cbc;
-		nit.OverrideBoundaryCondition(&cbc);
-
-		nit.SetLocation(p);
+	return n < 2;
+}
 
-		int n=0;
+//Skeleton values of the 3x3x3 neighborhood, pixels outside the image are background.
+//--------------------------------------------------
+template< class TInputImage, class TAverageOutwardFluxPixelType, class TOutputPixelType>
+typename MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::ConfigurationType
+MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::GetConfiguration( OffsetValueType offset, const OffsetValueType index[3] ) const
+//--------------------------------------------------
+{
+	const OutputPixelType *sk = this->skeleton->GetBufferPointer() + offset;
+	ConfigurationType c = 0;
 
-		for( int i = 0; i < nit.Size(); i++ )
+	if ( index[0] > 0 && index[0] < this->size[0]-1 &&
+	     index[1] > 0 && index[1] < this->size[1]-1 &&
+	     index[2] > 0 && index[2] < this->size[2]-1 )
+	{
+		for ( int i = 0; i < 27; i++ )
 		{
-			if ( nit.GetIndex() != nit.GetIndex( i ) && nit.GetPixel( i ) == 1 ) //Belonging to the object - 26* connected
-				n++;
+			if ( sk[ this->offsets[i] ] == 1 )
+				c |= 1u << i;
 		}
-
-		if ( n < 2 )
-			return true;
-		else
-			return false;
-	}
-	catch ( itk::ExceptionObject &err )
-	{
-		throw err;
+		return c;
 	}
-	catch (...)
+
+	for ( int i = 0; i < 27; i++ )
 	{
-		itkExceptionMacro( << "MedialCurveImageFilter::IsEnd() - Unexpected error!" << std::endl );
+		const OffsetValueType q[3] = { index[0] + i % 3 - 1, index[1] + ( i / 3 ) % 3 - 1, index[2] + i / 9 - 1 };
+		if ( q[0] < 0 || q[0] >= this->size[0] ||
+		     q[1] < 0 || q[1] >= this->size[1] ||
+		     q[2] < 0 || q[2] >= this->size[2] )
+			continue;
+		if ( sk[ this->offsets[i] ] == 1 )
+			c |= 1u << i;
 	}
+	return c;
 }
 
 //Computation o the binary image representing the object from its implicit representation.
@@ -495,26 +269,13 @@ template< class TInputImage, class TAverageOutwardFluxPixelType, class TOutputPi
 void MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::DistanceToObject()
 //--------------------------------------------------
 {
-	try
-	{
-		InputConstIteratorType dit(this->distance, this->distance->GetRequestedRegion());
-		OutputIteratorType skit(this->skeleton, this->skeleton->GetRequestedRegion());
+	const InputPixelType *d = this->distance->GetBufferPointer();
+	OutputPixelType *sk = this->skeleton->GetBufferPointer();
+	const SizeValueType n = this->distance->GetBufferedRegion().GetNumberOfPixels();
 
-		for ( dit.GoToBegin(), skit.GoToBegin(); !skit.IsAtEnd(); ++dit, ++skit )
-		{
-			if ( dit.Get() <= 0.0 )
-				skit.Set( 1 );
-			else
-				skit.Set( 0 );
-		}
-	}
-	catch ( itk::ExceptionObject &err )
+	for ( SizeValueType i = 0; i < n; i++ )
 	{
-		throw err;
-	}
-	catch (...)
-	{
-		itkExceptionMacro( << "MedialCurveImageFilter::DistanceToObject() - Unexpected error!" << std::endl );
+		sk[i] = d[i] <= 0.0 ? 1 : 0;
 	}
 }
 
@@ -523,152 +284,167 @@ template< class TInputImage, class TAverageOutwardFluxPixelType, class TOutputPi
 void MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPixelType>::GenerateData()
 //--------------------------------------------------
 {
-	try
+	this->distance = dynamic_cast<const TInputImage  *>( ProcessObject::GetInput(0) );
+	this->aof = dynamic_cast<const TAverageOutwardFluxFImage  *>( ProcessObject::GetInput(1) );
+
+	if ( !this->distance || !this->aof )
 	{
-		this->distance = dynamic_cast<const TInputImage  *>( ProcessObject::GetInput(0) );
-		this->aof = dynamic_cast<const TInputImage  *>( ProcessObject::GetInput(1) );
+		itkExceptionMacro( << "MedialCurveImageFilter::GenerateData() - Distance and average outward flux images are required." );
+	}
 
-		this->skeleton = dynamic_cast< TOutputImage * >(  this->ProcessObject::GetOutput(0) );
+	const OutputRegionType bufferedRegion = this->distance->GetBufferedRegion();
+	if ( this->aof->GetBufferedRegion() != bufferedRegion )
+	{
+		itkExceptionMacro( << "MedialCurveImageFilter::GenerateData() - Distance and average outward flux images must have the same buffered region." );
+	}
 
-		// Create the region of the auxuliar queued image
-		OutputSizeType size;
-		OutputIndexType start;
+	this->skeleton = dynamic_cast< TOutputImage * >(  this->ProcessObject::GetOutput(0) );
 
-		for ( int i = 0; i < TOutputImage::ImageDimension; i++ )
-		{
-			start[i]=0;
-			size[i]=3;
-		}
-		this->region.SetIndex( start );
-		this->region.SetSize( size );
-
-		this->skeleton->SetSpacing( this->distance->GetSpacing() );
-		this->skeleton->SetOrigin( this->distance->GetOrigin() );
-		this->skeleton->SetRegions( this->distance->GetRequestedRegion() );
-		this->skeleton->Allocate();
-
-		this->queued = TOutputImage::New();
-		this->queued->SetSpacing( this->distance->GetSpacing() );
-		this->queued->SetOrigin( this->distance->GetOrigin() );
-		this->queued->SetRegions( this->distance->GetRequestedRegion() );
-		this->queued->Allocate();
-
-		this->auxQueued = TOutputImage::New();
-		this->auxQueued->SetSpacing( this->distance->GetSpacing() );
-		this->auxQueued->SetOrigin( this->distance->GetOrigin() );
-		this->auxQueued->SetRegions( region );
-		this->auxQueued->Allocate();
-
-		// Initialization of binary object
-		this->DistanceToObject();
-
-		// Topological prunning
-
-		//Iterators
-		InputConstIteratorType dit( this->distance, this->distance->GetRequestedRegion() );
-		OutputIteratorType skit( this->skeleton, this->skeleton->GetRequestedRegion() );
-		OutputIteratorType qit( this->queued, this->queued->GetRequestedRegion() );
-
-		typename OutputNeighborhoodIteratorType::RadiusType radius;
-		radius.Fill(1);
-		InputConstNeighborhoodIteratorType dnit( radius, this->distance, this->distance->GetRequestedRegion() );
-		radius.Fill(0);
-		AOFConstNeighborhoodIteratorType aofnit( radius, this->aof, this->aof->GetRequestedRegion() );
-		radius.Fill(1);
-		OutputNeighborhoodIteratorType sknit( radius, this->skeleton, this->skeleton->GetRequestedRegion() );
-		radius.Fill(1);
-		OutputNeighborhoodIteratorType qnit( radius, this->queued, this->queued->GetRequestedRegion() );
-
-		//First step...
-		InputIndexType q;
-		InputPixelType priority=0;
-		HeapType heap;
-		Pixel node;
-
-		for ( skit.GoToBegin(), dit.GoToBegin(), qit.GoToBegin(); !skit.IsAtEnd() && !dit.IsAtEnd() && !qit.IsAtEnd(); ++skit, ++dit, ++qit )
+	this->skeleton->SetSpacing( this->distance->GetSpacing() );
+	this->skeleton->SetOrigin( this->distance->GetOrigin() );
+	this->skeleton->SetDirection( this->distance->GetDirection() );
+	this->skeleton->SetRegions( bufferedRegion );
+	this->skeleton->Allocate();
+
+	for ( int d = 0; d < 3; d++ )
+	{
+		this->size[d] = bufferedRegion.GetSize()[d];
+	}
+	this->strides[0] = 1;
+	this->strides[1] = this->size[0];
+	this->strides[2] = this->size[0] * this->size[1];
+	for ( int i = 0; i < 27; i++ )
+	{
+		this->offsets[i] = ( i % 3 - 1 ) * this->strides[0] + ( ( i / 3 ) % 3 - 1 ) * this->strides[1] + ( i / 9 - 1 ) * this->strides[2];
+	}
+
+	this->simpleTable.assign( ( 1u << 26 ) / 4, 0 );
+
+	// Initialization of binary object
+	this->DistanceToObject();
+
+	const InputPixelType *dist = this->distance->GetBufferPointer();
+	const TAverageOutwardFluxPixelType *flux = this->aof->GetBufferPointer();
+	OutputPixelType *sk = this->skeleton->GetBufferPointer();
+	const OffsetValueType numberOfPixels = this->strides[2] * this->size[2];
+
+	std::vector<unsigned char> queued( numberOfPixels, 0 );
+
+	// Topological prunning
+
+	// Buckets of the quantized depth -distance, shallowest first
+	double bucketWidth = this->m_BucketWidth;
+	if ( bucketWidth <= 0.0 )
+	{
+		const typename TInputImage::SpacingType spacing = this->distance->GetSpacing();
+		bucketWidth = std::min( spacing[0], std::min( spacing[1], spacing[2] ) ) / 64.0;
+	}
+
+	double maxDepth = 0.0;
+	for ( OffsetValueType o = 0; o < numberOfPixels; o++ )
+	{
+		if ( sk[o] == 1 && -dist[o] > maxDepth )
+			maxDepth = -dist[o];
+	}
+
+	const OffsetValueType maxNumberOfBuckets = 1 << 20;
+	if ( maxDepth / bucketWidth >= maxNumberOfBuckets )
+	{
+		bucketWidth = maxDepth / ( maxNumberOfBuckets - 1 );
+	}
+	const OffsetValueType numberOfBuckets = static_cast<OffsetValueType>( maxDepth / bucketWidth ) + 1;
+
+	std::vector< std::vector<OffsetValueType> > buckets( numberOfBuckets );
+	std::vector< size_t > heads( numberOfBuckets, 0 );
+	OffsetValueType currentBucket = numberOfBuckets;
+	SizeValueType numberOfQueued = 0;
+
+	//First step...
+	OffsetValueType index[3];
+
+	for ( index[2] = 0; index[2] < this->size[2]; index[2]++ )
+	{
+		for ( index[1] = 0; index[1] < this->size[1]; index[1]++ )
 		{
-			q = skit.GetIndex();
-			if ( this->IsBoundary( q ) )
+			for ( index[0] = 0; index[0] < this->size[0]; index[0]++ )
 			{
-				if ( IsIntSimple( q ) && IsExtSimple( q ) )
+				const OffsetValueType o = index[0] + index[1] * this->strides[1] + index[2] * this->strides[2];
+				if ( sk[o] != 1 )
+					continue;
+
+				const ConfigurationType c = this->GetConfiguration( o, index );
+				if ( this->IsBoundary( c ) && this->IsSimple( c ) )
 				{
 					//Simple pixel
-					node.SetIndex( q );
-					priority = dit.Get();
-   					node.SetValue( -priority );
- 					heap.push( node );
-					qit.Set( 1 );
+					OffsetValueType b = static_cast<OffsetValueType>( -dist[o] / bucketWidth );
+					b = b < 0 ? 0 : ( b >= numberOfBuckets ? numberOfBuckets-1 : b );
+					buckets[b].push_back( o );
+					currentBucket = b < currentBucket ? b : currentBucket;
+					numberOfQueued++;
+					queued[o] = 1;
 				}
-				else qit.Set( 0 );
 			}
-			else qit.Set( 0 );
 		}
+	}
 
-		//Second step 
+	//Second step 
 
-		InputIndexType r;
+	while ( numberOfQueued > 0 )
+	{
+		while ( heads[currentBucket] == buckets[currentBucket].size() )
+		{
+			buckets[currentBucket].clear();
+			heads[currentBucket] = 0;
+			currentBucket++;
+		}
 
-		while ( !heap.empty() )
+		const OffsetValueType q = buckets[currentBucket][ heads[currentBucket]++ ];
+		numberOfQueued--;
+		queued[q] = 0;
+
+		index[2] = q / this->strides[2];
+		index[1] = ( q - index[2] * this->strides[2] ) / this->strides[1];
+		index[0] = q - index[2] * this->strides[2] - index[1] * this->strides[1];
+
+		const ConfigurationType c = this->GetConfiguration( q, index );
+
+		if ( !this->IsSimple( c ) )
+			continue;
+
+		if ( ( flux[q] < this->m_Threshold ) && ( this->IsEnd( c ) ) )
 		{
+			// Is medial
+			continue;
+		}
 
-		node=heap.top();
-			heap.pop();
+		sk[q] = 0; //Deletion from object
 
-			q = node.GetIndex();
+		// Object neighbors outside the image are never set in the configuration
+		for ( int i = 0; i < 27; i++ )
+		{
+			if ( i == 13 || !( c & ( 1u << i ) ) )
+				continue;
 
-			qnit.SetLocation( q );
-			qnit.SetCenterPixel( 0 );
+			const OffsetValueType r = q + this->offsets[i];
+			if ( queued[r] )
+				continue;
 
-			if ( IsIntSimple( q ) && IsExtSimple( q ) )
+			//Not queued pixel
+			const OffsetValueType rindex[3] = { index[0] + i % 3 - 1, index[1] + ( i / 3 ) % 3 - 1, index[2] + i / 9 - 1 };
+			if ( this->IsSimple( this->GetConfiguration( r, rindex ) ) )
 			{
-				aofnit.SetLocation(q);
-				if ( ( aofnit.GetCenterPixel() < this->m_Threshold ) && ( IsEnd( q ) ) )
-				{
-					//std::cout<<q<<" Is medial "<<aofnit.GetCenterPixel()<<std::endl;
-				}
-				else
-				{
-					//std::cout<<q<<" Is deleted"<<std::endl;
-					sknit.SetLocation( q );
-					sknit.SetCenterPixel( 0 ); //Deletion from object
-					dnit.SetLocation( q );
-
-					// Este iterador de nh se sale fuera de la imagen, pero como tenemos la
-					// boundary condition a cero, al pedir por un pixel de fuera nos
-					// devuelve 0 y no haremos nada
-					// En queued por lo tanto tampoco escribiremos fuera de rango
-					for ( int i = 0; i < sknit.Size(); i++ )
-					{
-						if ( sknit.GetPixel( i ) == 1 )
-						{
-							//Object pixel
-							r = sknit.GetIndex( i );
-							if ( qnit.GetPixel( i ) == 0 )
-							{
-								//Not queued pixel
-								if ( IsIntSimple( r ) && IsExtSimple( r ) )
-								{
-									priority = dnit.GetPixel( i );
-									node.SetIndex( r );
-									node.SetValue( -priority );
-									heap.push( node );
-									qnit.SetPixel( i, 1 ); 
-								}
-							}
-						}
-					}
-				}
+				OffsetValueType b = static_cast<OffsetValueType>( -dist[r] / bucketWidth );
+				b = b < 0 ? 0 : ( b >= numberOfBuckets ? numberOfBuckets-1 : b );
+				buckets[b].push_back( r );
+				currentBucket = b < currentBucket ? b : currentBucket;
+				numberOfQueued++;
+				queued[r] = 1;
 			}
 		}
 	}
-	catch ( itk::ExceptionObject &err )
-	{
-		throw err;
-	}
-	catch (...)
-	{
-		itkExceptionMacro( << "MedialCurveImageFilter::GenerateData() - Unexpected error!" << std::endl );
-	}
+
+	this->simpleTable.clear();
+	std::vector<unsigned char>().swap( this->simpleTable );
 }
 
 /**
@@ -682,5 +458,6 @@ void MedialCurveImageFilter<TInputImage, TAverageOutwardFluxPixelType, TOutputPi
   
   os << indent << "Medial Curve." << std::endl;
   os << indent << "Threshold         : " << m_Threshold << std::endl;
+  os << indent << "BucketWidth       : " << m_BucketWidth << std::endl;
 }
 
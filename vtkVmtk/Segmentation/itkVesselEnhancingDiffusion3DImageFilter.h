@@ -11,6 +11,7 @@
 #define __itkVesselEnhancingDiffusion3DImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include "itkSymmetricSecondRankTensor.h"
 #include <vector>
 
 namespace itk
@@ -43,13 +44,17 @@ namespace itk
  *   on vnl datatypes and its eigensystem calculations
  * - note: most of computation time is spent at calculation of vesselness
  *   response
+ * - vesselness, diffusion tensor and diffusion passes are split over the
+ *   output region and run on the filter's threads; the diffusion update
+ *   works directly on the image buffers, with precomputed stencil offsets
+ *   for interior voxels and clamped (zero flux) offsets on the boundary.
+ *   The current and next iterates are swapped instead of copied.
  *
  * - PixelType      short, 3D
  *   Precision      float, 3D
  *
  *
  * - todo
- *   - using parallelism/threading eg over scales
  *   - completely itk-fying, eg eigenvalues calculation
  *   - possibly embedding within itk-diffusion framework
  *   - itk expert to have a look at use of iterators
@@ -78,6 +83,9 @@ public:
     typedef ImageToImageFilter<ImageType,ImageType>         Superclass;
     typedef SmartPointer<Self>                              Pointer;
     typedef SmartPointer<const Self>                        ConstPointer;
+    typedef typename ImageType::RegionType                  RegionType;
+    typedef SymmetricSecondRankTensor<double,Dimension>     HessianPixelType;
+    typedef Image<HessianPixelType,Dimension>               HessianImageType;
 
     itkNewMacro(Self);
     itkTypeMacro(VesselEnhancingDiffusion3DImageFilter, ImageToImageFilter);
@@ -132,6 +140,8 @@ protected:
     VesselEnhancingDiffusion3DImageFilter();
     ~VesselEnhancingDiffusion3DImageFilter() {};
     void PrintSelf(std::ostream &os, Indent indent) const ITK_OVERRIDE;
+    void GenerateInputRequestedRegion() ITK_OVERRIDE;
+    void EnlargeOutputRequestedRegion(DataObject *) ITK_OVERRIDE;
     void GenerateData() ITK_OVERRIDE;
 
 private: 
@@ -154,6 +164,10 @@ private:
 
     unsigned int                    m_CurrentIteration;
 
+    // current and next iterate, swapped after each iteration
+    typename PrecisionImageType::Pointer m_Current;
+    typename PrecisionImageType::Pointer m_Next;
+
     // current hessian for which we have max vesselresponse
     typename PrecisionImageType::Pointer m_Dxx;
     typename PrecisionImageType::Pointer m_Dxy;
@@ -162,24 +176,54 @@ private:
     typename PrecisionImageType::Pointer m_Dyz;
     typename PrecisionImageType::Pointer m_Dzz;
 
-    void VED3DSingleIteration (typename ImageType::Pointer );
+    // max vesselness and hessian at the scale being processed
+    typename PrecisionImageType::Pointer m_Vesselness;
+    typename HessianImageType::Pointer   m_Hessian;
+
+    enum
+    {
+        VESSELNESS_PASS,
+        TENSOR_PASS,
+        DIFFUSION_PASS
+    };
+
+    struct VEDThreadStruct
+    {
+        VesselEnhancingDiffusion3DImageFilter *Filter;
+        int Pass;
+    };
+
+    void VED3DSingleIteration ();
 
     // Calculates maxvessel response of the range
     // of scales and stores the hessian of each voxel
     // into the member images m_Dij. 
-    void MaxVesselResponse (const typename ImageType::Pointer);
+    void MaxVesselResponse ();
 
     // calculates diffusion tensor
     // based on current values of hessian (for which we have
     // maximim vessel response). 
     void DiffusionTensor();
 
+    // runs one of the passes above over the output region
+    // split among threads
+    void ThreadedPass (int pass);
+    static ITK_THREAD_RETURN_TYPE ThreaderCallback (void *arg);
+
+    void ThreadedMaxVesselResponse (const RegionType &);
+    void ThreadedDiffusionTensor (const RegionType &);
+    void ThreadedDiffusionUpdate (const RegionType &);
+
+    typename PrecisionImageType::Pointer AllocatePrecisionImage (const PrecisionImageType *) const;
+
     inline Precision VesselnessFunction3D ( // sorted magn increasing
             const Precision,    // l1
             const Precision,    // l2
             const Precision     // l3
             );
 
+    // vesselness of the hessian (xx, xy, xz, yy, yz, zz)
+    inline Precision HessianVesselness (const double *);
 
 };
 
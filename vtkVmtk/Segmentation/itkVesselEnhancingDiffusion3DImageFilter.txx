@@ -12,19 +12,18 @@
 #include "itkVesselEnhancingDiffusion3DImageFilter.h"
 
 #include "itkCastImageFilter.h"
-#include "itkConstShapedNeighborhoodIterator.h"
 #include "itkHessianRecursiveGaussianImageFilter.h"
 #include "itkImageRegionConstIterator.h"
 #include "itkImageRegionIterator.h"
+#include "itkMatrix.h"
 #include "itkMinimumMaximumImageFilter.h"
-#include "itkNeighborhoodAlgorithm.h"
 #include "itkNumericTraits.h"
-#include "itkZeroFluxNeumannBoundaryCondition.h"
+#include "itkSymmetricEigenAnalysis.h"
 
-#include <vnl/vnl_vector.h>
-#include <vnl/vnl_matrix.h>
 #include <vnl/algo/vnl_symmetric_eigensystem.h>
 
+#include <algorithm>
+#include <cmath>
 #include<iostream>
 
 namespace itk
@@ -63,10 +62,105 @@ void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
 	os << indent << "Sensitivity 		        : " << m_Sensitivity << std::endl;
   	os << indent << "DarkObjectLightBackground  : " << m_DarkObjectLightBackground << std::endl;
 }
+// input and output are processed as a whole
+template <class PixelType, unsigned int Dimension>
+void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
+::GenerateInputRequestedRegion()
+{
+    Superclass::GenerateInputRequestedRegion();
+    if (this->GetInput())
+    {
+        typename ImageType::Pointer input = const_cast<ImageType*>(this->GetInput());
+        input->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template <class PixelType, unsigned int Dimension>
+void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
+::EnlargeOutputRequestedRegion(DataObject *output)
+{
+    Superclass::EnlargeOutputRequestedRegion(output);
+    output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+// allocates an image with the same geometry as the reference
+template <class PixelType, unsigned int Dimension>
+typename VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>::PrecisionImageType::Pointer
+VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
+::AllocatePrecisionImage(const PrecisionImageType *reference) const
+{
+    typename PrecisionImageType::Pointer image = PrecisionImageType::New();
+    image->SetOrigin(reference->GetOrigin());
+    image->SetSpacing(reference->GetSpacing());
+    image->SetDirection(reference->GetDirection());
+    image->SetRegions(reference->GetLargestPossibleRegion());
+    image->Allocate();
+    return image;
+}
+
+// runs a pass split over the output region
+template <class PixelType, unsigned int Dimension>
+void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
+::ThreadedPass(int pass)
+{
+    VEDThreadStruct str;
+    str.Filter = this;
+    str.Pass = pass;
+#if ITK_VERSION_MAJOR >= 5
+    this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+#else
+    this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
+#endif
+    this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template <class PixelType, unsigned int Dimension>
+ITK_THREAD_RETURN_TYPE
+VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
+::ThreaderCallback(void *arg)
+{
+#if ITK_VERSION_MAJOR >= 5
+    typedef MultiThreaderBase::WorkUnitInfo ThreadInfoType;
+    const ThreadIdType threadId = ((ThreadInfoType *)(arg))->WorkUnitID;
+    const ThreadIdType threadCount = ((ThreadInfoType *)(arg))->NumberOfWorkUnits;
+#else
+    typedef MultiThreader::ThreadInfoStruct ThreadInfoType;
+    const ThreadIdType threadId = ((ThreadInfoType *)(arg))->ThreadID;
+    const ThreadIdType threadCount = ((ThreadInfoType *)(arg))->NumberOfThreads;
+#endif
+    VEDThreadStruct *str = (VEDThreadStruct *)(((ThreadInfoType *)(arg))->UserData);
+
+    RegionType splitRegion;
+    const ThreadIdType total = str->Filter->SplitRequestedRegion(threadId, threadCount, splitRegion);
+
+    if (threadId < total)
+    {
+        switch (str->Pass)
+        {
+            case VESSELNESS_PASS:
+                str->Filter->ThreadedMaxVesselResponse(splitRegion);
+                break;
+            case TENSOR_PASS:
+                str->Filter->ThreadedDiffusionTensor(splitRegion);
+                break;
+            case DIFFUSION_PASS:
+                str->Filter->ThreadedDiffusionUpdate(splitRegion);
+                break;
+        }
+    }
+
+#if ITK_VERSION_MAJOR >= 5
+    return ITK_THREAD_RETURN_DEFAULT_VALUE;
+#else
+    return ITK_THREAD_RETURN_VALUE;
+#endif
+}
+
 // singleiter
 template <class PixelType, unsigned int Dimension>
 void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
-::VED3DSingleIteration(typename ImageType::Pointer ci)
+::VED3DSingleIteration()
 {
     bool rec(false);
     if ( 
@@ -83,7 +177,7 @@ void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
             std::cout.flush();
             
         }
-        MaxVesselResponse (ci);
+        MaxVesselResponse ();
         DiffusionTensor (); 
     }
     if (m_Verbose)
@@ -95,54 +189,51 @@ void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
         }
     }
 
+    // calculate next = nonlineardiffusion(current)
+    // using 3x3x3 stencil, afterwards swap them
+    ThreadedPass (DIFFUSION_PASS);
+    std::swap (m_Current, m_Next);
 
-    // calculate d = nonlineardiffusion(ci)
-    // using 3x3x3 stencil, afterwards copy
-    // result from d back to ci
-    typename PrecisionImageType::Pointer d = PrecisionImageType::New();
-    d->SetOrigin(ci->GetOrigin());
-    d->SetSpacing(ci->GetSpacing());
-    d->SetDirection(ci->GetDirection());
-    d->SetRegions(ci->GetLargestPossibleRegion());
-    d->Allocate();
-    d->FillBuffer(NumericTraits<Precision>::Zero);
-
-    // shapedneighborhood iter, zeroflux boundary condition
-    // division into faces and inner region
-    typedef ZeroFluxNeumannBoundaryCondition<PrecisionImageType>    BT;
-    typedef ConstShapedNeighborhoodIterator<PrecisionImageType,BT>  NT;
-    typedef typename NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<PrecisionImageType> 
-                                                                    FT; 
-    BT                      b;
-    typename NT::RadiusType r;
-    r.Fill(1);
-
-
-    // offsets
-    const typename NT::OffsetType oxp = {{1,0,0}};
-    const typename NT::OffsetType oxm = {{-1,0,0}};
-    const typename NT::OffsetType oyp = {{0,1,0}};
-    const typename NT::OffsetType oym = {{0,-1,0}};
-    const typename NT::OffsetType ozp = {{0,0,1}};
-    const typename NT::OffsetType ozm = {{0,0,-1}};
-
-    const typename NT::OffsetType oxpyp = {{1,1,0}};
-    const typename NT::OffsetType oxmym = {{-1,-1,0}};
-    const typename NT::OffsetType oxpym = {{1,-1,0}};
-    const typename NT::OffsetType oxmyp = {{-1,1,0}};
-
-    const typename NT::OffsetType oxpzp = {{1,0,1}};
-    const typename NT::OffsetType oxmzm = {{-1,0,-1}};
-    const typename NT::OffsetType oxpzm = {{1,0,-1}};
-    const typename NT::OffsetType oxmzp = {{-1,0,1}};
-
-    const typename NT::OffsetType oypzp = {{0,1,1}};
-    const typename NT::OffsetType oymzm = {{0,-1,-1}};
-    const typename NT::OffsetType oypzm = {{0,1,-1}};
-    const typename NT::OffsetType oymzp = {{0,-1,1}};
+    return;
+} 
+
+// diffusion update of a region
+template <class PixelType, unsigned int Dimension>
+void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
+::ThreadedDiffusionUpdate(const RegionType &region)
+{
+    // stencil, in the order
+    // xp xm yp ym zp zm 
+    // xpyp xmym xpym xmyp
+    // xpzp xmzm xpzm xmzp
+    // ypzp ymzm ypzm ymzp
+    enum 
+    {
+        XP, XM, YP, YM, ZP, ZM,
+        XPYP, XMYM, XPYM, XMYP,
+        XPZP, XMZM, XPZM, XMZP,
+        YPZP, YMZM, YPZM, YMZP,
+        StencilSize
+    };
+
+    const Precision *ci  = m_Current->GetBufferPointer();
+    const Precision *dxx = m_Dxx->GetBufferPointer();
+    const Precision *dxy = m_Dxy->GetBufferPointer();
+    const Precision *dxz = m_Dxz->GetBufferPointer();
+    const Precision *dyy = m_Dyy->GetBufferPointer();
+    const Precision *dyz = m_Dyz->GetBufferPointer();
+    const Precision *dzz = m_Dzz->GetBufferPointer();
+    Precision       *d   = m_Next->GetBufferPointer();
+
+    const RegionType bufferedRegion = m_Current->GetBufferedRegion();
+    const OffsetValueType nx = bufferedRegion.GetSize()[0];
+    const OffsetValueType ny = bufferedRegion.GetSize()[1];
+    const OffsetValueType nz = bufferedRegion.GetSize()[2];
+    const OffsetValueType sy = nx;
+    const OffsetValueType sz = nx * ny;
 
     // fixed weights (timers)
-	const typename PrecisionImageType::SpacingType ispacing = ci->GetSpacing();
+    const typename PrecisionImageType::SpacingType ispacing = m_Current->GetSpacing();
     const Precision rxx = m_TimeStep / (2.0 * ispacing[0] * ispacing[0]);
     const Precision ryy = m_TimeStep / (2.0 * ispacing[1] * ispacing[1]);
     const Precision rzz = m_TimeStep / (2.0 * ispacing[2] * ispacing[2]);
@@ -150,394 +241,212 @@ void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
     const Precision rxz = m_TimeStep / (4.0 * ispacing[0] * ispacing[2]);
     const Precision ryz = m_TimeStep / (4.0 * ispacing[1] * ispacing[2]);
 
-    // faces
-    FT                            fc;
-    typename FT::FaceListType     fci = fc(ci,d->GetLargestPossibleRegion(),r);
-    typename FT::FaceListType     fxx = fc(m_Dxx,d->GetLargestPossibleRegion(),r);
-    typename FT::FaceListType     fxy = fc(m_Dxy,d->GetLargestPossibleRegion(),r);
-    typename FT::FaceListType     fxz = fc(m_Dxz,d->GetLargestPossibleRegion(),r);
-    typename FT::FaceListType     fyy = fc(m_Dyy,d->GetLargestPossibleRegion(),r);
-    typename FT::FaceListType     fyz = fc(m_Dyz,d->GetLargestPossibleRegion(),r);
-    typename FT::FaceListType     fzz = fc(m_Dzz,d->GetLargestPossibleRegion(),r);
-
-    typename FT::FaceListType::iterator fitci,fitxx,fitxy,fitxz,fityy,fityz,fitzz;
-
-    for ( fitci = fci.begin(),
-            fitxx = fxx.begin(), fitxy = fxy.begin(), fitxz = fxz.begin(),
-            fityy = fyy.begin(), fityz = fyz.begin(), fitzz = fzz.begin();
-            fitci != fci.end();
-            ++fitci, ++fitxx, ++fitxy, ++fitxz, ++fityy, ++fityz, ++fitzz)
+    // interior offsets, fixed for the whole image
+    OffsetValueType interior[StencilSize];
+    interior[XP] =  1;        interior[XM] = -1;
+    interior[YP] =  sy;       interior[YM] = -sy;
+    interior[ZP] =  sz;       interior[ZM] = -sz;
+    interior[XPYP] =  1 + sy; interior[XMYM] = -1 - sy;
+    interior[XPYM] =  1 - sy; interior[XMYP] = -1 + sy;
+    interior[XPZP] =  1 + sz; interior[XMZM] = -1 - sz;
+    interior[XPZM] =  1 - sz; interior[XMZP] = -1 + sz;
+    interior[YPZP] =  sy + sz; interior[YMZM] = -sy - sz;
+    interior[YPZM] =  sy - sz; interior[YMZP] = -sy + sz;
+
+    // boundary offsets, clamped to the image (zero flux)
+    OffsetValueType boundary[StencilSize];
+
+    const OffsetValueType x0 = region.GetIndex()[0] - bufferedRegion.GetIndex()[0];
+    const OffsetValueType y0 = region.GetIndex()[1] - bufferedRegion.GetIndex()[1];
+    const OffsetValueType z0 = region.GetIndex()[2] - bufferedRegion.GetIndex()[2];
+    const OffsetValueType x1 = x0 + static_cast<OffsetValueType>(region.GetSize()[0]);
+    const OffsetValueType y1 = y0 + static_cast<OffsetValueType>(region.GetSize()[1]);
+    const OffsetValueType z1 = z0 + static_cast<OffsetValueType>(region.GetSize()[2]);
+
+    for (OffsetValueType z=z0; z<z1; ++z)
     {
-        // output iter
-        ImageRegionIterator<PrecisionImageType> dit(d,*fitci);
-
-        // input iters
-        NT itci (r,ci,*fitci);
-        NT itxx (r,m_Dxx,*fitxx);
-        NT itxy (r,m_Dxy,*fitxy);
-        NT itxz (r,m_Dxz,*fitxz);
-        NT ityy (r,m_Dyy,*fityy);
-        NT ityz (r,m_Dyz,*fityz);
-        NT itzz (r,m_Dzz,*fitzz);
-
-        itci.OverrideBoundaryCondition(&b);
-        itxx.OverrideBoundaryCondition(&b);
-        itxy.OverrideBoundaryCondition(&b);
-        itxz.OverrideBoundaryCondition(&b);
-        ityy.OverrideBoundaryCondition(&b);
-        ityz.OverrideBoundaryCondition(&b);
-        itzz.OverrideBoundaryCondition(&b);
-
-        // setting active offsets (yeah there must
-        // be some smarter way of doing this)
-        itci.ClearActiveList();
-        itxx.ClearActiveList();
-        itxy.ClearActiveList();
-        itxz.ClearActiveList();
-        ityy.ClearActiveList();
-        ityz.ClearActiveList();
-        itzz.ClearActiveList();
-
-        itci.ActivateOffset(oxp);
-        itxx.ActivateOffset(oxp);
-        itxy.ActivateOffset(oxp);
-        itxz.ActivateOffset(oxp);
-        ityy.ActivateOffset(oxp);
-        ityz.ActivateOffset(oxp);
-        itzz.ActivateOffset(oxp);
-
-        itci.ActivateOffset(oxm);
-        itxx.ActivateOffset(oxm);
-        itxy.ActivateOffset(oxm);
-        itxz.ActivateOffset(oxm);
-        ityy.ActivateOffset(oxm);
-        ityz.ActivateOffset(oxm);
-        itzz.ActivateOffset(oxm);
-
-        itci.ActivateOffset(oyp);
-        itxx.ActivateOffset(oyp);
-        itxy.ActivateOffset(oyp);
-        itxz.ActivateOffset(oyp);
-        ityy.ActivateOffset(oyp);
-        ityz.ActivateOffset(oyp);
-        itzz.ActivateOffset(oyp);
-
-        itci.ActivateOffset(oym);
-        itxx.ActivateOffset(oym);
-        itxy.ActivateOffset(oym);
-        itxz.ActivateOffset(oym);
-        ityy.ActivateOffset(oym);
-        ityz.ActivateOffset(oym);
-        itzz.ActivateOffset(oym);
-
-        itci.ActivateOffset(ozp);
-        itxx.ActivateOffset(ozp);
-        itxy.ActivateOffset(ozp);
-        itxz.ActivateOffset(ozp);
-        ityy.ActivateOffset(ozp);
-        ityz.ActivateOffset(ozp);
-        itzz.ActivateOffset(ozp);
-
-        itci.ActivateOffset(ozm);
-        itxx.ActivateOffset(ozm);
-        itxy.ActivateOffset(ozm);
-        itxz.ActivateOffset(ozm);
-        ityy.ActivateOffset(ozm);
-        ityz.ActivateOffset(ozm);
-        itzz.ActivateOffset(ozm);
-
-        itci.ActivateOffset(oxpyp);
-        itxx.ActivateOffset(oxpyp);
-        itxy.ActivateOffset(oxpyp);
-        itxz.ActivateOffset(oxpyp);
-        ityy.ActivateOffset(oxpyp);
-        ityz.ActivateOffset(oxpyp);
-        itzz.ActivateOffset(oxpyp);
-
-        itci.ActivateOffset(oxmym);
-        itxx.ActivateOffset(oxmym);
-        itxy.ActivateOffset(oxmym);
-        itxz.ActivateOffset(oxmym);
-        ityy.ActivateOffset(oxmym);
-        ityz.ActivateOffset(oxmym);
-        itzz.ActivateOffset(oxmym);
-
-        itci.ActivateOffset(oxpym);
-        itxx.ActivateOffset(oxpym);
-        itxy.ActivateOffset(oxpym);
-        itxz.ActivateOffset(oxpym);
-        ityy.ActivateOffset(oxpym);
-        ityz.ActivateOffset(oxpym);
-        itzz.ActivateOffset(oxpym);
-
-        itci.ActivateOffset(oxmyp);
-        itxx.ActivateOffset(oxmyp);
-        itxy.ActivateOffset(oxmyp);
-        itxz.ActivateOffset(oxmyp);
-        ityy.ActivateOffset(oxmyp);
-        ityz.ActivateOffset(oxmyp);
-        itzz.ActivateOffset(oxmyp);
-
-        itci.ActivateOffset(oxpzp);
-        itxx.ActivateOffset(oxpzp);
-        itxy.ActivateOffset(oxpzp);
-        itxz.ActivateOffset(oxpzp);
-        ityy.ActivateOffset(oxpzp);
-        ityz.ActivateOffset(oxpzp);
-        itzz.ActivateOffset(oxpzp);
-
-        itci.ActivateOffset(oxmzm);
-        itxx.ActivateOffset(oxmzm);
-        itxy.ActivateOffset(oxmzm);
-        itxz.ActivateOffset(oxmzm);
-        ityy.ActivateOffset(oxmzm);
-        ityz.ActivateOffset(oxmzm);
-        itzz.ActivateOffset(oxmzm);
-
-        itci.ActivateOffset(oxpzm);
-        itxx.ActivateOffset(oxpzm);
-        itxy.ActivateOffset(oxpzm);
-        itxz.ActivateOffset(oxpzm);
-        ityy.ActivateOffset(oxpzm);
-        ityz.ActivateOffset(oxpzm);
-        itzz.ActivateOffset(oxpzm);
-
-        itci.ActivateOffset(oxmzp);
-        itxx.ActivateOffset(oxmzp);
-        itxy.ActivateOffset(oxmzp);
-        itxz.ActivateOffset(oxmzp);
-        ityy.ActivateOffset(oxmzp);
-        ityz.ActivateOffset(oxmzp);
-        itzz.ActivateOffset(oxmzp);
-
-        itci.ActivateOffset(oypzp);
-        itxx.ActivateOffset(oypzp);
-        itxy.ActivateOffset(oypzp);
-        itxz.ActivateOffset(oypzp);
-        ityy.ActivateOffset(oypzp);
-        ityz.ActivateOffset(oypzp);
-        itzz.ActivateOffset(oypzp);
-
-        itci.ActivateOffset(oymzm);
-        itxx.ActivateOffset(oymzm);
-        itxy.ActivateOffset(oymzm);
-        itxz.ActivateOffset(oymzm);
-        ityy.ActivateOffset(oymzm);
-        ityz.ActivateOffset(oymzm);
-        itzz.ActivateOffset(oymzm);
-
-        itci.ActivateOffset(oypzm);
-        itxx.ActivateOffset(oypzm);
-        itxy.ActivateOffset(oypzm);
-        itxz.ActivateOffset(oypzm);
-        ityy.ActivateOffset(oypzm);
-        ityz.ActivateOffset(oypzm);
-        itzz.ActivateOffset(oypzm);
-
-        itci.ActivateOffset(oymzp);
-        itxx.ActivateOffset(oymzp);
-        itxy.ActivateOffset(oymzp);
-        itxz.ActivateOffset(oymzp);
-        ityy.ActivateOffset(oymzp);
-        ityz.ActivateOffset(oymzp);
-        itzz.ActivateOffset(oymzp);
-
-        // run for each face diffusion
-        for (itci.GoToBegin(), dit.GoToBegin(),
-                itxx.GoToBegin(),itxy.GoToBegin(), itxz.GoToBegin(),
-                ityy.GoToBegin(),ityz.GoToBegin(), itzz.GoToBegin();
-                !itci.IsAtEnd();
-                ++itci, ++dit, ++itxx, ++itxy, ++itxz, ++ityy, ++ityz, ++itzz)
+        for (OffsetValueType y=y0; y<y1; ++y)
         {
-            // weights
-            const Precision xp = itxx.GetPixel(oxp) + itxx.GetCenterPixel();
-            const Precision xm = itxx.GetPixel(oxm) + itxx.GetCenterPixel();
-            const Precision yp = ityy.GetPixel(oyp) + ityy.GetCenterPixel();
-            const Precision ym = ityy.GetPixel(oym) + ityy.GetCenterPixel();
-            const Precision zp = itzz.GetPixel(ozp) + itzz.GetCenterPixel();
-            const Precision zm = itzz.GetPixel(ozm) + itzz.GetCenterPixel();
-
-            const Precision xpyp = itxy.GetPixel(oxpyp) + itxy.GetCenterPixel();
-            const Precision xmym = itxy.GetPixel(oxmym) + itxy.GetCenterPixel();
-            const Precision xpym = - itxy.GetPixel(oxpym) - itxy.GetCenterPixel();
-            const Precision xmyp = - itxy.GetPixel(oxmyp) - itxy.GetCenterPixel();
-
-            const Precision xpzp =   itxz.GetPixel(oxpzp) + itxz.GetCenterPixel();
-            const Precision xmzm =   itxz.GetPixel(oxmzm) + itxz.GetCenterPixel();
-            const Precision xpzm = - itxz.GetPixel(oxpzm) - itxz.GetCenterPixel();
-            const Precision xmzp = - itxz.GetPixel(oxmzp) - itxz.GetCenterPixel();
-
-            const Precision ypzp =   ityz.GetPixel(oypzp) + ityz.GetCenterPixel();
-            const Precision ymzm =   ityz.GetPixel(oymzm) + ityz.GetCenterPixel();
-            const Precision ypzm = - ityz.GetPixel(oypzm) - ityz.GetCenterPixel();
-            const Precision ymzp = - ityz.GetPixel(oymzp) - ityz.GetCenterPixel();
-
-            // evolution
-            const Precision cv = itci.GetCenterPixel();
-            dit.Value() = cv + 
-                + rxx * ( xp * (itci.GetPixel(oxp) - cv)
-                        + xm * (itci.GetPixel(oxm) - cv) )
-                + ryy * ( yp * (itci.GetPixel(oyp) - cv)
-                        + ym * (itci.GetPixel(oym) - cv) )
-                + rzz * ( zp * (itci.GetPixel(ozp) - cv)
-                        + zm * (itci.GetPixel(ozm) - cv) )
-                + rxy * ( xpyp * (itci.GetPixel(oxpyp) - cv)
-                        + xmym * (itci.GetPixel(oxmym) - cv)
-                        + xpym * (itci.GetPixel(oxpym) - cv)
-                        + xmyp * (itci.GetPixel(oxmyp) - cv) )
-                + rxz * ( xpzp * (itci.GetPixel(oxpzp) - cv)
-                        + xmzm * (itci.GetPixel(oxmzm) - cv)
-                        + xpzm * (itci.GetPixel(oxpzm) - cv)
-                        + xmzp * (itci.GetPixel(oxmzp) - cv) )
-                + ryz * ( ypzp * (itci.GetPixel(oypzp) - cv)
-                        + ymzm * (itci.GetPixel(oymzm) - cv)
-                        + ypzm * (itci.GetPixel(oypzm) - cv)
-                        + ymzp * (itci.GetPixel(oymzp) - cv) );
-
+            const bool interiorRow = (y > 0) && (y < ny-1) && (z > 0) && (z < nz-1);
+            for (OffsetValueType x=x0; x<x1; ++x)
+            {
+                const OffsetValueType c = x + y * sy + z * sz;
+                const OffsetValueType *o = interior;
+
+                if (!interiorRow || (x == 0) || (x == nx-1))
+                {
+                    const OffsetValueType xp = (x < nx-1) ?  1 : 0;
+                    const OffsetValueType xm = (x > 0)    ? -1 : 0;
+                    const OffsetValueType yp = (y < ny-1) ?  sy : 0;
+                    const OffsetValueType ym = (y > 0)    ? -sy : 0;
+                    const OffsetValueType zp = (z < nz-1) ?  sz : 0;
+                    const OffsetValueType zm = (z > 0)    ? -sz : 0;
+
+                    boundary[XP] = xp;        boundary[XM] = xm;
+                    boundary[YP] = yp;        boundary[YM] = ym;
+                    boundary[ZP] = zp;        boundary[ZM] = zm;
+                    boundary[XPYP] = xp + yp; boundary[XMYM] = xm + ym;
+                    boundary[XPYM] = xp + ym; boundary[XMYP] = xm + yp;
+                    boundary[XPZP] = xp + zp; boundary[XMZM] = xm + zm;
+                    boundary[XPZM] = xp + zm; boundary[XMZP] = xm + zp;
+                    boundary[YPZP] = yp + zp; boundary[YMZM] = ym + zm;
+                    boundary[YPZM] = yp + zm; boundary[YMZP] = ym + zp;
+                    o = boundary;
+                }
+
+                // weights
+                const Precision wxp = dxx[c+o[XP]] + dxx[c];
+                const Precision wxm = dxx[c+o[XM]] + dxx[c];
+                const Precision wyp = dyy[c+o[YP]] + dyy[c];
+                const Precision wym = dyy[c+o[YM]] + dyy[c];
+                const Precision wzp = dzz[c+o[ZP]] + dzz[c];
+                const Precision wzm = dzz[c+o[ZM]] + dzz[c];
+
+                const Precision wxpyp =   dxy[c+o[XPYP]] + dxy[c];
+                const Precision wxmym =   dxy[c+o[XMYM]] + dxy[c];
+                const Precision wxpym = - dxy[c+o[XPYM]] - dxy[c];
+                const Precision wxmyp = - dxy[c+o[XMYP]] - dxy[c];
+
+                const Precision wxpzp =   dxz[c+o[XPZP]] + dxz[c];
+                const Precision wxmzm =   dxz[c+o[XMZM]] + dxz[c];
+                const Precision wxpzm = - dxz[c+o[XPZM]] - dxz[c];
+                const Precision wxmzp = - dxz[c+o[XMZP]] - dxz[c];
+
+                const Precision wypzp =   dyz[c+o[YPZP]] + dyz[c];
+                const Precision wymzm =   dyz[c+o[YMZM]] + dyz[c];
+                const Precision wypzm = - dyz[c+o[YPZM]] - dyz[c];
+                const Precision wymzp = - dyz[c+o[YMZP]] - dyz[c];
+
+                // evolution
+                const Precision cv = ci[c];
+                d[c] = cv 
+                    + rxx * ( wxp * (ci[c+o[XP]] - cv)
+                            + wxm * (ci[c+o[XM]] - cv) )
+                    + ryy * ( wyp * (ci[c+o[YP]] - cv)
+                            + wym * (ci[c+o[YM]] - cv) )
+                    + rzz * ( wzp * (ci[c+o[ZP]] - cv)
+                            + wzm * (ci[c+o[ZM]] - cv) )
+                    + rxy * ( wxpyp * (ci[c+o[XPYP]] - cv)
+                            + wxmym * (ci[c+o[XMYM]] - cv)
+                            + wxpym * (ci[c+o[XPYM]] - cv)
+                            + wxmyp * (ci[c+o[XMYP]] - cv) )
+                    + rxz * ( wxpzp * (ci[c+o[XPZP]] - cv)
+                            + wxmzm * (ci[c+o[XMZM]] - cv)
+                            + wxpzm * (ci[c+o[XPZM]] - cv)
+                            + wxmzp * (ci[c+o[XMZP]] - cv) )
+                    + ryz * ( wypzp * (ci[c+o[YPZP]] - cv)
+                            + wymzm * (ci[c+o[YMZM]] - cv)
+                            + wypzm * (ci[c+o[YPZM]] - cv)
+                            + wymzp * (ci[c+o[YMZP]] - cv) );
+            }
         }
     }
+}
 
-    // copying
-    ImageRegionConstIterator<PrecisionImageType> iti (d,d->GetLargestPossibleRegion());
-    ImageRegionIterator<PrecisionImageType>      ito (ci,ci->GetLargestPossibleRegion());
-    for (iti.GoToBegin(), ito.GoToBegin(); !iti.IsAtEnd(); ++iti,++ito)
-    {
-        ito.Value() = iti.Value();
-    }
-
-    return;
-} 
 // maxvesselresponse
 template <class PixelType, unsigned int Dimension>
 void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
-::MaxVesselResponse(const typename ImageType::Pointer im)	
+::MaxVesselResponse()	
 {
-
-    // alloc memory for hessian/tensor
-    m_Dxx = PrecisionImageType::New();
-    m_Dxx->SetOrigin(im->GetOrigin());
-    m_Dxx->SetSpacing(im->GetSpacing());
-    m_Dxx->SetDirection(im->GetDirection());
-    m_Dxx->SetRegions(im->GetLargestPossibleRegion());
-    m_Dxx->Allocate();
+    // alloc memory for hessian/tensor, reused over recalculations
+    if (m_Dxx.IsNull() || 
+        m_Dxx->GetLargestPossibleRegion() != m_Current->GetLargestPossibleRegion())
+    {
+        m_Dxx = AllocatePrecisionImage(m_Current);
+        m_Dxy = AllocatePrecisionImage(m_Current);
+        m_Dxz = AllocatePrecisionImage(m_Current);
+        m_Dyy = AllocatePrecisionImage(m_Current);
+        m_Dyz = AllocatePrecisionImage(m_Current);
+        m_Dzz = AllocatePrecisionImage(m_Current);
+    }
     m_Dxx->FillBuffer(NumericTraits<Precision>::One);
-
-    m_Dxy = PrecisionImageType::New();
-    m_Dxy->SetOrigin(im->GetOrigin());
-    m_Dxy->SetSpacing(im->GetSpacing());
-    m_Dxy->SetDirection(im->GetDirection());
-    m_Dxy->SetRegions(im->GetLargestPossibleRegion());
-    m_Dxy->Allocate();
     m_Dxy->FillBuffer(NumericTraits<Precision>::Zero);
-
-    m_Dxz = PrecisionImageType::New();
-    m_Dxz->SetOrigin(im->GetOrigin());
-    m_Dxz->SetSpacing(im->GetSpacing());
-    m_Dxz->SetDirection(im->GetDirection());
-    m_Dxz->SetRegions(im->GetLargestPossibleRegion());
-    m_Dxz->Allocate();
     m_Dxz->FillBuffer(NumericTraits<Precision>::Zero);
-
-    m_Dyy = PrecisionImageType::New();
-    m_Dyy->SetOrigin(im->GetOrigin());
-    m_Dyy->SetSpacing(im->GetSpacing());
-    m_Dyy->SetDirection(im->GetDirection());
-    m_Dyy->SetRegions(im->GetLargestPossibleRegion());
-    m_Dyy->Allocate();
     m_Dyy->FillBuffer(NumericTraits<Precision>::One);
-
-    m_Dyz = PrecisionImageType::New();
-    m_Dyz->SetOrigin(im->GetOrigin());
-    m_Dyz->SetSpacing(im->GetSpacing());
-    m_Dyz->SetDirection(im->GetDirection());
-    m_Dyz->SetRegions(im->GetLargestPossibleRegion());
-    m_Dyz->Allocate();
     m_Dyz->FillBuffer(NumericTraits<Precision>::Zero);
-
-    m_Dzz = PrecisionImageType::New();
-    m_Dzz->SetOrigin(im->GetOrigin());
-    m_Dzz->SetSpacing(im->GetSpacing());
-    m_Dzz->SetDirection(im->GetDirection());
-    m_Dzz->SetRegions(im->GetLargestPossibleRegion());
-    m_Dzz->Allocate();
     m_Dzz->FillBuffer(NumericTraits<Precision>::One);
 
-
 	// create temp vesselness image to store maxvessel
-	typename PrecisionImageType::Pointer vi = PrecisionImageType::New();
-
-	vi->SetOrigin(im->GetOrigin());
-	vi->SetSpacing(im->GetSpacing());
-	vi->SetDirection(im->GetDirection());
-	vi->SetRegions(im->GetLargestPossibleRegion());
-	vi->Allocate();
-    vi->FillBuffer(NumericTraits<Precision>::Zero);
-    
+    m_Vesselness = AllocatePrecisionImage(m_Current);
+    m_Vesselness->FillBuffer(NumericTraits<Precision>::Zero);
 
 	for (unsigned int i=0; i< m_Scales.size(); ++i)
 	{
-        typedef HessianRecursiveGaussianImageFilter<PrecisionImageType> HessianType;
+        typedef HessianRecursiveGaussianImageFilter<PrecisionImageType,HessianImageType> HessianType;
         typename HessianType::Pointer hessian = HessianType::New();
-        hessian->SetInput(im);
+        hessian->SetInput(m_Current);
         hessian->SetNormalizeAcrossScale(true);
         hessian->SetSigma(m_Scales[i]);
         hessian->Update();
 
-        ImageRegionIterator<PrecisionImageType> itxx (m_Dxx, m_Dxx->GetLargestPossibleRegion());
-        ImageRegionIterator<PrecisionImageType> itxy (m_Dxy, m_Dxy->GetLargestPossibleRegion());
-        ImageRegionIterator<PrecisionImageType> itxz (m_Dxz, m_Dxz->GetLargestPossibleRegion());
-        ImageRegionIterator<PrecisionImageType> ityy (m_Dyy, m_Dyy->GetLargestPossibleRegion());
-        ImageRegionIterator<PrecisionImageType> ityz (m_Dyz, m_Dyz->GetLargestPossibleRegion());
-        ImageRegionIterator<PrecisionImageType> itzz (m_Dzz, m_Dzz->GetLargestPossibleRegion());
-        ImageRegionIterator<PrecisionImageType> vit(vi, vi->GetLargestPossibleRegion());
-
-        ImageRegionConstIterator<typename HessianType::OutputImageType> hit 
-            (hessian->GetOutput(), hessian->GetOutput()->GetLargestPossibleRegion());
-
-        for (itxx.GoToBegin(), itxy.GoToBegin(), itxz.GoToBegin(), 
-                ityy.GoToBegin(), ityz.GoToBegin(), itzz.GoToBegin(),
-                vit.GoToBegin(), hit.GoToBegin(); !vit.IsAtEnd(); 
-                ++itxx, ++itxy, ++itxz, ++ityy, ++ityz, ++itzz, ++hit, ++vit)
-        {
-            vnl_matrix<Precision> H(3,3);
-
-            H(0,0) = hit.Value()(0,0);
-            H(0,1) = H(1,0) = hit.Value()(0,1);
-            H(0,2) = H(2,0) = hit.Value()(0,2);
-            H(1,1) = hit.Value()(1,1);
-            H(1,2) = H(2,1) = hit.Value()(1,2);
-            H(2,2) = hit.Value()(2,2);
-
-            vnl_symmetric_eigensystem<Precision> ES(H);
-            vnl_vector<Precision> ev(3);
-
-            ev[0] = ES.get_eigenvalue(0); 
-            ev[1] = ES.get_eigenvalue(1); 
-            ev[2] = ES.get_eigenvalue(2);
-
-            if ( vcl_abs(ev[0]) > vcl_abs(ev[1])  ) std::swap(ev[0], ev[1]);
-            if ( vcl_abs(ev[1]) > vcl_abs(ev[2])  ) std::swap(ev[1], ev[2]);
-            if ( vcl_abs(ev[0]) > vcl_abs(ev[1])  ) std::swap(ev[0], ev[1]);
-
-			const Precision vesselness = VesselnessFunction3D(ev[0],ev[1],ev[2]);
-
-			if ( vesselness > 0 && vesselness > vit.Value() )
-			{
-				vit.Value() = vesselness;
-
-                itxx.Value() = hit.Value()(0,0);
-                itxy.Value() = hit.Value()(0,1);
-                itxz.Value() = hit.Value()(0,2);
-                ityy.Value() = hit.Value()(1,1);
-                ityz.Value() = hit.Value()(1,2);
-                itzz.Value() = hit.Value()(2,2);
-			}
-		} 
+        m_Hessian = hessian->GetOutput();
+        ThreadedPass (VESSELNESS_PASS);
+        m_Hessian = ITK_NULLPTR;
 	} 
+
+    m_Vesselness = ITK_NULLPTR;
  
     return;
+}
+
+template <class PixelType, unsigned int Dimension>
+void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
+::ThreadedMaxVesselResponse(const RegionType &region)
+{
+    ImageRegionIterator<PrecisionImageType> itxx (m_Dxx, region);
+    ImageRegionIterator<PrecisionImageType> itxy (m_Dxy, region);
+    ImageRegionIterator<PrecisionImageType> itxz (m_Dxz, region);
+    ImageRegionIterator<PrecisionImageType> ityy (m_Dyy, region);
+    ImageRegionIterator<PrecisionImageType> ityz (m_Dyz, region);
+    ImageRegionIterator<PrecisionImageType> itzz (m_Dzz, region);
+    ImageRegionIterator<PrecisionImageType> vit (m_Vesselness, region);
+    ImageRegionConstIterator<HessianImageType> hit (m_Hessian, region);
+
+    for (itxx.GoToBegin(), itxy.GoToBegin(), itxz.GoToBegin(), 
+            ityy.GoToBegin(), ityz.GoToBegin(), itzz.GoToBegin(),
+            vit.GoToBegin(), hit.GoToBegin(); !vit.IsAtEnd(); 
+            ++itxx, ++itxy, ++itxz, ++ityy, ++ityz, ++itzz, ++hit, ++vit)
+    {
+        const HessianPixelType &h = hit.Value();
+        const double H[6] = { h(0,0), h(0,1), h(0,2), h(1,1), h(1,2), h(2,2) };
+
+        const Precision vesselness = HessianVesselness(H);
+
+        if ( vesselness > 0 && vesselness > vit.Value() )
+        {
+            vit.Value() = vesselness;
+
+            itxx.Value() = H[0];
+            itxy.Value() = H[1];
+            itxz.Value() = H[2];
+            ityy.Value() = H[3];
+            ityz.Value() = H[4];
+            itzz.Value() = H[5];
+        }
+    } 
+}
 
+// vesselness of a hessian
+template <class PixelType, unsigned int Dimension>
+typename VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>::Precision
+VesselEnhancingDiffusion3DImageFilter<PixelType,Dimension>::HessianVesselness
+(
+    const double *H
+)
+{
+    // closed form eigenvalues of the symmetric 3x3 matrix
+    double l1, l2, l3;
+    vnl_symmetric_eigensystem_compute_eigenvals(H[0], H[1], H[2], H[3], H[4], H[5], l1, l2, l3);
+
+    Precision ev[3] = { static_cast<Precision>(l1), static_cast<Precision>(l2), static_cast<Precision>(l3) };
+
+    if ( std::abs(ev[0]) > std::abs(ev[1])  ) std::swap(ev[0], ev[1]);
+    if ( std::abs(ev[1]) > std::abs(ev[2])  ) std::swap(ev[1], ev[2]);
+    if ( std::abs(ev[0]) > std::abs(ev[1])  ) std::swap(ev[0], ev[1]);
+
+    return VesselnessFunction3D(ev[0],ev[1],ev[2]);
 }
+
 // vesselnessfunction
 template <class PixelType, unsigned int Dimension>
 typename VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>::Precision
@@ -569,13 +478,13 @@ VesselEnhancingDiffusion3DImageFilter<PixelType,Dimension>::VesselnessFunction3D
 	    const Precision vc2= 2.0*m_Gamma*m_Gamma;
 
 	    const Precision   Ra2 = (l2 * l2) / (l3 * l3);
-	    const Precision   Rb2 = (l1 * l1) / vcl_abs(l2 * l3);
+	    const Precision   Rb2 = (l1 * l1) / std::abs(l2 * l3);
 	    const Precision   S2 =  (l1 * l1) + (l2 *l2) + (l3 * l3);
-	    const Precision   T = vcl_exp(-(2*smoothC*smoothC)/(vcl_abs(l2)*l3*l3));
+	    const Precision   T = std::exp(-(2*smoothC*smoothC)/(std::abs(l2)*l3*l3));
 
-	    vesselness = T * (1.0 - vcl_exp( - Ra2/va2)) *
-		    vcl_exp(-Rb2/vb2) *
-		    (1.0 - vcl_exp(-S2/vc2));
+	    vesselness = T * (1.0 - std::exp( - Ra2/va2)) *
+		    std::exp(-Rb2/vb2) *
+		    (1.0 - std::exp(-S2/vc2));
 
     }
 
@@ -586,69 +495,84 @@ template <class PixelType, unsigned int Dimension>
 void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
 ::DiffusionTensor() 
 {
-    ImageRegionIterator<PrecisionImageType> itxx (m_Dxx, m_Dxx->GetLargestPossibleRegion());
-    ImageRegionIterator<PrecisionImageType> itxy (m_Dxy, m_Dxy->GetLargestPossibleRegion());
-    ImageRegionIterator<PrecisionImageType> itxz (m_Dxz, m_Dxz->GetLargestPossibleRegion());
-    ImageRegionIterator<PrecisionImageType> ityy (m_Dyy, m_Dyy->GetLargestPossibleRegion());
-    ImageRegionIterator<PrecisionImageType> ityz (m_Dyz, m_Dyz->GetLargestPossibleRegion());
-    ImageRegionIterator<PrecisionImageType> itzz (m_Dzz, m_Dzz->GetLargestPossibleRegion());
+    ThreadedPass (TENSOR_PASS);
+} 
+
+template <class PixelType, unsigned int Dimension>
+void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
+::ThreadedDiffusionTensor(const RegionType &region) 
+{
+    typedef Matrix<double,3,3>                                              MatrixType;
+    typedef FixedArray<double,3>                                            EigenValuesType;
+    typedef SymmetricEigenAnalysis<MatrixType,EigenValuesType,MatrixType>   EigenAnalysisType;
+
+    // eigenvalues in ascending order, eigenvectors as rows
+    EigenAnalysisType eigenAnalysis(3);
+    eigenAnalysis.SetOrderEigenValues(true);
+
+    ImageRegionIterator<PrecisionImageType> itxx (m_Dxx, region);
+    ImageRegionIterator<PrecisionImageType> itxy (m_Dxy, region);
+    ImageRegionIterator<PrecisionImageType> itxz (m_Dxz, region);
+    ImageRegionIterator<PrecisionImageType> ityy (m_Dyy, region);
+    ImageRegionIterator<PrecisionImageType> ityz (m_Dyz, region);
+    ImageRegionIterator<PrecisionImageType> itzz (m_Dzz, region);
 
     for  ( itxx.GoToBegin(), itxy.GoToBegin(), itxz.GoToBegin(),
             ityy.GoToBegin(), ityz.GoToBegin(), itzz.GoToBegin();
             !itxx.IsAtEnd();
             ++itxx, ++itxy, ++itxz, ++ityy, ++ityz, ++itzz)
     {
-        vnl_matrix<Precision> H(3,3);
-        H(0,0) = itxx.Value();
-        H(0,1) = H(1,0) = itxy.Value();
-        H(0,2) = H(2,0) = itxz.Value();
-        H(1,1) = ityy.Value();
-        H(1,2) = H(2,1) = ityz.Value();
-        H(2,2) = itzz.Value();
-
-        vnl_symmetric_eigensystem<Precision> ES(H);
-
-        vnl_matrix<Precision> EV(3,3);
-        EV.set_column(0,ES.get_eigenvector(0));
-        EV.set_column(1,ES.get_eigenvector(1));
-        EV.set_column(2,ES.get_eigenvector(2));
-
-        vnl_vector<Precision> ev(3);
-        ev[0] = ES.get_eigenvalue(0);
-        ev[1] = ES.get_eigenvalue(1);
-        ev[2] = ES.get_eigenvalue(2);
+        const double H[6] = { itxx.Value(), itxy.Value(), itxz.Value(), 
+                              ityy.Value(), ityz.Value(), itzz.Value() };
 
-        if ( vcl_abs(ev[0]) > vcl_abs(ev[1])  ) std::swap(ev[0], ev[1]);
-        if ( vcl_abs(ev[1]) > vcl_abs(ev[2])  ) std::swap(ev[1], ev[2]);
-        if ( vcl_abs(ev[0]) > vcl_abs(ev[1])  ) std::swap(ev[0], ev[1]);
+        const Precision V = HessianVesselness(H);
 
-        const Precision V=VesselnessFunction3D(ev[0],ev[1],ev[2]);
-        vnl_vector<Precision> evn(3);
+        // no vesselness, isotropic diffusion
+        if (V <= 0)
+        {
+            itxx.Value() = NumericTraits<Precision>::One;
+            itxy.Value() = NumericTraits<Precision>::Zero;
+            itxz.Value() = NumericTraits<Precision>::Zero;
+            ityy.Value() = NumericTraits<Precision>::One;
+            ityz.Value() = NumericTraits<Precision>::Zero;
+            itzz.Value() = NumericTraits<Precision>::One;
+            continue;
+        }
 
         // adjusting eigenvalues
         // static_cast required to prevent error with gcc 4.1.2
-        evn[0]   = 1.0 + (m_Epsilon - 1.0) * vcl_pow(V,static_cast<Precision>(1.0/m_Sensitivity));
-        evn[1]   = 1.0 + (m_Epsilon - 1.0) * vcl_pow(V,static_cast<Precision>(1.0/m_Sensitivity)); 
-        evn[2]   = 1.0 + (m_Omega - 1.0 ) * vcl_pow(V,static_cast<Precision>(1.0/m_Sensitivity)); 
-
-        vnl_matrix<Precision> LAM(3,3);
-        LAM.fill(0);
-        LAM(0,0) = evn[0];
-        LAM(1,1) = evn[1];
-        LAM(2,2) = evn[2];
-
-        const vnl_matrix<Precision> HN = EV * LAM * EV.transpose();
-
-        itxx.Value() = HN(0,0);
-        itxy.Value() = HN(0,1);
-        itxz.Value() = HN(0,2);
-        ityy.Value() = HN(1,1);
-        ityz.Value() = HN(1,2);
-        itzz.Value() = HN(2,2);
+        const Precision Vs = std::pow(V,static_cast<Precision>(1.0/m_Sensitivity));
+        const double e01 = 1.0 + (m_Epsilon - 1.0) * Vs;
+        const double e2  = 1.0 + (m_Omega - 1.0 ) * Vs; 
+
+        MatrixType A;
+        A(0,0) = H[0];
+        A(0,1) = A(1,0) = H[1];
+        A(0,2) = A(2,0) = H[2];
+        A(1,1) = H[3];
+        A(1,2) = A(2,1) = H[4];
+        A(2,2) = H[5];
+
+        EigenValuesType ev;
+        MatrixType EV;
+        eigenAnalysis.ComputeEigenValuesAndVectors(A, ev, EV);
+
+        // the first two adjusted eigenvalues are equal, so
+        // EV * LAM * EV' = e01 * I + (e2 - e01) * v2 * v2'
+        const double v0 = EV(2,0);
+        const double v1 = EV(2,1);
+        const double v2 = EV(2,2);
+        const double de = e2 - e01;
+
+        itxx.Value() = e01 + de * v0 * v0;
+        itxy.Value() = de * v0 * v1;
+        itxz.Value() = de * v0 * v2;
+        ityy.Value() = e01 + de * v1 * v1;
+        ityz.Value() = de * v1 * v2;
+        itzz.Value() = e01 + de * v2 * v2;
     }
-    return;
+}
 
-} 
 // generatedata
 template <class PixelType, unsigned int Dimension>
 void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
@@ -705,7 +629,9 @@ void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
     cast->SetInput(this->GetInput());
     cast->Update();
 
-    typename PrecisionImageType::Pointer ci = cast->GetOutput();
+    m_Current = cast->GetOutput();
+    m_Current->DisconnectPipeline();
+    m_Next = AllocatePrecisionImage(m_Current);
 
 
     if (m_Verbose)
@@ -715,9 +641,20 @@ void VesselEnhancingDiffusion3DImageFilter<PixelType, Dimension>
 
 	for (m_CurrentIteration=1; m_CurrentIteration<=m_Iterations; m_CurrentIteration++)
     {
-        VED3DSingleIteration (ci);
+        VED3DSingleIteration ();
     } 
 
+    // release working images
+    typename PrecisionImageType::Pointer ci = m_Current;
+    m_Current = ITK_NULLPTR;
+    m_Next = ITK_NULLPTR;
+    m_Dxx = ITK_NULLPTR;
+    m_Dxy = ITK_NULLPTR;
+    m_Dxz = ITK_NULLPTR;
+    m_Dyy = ITK_NULLPTR;
+    m_Dyz = ITK_NULLPTR;
+    m_Dzz = ITK_NULLPTR;
+
     typedef MinimumMaximumImageFilter<PrecisionImageType> MMT;
     typename MMT::Pointer mm = MMT::New();
     mm->SetInput(ci);
@@ -25,6 +25,7 @@ Version:   $Revision: 1.1 $
 
 #include "vtkvmtkCollidingFrontsImageFilter.h"
 #include "vtkvmtkITKFilterUtilities.h"
+#include "vtkvmtkNarrowBandFastMarching.h"
 #include "vtkObjectFactory.h"
 
 #include "itkCollidingFrontsImageFilter.h"
@@ -43,6 +44,9 @@ vtkvmtkCollidingFrontsImageFilter::vtkvmtkCollidingFrontsImageFilter()
   this->ApplyConnectivity = 0;
   this->NegativeEpsilon = -1E-6;
   this->StopOnTargets = 0;
+  this->BidirectionalPropagation = 0;
+  this->UseSeedBoundingBox = 0;
+  this->SeedBoundingBoxMargin = 10;
 }
 
 vtkvmtkCollidingFrontsImageFilter::~vtkvmtkCollidingFrontsImageFilter()
@@ -62,6 +66,12 @@ vtkvmtkCollidingFrontsImageFilter::~vtkvmtkCollidingFrontsImageFilter()
 
 void vtkvmtkCollidingFrontsImageFilter::SimpleExecute(vtkImageData* input, vtkImageData* output)
 {
+  if (this->BidirectionalPropagation)
+    {
+    this->ExecuteBidirectional(input,output);
+    return;
+    }
+
   std::cout<<input->GetScalarType()<<std::endl;
   typedef itk::Image<float,3> ImageType;
 
@@ -112,3 +122,234 @@ void vtkvmtkCollidingFrontsImageFilter::SimpleExecute(vtkImageData* input, vtkIm
   vtkvmtkITKFilterUtilities::ITKToVTKImage<ImageType>(collidingFrontsFilter->GetOutput(),output);
 }
 
+void vtkvmtkCollidingFrontsImageFilter::ExecuteBidirectional(vtkImageData* input, vtkImageData* output)
+{
+  if (input->GetScalarType() != VTK_FLOAT || input->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro(<<"Speed image must have one float component.");
+    return;
+    }
+
+  if (!this->Seeds1 || !this->Seeds2 || this->Seeds1->GetNumberOfIds() == 0 || this->Seeds2->GetNumberOfIds() == 0)
+    {
+    vtkErrorMacro(<<"Both Seeds1 and Seeds2 must be set.");
+    return;
+    }
+
+  int dimensions[3];
+  input->GetDimensions(dimensions);
+  double spacing[3];
+  input->GetSpacing(spacing);
+  const vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+  const vtkIdType numberOfVoxels = input->GetNumberOfPoints();
+
+  vtkIdList* seedLists[2] = { this->Seeds1, this->Seeds2 };
+  int i, j, k;
+  for (int n=0; n<2; n++)
+    {
+    for (i=0; i<seedLists[n]->GetNumberOfIds(); i++)
+      {
+      if (seedLists[n]->GetId(i) < 0 || seedLists[n]->GetId(i) >= numberOfVoxels)
+        {
+        vtkErrorMacro(<<"Seed id out of range: " << seedLists[n]->GetId(i));
+        return;
+        }
+      }
+    }
+
+  // marching region: the whole image or the enlarged bounding box of the seeds
+  int box[6] = { 0, dimensions[0]-1, 0, dimensions[1]-1, 0, dimensions[2]-1 };
+  if (this->UseSeedBoundingBox)
+    {
+    box[0] = box[2] = box[4] = VTK_INT_MAX;
+    box[1] = box[3] = box[5] = -1;
+    for (int n=0; n<2; n++)
+      {
+      for (i=0; i<seedLists[n]->GetNumberOfIds(); i++)
+        {
+        vtkIdType id = seedLists[n]->GetId(i);
+        int ijk[3];
+        ijk[2] = static_cast<int>(id / sliceSize);
+        ijk[1] = static_cast<int>((id - ijk[2] * sliceSize) / dimensions[0]);
+        ijk[0] = static_cast<int>(id - ijk[2] * sliceSize - ijk[1] * dimensions[0]);
+        for (j=0; j<3; j++)
+          {
+          box[2*j] = std::min(box[2*j],ijk[j]);
+          box[2*j+1] = std::max(box[2*j+1],ijk[j]);
+          }
+        }
+      }
+    for (j=0; j<3; j++)
+      {
+      box[2*j] = std::max(box[2*j] - this->SeedBoundingBoxMargin,0);
+      box[2*j+1] = std::min(box[2*j+1] + this->SeedBoundingBoxMargin,dimensions[j]-1);
+      }
+    }
+
+  int boxDimensions[3];
+  for (j=0; j<3; j++)
+    {
+    boxDimensions[j] = box[2*j+1] - box[2*j] + 1;
+    }
+  const vtkIdType boxSliceSize = static_cast<vtkIdType>(boxDimensions[0]) * boxDimensions[1];
+  const vtkIdType numberOfBoxVoxels = boxSliceSize * boxDimensions[2];
+  const bool wholeImage = numberOfBoxVoxels == numberOfVoxels;
+
+  const float* inputScalars = static_cast<const float*>(input->GetScalarPointer());
+  float* outputScalars = static_cast<float*>(output->GetScalarPointer());
+
+  // without a bounding box, march on the input and compute the result in
+  // the output; otherwise copy the speed of the box and paste the result back
+  const float* speed = inputScalars;
+  float* products = outputScalars;
+  std::vector<float> boxSpeed;
+  std::vector<float> boxProducts;
+  if (!wholeImage)
+    {
+    boxSpeed.resize(numberOfBoxVoxels);
+    for (k=0; k<boxDimensions[2]; k++)
+      {
+      for (j=0; j<boxDimensions[1]; j++)
+        {
+        const float* row = inputScalars + (k + box[4]) * sliceSize + static_cast<vtkIdType>(j + box[2]) * dimensions[0] + box[0];
+        std::copy(row,row+boxDimensions[0],boxSpeed.begin() + k * boxSliceSize + static_cast<vtkIdType>(j) * boxDimensions[0]);
+        }
+      }
+    speed = &boxSpeed[0];
+    boxProducts.resize(numberOfBoxVoxels);
+    products = &boxProducts[0];
+    }
+
+  const float largeValue = vtkvmtkNarrowBandFastMarching::GetLargeValue();
+  std::vector<float> times1(numberOfBoxVoxels,largeValue);
+  std::vector<float> times2(numberOfBoxVoxels,largeValue);
+  std::vector<float> gradients1(3*numberOfBoxVoxels,0.0f);
+  std::vector<float> gradients2(3*numberOfBoxVoxels,0.0f);
+
+  vtkvmtkNarrowBandFastMarching front1(speed,boxDimensions,spacing,&times1[0]);
+  vtkvmtkNarrowBandFastMarching front2(speed,boxDimensions,spacing,&times2[0]);
+  front1.SetGradient(&gradients1[0]);
+  front2.SetGradient(&gradients2[0]);
+
+  std::vector<vtkIdType> boxSeeds;
+  for (int n=0; n<2; n++)
+    {
+    vtkvmtkNarrowBandFastMarching& front = n == 0 ? front1 : front2;
+    for (i=0; i<seedLists[n]->GetNumberOfIds(); i++)
+      {
+      vtkIdType id = seedLists[n]->GetId(i);
+      int ijk[3];
+      ijk[2] = static_cast<int>(id / sliceSize);
+      ijk[1] = static_cast<int>((id - ijk[2] * sliceSize) / dimensions[0]);
+      ijk[0] = static_cast<int>(id - ijk[2] * sliceSize - ijk[1] * dimensions[0]);
+      vtkIdType boxId = (ijk[2] - box[4]) * boxSliceSize + static_cast<vtkIdType>(ijk[1] - box[2]) * boxDimensions[0] + (ijk[0] - box[0]);
+      front.AddSeed(boxId,0.0f);
+      boxSeeds.push_back(boxId);
+      }
+    }
+
+  // Advance the front with the smaller arrival time. Each voxel reached by
+  // both fronts gives an upper bound of the seed-to-seed distance; both
+  // fronts are stopped past the smallest such bound.
+  double distance = largeValue;
+  bool active1 = true;
+  bool active2 = true;
+  while (active1 || active2)
+    {
+    bool advance1 = active1 && (!active2 || front1.GetFrontValue() <= front2.GetFrontValue());
+    vtkvmtkNarrowBandFastMarching& front = advance1 ? front1 : front2;
+    vtkvmtkNarrowBandFastMarching& otherFront = advance1 ? front2 : front1;
+    vtkIdType id = front.Step();
+    if (id < 0)
+      {
+      if (advance1)
+        {
+        active1 = false;
+        }
+      else
+        {
+        active2 = false;
+        }
+      continue;
+      }
+    if (otherFront.IsAlive(id))
+      {
+      double sum = static_cast<double>(times1[id]) + static_cast<double>(times2[id]);
+      if (sum < distance)
+        {
+        distance = sum;
+        front1.SetStoppingValue(distance);
+        front2.SetStoppingValue(distance);
+        }
+      }
+    }
+
+  // gradients are zero where a front did not get, so is their product
+  for (vtkIdType id=0; id<numberOfBoxVoxels; id++)
+    {
+    const float* gradient1 = &gradients1[3*id];
+    const float* gradient2 = &gradients2[3*id];
+    products[id] = gradient1[0] * gradient2[0] + gradient1[1] * gradient2[1] + gradient1[2] * gradient2[2];
+    }
+
+  if (this->ApplyConnectivity)
+    {
+    // keep the face connected region below NegativeEpsilon grown from the seeds
+    std::vector<unsigned char> connected(numberOfBoxVoxels,0);
+    std::vector<vtkIdType> queue;
+    for (size_t n=0; n<boxSeeds.size(); n++)
+      {
+      if (!connected[boxSeeds[n]])
+        {
+        connected[boxSeeds[n]] = 1;
+        queue.push_back(boxSeeds[n]);
+        }
+      }
+    const vtkIdType strides[3] = { 1, boxDimensions[0], boxSliceSize };
+    while (!queue.empty())
+      {
+      vtkIdType id = queue.back();
+      queue.pop_back();
+      int ijk[3];
+      ijk[2] = static_cast<int>(id / boxSliceSize);
+      ijk[1] = static_cast<int>((id - ijk[2] * boxSliceSize) / boxDimensions[0]);
+      ijk[0] = static_cast<int>(id - ijk[2] * boxSliceSize - ijk[1] * boxDimensions[0]);
+      for (j=0; j<3; j++)
+        {
+        for (int s=-1; s<2; s+=2)
+          {
+          if (ijk[j] + s < 0 || ijk[j] + s >= boxDimensions[j])
+            {
+            continue;
+            }
+          vtkIdType neighborId = id + s * strides[j];
+          if (!connected[neighborId] && products[neighborId] < this->NegativeEpsilon)
+            {
+            connected[neighborId] = 1;
+            queue.push_back(neighborId);
+            }
+          }
+        }
+      }
+    for (vtkIdType id=0; id<numberOfBoxVoxels; id++)
+      {
+      if (!connected[id])
+        {
+        products[id] = 0.0f;
+        }
+      }
+    }
+
+  if (!wholeImage)
+    {
+    std::fill(outputScalars,outputScalars+numberOfVoxels,0.0f);
+    for (k=0; k<boxDimensions[2]; k++)
+      {
+      for (j=0; j<boxDimensions[1]; j++)
+        {
+        const float* row = products + k * boxSliceSize + static_cast<vtkIdType>(j) * boxDimensions[0];
+        std::copy(row,row+boxDimensions[0],outputScalars + (k + box[4]) * sliceSize + static_cast<vtkIdType>(j + box[2]) * dimensions[0] + box[0]);
+        }
+      }
+    }
+}
@@ -26,6 +26,19 @@ Version:   $Revision: 1.4 $
 // .NAME vtkvmtkCollidingFrontsImageFilter - Wrapper class around itk::CollidingFrontsImageFilter
 // .SECTION Description
 // vtkvmtkCollidingFrontsImageFilter
+//
+// By default both fronts are computed over the whole image by
+// itk::CollidingFrontsImageFilter. With BidirectionalPropagation on, the two
+// fronts are instead advanced together in a single sweep with
+// vtkvmtkNarrowBandFastMarching, always moving the front with the smaller
+// arrival time. Once they meet, the sum of the arrival times at the voxels
+// reached by both gives the seed-to-seed distance, and marching stops when
+// both fronts have gone past it, so the output covers the same collision
+// region as StopOnTargets. The output is the dot product of the two upwind
+// gradients (zero where a voxel was not reached by both fronts), restricted
+// to the region connected to the seeds if ApplyConnectivity is on.
+// UseSeedBoundingBox further restricts marching to the bounding box of the
+// seeds enlarged by SeedBoundingBoxMargin voxels.
 
 
 #ifndef __vtkvmtkCollidingFrontsImageFilter_h
@@ -52,6 +65,17 @@ class VTK_VMTK_SEGMENTATION_EXPORT vtkvmtkCollidingFrontsImageFilter : public vt
   vtkSetMacro(StopOnTargets,int);
   vtkBooleanMacro(StopOnTargets,int);
 
+  vtkGetMacro(BidirectionalPropagation,int);
+  vtkSetMacro(BidirectionalPropagation,int);
+  vtkBooleanMacro(BidirectionalPropagation,int);
+
+  vtkGetMacro(UseSeedBoundingBox,int);
+  vtkSetMacro(UseSeedBoundingBox,int);
+  vtkBooleanMacro(UseSeedBoundingBox,int);
+
+  vtkGetMacro(SeedBoundingBoxMargin,int);
+  vtkSetMacro(SeedBoundingBoxMargin,int);
+
   vtkSetObjectMacro(Seeds1,vtkIdList);
   vtkGetObjectMacro(Seeds1,vtkIdList);
 
@@ -65,6 +89,8 @@ protected:
 
   virtual void SimpleExecute(vtkImageData* input, vtkImageData* output) override;
 
+  void ExecuteBidirectional(vtkImageData* input, vtkImageData* output);
+
 private:
   vtkvmtkCollidingFrontsImageFilter(const vtkvmtkCollidingFrontsImageFilter&);  // Not implemented.
   void operator=(const vtkvmtkCollidingFrontsImageFilter&);  // Not implemented.
@@ -75,6 +101,9 @@ private:
   int ApplyConnectivity;
   double NegativeEpsilon;
   int StopOnTargets;
+  int BidirectionalPropagation;
+  int UseSeedBoundingBox;
+  int SeedBoundingBoxMargin;
 };
 
 #endif
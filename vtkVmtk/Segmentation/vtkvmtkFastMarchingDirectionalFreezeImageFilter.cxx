@@ -24,13 +24,86 @@ Version:   $Revision: 1.1 $
 =========================================================================*/
 
 #include "vtkvmtkFastMarchingDirectionalFreezeImageFilter.h"
+#include "vtkvmtkNarrowBandFastMarching.h"
+#include "vtkvmtkPolyBallLine.h"
+#include "vtkvmtkConstants.h"
+#include "vtkFloatArray.h"
+#include "vtkPointData.h"
+#include "vtkCellArray.h"
+#include "vtkMath.h"
 #include "vtkObjectFactory.h"
 
-#include "vtkvmtkITKFilterUtilities.h"
+vtkStandardNewMacro(vtkvmtkFastMarchingDirectionalFreezeImageFilter);
 
-#include "itkFastMarchingDirectionalFreezeImageFilter.h"
+namespace
+{
 
-vtkStandardNewMacro(vtkvmtkFastMarchingDirectionalFreezeImageFilter);
+// Collect the voxels inside the poly ball line of the centerlines. Each
+// segment only visits the voxels within the bounding box of its end balls.
+void BuildTubeDomain(vtkImageData* image, vtkPolyData* centerlines, vtkDataArray* radiusArray, double radiusFactor, std::unordered_set<vtkIdType>& domain)
+{
+  int imageExtent[6];
+  image->GetExtent(imageExtent);
+  double origin[3], spacing[3];
+  image->GetOrigin(origin);
+  image->GetSpacing(spacing);
+
+  vtkCellArray* lines = centerlines->GetLines();
+  vtkIdType npts;
+  const vtkIdType* pts;
+  for (lines->InitTraversal(); lines->GetNextCell(npts,pts); )
+    {
+    for (vtkIdType i=0; i<npts-1; i++)
+      {
+      double point0[3], point1[3];
+      centerlines->GetPoint(pts[i],point0);
+      centerlines->GetPoint(pts[i+1],point1);
+      double radius0 = radiusFactor * radiusArray->GetComponent(pts[i],0);
+      double radius1 = radiusFactor * radiusArray->GetComponent(pts[i+1],0);
+
+      int extent[6];
+      bool empty = false;
+      for (int j=0; j<3; j++)
+        {
+        double lower = std::min(point0[j] - radius0,point1[j] - radius1);
+        double upper = std::max(point0[j] + radius0,point1[j] + radius1);
+        extent[2*j] = std::max(static_cast<int>(ceil((lower - origin[j]) / spacing[j])),imageExtent[2*j]);
+        extent[2*j+1] = std::min(static_cast<int>(floor((upper - origin[j]) / spacing[j])),imageExtent[2*j+1]);
+        if (extent[2*j] > extent[2*j+1])
+          {
+          empty = true;
+          }
+        }
+      if (empty)
+        {
+        continue;
+        }
+
+      int ijk[3];
+      double x[3];
+      for (ijk[2]=extent[4]; ijk[2]<=extent[5]; ijk[2]++)
+        {
+        x[2] = origin[2] + ijk[2] * spacing[2];
+        for (ijk[1]=extent[2]; ijk[1]<=extent[3]; ijk[1]++)
+          {
+          x[1] = origin[1] + ijk[1] * spacing[1];
+          for (ijk[0]=extent[0]; ijk[0]<=extent[1]; ijk[0]++)
+            {
+            x[0] = origin[0] + ijk[0] * spacing[0];
+            double closestPoint[4];
+            double t;
+            if (vtkvmtkPolyBallLine::EvaluateSegmentFunction(x,point0,radius0,point1,radius1,closestPoint,t) <= 0.0)
+              {
+              domain.insert(image->ComputePointId(ijk));
+              }
+            }
+          }
+        }
+      }
+    }
+}
+
+}
 
 vtkvmtkFastMarchingDirectionalFreezeImageFilter::vtkvmtkFastMarchingDirectionalFreezeImageFilter()
 {
@@ -40,6 +113,9 @@ vtkvmtkFastMarchingDirectionalFreezeImageFilter::vtkvmtkFastMarchingDirectionalF
   this->TargetOffset = 0.0;
   this->Seeds = NULL;
   this->Targets = NULL;
+  this->Centerlines = NULL;
+  this->RadiusArrayName = NULL;
+  this->RadiusFactor = 1.0;
 }
 
 vtkvmtkFastMarchingDirectionalFreezeImageFilter::~vtkvmtkFastMarchingDirectionalFreezeImageFilter()
@@ -54,64 +130,106 @@ vtkvmtkFastMarchingDirectionalFreezeImageFilter::~vtkvmtkFastMarchingDirectional
       this->Targets->Delete();
       this->Targets = NULL;
     }
+  if (this->Centerlines)
+    {
+      this->Centerlines->Delete();
+      this->Centerlines = NULL;
+    }
+  if (this->RadiusArrayName)
+    {
+      delete[] this->RadiusArrayName;
+      this->RadiusArrayName = NULL;
+    }
 }
 
 void vtkvmtkFastMarchingDirectionalFreezeImageFilter::SimpleExecute(vtkImageData* input, vtkImageData* output)
 {
-  typedef itk::Image<float,3> ImageType;
+  if (input->GetScalarType() != VTK_FLOAT || input->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro(<<"Speed image must have one float component.");
+    return;
+    }
+
+  std::unordered_set<vtkIdType> tubeDomain;
+  if (this->Centerlines)
+    {
+    if (!this->RadiusArrayName)
+      {
+      vtkErrorMacro(<<"RadiusArrayName not specified.");
+      return;
+      }
+    vtkDataArray* radiusArray = this->Centerlines->GetPointData()->GetArray(this->RadiusArrayName);
+    if (!radiusArray)
+      {
+      vtkErrorMacro(<<"RadiusArray with name specified does not exist.");
+      return;
+      }
+    BuildTubeDomain(input,this->Centerlines,radiusArray,this->RadiusFactor,tubeDomain);
+    }
 
-  ImageType::Pointer inImage = ImageType::New();
+  int dimensions[3];
+  input->GetDimensions(dimensions);
+  double spacing[3];
+  input->GetSpacing(spacing);
+  vtkIdType numberOfVoxels = input->GetNumberOfPoints();
 
-  vtkvmtkITKFilterUtilities::VTKToITKImage<ImageType>(input,inImage);
+  const float* speed = static_cast<const float*>(input->GetScalarPointer());
+  float* outputScalars = static_cast<float*>(output->GetScalarPointer());
+  std::fill(outputScalars,outputScalars+numberOfVoxels,vtkvmtkNarrowBandFastMarching::GetLargeValue());
+
+  vtkvmtkNarrowBandFastMarching fastMarching(speed,dimensions,spacing,outputScalars);
+  fastMarching.SetDirectionalFreeze(true);
+  if (this->Centerlines)
+    {
+    fastMarching.SetDomain(&tubeDomain);
+    }
 
-  typedef itk::FastMarchingDirectionalFreezeImageFilter<ImageType,ImageType> FastMarchingFilterType;
+  vtkFloatArray* gradientArray = NULL;
+  if (this->GenerateGradientImage)
+    {
+    gradientArray = vtkFloatArray::New();
+    gradientArray->SetName("UpwindGradient");
+    gradientArray->SetNumberOfComponents(3);
+    gradientArray->SetNumberOfTuples(numberOfVoxels);
+    gradientArray->FillComponent(0,0.0);
+    gradientArray->FillComponent(1,0.0);
+    gradientArray->FillComponent(2,0.0);
+    fastMarching.SetGradient(gradientArray->GetPointer(0));
+    }
 
-  FastMarchingFilterType::Pointer fastMarchingFilter = FastMarchingFilterType::New();
-  fastMarchingFilter->SetInput(inImage);
-  fastMarchingFilter->SetGenerateGradientImage(this->GenerateGradientImage);
-  fastMarchingFilter->SetTargetOffset(this->TargetOffset);
   if (this->TargetReachedMode == ONE_TARGET)
     {
-      fastMarchingFilter->SetTargetReachedMode(FastMarchingFilterType::OneTarget);
+    fastMarching.SetTargetReachedMode(vtkvmtkNarrowBandFastMarching::ONE_TARGET);
     }
   else
     {
-      fastMarchingFilter->SetTargetReachedMode(FastMarchingFilterType::AllTargets);
+    fastMarching.SetTargetReachedMode(vtkvmtkNarrowBandFastMarching::ALL_TARGETS);
     }
+  fastMarching.SetTargetOffset(this->TargetOffset);
 
-  FastMarchingFilterType::NodeContainerPointer seeds = FastMarchingFilterType::NodeContainer::New();
-  int i;
-  for (i=0; i<this->Seeds->GetNumberOfIds(); i++)
+  if (this->Seeds)
     {
-    // TODO: here we get the point. We should get the cell center instead.
-    ImageType::PointType seedPoint(input->GetPoint(this->Seeds->GetId(i)));
-    FastMarchingFilterType::NodeType::IndexType seedIndex;
-    inImage->TransformPhysicalPointToIndex(seedPoint,seedIndex);
-    FastMarchingFilterType::PixelType seedValue = itk::NumericTraits<FastMarchingFilterType::PixelType>::Zero;
-    FastMarchingFilterType::NodeType seed;
-    seed.SetValue(seedValue);
-    seed.SetIndex(seedIndex);
-    seeds->InsertElement(i,seed);
+    for (vtkIdType i=0; i<this->Seeds->GetNumberOfIds(); i++)
+      {
+      fastMarching.AddSeed(this->Seeds->GetId(i),0.0f);
+      }
     }
-  fastMarchingFilter->SetTrialPoints(seeds);
 
-  FastMarchingFilterType::NodeContainerPointer targets = FastMarchingFilterType::NodeContainer::New();
-  for (i=0; i<this->Targets->GetNumberOfIds(); i++)
+  vtkIdList* targets = vtkIdList::New();
+  if (this->Targets)
     {
-    // TODO: here we get the point. We should get the cell center instead.
-    ImageType::PointType seedPoint(input->GetPoint(this->Targets->GetId(i)));
-    FastMarchingFilterType::NodeType::IndexType seedIndex;
-    inImage->TransformPhysicalPointToIndex(seedPoint,seedIndex);
-    FastMarchingFilterType::PixelType seedValue = itk::NumericTraits<FastMarchingFilterType::PixelType>::Zero;
-    FastMarchingFilterType::NodeType seed;
-    seed.SetValue(seedValue);
-    seed.SetIndex(seedIndex);
-    targets->InsertElement(i,seed);
+    targets->DeepCopy(this->Targets);
     }
-  fastMarchingFilter->SetTargetPoints(targets);
-  fastMarchingFilter->Update();
+  fastMarching.SetTargets(targets);
+  targets->Delete();
 
-  this->TargetValue = fastMarchingFilter->GetTargetValue();
+  fastMarching.Execute();
 
-  vtkvmtkITKFilterUtilities::ITKToVTKImage<ImageType>(fastMarchingFilter->GetOutput(),output);
+  this->TargetValue = fastMarching.GetTargetValue();
+
+  if (gradientArray)
+    {
+    output->GetPointData()->AddArray(gradientArray);
+    gradientArray->Delete();
+    }
 }
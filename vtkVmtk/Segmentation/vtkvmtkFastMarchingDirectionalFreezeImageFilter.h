@@ -23,9 +23,17 @@ Version:   $Revision: 1.4 $
 
 =========================================================================*/
 
-// .NAME vtkvmtkFastMarchingDirectionalFreezeImageFilter - Wrapper class around itk::FastMarchingDirectionalFreezeImageFilter
+// .NAME vtkvmtkFastMarchingDirectionalFreezeImageFilter - Fast marching freezing points where the front runs against the speed gradient
 // .SECTION Description
-// vtkvmtkFastMarchingDirectionalFreezeImageFilter
+// vtkvmtkFastMarchingDirectionalFreezeImageFilter computes arrival times
+// from Seeds with the semantics of itk::FastMarchingDirectionalFreezeImageFilter,
+// using vtkvmtkNarrowBandFastMarching on the output buffer.
+//
+// If Centerlines is set, marching is further confined to the tube obtained
+// by sweeping the maximal inscribed spheres of the centerlines (radii from
+// RadiusArrayName, scaled by RadiusFactor) as vtkvmtkPolyBallLine does.
+// Voxels outside the tube are frozen and keep a large value; only the
+// voxels within the tube are ever visited.
 
 
 #ifndef __vtkvmtkFastMarchingDirectionalFreezeImageFilter_h
@@ -33,6 +41,7 @@ Version:   $Revision: 1.4 $
 
 #include "vtkSimpleImageToImageFilter.h"
 #include "vtkIdList.h"
+#include "vtkPolyData.h"
 #include "vtkvmtkWin32Header.h"
 
 class VTK_VMTK_SEGMENTATION_EXPORT vtkvmtkFastMarchingDirectionalFreezeImageFilter : public vtkSimpleImageToImageFilter
@@ -75,6 +84,15 @@ class VTK_VMTK_SEGMENTATION_EXPORT vtkvmtkFastMarchingDirectionalFreezeImageFilt
   vtkSetObjectMacro(Targets,vtkIdList);
   vtkGetObjectMacro(Targets,vtkIdList);
 
+  vtkSetObjectMacro(Centerlines,vtkPolyData);
+  vtkGetObjectMacro(Centerlines,vtkPolyData);
+
+  vtkSetStringMacro(RadiusArrayName);
+  vtkGetStringMacro(RadiusArrayName);
+
+  vtkSetMacro(RadiusFactor,double);
+  vtkGetMacro(RadiusFactor,double);
+
 protected:
   vtkvmtkFastMarchingDirectionalFreezeImageFilter();
   ~vtkvmtkFastMarchingDirectionalFreezeImageFilter();
@@ -92,6 +110,10 @@ private:
 
   vtkIdList* Seeds;
   vtkIdList* Targets;
+
+  vtkPolyData* Centerlines;
+  char* RadiusArrayName;
+  double RadiusFactor;
 };
 
 #endif
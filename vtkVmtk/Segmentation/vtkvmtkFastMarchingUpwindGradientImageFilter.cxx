@@ -24,12 +24,11 @@ Version:   $Revision: 1.1 $
 =========================================================================*/
 
 #include "vtkvmtkFastMarchingUpwindGradientImageFilter.h"
+#include "vtkvmtkNarrowBandFastMarching.h"
+#include "vtkFloatArray.h"
+#include "vtkPointData.h"
 #include "vtkObjectFactory.h"
 
-#include "vtkvmtkITKFilterUtilities.h"
-
-#include <itkFastMarchingUpwindGradientImageFilter.h>
-
 vtkStandardNewMacro(vtkvmtkFastMarchingUpwindGradientImageFilter);
 
 vtkvmtkFastMarchingUpwindGradientImageFilter::vtkvmtkFastMarchingUpwindGradientImageFilter()
@@ -58,60 +57,74 @@ vtkvmtkFastMarchingUpwindGradientImageFilter::~vtkvmtkFastMarchingUpwindGradient
 
 void vtkvmtkFastMarchingUpwindGradientImageFilter::SimpleExecute(vtkImageData* input, vtkImageData* output)
 {
-  typedef itk::Image<float,3> ImageType;
+  if (input->GetScalarType() != VTK_FLOAT || input->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro(<<"Speed image must have one float component.");
+    return;
+    }
+
+  int dimensions[3];
+  input->GetDimensions(dimensions);
+  double spacing[3];
+  input->GetSpacing(spacing);
+  vtkIdType numberOfVoxels = input->GetNumberOfPoints();
 
-  ImageType::Pointer inImage = ImageType::New();
+  const float* speed = static_cast<const float*>(input->GetScalarPointer());
+  float* outputScalars = static_cast<float*>(output->GetScalarPointer());
+  std::fill(outputScalars,outputScalars+numberOfVoxels,vtkvmtkNarrowBandFastMarching::GetLargeValue());
 
-  vtkvmtkITKFilterUtilities::VTKToITKImage<ImageType>(input,inImage);
+  vtkvmtkNarrowBandFastMarching fastMarching(speed,dimensions,spacing,outputScalars);
 
-  typedef itk::FastMarchingUpwindGradientImageFilter<ImageType,ImageType> FastMarchingFilterType;
+  vtkFloatArray* gradientArray = NULL;
+  if (this->GenerateGradientImage)
+    {
+    gradientArray = vtkFloatArray::New();
+    gradientArray->SetName("UpwindGradient");
+    gradientArray->SetNumberOfComponents(3);
+    gradientArray->SetNumberOfTuples(numberOfVoxels);
+    gradientArray->FillComponent(0,0.0);
+    gradientArray->FillComponent(1,0.0);
+    gradientArray->FillComponent(2,0.0);
+    fastMarching.SetGradient(gradientArray->GetPointer(0));
+    }
 
-  FastMarchingFilterType::Pointer fastMarchingFilter = FastMarchingFilterType::New();
-  fastMarchingFilter->SetInput(inImage);
-  fastMarchingFilter->SetGenerateGradientImage(this->GenerateGradientImage);
-  fastMarchingFilter->SetTargetOffset(this->TargetOffset);
+  // As with itk::FastMarchingUpwindGradientImageFilter, anything but
+  // ONE_TARGET waits for all the targets to be reached. With no targets
+  // this stops TargetOffset past the first alive point.
   if (this->TargetReachedMode == ONE_TARGET)
     {
-    fastMarchingFilter->SetTargetReachedMode(FastMarchingFilterType::OneTarget);
+    fastMarching.SetTargetReachedMode(vtkvmtkNarrowBandFastMarching::ONE_TARGET);
     }
   else
     {
-    fastMarchingFilter->SetTargetReachedMode(FastMarchingFilterType::AllTargets);
+    fastMarching.SetTargetReachedMode(vtkvmtkNarrowBandFastMarching::ALL_TARGETS);
     }
+  fastMarching.SetTargetOffset(this->TargetOffset);
 
-  FastMarchingFilterType::NodeContainerPointer seeds = FastMarchingFilterType::NodeContainer::New();
-  int i;
-  for (i=0; i<this->Seeds->GetNumberOfIds(); i++)
+  // Seeds and targets are point ids, i.e. offsets in the scalar buffers.
+  if (this->Seeds)
     {
-    // TODO: here we get the point. We should get the cell center instead.
-    ImageType::PointType seedPoint(input->GetPoint(this->Seeds->GetId(i)));
-    FastMarchingFilterType::NodeType::IndexType seedIndex;
-    inImage->TransformPhysicalPointToIndex(seedPoint,seedIndex);
-    FastMarchingFilterType::PixelType seedValue = itk::NumericTraits<FastMarchingFilterType::PixelType>::Zero;
-    FastMarchingFilterType::NodeType seed;
-    seed.SetValue(seedValue);
-    seed.SetIndex(seedIndex);
-    seeds->InsertElement(i,seed);
+    for (vtkIdType i=0; i<this->Seeds->GetNumberOfIds(); i++)
+      {
+      fastMarching.AddSeed(this->Seeds->GetId(i),0.0f);
+      }
     }
-  fastMarchingFilter->SetTrialPoints(seeds);
 
-  FastMarchingFilterType::NodeContainerPointer targets = FastMarchingFilterType::NodeContainer::New();
-  for (i=0; i<this->Targets->GetNumberOfIds(); i++)
+  vtkIdList* targets = vtkIdList::New();
+  if (this->Targets)
     {
-    // TODO: here we get the point. We should get the cell center instead.
-    ImageType::PointType seedPoint(input->GetPoint(this->Targets->GetId(i)));
-    FastMarchingFilterType::NodeType::IndexType seedIndex;
-    inImage->TransformPhysicalPointToIndex(seedPoint,seedIndex);
-    FastMarchingFilterType::PixelType seedValue = itk::NumericTraits<FastMarchingFilterType::PixelType>::Zero;
-    FastMarchingFilterType::NodeType seed;
-    seed.SetValue(seedValue);
-    seed.SetIndex(seedIndex);
-    targets->InsertElement(i,seed);
+    targets->DeepCopy(this->Targets);
     }
-  fastMarchingFilter->SetTargetPoints(targets);
-  fastMarchingFilter->Update();
+  fastMarching.SetTargets(targets);
+  targets->Delete();
 
-  this->TargetValue = fastMarchingFilter->GetTargetValue();
+  fastMarching.Execute();
 
-  vtkvmtkITKFilterUtilities::ITKToVTKImage<ImageType>(fastMarchingFilter->GetOutput(),output);
+  this->TargetValue = fastMarching.GetTargetValue();
+
+  if (gradientArray)
+    {
+    output->GetPointData()->AddArray(gradientArray);
+    gradientArray->Delete();
+    }
 }
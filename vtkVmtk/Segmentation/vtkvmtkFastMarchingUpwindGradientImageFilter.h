@@ -23,9 +23,15 @@ Version:   $Revision: 1.4 $
 
 =========================================================================*/
 
-// .NAME vtkvmtkFastMarchingUpwindGradientImageFilter - Wrapper class around itk::FastMarchingUpwindGradientImageFilter
+// .NAME vtkvmtkFastMarchingUpwindGradientImageFilter - Fast marching arrival times from seed points
 // .SECTION Description
-// vtkvmtkFastMarchingUpwindGradientImageFilter
+// vtkvmtkFastMarchingUpwindGradientImageFilter computes the arrival times of
+// a front started at Seeds on a float speed image, with the semantics of
+// itk::FastMarchingUpwindGradientImageFilter. Marching is done by
+// vtkvmtkNarrowBandFastMarching directly in the output buffer and stops
+// TargetOffset past the arrival time at the targets; voxels not reached keep
+// a large value. If GenerateGradientImage is on, the upwind gradient is
+// added to the output point data as UpwindGradient.
 
 
 #ifndef __vtkvmtkFastMarchingUpwindGradientImageFilter_h
@@ -35,7 +35,11 @@ Version:   $Revision: 1.2 $
 #include "vtkvmtkWin32Header.h"
 
 #include "vtkImageData.h"
+#include "vtkPointData.h"
+#include "vtkDataArray.h"
+#include "vtkTypeTraits.h"
 #include "itkImage.h"
+#include "itkNumericTraits.h"
 #include "itkCommand.h"
 
 class VTK_VMTK_SEGMENTATION_EXPORT vtkvmtkITKFilterUtilities
@@ -169,16 +173,88 @@ public:
     extent[4] = index[2];
     extent[5] = index[2] + size[2] - 1;
 
+    typedef typename itk::NumericTraits<PixelType>::ValueType ComponentType;
+
     int components = input->GetNumberOfComponentsPerPixel();
     int dataType = output->GetScalarType(); // WARNING: we delegate setting type to caller
+    if (!output->GetPointData()->GetScalars())
+      {
+      // caller did not set a type (e.g. a freshly created auxiliary output): use the ITK pixel type
+      dataType = vtkTypeTraits<ComponentType>::VTKTypeID();
+      }
 
     //output->SetDimensions(dimensions);
     output->SetExtent(extent);
+
+    if (vtkvmtkITKFilterUtilities::AdoptITKPixelContainer<ImageType>(input,output,dataType,components))
+      {
+      return;
+      }
+
     output->AllocateScalars(dataType,components);
 
     memcpy(static_cast<PixelType*>(output->GetScalarPointer()),input->GetBufferPointer(),input->GetBufferedRegion().GetNumberOfPixels()*sizeof(PixelType));
   }
 
+  // Description:
+  // Hands the pixel buffer of an ITK image over to a new VTK scalar array, avoiding
+  // the allocation and copy of ITKToVTKImage. This is only possible if the pixel
+  // container owns its memory (i.e. it was allocated by an ITK filter, not imported
+  // from VTK) and the buffer layout matches the requested VTK scalar type. On success
+  // the container releases ownership and the VTK array frees the buffer when deleted;
+  // the ITK image must not be used to modify the buffer afterwards. Returns false if
+  // the buffer cannot be adopted, in which case the caller has to copy.
+  template<typename TImage>
+  static bool
+  AdoptITKPixelContainer(typename TImage::Pointer input, vtkImageData* output, int dataType, int components) {
+
+    typedef TImage ImageType;
+    typedef typename ImageType::PixelContainer PixelContainerType;
+    typedef typename PixelContainerType::Element ElementType;
+
+    PixelContainerType* container = input->GetPixelContainer();
+    if (!container || !container->GetContainerManageMemory() || !container->GetImportPointer())
+      {
+      return false;
+      }
+
+    vtkIdType numberOfTuples = static_cast<vtkIdType>(input->GetBufferedRegion().GetNumberOfPixels());
+    size_t bufferSize = static_cast<size_t>(container->Size()) * sizeof(ElementType);
+    if (bufferSize != static_cast<size_t>(numberOfTuples) * components * vtkDataArray::GetDataTypeSize(dataType))
+      {
+      return false;
+      }
+
+    vtkDataArray* scalars = vtkDataArray::CreateDataArray(dataType);
+    if (!scalars)
+      {
+      return false;
+      }
+
+    vtkDataArray* previousScalars = output->GetPointData()->GetScalars();
+    scalars->SetName(previousScalars && previousScalars->GetName() ? previousScalars->GetName() : "ImageScalars");
+    scalars->SetNumberOfComponents(components);
+
+    ElementType* buffer = container->GetImportPointer();
+    container->SetContainerManageMemory(false);
+
+    scalars->SetVoidArray(buffer,numberOfTuples*components,0,vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+    scalars->SetArrayFreeFunction(&vtkvmtkITKFilterUtilities::DeleteITKPixelBuffer<ElementType>);
+
+    output->GetPointData()->SetScalars(scalars);
+    scalars->Delete();
+
+    return true;
+  }
+
+  template<typename TElement>
+  static void
+  DeleteITKPixelBuffer(void* buffer)
+  {
+    // matches the new[] in itk::ImportImageContainer::AllocateElements
+    delete[] static_cast<TElement*>(buffer);
+  }
+
   static void
   ProgressCallback(itk::Object *o, const itk::EventObject &, void *data)
   {
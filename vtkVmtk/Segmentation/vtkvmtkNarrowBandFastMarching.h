@@ -0,0 +1,562 @@
+/*=========================================================================
+
+Program:   VMTK
+Module:    vtkvmtkNarrowBandFastMarching.h
+Language:  C++
+Date:      $Date: 2006/04/06 16:48:25 $
+Version:   $Revision: 1.1 $
+
+  Copyright (c) Luca Antiga, David Steinman. All rights reserved.
+  See LICENSE file for details.
+
+  Portions of this code are covered under the VTK copyright.
+  See VTKCopyright.txt or http://www.kitware.com/VTKCopyright.htm
+  for details.
+
+  Portions of this code are covered under the ITK copyright.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm
+  for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+
+// .NAME vtkvmtkNarrowBandFastMarching - fast marching with a sparse narrow band
+// .SECTION Description
+// vtkvmtkNarrowBandFastMarching solves the Eikonal equation on a float speed
+// image with the first order scheme of itk::FastMarchingImageFilter, and
+// handles target points and the upwind gradient as
+// itk::FastMarchingUpwindGradientImageFilter does.
+//
+// No label image is allocated: the voxels reached so far are kept in a hash
+// map, holding either the position of a trial voxel in an indexed binary heap
+// or the alive state. Trial values are updated in place in the heap instead
+// of pushing duplicates. Arrival times (and gradients, if requested) are
+// written to buffers owned by the caller, which must hold GetLargeValue()
+// (zero for the gradient) on entry; only reached voxels are written, and
+// marching stops as soon as the stopping value is exceeded, so the work done
+// depends on the explored region only.
+//
+// Voxels are addressed by their offset in the buffers (the point id of the
+// image). Step() makes one voxel alive, so that several fronts can be
+// advanced in lockstep by the caller.
+//
+// Marching can be confined to a sparse set of voxels (e.g. a tube around a
+// centerline); voxels outside it are never reached. With DirectionalFreeze
+// on, an alive voxel whose front direction opposes the speed gradient by
+// more than the freeze threshold does not update its neighbors, as in
+// itk::FastMarchingDirectionalFreezeImageFilter. The speed gradient is
+// computed on the fly by central differences, as itk::GradientImageFilter
+// does.
+
+#ifndef __vtkvmtkNarrowBandFastMarching_h
+#define __vtkvmtkNarrowBandFastMarching_h
+
+#include "vtkIdList.h"
+#include "vtkType.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class vtkvmtkNarrowBandFastMarching
+{
+public:
+
+  // Description:
+  // Same values as the TargetReachedMode of
+  // vtkvmtkFastMarchingUpwindGradientImageFilter.
+  enum
+  {
+    ONE_TARGET,
+    ALL_TARGETS,
+    NO_TARGETS
+  };
+
+  vtkvmtkNarrowBandFastMarching(const float* speed, const int dimensions[3], const double spacing[3], float* output)
+    : Speed(speed), Output(output), Gradient(NULL), Domain(NULL)
+  {
+    for (int i=0; i<3; i++)
+      {
+      this->Dimensions[i] = dimensions[i];
+      this->SpaceFactors[i] = 1.0 / (spacing[i] * spacing[i]);
+      this->Spacing[i] = spacing[i];
+      }
+    this->NumberOfVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+    this->TargetReachedMode = NO_TARGETS;
+    this->UseTargets = false;
+    this->NumberOfReachedTargets = 0;
+    this->TargetOffset = 0.0;
+    this->TargetValue = 0.0;
+    this->StoppingValue = GetLargeValue();
+    this->DirectionalFreeze = false;
+    this->DirectionalFreezeThreshold = -0.6;
+  }
+
+  // Description:
+  // Arrival time of voxels not reached, as in itk::FastMarchingImageFilter.
+  static float GetLargeValue()
+  {
+    return std::numeric_limits<float>::max() / 2.0f;
+  }
+
+  // Description:
+  // Buffer of 3 components per voxel receiving the upwind gradient of alive
+  // voxels. Must be zero on entry.
+  void SetGradient(float* gradient)
+  {
+    this->Gradient = gradient;
+  }
+
+  // Description:
+  // Voxels that can be reached, NULL (default) for the whole image. The set
+  // is not copied and must outlive marching.
+  void SetDomain(const std::unordered_set<vtkIdType>* domain)
+  {
+    this->Domain = domain;
+  }
+
+  // Description:
+  // Freeze alive voxels where the cosine between the front direction and
+  // the speed gradient is below the threshold.
+  void SetDirectionalFreeze(bool freeze) { this->DirectionalFreeze = freeze; }
+  void SetDirectionalFreezeThreshold(double threshold) { this->DirectionalFreezeThreshold = threshold; }
+
+  // Description:
+  // Add a trial voxel with the given arrival time. Seed values are never
+  // updated by neighbors. Voxels out of the image are ignored.
+  void AddSeed(vtkIdType id, float value = 0.0f)
+  {
+    if (id < 0 || id >= this->NumberOfVoxels)
+      {
+      return;
+      }
+    this->Seeds.insert(id);
+    this->Output[id] = value;
+    this->SetTrialValue(id,value);
+  }
+
+  // Description:
+  // Target voxels. Once the target condition is met the stopping value is
+  // lowered to the target arrival time plus TargetOffset. A NULL list
+  // disables targets.
+  void SetTargets(vtkIdList* targets)
+  {
+    this->Targets.clear();
+    this->UseTargets = targets != NULL;
+    this->NumberOfTargets = 0;
+    if (targets)
+      {
+      this->NumberOfTargets = targets->GetNumberOfIds();
+      for (vtkIdType i=0; i<targets->GetNumberOfIds(); i++)
+        {
+        this->Targets.insert(targets->GetId(i));
+        }
+      }
+  }
+
+  void SetTargetReachedMode(int mode) { this->TargetReachedMode = mode; }
+  void SetTargetOffset(double offset) { this->TargetOffset = offset; }
+  void SetStoppingValue(double value) { this->StoppingValue = value; }
+  double GetStoppingValue() const { return this->StoppingValue; }
+
+  // Description:
+  // Arrival time of the target that met the target condition or, without
+  // targets, of the last alive voxel.
+  double GetTargetValue() const { return this->TargetValue; }
+
+  // Description:
+  // Number of voxels reached (trial or alive).
+  vtkIdType GetNumberOfVisitedVoxels() const { return static_cast<vtkIdType>(this->States.size()); }
+
+  bool IsAlive(vtkIdType id) const
+  {
+    std::unordered_map<vtkIdType,vtkIdType>::const_iterator it = this->States.find(id);
+    return it != this->States.end() && it->second == ALIVE;
+  }
+
+  // Description:
+  // Smallest trial arrival time, or the large value if there is none.
+  float GetFrontValue() const
+  {
+    return this->Heap.empty() ? GetLargeValue() : this->Heap[0].Value;
+  }
+
+  // Description:
+  // Make the trial voxel with the smallest arrival time alive and update its
+  // neighbors. Returns the id of the new alive voxel, or -1 when marching is
+  // over (no trial voxels left or stopping value exceeded).
+  vtkIdType Step()
+  {
+    if (this->Heap.empty() || this->Heap[0].Value > this->StoppingValue)
+      {
+      return -1;
+      }
+    HeapNode node = this->Heap[0];
+    this->PopHeap();
+    this->States[node.Id] = ALIVE;
+
+    int ijk[3];
+    this->GetIndex(node.Id,ijk);
+    if (this->DirectionalFreeze && this->IsFrozen(node.Id,ijk))
+      {
+      return node.Id;
+      }
+    this->UpdateNeighbors(node.Id,ijk);
+    if (this->Gradient)
+      {
+      this->ComputeGradient(node.Id,ijk);
+      }
+    this->CheckTargets(node.Id);
+    return node.Id;
+  }
+
+  // Description:
+  // March until no trial voxels are left or the stopping value is exceeded.
+  void Execute()
+  {
+    while (this->Step() >= 0)
+      {
+      }
+  }
+
+protected:
+
+  enum
+  {
+    ALIVE = -1
+  };
+
+  struct HeapNode
+  {
+    float Value;
+    vtkIdType Id;
+  };
+
+  void GetIndex(vtkIdType id, int ijk[3]) const
+  {
+    vtkIdType sliceSize = static_cast<vtkIdType>(this->Dimensions[0]) * this->Dimensions[1];
+    ijk[2] = static_cast<int>(id / sliceSize);
+    vtkIdType rest = id - ijk[2] * sliceSize;
+    ijk[1] = static_cast<int>(rest / this->Dimensions[0]);
+    ijk[0] = static_cast<int>(rest - ijk[1] * this->Dimensions[0]);
+  }
+
+  vtkIdType GetStride(int axis) const
+  {
+    return axis == 0 ? 1 : axis == 1 ? this->Dimensions[0] : static_cast<vtkIdType>(this->Dimensions[0]) * this->Dimensions[1];
+  }
+
+  void UpdateNeighbors(vtkIdType id, const int ijk[3])
+  {
+    int neighborIjk[3] = { ijk[0], ijk[1], ijk[2] };
+    for (int axis=0; axis<3; axis++)
+      {
+      vtkIdType stride = this->GetStride(axis);
+      for (int s=-1; s<2; s+=2)
+        {
+        int index = ijk[axis] + s;
+        if (index < 0 || index >= this->Dimensions[axis])
+          {
+          continue;
+          }
+        vtkIdType neighborId = id + s * stride;
+        if (this->IsAlive(neighborId) || this->Seeds.find(neighborId) != this->Seeds.end() ||
+            (this->Domain && this->Domain->find(neighborId) == this->Domain->end()))
+          {
+          continue;
+          }
+        neighborIjk[axis] = index;
+        this->UpdateValue(neighborId,neighborIjk);
+        neighborIjk[axis] = ijk[axis];
+        }
+      }
+  }
+
+  // Description:
+  // Solve the upwind quadratic with the alive neighbors of the voxel, in
+  // increasing order of arrival time, as itk::FastMarchingImageFilter does.
+  void UpdateValue(vtkIdType id, const int ijk[3])
+  {
+    const float largeValue = GetLargeValue();
+    float values[3];
+    int axes[3];
+    for (int axis=0; axis<3; axis++)
+      {
+      values[axis] = largeValue;
+      axes[axis] = axis;
+      vtkIdType stride = this->GetStride(axis);
+      for (int s=-1; s<2; s+=2)
+        {
+        int index = ijk[axis] + s;
+        if (index < 0 || index >= this->Dimensions[axis])
+          {
+          continue;
+          }
+        vtkIdType neighborId = id + s * stride;
+        if (this->IsAlive(neighborId) && this->Output[neighborId] < values[axis])
+          {
+          values[axis] = this->Output[neighborId];
+          }
+        }
+      }
+
+    // sort the three axes by neighbor value
+    for (int i=1; i<3; i++)
+      {
+      for (int j=i; j>0 && values[j] < values[j-1]; j--)
+        {
+        std::swap(values[j],values[j-1]);
+        std::swap(axes[j],axes[j-1]);
+        }
+      }
+
+    double cc = static_cast<double>(this->Speed[id]);
+    cc = -1.0 * (1.0 / cc) * (1.0 / cc);
+    double aa = 0.0;
+    double bb = 0.0;
+    double solution = largeValue;
+    for (int j=0; j<3; j++)
+      {
+      if (solution < values[j])
+        {
+        break;
+        }
+      const double spaceFactor = this->SpaceFactors[axes[j]];
+      const double value = values[j];
+      aa += spaceFactor;
+      bb += value * spaceFactor;
+      cc += value * value * spaceFactor;
+      double discrim = bb * bb - aa * cc;
+      if (discrim < 0.0)
+        {
+        // keep the solution found with the previous axes
+        break;
+        }
+      solution = (sqrt(discrim) + bb) / aa;
+      }
+
+    if (solution < largeValue)
+      {
+      float value = static_cast<float>(solution);
+      this->Output[id] = value;
+      this->SetTrialValue(id,value);
+      }
+  }
+
+  void ComputeGradient(vtkIdType id, const int ijk[3])
+  {
+    this->ComputeUpwindGradient(id,ijk,this->Gradient + 3 * id);
+  }
+
+  // Description:
+  // One sided differences towards alive neighbors, where the front comes
+  // from.
+  void ComputeUpwindGradient(vtkIdType id, const int ijk[3], float gradient[3]) const
+  {
+    const float centerValue = this->Output[id];
+    for (int axis=0; axis<3; axis++)
+      {
+      vtkIdType stride = this->GetStride(axis);
+      float backward = 0.0f;
+      float forward = 0.0f;
+      if (ijk[axis] > 0 && this->IsAlive(id - stride))
+        {
+        backward = centerValue - this->Output[id - stride];
+        }
+      if (ijk[axis] < this->Dimensions[axis] - 1 && this->IsAlive(id + stride))
+        {
+        forward = this->Output[id + stride] - centerValue;
+        }
+      float value;
+      if (std::max(backward,-forward) < 0.0f)
+        {
+        value = 0.0f;
+        }
+      else if (backward > -forward)
+        {
+        value = backward;
+        }
+      else
+        {
+        value = forward;
+        }
+      gradient[axis] = static_cast<float>(value / this->Spacing[axis]);
+      }
+  }
+
+  bool IsFrozen(vtkIdType id, const int ijk[3]) const
+  {
+    float frontGradient[3];
+    this->ComputeUpwindGradient(id,ijk,frontGradient);
+    double speedGradient[3];
+    double frontNorm = 0.0;
+    double speedNorm = 0.0;
+    double dot = 0.0;
+    for (int axis=0; axis<3; axis++)
+      {
+      vtkIdType stride = this->GetStride(axis);
+      vtkIdType backwardId = ijk[axis] > 0 ? id - stride : id;
+      vtkIdType forwardId = ijk[axis] < this->Dimensions[axis] - 1 ? id + stride : id;
+      speedGradient[axis] = (this->Speed[forwardId] - this->Speed[backwardId]) / (2.0 * this->Spacing[axis]);
+      frontNorm += frontGradient[axis] * frontGradient[axis];
+      speedNorm += speedGradient[axis] * speedGradient[axis];
+      dot += frontGradient[axis] * speedGradient[axis];
+      }
+    if (frontNorm == 0.0 || speedNorm == 0.0)
+      {
+      return false;
+      }
+    return dot / sqrt(frontNorm * speedNorm) < this->DirectionalFreezeThreshold;
+  }
+
+  void CheckTargets(vtkIdType id)
+  {
+    if (this->TargetReachedMode == NO_TARGETS || !this->UseTargets)
+      {
+      this->TargetValue = this->Output[id];
+      return;
+      }
+    bool isTarget = this->Targets.find(id) != this->Targets.end();
+    bool targetReached = false;
+    if (this->TargetReachedMode == ONE_TARGET)
+      {
+      targetReached = isTarget;
+      }
+    else
+      {
+      if (isTarget)
+        {
+        this->NumberOfReachedTargets++;
+        }
+      targetReached = this->NumberOfReachedTargets == this->NumberOfTargets;
+      }
+    if (targetReached)
+      {
+      this->TargetValue = this->Output[id];
+      double stoppingValue = this->TargetValue + this->TargetOffset;
+      if (stoppingValue < this->StoppingValue)
+        {
+        this->StoppingValue = stoppingValue;
+        }
+      }
+  }
+
+  // Description:
+  // Insert a trial voxel in the heap, or move it to its new value.
+  void SetTrialValue(vtkIdType id, float value)
+  {
+    std::pair<std::unordered_map<vtkIdType,vtkIdType>::iterator,bool> inserted =
+      this->States.insert(std::make_pair(id,static_cast<vtkIdType>(this->Heap.size())));
+    if (inserted.second)
+      {
+      HeapNode node = { value, id };
+      this->Heap.push_back(node);
+      this->SiftUp(this->Heap.size()-1);
+      return;
+      }
+    vtkIdType position = inserted.first->second;
+    if (position == ALIVE)
+      {
+      return;
+      }
+    float oldValue = this->Heap[position].Value;
+    this->Heap[position].Value = value;
+    if (value < oldValue)
+      {
+      this->SiftUp(position);
+      }
+    else
+      {
+      this->SiftDown(position);
+      }
+  }
+
+  void PopHeap()
+  {
+    this->Heap[0] = this->Heap.back();
+    this->Heap.pop_back();
+    if (!this->Heap.empty())
+      {
+      this->States[this->Heap[0].Id] = 0;
+      this->SiftDown(0);
+      }
+  }
+
+  void SiftUp(size_t position)
+  {
+    HeapNode node = this->Heap[position];
+    while (position > 0)
+      {
+      size_t parent = (position - 1) / 2;
+      if (!(node.Value < this->Heap[parent].Value))
+        {
+        break;
+        }
+      this->Heap[position] = this->Heap[parent];
+      this->States[this->Heap[position].Id] = static_cast<vtkIdType>(position);
+      position = parent;
+      }
+    this->Heap[position] = node;
+    this->States[node.Id] = static_cast<vtkIdType>(position);
+  }
+
+  void SiftDown(size_t position)
+  {
+    HeapNode node = this->Heap[position];
+    size_t size = this->Heap.size();
+    while (true)
+      {
+      size_t child = 2 * position + 1;
+      if (child >= size)
+        {
+        break;
+        }
+      if (child + 1 < size && this->Heap[child+1].Value < this->Heap[child].Value)
+        {
+        child++;
+        }
+      if (!(this->Heap[child].Value < node.Value))
+        {
+        break;
+        }
+      this->Heap[position] = this->Heap[child];
+      this->States[this->Heap[position].Id] = static_cast<vtkIdType>(position);
+      position = child;
+      }
+    this->Heap[position] = node;
+    this->States[node.Id] = static_cast<vtkIdType>(position);
+  }
+
+  const float* Speed;
+  float* Output;
+  float* Gradient;
+  int Dimensions[3];
+  double Spacing[3];
+  double SpaceFactors[3];
+  vtkIdType NumberOfVoxels;
+  const std::unordered_set<vtkIdType>* Domain;
+  bool DirectionalFreeze;
+  double DirectionalFreezeThreshold;
+
+  // heap position of trial voxels, ALIVE for alive ones
+  std::unordered_map<vtkIdType,vtkIdType> States;
+  std::vector<HeapNode> Heap;
+  std::unordered_set<vtkIdType> Seeds;
+
+  std::unordered_set<vtkIdType> Targets;
+  vtkIdType NumberOfTargets;
+  vtkIdType NumberOfReachedTargets;
+  bool UseTargets;
+  int TargetReachedMode;
+  double TargetOffset;
+  double TargetValue;
+  double StoppingValue;
+};
+
+#endif
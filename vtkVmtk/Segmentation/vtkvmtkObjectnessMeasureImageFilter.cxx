@@ -30,6 +30,7 @@ Version:   $Revision: 1.1 $
 
 #include "itkMultiScaleHessianBasedMeasureImageFilter.h"
 #include "itkHessianToObjectnessMeasureImageFilter.h"
+#include "itkFusedMultiScaleHessianMeasureImageFilter.h"
 
 vtkStandardNewMacro(vtkvmtkObjectnessMeasureImageFilter);
 
@@ -44,6 +45,7 @@ vtkvmtkObjectnessMeasureImageFilter::vtkvmtkObjectnessMeasureImageFilter()
   this->Beta = 1.0;
   this->Gamma = 1.0;
   this->ObjectDimension = 1;
+  this->UseFusedMultiScale = 0;
   this->ScalesOutput = NULL;
 }
 
@@ -64,6 +66,41 @@ void vtkvmtkObjectnessMeasureImageFilter::SimpleExecute(vtkImageData* input, vtk
 
   vtkvmtkITKFilterUtilities::VTKToITKImage<ImageType>(input,inImage);
 
+  if (this->ScalesOutput)
+    {
+      this->ScalesOutput->Delete();
+      this->ScalesOutput = NULL;
+    }
+
+  this->ScalesOutput = vtkImageData::New();
+
+  if (this->UseFusedMultiScale)
+    {
+    typedef itk::FusedMultiScaleHessianMeasureImageFilter<ImageType,ImageType> FusedFilterType;
+
+    FusedFilterType::Pointer fusedFilter = FusedFilterType::New();
+    fusedFilter->SetInput(inImage);
+    fusedFilter->SetMeasure(FusedFilterType::OBJECTNESS);
+    fusedFilter->SetSigmaMinimum(this->SigmaMin);
+    fusedFilter->SetSigmaMaximum(this->SigmaMax);
+    fusedFilter->SetNumberOfSigmaSteps(this->NumberOfSigmaSteps);
+    fusedFilter->SetSigmaStepMethod(this->SigmaStepMethod == LOGARITHMIC ? FusedFilterType::LOGARITHMIC : FusedFilterType::EQUISPACED);
+    fusedFilter->SetScaleObjectnessMeasure(this->UseScaledObjectness);
+    fusedFilter->SetBrightObject(true);
+    fusedFilter->SetObjectDimension(this->ObjectDimension);
+    fusedFilter->SetAlpha(this->Alpha);
+    fusedFilter->SetBeta(this->Beta);
+    fusedFilter->SetGamma(this->Gamma);
+    vtkvmtkITKFilterUtilities::ConnectProgress(fusedFilter,this);
+    fusedFilter->Update();
+
+    ImageType::Pointer scalesImage = const_cast<ImageType*>(fusedFilter->GetScalesOutput());
+    vtkvmtkITKFilterUtilities::ITKToVTKImage<ImageType>(scalesImage,this->ScalesOutput);
+
+    vtkvmtkITKFilterUtilities::ITKToVTKImage<ImageType>(fusedFilter->GetOutput(),output);
+    return;
+    }
+
   typedef itk::SymmetricSecondRankTensor<float,3> HessianPixelType;
   typedef itk::Image<HessianPixelType,3> HessianImageType;
   typedef itk::HessianToObjectnessMeasureImageFilter<HessianImageType,ImageType> ObjectnessFilterType;
@@ -95,14 +132,6 @@ void vtkvmtkObjectnessMeasureImageFilter::SimpleExecute(vtkImageData* input, vtk
   multiScaleFilter->SetHessianToMeasureFilter(objectnessFilter);
   multiScaleFilter->Update();
 
-  if (this->ScalesOutput)
-    {
-      this->ScalesOutput->Delete();
-      this->ScalesOutput = NULL;
-    }
-
-  this->ScalesOutput = vtkImageData::New();
-
   ScalesImageType::Pointer scalesImage = const_cast<ScalesImageType*>(multiScaleFilter->GetScalesOutput());
 
   vtkvmtkITKFilterUtilities::ITKToVTKImage<ScalesImageType>(scalesImage,this->ScalesOutput);
@@ -85,6 +85,14 @@ class VTK_VMTK_SEGMENTATION_EXPORT vtkvmtkObjectnessMeasureImageFilter : public
   vtkGetMacro(ObjectDimension,int);
   vtkSetMacro(ObjectDimension,int);
 
+  // Description:
+  // Compute the measure with itk::FusedMultiScaleHessianMeasureImageFilter,
+  // which works on slabs and keeps only the running maximum instead of
+  // computing a Hessian image per scale. Default is off.
+  vtkGetMacro(UseFusedMultiScale,int);
+  vtkSetMacro(UseFusedMultiScale,int);
+  vtkBooleanMacro(UseFusedMultiScale,int);
+
   vtkGetObjectMacro(ScalesOutput,vtkImageData);
 
 protected:
@@ -106,6 +114,7 @@ private:
   double Beta;
   double Gamma;
   int ObjectDimension;
+  int UseFusedMultiScale;
   vtkImageData* ScalesOutput;
 };
 
@@ -31,6 +31,7 @@ Version:   $Revision: 1.1 $
 
 #include "itkMultiScaleHessianBasedMeasureImageFilter.h"
 #include "itkHessian3DToVesselnessMeasureImageFilter.h"
+#include "itkFusedMultiScaleHessianMeasureImageFilter.h"
 
 
 vtkStandardNewMacro(vtkvmtkSatoVesselnessMeasureImageFilter);
@@ -43,6 +44,7 @@ vtkvmtkSatoVesselnessMeasureImageFilter::vtkvmtkSatoVesselnessMeasureImageFilter
   this->SetSigmaStepMethodToEquispaced();
   this->Alpha1 = 0.5;
   this->Alpha2 = 2.0;
+  this->UseFusedMultiScale = 0;
 }
 
 vtkvmtkSatoVesselnessMeasureImageFilter::~vtkvmtkSatoVesselnessMeasureImageFilter()
@@ -57,6 +59,26 @@ void vtkvmtkSatoVesselnessMeasureImageFilter::SimpleExecute(vtkImageData *input,
 
   vtkvmtkITKFilterUtilities::VTKToITKImage<ImageType>(input,inImage);
 
+  if (this->UseFusedMultiScale)
+    {
+    typedef itk::FusedMultiScaleHessianMeasureImageFilter<ImageType,ImageType> FusedFilterType;
+
+    FusedFilterType::Pointer fusedFilter = FusedFilterType::New();
+    fusedFilter->SetInput(inImage);
+    fusedFilter->SetMeasure(FusedFilterType::SATO);
+    fusedFilter->SetSigmaMinimum(this->SigmaMin);
+    fusedFilter->SetSigmaMaximum(this->SigmaMax);
+    fusedFilter->SetNumberOfSigmaSteps(this->NumberOfSigmaSteps);
+    fusedFilter->SetSigmaStepMethod(this->SigmaStepMethod == LOGARITHMIC ? FusedFilterType::LOGARITHMIC : FusedFilterType::EQUISPACED);
+    fusedFilter->SetAlpha1(this->Alpha1);
+    fusedFilter->SetAlpha2(this->Alpha2);
+    vtkvmtkITKFilterUtilities::ConnectProgress(fusedFilter,this);
+    fusedFilter->Update();
+
+    vtkvmtkITKFilterUtilities::ITKToVTKImage<ImageType>(fusedFilter->GetOutput(),output);
+    return;
+    }
+
   typedef itk::SymmetricSecondRankTensor<double,3> HessianPixelType;
   typedef itk::Image<HessianPixelType,3> HessianImageType;
   typedef itk::Hessian3DToVesselnessMeasureImageFilter<float> VesselnessFilterType;
@@ -66,6 +66,14 @@ class VTK_VMTK_SEGMENTATION_EXPORT vtkvmtkSatoVesselnessMeasureImageFilter : pub
 
   vtkGetMacro(Alpha2,double);
   vtkSetMacro(Alpha2,double);
+
+  // Description:
+  // Compute the measure with itk::FusedMultiScaleHessianMeasureImageFilter,
+  // which works on slabs and keeps only the running maximum instead of
+  // computing a Hessian image per scale. Default is off.
+  vtkGetMacro(UseFusedMultiScale,int);
+  vtkSetMacro(UseFusedMultiScale,int);
+  vtkBooleanMacro(UseFusedMultiScale,int);
 //BTX
   enum 
   {
@@ -89,6 +97,7 @@ private:
   int SigmaStepMethod;
   double Alpha1;
   double Alpha2;
+  int UseFusedMultiScale;
 };
 
 #endif
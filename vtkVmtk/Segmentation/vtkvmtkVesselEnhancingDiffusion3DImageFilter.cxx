@@ -1,7 +1,7 @@
 /*=========================================================================
 
 Program:   VMTK
-Module:    $RCSfile: vtkbvsVesselEnhancingDiffusion3DImageFilter.cxx,v $
+Module:    $RCSfile: vtkvmtkVesselEnhancingDiffusion3DImageFilter.cxx,v $
 Language:  C++
 Date:      $Date: 2006/04/06 16:48:25 $
 Version:   $Revision: 1.1 $
@@ -26,7 +26,114 @@ Version:   $Revision: 1.1 $
 #include "vtkvmtkVesselEnhancingDiffusion3DImageFilter.h"
 #include "vtkObjectFactory.h"
 
+#include "vtkvmtkITKFilterUtilities.h"
+
+#include "itkVesselEnhancingDiffusion3DImageFilter.h"
+
+#include <cmath>
+#include <vector>
 
 vtkStandardNewMacro(vtkvmtkVesselEnhancingDiffusion3DImageFilter);
 
+vtkvmtkVesselEnhancingDiffusion3DImageFilter::vtkvmtkVesselEnhancingDiffusion3DImageFilter()
+{
+  // defaults for the lowdose example of the paper, see SetDefaultPars
+  this->SigmaMin = 0.3;
+  this->SigmaMax = 2.0;
+  this->NumberOfSigmaSteps = 5;
+  this->SigmaStepMethod = LOGARITHMIC;
+  this->NumberOfIterations = 30;
+  this->RecalculateVesselness = 100;
+  this->TimeStep = 0.001;
+  this->Epsilon = 0.01;
+  this->Omega = 25.0;
+  this->Sensitivity = 5.0;
+  this->Alpha = 0.5;
+  this->Beta = 0.5;
+  this->Gamma = 5.0;
+  this->DarkObjectLightBackground = 0;
+  this->NumberOfThreads = 0;
+}
+
+double vtkvmtkVesselEnhancingDiffusion3DImageFilter::ComputeSigmaValue(int scaleLevel)
+{
+  if (this->NumberOfSigmaSteps < 2)
+    {
+    return this->SigmaMin;
+    }
+
+  double sigmaValue;
+
+  switch (this->SigmaStepMethod)
+    {
+    case EQUISPACED:
+      {
+      double stepSize = ( this->SigmaMax - this->SigmaMin ) / (this->NumberOfSigmaSteps-1);
+      if (stepSize < 1e-10)
+        {
+        stepSize = 1e-10;
+        }
+      sigmaValue = this->SigmaMin + stepSize * scaleLevel;
+      break;
+      }
+    case LOGARITHMIC:
+      {
+      double stepSize = ( std::log(this->SigmaMax) - std::log(this->SigmaMin) ) / (this->NumberOfSigmaSteps-1);
+      if (stepSize < 1e-10)
+        {
+        stepSize = 1e-10;
+        }
+      sigmaValue = std::exp( std::log(this->SigmaMin) + stepSize * scaleLevel);
+      break;
+      }
+    default:
+      vtkErrorMacro("Error: undefined sigma step method.");
+      sigmaValue = 0.0;
+      break;
+    }
+
+  return sigmaValue;
+}
+
+void vtkvmtkVesselEnhancingDiffusion3DImageFilter::SimpleExecute(vtkImageData* input, vtkImageData* output)
+{
+  typedef itk::VesselEnhancingDiffusion3DImageFilter<float,3> VesselEnhancingDiffusionFilterType;
+  typedef VesselEnhancingDiffusionFilterType::ImageType ImageType;
+
+  ImageType::Pointer inImage = ImageType::New();
+
+  vtkvmtkITKFilterUtilities::VTKToITKImage<ImageType>(input,inImage);
+
+  std::vector<VesselEnhancingDiffusionFilterType::Precision> scales;
+  for (int i=0; i<this->NumberOfSigmaSteps; i++)
+    {
+    scales.push_back(this->ComputeSigmaValue(i));
+    }
+
+  VesselEnhancingDiffusionFilterType::Pointer vesselEnhancingDiffusionFilter = VesselEnhancingDiffusionFilterType::New();
+  vesselEnhancingDiffusionFilter->SetDefaultPars();
+  vesselEnhancingDiffusionFilter->SetInput(inImage);
+  vesselEnhancingDiffusionFilter->SetScales(scales);
+  vesselEnhancingDiffusionFilter->SetTimeStep(this->TimeStep);
+  vesselEnhancingDiffusionFilter->SetIterations(this->NumberOfIterations);
+  vesselEnhancingDiffusionFilter->SetRecalculateVesselness(this->RecalculateVesselness);
+  vesselEnhancingDiffusionFilter->SetAlpha(this->Alpha);
+  vesselEnhancingDiffusionFilter->SetBeta(this->Beta);
+  vesselEnhancingDiffusionFilter->SetGamma(this->Gamma);
+  vesselEnhancingDiffusionFilter->SetEpsilon(this->Epsilon);
+  vesselEnhancingDiffusionFilter->SetOmega(this->Omega);
+  vesselEnhancingDiffusionFilter->SetSensitivity(this->Sensitivity);
+  vesselEnhancingDiffusionFilter->SetDarkObjectLightBackground(this->DarkObjectLightBackground != 0);
+  vesselEnhancingDiffusionFilter->SetVerbose(false);
+  if (this->NumberOfThreads > 0)
+    {
+#if ITK_VERSION_MAJOR >= 5
+    vesselEnhancingDiffusionFilter->SetNumberOfWorkUnits(this->NumberOfThreads);
+#else
+    vesselEnhancingDiffusionFilter->SetNumberOfThreads(this->NumberOfThreads);
+#endif
+    }
+  vesselEnhancingDiffusionFilter->Update();
 
+  vtkvmtkITKFilterUtilities::ITKToVTKImage<ImageType>(vesselEnhancingDiffusionFilter->GetOutput(),output);
+}
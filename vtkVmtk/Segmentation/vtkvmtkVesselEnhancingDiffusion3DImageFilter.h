@@ -25,176 +25,115 @@ Version:   $Revision: 1.2 $
 
 // .NAME vtkvmtkVesselEnhancingDiffusion3DImageFilter - Wrapper class around itk::VesselEnhancingDiffusion3DImageFilter
 // .SECTION Description
-// vtkvmtkVesselEnhancingDiffusion3DImageFilter
+// vtkvmtkVesselEnhancingDiffusion3DImageFilter applies vessel enhancing diffusion
+// (Manniesing, MedIA 2006) on a float copy of the input. Vesselness is recalculated
+// over NumberOfSigmaSteps scales every RecalculateVesselness iterations.
 
 
 #ifndef __vtkvmtkVesselEnhancingDiffusion3DImageFilter_h
 #define __vtkvmtkVesselEnhancingDiffusion3DImageFilter_h
 
-
-#include "vtkvmtkITKImageToImageFilterFF.h"
-#include "itkVesselEnhancingDiffusion3DImageFilter.h"
+#include "vtkSimpleImageToImageFilter.h"
 #include "vtkvmtkWin32Header.h"
-#include "vtkVersion.h"
 
-class VTK_VMTK_SEGMENTATION_EXPORT vtkvmtkVesselEnhancingDiffusion3DImageFilter : public vtkvmtkITKImageToImageFilterFF
+class VTK_VMTK_SEGMENTATION_EXPORT vtkvmtkVesselEnhancingDiffusion3DImageFilter : public vtkSimpleImageToImageFilter
 {
  public:
   static vtkvmtkVesselEnhancingDiffusion3DImageFilter *New();
-  vtkTypeMacro(vtkvmtkVesselEnhancingDiffusion3DImageFilter, vtkvmtkITKImageToImageFilterFF);
+  vtkTypeMacro(vtkvmtkVesselEnhancingDiffusion3DImageFilter, vtkSimpleImageToImageFilter);
 
-  vtkSetMacro(SigmaMin,double);
   vtkGetMacro(SigmaMin,double);
+  vtkSetMacro(SigmaMin,double);
 
-  vtkSetMacro(SigmaMax,double);
   vtkGetMacro(SigmaMax,double);
+  vtkSetMacro(SigmaMax,double);
 
-  vtkSetMacro(NumberOfSigmaSteps,int);
   vtkGetMacro(NumberOfSigmaSteps,int);
+  vtkSetMacro(NumberOfSigmaSteps,int);
+
+  vtkGetMacro(SigmaStepMethod,int);
+  vtkSetMacro(SigmaStepMethod,int);
 
   void SetSigmaStepMethodToEquispaced()
   {
-    this->SigmaStepMethod = EQUISPACED_STEPS;
+    this->SetSigmaStepMethod(EQUISPACED);
   }
-  
+
   void SetSigmaStepMethodToLogarithmic()
   {
-    this->SigmaStepMethod = LOGARITHMIC_STEPS;
+    this->SetSigmaStepMethod(LOGARITHMIC);
   }
 
-  void SetTimeStep(double value)
+  enum
   {
-    DelegateITKInputMacro(SetTimeStep,value);
-  }
+    EQUISPACED,
+    LOGARITHMIC
+  };
 
-  void SetEpsilon(double value)
-  {
-    DelegateITKInputMacro(SetEpsilon,value);
-  }
+  vtkGetMacro(Alpha,double);
+  vtkSetMacro(Alpha,double);
 
-  void SetOmega(double value)
-  {
-    DelegateITKInputMacro(SetOmega,value);
-  }
+  vtkGetMacro(Beta,double);
+  vtkSetMacro(Beta,double);
 
-  void SetSensitivity(double value)
-  {
-    DelegateITKInputMacro(SetSensitivity,value);
-  }
+  vtkGetMacro(Gamma,double);
+  vtkSetMacro(Gamma,double);
 
-  void SetNumberOfIterations(int value)
-  {
-    DelegateITKInputMacro(SetIterations,value);
-  }
+  vtkGetMacro(NumberOfIterations,int);
+  vtkSetMacro(NumberOfIterations,int);
 
-  void SetAlpha(double value)
-  {
-    DelegateITKInputMacro(SetAlpha,value);
-  }
+  vtkGetMacro(RecalculateVesselness,int);
+  vtkSetMacro(RecalculateVesselness,int);
 
-  void SetBeta(double value)
-  {
-    DelegateITKInputMacro(SetBeta,value);
-  }
+  vtkGetMacro(TimeStep,double);
+  vtkSetMacro(TimeStep,double);
 
-  void SetGamma(double value)
-  {
-    DelegateITKInputMacro(SetGamma,value);
-  }
+  vtkGetMacro(Epsilon,double);
+  vtkSetMacro(Epsilon,double);
 
-  void SetRecalculateVesselness(int value)
-  {
-    DelegateITKInputMacro(SetRecalculateVesselness,value);
-  }
+  vtkGetMacro(Omega,double);
+  vtkSetMacro(Omega,double);
 
-  double ComputeSigmaValue(int scaleLevel)
-  {
-    double sigmaValue;
-
-    if (this->NumberOfSigmaSteps < 2)
-    {
-      return this->SigmaMin;
-    }
-
-    switch (this->SigmaStepMethod)
-      {
-      case EQUISPACED_STEPS:
-        {
-        double stepSize = ( SigmaMax - SigmaMin ) / (NumberOfSigmaSteps-1);
-        if (stepSize < 1e-10)
-          {
-          stepSize = 1e-10;
-          }
-        sigmaValue = SigmaMin + stepSize * scaleLevel;
-        break;
-        }
-      case LOGARITHMIC_STEPS:
-        {
-        double stepSize = ( vcl_log(SigmaMax) - vcl_log(SigmaMin) ) / (NumberOfSigmaSteps-1);
-        if (stepSize < 1e-10)
-          {
-          stepSize = 1e-10;
-          }
-        sigmaValue = vcl_exp( vcl_log (SigmaMin) + stepSize * scaleLevel);
-        break;
-        }
-      default:
-        vtkErrorMacro("Error: undefined sigma step method.");
-        sigmaValue = 0.0;
-        break;
-      }
-
-    return sigmaValue;
-  }
+  vtkGetMacro(Sensitivity,double);
+  vtkSetMacro(Sensitivity,double);
 
-  void Update()
-  {
-    std::vector<float> scales;
-    for (int i=0; i<this->NumberOfSigmaSteps; i++)
-      {
-      scales.push_back(this->ComputeSigmaValue(i));
-      }
-    this->GetImageFilterPointer()->SetScales(scales);
-  }
+  vtkGetMacro(DarkObjectLightBackground,int);
+  vtkSetMacro(DarkObjectLightBackground,int);
+  vtkBooleanMacro(DarkObjectLightBackground,int);
 
-//BTX
-  enum
-  {
-    EQUISPACED_STEPS,
-    LOGARITHMIC_STEPS
-  };
-//ETX
+  // Description:
+  // Number of threads used by the diffusion passes, 0 for the ITK default.
+  vtkGetMacro(NumberOfThreads,int);
+  vtkSetMacro(NumberOfThreads,int);
+
+  double ComputeSigmaValue(int scaleLevel);
 
 protected:
-  //BTX
-  typedef itk::VesselEnhancingDiffusion3DImageFilter<Superclass::InputImageType::PixelType> ImageFilterType;
 
-  vtkvmtkVesselEnhancingDiffusion3DImageFilter() : Superclass(ImageFilterType::New()) 
-  {
-    this->SigmaMin = 0.0;
-    this->SigmaMax = 0.0;
-    this->NumberOfSigmaSteps = 0;
-    this->SigmaStepMethod = EQUISPACED_STEPS;
+  vtkvmtkVesselEnhancingDiffusion3DImageFilter();
+  ~vtkvmtkVesselEnhancingDiffusion3DImageFilter() {};
 
-    this->GetImageFilterPointer()->SetDefaultPars();
-  }
+  virtual void SimpleExecute(vtkImageData* input, vtkImageData* output) override;
 
-  ~vtkvmtkVesselEnhancingDiffusion3DImageFilter() {};
-  ImageFilterType* GetImageFilterPointer() { return dynamic_cast<ImageFilterType*>(m_Filter.GetPointer()); }
-  //ETX
+private:
+  vtkvmtkVesselEnhancingDiffusion3DImageFilter(const vtkvmtkVesselEnhancingDiffusion3DImageFilter&);  // Not implemented.
+  void operator=(const vtkvmtkVesselEnhancingDiffusion3DImageFilter&);  // Not implemented.
 
   double SigmaMin;
   double SigmaMax;
   int NumberOfSigmaSteps;
   int SigmaStepMethod;
-
-private:
-  vtkvmtkVesselEnhancingDiffusion3DImageFilter(const vtkvmtkVesselEnhancingDiffusion3DImageFilter&);  // Not implemented.
-  void operator=(const vtkvmtkVesselEnhancingDiffusion3DImageFilter&);  // Not implemented.
+  int NumberOfIterations;
+  int RecalculateVesselness;
+  double TimeStep;
+  double Epsilon;
+  double Omega;
+  double Sensitivity;
+  double Alpha;
+  double Beta;
+  double Gamma;
+  int DarkObjectLightBackground;
+  int NumberOfThreads;
 };
 
 #endif
-
-
-
-
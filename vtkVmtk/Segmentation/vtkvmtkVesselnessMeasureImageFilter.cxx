@@ -30,6 +30,7 @@ Version:   $Revision: 1.1 $
 
 #include "itkMultiScaleHessianBasedMeasureImageFilter.h"
 #include "itkHessianToObjectnessMeasureImageFilter.h"
+#include "itkFusedMultiScaleHessianMeasureImageFilter.h"
 
 vtkStandardNewMacro(vtkvmtkVesselnessMeasureImageFilter);
 
@@ -45,6 +46,7 @@ vtkvmtkVesselnessMeasureImageFilter::vtkvmtkVesselnessMeasureImageFilter()
   this->Gamma = 1.0;
   this->ScalesOutput = NULL;
   this->BrightObject = true;
+  this->UseFusedMultiScale = 0;
 }
 
 vtkvmtkVesselnessMeasureImageFilter::~vtkvmtkVesselnessMeasureImageFilter()
@@ -64,6 +66,41 @@ void vtkvmtkVesselnessMeasureImageFilter::SimpleExecute(vtkImageData* input, vtk
 
   vtkvmtkITKFilterUtilities::VTKToITKImage<ImageType>(input,inImage);
 
+  if (this->ScalesOutput)
+    {
+      this->ScalesOutput->Delete();
+      this->ScalesOutput = NULL;
+    }
+
+  this->ScalesOutput = vtkImageData::New();
+
+  if (this->UseFusedMultiScale)
+    {
+    typedef itk::FusedMultiScaleHessianMeasureImageFilter<ImageType,ImageType> FusedFilterType;
+
+    FusedFilterType::Pointer fusedFilter = FusedFilterType::New();
+    fusedFilter->SetInput(inImage);
+    fusedFilter->SetMeasure(FusedFilterType::OBJECTNESS);
+    fusedFilter->SetSigmaMinimum(this->SigmaMin);
+    fusedFilter->SetSigmaMaximum(this->SigmaMax);
+    fusedFilter->SetNumberOfSigmaSteps(this->NumberOfSigmaSteps);
+    fusedFilter->SetSigmaStepMethod(this->SigmaStepMethod == LOGARITHMIC ? FusedFilterType::LOGARITHMIC : FusedFilterType::EQUISPACED);
+    fusedFilter->SetScaleObjectnessMeasure(this->UseScaledVesselness);
+    fusedFilter->SetBrightObject(this->BrightObject);
+    fusedFilter->SetObjectDimension(1);
+    fusedFilter->SetAlpha(this->Alpha);
+    fusedFilter->SetBeta(this->Beta);
+    fusedFilter->SetGamma(this->Gamma);
+    vtkvmtkITKFilterUtilities::ConnectProgress(fusedFilter,this);
+    fusedFilter->Update();
+
+    ImageType::Pointer scalesImage = const_cast<ImageType*>(fusedFilter->GetScalesOutput());
+    vtkvmtkITKFilterUtilities::ITKToVTKImage<ImageType>(scalesImage,this->ScalesOutput);
+
+    vtkvmtkITKFilterUtilities::ITKToVTKImage<ImageType>(fusedFilter->GetOutput(),output);
+    return;
+    }
+
   typedef itk::SymmetricSecondRankTensor<float,3> HessianPixelType;
   typedef itk::Image<HessianPixelType,3> HessianImageType;
   typedef itk::HessianToObjectnessMeasureImageFilter<HessianImageType,ImageType> VesselnessFilterType;
@@ -95,14 +132,6 @@ void vtkvmtkVesselnessMeasureImageFilter::SimpleExecute(vtkImageData* input, vtk
   multiScaleFilter->SetHessianToMeasureFilter(vesselnessFilter);
   multiScaleFilter->Update();
 
-  if (this->ScalesOutput)
-    {
-      this->ScalesOutput->Delete();
-      this->ScalesOutput = NULL;
-    }
-
-  this->ScalesOutput = vtkImageData::New();
-
   ScalesImageType::Pointer scalesImage = const_cast<ScalesImageType*>(multiScaleFilter->GetScalesOutput());
 
   vtkvmtkITKFilterUtilities::ITKToVTKImage<ScalesImageType>(scalesImage,this->ScalesOutput);
@@ -82,6 +82,14 @@ class VTK_VMTK_SEGMENTATION_EXPORT vtkvmtkVesselnessMeasureImageFilter : public
   vtkGetMacro(Gamma,double);
   vtkSetMacro(Gamma,double);
 
+  // Description:
+  // Compute the measure with itk::FusedMultiScaleHessianMeasureImageFilter,
+  // which works on slabs and keeps only the running maximum instead of
+  // computing a Hessian image per scale. Default is off.
+  vtkGetMacro(UseFusedMultiScale,int);
+  vtkSetMacro(UseFusedMultiScale,int);
+  vtkBooleanMacro(UseFusedMultiScale,int);
+
   vtkGetObjectMacro(ScalesOutput,vtkImageData);
   
   vtkSetMacro(BrightObject, bool);
@@ -107,6 +115,7 @@ private:
   double Beta;
   double Gamma;
   bool BrightObject;
+  int UseFusedMultiScale;
   vtkImageData* ScalesOutput;
 };
 
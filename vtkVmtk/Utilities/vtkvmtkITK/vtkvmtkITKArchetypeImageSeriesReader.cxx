@@ -22,6 +22,7 @@
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
 #include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 
 // ITK includes
@@ -30,17 +31,207 @@
 #include <itkMetaDataObject.h>
 #include <itkTimeProbe.h>
 
+// GDCM includes
+#include <gdcmReader.h>
+#include <gdcmStringFilter.h>
+
+// KWSys includes
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
 // STD includes
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
 #include <vector>
 
 #include "itkArchetypeSeriesFileNames.h"
 #include "itkOrientImageFilter.h"
 #include "itkImageSeriesReader.h"
-#include "itkGDCMSeriesFileNames.h"
 #include "itkGDCMImageIO.h"
 
 vtkStandardNewMacro(vtkvmtkITKArchetypeImageSeriesReader);
 
+namespace {
+
+/// DICOM tags kept for each file, in the order of the header records.
+/// The series number, sequence name, slice thickness and matrix size
+/// split a series instance UID into volumes, as gdcm::SerieHelper does
+/// with series details enabled.
+enum
+{
+  SERIES_INSTANCE_UID_TAG = 0,
+  CONTENT_TIME_TAG,
+  TRIGGER_TIME_TAG,
+  ECHO_NUMBERS_TAG,
+  DIFFUSION_GRADIENT_ORIENTATION_TAG,
+  SLICE_LOCATION_TAG,
+  IMAGE_ORIENTATION_PATIENT_TAG,
+  IMAGE_POSITION_PATIENT_TAG,
+  INSTANCE_NUMBER_TAG,
+  SERIES_NUMBER_TAG,
+  SEQUENCE_NAME_TAG,
+  SLICE_THICKNESS_TAG,
+  ROWS_TAG,
+  COLUMNS_TAG,
+  NUMBER_OF_HEADER_TAGS
+};
+
+const uint16_t HeaderTags[NUMBER_OF_HEADER_TAGS][2] =
+{
+  { 0x0020, 0x000e },
+  { 0x0008, 0x0033 },
+  { 0x0018, 0x1060 },
+  { 0x0018, 0x0086 },
+  { 0x0010, 0x9089 },
+  { 0x0020, 0x1041 },
+  { 0x0020, 0x0037 },
+  { 0x0020, 0x0032 },
+  { 0x0020, 0x0013 },
+  { 0x0020, 0x0011 },
+  { 0x0018, 0x0024 },
+  { 0x0018, 0x0050 },
+  { 0x0028, 0x0010 },
+  { 0x0028, 0x0011 }
+};
+
+const char HeaderCacheSignature[] = "vmtk dicom header index 1";
+
+const std::string& GetHeaderValue( const std::vector<std::string>& header, int tag )
+{
+  static const std::string noValue;
+  return header.size() == NUMBER_OF_HEADER_TAGS ? header[tag] : noValue;
+}
+
+/// strip the padding of DICOM values
+std::string TrimHeaderValue( const std::string& value )
+{
+  std::string::size_type begin = value.find_first_not_of( std::string(" \0", 2) );
+  if ( begin == std::string::npos )
+    {
+    return std::string();
+    }
+  std::string::size_type end = value.find_last_not_of( std::string(" \0", 2) );
+  return value.substr( begin, end - begin + 1 );
+}
+
+/// Reads the tags of a range of files. Each file is parsed by its own
+/// gdcm::Reader, up to the pixel data.
+class HeaderScanFunctor
+{
+public:
+  HeaderScanFunctor( const std::vector<std::string>& fileNames,
+                     std::vector< std::vector<std::string> >& headers )
+    : FileNames(fileNames), Headers(headers) {}
+
+  void operator()( vtkIdType begin, vtkIdType end ) const
+    {
+    for (vtkIdType f = begin; f < end; f++)
+      {
+      std::vector<std::string>& header = this->Headers[f];
+      header.clear();
+      gdcm::Reader reader;
+      reader.SetFileName( this->FileNames[f].c_str() );
+      std::set<gdcm::Tag> skipTags;
+      if ( !reader.ReadUpToTag( gdcm::Tag(0x7fe0, 0x0010), skipTags ) )
+        {
+        continue;
+        }
+      const gdcm::DataSet& dataSet = reader.GetFile().GetDataSet();
+      gdcm::StringFilter stringFilter;
+      stringFilter.SetFile( reader.GetFile() );
+      header.resize( NUMBER_OF_HEADER_TAGS );
+      for (int t = 0; t < NUMBER_OF_HEADER_TAGS; t++)
+        {
+        gdcm::Tag tag( HeaderTags[t][0], HeaderTags[t][1] );
+        if ( dataSet.FindDataElement( tag ) )
+          {
+          header[t] = TrimHeaderValue( stringFilter.ToString( tag ) );
+          }
+        }
+      }
+    }
+
+private:
+  const std::vector<std::string>& FileNames;
+  std::vector< std::vector<std::string> >& Headers;
+};
+
+/// Series key of a file: the series instance UID followed by the tags
+/// telling apart volumes sharing it. Empty if the file has no UID.
+std::string GetSeriesKey( const std::vector<std::string>& header )
+{
+  std::string key = GetHeaderValue( header, SERIES_INSTANCE_UID_TAG );
+  if ( key.empty() )
+    {
+    return key;
+    }
+  const int detailTags[] = { SERIES_NUMBER_TAG, SEQUENCE_NAME_TAG, SLICE_THICKNESS_TAG, ROWS_TAG, COLUMNS_TAG };
+  for (unsigned int k = 0; k < sizeof(detailTags)/sizeof(detailTags[0]); k++)
+    {
+    const std::string& value = GetHeaderValue( header, detailTags[k] );
+    if ( !value.empty() )
+      {
+      key += "." + value;
+      }
+    }
+  return key;
+}
+
+/// Sort the files of a series by position along the slice normal. If a
+/// file lacks position or orientation fall back to the instance number,
+/// and keep the given order if that is missing too.
+void SortSeriesFiles( const std::vector< std::vector<std::string> >& headers,
+                      std::vector<size_t>& files )
+{
+  std::vector< std::pair<double, size_t> > keys( files.size() );
+  bool havePositions = true;
+  double normal[3] = { 0.0, 0.0, 0.0 };
+  for (size_t k = 0; k < files.size() && havePositions; k++)
+    {
+    const std::vector<std::string>& header = headers[files[k]];
+    double o[6], p[3];
+    if ( sscanf( GetHeaderValue( header, IMAGE_ORIENTATION_PATIENT_TAG ).c_str(),
+                 "%lf\\%lf\\%lf\\%lf\\%lf\\%lf", o, o+1, o+2, o+3, o+4, o+5 ) != 6 ||
+         sscanf( GetHeaderValue( header, IMAGE_POSITION_PATIENT_TAG ).c_str(),
+                 "%lf\\%lf\\%lf", p, p+1, p+2 ) != 3 )
+      {
+      havePositions = false;
+      break;
+      }
+    if ( k == 0 )
+      {
+      vtkMath::Cross( o, o+3, normal );
+      }
+    keys[k] = std::make_pair( vtkMath::Dot( p, normal ), files[k] );
+    }
+  if ( !havePositions )
+    {
+    bool haveNumbers = true;
+    for (size_t k = 0; k < files.size() && haveNumbers; k++)
+      {
+      int number;
+      haveNumbers = sscanf( GetHeaderValue( headers[files[k]], INSTANCE_NUMBER_TAG ).c_str(), "%d", &number ) == 1;
+      keys[k] = std::make_pair( haveNumbers ? number : 0.0, files[k] );
+      }
+    if ( !haveNumbers )
+      {
+      return;
+      }
+    }
+  // ties keep the file name order, as the indices are increasing
+  std::sort( keys.begin(), keys.end() );
+  for (size_t k = 0; k < files.size(); k++)
+    {
+    files[k] = keys[k].second;
+    }
+}
+
+}
+
 //----------------------------------------------------------------------------
 vtkvmtkITKArchetypeImageSeriesReader::vtkvmtkITKArchetypeImageSeriesReader()
 {
@@ -60,6 +251,8 @@ vtkvmtkITKArchetypeImageSeriesReader::vtkvmtkITKArchetypeImageSeriesReader()
   this->OutputScalarType = VTK_FLOAT;
   this->NumberOfComponents = 0;
   this->UseNativeScalarType = 0;
+  this->UseHeaderCache = 0;
+  this->HeaderCacheDirectory = NULL;
   for (int i = 0; i < 3; i++)
     {
     this->DefaultDataSpacing[i] = 1.0;
@@ -99,6 +292,7 @@ vtkvmtkITKArchetypeImageSeriesReader::~vtkvmtkITKArchetypeImageSeriesReader()
     delete [] this->Archetype;
     this->Archetype = NULL;
     }
+  this->SetHeaderCacheDirectory(NULL);
  if (RasToIjkMatrix)
    {
    RasToIjkMatrix->Delete();
@@ -158,6 +352,10 @@ void vtkvmtkITKArchetypeImageSeriesReader::PrintSelf(std::ostream& os, vtkIndent
     }
   os << ")\n";
 
+  os << indent << "UseHeaderCache: " << this->UseHeaderCache << "\n";
+  os << indent << "HeaderCacheDirectory: " <<
+    (this->HeaderCacheDirectory ? this->HeaderCacheDirectory : "(default)") << "\n";
+
 }
 
 //----------------------------------------------------------------------------
@@ -223,6 +421,7 @@ int vtkvmtkITKArchetypeImageSeriesReader::RequestInformation(
     }
 
   this->AllFileNames.resize( 0 );
+  this->AllFileHeaders.resize( 0 );
 
   // Some file types require special processing
   itk::GDCMImageIO::Pointer dicomIO = itk::GDCMImageIO::New();
@@ -257,31 +456,15 @@ int vtkvmtkITKArchetypeImageSeriesReader::RequestInformation(
   {
     if ( isDicomFile && !this->GetSingleFile() )
     {
-      typedef itk::GDCMSeriesFileNames DICOMNameGeneratorType;
-      DICOMNameGeneratorType::Pointer inputImageFileGenerator = DICOMNameGeneratorType::New();
       std::string fileNamePath = itksys::SystemTools::GetFilenamePath( this->Archetype );
       if (fileNamePath == "")
       {
         fileNamePath = ".";
       }
-      inputImageFileGenerator->SetDirectory( fileNamePath );
-
-      // determine if the file is diffusion weighted MR file
 
-      // Find the series that contains the archetype
-      candidateSeries = inputImageFileGenerator->GetSeriesUIDs();
-
-      // Find all dicom files in the directory
-      for (unsigned int s = 0; s < candidateSeries.size(); s++)
-      {
-        std::vector<std::string> seriesFileNames;
-        seriesFileNames = inputImageFileGenerator->GetFileNames( candidateSeries[s] );
-        for (unsigned int f = 0; f < seriesFileNames.size(); f++)
-        {
-          this->AllFileNames.push_back( seriesFileNames[f] );
-        }
-      }
-      //int nFiles = this->AllFileNames.size(); UNUSED
+      // Find all dicom files in the directory, grouped by series
+      std::vector< std::vector<std::string> > candidateSeriesFileNames;
+      this->ScanDicomDirectory( fileNamePath, candidateSeries, candidateSeriesFileNames );
 
       // analysis dicom files and fill the Dicom Tag arrays
       if ( AnalyzeHeader )
@@ -294,7 +477,7 @@ int vtkvmtkITKArchetypeImageSeriesReader::RequestInformation(
       int found = 0;
       for (unsigned int s = 0; s < candidateSeries.size() && found == 0; s++)
       {
-        candidateFiles = inputImageFileGenerator->GetFileNames(candidateSeries[s]);
+        candidateFiles = candidateSeriesFileNames[s];
         for (unsigned int f = 0; f < candidateFiles.size(); f++)
         {
           if (itksys::SystemTools::CollapseFullPath(candidateFiles[f].c_str()) ==
@@ -1040,17 +1223,19 @@ void vtkvmtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     return;
     }
 
-  // if Archetype is a Dicom File
-  gdcmIO->SetFileName( this->Archetype );
+  // if Archetype is a Dicom File, use the tags scanned with the directory
+  // or read them now
+  if ( this->AllFileHeaders.size() != this->AllFileNames.size() )
+  {
+    ScanDicomHeaders( this->AllFileNames, this->AllFileHeaders );
+  }
   for (int f = 0; f < nFiles; f++)
   {
-    gdcmIO->SetFileName( this->AllFileNames[f] );
-    gdcmIO->ReadImageInformation();
-    itk::MetaDataDictionary &dict = gdcmIO->GetMetaDataDictionary();
+    const std::vector<std::string>& header = this->AllFileHeaders[f];
     std::string tagValue;
 
     // series instance UID
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|000e", tagValue );
+    tagValue = GetHeaderValue( header, SERIES_INSTANCE_UID_TAG );
     if ( tagValue.length() > 0 )
     {
       int idx = InsertSeriesInstanceUIDs( tagValue.c_str() );
@@ -1062,7 +1247,7 @@ void vtkvmtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // content time
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0008|0033", tagValue );
+    tagValue = GetHeaderValue( header, CONTENT_TIME_TAG );
     if ( tagValue.length() > 0 )
     {
       int idx = InsertContentTime( tagValue.c_str() );
@@ -1074,7 +1259,7 @@ void vtkvmtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // trigger time
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0018|1060", tagValue );
+    tagValue = GetHeaderValue( header, TRIGGER_TIME_TAG );
     if ( tagValue.length() > 0 )
     {
       int idx = InsertTriggerTime( tagValue.c_str() );
@@ -1086,7 +1271,7 @@ void vtkvmtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // echo numbers
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0018|0086", tagValue );
+    tagValue = GetHeaderValue( header, ECHO_NUMBERS_TAG );
     if ( tagValue.length() > 0 )
     {
       int idx = InsertEchoNumbers( tagValue.c_str() );
@@ -1098,7 +1283,7 @@ void vtkvmtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // diffision gradient orientation
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0010|9089", tagValue );
+    tagValue = GetHeaderValue( header, DIFFUSION_GRADIENT_ORIENTATION_TAG );
     if ( tagValue.length() > 0 )
     {
       float a[3];
@@ -1112,7 +1297,7 @@ void vtkvmtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // slice location
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|1041", tagValue );
+    tagValue = GetHeaderValue( header, SLICE_LOCATION_TAG );
     if ( tagValue.length() > 0 )
     {
       float a;
@@ -1126,7 +1311,7 @@ void vtkvmtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // image orientation patient
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|0037", tagValue );
+    tagValue = GetHeaderValue( header, IMAGE_ORIENTATION_PATIENT_TAG );
     if ( tagValue.length() > 0 )
     {
       float a[6];
@@ -1139,7 +1324,7 @@ void vtkvmtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       this->IndexImageOrientationPatient[f] = -1;
     }
     // image position patient
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|0032", tagValue );
+    tagValue = GetHeaderValue( header, IMAGE_POSITION_PATIENT_TAG );
     if( tagValue.length() > 0 )
     {
         float a[3];
@@ -1160,6 +1345,247 @@ void vtkvmtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
   return;
 }
 
+//----------------------------------------------------------------------------
+void vtkvmtkITKArchetypeImageSeriesReader::ScanDicomHeaders(
+  const std::vector<std::string>& fileNames,
+  std::vector< std::vector<std::string> >& headers )
+{
+  headers.assign( fileNames.size(), std::vector<std::string>() );
+  HeaderScanFunctor functor( fileNames, headers );
+  vtkSMPTools::For( 0, static_cast<vtkIdType>(fileNames.size()), 1, functor );
+}
+
+//----------------------------------------------------------------------------
+void vtkvmtkITKArchetypeImageSeriesReader::ScanDicomDirectory(
+  const std::string& directory,
+  std::vector<std::string>& seriesUIDs,
+  std::vector< std::vector<std::string> >& seriesFileNames )
+{
+  std::vector<std::string> fileNames;
+  std::vector< std::vector<std::string> > headers;
+  long int modifiedTime = itksys::SystemTools::ModifiedTime( directory );
+
+  if ( !this->UseHeaderCache ||
+       !this->ReadHeaderCache( directory, modifiedTime, fileNames, headers ) )
+    {
+    itksys::Directory directoryListing;
+    if ( directoryListing.Load( directory ) )
+      {
+      for (unsigned long k = 0; k < directoryListing.GetNumberOfFiles(); k++)
+        {
+        std::string fileName = directoryListing.GetFile( k );
+        if ( fileName == "." || fileName == ".." )
+          {
+          continue;
+          }
+        std::string filePath = directory + "/" + fileName;
+        if ( !itksys::SystemTools::FileIsDirectory( filePath ) )
+          {
+          fileNames.push_back( filePath );
+          }
+        }
+      }
+    std::sort( fileNames.begin(), fileNames.end() );
+    ScanDicomHeaders( fileNames, headers );
+    // a directory modified within the last second may change again
+    // without its time stamp changing
+    if ( this->UseHeaderCache && time(NULL) > modifiedTime + 1 )
+      {
+      this->WriteHeaderCache( directory, modifiedTime, fileNames, headers );
+      }
+    }
+
+  std::map< std::string, std::vector<size_t> > series;
+  for (size_t f = 0; f < fileNames.size(); f++)
+    {
+    std::string key = GetSeriesKey( headers[f] );
+    if ( !key.empty() )
+      {
+      series[key].push_back( f );
+      }
+    }
+
+  seriesUIDs.resize( 0 );
+  seriesFileNames.resize( 0 );
+  this->AllFileNames.resize( 0 );
+  this->AllFileHeaders.resize( 0 );
+  std::map< std::string, std::vector<size_t> >::iterator iter;
+  for (iter = series.begin(); iter != series.end(); ++iter)
+    {
+    std::vector<size_t>& files = iter->second;
+    SortSeriesFiles( headers, files );
+    seriesUIDs.push_back( iter->first );
+    seriesFileNames.push_back( std::vector<std::string>() );
+    for (size_t k = 0; k < files.size(); k++)
+      {
+      seriesFileNames.back().push_back( fileNames[files[k]] );
+      this->AllFileNames.push_back( fileNames[files[k]] );
+      this->AllFileHeaders.push_back( headers[files[k]] );
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+std::string vtkvmtkITKArchetypeImageSeriesReader::GetHeaderCacheFileName( const std::string& directory )
+{
+  std::string cacheDirectory;
+  if ( this->HeaderCacheDirectory && this->HeaderCacheDirectory[0] )
+    {
+    cacheDirectory = this->HeaderCacheDirectory;
+    }
+  else
+    {
+    std::string base;
+    if ( itksys::SystemTools::GetEnv( "XDG_CACHE_HOME", base ) && !base.empty() )
+      {
+      cacheDirectory = base + "/vmtk/dicom";
+      }
+    else if ( itksys::SystemTools::GetEnv( "HOME", base ) && !base.empty() )
+      {
+      cacheDirectory = base + "/.cache/vmtk/dicom";
+      }
+    else if ( itksys::SystemTools::GetEnv( "LOCALAPPDATA", base ) && !base.empty() )
+      {
+      cacheDirectory = base + "/vmtk/dicom";
+      }
+    else
+      {
+      return std::string();
+      }
+    }
+
+  // one index per directory, named after the FNV-1a hash of its full path
+  std::string fullPath = itksys::SystemTools::CollapseFullPath( directory );
+  unsigned long long hash = 14695981039346656037ULL;
+  for (std::string::size_type k = 0; k < fullPath.size(); k++)
+    {
+    hash ^= static_cast<unsigned char>( fullPath[k] );
+    hash *= 1099511628211ULL;
+    }
+  char name[32];
+  snprintf( name, sizeof(name), "%016llx.txt", hash );
+  return cacheDirectory + "/" + name;
+}
+
+//----------------------------------------------------------------------------
+// The index is a text file: a signature line, the full path of the
+// directory, its modification time, the number of files and tags, then
+// one tab separated line per file with its name, a flag telling whether
+// gdcm could read it and the tag values.
+bool vtkvmtkITKArchetypeImageSeriesReader::ReadHeaderCache(
+  const std::string& directory, long int modifiedTime,
+  std::vector<std::string>& fileNames,
+  std::vector< std::vector<std::string> >& headers )
+{
+  std::string cacheFileName = this->GetHeaderCacheFileName( directory );
+  if ( cacheFileName.empty() )
+    {
+    return false;
+    }
+  std::ifstream in( cacheFileName.c_str(), std::ios::in | std::ios::binary );
+  if ( !in )
+    {
+    return false;
+    }
+
+  std::string line;
+  if ( !std::getline( in, line ) || line != HeaderCacheSignature ||
+       !std::getline( in, line ) || line != itksys::SystemTools::CollapseFullPath( directory ) ||
+       !std::getline( in, line ) || atol( line.c_str() ) != modifiedTime ||
+       !std::getline( in, line ) )
+    {
+    return false;
+    }
+  unsigned long numberOfFiles = 0;
+  int numberOfTags = 0;
+  if ( sscanf( line.c_str(), "%lu %d", &numberOfFiles, &numberOfTags ) != 2 ||
+       numberOfTags != NUMBER_OF_HEADER_TAGS )
+    {
+    return false;
+    }
+
+  fileNames.resize( numberOfFiles );
+  headers.assign( numberOfFiles, std::vector<std::string>() );
+  for (unsigned long f = 0; f < numberOfFiles; f++)
+    {
+    if ( !std::getline( in, line ) )
+      {
+      return false;
+      }
+    std::vector<std::string> fields;
+    std::string::size_type begin = 0;
+    while ( true )
+      {
+      std::string::size_type end = line.find( '\t', begin );
+      fields.push_back( line.substr( begin, end == std::string::npos ? std::string::npos : end - begin ) );
+      if ( end == std::string::npos )
+        {
+        break;
+        }
+      begin = end + 1;
+      }
+    if ( fields.size() != static_cast<size_t>(NUMBER_OF_HEADER_TAGS + 2) || fields[0].empty() )
+      {
+      return false;
+      }
+    fileNames[f] = directory + "/" + fields[0];
+    if ( fields[1] == "1" )
+      {
+      headers[f].assign( fields.begin() + 2, fields.end() );
+      }
+    }
+  vtkDebugMacro( "Read DICOM header index " << cacheFileName );
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkvmtkITKArchetypeImageSeriesReader::WriteHeaderCache(
+  const std::string& directory, long int modifiedTime,
+  const std::vector<std::string>& fileNames,
+  const std::vector< std::vector<std::string> >& headers )
+{
+  std::string cacheFileName = this->GetHeaderCacheFileName( directory );
+  if ( cacheFileName.empty() ||
+       !itksys::SystemTools::MakeDirectory( itksys::SystemTools::GetFilenamePath( cacheFileName ).c_str() ) )
+    {
+    return;
+    }
+
+  std::ostringstream buffer;
+  buffer << HeaderCacheSignature << "\n"
+         << itksys::SystemTools::CollapseFullPath( directory ) << "\n"
+         << modifiedTime << "\n"
+         << fileNames.size() << " " << NUMBER_OF_HEADER_TAGS << "\n";
+  for (size_t f = 0; f < fileNames.size(); f++)
+    {
+    bool isDicom = headers[f].size() == NUMBER_OF_HEADER_TAGS;
+    buffer << itksys::SystemTools::GetFilenameName( fileNames[f] ) << "\t" << (isDicom ? 1 : 0);
+    for (int t = 0; t < NUMBER_OF_HEADER_TAGS; t++)
+      {
+      buffer << "\t" << GetHeaderValue( headers[f], t );
+      }
+    buffer << "\n";
+    }
+
+  // write next to the index and rename, so that concurrent readers never
+  // see a partial file
+  std::string temporaryFileName = cacheFileName + ".tmp";
+  std::ofstream out( temporaryFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  if ( !out )
+    {
+    return;
+    }
+  const std::string text = buffer.str();
+  out.write( text.data(), text.size() );
+  out.close();
+  if ( !out || !itksys::SystemTools::RenameFile( temporaryFileName.c_str(), cacheFileName.c_str() ) )
+    {
+    itksys::SystemTools::RemoveFile( temporaryFileName.c_str() );
+    return;
+    }
+  vtkDebugMacro( "Wrote DICOM header index " << cacheFileName );
+}
+
 //----------------------------------------------------------------------------
 const itk::MetaDataDictionary&
 vtkvmtkITKArchetypeImageSeriesReader
@@ -1261,6 +1687,7 @@ void vtkvmtkITKArchetypeImageSeriesReader::ResetFileNames( )
 {
   this->FileNames.resize( 0 );
   this->AllFileNames.resize( 0 );
+  this->AllFileHeaders.resize( 0 );
   this->SeriesInstanceUIDs.resize( 0 );
   this->ContentTime.resize( 0 );
   this->TriggerTime.resize( 0 );
@@ -234,6 +234,19 @@ public:
   vtkSetMacro(UseOrientationFromFile, int);
   vtkGetMacro(UseOrientationFromFile, int);
 
+  ///
+  /// Whether to keep the DICOM tags scanned from a directory in an index
+  /// file, reused as long as the directory is not modified (default off)
+  vtkSetMacro(UseHeaderCache, int);
+  vtkGetMacro(UseHeaderCache, int);
+  vtkBooleanMacro(UseHeaderCache, int);
+
+  ///
+  /// Directory holding the header index files. If not set,
+  /// $XDG_CACHE_HOME/vmtk/dicom (or ~/.cache/vmtk/dicom) is used.
+  vtkSetStringMacro(HeaderCacheDirectory);
+  vtkGetStringMacro(HeaderCacheDirectory);
+
   ///
   /// Returns an IJK to RAS transformation matrix
   vtkMatrix4x4* GetRasToIjkMatrix();
@@ -828,6 +841,27 @@ protected:
 
   itk::MetaDataDictionary Dictionary;
 
+  int UseHeaderCache;
+  char *HeaderCacheDirectory;
+
+  /// Read the DICOM tags of fileNames, in parallel.
+  static void ScanDicomHeaders( const std::vector<std::string>& fileNames,
+                                std::vector< std::vector<std::string> >& headers );
+
+  /// List the DICOM series of a directory, each sorted along the slice
+  /// normal, and fill AllFileNames and AllFileHeaders in series order.
+  void ScanDicomDirectory( const std::string& directory,
+                           std::vector<std::string>& seriesUIDs,
+                           std::vector< std::vector<std::string> >& seriesFileNames );
+
+  std::string GetHeaderCacheFileName( const std::string& directory );
+  bool ReadHeaderCache( const std::string& directory, long int modifiedTime,
+                        std::vector<std::string>& fileNames,
+                        std::vector< std::vector<std::string> >& headers );
+  void WriteHeaderCache( const std::string& directory, long int modifiedTime,
+                         const std::vector<std::string>& fileNames,
+                         const std::vector< std::vector<std::string> >& headers );
+
   /// The following variables provide support
   /// for reading a directory with multiple series/groups.
   /// The current scheme is to check the following and see
@@ -843,6 +877,9 @@ protected:
   /// ImagePositionPatient           0020,0032
 
   std::vector<std::string> AllFileNames;
+  /// DICOM tags of each file in AllFileNames (empty for files gdcm
+  /// cannot read); filled by ScanDicomDirectory or ScanDicomHeaders
+  std::vector< std::vector<std::string> > AllFileHeaders;
   bool AnalyzeHeader;
   bool IsOnlyFile;
 
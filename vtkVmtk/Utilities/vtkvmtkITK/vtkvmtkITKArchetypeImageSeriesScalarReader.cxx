@@ -23,6 +23,7 @@
 #include <vtkInformationVector.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkSMPTools.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkVersion.h>
 
@@ -30,6 +31,9 @@
 #include <itkOrientImageFilter.h>
 #include <itkImageSeriesReader.h>
 
+// STD includes
+#include <algorithm>
+
 vtkStandardNewMacro(vtkvmtkITKArchetypeImageSeriesScalarReader);
 
 namespace {
@@ -38,7 +42,111 @@ namespace {
   {
     return vtkAOSDataArrayTemplate<T>::FastDownCast(a);
   }
-};
+
+  /// Decodes a range of slices of a series into a preallocated volume.
+  /// Each file gets its own reader and a fresh copy of the image IO.
+  template <class TImage>
+  class SliceReaderFunctor
+  {
+  public:
+    SliceReaderFunctor(const std::vector<std::string>& fileNames, itk::ImageIOBase* imageIO,
+                       TImage* image, std::vector<char>& failed)
+      : FileNames(fileNames), ImageIO(imageIO), Image(image), Failed(failed) {}
+
+    void operator()(vtkIdType begin, vtkIdType end) const
+    {
+      const typename TImage::SizeType& size = this->Image->GetLargestPossibleRegion().GetSize();
+      const size_t sliceSize = size[0] * size[1];
+      for (vtkIdType k = begin; k < end; k++)
+        {
+        typename itk::ImageFileReader<TImage>::Pointer reader = itk::ImageFileReader<TImage>::New();
+        reader->SetFileName(this->FileNames[k].c_str());
+        itk::LightObject::Pointer imageIO = this->ImageIO->CreateAnother();
+        reader->SetImageIO(dynamic_cast<itk::ImageIOBase*>(imageIO.GetPointer()));
+        try
+          {
+          reader->Update();
+          }
+        catch (itk::ExceptionObject&)
+          {
+          this->Failed[k] = 1;
+          continue;
+          }
+        const TImage* slice = reader->GetOutput();
+        const typename TImage::SizeType& readSize = slice->GetBufferedRegion().GetSize();
+        if (readSize[0] != size[0] || readSize[1] != size[1] || readSize[2] != 1)
+          {
+          this->Failed[k] = 1;
+          continue;
+          }
+        std::copy(slice->GetBufferPointer(), slice->GetBufferPointer() + sliceSize,
+                  this->Image->GetBufferPointer() + k * sliceSize);
+        }
+    }
+
+  private:
+    const std::vector<std::string>& FileNames;
+    itk::ImageIOBase* ImageIO;
+    TImage* Image;
+    std::vector<char>& Failed;
+  };
+
+  /// Read the files of a series slice by slice in parallel, into a volume
+  /// with the geometry computed by seriesReader. Returns a null pointer if
+  /// the files are not single slices of the same size, in which case the
+  /// series reader has to do the work. The slices are read in batches so
+  /// that progress can be reported by the calling thread.
+  template <class TImage>
+  typename TImage::Pointer ReadSeriesSlices(itk::ImageSeriesReader<TImage>* seriesReader,
+                                            const std::vector<std::string>& fileNames,
+                                            vtkAlgorithm* progressSource)
+  {
+    typename TImage::Pointer image;
+    try
+      {
+      typename itk::ImageFileReader<TImage>::Pointer firstReader = itk::ImageFileReader<TImage>::New();
+      firstReader->SetFileName(fileNames[0].c_str());
+      firstReader->UpdateOutputInformation();
+      itk::ImageIOBase::Pointer imageIO = firstReader->GetImageIO();
+      if (imageIO.IsNull() || (imageIO->GetNumberOfDimensions() > 2 && imageIO->GetDimensions(2) > 1))
+        {
+        return image;
+        }
+      seriesReader->SetImageIO(imageIO);
+      seriesReader->UpdateOutputInformation();
+      const typename TImage::RegionType& region = seriesReader->GetOutput()->GetLargestPossibleRegion();
+      if (region.GetSize()[2] != fileNames.size())
+        {
+        return image;
+        }
+      image = TImage::New();
+      image->CopyInformation(seriesReader->GetOutput());
+      image->SetRegions(region);
+      image->Allocate();
+
+      std::vector<char> failed(fileNames.size(), 0);
+      SliceReaderFunctor<TImage> functor(fileNames, imageIO, image, failed);
+      const vtkIdType numberOfFiles = static_cast<vtkIdType>(fileNames.size());
+      const vtkIdType numberOfBatches = std::min<vtkIdType>(numberOfFiles, 20);
+      for (vtkIdType batch = 0; batch < numberOfBatches; batch++)
+        {
+        const vtkIdType begin = batch * numberOfFiles / numberOfBatches;
+        const vtkIdType end = (batch + 1) * numberOfFiles / numberOfBatches;
+        vtkSMPTools::For(begin, end, 1, functor);
+        progressSource->UpdateProgress(static_cast<double>(end) / numberOfFiles);
+        }
+      if (std::find(failed.begin(), failed.end(), 1) != failed.end())
+        {
+        image = nullptr;
+        }
+      }
+    catch (itk::ExceptionObject&)
+      {
+      image = nullptr;
+      }
+    return image;
+  }
+}
 
 //----------------------------------------------------------------------------
 vtkvmtkITKArchetypeImageSeriesScalarReader::vtkvmtkITKArchetypeImageSeriesScalarReader()
@@ -88,8 +196,6 @@ int vtkvmtkITKArchetypeImageSeriesScalarReader::RequestData(
     case typeN: \
     {\
       typedef itk::Image<type,3> image##typeN;\
-      typedef itk::ImageSource<image##typeN> FilterType; \
-      FilterType::Pointer filter; \
       itk::ImageSeriesReader<image##typeN>::Pointer reader##typeN = \
           itk::ImageSeriesReader<image##typeN>::New(); \
           itk::CStyleCommand::Pointer pcl=itk::CStyleCommand::New(); \
@@ -98,23 +204,26 @@ int vtkvmtkITKArchetypeImageSeriesScalarReader::RequestData(
           reader##typeN->AddObserver(itk::ProgressEvent(),pcl); \
       reader##typeN->SetFileNames(this->FileNames); \
       reader##typeN->ReleaseDataFlagOn(); \
-      if (this->UseNativeCoordinateOrientation) \
-        { \
-        filter = reader##typeN; \
-        } \
-      else \
+      image##typeN::Pointer output##typeN = \
+          ReadSeriesSlices<image##typeN>(reader##typeN, this->FileNames, this); \
+      if (!this->UseNativeCoordinateOrientation) \
         { \
         itk::OrientImageFilter<image##typeN,image##typeN>::Pointer orient##typeN = \
             itk::OrientImageFilter<image##typeN,image##typeN>::New(); \
         if (this->Debug) {orient##typeN->DebugOn();} \
-        orient##typeN->SetInput(reader##typeN->GetOutput()); \
+        orient##typeN->SetInput(output##typeN.IsNotNull() ? output##typeN.GetPointer() : reader##typeN->GetOutput()); \
         orient##typeN->UseImageDirectionOn(); \
         orient##typeN->SetDesiredCoordinateOrientation(this->DesiredCoordinateOrientation); \
-        filter = orient##typeN; \
+        orient##typeN->UpdateLargestPossibleRegion(); \
+        output##typeN = orient##typeN->GetOutput(); \
         }\
-      filter->UpdateLargestPossibleRegion(); \
+      else if (output##typeN.IsNull()) \
+        { \
+        reader##typeN->UpdateLargestPossibleRegion(); \
+        output##typeN = reader##typeN->GetOutput(); \
+        } \
       itk::ImportImageContainer<itk::SizeValueType, type>::Pointer PixelContainer##typeN;\
-      PixelContainer##typeN = filter->GetOutput()->GetPixelContainer();\
+      PixelContainer##typeN = output##typeN->GetPixelContainer();\
       void *ptr = static_cast<void *> (PixelContainer##typeN->GetBufferPointer());\
       DownCast<type>(data->GetPointData()->GetScalars())                \
         ->SetVoidArray(ptr, PixelContainer##typeN->Size(), 0,\
@@ -24,6 +24,7 @@
 #include <vtkITKUtility.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
+#include <vtkSMPTools.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkVersion.h>
 
@@ -31,16 +32,356 @@
 #include <vtksys/SystemTools.hxx>
 
 // ITK includes
+#include <itkChangeInformationImageFilter.h>
 #include <itkDiffusionTensor3D.h>
 #include <itkImageFileWriter.h>
 #include <itkMetaDataDictionary.h>
 #include <itkMetaDataObject.h>
 #include <itkMetaDataObjectBase.h>
 #include <itkVTKImageImport.h>
+#include "itk_zlib.h"
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 
 vtkStandardNewMacro(vtkvmtkITKImageWriter);
 
+namespace {
+
+enum
+{
+  NO_COMPRESSED_FORMAT,
+  NRRD_COMPRESSED_FORMAT,
+  META_COMPRESSED_FORMAT
+};
+
+/// Compresses a range of blocks of the data. Each block is a raw deflate
+/// stream of its own, ended with a sync flush (the last one with the final
+/// block bit), so that the concatenation of the blocks is a valid deflate
+/// stream. The checksum of each block is computed alongside and combined
+/// by the caller.
+class DeflateBlockFunctor
+{
+public:
+  DeflateBlockFunctor(const unsigned char* data, size_t numberOfBytes, size_t blockSize,
+                      size_t numberOfBlocks, size_t firstBlock, int level, bool gzip,
+                      std::vector<std::string>& buffers, std::vector<unsigned long>& checksums,
+                      std::vector<char>& failed)
+    : Data(data), NumberOfBytes(numberOfBytes), BlockSize(blockSize), NumberOfBlocks(numberOfBlocks),
+      FirstBlock(firstBlock), Level(level), Gzip(gzip), Buffers(buffers), Checksums(checksums), Failed(failed) {}
+
+  void operator()(vtkIdType begin, vtkIdType end) const
+  {
+    for (vtkIdType k = begin; k < end; k++)
+      {
+      size_t block = this->FirstBlock + k;
+      size_t start = block * this->BlockSize;
+      size_t length = std::min(this->BlockSize, this->NumberOfBytes - start);
+      bool last = block == this->NumberOfBlocks - 1;
+      const unsigned char* data = this->Data + start;
+
+      this->Failed[k] = 1;
+      z_stream stream;
+      memset(&stream, 0, sizeof(stream));
+      if (deflateInit2(&stream, this->Level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+        continue;
+        }
+      std::string& buffer = this->Buffers[k];
+      // room for the empty stored block of the sync flush
+      buffer.resize(deflateBound(&stream, static_cast<uLong>(length)) + 16);
+      stream.next_in = const_cast<Bytef*>(data);
+      stream.avail_in = static_cast<uInt>(length);
+      stream.next_out = reinterpret_cast<Bytef*>(&buffer[0]);
+      stream.avail_out = static_cast<uInt>(buffer.size());
+      int status = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+      bool complete = last ? status == Z_STREAM_END : status == Z_OK && stream.avail_in == 0 && stream.avail_out > 0;
+      buffer.resize(buffer.size() - stream.avail_out);
+      deflateEnd(&stream);
+      if (!complete)
+        {
+        continue;
+        }
+      this->Checksums[k] = this->Gzip ?
+        crc32(crc32(0L, Z_NULL, 0), data, static_cast<uInt>(length)) :
+        adler32(adler32(0L, Z_NULL, 0), data, static_cast<uInt>(length));
+      this->Failed[k] = 0;
+      }
+  }
+
+private:
+  const unsigned char* Data;
+  size_t NumberOfBytes;
+  size_t BlockSize;
+  size_t NumberOfBlocks;
+  size_t FirstBlock;
+  int Level;
+  bool Gzip;
+  std::vector<std::string>& Buffers;
+  std::vector<unsigned long>& Checksums;
+  std::vector<char>& Failed;
+};
+
+/// Write data to out as a zlib (MetaImage) or gzip (NRRD) stream, compressing
+/// batches of blocks in parallel. Only one batch of compressed blocks, at
+/// most one of numberOfDivisions slabs of the data, is held in memory at a
+/// time. Returns false on failure.
+bool WriteDeflateStream(std::ostream& out, const unsigned char* data, size_t numberOfBytes, int level, bool gzip,
+                        int numberOfDivisions)
+{
+  const size_t blockSize = 1 << 20;
+  const size_t numberOfBlocks = numberOfBytes > 0 ? (numberOfBytes + blockSize - 1) / blockSize : 1;
+  const size_t divisions = static_cast<size_t>(std::max(numberOfDivisions, 1));
+  const size_t blocksPerBatch = std::max<size_t>(std::min<size_t>((numberOfBlocks + divisions - 1) / divisions, 64), 1);
+
+  if (gzip)
+    {
+    const unsigned char header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+  else
+    {
+    int levelFlag = level == Z_DEFAULT_COMPRESSION ? 2 : level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    unsigned char header[2] = { 0x78, static_cast<unsigned char>(levelFlag << 6) };
+    header[1] += 31 - (header[0] * 256 + header[1]) % 31;
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+
+  unsigned long checksum = gzip ? crc32(0L, Z_NULL, 0) : adler32(0L, Z_NULL, 0);
+  size_t batchCapacity = std::min(numberOfBlocks, blocksPerBatch);
+  std::vector<std::string> buffers(batchCapacity);
+  std::vector<unsigned long> checksums(batchCapacity);
+  std::vector<char> failed(batchCapacity);
+  for (size_t firstBlock = 0; firstBlock < numberOfBlocks; firstBlock += blocksPerBatch)
+    {
+    size_t batchSize = std::min(numberOfBlocks - firstBlock, blocksPerBatch);
+    DeflateBlockFunctor functor(data, numberOfBytes, blockSize, numberOfBlocks, firstBlock, level, gzip, buffers, checksums, failed);
+    vtkSMPTools::For(0, static_cast<vtkIdType>(batchSize), 1, functor);
+    for (size_t k = 0; k < batchSize; k++)
+      {
+      if (failed[k])
+        {
+        return false;
+        }
+      size_t start = (firstBlock + k) * blockSize;
+      z_off_t length = static_cast<z_off_t>(std::min(blockSize, numberOfBytes - start));
+      checksum = gzip ? crc32_combine(checksum, checksums[k], length) : adler32_combine(checksum, checksums[k], length);
+      out.write(buffers[k].data(), buffers[k].size());
+      }
+    if (!out.good())
+      {
+      return false;
+      }
+    }
+
+  unsigned char trailer[8];
+  if (gzip)
+    {
+    unsigned long size = static_cast<unsigned long>(numberOfBytes & 0xffffffffUL);
+    for (int i = 0; i < 4; i++)
+      {
+      trailer[i] = static_cast<unsigned char>((checksum >> (8 * i)) & 0xff);
+      trailer[4 + i] = static_cast<unsigned char>((size >> (8 * i)) & 0xff);
+      }
+    out.write(reinterpret_cast<const char*>(trailer), 8);
+    }
+  else
+    {
+    for (int i = 0; i < 4; i++)
+      {
+      trailer[i] = static_cast<unsigned char>((checksum >> (8 * (3 - i))) & 0xff);
+      }
+    out.write(reinterpret_cast<const char*>(trailer), 4);
+    }
+  return out.good();
+}
+
+/// Which of the parallel compressed formats fileName is to be written in.
+int GetCompressedFormat(vtkvmtkITKImageWriter* self, const char* fileName)
+{
+  std::string fileExtension = vtksys::SystemTools::LowerCase( vtksys::SystemTools::GetFilenameLastExtension(fileName) );
+  std::string ioClassName = self->GetImageIOClassName() ? self->GetImageIOClassName() : "";
+  if (fileExtension == ".nrrd" && (ioClassName.empty() || ioClassName == "NrrdImageIO"))
+    {
+    return NRRD_COMPRESSED_FORMAT;
+    }
+  if (fileExtension == ".mha" && (ioClassName.empty() || ioClassName == "MetaImageIO"))
+    {
+    return META_COMPRESSED_FORMAT;
+    }
+  return NO_COMPRESSED_FORMAT;
+}
+
+/// Write a scalar volume as a NRRD file with gzip encoding or a MetaImage
+/// file with local compressed data. The header has the fields the ITK image
+/// IO writes for a scalar volume; the pixel data is the VTK buffer as is.
+template <class TPixelType>
+void WriteCompressedVolume(int format, const char* fileName, const int dimensions[3], const double spacing[3],
+                           const double origin[3], const double direction[3][3], const void* data, int level,
+                           int numberOfDivisions)
+{
+  typedef std::numeric_limits<TPixelType> Limits;
+  const int bits = static_cast<int>(8 * sizeof(TPixelType));
+  const size_t numberOfBytes = static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2] * sizeof(TPixelType);
+#ifdef VTK_WORDS_BIGENDIAN
+  const bool bigEndian = true;
+#else
+  const bool bigEndian = false;
+#endif
+
+  std::ostringstream header;
+  header.precision(17);
+  if (format == NRRD_COMPRESSED_FORMAT)
+    {
+    std::ofstream out(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out)
+      {
+      itkGenericExceptionMacro(<< "Could not open " << fileName << " for writing");
+      }
+    header << "NRRD0004\n"
+           << "# Complete NRRD file format specification at:\n"
+           << "# http://teem.sourceforge.net/nrrd/format.html\n"
+           << "type: ";
+    if (Limits::is_integer)
+      {
+      const char* nrrdTypes[2][4] = { { "unsigned char", "unsigned short", "unsigned int", "unsigned long long int" },
+                                      { "signed char", "short", "int", "long long int" } };
+      int typeIndex = sizeof(TPixelType) == 1 ? 0 : sizeof(TPixelType) == 2 ? 1 : sizeof(TPixelType) == 4 ? 2 : 3;
+      header << nrrdTypes[Limits::is_signed ? 1 : 0][typeIndex] << "\n";
+      }
+    else
+      {
+      header << (bits == 32 ? "float" : "double") << "\n";
+      }
+    header << "dimension: 3\n"
+           << "space: left-posterior-superior\n"
+           << "sizes: " << dimensions[0] << " " << dimensions[1] << " " << dimensions[2] << "\n"
+           << "space directions:";
+    for (int i = 0; i < 3; i++)
+      {
+      header << " (" << direction[0][i] * spacing[i] << "," << direction[1][i] * spacing[i] << "," << direction[2][i] * spacing[i] << ")";
+      }
+    header << "\n"
+           << "kinds: domain domain domain\n"
+           << "endian: " << (bigEndian ? "big" : "little") << "\n"
+           << "encoding: gzip\n"
+           << "space origin: (" << origin[0] << "," << origin[1] << "," << origin[2] << ")\n\n";
+    out << header.str();
+    if (!WriteDeflateStream(out, static_cast<const unsigned char*>(data), numberOfBytes, level, true, numberOfDivisions))
+      {
+      itkGenericExceptionMacro(<< "Error writing compressed data to " << fileName);
+      }
+    out.close();
+    if (!out)
+      {
+      itkGenericExceptionMacro(<< "Error writing " << fileName);
+      }
+    return;
+    }
+
+  // the MetaImage header carries the compressed size, which is only known
+  // once the data is compressed: the compressed stream goes to a temporary
+  // file next to the output and is appended after the header
+  std::string compressedFileName = std::string(fileName) + ".deflate.tmp";
+  std::streamoff compressedSize = 0;
+  {
+  std::ofstream compressedOut(compressedFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!compressedOut)
+    {
+    itkGenericExceptionMacro(<< "Could not open " << compressedFileName << " for writing");
+    }
+  bool written = WriteDeflateStream(compressedOut, static_cast<const unsigned char*>(data), numberOfBytes, level, false, numberOfDivisions);
+  compressedSize = compressedOut.tellp();
+  compressedOut.close();
+  if (!written || !compressedOut)
+    {
+    vtksys::SystemTools::RemoveFile(compressedFileName);
+    itkGenericExceptionMacro(<< "Error writing compressed data to " << compressedFileName);
+    }
+  }
+
+  // orientation letters as ITK derives them from the direction cosines:
+  // the dominant LPS component of each axis, named after where it starts
+  const char orientationLetters[3][2] = { { 'R', 'L' }, { 'A', 'P' }, { 'I', 'S' } };
+  std::string anatomicalOrientation;
+  for (int i = 0; i < 3; i++)
+    {
+    int dominant = 0;
+    for (int j = 1; j < 3; j++)
+      {
+      if (fabs(direction[j][i]) > fabs(direction[dominant][i]))
+        {
+        dominant = j;
+        }
+      }
+    anatomicalOrientation += orientationLetters[dominant][direction[dominant][i] >= 0.0 ? 0 : 1];
+    }
+
+  header << "ObjectType = Image\n"
+         << "NDims = 3\n"
+         << "BinaryData = True\n"
+         << "BinaryDataByteOrderMSB = " << (bigEndian ? "True" : "False") << "\n"
+         << "CompressedData = True\n"
+         << "CompressedDataSize = " << compressedSize << "\n"
+         << "TransformMatrix =";
+  for (int i = 0; i < 3; i++)
+    {
+    header << " " << direction[0][i] << " " << direction[1][i] << " " << direction[2][i];
+    }
+  header << "\n"
+         << "Offset = " << origin[0] << " " << origin[1] << " " << origin[2] << "\n"
+         << "CenterOfRotation = 0 0 0\n"
+         << "AnatomicalOrientation = " << anatomicalOrientation << "\n"
+         << "ElementSpacing = " << spacing[0] << " " << spacing[1] << " " << spacing[2] << "\n"
+         << "DimSize = " << dimensions[0] << " " << dimensions[1] << " " << dimensions[2] << "\n"
+         << "ElementNumberOfChannels = 1\n"
+         << "ElementType = ";
+  if (Limits::is_integer)
+    {
+    const char* metaTypes[2][4] = { { "MET_UCHAR", "MET_USHORT", "MET_UINT", "MET_ULONG_LONG" },
+                                    { "MET_CHAR", "MET_SHORT", "MET_INT", "MET_LONG_LONG" } };
+    int typeIndex = sizeof(TPixelType) == 1 ? 0 : sizeof(TPixelType) == 2 ? 1 : sizeof(TPixelType) == 4 ? 2 : 3;
+    header << metaTypes[Limits::is_signed ? 1 : 0][typeIndex] << "\n";
+    }
+  else
+    {
+    header << (bits == 32 ? "MET_FLOAT" : "MET_DOUBLE") << "\n";
+    }
+  header << "ElementDataFile = LOCAL\n";
+
+  std::ifstream compressedIn(compressedFileName.c_str(), std::ios::in | std::ios::binary);
+  std::ofstream out(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!compressedIn || !out)
+    {
+    vtksys::SystemTools::RemoveFile(compressedFileName);
+    itkGenericExceptionMacro(<< "Could not open " << fileName << " for writing");
+    }
+  out << header.str();
+  std::vector<char> buffer(1 << 20);
+  while (compressedIn)
+    {
+    compressedIn.read(&buffer[0], buffer.size());
+    out.write(&buffer[0], compressedIn.gcount());
+    }
+  compressedIn.close();
+  vtksys::SystemTools::RemoveFile(compressedFileName);
+  out.close();
+  if (!out)
+    {
+    itkGenericExceptionMacro(<< "Error writing " << fileName);
+    }
+}
+
+}
+
 // helper function
 template <class  TPixelType, int Dimension>
 void ITKWriteVTKImage(vtkvmtkITKImageWriter *self, vtkImageData *inputImage, char *fileName,
@@ -125,6 +466,39 @@ void ITKWriteVTKImage(vtkvmtkITKImageWriter *self, vtkImageData *inputImage, cha
   origin[0] *= -1;
   origin[1] *= -1;
 
+  // with ParallelCompression, compressed scalar NRRD and MetaImage volumes
+  // are written directly from the VTK buffer, compressing in parallel
+  vtkDataArray* scalars = inputImage->GetPointData()->GetScalars();
+  int compressedFormat = GetCompressedFormat(self, fileName);
+  if (Dimension == 3 && self->GetUseCompression() && self->GetParallelCompression() && std::is_arithmetic<TPixelType>::value &&
+      compressedFormat != NO_COMPRESSED_FORMAT && scalars && scalars->GetNumberOfComponents() == 1 &&
+      scalars->GetDataTypeSize() == static_cast<int>(sizeof(TPixelType)))
+    {
+    double originValues[3];
+    double directionValues[3][3];
+    for (i=0; i<3; i++)
+      {
+      originValues[i] = origin[i];
+      for (int j=0; j<3; j++)
+        {
+        directionValues[i][j] = direction[i][j];
+        }
+      }
+    try
+      {
+      WriteCompressedVolume<TPixelType>(compressedFormat, fileName, inputImage->GetDimensions(), mag,
+        originValues, directionValues, scalars->GetVoidPointer(0),
+        self->GetCompressionLevel() < 0 ? Z_DEFAULT_COMPRESSION : self->GetCompressionLevel(),
+        self->GetNumberOfStreamDivisions());
+      }
+    catch (itk::ExceptionObject& exception)
+      {
+      exception.Print(std::cerr);
+      throw exception;
+      }
+    return;
+    }
+
   // itk import for input itk images
   typedef typename itk::VTKImageImport<ImageType> ImageImportType;
   typename ImageImportType::Pointer itkImporter = ImageImportType::New();
@@ -166,7 +540,23 @@ void ITKWriteVTKImage(vtkvmtkITKImageWriter *self, vtkImageData *inputImage, cha
       itkImageWriter->SetImageIO(imageIOType);
       }
     }
-  itkImageWriter->SetInput(itkImporter->GetOutput());
+  // the geometry is set on the pipeline rather than on an updated importer
+  // output, so that the writer can request the image slab by slab
+  typedef typename itk::ChangeInformationImageFilter<ImageType> ChangeInformationType;
+  typename ChangeInformationType::Pointer changeInformation = ChangeInformationType::New();
+  typename ImageType::SpacingType spacing;
+  for (i=0; i<Dimension; i++)
+    {
+    spacing[i] = mag[i];
+    }
+  changeInformation->SetInput(itkImporter->GetOutput());
+  changeInformation->SetOutputDirection(direction);
+  changeInformation->SetOutputOrigin(origin);
+  changeInformation->SetOutputSpacing(spacing);
+  changeInformation->ChangeDirectionOn();
+  changeInformation->ChangeOriginOn();
+  changeInformation->ChangeSpacingOn();
+  itkImageWriter->SetInput(changeInformation->GetOutput());
 
   if (MeasurementFrameMatrix != NULL)
     {
@@ -207,11 +597,8 @@ void ITKWriteVTKImage(vtkvmtkITKImageWriter *self, vtkImageData *inputImage, cha
 
   try
     {
-    itkImporter->GetOutput()->SetDirection(direction);
-    itkImporter->GetOutput()->Update();
-    itkImporter->GetOutput()->SetOrigin(origin);
-    itkImporter->GetOutput()->SetSpacing(mag);
     itkImageWriter->SetFileName( fileName );
+    itkImageWriter->SetNumberOfStreamDivisions( self->GetNumberOfStreamDivisions() );
     itkImageWriter->Update();
     }
   catch (itk::ExceptionObject& exception)
@@ -248,6 +635,9 @@ vtkvmtkITKImageWriter::vtkvmtkITKImageWriter()
   this->RasToIJKMatrix = NULL;
   this->MeasurementFrameMatrix = NULL;
   this->UseCompression = 0;
+  this->ParallelCompression = 0;
+  this->CompressionLevel = -1;
+  this->NumberOfStreamDivisions = 1;
   this->ImageIOClassName = NULL;
 }
 
@@ -277,6 +667,10 @@ void vtkvmtkITKImageWriter::PrintSelf(std::ostream& os, vtkIndent indent)
 
   os << indent << "FileName: " <<
     (this->FileName ? this->FileName : "(none)") << "\n";
+  os << indent << "UseCompression: " << this->UseCompression << "\n";
+  os << indent << "ParallelCompression: " << this->ParallelCompression << "\n";
+  os << indent << "CompressionLevel: " << this->CompressionLevel << "\n";
+  os << indent << "NumberOfStreamDivisions: " << this->NumberOfStreamDivisions << "\n";
   os << indent << "ImageIOClassName: " <<
     (this->ImageIOClassName ? this->ImageIOClassName : "(none)") << "\n";
 }
@@ -48,6 +48,28 @@ public:
   vtkSetMacro (UseCompression, int);
   vtkBooleanMacro(UseCompression, int);
 
+  ///
+  /// Write compressed NRRD (.nrrd) and MetaImage (.mha) scalar volumes
+  /// directly from the VTK buffer, compressing in parallel block by block,
+  /// instead of going through the ITK writer. Off by default.
+  vtkGetMacro (ParallelCompression, int);
+  vtkSetMacro (ParallelCompression, int);
+  vtkBooleanMacro(ParallelCompression, int);
+
+  ///
+  /// zlib compression level (0-9, -1 for the zlib default) of volumes
+  /// written with ParallelCompression.
+  vtkGetMacro (CompressionLevel, int);
+  vtkSetClampMacro (CompressionLevel, int, -1, 9);
+
+  ///
+  /// Number of slabs the image is written in. ITK writers that can stream
+  /// (e.g. uncompressed NRRD and MetaImage) request and write one slab at a
+  /// time; with ParallelCompression at most one slab worth of compressed
+  /// blocks is held in memory. Default is 1.
+  vtkGetMacro (NumberOfStreamDivisions, int);
+  vtkSetClampMacro (NumberOfStreamDivisions, int, 1, VTK_INT_MAX);
+
   ///
   /// Set/Get the ImageIO class name.
   vtkGetStringMacro (ImageIOClassName);
@@ -75,6 +97,9 @@ protected:
   vtkMatrix4x4* RasToIJKMatrix;
   vtkMatrix4x4* MeasurementFrameMatrix;
   int UseCompression;
+  int ParallelCompression;
+  int CompressionLevel;
+  int NumberOfStreamDivisions;
   char* ImageIOClassName;
 
 private: